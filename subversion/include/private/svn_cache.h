@@ -35,6 +35,7 @@
 #include "svn_error.h"
 #include "svn_iter.h"
 #include "svn_config.h"
+#include "svn_io.h"
 #include "svn_string.h"
 
 #ifdef __cplusplus
@@ -310,6 +311,33 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
                                   svn_boolean_t allow_blocking_writes,
                                   apr_pool_t *result_pool);
 
+/**
+ * Like svn_cache__membuffer_cache_create() but place all cache structures
+ * and data buffers in anonymous shared memory.  All processes forked
+ * from the current one after this call will access the same cache
+ * contents, i.e. data cached by one process will be visible to all others.
+ *
+ * The cache is always thread-safe.  Because access needs to be serialized
+ * across processes, every cache segment is protected by a process-global
+ * mutex which will be held exclusively by readers and writers alike.
+ * Consider using a larger @a segment_count than for private caches.
+ *
+ * Key prefixes will not be abbreviated using process-local indexes, i.e.
+ * the full keys will be stored for all entries.
+ *
+ * Return #SVN_ERR_UNSUPPORTED_FEATURE if the platform does not support
+ * fork() or anonymous shared memory.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_cache__membuffer_cache_create_shared(svn_membuffer_t **cache,
+                                         apr_size_t total_size,
+                                         apr_size_t directory_size,
+                                         apr_size_t segment_count,
+                                         svn_boolean_t allow_blocking_writes,
+                                         apr_pool_t *result_pool);
+
 /**
  * @defgroup Standard priority classes for #svn_cache__create_membuffer_cache.
  * @{
@@ -554,6 +582,36 @@ svn_cache__format_info(const svn_cache__info_t *info,
 struct svn_membuffer_t *
 svn_cache__get_global_membuffer_cache(void);
 
+/**
+ * Return TRUE if multiple threads may use the process-global membuffer
+ * cache at the same time.  That is the case unless the cache config had
+ * the @c single_threaded flag set when the cache got created.  If the
+ * cache does not exist yet, it will be created.
+ *
+ * Code that uses caches from multiple threads must check this first and
+ * fall back to a single thread otherwise.
+ *
+ * @since New in 1.15.
+ */
+svn_boolean_t
+svn_cache__global_membuffer_cache_is_thread_safe(void);
+
+/**
+ * Create the process-global (singleton) membuffer cache in shared memory
+ * using the current cache config, such that all processes forked after
+ * this call will share its contents.  See
+ * svn_cache__membuffer_cache_create_shared() for details.
+ *
+ * This must be called before the first call to
+ * svn_cache__get_global_membuffer_cache() in this process.  Otherwise,
+ * #SVN_ERR_INCORRECT_PARAMS will be returned.  Does nothing if the
+ * desired cache size is 0.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_cache__create_shared_global_membuffer_cache(void);
+
 /**
  * Return total access and size stats over all membuffer caches as they
  * share the underlying data buffer.  The result will be allocated in POOL.
@@ -570,6 +628,62 @@ svn_cache__membuffer_get_global_info(apr_pool_t *pool);
 svn_error_t *
 svn_cache__membuffer_clear(svn_membuffer_t *cache);
 
+/**
+ * Callback type used to select the items that get written to or read from
+ * a membuffer cache snapshot.  Set @a *keep to FALSE, if items whose full
+ * key starts with @a prefix shall be ignored.  @a baton is the callback
+ * baton and @a scratch_pool can be used for temporary allocations.
+ */
+typedef svn_error_t *
+(*svn_cache__snapshot_filter_t)(svn_boolean_t *keep,
+                                void *baton,
+                                const char *prefix,
+                                apr_pool_t *scratch_pool);
+
+/**
+ * Write a snapshot of the current contents of @a cache to @a stream.
+ * If @a filter_func is not NULL, only items accepted by it (called with
+ * @a filter_baton) will be written.  Concurrent access to @a cache is
+ * possible while the snapshot is being taken.
+ *
+ * The snapshot only contains serialized data and may be loaded into a
+ * membuffer cache of a different size in another process on the same
+ * machine using svn_cache__membuffer_load().
+ *
+ * @a cancel_func with @a cancel_baton will be called periodically, if not
+ * NULL.  Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_cache__membuffer_save(svn_membuffer_t *cache,
+                          svn_stream_t *stream,
+                          svn_cache__snapshot_filter_t filter_func,
+                          void *filter_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool);
+
+/**
+ * Read a snapshot written by svn_cache__membuffer_save() from @a stream
+ * and add its items to @a cache.  If @a filter_func is not NULL, only items
+ * accepted by it (called with @a filter_baton) will be added.  Items that
+ * don't fit into @a cache will silently be dropped.
+ *
+ * Return #SVN_ERR_MALFORMED_FILE if the snapshot is incomplete or has been
+ * created on a different platform.  Items read before the error occurred
+ * remain in the cache.
+ *
+ * @a cancel_func with @a cancel_baton will be called periodically, if not
+ * NULL.  Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_cache__membuffer_load(svn_membuffer_t *cache,
+                          svn_stream_t *stream,
+                          svn_cache__snapshot_filter_t filter_func,
+                          void *filter_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool);
+
 /** @} */
 
 
@@ -102,12 +102,39 @@ svn_delta__delta_from_editor(const svn_delta_editor_t **deditor,
                              apr_pool_t *pool);
 
 /** Read the txdelta window header from @a stream and return the total
-    length of the unparsed window data in @a *window_len. */
+    length of the unparsed window data in @a *window_len.  The window
+    is expected to be in svndiff format @a svndiff_version. */
 svn_error_t *
 svn_txdelta__read_raw_window_len(apr_size_t *window_len,
                                  svn_stream_t *stream,
+                                 int svndiff_version,
                                  apr_pool_t *pool);
 
+/** Return the largest delta window size, i.e. the maximum source and
+    target view length, that svndiff version @a svndiff_version supports.
+    That is 100kB up to svndiff2 and 1MB for svndiff3. */
+apr_size_t
+svn_txdelta__window_size(int svndiff_version);
+
+/** Like svn_txdelta2() but create delta windows spanning up to
+    @a window_size bytes of source and target data each. */
+void
+svn_txdelta__create(svn_txdelta_stream_t **stream,
+                    svn_stream_t *source,
+                    svn_stream_t *target,
+                    svn_boolean_t calculate_checksum,
+                    apr_size_t window_size,
+                    apr_pool_t *pool);
+
+/** Like svn_txdelta_target_push() but create delta windows spanning up
+    to @a window_size bytes of source and target data each. */
+svn_stream_t *
+svn_txdelta__target_push(svn_txdelta_window_handler_t handler,
+                         void *handler_baton,
+                         svn_stream_t *source,
+                         apr_size_t window_size,
+                         apr_pool_t *pool);
+
 /* Return a debug editor that wraps @a wrapped_editor.
  *
  * The debug editor simply prints an indication of what callbacks are being
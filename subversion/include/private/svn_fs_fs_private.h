@@ -364,6 +364,58 @@ typedef struct svn_fs_fs__ioctl_build_rep_cache_input_t
 /* See svn_fs_fs__build_rep_cache(). */
 SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_BUILD_REP_CACHE, SVN_FS_TYPE_FSFS, 1004);
 
+typedef struct svn_fs_fs__ioctl_cache_snapshot_input_t
+{
+  /* Snapshot file to use.  NULL selects the default inside the repo. */
+  const char *path;
+} svn_fs_fs__ioctl_cache_snapshot_input_t;
+
+typedef struct svn_fs_fs__ioctl_load_cache_snapshot_output_t
+{
+  svn_boolean_t loaded;
+} svn_fs_fs__ioctl_load_cache_snapshot_output_t;
+
+/* See svn_fs_fs__save_cache_snapshot(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_SAVE_CACHE_SNAPSHOT, SVN_FS_TYPE_FSFS, 1005);
+
+/* See svn_fs_fs__load_cache_snapshot(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_LOAD_CACHE_SNAPSHOT, SVN_FS_TYPE_FSFS, 1006);
+
+/* A range of revisions within a single pack unit, i.e. within a packed
+ * shard, a pack stage or a single non-packed revision.
+ */
+typedef struct svn_fs_fs__verify_unit_t
+{
+  /* First and last revision of the range. */
+  svn_revnum_t start;
+  svn_revnum_t end;
+
+  /* TRUE if the pack unit passed verification before and has not been
+   * modified since. */
+  svn_boolean_t verified;
+} svn_fs_fs__verify_unit_t;
+
+typedef struct svn_fs_fs__ioctl_verify_checkpoints_input_t
+{
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+} svn_fs_fs__ioctl_verify_checkpoints_input_t;
+
+typedef struct svn_fs_fs__ioctl_get_verify_checkpoints_output_t
+{
+  /* Array of svn_fs_fs__verify_unit_t *. */
+  apr_array_header_t *units;
+} svn_fs_fs__ioctl_get_verify_checkpoints_output_t;
+
+/* See svn_fs_fs__get_verify_checkpoints(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_GET_VERIFY_CHECKPOINTS, SVN_FS_TYPE_FSFS, 1007);
+
+/* See svn_fs_fs__add_verify_checkpoints(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_ADD_VERIFY_CHECKPOINTS, SVN_FS_TYPE_FSFS, 1008);
+
+/* See svn_fs_fs__compact_verify_checkpoints().  Takes no input. */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_COMPACT_VERIFY_CHECKPOINTS, SVN_FS_TYPE_FSFS, 1009);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
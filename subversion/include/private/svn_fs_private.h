@@ -211,6 +211,43 @@ svn_fs__get_deleted_node(svn_fs_root_t **node_root,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool);
 
+/** A range of bytes within a file, as returned by
+ * svn_fs__file_contents_ranges().
+ */
+typedef struct svn_fs__file_range_t
+{
+  /** Offset of the first byte of the range within the file. */
+  apr_off_t offset;
+
+  /** Number of bytes in the range. */
+  apr_off_t length;
+} svn_fs__file_range_t;
+
+/** Find out whether the contents of the file @a path under @a root are
+ * stored verbatim, i.e. neither deltified nor compressed, in the
+ * repository.
+ *
+ * If so, set @a *file to the repository file that contains them, opened
+ * for reading, and @a *ranges to an array of #svn_fs__file_range_t within
+ * @a *file.  Concatenated, these ranges form the contents of @a path.
+ * This allows the contents to be sent to the network without reading
+ * them into memory first.
+ *
+ * Otherwise, or if the backend does not support this, set @a *file to
+ * @c NULL.  Callers must then fall back to svn_fs_file_contents().
+ *
+ * Allocate @a *file and @a *ranges in @a result_pool; @a *file will be
+ * closed when that pool gets cleared.  Use @a scratch_pool for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_fs__file_contents_ranges(apr_file_t **file,
+                             apr_array_header_t **ranges,
+                             svn_fs_root_t *root,
+                             const char *path,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
 
 /** @} */
 
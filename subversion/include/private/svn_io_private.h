@@ -73,6 +73,33 @@ svn_io__is_finfo_read_only(svn_boolean_t *read_only,
                            apr_pool_t *pool);
 
 
+/** Return TRUE if the file timestamp @a mtime is so recent, relative to
+ * @a now, that modifying the file right now could leave its timestamp
+ * unchanged.  Only use this for filesystems with sub-second timestamps,
+ * which are assumed to tick at least every #SVN_HI_RES_SLEEP_MS
+ * milliseconds.
+ */
+svn_boolean_t
+svn_io__is_timestamp_racy(apr_time_t mtime, apr_time_t now);
+
+/** The number of milliseconds within which a file on a filesystem with
+ * sub-second timestamps is assumed to get a new timestamp when modified.
+ */
+#ifndef SVN_HI_RES_SLEEP_MS
+#define SVN_HI_RES_SLEEP_MS 10
+#endif
+
+/** Create @a to_path as a hard link to the existing file @a from_path,
+ * so that both names refer to the same file.  Fail if @a to_path already
+ * exists, or if the file system does not support hard links between the
+ * two locations.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_io__file_link(const char *from_path, const char *to_path,
+                  apr_pool_t *scratch_pool);
+
 /**
  * Lock file at @a lock_file. If that file does not exist, create an empty
  * file.
@@ -127,6 +154,14 @@ svn_stream__install_get_info(apr_finfo_t *finfo,
                              apr_int32_t wanted,
                              apr_pool_t *scratch_pool);
 
+/* Like svn_stream_compressed(), but compress the data written to STREAM
+   in blocks with LZ4 and decompress the data read from it.  This trades
+   some compression ratio for much faster compression and decompression.
+   Allocate the returned stream in RESULT_POOL. */
+svn_stream_t *
+svn_stream__compressed_lz4(svn_stream_t *stream,
+                           apr_pool_t *result_pool);
+
 /* Internal version of svn_stream_from_aprfile2() supporting the
    additional TRUNCATE_ON_SEEK argument. */
 svn_stream_t *
@@ -132,6 +132,26 @@ svn_ra_svn__set_capabilities(svn_ra_svn_conn_t *conn,
 int
 svn_ra_svn__svndiff_version(svn_ra_svn_conn_t *conn);
 
+/** Compress all further data sent and received over @a conn, using LZ4 if
+ * @a use_lz4 is set and zlib with the connection's compression level
+ * otherwise.  Both sides must switch at the same point in the protocol.
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_ra_svn__enable_compression(svn_ra_svn_conn_t *conn,
+                               svn_boolean_t use_lz4,
+                               apr_pool_t *scratch_pool);
+
+/** Like svn_ra_svn_get_editor() without a callback, but send the text
+ * changes of files that have no delta base, i.e. deltas against the empty
+ * stream, as empty deltas.  The receiving end fetches those texts by
+ * itself, see the fetch-texts capability.
+ */
+void
+svn_ra_svn__get_editor_without_fulltexts(const svn_delta_editor_t **editor,
+                                         void **edit_baton,
+                                         svn_ra_svn_conn_t *conn,
+                                         apr_pool_t *pool);
 
 /**
  * Set the shim callbacks to be used by @a conn to @a shim_callbacks.
@@ -178,6 +198,21 @@ svn_ra_svn__write_cstring(svn_ra_svn_conn_t *conn,
                           apr_pool_t *pool,
                           const char *s);
 
+/** Write a string over the net whose contents are the @a len bytes at
+ * @a offset in @a file.
+ *
+ * Unlike the other write functions, this flushes the write buffer and
+ * sends the contents without copying them into user space if @a conn
+ * is a plain socket connection and the platform supports sendfile.
+ * Otherwise, the contents are copied through a temporary buffer.
+ */
+svn_error_t *
+svn_ra_svn__write_file_range(svn_ra_svn_conn_t *conn,
+                             apr_pool_t *pool,
+                             apr_file_t *file,
+                             apr_off_t offset,
+                             apr_size_t len);
+
 /** Write a word over the net.
  *
  * Writes will be buffered until the next read or flush.
@@ -773,6 +808,10 @@ svn_ra_svn__write_cmd_get_file(svn_ra_svn_conn_t *conn,
 /** Send a "update" command over connection @a conn.
  * Use @a pool for allocations.
  *
+ * If @a text_deltas is FALSE, the server will only announce which files
+ * have changed contents but not send their text deltas.  That is only
+ * supported by servers with the #SVN_RA_SVN_CAP_FETCH_TEXTS capability.
+ *
  * @see #svn_ra_do_update3 for a description.
  */
 svn_error_t *
@@ -783,7 +822,8 @@ svn_ra_svn__write_cmd_update(svn_ra_svn_conn_t *conn,
                              svn_boolean_t recurse,
                              svn_depth_t depth,
                              svn_boolean_t send_copyfrom_args,
-                             svn_boolean_t ignore_ancestry);
+                             svn_boolean_t ignore_ancestry,
+                             svn_boolean_t text_deltas);
 
 /** Send a "switch" command over connection @a conn.
  * Use @a pool for allocations.
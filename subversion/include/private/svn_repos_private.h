@@ -390,6 +390,38 @@ svn_repos__get_dump_editor(const svn_delta_editor_t **editor,
                            const char *update_anchor_relpath,
                            apr_pool_t *pool);
 
+/* Like svn_repos_load_fs6() but, if JOBS is larger than 1, read
+ * DUMPSTREAM and decode the svndiff data of its text deltas on separate
+ * threads ahead of committing the revisions.
+ *
+ * Applying the deltas, computing checksums and writing to the repository
+ * still happen on the calling thread, one revision at a time and in
+ * stream order.  Thus, the result is the same as with a single job but
+ * the speedup is limited to the parser's share of the load.  CANCEL_FUNC
+ * may be called from threads other than the caller's.
+ *
+ * ### This is not public API because it does not yet prepare the node
+ *     contents for the next revisions while the current one commits.
+ */
+svn_error_t *
+svn_repos__load_fs_pipelined(svn_repos_t *repos,
+                             svn_stream_t *dumpstream,
+                             svn_revnum_t start_rev,
+                             svn_revnum_t end_rev,
+                             enum svn_repos_load_uuid uuid_action,
+                             const char *parent_dir,
+                             svn_boolean_t use_pre_commit_hook,
+                             svn_boolean_t use_post_commit_hook,
+                             svn_boolean_t validate_props,
+                             svn_boolean_t ignore_dates,
+                             svn_boolean_t normalize_props,
+                             int jobs,
+                             svn_repos_notify_func_t notify_func,
+                             void *notify_baton,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -52,6 +52,7 @@ typedef struct svn_sqlite__db_t svn_sqlite__db_t;
 typedef struct svn_sqlite__stmt_t svn_sqlite__stmt_t;
 typedef struct svn_sqlite__context_t svn_sqlite__context_t;
 typedef struct svn_sqlite__value_t svn_sqlite__value_t;
+typedef struct svn_sqlite__rows_t svn_sqlite__rows_t;
 
 typedef enum svn_sqlite__mode_e {
     svn_sqlite__mode_readonly,   /* open the database read-only */
@@ -354,6 +355,100 @@ svn_sqlite__column_is_null(svn_sqlite__stmt_t *stmt, int column);
 int
 svn_sqlite__column_bytes(svn_sqlite__stmt_t *stmt, int column);
 
+
+/* ---------------------------------------------------------------------
+
+   FETCHING ROWS IN BULK
+
+   Instead of reading the columns of a statement row by row, a caller can
+   fetch all result rows at once into a svn_sqlite__rows_t.  The values
+   are stored column by column in contiguous arrays, so reading a large
+   result costs a handful of allocations instead of several per row, and
+   the statement is done (and reset) before the caller runs any other
+   query on the same database.
+
+   The svn_sqlite__rows_* accessors work like their svn_sqlite__column_*
+   counterparts, except that they do not convert between types: text and
+   blob accessors return NULL for integer values and integer accessors
+   return 0 for text and blob values.  Text and blob values stay valid as
+   long as the pool the rows were fetched into.
+*/
+
+/* Step STMT until it is done and store all of its result rows in *ROWS,
+   allocated in RESULT_POOL.  STMT is reset before returning.
+
+   Text and blob values in the columns whose bit is set in INTERN_COLUMNS
+   (bit N for column N, for N < 32) are interned: rows with equal values
+   in such a column share one copy.  Use this for columns that have few
+   distinct values, like tokens and author names. */
+svn_error_t *
+svn_sqlite__fetch_rows(svn_sqlite__rows_t **rows,
+                       svn_sqlite__stmt_t *stmt,
+                       apr_uint32_t intern_columns,
+                       apr_pool_t *result_pool);
+
+/* Return the number of rows in ROWS. */
+int
+svn_sqlite__rows_count(const svn_sqlite__rows_t *rows);
+
+/* Return the text in COLUMN of ROW, or NULL if it is null. */
+const char *
+svn_sqlite__rows_text(const svn_sqlite__rows_t *rows, int row, int column);
+
+/* Return the blob in COLUMN of ROW and set *LEN to its length, or return
+   NULL if it is null. */
+const void *
+svn_sqlite__rows_blob(const svn_sqlite__rows_t *rows, int row, int column,
+                      apr_size_t *len);
+
+/* Return the integer in COLUMN of ROW, or 0 if it is null. */
+apr_int64_t
+svn_sqlite__rows_int64(const svn_sqlite__rows_t *rows, int row, int column);
+
+/* Like svn_sqlite__rows_int64(), but return an int. */
+int
+svn_sqlite__rows_int(const svn_sqlite__rows_t *rows, int row, int column);
+
+/* Return the revision in COLUMN of ROW, or SVN_INVALID_REVNUM if it is
+   null. */
+svn_revnum_t
+svn_sqlite__rows_revnum(const svn_sqlite__rows_t *rows, int row, int column);
+
+/* Return TRUE if the integer in COLUMN of ROW is not 0. */
+svn_boolean_t
+svn_sqlite__rows_boolean(const svn_sqlite__rows_t *rows, int row,
+                         int column);
+
+/* Like svn_sqlite__column_token(), for COLUMN of ROW. */
+int
+svn_sqlite__rows_token(const svn_sqlite__rows_t *rows, int row, int column,
+                       const svn_token_map_t *map);
+
+/* Like svn_sqlite__column_token_null(), for COLUMN of ROW. */
+int
+svn_sqlite__rows_token_null(const svn_sqlite__rows_t *rows, int row,
+                            int column, const svn_token_map_t *map,
+                            int null_val);
+
+/* Like svn_sqlite__column_properties(), for COLUMN of ROW. */
+svn_error_t *
+svn_sqlite__rows_properties(apr_hash_t **props,
+                            const svn_sqlite__rows_t *rows,
+                            int row,
+                            int column,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
+/* Return TRUE if COLUMN of ROW is null, FALSE otherwise. */
+svn_boolean_t
+svn_sqlite__rows_is_null(const svn_sqlite__rows_t *rows, int row,
+                         int column);
+
+/* Return the length in bytes of the text or blob in COLUMN of ROW, or 0
+   for other values. */
+apr_size_t
+svn_sqlite__rows_bytes(const svn_sqlite__rows_t *rows, int row, int column);
+
 /* When Subversion is compiled in maintainer mode: enables the sqlite error
    logging to SVN_DBG_OUTPUT. */
 void
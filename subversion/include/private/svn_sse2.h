@@ -0,0 +1,47 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_sse2.h
+ * @brief Compile-time detection of SSE2 support
+ */
+
+#ifndef SVN_SSE2_H
+#define SVN_SSE2_H
+
+/**
+ * Defined as 1 and with <emmintrin.h> included if the compiler targets
+ * a CPU that supports SSE2.  This is always the case on x86-64.  On
+ * 32 bit x86, it depends on the compiler options.  No runtime detection
+ * takes place.
+ *
+ * Code using SSE2 intrinsics must provide a portable fallback for builds
+ * where SVN_HAVE_SSE2 is not defined.
+ *
+ * @since New in 1.15.
+ */
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SVN_HAVE_SSE2 1
+#endif
+
+#endif /* SVN_SSE2_H */
@@ -726,6 +726,53 @@ svn_dso__pool(void);
 /** @} */
 
 
+/**
+ * @defgroup svn_subst_private Single-pass translation helpers
+ * @{
+ */
+
+/* Translate the contents of SOURCE as svn_subst_stream_translated() would
+ * with EOL_STR, REPAIR, KEYWORDS and EXPAND, and set *SAME to TRUE if the
+ * result is identical to the contents of COMPARE_TO, else to FALSE.
+ *
+ * This does the same as svn_stream_contents_same2() on a translated
+ * SOURCE, but compares the translated data while it is produced, without
+ * buffering it in an intermediate stream, and stops reading at the first
+ * difference.
+ *
+ * Both streams will be closed before a successful return.  Use
+ * SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_subst__translated_contents_same(svn_boolean_t *same,
+                                    svn_stream_t *source,
+                                    svn_stream_t *compare_to,
+                                    const char *eol_str,
+                                    svn_boolean_t repair,
+                                    apr_hash_t *keywords,
+                                    svn_boolean_t expand,
+                                    apr_pool_t *scratch_pool);
+
+/* Like svn_subst__translated_contents_same(), but set *CHECKSUM to the
+ * checksum of KIND of the translated contents of SOURCE, allocated in
+ * RESULT_POOL.
+ *
+ * SOURCE will be closed before a successful return.
+ */
+svn_error_t *
+svn_subst__translated_checksum(svn_checksum_t **checksum,
+                               svn_stream_t *source,
+                               svn_checksum_kind_t kind,
+                               const char *eol_str,
+                               svn_boolean_t repair,
+                               apr_hash_t *keywords,
+                               svn_boolean_t expand,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
+/** @} */
+
+
 /* Return the xml (expat) version we compiled against. */
 const char *svn_xml__compiled_version(void);
 
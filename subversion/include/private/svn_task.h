@@ -0,0 +1,150 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_task.h
+ * @brief Concurrent processing of work items with in-order results
+ */
+
+#ifndef SVN_TASK_H
+#define SVN_TASK_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * A task queue processes work items ("tasks") on a fixed number of worker
+ * threads while handing the results back to the consumer strictly in the
+ * order in which the tasks had been added.  This allows for pipelines
+ * where a single thread produces the tasks, e.g. by parsing some input,
+ * and another thread - usually the caller - consumes the results in
+ * their original order, e.g. writing them to a repository.
+ *
+ * Each task comes with its own root pool that is owned by the queue
+ * between svn_task__queue_push() and svn_task__queue_pop().  Because
+ * each pool is only ever used by one thread at a time, it does not need
+ * to be thread-safe itself.
+ *
+ * If APR does not support threads or the number of threads is 0, tasks
+ * get processed synchronously by svn_task__queue_push().
+ */
+typedef struct svn_task__queue_t svn_task__queue_t;
+
+/** Callback type processing a single @a task with the @a process_baton
+ * given to svn_task__queue_create().  Return the result in @a *result,
+ * allocated in @a result_pool, which is the pool that was passed along
+ * with @a task.  Use @a scratch_pool for temporary allocations.
+ *
+ * This function may be called concurrently from multiple threads.  Any
+ * data shared between tasks, including @a process_baton, must only be
+ * accessed in a thread-safe way.
+ */
+typedef svn_error_t *
+(*svn_task__process_func_t)(void **result,
+                            void *task,
+                            void *process_baton,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
+/** Set @a *queue to a new task queue, allocated in @a result_pool, that
+ * processes tasks by calling @a process_func with @a process_baton on
+ * @a thread_count worker threads.
+ *
+ * If @a max_pending is not 0, svn_task__queue_push() will block while
+ * @a max_pending tasks have been pushed but not popped, yet.  This limits
+ * the amount of memory held by unconsumed results.  It is the caller's
+ * responsibility to not wait for itself in that case, i.e. a thread that
+ * pushes as well as pops tasks must keep track of the number of pending
+ * tasks.
+ *
+ * Clearing @a result_pool shuts the queue down and waits for the worker
+ * threads to finish their current tasks.  Results that have not been
+ * consumed, yet, will be discarded.
+ */
+svn_error_t *
+svn_task__queue_create(svn_task__queue_t **queue,
+                       int thread_count,
+                       int max_pending,
+                       svn_task__process_func_t process_func,
+                       void *process_baton,
+                       apr_pool_t *result_pool);
+
+/** Add @a task to the end of @a queue.  @a task as well as its result will
+ * be allocated in @a task_pool, which must be a root pool and which is
+ * passed to the queue's process function as its result pool.  @a queue
+ * takes ownership of @a task_pool until it gets returned by
+ * svn_task__queue_pop().
+ *
+ * If the queue has been shut down, @a task_pool gets destroyed and
+ * #SVN_ERR_CANCELLED will be returned.
+ *
+ * This function may be called from any thread.
+ */
+svn_error_t *
+svn_task__queue_push(svn_task__queue_t *queue,
+                     void *task,
+                     apr_pool_t *task_pool);
+
+/** Wait for the oldest task in @a queue to be processed, remove it from
+ * @a queue and return its result in @a *result.  Return the task itself
+ * and its pool in @a *task and @a *task_pool, respectively.  The caller
+ * takes ownership of the latter and must destroy it eventually.  @a task
+ * may be @c NULL.
+ *
+ * If processing the task returned an error, return that error.  The task
+ * and its pool will be returned nevertheless.  If the queue has been shut
+ * down, return #SVN_ERR_CANCELLED.
+ *
+ * This function may be called from any thread but it must not be called
+ * on an empty queue unless some other thread is going to push more tasks.
+ */
+svn_error_t *
+svn_task__queue_pop(void **result,
+                    void **task,
+                    apr_pool_t **task_pool,
+                    svn_task__queue_t *queue);
+
+/** Return the number of tasks in @a queue that have been pushed but not
+ * popped, yet.
+ */
+int
+svn_task__queue_size(svn_task__queue_t *queue);
+
+/** Shut @a queue down, making any blocked and future calls to
+ * svn_task__queue_push() and svn_task__queue_pop() return
+ * #SVN_ERR_CANCELLED.  Worker threads will terminate after finishing
+ * their current task.  This function does not wait for them.
+ *
+ * This function may be called from any thread.
+ */
+svn_error_t *
+svn_task__queue_shutdown(svn_task__queue_t *queue);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_TASK_H */
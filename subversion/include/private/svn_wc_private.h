@@ -1051,6 +1051,113 @@ svn_wc__get_pristine_contents_by_checksum(svn_stream_t **contents,
                                           apr_pool_t *result_pool,
                                           apr_pool_t *scratch_pool);
 
+/* Set *STORE_PRISTINE to TRUE if the working copy of LOCAL_ABSPATH keeps
+   the pristine text of every file, and to FALSE if it was checked out
+   without a pristine store and only keeps the texts it needs.
+ */
+svn_error_t *
+svn_wc__get_store_pristine(svn_boolean_t *store_pristine,
+                           svn_wc_context_t *wc_ctx,
+                           const char *local_abspath,
+                           apr_pool_t *scratch_pool);
+
+/* Callback for svn_wc__textbase_sync().  Write the contents of the file
+   REPOS_RELPATH in revision REVISION of the repository at REPOS_ROOT_URL
+   to CONTENTS, in repository normal form, and close CONTENTS.
+ */
+typedef svn_error_t *(*svn_wc__textbase_fetch_t)(
+  void *baton,
+  const char *repos_root_url,
+  const char *repos_relpath,
+  svn_revnum_t revision,
+  svn_stream_t *contents,
+  svn_cancel_func_t cancel_func,
+  void *cancel_baton,
+  apr_pool_t *scratch_pool);
+
+/* Prepare the pristine texts of LOCAL_ABSPATH and its descendants for
+   an operation, if the working copy was checked out without a pristine
+   store.  Do nothing for other working copies.
+
+   If ALLOW_HYDRATE is TRUE, use FETCH_FUNC with FETCH_BATON to fetch
+   every missing pristine text that cannot be derived from an unmodified
+   working file, i.e. the texts of modified, missing, deleted and shadowed
+   files.  Operations like update, revert and diff need these.
+
+   If ALLOW_DEHYDRATE is TRUE, remove the least recently used pristine
+   texts that are not needed anymore until the rest fits in the configured
+   pristine cache size.
+
+   Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_wc__textbase_sync(svn_wc_context_t *wc_ctx,
+                      const char *local_abspath,
+                      svn_boolean_t allow_hydrate,
+                      svn_boolean_t allow_dehydrate,
+                      svn_wc__textbase_fetch_t fetch_func,
+                      void *fetch_baton,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *scratch_pool);
+
+/* Return the number of threads that operations in WC_CTX may use for
+   file system work that does not access the working copy database, as
+   configured in the [working-copy] section of the config.  */
+int
+svn_wc__get_io_threads(svn_wc_context_t *wc_ctx);
+
+/* The text delta transmission of a single file for commit, split in three
+   steps so that the expensive part can run on a worker thread.  Together,
+   the steps do what svn_wc_transmit_text_deltas3() does.
+
+   svn_wc__prepare_text_deltas() and svn_wc__send_text_deltas() access the
+   working copy and the editor, so they must be called from the thread
+   that uses WC_CTX.  svn_wc__compute_text_deltas() only reads and writes
+   files and may be called from any thread.
+ */
+typedef struct svn_wc__text_deltas_t svn_wc__text_deltas_t;
+
+/* Set *TEXT_DELTAS to a new text delta transmission of the file at
+   LOCAL_ABSPATH in WC_CTX, sending a fulltext if FULLTEXT is TRUE or no
+   pristine text is available.  Open the files involved.
+
+   Allocate *TEXT_DELTAS in RESULT_POOL, which must not be used by other
+   threads until the transmission has been sent, and which must outlive it.
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_wc__prepare_text_deltas(svn_wc__text_deltas_t **text_deltas,
+                            svn_wc_context_t *wc_ctx,
+                            const char *local_abspath,
+                            svn_boolean_t fulltext,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
+/* Compute the delta of TEXT_DELTAS into a temporary file, together with
+   the checksums of the old and new text, and write the new pristine text.
+   Verify the old text against its recorded checksum.
+
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_wc__compute_text_deltas(svn_wc__text_deltas_t *text_deltas,
+                            apr_pool_t *scratch_pool);
+
+/* Send the delta computed by svn_wc__compute_text_deltas() to FILE_BATON
+   of EDITOR, install the new pristine text in WC_CTX and close FILE_BATON.
+
+   Set *NEW_TEXT_BASE_MD5_CHECKSUM and *NEW_TEXT_BASE_SHA1_CHECKSUM like
+   svn_wc_transmit_text_deltas3() does, allocated in RESULT_POOL.  Use
+   SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_wc__send_text_deltas(const svn_checksum_t **new_text_base_md5_checksum,
+                         const svn_checksum_t **new_text_base_sha1_checksum,
+                         svn_wc_context_t *wc_ctx,
+                         svn_wc__text_deltas_t *text_deltas,
+                         const svn_delta_editor_t *editor,
+                         void *file_baton,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool);
+
 /* Gets an array of const char *repos_relpaths of descendants of LOCAL_ABSPATH,
  * which must be the op root of an addition, copy or move. The descendants
  * returned are at the same op_depth, but are to be deleted by the commit
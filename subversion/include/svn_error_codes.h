@@ -576,6 +576,11 @@ SVN_ERROR_START
              SVN_ERR_WC_CATEGORY_START + 41,
              "Duplicate targets in svn:externals property")
 
+  /** @since New in 1.15 */
+  SVN_ERRDEF(SVN_ERR_WC_PRISTINE_DEHYDRATED,
+             SVN_ERR_WC_CATEGORY_START + 42,
+             "Pristine text not available in the working copy")
+
   /* fs errors */
 
   SVN_ERRDEF(SVN_ERR_FS_GENERAL,
@@ -140,6 +140,15 @@ typedef struct svn_fs_t svn_fs_t;
  */
 #define SVN_FS_CONFIG_FSFS_CACHE_NODEPROPS      "fsfs-cache-nodeprops"
 
+/** Number of threads that svn_fs_verify() may use to check the
+ * FSFS format 7+ metadata of multiple shards concurrently.
+ *
+ * "1", the default, verifies one shard after the other.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_FS_CONFIG_FSFS_VERIFY_JOBS          "fsfs-verify-jobs"
+
 /** Enable / disable the FSFS format 7 "block read" feature.
  *
  * @since New in 1.9.
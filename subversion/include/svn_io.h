@@ -589,6 +589,10 @@ svn_io_set_file_affected_time(apr_time_t apr_time,
  * Errors while retrieving the timestamp resolution will result in sleeping
  * to the next second, to keep the working copy stable in error conditions.
  *
+ * @note Since 1.15 this doesn't sleep at all on filesystems with
+ * sub-second timestamps, as the working copy no longer records timestamps
+ * there that a modification could still repeat.
+ *
  * @since New in 1.6.
  */
 void
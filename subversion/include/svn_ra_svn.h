@@ -50,6 +50,7 @@ extern "C" {
 #define SVN_RA_SVN_CAP_EDIT_PIPELINE "edit-pipeline"
 #define SVN_RA_SVN_CAP_SVNDIFF1 "svndiff1"
 #define SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED "accepts-svndiff2"
+#define SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED "accepts-svndiff3"
 #define SVN_RA_SVN_CAP_ABSENT_ENTRIES "absent-entries"
 /* maps to SVN_RA_CAPABILITY_COMMIT_REVPROPS: */
 #define SVN_RA_SVN_CAP_COMMIT_REVPROPS "commit-revprops"
@@ -71,6 +72,17 @@ extern "C" {
 #define SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE "file-revs-reverse"
 /* maps to SVN_RA_CAPABILITY_LIST */
 #define SVN_RA_SVN_CAP_LIST "list"
+/** The server accepts update commands without text deltas, leaving it
+ * to the client to fetch the changed file contents separately.
+ * @since New in 1.15. */
+#define SVN_RA_SVN_CAP_FETCH_TEXTS "fetch-texts"
+/** Compress the whole data stream with LZ4 after the connection has been
+ * set up.  Offered by the server, selected by the client.
+ * @since New in 1.15. */
+#define SVN_RA_SVN_CAP_COMPRESS_LZ4 "compress-lz4"
+/** Like #SVN_RA_SVN_CAP_COMPRESS_LZ4 but using zlib compression.
+ * @since New in 1.15. */
+#define SVN_RA_SVN_CAP_COMPRESS_ZLIB "compress-zlib"
 
 
 /** ra_svn passes @c svn_dirent_t fields over the wire as a list of
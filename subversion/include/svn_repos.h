@@ -3220,6 +3220,13 @@ typedef svn_error_t *(*svn_repos_verify_callback_t)(void *baton,
  *            called has reached its end and is about to return?
  *        ### Not sent, currently, if a FS structure error is found.
  *
+ * If @a jobs is larger than 1, verify up to @a jobs revisions - and, for
+ * backends that support it, up to @a jobs shards of FS-specific structure
+ * - concurrently, each on its own thread and filesystem instance.  All
+ * notifications and @a verify_callback invocations will still be made from
+ * the calling thread and strictly in revision order, i.e. the reported
+ * results are the same as with a single job.
+ *
  * If @a cancel_func is not @c NULL, call it periodically with @a
  * cancel_baton as argument to see if the caller wishes to cancel the
  * verification.
@@ -3228,8 +3235,30 @@ typedef svn_error_t *(*svn_repos_verify_callback_t)(void *baton,
  *
  * @see svn_repos_verify_callback_t
  *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_repos_verify_fs4(svn_repos_t *repos,
+                     svn_revnum_t start_rev,
+                     svn_revnum_t end_rev,
+                     svn_boolean_t check_normalization,
+                     svn_boolean_t metadata_only,
+                     int jobs,
+                     svn_repos_notify_func_t notify_func,
+                     void *notify_baton,
+                     svn_repos_verify_callback_t verify_callback,
+                     void *verify_baton,
+                     svn_cancel_func_t cancel,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool);
+
+/**
+ * Similar to svn_repos_verify_fs4(), but with @a jobs always set to 1.
+ *
  * @since New in 1.9.
+ * @deprecated Provided for backward compatibility with the 1.14 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_verify_fs3(svn_repos_t *repos,
                      svn_revnum_t start_rev,
@@ -3543,10 +3543,36 @@ svn_wc_mark_missing_deleted(const char *path,
  * Do not ensure existence of @a local_abspath itself; if @a local_abspath
  * does not exist, return error.
  *
+ * If @a store_pristine is FALSE and a new administrative area is created,
+ * the working copy will not keep a pristine copy of every file.  It
+ * only stores the pristine texts it needs and fetches the others from
+ * the repository when they are needed.  Such working copies cannot be
+ * used by clients older than 1.15.  If the administrative area already
+ * exists, @a store_pristine is ignored.
+ *
  * Use @a scratch_pool for temporary allocations.
  *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_wc_ensure_adm5(svn_wc_context_t *wc_ctx,
+                   const char *local_abspath,
+                   const char *url,
+                   const char *repos_root_url,
+                   const char *repos_uuid,
+                   svn_revnum_t revision,
+                   svn_depth_t depth,
+                   svn_boolean_t store_pristine,
+                   apr_pool_t *scratch_pool);
+
+/**
+ * Similar to svn_wc_ensure_adm5(), but always creates a working copy
+ * that stores pristine texts.
+ *
  * @since New in 1.7.
+ * @deprecated Provided for backwards compatibility with the 1.14 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_wc_ensure_adm4(svn_wc_context_t *wc_ctx,
                    const char *local_abspath,
@@ -539,6 +539,9 @@ svn_client__update_internal(svn_revnum_t *result_rev,
    the repos are tolerated; if FALSE, these obstructions cause the checkout
    to fail.
 
+   If STORE_PRISTINE is FALSE, a new working copy is created without a
+   pristine store; see svn_wc_ensure_adm5().
+
    If RA_SESSION is NOT NULL, it may be used to avoid creating a new
    session. The session may point to a different URL after returning.
    */
@@ -552,6 +555,7 @@ svn_client__checkout_internal(svn_revnum_t *result_rev,
                               svn_depth_t depth,
                               svn_boolean_t ignore_externals,
                               svn_boolean_t allow_unver_obstructions,
+                              svn_boolean_t store_pristine,
                               svn_ra_session_t *ra_session,
                               svn_client_ctx_t *ctx,
                               apr_pool_t *pool);
@@ -1236,6 +1240,30 @@ svn_client__merge_locked(svn_client__conflict_report_t **conflict_report,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool);
 
+/* ---------------------------------------------------------------- */
+
+
+/*** Pristine texts ***/
+
+/* If the working copy at LOCAL_ABSPATH has no pristine store, make sure
+   that the pristine texts of the nodes at and below LOCAL_ABSPATH are
+   available before an operation that needs them, and drop the ones that
+   are no longer needed afterwards.
+
+   If ALLOW_HYDRATE is TRUE, fetch the pristine texts that are needed but
+   missing from the repository.  If ALLOW_DEHYDRATE is TRUE, remove the
+   pristine texts that are not needed anymore, as far as they don't fit
+   in the local pristine cache.
+
+   Do nothing if the working copy has a pristine store.  Use CTX for
+   opening RA sessions and for cancellation. */
+svn_error_t *
+svn_client__textbase_sync(const char *local_abspath,
+                          svn_boolean_t allow_hydrate,
+                          svn_boolean_t allow_dehydrate,
+                          svn_client_ctx_t *ctx,
+                          apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -1033,6 +1033,20 @@ svn_client_commit6(const apr_array_header_t *targets,
 
       if (bump_err)
         goto cleanup;
+
+      /* The committed texts are now pristine texts; drop the ones that
+         a working copy without a pristine store doesn't need. */
+      for (i = 0; i < locks_obtained->nelts; i++)
+        {
+          const char *lock_root = APR_ARRAY_IDX(locks_obtained, i,
+                                                const char *);
+
+          svn_pool_clear(iterpool);
+          bump_err = svn_client__textbase_sync(lock_root, FALSE, TRUE, ctx,
+                                               iterpool);
+          if (bump_err)
+            goto cleanup;
+        }
     }
 
  cleanup:
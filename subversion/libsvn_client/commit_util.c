@@ -45,6 +45,7 @@
 #include "private/svn_wc_private.h"
 #include "private/svn_client_private.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_task.h"
 
 /*** Uncomment this to turn on commit driver debugging. ***/
 /*
@@ -1856,6 +1857,158 @@ fixup_error:
                                             err, ctx, pool));
 }
 
+/* Send a commit_postfix_txdelta notification for ITEM through CTX. */
+static void
+notify_txdelta(const svn_client_commit_item3_t *item,
+               const char *notify_path_prefix,
+               svn_client_ctx_t *ctx,
+               apr_pool_t *scratch_pool)
+{
+  if (ctx->notify_func2)
+    {
+      svn_wc_notify_t *notify;
+      notify = svn_wc_create_notify(item->path,
+                                    svn_wc_notify_commit_postfix_txdelta,
+                                    scratch_pool);
+      notify->kind = svn_node_file;
+      notify->path_prefix = notify_path_prefix;
+      ctx->notify_func2(ctx->notify_baton2, notify, scratch_pool);
+    }
+}
+
+/* Return TRUE if the text of ITEM must be sent as a fulltext because the
+   node has no history. */
+static svn_boolean_t
+needs_fulltext(const svn_client_commit_item3_t *item)
+{
+  return ((item->state_flags & SVN_CLIENT_COMMIT_ITEM_ADD)
+          && ! (item->state_flags & SVN_CLIENT_COMMIT_ITEM_IS_COPY));
+}
+
+#if APR_HAS_THREADS
+/* Implements svn_task__process_func_t, computing the text deltas of the
+   svn_wc__text_deltas_t in TASK. */
+static svn_error_t *
+compute_text_deltas_task(void **result,
+                         void *task,
+                         void *process_baton,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  *result = NULL;
+  return svn_error_trace(svn_wc__compute_text_deltas(task, scratch_pool));
+}
+
+/* Transmit the text deltas of the struct file_mod_t * in MODS to EDITOR
+   in order, like svn_client__do_commit() does, but compute the deltas and
+   checksums on THREADS worker threads.  Record the new SHA-1 checksums in
+   SHA1_CHECKSUMS unless that is NULL.
+
+   The working copy and EDITOR are only used by the calling thread. */
+static svn_error_t *
+transmit_text_deltas_concurrently(apr_hash_t *sha1_checksums,
+                                  const apr_array_header_t *mods,
+                                  int threads,
+                                  const svn_delta_editor_t *editor,
+                                  const char *base_url,
+                                  const char *notify_path_prefix,
+                                  svn_client_ctx_t *ctx,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *queue_pool = svn_pool_create(scratch_pool);
+  svn_task__queue_t *queue = NULL;
+  int max_pending = 2 * threads;
+  int pushed = 0;
+  int popped = 0;
+  svn_error_t *err;
+
+  err = svn_task__queue_create(&queue, threads, max_pending,
+                               compute_text_deltas_task, NULL, queue_pool);
+
+  while (!err && popped < mods->nelts)
+    {
+      const struct file_mod_t *mod;
+      svn_wc__text_deltas_t *td;
+      apr_pool_t *task_pool;
+      void *result;
+
+      svn_pool_clear(iterpool);
+
+      /* Keep the workers busy.  Reading the working copy is not
+         thread-safe, so prepare the transmission right here. */
+      if (pushed < mods->nelts && svn_task__queue_size(queue) < max_pending)
+        {
+          mod = APR_ARRAY_IDX(mods, pushed, const struct file_mod_t *);
+          task_pool = svn_pool_create(NULL);
+          err = svn_wc__prepare_text_deltas(&td, ctx->wc_ctx, mod->item->path,
+                                            needs_fulltext(mod->item),
+                                            task_pool, iterpool);
+          if (err)
+            {
+              svn_pool_destroy(task_pool);
+              err = fixup_commit_error(mod->item->path, base_url,
+                                       mod->item->session_relpath,
+                                       svn_node_file, err, ctx, scratch_pool);
+            }
+          else
+            err = svn_task__queue_push(queue, td, task_pool);
+
+          ++pushed;
+          continue;
+        }
+
+      if (ctx->cancel_func)
+        err = ctx->cancel_func(ctx->cancel_baton);
+      if (err)
+        break;
+
+      /* The oldest pending task belongs to the next file to transmit. */
+      mod = APR_ARRAY_IDX(mods, popped, const struct file_mod_t *);
+      task_pool = NULL;
+      err = svn_task__queue_pop(&result, (void **)&td, &task_pool, queue);
+      if (!err)
+        {
+          const svn_checksum_t *new_text_base_sha1_checksum;
+
+          notify_txdelta(mod->item, notify_path_prefix, ctx, iterpool);
+          err = svn_wc__send_text_deltas(NULL, &new_text_base_sha1_checksum,
+                                         ctx->wc_ctx, td, editor,
+                                         mod->file_baton,
+                                         result_pool, iterpool);
+          if (!err)
+            {
+              if (sha1_checksums)
+                svn_hash_sets(sha1_checksums, mod->item->path,
+                              new_text_base_sha1_checksum);
+
+              svn_pool_destroy(mod->file_pool);
+              ++popped;
+            }
+        }
+
+      /* Without a task, the queue has been shut down. */
+      if (err && task_pool)
+        err = fixup_commit_error(mod->item->path, base_url,
+                                 mod->item->session_relpath,
+                                 svn_node_file, err, ctx, scratch_pool);
+
+      if (task_pool)
+        svn_pool_destroy(task_pool);
+    }
+
+  /* Stop all workers and wait for them to finish. */
+  if (queue)
+    svn_error_clear(svn_task__queue_shutdown(queue));
+  svn_pool_destroy(queue_pool);
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+#endif
+
 svn_error_t *
 svn_client__do_commit(const char *base_url,
                       const apr_array_header_t *commit_items,
@@ -1875,6 +2028,10 @@ svn_client__do_commit(const char *base_url,
   struct item_commit_baton cb_baton;
   apr_array_header_t *paths =
     apr_array_make(scratch_pool, commit_items->nelts, sizeof(const char *));
+  apr_array_header_t *mods;
+#if APR_HAS_THREADS
+  int threads;
+#endif
 
   /* Ditto for the checksums. */
   if (sha1_checksums)
@@ -1904,15 +2061,37 @@ svn_client__do_commit(const char *base_url,
                                  do_item_commit, &cb_baton, scratch_pool));
 
   /* Transmit outstanding text deltas. */
+  mods = apr_array_make(scratch_pool, apr_hash_count(file_mods),
+                        sizeof(struct file_mod_t *));
   for (hi = apr_hash_first(scratch_pool, file_mods);
        hi;
        hi = apr_hash_next(hi))
+    APR_ARRAY_PUSH(mods, struct file_mod_t *) = apr_hash_this_val(hi);
+
+#if APR_HAS_THREADS
+  threads = svn_wc__get_io_threads(ctx->wc_ctx);
+  if (threads > 1 && mods->nelts > 1)
+    {
+      svn_error_t *err;
+
+      err = transmit_text_deltas_concurrently(
+              sha1_checksums ? *sha1_checksums : NULL, mods, threads,
+              editor, base_url, notify_path_prefix, ctx,
+              result_pool, iterpool);
+      if (err)
+        {
+          svn_pool_destroy(iterpool); /* Close tempfiles */
+          return svn_error_trace(err);
+        }
+    }
+  else
+#endif
+  for (i = 0; i < mods->nelts; i++)
     {
-      struct file_mod_t *mod = apr_hash_this_val(hi);
+      struct file_mod_t *mod = APR_ARRAY_IDX(mods, i, struct file_mod_t *);
       const svn_client_commit_item3_t *item = mod->item;
       const svn_checksum_t *new_text_base_md5_checksum;
       const svn_checksum_t *new_text_base_sha1_checksum;
-      svn_boolean_t fulltext = FALSE;
       svn_error_t *err;
 
       svn_pool_clear(iterpool);
@@ -1921,26 +2100,13 @@ svn_client__do_commit(const char *base_url,
       if (ctx->cancel_func)
         SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
 
-      if (ctx->notify_func2)
-        {
-          svn_wc_notify_t *notify;
-          notify = svn_wc_create_notify(item->path,
-                                        svn_wc_notify_commit_postfix_txdelta,
-                                        iterpool);
-          notify->kind = svn_node_file;
-          notify->path_prefix = notify_path_prefix;
-          ctx->notify_func2(ctx->notify_baton2, notify, iterpool);
-        }
-
-      /* If the node has no history, transmit full text */
-      if ((item->state_flags & SVN_CLIENT_COMMIT_ITEM_ADD)
-          && ! (item->state_flags & SVN_CLIENT_COMMIT_ITEM_IS_COPY))
-        fulltext = TRUE;
+      notify_txdelta(item, notify_path_prefix, ctx, iterpool);
 
       err = svn_wc_transmit_text_deltas3(&new_text_base_md5_checksum,
                                          &new_text_base_sha1_checksum,
                                          ctx->wc_ctx, item->path,
-                                         fulltext, editor, mod->file_baton,
+                                         needs_fulltext(item),
+                                         editor, mod->file_baton,
                                          result_pool, iterpool);
 
       if (err)
@@ -2422,6 +2422,7 @@ svn_client__repos_to_wc_copy_dir(svn_boolean_t *timestamp_sleep,
                                  apr_pool_t *scratch_pool)
 {
   const char *tmpdir_abspath, *tmp_abspath;
+  svn_boolean_t store_pristine;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(dst_abspath));
 
@@ -2456,6 +2457,11 @@ svn_client__repos_to_wc_copy_dir(svn_boolean_t *timestamp_sleep,
                                    svn_io_file_del_on_close,
                                    scratch_pool, scratch_pool));
 
+  /* The pristine texts of the checkout are transferred to the destination
+     working copy, so check out the same way that one was. */
+  SVN_ERR(svn_wc__get_store_pristine(&store_pristine, ctx->wc_ctx,
+                                     dst_abspath, scratch_pool));
+
   /* Make a new checkout of the requested source. While doing so,
    * resolve copy_src_revnum to an actual revision number in case it
    * was until now 'invalid' meaning 'head'.  Ask this function not to
@@ -2487,6 +2493,7 @@ svn_client__repos_to_wc_copy_dir(svn_boolean_t *timestamp_sleep,
                                         svn_depth_infinity,
                                         TRUE /*ignore_externals*/,
                                         FALSE, /* we don't allow obstructions */
+                                        store_pristine,
                                         ra_session, ctx, scratch_pool);
 
     ctx->notify_func2 = old_notify_func2;
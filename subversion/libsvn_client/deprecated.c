@@ -2668,6 +2668,25 @@ svn_client_cat(svn_stream_t *out,
 }
 
 /*** From checkout.c ***/
+svn_error_t *
+svn_client_checkout3(svn_revnum_t *result_rev,
+                     const char *URL,
+                     const char *path,
+                     const svn_opt_revision_t *peg_revision,
+                     const svn_opt_revision_t *revision,
+                     svn_depth_t depth,
+                     svn_boolean_t ignore_externals,
+                     svn_boolean_t allow_unver_obstructions,
+                     svn_client_ctx_t *ctx,
+                     apr_pool_t *pool)
+{
+  return svn_error_trace(svn_client_checkout4(result_rev, URL, path,
+                                              peg_revision, revision, depth,
+                                              ignore_externals,
+                                              allow_unver_obstructions,
+                                              TRUE, ctx, pool));
+}
+
 svn_error_t *
 svn_client_checkout2(svn_revnum_t *result_rev,
                      const char *URL,
@@ -1866,6 +1866,9 @@ diff_wc_wc(const char *path1,
                           "or between the working versions of two paths"
                           )));
 
+  SVN_ERR(svn_client__textbase_sync(abspath1, TRUE, FALSE, ctx,
+                                    scratch_pool));
+
   SVN_ERR(svn_wc__diff7(TRUE,
                         ctx->wc_ctx, abspath1, depth,
                         ignore_ancestry, changelists,
@@ -2269,6 +2272,9 @@ diff_repos_wc(struct diff_driver_info_t *ddi,
   if (reverse)
     diff_processor = svn_diff__tree_processor_reverse_create(diff_processor, scratch_pool);
 
+  SVN_ERR(svn_client__textbase_sync(abspath2, TRUE, FALSE, ctx,
+                                    scratch_pool));
+
   /* Use the diff editor to generate the diff. */
   SVN_ERR(svn_ra_has_capability(ra_session, &server_supports_depth,
                                 SVN_RA_CAPABILITY_DEPTH, scratch_pool));
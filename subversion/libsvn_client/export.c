@@ -1512,6 +1512,10 @@ svn_client_export5(svn_revnum_t *result_rev,
       eib.origin_abspath = from_path_or_url;
       eib.exported = FALSE;
 
+      if (revision->kind != svn_opt_revision_working)
+        SVN_ERR(svn_client__textbase_sync(from_path_or_url, TRUE, FALSE, ctx,
+                                          pool));
+
       SVN_ERR(svn_wc_walk_status(ctx->wc_ctx, from_path_or_url, depth,
                                  TRUE /* get_all */,
                                  TRUE /* no_ignore */,
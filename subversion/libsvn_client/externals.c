@@ -162,6 +162,7 @@ switch_dir_external(const char *local_abspath,
   apr_pool_t *subpool = svn_pool_create(pool);
   const char *repos_root_url;
   const char *repos_uuid;
+  svn_boolean_t store_pristine;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
 
@@ -407,11 +408,16 @@ switch_dir_external(const char *local_abspath,
       SVN_ERR(svn_io_make_dir_recursively(parent, pool));
     }
 
+  /* Check out the external the same way as the working copy that
+     defines it. */
+  SVN_ERR(svn_wc__get_store_pristine(&store_pristine, ctx->wc_ctx,
+                                     defining_abspath, pool));
+
   /* ... Hello, new hotness. */
   SVN_ERR(svn_client__checkout_internal(NULL, timestamp_sleep,
                                         url, local_abspath, peg_revision,
                                         revision, svn_depth_infinity,
-                                        FALSE, FALSE,
+                                        FALSE, FALSE, store_pristine,
                                         ra_session,
                                         ctx, pool));
 
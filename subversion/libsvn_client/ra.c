@@ -1090,7 +1090,8 @@ svn_client__ra_provide_base(svn_stream_t **contents,
                                       result_pool, scratch_pool);
   if (err)
     {
-      if (err->apr_err != SVN_ERR_WC_PATH_NOT_FOUND)
+      if (err->apr_err != SVN_ERR_WC_PATH_NOT_FOUND
+          && err->apr_err != SVN_ERR_WC_PRISTINE_DEHYDRATED)
         return svn_error_trace(err);
 
       svn_error_clear(err);
@@ -67,19 +67,29 @@ static svn_error_t *
 revert(void *baton, apr_pool_t *result_pool, apr_pool_t *scratch_pool)
 {
   struct revert_with_write_lock_baton *b = baton;
-  svn_error_t *err;
-
-  err = svn_wc_revert6(b->ctx->wc_ctx,
-                       b->local_abspath,
-                       b->depth,
-                       b->use_commit_times,
-                       b->changelists,
-                       b->clear_changelists,
-                       b->metadata_only,
-                       b->added_keep_local,
-                       b->ctx->cancel_func, b->ctx->cancel_baton,
-                       b->ctx->notify_func2, b->ctx->notify_baton2,
-                       scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+
+  /* Reverting the text of a file needs its pristine text. */
+  if (! b->metadata_only)
+    err = svn_client__textbase_sync(b->local_abspath, TRUE, FALSE,
+                                    b->ctx, scratch_pool);
+
+  if (! err)
+    err = svn_wc_revert6(b->ctx->wc_ctx,
+                         b->local_abspath,
+                         b->depth,
+                         b->use_commit_times,
+                         b->changelists,
+                         b->clear_changelists,
+                         b->metadata_only,
+                         b->added_keep_local,
+                         b->ctx->cancel_func, b->ctx->cancel_baton,
+                         b->ctx->notify_func2, b->ctx->notify_baton2,
+                         scratch_pool);
+
+  if (! err && ! b->metadata_only)
+    err = svn_client__textbase_sync(b->local_abspath, FALSE, TRUE,
+                                    b->ctx, scratch_pool);
 
   if (err)
     {
@@ -1033,6 +1033,7 @@ shelf_copy_base(svn_client__shelf_version_t *new_shelf_version,
                                         svn_depth_infinity,
                                         TRUE /*ignore_externals*/,
                                         FALSE /*allow_unver_obstructions*/,
+                                        TRUE /*store_pristine*/,
                                         ra_session,
                                         ctx, scratch_pool));
   /* ### hopefully we won't eventually need to sleep_here... */
@@ -426,13 +426,18 @@ svn_client__switch_internal(svn_revnum_t *result_rev,
   acquired_lock = (err == SVN_NO_ERROR);
   svn_error_clear(err);
 
-  err1 = switch_internal(result_rev, conflicted_paths,
-                         local_abspath, anchor_abspath,
-                         switch_url, peg_revision, revision,
-                         depth, depth_is_sticky,
-                         ignore_externals,
-                         allow_unver_obstructions, ignore_ancestry,
-                         timestamp_sleep, ctx, pool);
+  /* The switch editor applies deltas against the pristine texts of
+     locally modified files, so make sure we have them. */
+  err1 = svn_client__textbase_sync(local_abspath, TRUE, FALSE, ctx, pool);
+
+  if (! err1)
+    err1 = switch_internal(result_rev, conflicted_paths,
+                           local_abspath, anchor_abspath,
+                           switch_url, peg_revision, revision,
+                           depth, depth_is_sticky,
+                           ignore_externals,
+                           allow_unver_obstructions, ignore_ancestry,
+                           timestamp_sleep, ctx, pool);
 
   /* Give the conflict resolver callback the opportunity to
    * resolve any conflicts that were raised. */
@@ -441,6 +446,9 @@ svn_client__switch_internal(svn_revnum_t *result_rev,
       err1 = svn_client__resolve_conflicts(NULL, conflicted_paths, ctx, pool);
     }
 
+  if (! err1 && acquired_lock)
+    err1 = svn_client__textbase_sync(local_abspath, FALSE, TRUE, ctx, pool);
+
   if (acquired_lock)
     err2 = svn_wc__release_write_lock(ctx->wc_ctx, anchor_abspath, pool);
   else
@@ -0,0 +1,108 @@
+/*
+ * textbase.c:  fetching pristine texts on demand
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* ==================================================================== */
+
+
+
+/*** Includes. ***/
+
+#include "svn_hash.h"
+#include "svn_client.h"
+#include "svn_error.h"
+#include "svn_pools.h"
+#include "svn_ra.h"
+#include "client.h"
+
+#include "svn_private_config.h"
+#include "private/svn_wc_private.h"
+
+
+/*** Code. ***/
+
+/* Baton for fetch_textbase(). */
+typedef struct textbase_fetch_baton_t
+{
+  /* The working copy root that the pristine texts are fetched for. */
+  const char *local_abspath;
+
+  /* Maps repository root URLs to svn_ra_session_t *, opened on demand. */
+  apr_hash_t *sessions;
+
+  svn_client_ctx_t *ctx;
+
+  /* Pool for the sessions. */
+  apr_pool_t *pool;
+} textbase_fetch_baton_t;
+
+/* Implements svn_wc__textbase_fetch_t. */
+static svn_error_t *
+fetch_textbase(void *baton,
+               const char *repos_root_url,
+               const char *repos_relpath,
+               svn_revnum_t revision,
+               svn_stream_t *contents,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *scratch_pool)
+{
+  textbase_fetch_baton_t *b = baton;
+  svn_ra_session_t *ra_session;
+
+  ra_session = svn_hash_gets(b->sessions, repos_root_url);
+  if (!ra_session)
+    {
+      SVN_ERR(svn_client_open_ra_session2(&ra_session, repos_root_url,
+                                          b->local_abspath, b->ctx,
+                                          b->pool, scratch_pool));
+      svn_hash_sets(b->sessions, apr_pstrdup(b->pool, repos_root_url),
+                    ra_session);
+    }
+
+  SVN_ERR(svn_ra_get_file(ra_session, repos_relpath, revision, contents,
+                          NULL, NULL, scratch_pool));
+
+  return svn_error_trace(svn_stream_close(contents));
+}
+
+svn_error_t *
+svn_client__textbase_sync(const char *local_abspath,
+                          svn_boolean_t allow_hydrate,
+                          svn_boolean_t allow_dehydrate,
+                          svn_client_ctx_t *ctx,
+                          apr_pool_t *scratch_pool)
+{
+  textbase_fetch_baton_t baton;
+
+  baton.local_abspath = local_abspath;
+  baton.sessions = apr_hash_make(scratch_pool);
+  baton.ctx = ctx;
+  baton.pool = scratch_pool;
+
+  return svn_error_trace(svn_wc__textbase_sync(ctx->wc_ctx, local_abspath,
+                                               allow_hydrate, allow_dehydrate,
+                                               fetch_textbase, &baton,
+                                               ctx->cancel_func,
+                                               ctx->cancel_baton,
+                                               scratch_pool));
+}
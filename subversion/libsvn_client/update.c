@@ -693,6 +693,12 @@ svn_client__update_internal(svn_revnum_t *result_rev,
       anchor_abspath = lockroot_abspath;
     }
 
+  /* The update editor applies deltas against the pristine texts of
+     locally modified files, so make sure we have them. */
+  err = svn_client__textbase_sync(local_abspath, TRUE, FALSE, ctx, pool);
+  if (err)
+    goto cleanup;
+
   err = update_internal(result_rev, timestamp_sleep, conflicted_paths,
                         &ra_session,
                         local_abspath, anchor_abspath,
@@ -708,6 +714,9 @@ svn_client__update_internal(svn_revnum_t *result_rev,
       err = svn_client__resolve_conflicts(NULL, conflicted_paths, ctx, pool);
     }
 
+  if (! err)
+    err = svn_client__textbase_sync(local_abspath, FALSE, TRUE, ctx, pool);
+
  cleanup:
   err = svn_error_compose_create(
             err,
@@ -429,7 +429,8 @@ fetch_base_func(const char **filename,
   err = svn_wc_get_pristine_contents2(&pristine_stream, scb->wc_ctx,
                                       local_abspath, scratch_pool,
                                       scratch_pool);
-  if (err && err->apr_err == SVN_ERR_WC_PATH_NOT_FOUND)
+  if (err && (err->apr_err == SVN_ERR_WC_PATH_NOT_FOUND
+              || err->apr_err == SVN_ERR_WC_PRISTINE_DEHYDRATED))
     {
       svn_error_clear(err);
       *filename = NULL;
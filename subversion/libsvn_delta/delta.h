@@ -44,6 +44,12 @@ extern "C" {
 
 #define SVN_DELTA_WINDOW_SIZE 102400
 
+/* The maximum size of an svndiff window for svndiff version 3 and later.
+   Larger windows allow for deltification of large binary files whose
+   content got shifted by more than a few kB. */
+
+#define SVN_DELTA_LARGE_WINDOW_SIZE (1024 * 1024)
+
 
 /* Context/baton for building an operation sequence. */
 
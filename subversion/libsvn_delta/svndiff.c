@@ -39,13 +39,16 @@
 static const char SVNDIFF_V0[] = { 'S', 'V', 'N', 0 };
 static const char SVNDIFF_V1[] = { 'S', 'V', 'N', 1 };
 static const char SVNDIFF_V2[] = { 'S', 'V', 'N', 2 };
+static const char SVNDIFF_V3[] = { 'S', 'V', 'N', 3 };
 
 #define SVNDIFF_HEADER_SIZE (sizeof(SVNDIFF_V0))
 
 static const char *
 get_svndiff_header(int version)
 {
-  if (version == 2)
+  if (version == 3)
+    return SVNDIFF_V3;
+  else if (version == 2)
     return SVNDIFF_V2;
   else if (version == 1)
     return SVNDIFF_V1;
@@ -70,9 +73,31 @@ struct encoder_baton {
 /* This is at least as big as the largest size for a single instruction. */
 #define MAX_INSTRUCTION_LEN (2*SVN__MAX_ENCODED_UINT_LEN+1)
 /* This is at least as big as the largest possible instructions
-   section: in theory, the instructions could be SVN_DELTA_WINDOW_SIZE
-   1-byte copy-from-source instructions (though this is very unlikely). */
-#define MAX_INSTRUCTION_SECTION_LEN (SVN_DELTA_WINDOW_SIZE*MAX_INSTRUCTION_LEN)
+   section for svndiff VERSION: in theory, the instructions could be
+   one 1-byte copy-from-source instruction per byte in the window
+   (though this is very unlikely). */
+#define MAX_INSTRUCTION_SECTION_LEN(version) \
+  (svn_txdelta__window_size(version) * MAX_INSTRUCTION_LEN)
+
+/* svndiff3 encodes instruction offsets relative to the current position
+   instead of absolute values:
+
+   - source copies specify the signed distance between their offset and
+     the end of the previous source copy (0 for the first one),
+   - target copies specify how many bytes before the current target
+     position they start.
+
+   Typical deltas copy large chunks of the source in sequence and most
+   offsets become 1 byte integers this way.  This struct keeps track of
+   the positions while encoding or decoding a window. */
+typedef struct instruction_pos_t
+{
+  /* End of the last source copy in the source view. */
+  apr_size_t source_pos;
+
+  /* Current position in the target view. */
+  apr_size_t target_pos;
+} instruction_pos_t;
 
 
 /* Append an encoded integer to a string.  */
@@ -169,6 +194,7 @@ encode_window(svn_stringbuf_t **instructions_p,
   const svn_string_t *newdata;
   unsigned char ibuf[MAX_INSTRUCTION_LEN], *ip;
   const svn_txdelta_op_t *op;
+  instruction_pos_t pos = { 0 };
 
   /* create the necessary data buffers */
   instructions = svn_stringbuf_create_empty(pool);
@@ -189,16 +215,26 @@ encode_window(svn_stringbuf_t **instructions_p,
         *ip++ |= (unsigned char)op->length;
       else
         ip = svn__encode_uint(ip + 1, op->length);
-      if (op->action_code != svn_txdelta_new)
+      if (version >= 3 && op->action_code == svn_txdelta_source)
+        {
+          ip = svn__encode_int(ip, (apr_int64_t)op->offset
+                                   - (apr_int64_t)pos.source_pos);
+          pos.source_pos = op->offset + op->length;
+        }
+      else if (version >= 3 && op->action_code == svn_txdelta_target)
+        ip = svn__encode_uint(ip, pos.target_pos - op->offset);
+      else if (op->action_code != svn_txdelta_new)
         ip = svn__encode_uint(ip, op->offset);
       svn_stringbuf_appendbytes(instructions, (const char *)ibuf, ip - ibuf);
+
+      pos.target_pos += op->length;
     }
 
   /* Encode the header.  */
   append_encoded_int(header, window->sview_offset);
   append_encoded_int(header, window->sview_len);
   append_encoded_int(header, window->tview_len);
-  if (version == 2)
+  if (version >= 2)
     {
       svn_stringbuf_t *compressed_instructions;
       compressed_instructions = svn_stringbuf_create_empty(pool);
@@ -217,7 +253,7 @@ encode_window(svn_stringbuf_t **instructions_p,
   append_encoded_int(header, instructions->len);
 
   /* Encode the data. */
-  if (version == 2)
+  if (version >= 2)
     {
       svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
 
@@ -426,11 +462,15 @@ decode_size(apr_size_t *val,
 
 /* Decode an instruction into OP, returning a pointer to the text
    after the instruction.  Note that if the action code is
-   svn_txdelta_new, the offset field of *OP will not be set.  */
+   svn_txdelta_new, the offset field of *OP will not be set.
+   For svndiff VERSION 3 and later, offsets are relative to *POS, which
+   will be updated.  */
 static const unsigned char *
 decode_instruction(svn_txdelta_op_t *op,
                    const unsigned char *p,
-                   const unsigned char *end)
+                   const unsigned char *end,
+                   int version,
+                   instruction_pos_t *pos)
 {
   apr_size_t c;
   apr_size_t action;
@@ -458,13 +498,40 @@ decode_instruction(svn_txdelta_op_t *op,
       if (p == NULL)
         return NULL;
     }
-  if (action != svn_txdelta_new)
+  if (version >= 3 && action == svn_txdelta_source)
+    {
+      apr_int64_t distance;
+      p = svn__decode_int(&distance, p, end);
+      if (p == NULL)
+        return NULL;
+
+      /* Reject offsets outside the range of apr_size_t. */
+      if (distance < 0
+          ? (apr_uint64_t)0 - (apr_uint64_t)distance > pos->source_pos
+          : (apr_uint64_t)distance > APR_SIZE_MAX - pos->source_pos)
+        return NULL;
+
+      op->offset = (apr_size_t)((apr_int64_t)pos->source_pos + distance);
+      pos->source_pos = op->offset + op->length;
+    }
+  else if (version >= 3 && action == svn_txdelta_target)
+    {
+      apr_size_t distance;
+      p = decode_size(&distance, p, end);
+      if (p == NULL || distance == 0 || distance > pos->target_pos)
+        return NULL;
+
+      op->offset = pos->target_pos - distance;
+    }
+  else if (action != svn_txdelta_new)
     {
       p = decode_size(&op->offset, p, end);
       if (p == NULL)
         return NULL;
     }
 
+  pos->target_pos += op->length;
+
   return p;
 }
 
@@ -478,15 +545,17 @@ count_and_verify_instructions(int *ninst,
                               const unsigned char *end,
                               apr_size_t sview_len,
                               apr_size_t tview_len,
-                              apr_size_t new_len)
+                              apr_size_t new_len,
+                              int version)
 {
   int n = 0;
   svn_txdelta_op_t op;
   apr_size_t tpos = 0, npos = 0;
+  instruction_pos_t pos = { 0 };
 
   while (p < end)
     {
-      p = decode_instruction(&op, p, end);
+      p = decode_instruction(&op, p, end, version, &pos);
 
       /* Detect any malformed operations from the instruction stream. */
       if (p == NULL)
@@ -558,6 +627,7 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
   apr_size_t npos;
   svn_txdelta_op_t *ops, *op;
   svn_string_t *new_data;
+  instruction_pos_t pos = { 0 };
 
   window->sview_offset = sview_offset;
   window->sview_len = sview_len;
@@ -565,15 +635,15 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
 
   insend = data + inslen;
 
-  if (version == 2)
+  if (version >= 2)
     {
       svn_stringbuf_t *instout = svn_stringbuf_create_empty(pool);
       svn_stringbuf_t *ndout = svn_stringbuf_create_empty(pool);
 
       SVN_ERR(svn__decompress_lz4(insend, newlen, ndout,
-                                  SVN_DELTA_WINDOW_SIZE));
+                                  svn_txdelta__window_size(version)));
       SVN_ERR(svn__decompress_lz4(data, insend - data, instout,
-                                  MAX_INSTRUCTION_SECTION_LEN));
+                                  MAX_INSTRUCTION_SECTION_LEN(version)));
 
       newlen = ndout->len;
       data = (unsigned char *)instout->data;
@@ -589,7 +659,7 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
       SVN_ERR(svn__decompress_zlib(insend, newlen, ndout,
                                    SVN_DELTA_WINDOW_SIZE));
       SVN_ERR(svn__decompress_zlib(data, insend - data, instout,
-                                   MAX_INSTRUCTION_SECTION_LEN));
+                                   MAX_INSTRUCTION_SECTION_LEN(version)));
 
       newlen = ndout->len;
       data = (unsigned char *)instout->data;
@@ -606,7 +676,8 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
 
   /* Count the instructions and make sure they are all valid.  */
   SVN_ERR(count_and_verify_instructions(&ninst, data, insend,
-                                        sview_len, tview_len, newlen));
+                                        sview_len, tview_len, newlen,
+                                        version));
 
   /* Allocate a buffer for the instructions and decode them. */
   ops = apr_palloc(pool, ninst * sizeof(*ops));
@@ -614,7 +685,7 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
   window->src_ops = 0;
   for (op = ops; op < ops + ninst; op++)
     {
-      data = decode_instruction(op, data, insend);
+      data = decode_instruction(op, data, insend, version, &pos);
       if (op->action_code == svn_txdelta_source)
         ++window->src_ops;
       else if (op->action_code == svn_txdelta_new)
@@ -653,6 +724,8 @@ write_handler(void *baton,
         db->version = 1;
       else if (memcmp(buffer, SVNDIFF_V2 + db->header_bytes, nheader) == 0)
         db->version = 2;
+      else if (memcmp(buffer, SVNDIFF_V3 + db->header_bytes, nheader) == 0)
+        db->version = 3;
       else
         return svn_error_create(SVN_ERR_SVNDIFF_INVALID_HEADER, NULL,
                                 _("Svndiff has invalid header"));
@@ -710,11 +783,12 @@ write_handler(void *baton,
           if (p == NULL)
               break;
 
-          if (tview_len > SVN_DELTA_WINDOW_SIZE ||
-              sview_len > SVN_DELTA_WINDOW_SIZE ||
+          if (tview_len > svn_txdelta__window_size(db->version) ||
+              sview_len > svn_txdelta__window_size(db->version) ||
               /* for svndiff1, newlen includes the original length */
-              newlen > SVN_DELTA_WINDOW_SIZE + SVN__MAX_ENCODED_UINT_LEN ||
-              inslen > MAX_INSTRUCTION_SECTION_LEN)
+              newlen > svn_txdelta__window_size(db->version)
+                       + SVN__MAX_ENCODED_UINT_LEN ||
+              inslen > MAX_INSTRUCTION_SECTION_LEN(db->version))
             return svn_error_create(
                      SVN_ERR_SVNDIFF_CORRUPT_WINDOW, NULL,
                      _("Svndiff contains a too-large window"));
@@ -894,13 +968,15 @@ read_one_size(apr_size_t *size,
   return SVN_NO_ERROR;
 }
 
-/* Read a window header from STREAM and check it for integer overflow. */
+/* Read a window header from STREAM and check it for integer overflow.
+   The window is expected to be in svndiff format VERSION. */
 static svn_error_t *
 read_window_header(svn_stream_t *stream, svn_filesize_t *sview_offset,
                    apr_size_t *sview_len, apr_size_t *tview_len,
                    apr_size_t *inslen, apr_size_t *newlen,
-                   apr_size_t *header_len)
+                   apr_size_t *header_len, int version)
 {
+  apr_size_t max_window_size = svn_txdelta__window_size(version);
   unsigned char c;
 
   /* Read the source view offset by hand, since it's not an apr_size_t. */
@@ -921,11 +997,11 @@ read_window_header(svn_stream_t *stream, svn_filesize_t *sview_offset,
   SVN_ERR(read_one_size(inslen, header_len, stream));
   SVN_ERR(read_one_size(newlen, header_len, stream));
 
-  if (*tview_len > SVN_DELTA_WINDOW_SIZE ||
-      *sview_len > SVN_DELTA_WINDOW_SIZE ||
+  if (*tview_len > max_window_size ||
+      *sview_len > max_window_size ||
       /* for svndiff1, newlen includes the original length */
-      *newlen > SVN_DELTA_WINDOW_SIZE + SVN__MAX_ENCODED_UINT_LEN ||
-      *inslen > MAX_INSTRUCTION_SECTION_LEN)
+      *newlen > max_window_size + SVN__MAX_ENCODED_UINT_LEN ||
+      *inslen > MAX_INSTRUCTION_SECTION_LEN(version))
     return svn_error_create(SVN_ERR_SVNDIFF_CORRUPT_WINDOW, NULL,
                             _("Svndiff contains a too-large window"));
 
@@ -950,7 +1026,8 @@ svn_txdelta_read_svndiff_window(svn_txdelta_window_t **window,
   unsigned char *buf;
 
   SVN_ERR(read_window_header(stream, &sview_offset, &sview_len, &tview_len,
-                             &inslen, &newlen, &header_len));
+                             &inslen, &newlen, &header_len,
+                             svndiff_version));
   len = inslen + newlen;
   buf = apr_palloc(pool, len);
   SVN_ERR(svn_stream_read_full(stream, (char*)buf, &len));
@@ -974,7 +1051,8 @@ svn_txdelta_skip_svndiff_window(apr_file_t *file,
   apr_off_t offset;
 
   SVN_ERR(read_window_header(stream, &sview_offset, &sview_len, &tview_len,
-                             &inslen, &newlen, &header_len));
+                             &inslen, &newlen, &header_len,
+                             svndiff_version));
 
   offset = inslen + newlen;
   return svn_io_file_seek(file, APR_CUR, &offset, pool);
@@ -983,13 +1061,15 @@ svn_txdelta_skip_svndiff_window(apr_file_t *file,
 svn_error_t *
 svn_txdelta__read_raw_window_len(apr_size_t *window_len,
                                  svn_stream_t *stream,
+                                 int svndiff_version,
                                  apr_pool_t *pool)
 {
   svn_filesize_t sview_offset;
   apr_size_t sview_len, tview_len, inslen, newlen, header_len;
 
   SVN_ERR(read_window_header(stream, &sview_offset, &sview_len, &tview_len,
-                             &inslen, &newlen, &header_len));
+                             &inslen, &newlen, &header_len,
+                             svndiff_version));
 
   *window_len = inslen + newlen + header_len;
   return SVN_NO_ERROR;
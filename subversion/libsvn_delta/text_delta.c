@@ -33,6 +33,8 @@
 #include "svn_pools.h"
 #include "svn_checksum.h"
 
+#include "private/svn_delta_private.h"
+
 #include "delta.h"
 
 
@@ -56,6 +58,7 @@ struct txdelta_baton {
   svn_boolean_t more;           /* TRUE if there are more data in the pool. */
   svn_filesize_t pos;           /* Offset of next read in source file. */
   char *buf;                    /* Buffer for input data. */
+  apr_size_t window_size;       /* Max. source and target size per window. */
 
   svn_checksum_ctx_t *context;  /* If not NULL, the context for computing
                                    the checksum. */
@@ -76,6 +79,7 @@ struct tpush_baton {
 
   /* Private data */
   char *buf;
+  apr_size_t window_size;
   svn_filesize_t source_offset;
   apr_size_t source_len;
   svn_boolean_t source_done;
@@ -359,14 +363,14 @@ txdelta_next_window(svn_txdelta_window_t **window,
                     apr_pool_t *pool)
 {
   struct txdelta_baton *b = baton;
-  apr_size_t source_len = SVN_DELTA_WINDOW_SIZE;
-  apr_size_t target_len = SVN_DELTA_WINDOW_SIZE;
+  apr_size_t source_len = b->window_size;
+  apr_size_t target_len = b->window_size;
 
   /* Read the source stream. */
   if (b->more_source)
     {
       SVN_ERR(svn_stream_read_full(b->source, b->buf, &source_len));
-      b->more_source = (source_len == SVN_DELTA_WINDOW_SIZE);
+      b->more_source = (source_len == b->window_size);
     }
   else
     source_len = 0;
@@ -435,7 +439,8 @@ svn_txdelta_run(svn_stream_t *source,
   tb.more_source = TRUE;
   tb.more = TRUE;
   tb.pos = 0;
-  tb.buf = apr_palloc(scratch_pool, 2 * SVN_DELTA_WINDOW_SIZE);
+  tb.window_size = SVN_DELTA_WINDOW_SIZE;
+  tb.buf = apr_palloc(scratch_pool, 2 * tb.window_size);
   tb.result_pool = result_pool;
 
   if (checksum != NULL)
@@ -466,12 +471,20 @@ svn_txdelta_run(svn_stream_t *source,
 }
 
 
+apr_size_t
+svn_txdelta__window_size(int svndiff_version)
+{
+  return svndiff_version >= 3 ? SVN_DELTA_LARGE_WINDOW_SIZE
+                              : SVN_DELTA_WINDOW_SIZE;
+}
+
 void
-svn_txdelta2(svn_txdelta_stream_t **stream,
-             svn_stream_t *source,
-             svn_stream_t *target,
-             svn_boolean_t calculate_checksum,
-             apr_pool_t *pool)
+svn_txdelta__create(svn_txdelta_stream_t **stream,
+                    svn_stream_t *source,
+                    svn_stream_t *target,
+                    svn_boolean_t calculate_checksum,
+                    apr_size_t window_size,
+                    apr_pool_t *pool)
 {
   struct txdelta_baton *b = apr_pcalloc(pool, sizeof(*b));
 
@@ -479,7 +492,8 @@ svn_txdelta2(svn_txdelta_stream_t **stream,
   b->target = target;
   b->more_source = TRUE;
   b->more = TRUE;
-  b->buf = apr_palloc(pool, 2 * SVN_DELTA_WINDOW_SIZE);
+  b->window_size = window_size;
+  b->buf = apr_palloc(pool, 2 * window_size);
   b->context = calculate_checksum
              ? svn_checksum_ctx_create(svn_checksum_md5, pool)
              : NULL;
@@ -489,6 +503,17 @@ svn_txdelta2(svn_txdelta_stream_t **stream,
                                       txdelta_md5_digest, pool);
 }
 
+void
+svn_txdelta2(svn_txdelta_stream_t **stream,
+             svn_stream_t *source,
+             svn_stream_t *target,
+             svn_boolean_t calculate_checksum,
+             apr_pool_t *pool)
+{
+  svn_txdelta__create(stream, source, target, calculate_checksum,
+                      SVN_DELTA_WINDOW_SIZE, pool);
+}
+
 void
 svn_txdelta(svn_txdelta_stream_t **stream,
             svn_stream_t *source,
@@ -520,14 +545,14 @@ tpush_write_handler(void *baton, const char *data, apr_size_t *len)
       /* Make sure we're all full up on source data, if possible. */
       if (tb->source_len == 0 && !tb->source_done)
         {
-          tb->source_len = SVN_DELTA_WINDOW_SIZE;
+          tb->source_len = tb->window_size;
           SVN_ERR(svn_stream_read_full(tb->source, tb->buf, &tb->source_len));
-          if (tb->source_len < SVN_DELTA_WINDOW_SIZE)
+          if (tb->source_len < tb->window_size)
             tb->source_done = TRUE;
         }
 
-      /* Copy in the target data, up to SVN_DELTA_WINDOW_SIZE. */
-      chunk_len = SVN_DELTA_WINDOW_SIZE - tb->target_len;
+      /* Copy in the target data, up to WINDOW_SIZE. */
+      chunk_len = tb->window_size - tb->target_len;
       if (chunk_len > data_len)
         chunk_len = data_len;
       memcpy(tb->buf + tb->source_len + tb->target_len, data, chunk_len);
@@ -536,7 +561,7 @@ tpush_write_handler(void *baton, const char *data, apr_size_t *len)
       tb->target_len += chunk_len;
 
       /* If we're full of target data, compute and fire off a window. */
-      if (tb->target_len == SVN_DELTA_WINDOW_SIZE)
+      if (tb->target_len == tb->window_size)
         {
           window = compute_window(tb->buf, tb->source_len, tb->target_len,
                                   tb->source_offset, pool);
@@ -575,9 +600,11 @@ tpush_close_handler(void *baton)
 
 
 svn_stream_t *
-svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
-                        void *handler_baton, svn_stream_t *source,
-                        apr_pool_t *pool)
+svn_txdelta__target_push(svn_txdelta_window_handler_t handler,
+                         void *handler_baton,
+                         svn_stream_t *source,
+                         apr_size_t window_size,
+                         apr_pool_t *pool)
 {
   struct tpush_baton *tb;
   svn_stream_t *stream;
@@ -588,7 +615,8 @@ svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
   tb->wh = handler;
   tb->whb = handler_baton;
   tb->pool = pool;
-  tb->buf = apr_palloc(pool, 2 * SVN_DELTA_WINDOW_SIZE);
+  tb->window_size = window_size;
+  tb->buf = apr_palloc(pool, 2 * window_size);
   tb->source_offset = 0;
   tb->source_len = 0;
   tb->source_done = FALSE;
@@ -601,6 +629,15 @@ svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
   return stream;
 }
 
+svn_stream_t *
+svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
+                        void *handler_baton, svn_stream_t *source,
+                        apr_pool_t *pool)
+{
+  return svn_txdelta__target_push(handler, handler_baton, source,
+                                  SVN_DELTA_WINDOW_SIZE, pool);
+}
+
 
 
 /* Functions for applying deltas.  */
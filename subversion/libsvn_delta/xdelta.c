@@ -30,6 +30,7 @@
 #include "svn_hash.h"
 #include "svn_delta.h"
 #include "private/svn_string_private.h"
+#include "private/svn_sse2.h"
 #include "delta.h"
 
 /* This is pseudo-adler32. It is adler32 without the prime modulus.
@@ -45,13 +46,19 @@
 #define MATCH_BLOCKSIZE 64
 
 /* Size of the checksum presence FLAGS array in BLOCKS_T.  With standard
-   MATCH_BLOCKSIZE and SVN_DELTA_WINDOW_SIZE, 32k entries is about 20x
-   the number of checksums that actually occur, i.e. we expect a >95%
+   MATCH_BLOCKSIZE and SVN_DELTA_WINDOW_SIZE, 64k entries is about 40x
+   the number of checksums that actually occur, i.e. we expect a >97%
    probability that non-matching checksums get already detected by checking
-   against the FLAGS array.
+   against the FLAGS array.  At 8kB, the array still fits into L1 easily.
    Must be a power of 2.
  */
-#define FLAGS_COUNT (32 * 1024)
+#define FLAGS_COUNT (64 * 1024)
+
+/* Minimum ratio of hash table SLOTS to blocks in the source.  Must be a
+   power of 2.  A load of at most 25% keeps the probing sequences in
+   ADD_BLOCK and FIND_BLOCK very short.
+ */
+#define SLOTS_PER_BLOCK 4
 
 /* "no" / "invalid" / "unused" value for positions within the delta windows
  */
@@ -79,6 +86,49 @@ adler32_replace(apr_uint32_t adler32, const char c_out, const char c_in)
 /* Calculate an pseudo-adler32 checksum for MATCH_BLOCKSIZE bytes starting
    at DATA.  Return the checksum value.  */
 
+#ifdef SVN_HAVE_SSE2
+
+/* SSE2 variant.  The sum of sums equals the sum of every byte weighted
+   with its distance from the end of the block, which we can calculate
+   16 bytes at a time.  The result is the same as for the scalar code. */
+static APR_INLINE apr_uint32_t
+init_adler32(const char *data)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i offsets_lo = _mm_set_epi16(7, 6, 5, 4, 3, 2, 1, 0);
+  const __m128i offsets_hi = _mm_set_epi16(15, 14, 13, 12, 11, 10, 9, 8);
+  __m128i s1 = zero;
+  __m128i s2 = zero;
+  int i;
+
+  for (i = 0; i < MATCH_BLOCKSIZE; i += 16)
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)(data + i));
+      __m128i base = _mm_set1_epi16((short)(MATCH_BLOCKSIZE - i));
+
+      /* Sum of bytes, in two 64 bit lanes. */
+      s1 = _mm_add_epi64(s1, _mm_sad_epu8(chunk, zero));
+
+      /* Weighted sum of bytes, in four 32 bit lanes. */
+      s2 = _mm_add_epi32(s2,
+                         _mm_madd_epi16(_mm_unpacklo_epi8(chunk, zero),
+                                        _mm_sub_epi16(base, offsets_lo)));
+      s2 = _mm_add_epi32(s2,
+                         _mm_madd_epi16(_mm_unpackhi_epi8(chunk, zero),
+                                        _mm_sub_epi16(base, offsets_hi)));
+    }
+
+  /* Fold the lanes. */
+  s1 = _mm_add_epi64(s1, _mm_srli_si128(s1, 8));
+  s2 = _mm_add_epi32(s2, _mm_shuffle_epi32(s2, _MM_SHUFFLE(1, 0, 3, 2)));
+  s2 = _mm_add_epi32(s2, _mm_shuffle_epi32(s2, _MM_SHUFFLE(2, 3, 0, 1)));
+
+  return (apr_uint32_t)_mm_cvtsi128_si32(s2) * 0x10000
+       + (apr_uint32_t)_mm_cvtsi128_si32(s1);
+}
+
+#else
+
 static APR_INLINE apr_uint32_t
 init_adler32(const char *data)
 {
@@ -103,6 +153,8 @@ init_adler32(const char *data)
   return s2 * 0x10000 + s1;
 }
 
+#endif
+
 /* Information for a block of the delta source.  The length of the
    block is the smaller of MATCH_BLOCKSIZE and the difference between
    the size of the source data and the position of this block. */
@@ -223,8 +275,8 @@ init_blocks_table(const char *data,
   /* Find nearest larger power of two. */
   while (wnslots <= nblocks)
     wnslots *= 2;
-  /* Double the number of slots to avoid a too high load. */
-  wnslots *= 2;
+  /* Add more slots to avoid a too high load. */
+  wnslots *= SLOTS_PER_BLOCK;
   /* Narrow the number of slots to 32 bits, which is the size of the
      block position index in the hash table.
      Sanity check: On 64-bit platforms, apr_size_t is likely to be
@@ -278,7 +330,7 @@ find_match(const struct blocks *blocks,
            apr_size_t pending_insert_start)
 {
   apr_size_t apos, bpos = *bposp;
-  apr_size_t delta, max_delta;
+  apr_size_t delta, max_delta, back;
 
   apos = find_block(blocks, rolling, b + bpos);
 
@@ -296,12 +348,13 @@ find_match(const struct blocks *blocks,
 
   /* See if we can extend backwards (max MATCH_BLOCKSIZE-1 steps because A's
      content has been sampled only every MATCH_BLOCKSIZE positions).  */
-  while (apos > 0 && bpos > pending_insert_start && a[apos-1] == b[bpos-1])
-    {
-      --apos;
-      --bpos;
-      ++delta;
-    }
+  max_delta = apos < bpos - pending_insert_start
+            ? apos
+            : bpos - pending_insert_start;
+  back = svn_cstring__reverse_match_length(a + apos, b + bpos, max_delta);
+  apos -= back;
+  bpos -= back;
+  delta += back;
 
   *aposp = apos;
   *bposp = bpos;
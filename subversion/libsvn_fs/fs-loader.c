@@ -1564,6 +1564,29 @@ svn_fs_try_process_file_contents(svn_boolean_t *success,
                          processor, baton, pool));
 }
 
+svn_error_t *
+svn_fs__file_contents_ranges(apr_file_t **file,
+                             apr_array_header_t **ranges,
+                             svn_fs_root_t *root,
+                             const char *path,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  /* if the FS doesn't implement this function, the contents are never
+     available as plain file ranges */
+  if (root->vtable->file_contents_ranges == NULL)
+    {
+      *file = NULL;
+      *ranges = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(root->vtable->file_contents_ranges(file, ranges,
+                                                            root, path,
+                                                            result_pool,
+                                                            scratch_pool));
+}
+
 svn_error_t *
 svn_fs_make_file(svn_fs_root_t *root, const char *path, apr_pool_t *pool)
 {
@@ -28,6 +28,7 @@
 #include "svn_ctype.h"
 #include "svn_sorts.h"
 #include "private/svn_delta_private.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_io_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
@@ -844,19 +845,18 @@ create_rep_state_body(rep_state_t **rep_state,
 
   /* If the hint is
    * - given,
-   * - refers to a valid revision,
-   * - refers to a packed revision,
-   * - as does the rep we want to read, and
-   * - refers to the same pack file as the rep
-   * we can re-use the same, already open file object
+   * - refers to a valid revision and
+   * - refers to an open rev / pack file that also contains the rep,
+   * we can re-use the same, already open file object.  Its contents is
+   * still valid even if the revisions got packed or staged since.
    */
   svn_boolean_t reuse_shared_file
     =    shared_file && *shared_file && (*shared_file)->rfile
       && SVN_IS_VALID_REVNUM((*shared_file)->revision)
-      && (*shared_file)->revision < ffd->min_unpacked_rev
-      && rep->revision < ffd->min_unpacked_rev
-      && (   ((*shared_file)->revision / ffd->max_files_per_dir)
-          == (rep->revision / ffd->max_files_per_dir));
+      && (*shared_file)->rfile->start_revision <= rep->revision
+      && rep->revision < (*shared_file)->rfile->start_revision
+                       + svn_fs_fs__rev_file_rev_count(fs,
+                                                 (*shared_file)->rfile);
 
   pair_cache_key_t key;
   key.revision = rep->revision;
@@ -1165,6 +1165,44 @@ svn_fs_fs__rep_chain_length(int *chain_length,
   return SVN_NO_ERROR;
 }
 
+/* Return the svndiff version used by the delta rep described by RS in
+   *VERSION.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+get_delta_rep_version(int *version,
+                      rep_state_t *rs,
+                      apr_pool_t *scratch_pool)
+{
+  SVN_ERR(auto_open_shared_file(rs->sfile));
+  SVN_ERR(auto_set_start_offset(rs, scratch_pool));
+  SVN_ERR(auto_read_diff_version(rs, scratch_pool));
+  *version = rs->ver;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__rep_svndiff_version(int *version,
+                               representation_t *rep,
+                               svn_fs_t *fs,
+                               apr_pool_t *scratch_pool)
+{
+  rep_state_t *rs;
+  svn_fs_fs__rep_header_t *rep_header;
+
+  SVN_ERR(create_rep_state(&rs, &rep_header, NULL, rep, fs, scratch_pool,
+                           scratch_pool));
+  if (rep_header->type == svn_fs_fs__rep_plain)
+    *version = -1;
+  else
+    SVN_ERR(get_delta_rep_version(version, rs, scratch_pool));
+
+  /* Don't keep file handles open for longer than necessary. */
+  if (rs->sfile->rfile)
+    SVN_ERR(svn_fs_fs__close_revision_file(rs->sfile->rfile));
+
+  return SVN_NO_ERROR;
+}
+
 struct rep_read_baton
 {
   /* The FS from which we're reading. */
@@ -2419,6 +2457,206 @@ svn_fs_fs__try_process_file_contents(svn_boolean_t *success,
 }
 
 
+/* Upper limit for the number of bytes in an svndiff window header plus
+   an instructions section that consists of a single "new data"
+   instruction: five numbers in the window header, the expanded size of
+   the instructions section and the instruction with its length. */
+#define MAX_VERBATIM_WINDOW_PREFIX (7 * SVN__MAX_ENCODED_UINT_LEN + 1)
+
+/* Parse the svndiff window of format VERSION starting at *OFFSET in FILE,
+   which must not extend beyond END.  If that window inserts its whole
+   target view from a single, uncompressed new-data section, append the
+   location of that section to RANGES, advance *OFFSET to the start of the
+   next window and set *VERBATIM to TRUE.  Otherwise, set *VERBATIM to
+   FALSE.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_verbatim_window(svn_boolean_t *verbatim,
+                     apr_off_t *offset,
+                     apr_array_header_t *ranges,
+                     apr_file_t *file,
+                     apr_off_t end,
+                     int version,
+                     apr_pool_t *scratch_pool)
+{
+  unsigned char buffer[MAX_VERBATIM_WINDOW_PREFIX];
+  const unsigned char *p = buffer;
+  const unsigned char *buffer_end;
+  const unsigned char *instructions_end;
+  apr_size_t len = sizeof(buffer);
+  apr_uint64_t sview_offset, sview_len, tview_len, ins_len, new_len;
+  apr_uint64_t value;
+  apr_off_t start = *offset;
+  svn_fs__file_range_t *range;
+
+  *verbatim = FALSE;
+
+  if (end - start < (apr_off_t)len)
+    len = (apr_size_t)(end - start);
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &start, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(file, buffer, len, &len, NULL,
+                                 scratch_pool));
+  buffer_end = buffer + len;
+
+  /* The window header.  There must not be any source view. */
+  p = svn__decode_uint(&sview_offset, p, buffer_end);
+  if (p)
+    p = svn__decode_uint(&sview_len, p, buffer_end);
+  if (p)
+    p = svn__decode_uint(&tview_len, p, buffer_end);
+  if (p)
+    p = svn__decode_uint(&ins_len, p, buffer_end);
+  if (p)
+    p = svn__decode_uint(&new_len, p, buffer_end);
+  if (!p || sview_len != 0 || ins_len > (apr_uint64_t)(buffer_end - p))
+    return SVN_NO_ERROR;
+
+  instructions_end = p + ins_len;
+
+  /* Compressed svndiff formats prefix each section with its expanded
+     size.  A section is stored uncompressed iff that size matches the
+     remaining section size. */
+  if (version > 0)
+    {
+      p = svn__decode_uint(&value, p, instructions_end);
+      if (!p || value != (apr_uint64_t)(instructions_end - p))
+        return SVN_NO_ERROR;
+    }
+
+  /* A single "new data" instruction covering the whole target view. */
+  if (p == instructions_end || ((*p >> 6) & 0x3) != svn_txdelta_new)
+    return SVN_NO_ERROR;
+
+  value = *p++ & 0x3f;
+  if (value == 0)
+    p = svn__decode_uint(&value, p, instructions_end);
+  if (p != instructions_end || value != tview_len)
+    return SVN_NO_ERROR;
+
+  /* The new data section. */
+  start += p - buffer;
+  if (version > 0)
+    {
+      const unsigned char *prefix_end;
+      unsigned char prefix[SVN__MAX_ENCODED_UINT_LEN];
+
+      len = (apr_size_t)MIN(new_len, sizeof(prefix));
+      SVN_ERR(svn_io_file_seek(file, APR_SET, &start, scratch_pool));
+      SVN_ERR(svn_io_file_read_full2(file, prefix, len, &len, NULL,
+                                     scratch_pool));
+
+      prefix_end = svn__decode_uint(&value, prefix, prefix + len);
+      if (!prefix_end)
+        return SVN_NO_ERROR;
+
+      start += prefix_end - prefix;
+      new_len -= prefix_end - prefix;
+      if (value != new_len)
+        return SVN_NO_ERROR;
+    }
+
+  if (new_len != tview_len || start + (apr_off_t)new_len > end)
+    return SVN_NO_ERROR;
+
+  if (new_len)
+    {
+      range = apr_array_push(ranges);
+      range->offset = start;
+      range->length = (apr_off_t)new_len;
+    }
+
+  *offset = start + (apr_off_t)new_len;
+  *verbatim = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_contents_ranges(apr_file_t **file,
+                               apr_array_header_t **ranges,
+                               svn_fs_t *fs,
+                               representation_t *rep,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__revision_file_t *rev_file;
+  svn_fs_fs__rep_header_t *rh;
+  apr_off_t offset = -1;
+  apr_off_t end;
+  apr_array_header_t *result;
+
+  *file = NULL;
+  *ranges = NULL;
+
+  /* Representations in transactions may still change. */
+  if (!rep || svn_fs_fs__id_txn_used(&rep->txn_id))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(rep->revision, fs,
+                                            scratch_pool));
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rep->revision,
+                                           result_pool, scratch_pool));
+  SVN_ERR(svn_fs_fs__item_offset(&offset, fs, rev_file, rep->revision, NULL,
+                                 rep->item_index, scratch_pool));
+  SVN_ERR(aligned_seek(fs, rev_file->file, NULL, offset, scratch_pool));
+  SVN_ERR(svn_fs_fs__read_rep_header(&rh, rev_file->stream, scratch_pool,
+                                     scratch_pool));
+
+  offset += rh->header_size;
+  end = offset + (apr_off_t)rep->size;
+  result = apr_array_make(result_pool, 1, sizeof(svn_fs__file_range_t));
+
+  if (rh->type == svn_fs_fs__rep_plain)
+    {
+      svn_fs__file_range_t *range = apr_array_push(result);
+      range->offset = offset;
+      range->length = (apr_off_t)rep->size;
+    }
+  else if (rh->type == svn_fs_fs__rep_self_delta)
+    {
+      apr_pool_t *iterpool;
+      unsigned char signature[4] = { 0 };
+      apr_size_t len = sizeof(signature);
+      int version;
+
+      SVN_ERR(svn_io_file_seek(rev_file->file, APR_SET, &offset,
+                               scratch_pool));
+      SVN_ERR(svn_io_file_read_full2(rev_file->file, signature, len, &len,
+                                     NULL, scratch_pool));
+      version = signature[3];
+      if (len != sizeof(signature) || memcmp(signature, "SVN", 3) != 0
+          || version > 2)
+        return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+
+      offset += len;
+      iterpool = svn_pool_create(scratch_pool);
+      while (offset < end)
+        {
+          svn_boolean_t verbatim;
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(read_verbatim_window(&verbatim, &offset, result,
+                                       rev_file->file, end, version,
+                                       iterpool));
+          if (!verbatim)
+            {
+              svn_pool_destroy(iterpool);
+              return svn_error_trace(
+                       svn_fs_fs__close_revision_file(rev_file));
+            }
+        }
+      svn_pool_destroy(iterpool);
+    }
+  else
+    {
+      return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+    }
+
+  *file = rev_file->file;
+  *ranges = result;
+
+  return SVN_NO_ERROR;
+}
+
 /* Baton used when reading delta windows. */
 struct delta_read_baton
 {
@@ -2483,6 +2721,7 @@ svn_fs_fs__get_file_delta_stream(svn_txdelta_stream_t **stream_p,
   rep_state_t *rep_state;
   svn_fs_fs__rep_header_t *rep_header;
   fs_fs_data_t *ffd = fs->fsap_data;
+  int version = 0;
 
   /* Try a shortcut: if the target is stored as a delta against the source,
      then just use that delta.  However, prefer using the fulltext cache
@@ -2493,7 +2732,13 @@ svn_fs_fs__get_file_delta_stream(svn_txdelta_stream_t **stream_p,
       SVN_ERR(create_rep_state(&rep_state, &rep_header, NULL,
                                 target->data_rep, fs, pool, pool));
 
-      if (source && source->data_rep && target->data_rep)
+      /* Svndiff3 windows may exceed the window size that our callers
+         can pass on in older svndiff formats.  Re-calculate those. */
+      if (   rep_header->type != svn_fs_fs__rep_plain
+          && ffd->format >= SVN_FS_FS__MIN_SVNDIFF3_FORMAT)
+        SVN_ERR(get_delta_rep_version(&version, rep_state, pool));
+
+      if (version < 3 && source && source->data_rep && target->data_rep)
         {
           /* If that matches source, then use this delta as is.
              Note that we want an actual delta here.  E.g. a self-delta would
@@ -2506,7 +2751,7 @@ svn_fs_fs__get_file_delta_stream(svn_txdelta_stream_t **stream_p,
               return SVN_NO_ERROR;
             }
         }
-      else if (!source)
+      else if (version < 3 && !source)
         {
           /* We want a self-delta. There is a fair chance that TARGET got
              added in this revision and is already stored in the requested
@@ -3333,7 +3578,7 @@ cache_windows(svn_fs_t *fs,
           SVN_ERR(rs_aligned_seek(rs, NULL, start_offset, iterpool));
           SVN_ERR(svn_txdelta__read_raw_window_len(&window_len,
                                                    rs->sfile->rfile->stream,
-                                                   iterpool));
+                                                   rs->ver, iterpool));
 
           /* Read the raw window. */
           buf = apr_palloc(iterpool, window_len + 1);
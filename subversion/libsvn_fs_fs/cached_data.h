@@ -81,6 +81,16 @@ svn_fs_fs__rep_chain_length(int *chain_length,
                             svn_fs_t *fs,
                             apr_pool_t *scratch_pool);
 
+/* Set *VERSION to the svndiff version used by representation REP in FS
+   or to -1 if REP is stored as plain text.  Deltas against REP must use
+   the same delta window size as REP itself unless it is plain text.
+   Do any allocations in SCRATCH_POOL. */
+svn_error_t *
+svn_fs_fs__rep_svndiff_version(int *version,
+                               representation_t *rep,
+                               svn_fs_t *fs,
+                               apr_pool_t *scratch_pool);
+
 /* Set *CONTENTS_P to be a readable svn_stream_t that receives the text
    representation REP as seen in filesystem FS.  If CACHE_FULLTEXT is
    not set, bypass fulltext cache lookup for this rep and don't put the
@@ -119,6 +129,23 @@ svn_fs_fs__try_process_file_contents(svn_boolean_t *success,
                                      void* baton,
                                      apr_pool_t *pool);
 
+/* If the contents of representation REP in filesystem FS are stored
+   verbatim, i.e. as a PLAIN rep or as a self-delta whose windows each
+   contain a single, uncompressed new-data section, set *FILE to the
+   rev or pack file containing them and *RANGES to the svn_fs__file_range_t
+   within *FILE that form the contents.  Otherwise, set *FILE to NULL.
+
+   Allocate *FILE and *RANGES in RESULT_POOL and use SCRATCH_POOL for
+   temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__get_contents_ranges(apr_file_t **file,
+                               apr_array_header_t **ranges,
+                               svn_fs_t *fs,
+                               representation_t *rep,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
 /* Set *STREAM_P to a delta stream turning the contents of the file SOURCE into
    the contents of the file TARGET, allocated in POOL.
    If SOURCE is null, the empty string will be used. */
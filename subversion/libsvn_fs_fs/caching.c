@@ -27,9 +27,11 @@
 #include "tree.h"
 #include "index.h"
 #include "temp_serializer.h"
+#include "util.h"
 #include "../libsvn_fs/fs-loader.h"
 
 #include "svn_config.h"
+#include "svn_dirent_uri.h"
 #include "svn_cache_config.h"
 
 #include "svn_private_config.h"
@@ -346,16 +348,28 @@ create_cache(svn_cache__t **cache_p,
   return SVN_NO_ERROR;
 }
 
+/* Return the key prefix shared by all FS-global caches of FS that use
+ * the CACHE_NAMESPACE.  Allocate the result in POOL.
+ */
+static const char *
+get_cache_prefix(svn_fs_t *fs,
+                 const char *cache_namespace,
+                 apr_pool_t *pool)
+{
+  return apr_pstrcat(pool,
+                     "ns:", cache_namespace, ":",
+                     "fsfs:", fs->uuid,
+                     "/", normalize_key_part(fs->path, pool),
+                     ":",
+                     SVN_VA_NULL);
+}
+
 svn_error_t *
 svn_fs_fs__initialize_caches(svn_fs_t *fs,
                              apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  const char *prefix = apr_pstrcat(pool,
-                                   "fsfs:", fs->uuid,
-                                   "/", normalize_key_part(fs->path, pool),
-                                   ":",
-                                   SVN_VA_NULL);
+  const char *prefix;
   svn_membuffer_t *membuffer;
   svn_boolean_t no_handler = ffd->fail_stop;
   svn_boolean_t cache_txdeltas;
@@ -372,7 +386,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                       fs,
                       pool));
 
-  prefix = apr_pstrcat(pool, "ns:", cache_namespace, ":", prefix, SVN_VA_NULL);
+  prefix = get_cache_prefix(fs, cache_namespace, pool);
   has_namespace = strlen(cache_namespace) > 0;
 
   membuffer = svn_cache__get_global_membuffer_cache();
@@ -897,3 +911,249 @@ svn_fs_fs__reset_txn_caches(svn_fs_t *fs)
   fs_fs_data_t *ffd = fs->fsap_data;
   ffd->txn_dir_cache = NULL;
 }
+
+/* First line of every FSFS cache snapshot file. */
+#define CACHE_SNAPSHOT_FORMAT "fsfs-cache-snapshot 2"
+
+/* Implements svn_cache__snapshot_filter_t.  Accept all items whose key
+ * starts with the FS-specific cache prefix given as BATON. */
+static svn_error_t *
+cache_snapshot_filter(svn_boolean_t *keep,
+                      void *baton,
+                      const char *prefix,
+                      apr_pool_t *scratch_pool)
+{
+  const char *fs_prefix = baton;
+  *keep = strncmp(prefix, fs_prefix, strlen(fs_prefix)) == 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *STATE to a string that identifies the current contents of FS.
+ * It combines the 'current' file, the oldest non-packed revision and the
+ * size and timestamp of the youngest revision file.  Thus, a restored
+ * backup will not match even if it has been committed to since.
+ * Allocate *STATE in RESULT_POOL and use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+get_snapshot_state(const char **state,
+                   svn_fs_t *fs,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_stringbuf_t *current;
+  svn_revnum_t youngest, min_unpacked_rev = 0;
+  const svn_io_dirent2_t *dirent;
+
+  SVN_ERR(svn_fs_fs__read_content(&current,
+                                  svn_fs_fs__path_current(fs, scratch_pool),
+                                  scratch_pool));
+  svn_stringbuf_strip_whitespace(current);
+  SVN_ERR(svn_revnum_parse(&youngest, current->data, NULL));
+
+  if (ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
+    {
+      SVN_ERR(svn_fs_fs__update_min_unpacked_rev(fs, scratch_pool));
+      min_unpacked_rev = ffd->min_unpacked_rev;
+    }
+
+  /* A concurrent pack may move the revision file.  Any snapshot state
+   * recorded in between will simply not match anymore. */
+  SVN_ERR(svn_io_stat_dirent2(&dirent,
+                              svn_fs_fs__path_rev_absolute(fs, youngest,
+                                                           scratch_pool),
+                              FALSE, TRUE, scratch_pool, scratch_pool));
+
+  *state = apr_psprintf(result_pool,
+                        "%s %ld %" SVN_FILESIZE_T_FMT " %" APR_TIME_T_FMT,
+                        current->data, min_unpacked_rev,
+                        dirent->filesize, dirent->mtime);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the snapshot file name to use for FS if the caller provided PATH.
+ * Allocate the result in RESULT_POOL. */
+static const char *
+get_snapshot_path(svn_fs_t *fs,
+                  const char *path,
+                  apr_pool_t *result_pool)
+{
+  return path ? path
+              : svn_dirent_join(fs->path, PATH_CACHE_SNAPSHOT, result_pool);
+}
+
+/* Write the snapshot header and the cached items of FS that match
+ * PREFIX from MEMBUFFER to STREAM.  Cancellation support is provided by
+ * CANCEL_FUNC and CANCEL_BATON.  Use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+write_cache_snapshot(svn_stream_t *stream,
+                     svn_fs_t *fs,
+                     svn_membuffer_t *membuffer,
+                     const char *prefix,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *state;
+
+  SVN_ERR(get_snapshot_state(&state, fs, scratch_pool, scratch_pool));
+  SVN_ERR(svn_stream_printf(stream, scratch_pool, "%s\n%s\n%s\n%s\n",
+                            CACHE_SNAPSHOT_FORMAT, fs->uuid,
+                            ffd->instance_id, state));
+  SVN_ERR(svn_cache__membuffer_save(membuffer, stream,
+                                    cache_snapshot_filter, (void *)prefix,
+                                    cancel_func, cancel_baton,
+                                    scratch_pool));
+
+  return svn_error_trace(svn_stream_close(stream));
+}
+
+svn_error_t *
+svn_fs_fs__save_cache_snapshot(svn_fs_t *fs,
+                               const char *path,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *scratch_pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  const char *cache_namespace;
+  svn_boolean_t cache_txdeltas, cache_fulltexts, cache_nodeprops;
+  svn_stream_t *stream;
+  const char *temp_path;
+  svn_error_t *err;
+
+  /* Nothing to save? */
+  if (membuffer == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(read_config(&cache_namespace, &cache_txdeltas, &cache_fulltexts,
+                      &cache_nodeprops, fs, scratch_pool));
+
+  /* Write to a temporary file first, such that readers will never see
+   * incomplete snapshots. */
+  path = get_snapshot_path(fs, path, scratch_pool);
+  SVN_ERR(svn_stream_open_unique(&stream, &temp_path,
+                                 svn_dirent_dirname(path, scratch_pool),
+                                 svn_io_file_del_none,
+                                 scratch_pool, scratch_pool));
+
+  err = write_cache_snapshot(stream, fs, membuffer,
+                             get_cache_prefix(fs, cache_namespace,
+                                              scratch_pool),
+                             cancel_func, cancel_baton, scratch_pool);
+  if (!err)
+    err = svn_io_file_rename2(temp_path, path, FALSE, scratch_pool);
+
+  if (err)
+    return svn_error_compose_create(err,
+                                    svn_io_remove_file2(temp_path, TRUE,
+                                                        scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the next line from STREAM into *LINE.  Allocate it in RESULT_POOL.
+ * Return an error if the end of STREAM has been reached. */
+static svn_error_t *
+read_snapshot_line(const char **line,
+                   svn_stream_t *stream,
+                   apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *buffer;
+  svn_boolean_t eof;
+
+  SVN_ERR(svn_stream_readline(stream, &buffer, "\n", &eof, result_pool));
+  if (eof)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                            _("Unexpected end of cache snapshot"));
+
+  *line = buffer->data;
+  return SVN_NO_ERROR;
+}
+
+/* Read the snapshot header from STREAM and set *MATCHES to whether the
+ * snapshot is still valid for FS.  Use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+check_snapshot_header(svn_boolean_t *matches,
+                      svn_stream_t *stream,
+                      svn_fs_t *fs,
+                      apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *format, *uuid, *instance_id, *saved_state, *state;
+
+  *matches = FALSE;
+
+  SVN_ERR(read_snapshot_line(&format, stream, scratch_pool));
+  SVN_ERR(read_snapshot_line(&uuid, stream, scratch_pool));
+  SVN_ERR(read_snapshot_line(&instance_id, stream, scratch_pool));
+  SVN_ERR(read_snapshot_line(&saved_state, stream, scratch_pool));
+
+  /* Same format and repository? */
+  if (   strcmp(format, CACHE_SNAPSHOT_FORMAT)
+      || strcmp(uuid, fs->uuid)
+      || strcmp(instance_id, ffd->instance_id))
+    return SVN_NO_ERROR;
+
+  /* Any change to the repository may invalidate cached data.  Revisions
+   * may have been replaced (e.g. after restoring a backup and committing
+   * to it) or packed.  Only accept the snapshot if nothing changed. */
+  SVN_ERR(get_snapshot_state(&state, fs, scratch_pool, scratch_pool));
+  *matches = strcmp(state, saved_state) == 0;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__load_cache_snapshot(svn_boolean_t *loaded,
+                               svn_fs_t *fs,
+                               const char *path,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *scratch_pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  const char *cache_namespace;
+  svn_boolean_t cache_txdeltas, cache_fulltexts, cache_nodeprops;
+  svn_boolean_t matches;
+  svn_stream_t *stream;
+  svn_error_t *err;
+
+  *loaded = FALSE;
+
+  /* Nowhere to load the data into? */
+  if (membuffer == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(read_config(&cache_namespace, &cache_txdeltas, &cache_fulltexts,
+                      &cache_nodeprops, fs, scratch_pool));
+
+  /* A missing snapshot is not an error. */
+  path = get_snapshot_path(fs, path, scratch_pool);
+  err = svn_stream_open_readonly(&stream, path, scratch_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(check_snapshot_header(&matches, stream, fs, scratch_pool));
+  if (matches)
+    {
+      SVN_ERR(svn_cache__membuffer_load(membuffer, stream,
+                                        cache_snapshot_filter,
+                                        (void *)get_cache_prefix(
+                                                     fs, cache_namespace,
+                                                     scratch_pool),
+                                        cancel_func, cancel_baton,
+                                        scratch_pool));
+      *loaded = TRUE;
+    }
+
+  return svn_error_trace(svn_stream_close(stream));
+}
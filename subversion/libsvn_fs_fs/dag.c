@@ -1020,6 +1020,30 @@ svn_fs_fs__dag_try_process_file_contents(svn_boolean_t *success,
 }
 
 
+svn_error_t *
+svn_fs_fs__dag_file_contents_ranges(apr_file_t **file,
+                                    apr_array_header_t **ranges,
+                                    dag_node_t *node,
+                                    apr_pool_t *result_pool,
+                                    apr_pool_t *scratch_pool)
+{
+  node_revision_t *noderev;
+
+  /* Make sure our node is a file. */
+  if (node->kind != svn_node_file)
+    return svn_error_createf
+      (SVN_ERR_FS_NOT_FILE, NULL,
+       "Attempted to get textual contents of a *non*-file node");
+
+  /* Go get a fresh node-revision for FILE. */
+  SVN_ERR(get_node_revision(&noderev, node));
+
+  return svn_fs_fs__get_contents_ranges(file, ranges, node->fs,
+                                        noderev->data_rep,
+                                        result_pool, scratch_pool);
+}
+
+
 svn_error_t *
 svn_fs_fs__dag_file_length(svn_filesize_t *length,
                            dag_node_t *file,
@@ -426,6 +426,18 @@ svn_fs_fs__dag_try_process_file_contents(svn_boolean_t *success,
                                          void* baton,
                                          apr_pool_t *pool);
 
+/* Implement svn_fs__file_contents_ranges() for the file NODE.
+
+   Allocate *FILE and *RANGES in RESULT_POOL and use SCRATCH_POOL for
+   temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__dag_file_contents_ranges(apr_file_t **file,
+                                    apr_array_header_t **ranges,
+                                    dag_node_t *node,
+                                    apr_pool_t *result_pool,
+                                    apr_pool_t *scratch_pool);
+
 
 /* Set *STREAM_P to a delta stream that will turn the contents of SOURCE into
    the contents of TARGET, allocated in POOL.  If SOURCE is null, the empty
@@ -328,6 +328,60 @@ fs_ioctl(svn_fs_t *fs, svn_fs_ioctl_code_t ctlcode,
           *output_p = NULL;
           return SVN_NO_ERROR;
         }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_SAVE_CACHE_SNAPSHOT.code)
+        {
+          svn_fs_fs__ioctl_cache_snapshot_input_t *input = input_void;
+
+          SVN_ERR(svn_fs_fs__save_cache_snapshot(fs, input->path,
+                                                 cancel_func, cancel_baton,
+                                                 scratch_pool));
+          *output_p = NULL;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_LOAD_CACHE_SNAPSHOT.code)
+        {
+          svn_fs_fs__ioctl_cache_snapshot_input_t *input = input_void;
+          svn_fs_fs__ioctl_load_cache_snapshot_output_t *output
+            = apr_pcalloc(result_pool, sizeof(*output));
+
+          SVN_ERR(svn_fs_fs__load_cache_snapshot(&output->loaded, fs,
+                                                 input->path,
+                                                 cancel_func, cancel_baton,
+                                                 scratch_pool));
+          *output_p = output;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_GET_VERIFY_CHECKPOINTS.code)
+        {
+          svn_fs_fs__ioctl_verify_checkpoints_input_t *input = input_void;
+          svn_fs_fs__ioctl_get_verify_checkpoints_output_t *output
+            = apr_pcalloc(result_pool, sizeof(*output));
+
+          SVN_ERR(svn_fs_fs__get_verify_checkpoints(&output->units, fs,
+                                                    input->start_rev,
+                                                    input->end_rev,
+                                                    result_pool,
+                                                    scratch_pool));
+          *output_p = output;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_ADD_VERIFY_CHECKPOINTS.code)
+        {
+          svn_fs_fs__ioctl_verify_checkpoints_input_t *input = input_void;
+
+          SVN_ERR(svn_fs_fs__add_verify_checkpoints(fs, input->start_rev,
+                                                    input->end_rev,
+                                                    scratch_pool));
+          *output_p = NULL;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code
+               == SVN_FS_FS__IOCTL_COMPACT_VERIFY_CHECKPOINTS.code)
+        {
+          SVN_ERR(svn_fs_fs__compact_verify_checkpoints(fs, scratch_pool));
+          *output_p = NULL;
+          return SVN_NO_ERROR;
+        }
     }
 
   return svn_error_create(SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE, NULL, NULL);
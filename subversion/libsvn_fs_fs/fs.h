@@ -66,18 +66,26 @@ extern "C" {
 #define PATH_LOCKS_DIR        "locks"            /* Directory of locks */
 #define PATH_MIN_UNPACKED_REV "min-unpacked-rev" /* Oldest revision which
                                                     has not been packed. */
+#define PATH_MIN_UNSTAGED_REV "min-unstaged-rev" /* Oldest revision which
+                                                    is neither packed nor
+                                                    in a pack stage. */
 #define PATH_REVPROP_GENERATION "revprop-generation"
                                                  /* Current revprop generation*/
 #define PATH_MANIFEST         "manifest"         /* Manifest file name */
 #define PATH_PACKED           "pack"             /* Packed revision data file */
 #define PATH_EXT_PACKED_SHARD ".pack"            /* Extension for packed
                                                     shards */
+#define PATH_EXT_PACK_STAGE   ".stage"           /* Extension for pack
+                                                    stage files */
 #define PATH_EXT_L2P_INDEX    ".l2p"             /* extension of the log-
                                                     to-phys index */
 #define PATH_EXT_P2L_INDEX    ".p2l"             /* extension of the phys-
                                                     to-log index */
 /* If you change this, look at tests/svn_test_fs.c(maybe_install_fsfs_conf) */
 #define PATH_CONFIG           "fsfs.conf"        /* Configuration */
+#define PATH_CACHE_SNAPSHOT   "cache-snapshot"   /* Saved cache contents */
+#define PATH_VERIFY_CHECKPOINTS "verify-checkpoints"
+                                                 /* Verified pack units */
 
 /* Names of special files and file extensions for transactions */
 #define PATH_CHANGES       "changes"       /* Records changes made so far */
@@ -119,6 +127,11 @@ extern "C" {
 #define CONFIG_OPTION_PACK_AFTER_COMMIT  "pack-after-commit"
 #define CONFIG_OPTION_VERIFY_BEFORE_COMMIT "verify-before-commit"
 #define CONFIG_OPTION_COMPRESSION        "compression"
+#define CONFIG_OPTION_LARGE_DELTA_WINDOWS "large-delta-windows"
+#define CONFIG_SECTION_PACK              "pack"
+#define CONFIG_OPTION_PACK_THREADS       "threads"
+#define CONFIG_OPTION_PACK_MEMORY        "memory-per-thread"
+#define CONFIG_OPTION_STAGE_AFTER_COMMIT "stage-after-commit"
 
 /* The format number of this filesystem.
    This is independent of the repository format number, and
@@ -127,7 +140,7 @@ extern "C" {
    Note: If you bump this, please update the switch statement in
          svn_fs_fs__create() as well.
  */
-#define SVN_FS_FS__FORMAT_NUMBER   8
+#define SVN_FS_FS__FORMAT_NUMBER   9
 
 /* The minimum format number that supports svndiff version 1.  */
 #define SVN_FS_FS__MIN_SVNDIFF1_FORMAT 2
@@ -188,6 +201,18 @@ extern "C" {
 /* The minimum format number that supports svndiff version 2. */
 #define SVN_FS_FS__MIN_SVNDIFF2_FORMAT 8
 
+/* The minimum format number that supports svndiff version 3. */
+#define SVN_FS_FS__MIN_SVNDIFF3_FORMAT 9
+
+/* The minimum format number that supports pack stages, i.e. intermediate
+   pack files covering a few revisions of a shard that has not been packed,
+   yet.  Requires logical addressing. */
+#define SVN_FS_FS__MIN_PACK_STAGES_FORMAT 9
+
+/* Number of revisions in a pack stage.  The last stage in a shard may be
+   shorter if the shard size is not a multiple of this. */
+#define SVN_FS_FS__PACK_STAGE_SIZE 16
+
 /* The minimum format number that supports the special notation ("-")
    for optional values that are not present in the representation strings,
    such as SHA1 or the uniquifier.  For example:
@@ -469,6 +494,11 @@ typedef struct fs_fs_data_t
    * if revprop packing has been enabled by the FSFS format version. */
   svn_revnum_t min_unpacked_rev;
 
+  /* The oldest revision that is neither packed nor in a pack stage.
+   * Revisions from MIN_UNPACKED_REV up to this one have been staged.
+   * Always 0 for formats that don't support pack stages. */
+  svn_revnum_t min_unstaged_rev;
+
   /* Whether rep-sharing is supported by the filesystem
    * and allowed by the configuration. */
   svn_boolean_t rep_sharing_allowed;
@@ -499,9 +529,22 @@ typedef struct fs_fs_data_t
   /* Compression level (currently, only used with compression_type_zlib). */
   int delta_compression_level;
 
+  /* Store new deltas in svndiff3 format with large delta windows. */
+  svn_boolean_t large_delta_windows;
+
   /* Pack after every commit. */
   svn_boolean_t pack_after_commit;
 
+  /* Number of shards to pack concurrently. */
+  int pack_threads;
+
+  /* Memory budget in bytes for each of the PACK_THREADS.  0 selects the
+     built-in default. */
+  apr_size_t pack_memory;
+
+  /* Put revisions into pack stages as soon as a stage is complete. */
+  svn_boolean_t stage_after_commit;
+
   /* Verify each new revision before commit. */
   svn_boolean_t verify_before_commit;
 
@@ -851,14 +851,59 @@ read_config(fs_fs_data_t *ffd,
 
   if (ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
     {
+      apr_int64_t threads, memory;
+
       SVN_ERR(svn_config_get_bool(config, &ffd->pack_after_commit,
                                   CONFIG_SECTION_DEBUG,
                                   CONFIG_OPTION_PACK_AFTER_COMMIT,
                                   FALSE));
+
+      SVN_ERR(svn_config_get_int64(config, &threads,
+                                   CONFIG_SECTION_PACK,
+                                   CONFIG_OPTION_PACK_THREADS,
+                                   1));
+      SVN_ERR(svn_config_get_int64(config, &memory,
+                                   CONFIG_SECTION_PACK,
+                                   CONFIG_OPTION_PACK_MEMORY,
+                                   0));
+
+      /* Don't accept unreasonable values.  The memory budget is given in
+       * MBytes. */
+      if (threads < 1 || threads > 256)
+        return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                 _("'%s' must be between 1 and 256"),
+                                 CONFIG_OPTION_PACK_THREADS);
+      if (memory < 0 || memory > APR_SIZE_MAX / 0x100000)
+        return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                 _("'%s' is out of range"),
+                                 CONFIG_OPTION_PACK_MEMORY);
+
+      ffd->pack_threads = (int)threads;
+      ffd->pack_memory = (apr_size_t)memory * 0x100000;
+
+      SVN_ERR(svn_config_get_bool(config, &ffd->stage_after_commit,
+                                  CONFIG_SECTION_PACK,
+                                  CONFIG_OPTION_STAGE_AFTER_COMMIT,
+                                  FALSE));
+      if (ffd->stage_after_commit)
+        {
+          if (ffd->format < SVN_FS_FS__MIN_PACK_STAGES_FORMAT)
+            return svn_error_create(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                    _("Pack stages require "
+                                      "filesystem format 9 or higher"));
+
+          if (!ffd->use_log_addressing)
+            return svn_error_create(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                    _("Pack stages require "
+                                      "logical addressing"));
+        }
     }
   else
     {
       ffd->pack_after_commit = FALSE;
+      ffd->pack_threads = 1;
+      ffd->pack_memory = 0;
+      ffd->stage_after_commit = FALSE;
     }
 
   /* Initialize compression settings in ffd. */
@@ -926,6 +971,24 @@ read_config(fs_fs_data_t *ffd,
       ffd->delta_compression_level = SVN_DELTA_COMPRESSION_LEVEL_NONE;
     }
 
+  /* Large delta windows use svndiff3, which implies LZ4. */
+  SVN_ERR(svn_config_get_bool(config, &ffd->large_delta_windows,
+                              CONFIG_SECTION_DELTIFICATION,
+                              CONFIG_OPTION_LARGE_DELTA_WINDOWS,
+                              FALSE));
+  if (ffd->large_delta_windows)
+    {
+      if (ffd->format < SVN_FS_FS__MIN_SVNDIFF3_FORMAT)
+        return svn_error_create(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                _("Large delta windows require "
+                                  "filesystem format 9 or higher"));
+
+      if (ffd->delta_compression_type != compression_type_lz4)
+        return svn_error_create(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                _("Large delta windows require "
+                                  "compression type 'lz4'"));
+    }
+
 #ifdef SVN_DEBUG
   SVN_ERR(svn_config_get_bool(config, &ffd->verify_before_commit,
                               CONFIG_SECTION_DEBUG,
@@ -1080,6 +1143,18 @@ write_config(svn_fs_t *fs,
 "### still be used (and it will result in zlib compression with the"         NL
 "### corresponding compression level)."                                      NL
 "###   " CONFIG_OPTION_COMPRESSION_LEVEL " = 0 ... 9 (default is 5)"         NL
+"###"                                                                        NL
+"### Deltas are normally computed over 100 kByte windows.  Large binary"     NL
+"### files whose content shifts by more than that between revisions will"    NL
+"### not find matches across window boundaries.  Enabling this option makes" NL
+"### new deltas use 1 MByte windows (svndiff3), which typically yields much" NL
+"### smaller deltas for such files at a moderate increase in memory usage."  NL
+"### To keep delta chains consistent, new deltas will use the window size"   NL
+"### of their delta base if that one is a delta itself.  This option"        NL
+"### requires '" CONFIG_OPTION_COMPRESSION " = lz4' and format 9"            NL
+"### repositories, available in Subversion 1.15 and higher."                 NL
+"### The default is false."                                                  NL
+"# " CONFIG_OPTION_LARGE_DELTA_WINDOWS " = false"                            NL
 ""                                                                           NL
 "[" CONFIG_SECTION_PACKED_REVPROPS "]"                                       NL
 "### This parameter controls the size (in kBytes) of packed revprop files."  NL
@@ -1149,6 +1224,31 @@ write_config(svn_fs_t *fs,
 "### p2l-page-size is given in kBytes and with a default of 1024 kBytes."    NL
 "# " CONFIG_OPTION_P2L_PAGE_SIZE " = 1024"                                   NL
 ""                                                                           NL
+"[" CONFIG_SECTION_PACK "]"                                                  NL
+"### Shards of the repository are independent of each other and may be"      NL
+"### packed concurrently.  This parameter sets the number of shards that"    NL
+"### 'svnadmin pack' will process at the same time.  Each shard will still"  NL
+"### become visible atomically and in order, i.e. readers and an"            NL
+"### interrupted pack will behave just as with a single thread."             NL
+"### The default is 1."                                                      NL
+"# " CONFIG_OPTION_PACK_THREADS " = 1"                                       NL
+"###"                                                                        NL
+"### The amount of memory (in MBytes) that each thread may use to reorder"   NL
+"### the contents of format 7+ revision files.  Larger values allow for"     NL
+"### better data locality in the pack files of very large shards.  The"      NL
+"### total memory usage will be roughly this value times the number of"      NL
+"### threads.  The default is 64 MBytes."                                    NL
+"# " CONFIG_OPTION_PACK_MEMORY " = 64"                                       NL
+"###"                                                                        NL
+"### Non-packed revisions may be combined into intermediate pack files"      NL
+"### (stages) of 16 revisions each right after they have been committed."    NL
+"### This reduces the number of files and the I/O overhead for recent"       NL
+"### history long before the shard is complete and can be packed.  Stages"   NL
+"### will be merged into the shard's pack file by 'svnadmin pack'."          NL
+"### This requires format 9 or newer and logical addressing."                NL
+"### The default is false."                                                  NL
+"# " CONFIG_OPTION_STAGE_AFTER_COMMIT " = false"                             NL
+""                                                                           NL
 "[" CONFIG_SECTION_DEBUG "]"                                                 NL
 "###"                                                                        NL
 "### Whether to verify each new revision immediately before finalizing"      NL
@@ -1267,6 +1367,49 @@ svn_fs_fs__open(svn_fs_t *fs, const char *path, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__open_clone(svn_fs_t **clone,
+                      svn_fs_t *fs,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_fs_t *result = apr_pmemdup(result_pool, fs, sizeof(*fs));
+  fs_fs_data_t *result_ffd = apr_pcalloc(result_pool, sizeof(*result_ffd));
+
+  /* Of the generic FS struct, the clone shares only the read-only config
+   * hash and the warning callback.  It never needs the lock tokens. */
+  result->pool = result_pool;
+  result->path = NULL;
+  result->uuid = NULL;
+  result->access_ctx = NULL;
+  result->fsap_data = result_ffd;
+
+  /* Initialize the backend-specific data just like fs_open() does, i.e.
+   * read everything from disk again.  Thus, the clone gets its own open
+   * files, youngest rev, revprop generation, txn bookkeeping and rep-cache
+   * connection. */
+  result_ffd->flush_to_disk = TRUE;
+  result_ffd->svn_fs_open_ = ffd->svn_fs_open_;
+  SVN_ERR(svn_fs_fs__open(result, fs->path, scratch_pool));
+
+  /* New cache frontends and per-instance caches.  Data is still being
+   * stored in the process-global membuffer cache, so callers must check
+   * svn_cache__global_membuffer_cache_is_thread_safe() before using the
+   * clone from another thread. */
+  SVN_ERR(svn_fs_fs__initialize_caches(result, scratch_pool));
+
+  /* The data shared between all instances of this repository does its own
+   * synchronization.  The clone works on behalf of FS, so it holds the
+   * same locks. */
+  result_ffd->shared = ffd->shared;
+  result_ffd->has_write_lock = ffd->has_write_lock;
+
+  *clone = result;
+
+  return SVN_NO_ERROR;
+}
+
 /* Wrapper around svn_io_file_create which ignores EEXIST. */
 static svn_error_t *
 create_file_ignore_eexist(const char *file,
@@ -1356,6 +1499,11 @@ upgrade_body(void *baton, apr_pool_t *pool)
     SVN_ERR(svn_io_file_create(svn_fs_fs__path_min_unpacked_rev(fs, pool),
                                "0\n", pool));
 
+  /* Same for the min unstaged rev file. */
+  if (format < SVN_FS_FS__MIN_PACK_STAGES_FORMAT)
+    SVN_ERR(svn_io_file_create(svn_fs_fs__path_min_unstaged_rev(fs, pool),
+                               "0\n", pool));
+
   /* If the file system supports revision packing but not revprop packing
      *and* the FS has been sharded, pack the revprops up to the point that
      revision data has been packed.  However, keep the non-packed revprop
@@ -1894,6 +2042,11 @@ svn_fs_fs__create_file_tree(svn_fs_t *fs,
     SVN_ERR(svn_io_file_create(svn_fs_fs__path_min_unpacked_rev(fs, pool),
                                "0\n", pool));
 
+  /* Create the min unstaged rev file. */
+  if (ffd->format >= SVN_FS_FS__MIN_PACK_STAGES_FORMAT)
+    SVN_ERR(svn_io_file_create(svn_fs_fs__path_min_unstaged_rev(fs, pool),
+                               "0\n", pool));
+
   /* Create the txn-current file if the repository supports
      the transaction sequence file. */
   if (format >= SVN_FS_FS__MIN_TXN_CURRENT_FORMAT)
@@ -1952,6 +2105,13 @@ svn_fs_fs__create(svn_fs_t *fs,
           case 9: format = 7;
                   break;
 
+          case 10:
+          case 11:
+          case 12:
+          case 13:
+          case 14: format = 8;
+                  break;
+
           default:format = SVN_FS_FS__FORMAT_NUMBER;
         }
 
@@ -2323,8 +2483,11 @@ svn_fs_fs__info_format(int *fs_format,
     case 8:
       (*supports_version)->minor = 10;
       break;
+    case 9:
+      (*supports_version)->minor = 15;
+      break;
 #ifdef SVN_DEBUG
-# if SVN_FS_FS__FORMAT_NUMBER != 8
+# if SVN_FS_FS__FORMAT_NUMBER != 9
 #  error "Need to add a 'case' statement here"
 # endif
 #endif
@@ -39,6 +39,18 @@ svn_error_t *svn_fs_fs__open(svn_fs_t *fs,
                              const char *path,
                              apr_pool_t *pool);
 
+/* Set *CLONE to a new instance of the open filesystem FS, allocated in
+   RESULT_POOL.  *CLONE re-reads all repository state from disk and shares
+   only FS' config hash, the shared per-repository data and FS' locks.
+   It may be used by a different thread than FS as long as the global
+   membuffer cache is thread-safe.  Use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_fs__open_clone(svn_fs_t **clone,
+                      svn_fs_t *fs,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool);
+
 /* Initialize parts of the FS data that are being shared across multiple
    filesystem objects.  Use COMMON_POOL for process-wide and POOL for
    temporary allocations.  Use COMMON_POOL_LOCK to ensure that the
@@ -304,6 +316,32 @@ svn_fs_fs__initialize_txn_caches(svn_fs_t *fs,
 void
 svn_fs_fs__reset_txn_caches(svn_fs_t *fs);
 
+/* Write all items currently cached for FS in the global membuffer cache
+   to the snapshot file PATH.  If PATH is NULL, use the default location
+   within FS.  The file gets replaced atomically.  Use CANCEL_FUNC and
+   CANCEL_BATON for cancellation support and SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_fs__save_cache_snapshot(svn_fs_t *fs,
+                               const char *path,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *scratch_pool);
+
+/* Read the cache snapshot file PATH, written by
+   svn_fs_fs__save_cache_snapshot, into the global membuffer cache.
+   If PATH is NULL, use the default location within FS.  Set *LOADED to
+   TRUE if the snapshot exists and is still valid for the current state
+   of FS.  Use CANCEL_FUNC and CANCEL_BATON for cancellation support and
+   SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__load_cache_snapshot(svn_boolean_t *loaded,
+                               svn_fs_t *fs,
+                               const char *path,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *scratch_pool);
+
 /* Scan all contents of the repository FS and return statistics in *STATS,
  * allocated in RESULT_POOL.  Report progress through PROGRESS_FUNC with
  * PROGRESS_BATON, if PROGRESS_FUNC is not NULL.
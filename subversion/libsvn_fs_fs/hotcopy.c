@@ -382,6 +382,73 @@ hotcopy_remove_file(const char *path,
   return SVN_NO_ERROR;
 }
 
+/* Copy the pack stage starting at revision REV from SRC_FS to DST_FS and
+ * switch DST_FS over to it.  Update *DST_MIN_UNSTAGED_REV in case the stage
+ * is new in DST_FS.  Do not re-copy data which already exists in DST_FS.
+ * Set *SKIPPED_P to FALSE only if the stage was copied, do not change the
+ * value in *SKIPPED_P otherwise.  If INCREMENTAL is set, remove the now
+ * redundant rev files from DST_FS.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+hotcopy_copy_stage(svn_boolean_t *skipped_p,
+                   svn_revnum_t *dst_min_unstaged_rev,
+                   svn_fs_t *src_fs,
+                   svn_fs_t *dst_fs,
+                   svn_revnum_t rev,
+                   svn_boolean_t incremental,
+                   apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *src_ffd = src_fs->fsap_data;
+  svn_revnum_t end_rev = rev + svn_fs_fs__stage_size(src_fs, rev);
+  const char *src_shard = svn_fs_fs__path_rev_shard(src_fs, rev,
+                                                    scratch_pool);
+  const char *dst_shard = svn_fs_fs__path_rev_shard(dst_fs, rev,
+                                                    scratch_pool);
+  const char *name
+    = svn_dirent_basename(svn_fs_fs__path_rev_staged(src_fs, rev,
+                                                     scratch_pool),
+                          NULL);
+
+  /* The stage may be the first thing we copy into that shard. */
+  if (rev % src_ffd->max_files_per_dir == 0)
+    {
+      const char *dst_revs_dir = svn_dirent_join(dst_fs->path,
+                                                 PATH_REVS_DIR,
+                                                 scratch_pool);
+      SVN_ERR(svn_io_make_dir_recursively(dst_shard, scratch_pool));
+      SVN_ERR(svn_io_copy_perms(dst_revs_dir, dst_shard, scratch_pool));
+    }
+
+  SVN_ERR(hotcopy_io_dir_file_copy(skipped_p, src_shard, dst_shard, name,
+                                   scratch_pool));
+
+  /* Make the stage visible in DST_FS before removing the rev files. */
+  if (*dst_min_unstaged_rev < end_rev)
+    {
+      *dst_min_unstaged_rev = end_rev;
+      SVN_ERR(svn_fs_fs__write_min_unstaged_rev(dst_fs, end_rev,
+                                                scratch_pool));
+    }
+
+  if (incremental)
+    {
+      svn_revnum_t i;
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+      for (i = rev; i < end_rev; ++i)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(hotcopy_remove_file(svn_fs_fs__path_rev(dst_fs, i,
+                                                          iterpool),
+                                      iterpool));
+        }
+
+      svn_pool_destroy(iterpool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Remove revision or revprop files between START_REV (inclusive) and
  * END_REV (non-inclusive) from folder DST_SUBDIR in DST_FS.  Assume
@@ -561,6 +628,8 @@ hotcopy_revisions(svn_fs_t *src_fs,
   int max_files_per_dir = src_ffd->max_files_per_dir;
   svn_revnum_t src_min_unpacked_rev;
   svn_revnum_t dst_min_unpacked_rev;
+  svn_revnum_t src_min_unstaged_rev = 0;
+  svn_revnum_t dst_min_unstaged_rev = 0;
   svn_revnum_t rev;
   apr_pool_t *iterpool;
 
@@ -593,6 +662,16 @@ hotcopy_revisions(svn_fs_t *src_fs,
       dst_min_unpacked_rev = 0;
     }
 
+  /* Pack stages will be copied along with the non-packed revisions.
+   * Holding the pack lock, SRC_FS will not add new stages meanwhile. */
+  if (src_ffd->format >= SVN_FS_FS__MIN_PACK_STAGES_FORMAT)
+    {
+      SVN_ERR(svn_fs_fs__read_min_unstaged_rev(&src_min_unstaged_rev,
+                                               src_fs, pool));
+      SVN_ERR(svn_fs_fs__read_min_unstaged_rev(&dst_min_unstaged_rev,
+                                               dst_fs, pool));
+    }
+
   if (cancel_func)
     SVN_ERR(cancel_func(cancel_baton));
 
@@ -690,11 +769,21 @@ hotcopy_revisions(svn_fs_t *src_fs,
        * hotcopy with an ENOENT (revision file moved to a pack, so it is no
        * longer where we expect it to be). */
 
-      /* Copy the rev file. */
-      SVN_ERR(hotcopy_copy_shard_file(&skipped,
-                                      src_revs_dir, dst_revs_dir, rev,
-                                      max_files_per_dir,
-                                      iterpool));
+      /* Copy the rev file or, once per stage, the pack stage. */
+      if (rev < src_min_unstaged_rev)
+        {
+          if (svn_fs_fs__stage_base_rev(src_fs, rev) == rev)
+            SVN_ERR(hotcopy_copy_stage(&skipped, &dst_min_unstaged_rev,
+                                       src_fs, dst_fs, rev, incremental,
+                                       iterpool));
+        }
+      else
+        {
+          SVN_ERR(hotcopy_copy_shard_file(&skipped,
+                                          src_revs_dir, dst_revs_dir, rev,
+                                          max_files_per_dir,
+                                          iterpool));
+        }
       /* Copy the revprop file. */
       SVN_ERR(hotcopy_copy_shard_file(&skipped,
                                       src_revprops_dir, dst_revprops_dir,
@@ -650,6 +650,19 @@ read_off_t_from_proto_index(apr_file_t *proto_index,
   return SVN_NO_ERROR;
 }
 
+/* Return the value identifying the type of REV_FILE in cache keys.  Rev
+ * files, pack stages and packed shards may all start with the same
+ * revision, so their index data must be kept apart.
+ */
+static int
+rev_file_kind(svn_fs_fs__revision_file_t *rev_file)
+{
+  if (rev_file->is_packed)
+    return 1;
+
+  return rev_file->is_staged ? 2 : 0;
+}
+
 /*
  * log-to-phys index
  */
@@ -981,7 +994,7 @@ get_l2p_header_body(l2p_header_t **header,
 
   pair_cache_key_t key;
   key.revision = rev_file->start_revision;
-  key.second = rev_file->is_packed;
+  key.second = rev_file_kind(rev_file);
 
   SVN_ERR(auto_open_l2p_index(rev_file, fs, revision));
   packed_stream_seek(rev_file->l2p_stream, 0);
@@ -1003,7 +1016,9 @@ get_l2p_header_body(l2p_header_t **header,
   SVN_ERR(packed_stream_get(&value, rev_file->l2p_stream));
   result->revision_count = (int)value;
   if (   result->revision_count != 1
-      && result->revision_count != (apr_uint64_t)ffd->max_files_per_dir)
+      && result->revision_count != (apr_uint64_t)ffd->max_files_per_dir
+      && (   !rev_file->is_staged
+          || result->revision_count > SVN_FS_FS__PACK_STAGE_SIZE))
     return svn_error_create(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
                             _("Invalid number of revisions in L2P index"));
 
@@ -1213,7 +1228,7 @@ get_l2p_page_info(l2p_page_info_baton_t *baton,
   /* try to find the info in the cache */
   pair_cache_key_t key;
   key.revision = rev_file->start_revision;
-  key.second = rev_file->is_packed;
+  key.second = rev_file_kind(rev_file);
   SVN_ERR(svn_cache__get_partial((void**)&dummy, &is_cached,
                                  ffd->l2p_header_cache, &key,
                                  l2p_page_info_access_func, baton,
@@ -1303,7 +1318,7 @@ get_l2p_page_table(apr_array_header_t *pages,
 
   pair_cache_key_t key;
   key.revision = rev_file->start_revision;
-  key.second = rev_file->is_packed;
+  key.second = rev_file_kind(rev_file);
 
   apr_array_clear(pages);
   baton.revision = revision;
@@ -1415,7 +1430,7 @@ prefetch_l2p_pages(svn_boolean_t *end,
   iterpool = svn_pool_create(scratch_pool);
   assert(revision <= APR_UINT32_MAX);
   key.revision = (apr_uint32_t)revision;
-  key.is_packed = rev_file->is_packed;
+  key.kind = rev_file_kind(rev_file);
 
   for (i = 0; i < pages->nelts && !*end; ++i)
     {
@@ -1554,7 +1569,7 @@ l2p_index_lookup(apr_off_t *offset,
 
   assert(revision <= APR_UINT32_MAX);
   key.revision = (apr_uint32_t)revision;
-  key.is_packed = svn_fs_fs__is_packed_rev(fs, revision);
+  key.kind = rev_file_kind(rev_file);
   key.page = info_baton.page_no;
 
   SVN_ERR(svn_cache__get_partial(&dummy, &is_cached,
@@ -1570,7 +1585,7 @@ l2p_index_lookup(apr_off_t *offset,
       svn_revnum_t prefetch_revision;
       svn_revnum_t last_revision
         = info_baton.first_revision
-          + (key.is_packed ? ffd->max_files_per_dir : 1);
+          + svn_fs_fs__rev_file_rev_count(fs, rev_file);
       svn_boolean_t end;
       apr_off_t max_offset
         = APR_ALIGN(info_baton.entry.offset + info_baton.entry.size,
@@ -1693,7 +1708,7 @@ get_l2p_header(l2p_header_t **header,
   /* first, try cache lookop */
   pair_cache_key_t key;
   key.revision = rev_file->start_revision;
-  key.second = rev_file->is_packed;
+  key.second = rev_file_kind(rev_file);
   SVN_ERR(svn_cache__get((void**)header, &is_cached, ffd->l2p_header_cache,
                          &key, result_pool));
   if (is_cached)
@@ -2173,7 +2188,7 @@ get_p2l_header(p2l_header_t **header,
   /* look for the header data in our cache */
   pair_cache_key_t key;
   key.revision = rev_file->start_revision;
-  key.second = rev_file->is_packed;
+  key.second = rev_file_kind(rev_file);
 
   SVN_ERR(svn_cache__get((void**)header, &is_cached, ffd->p2l_header_cache,
                          &key, result_pool));
@@ -2348,7 +2363,7 @@ get_p2l_page_info(p2l_page_info_baton_t *baton,
   /* look for the header data in our cache */
   pair_cache_key_t key;
   key.revision = rev_file->start_revision;
-  key.second = rev_file->is_packed;
+  key.second = rev_file_kind(rev_file);
 
   SVN_ERR(svn_cache__get_partial(&dummy, &is_cached, ffd->p2l_header_cache,
                                  &key, p2l_page_info_func, baton,
@@ -2555,7 +2570,7 @@ prefetch_p2l_page(svn_boolean_t *end,
   /* do we have that page in our caches already? */
   assert(baton->first_revision <= APR_UINT32_MAX);
   key.revision = (apr_uint32_t)baton->first_revision;
-  key.is_packed = svn_fs_fs__is_packed_rev(fs, baton->first_revision);
+  key.kind = rev_file_kind(rev_file);
   key.page = baton->page_no;
   SVN_ERR(svn_cache__has_key(&already_cached, ffd->p2l_page_cache,
                              &key, scratch_pool));
@@ -2626,7 +2641,7 @@ get_p2l_keys(p2l_page_info_baton_t *page_info_p,
       svn_fs_fs__page_cache_key_t key = { 0 };
       assert(page_info.first_revision <= APR_UINT32_MAX);
       key.revision = (apr_uint32_t)page_info.first_revision;
-      key.is_packed = rev_file->is_packed;
+      key.kind = rev_file_kind(rev_file);
       key.page = page_info.page_no;
 
       *key_p = key;
@@ -3060,7 +3075,7 @@ p2l_get_max_offset(apr_off_t *offset,
   /* look for the header data in our cache */
   pair_cache_key_t key;
   key.revision = rev_file->start_revision;
-  key.second = rev_file->is_packed;
+  key.second = rev_file_kind(rev_file);
 
   SVN_ERR(svn_cache__get_partial((void **)&offset_p, &is_cached,
                                  ffd->p2l_header_cache, &key,
@@ -269,9 +269,10 @@ typedef struct svn_fs_fs__page_cache_key_t
      in p2l: this is the start revision identifying the pack / rev file */
   apr_uint32_t revision;
 
-  /* if TRUE, this is the index to a pack file
+  /* type of the rev / pack file: 0 for rev files, 1 for packed shards
+   * and 2 for pack stages
    */
-  svn_boolean_t is_packed;
+  int kind;
 
   /* in l2p: page number within the revision
    * in p2l: page number with the rev / pack file
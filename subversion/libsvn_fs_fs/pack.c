@@ -30,6 +30,10 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_io_private.h"
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+#include "private/svn_task.h"
+#include "private/svn_cache.h"
 
 #include "fs_fs.h"
 #include "pack.h"
@@ -147,7 +151,7 @@ typedef struct pack_context_t
   /* baton to pass to CANCEL_FUNC */
   void *cancel_baton;
 
-  /* first revision in the shard (and future pack file) */
+  /* first revision in the shard or stage (and future pack file) */
   svn_revnum_t shard_rev;
 
   /* first revision in the range to process (>= SHARD_REV) */
@@ -156,7 +160,7 @@ typedef struct pack_context_t
   /* first revision after the range to process (<= SHARD_END_REV) */
   svn_revnum_t end_rev;
 
-  /* first revision after the current shard */
+  /* first revision after the current shard or stage */
   svn_revnum_t shard_end_rev;
 
   /* log-to-phys proto index for the whole pack file */
@@ -238,9 +242,9 @@ typedef struct pack_context_t
   svn_boolean_t flush_to_disk;
 } pack_context_t;
 
-/* Create and initialize a new pack context for packing shard SHARD_REV in
- * SHARD_DIR into PACK_FILE_DIR within filesystem FS.  Allocate it in POOL
- * and return the structure in *CONTEXT.
+/* Create and initialize a new pack context for packing the REV_COUNT
+ * revisions starting at SHARD_REV in SHARD_DIR into PACK_FILE_DIR within
+ * filesystem FS.  Allocate it in POOL and return the structure in *CONTEXT.
  *
  * Limit the number of items being copied per iteration to MAX_ITEMS.
  * Set FLUSH_TO_DISK, CANCEL_FUNC and CANCEL_BATON as well.
@@ -251,6 +255,7 @@ initialize_pack_context(pack_context_t *context,
                         const char *pack_file_dir,
                         const char *shard_dir,
                         svn_revnum_t shard_rev,
+                        int rev_count,
                         int max_items,
                         svn_boolean_t flush_to_disk,
                         svn_cancel_func_t cancel_func,
@@ -259,10 +264,10 @@ initialize_pack_context(pack_context_t *context,
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   const char *temp_dir;
-  int max_revs = MIN(ffd->max_files_per_dir, max_items);
+  int max_revs = MIN(rev_count, max_items);
 
   SVN_ERR_ASSERT(ffd->format >= SVN_FS_FS__MIN_LOG_ADDRESSING_FORMAT);
-  SVN_ERR_ASSERT(shard_rev % ffd->max_files_per_dir == 0);
+  SVN_ERR_ASSERT(rev_count > 0 && rev_count <= ffd->max_files_per_dir);
 
   /* where we will place our various temp files */
   SVN_ERR(svn_io_temp_dir(&temp_dir, pool));
@@ -275,7 +280,7 @@ initialize_pack_context(pack_context_t *context,
   context->shard_rev = shard_rev;
   context->start_rev = shard_rev;
   context->end_rev = shard_rev;
-  context->shard_end_rev = shard_rev + ffd->max_files_per_dir;
+  context->shard_end_rev = shard_rev + rev_count;
 
   /* the pool used for temp structures */
   context->info_pool = svn_pool_create(pool);
@@ -1337,8 +1342,9 @@ pack_range(pack_context_t *context,
   apr_pool_t *iterpool2 = svn_pool_create(pool);
 
   /* Phase 2: Copy items into various buckets and build tracking info */
-  svn_revnum_t revision;
-  for (revision = context->start_rev; revision < context->end_rev; ++revision)
+  svn_revnum_t revision, last;
+  for (revision = context->start_rev; revision < context->end_rev;
+       revision = last)
     {
       apr_off_t offset = 0;
       svn_fs_fs__revision_file_t *rev_file;
@@ -1350,8 +1356,40 @@ pack_range(pack_context_t *context,
                                                revision, revpool, iterpool));
       SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
 
+      /* A pack stage contains multiple revisions, some of which may be
+       * outside the current range.  Process all that are inside. */
+      if (rev_file->is_staged)
+        last = MIN(context->end_rev,
+                   rev_file->start_revision
+                     + svn_fs_fs__rev_file_rev_count(context->fs, rev_file));
+      else
+        last = revision + 1;
+
       /* store the indirect array index */
-      APR_ARRAY_PUSH(context->rev_offsets, int) = context->reps->nelts;
+      if (last == revision + 1)
+        {
+          APR_ARRAY_PUSH(context->rev_offsets, int) = context->reps->nelts;
+        }
+      else
+        {
+          /* Items of different revisions are interleaved in the stage.
+           * Reserve the index ranges for all of them up-front. */
+          apr_array_header_t *max_ids;
+          int i;
+
+          SVN_ERR(svn_fs_fs__l2p_get_max_ids(&max_ids, context->fs,
+                                             revision, last - revision,
+                                             revpool, iterpool));
+          for (i = 0; i < max_ids->nelts; ++i)
+            {
+              int end = context->reps->nelts
+                      + (int)APR_ARRAY_IDX(max_ids, i, apr_uint64_t);
+
+              APR_ARRAY_PUSH(context->rev_offsets, int) = context->reps->nelts;
+              while (context->reps->nelts < end)
+                APR_ARRAY_PUSH(context->reps, void *) = NULL;
+            }
+        }
 
       /* read the phys-to-log index file until we covered the whole rev file.
        * That index contains enough info to build both target indexes from it. */
@@ -1384,6 +1422,15 @@ pack_range(pack_context_t *context,
               offset = entry->offset;
               if (offset < rev_file->l2p_offset)
                 {
+                  /* skip items of revisions outside the current range */
+                  if (   entry->type == SVN_FS_FS__ITEM_TYPE_UNUSED
+                      || entry->item.revision < revision
+                      || entry->item.revision >= last)
+                    {
+                      offset += entry->size;
+                      continue;
+                    }
+
                   SVN_ERR(svn_io_file_seek(rev_file->file, APR_SET, &offset,
                                            iterpool2));
 
@@ -1457,6 +1504,79 @@ pack_range(pack_context_t *context,
   return SVN_NO_ERROR;
 }
 
+/* Append the items of CONTEXT->START_REV from the pack stage REV_FILE to
+ * the context's pack file, keeping their relative order.  Unlike plain rev
+ * files, stages interleave the items of multiple revisions, so we need to
+ * copy them one by one.  Use POOL for temporary allocations.
+ */
+static svn_error_t *
+append_staged_revision(pack_context_t *context,
+                       svn_fs_fs__revision_file_t *rev_file,
+                       apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = context->fs->fsap_data;
+  apr_off_t offset = 0;
+  apr_off_t revdata_size = rev_file->l2p_offset;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* mark the start of a new revision */
+  SVN_ERR(svn_fs_fs__l2p_proto_index_add_revision(context->proto_l2p_index,
+                                                  pool));
+
+  while (offset < revdata_size)
+    {
+      /* read one cluster */
+      int i;
+      apr_array_header_t *entries;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, context->fs, rev_file,
+                                          context->start_rev, offset,
+                                          ffd->p2l_page_size, iterpool,
+                                          iterpool));
+
+      for (i = 0; i < entries->nelts; ++i)
+        {
+          svn_fs_fs__p2l_entry_t *entry
+            = &APR_ARRAY_IDX(entries, i, svn_fs_fs__p2l_entry_t);
+
+          /* skip first entry if that was duplicated due crossing a
+             cluster boundary */
+          if (offset > entry->offset)
+            continue;
+
+          offset = entry->offset;
+          if (offset >= revdata_size)
+            break;
+
+          /* copy only the items that belong to the revision to append */
+          if (   entry->type != SVN_FS_FS__ITEM_TYPE_UNUSED
+              && entry->item.revision == context->start_rev)
+            {
+              SVN_ERR(svn_io_file_seek(rev_file->file, APR_SET, &offset,
+                                       iterpool));
+              SVN_ERR(copy_file_data(context, context->pack_file,
+                                     rev_file->file, entry->size,
+                                     iterpool));
+
+              entry->offset = context->pack_offset;
+              context->pack_offset += entry->size;
+              SVN_ERR(svn_fs_fs__l2p_proto_index_add_entry(
+                         context->proto_l2p_index, entry->offset,
+                         entry->item.number, iterpool));
+              SVN_ERR(svn_fs_fs__p2l_proto_index_add_entry(
+                         context->proto_p2l_index, entry, iterpool));
+            }
+
+          offset += entry->size;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Append CONTEXT->START_REV to the context's pack file with no re-ordering.
  * This function will only be used for very large revisions (>>100k changes).
  * Use POOL for temporary allocations.
@@ -1478,6 +1598,14 @@ append_revision(pack_context_t *context,
   SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
   revdata_size = rev_file->l2p_offset;
 
+  if (rev_file->is_staged)
+    {
+      SVN_ERR(append_staged_revision(context, rev_file, iterpool));
+      svn_pool_destroy(iterpool);
+
+      return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+    }
+
   SVN_ERR(svn_io_file_aligned_seek(rev_file->file, ffd->block_size, NULL, 0,
                                    iterpool));
   SVN_ERR(copy_file_data(context, context->pack_file, rev_file->file,
@@ -1536,8 +1664,9 @@ append_revision(pack_context_t *context,
 
 /* Logical addressing mode packing logic.
  *
- * Pack the revision shard starting at SHARD_REV in filesystem FS from
- * SHARD_DIR into the PACK_FILE_DIR, using POOL for allocations.  Limit
+ * Pack the REV_COUNT revisions starting at SHARD_REV in filesystem FS from
+ * SHARD_DIR into the PACK_FILE_DIR, using POOL for allocations.  This is
+ * either a whole shard or a pack stage within that shard.  Limit
  * the extra memory consumption to MAX_MEM bytes.  If FLUSH_TO_DISK is
  * non-zero, do not return until the data has actually been written on
  * the disk.  CANCEL_FUNC and CANCEL_BATON are what you think they are.
@@ -1547,6 +1676,7 @@ pack_log_addressed(svn_fs_t *fs,
                    const char *pack_file_dir,
                    const char *shard_dir,
                    svn_revnum_t shard_rev,
+                   int rev_count,
                    apr_size_t max_mem,
                    svn_boolean_t flush_to_disk,
                    svn_cancel_func_t cancel_func,
@@ -1581,8 +1711,9 @@ pack_log_addressed(svn_fs_t *fs,
 
   /* set up a pack context */
   SVN_ERR(initialize_pack_context(&context, fs, pack_file_dir, shard_dir,
-                                  shard_rev, max_items, flush_to_disk,
-                                  cancel_func, cancel_baton, pool));
+                                  shard_rev, rev_count, max_items,
+                                  flush_to_disk, cancel_func, cancel_baton,
+                                  pool));
 
   /* phase 1: determine the size of the revisions to pack */
   SVN_ERR(svn_fs_fs__l2p_get_max_ids(&max_ids, fs, shard_rev,
@@ -1840,8 +1971,9 @@ pack_rev_shard(svn_fs_t *fs,
   /* Index information files */
   if (svn_fs_fs__use_log_addressing(fs))
     SVN_ERR(pack_log_addressed(fs, pack_file_dir, shard_path,
-                               shard_rev, max_mem, flush_to_disk,
-                               cancel_func, cancel_baton, pool));
+                               shard_rev, max_files_per_dir, max_mem,
+                               flush_to_disk, cancel_func, cancel_baton,
+                               pool));
   else
     SVN_ERR(pack_phys_addressed(pack_file_dir, shard_path, shard_rev,
                                 max_files_per_dir, flush_to_disk,
@@ -1957,6 +2089,33 @@ synced_pack_shard(void *baton,
   return SVN_NO_ERROR;
 }
 
+/* Switch the shard described by BATON over to its already packed
+ * revision data.  Notify the caller about the shard being complete.
+ * Use POOL for temporary allocations.
+ */
+static svn_error_t *
+publish_shard(struct pack_baton *baton,
+              apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = baton->fs->fsap_data;
+
+  /* For newer repo formats, we only acquired the pack lock so far.
+     Before modifying the repo state by switching over to the packed
+     data, we need to acquire the global (write) lock. */
+  if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
+    SVN_ERR(svn_fs_fs__with_write_lock(baton->fs, synced_pack_shard, baton,
+                                       pool));
+  else
+    SVN_ERR(synced_pack_shard(baton, pool));
+
+  /* Notify caller we're starting to pack this shard. */
+  if (baton->notify_func)
+    SVN_ERR(baton->notify_func(baton->notify_baton, baton->shard,
+                               svn_fs_pack_notify_end, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Pack the shard described by BATON.
  *
  * If for some reason we detect a partial packing already performed,
@@ -1992,23 +2151,228 @@ pack_shard(struct pack_baton *baton,
                          baton->max_mem, ffd->flush_to_disk,
                          baton->cancel_func, baton->cancel_baton, pool));
 
-  /* For newer repo formats, we only acquired the pack lock so far.
-     Before modifying the repo state by switching over to the packed
-     data, we need to acquire the global (write) lock. */
-  if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
-    SVN_ERR(svn_fs_fs__with_write_lock(baton->fs, synced_pack_shard, baton,
-                                       pool));
-  else
-    SVN_ERR(synced_pack_shard(baton, pool));
+  return svn_error_trace(publish_shard(baton, pool));
+}
 
-  /* Notify caller we're starting to pack this shard. */
-  if (baton->notify_func)
-    SVN_ERR(baton->notify_func(baton->notify_baton, baton->shard,
-                               svn_fs_pack_notify_end, pool));
+#if APR_HAS_THREADS
+
+/* A shard to be packed by one of the worker threads. */
+typedef struct shard_task_t
+{
+  /* Shard number. */
+  apr_int64_t shard;
+
+  /* Directory to write the pack file and its indexes to. */
+  const char *rev_pack_file_dir;
+
+  /* Directory containing the non-packed revisions of the shard. */
+  const char *rev_shard_path;
+} shard_task_t;
+
+/* State shared by all worker threads packing shards concurrently. */
+typedef struct pack_workers_t
+{
+  /* Filesystem instances (svn_fs_t *) not currently used by any worker.
+   * Each one lives in its own root pool. */
+  apr_array_header_t *idle_fs;
+
+  /* Serializes access to IDLE_FS. */
+  svn_mutex__t *mutex;
+
+  /* Memory budget per worker. */
+  apr_size_t max_mem;
+
+  /* Non-zero if the workers shall stop as soon as possible. */
+  svn_atomic_t cancelled;
+} pack_workers_t;
+
+/* Implements svn_cancel_func_t.  BATON is a pack_workers_t *. */
+static svn_error_t *
+check_workers_cancelled(void *baton)
+{
+  pack_workers_t *workers = baton;
+
+  if (svn_atomic_read(&workers->cancelled))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
 
   return SVN_NO_ERROR;
 }
 
+/* Remove an idle filesystem instance from WORKERS and return it in *FS. */
+static svn_error_t *
+take_idle_fs(svn_fs_t **fs,
+             pack_workers_t *workers)
+{
+  svn_fs_t **entry = apr_array_pop(workers->idle_fs);
+  SVN_ERR_ASSERT(entry);
+  *fs = *entry;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return FS to the list of idle filesystem instances in WORKERS. */
+static svn_error_t *
+release_idle_fs(pack_workers_t *workers,
+                svn_fs_t *fs)
+{
+  APR_ARRAY_PUSH(workers->idle_fs, svn_fs_t *) = fs;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  Pack the revisions of the
+ * shard_task_t given as TASK into the shard's pack directory using one of
+ * the filesystem instances in the pack_workers_t PROCESS_BATON.  This does
+ * not publish the packed shard. */
+static svn_error_t *
+pack_shard_task(void **result,
+                void *task,
+                void *process_baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  shard_task_t *shard_task = task;
+  pack_workers_t *workers = process_baton;
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_error_t *err;
+
+  /* Filesystem objects are not thread-safe.  Use one that no other thread
+   * is using right now. */
+  SVN_MUTEX__WITH_LOCK(workers->mutex, take_idle_fs(&fs, workers));
+  ffd = fs->fsap_data;
+
+  err = pack_rev_shard(fs, shard_task->rev_pack_file_dir,
+                       shard_task->rev_shard_path, shard_task->shard,
+                       ffd->max_files_per_dir, workers->max_mem,
+                       ffd->flush_to_disk, check_workers_cancelled, workers,
+                       scratch_pool);
+
+  SVN_MUTEX__WITH_LOCK(workers->mutex, release_idle_fs(workers, fs));
+
+  *result = NULL;
+
+  return svn_error_trace(err);
+}
+
+/* Push a task for packing SHARD as described by PB into QUEUE. */
+static svn_error_t *
+push_shard_task(svn_task__queue_t *queue,
+                struct pack_baton *pb,
+                apr_int64_t shard)
+{
+  apr_pool_t *task_pool = svn_pool_create(NULL);
+  shard_task_t *task = apr_pcalloc(task_pool, sizeof(*task));
+
+  task->shard = shard;
+  task->rev_pack_file_dir = svn_dirent_join(pb->revs_dir,
+                  apr_psprintf(task_pool,
+                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
+                               shard),
+                  task_pool);
+  task->rev_shard_path = svn_dirent_join(pb->revs_dir,
+                  apr_psprintf(task_pool, "%" APR_INT64_T_FMT, shard),
+                  task_pool);
+
+  return svn_error_trace(svn_task__queue_push(queue, task, task_pool));
+}
+
+/* Pack the shards from PB->SHARD up to but not including COMPLETED_SHARDS
+ * on THREAD_COUNT threads.  The shards get published strictly in order,
+ * i.e. min-unpacked-rev advances exactly as it does when packing them one
+ * by one.  Use POOL for temporary allocations.
+ *
+ * Only the calling thread will invoke PB's notification and cancellation
+ * callbacks. */
+static svn_error_t *
+pack_shards_concurrently(struct pack_baton *pb,
+                         apr_int64_t completed_shards,
+                         int thread_count,
+                         apr_pool_t *pool)
+{
+  apr_pool_t *queue_pool = svn_pool_create(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  pack_workers_t *workers = apr_pcalloc(pool, sizeof(*workers));
+  svn_task__queue_t *queue = NULL;
+  apr_int64_t next_shard = pb->shard;
+  int max_pending = 2 * thread_count;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  workers->max_mem = pb->max_mem;
+  workers->idle_fs = apr_array_make(pool, thread_count, sizeof(svn_fs_t *));
+  SVN_ERR(svn_mutex__init(&workers->mutex, TRUE, pool));
+
+  /* Each worker gets its own filesystem instance. */
+  for (i = 0; i < thread_count && !err; ++i)
+    {
+      apr_pool_t *fs_pool = svn_pool_create(NULL);
+      svn_fs_t *fs;
+
+      err = svn_fs_fs__open_clone(&fs, pb->fs, fs_pool, iterpool);
+      if (err)
+        svn_pool_destroy(fs_pool);
+      else
+        APR_ARRAY_PUSH(workers->idle_fs, svn_fs_t *) = fs;
+    }
+
+  if (!err)
+    err = svn_task__queue_create(&queue, thread_count, 0, pack_shard_task,
+                                 workers, queue_pool);
+
+  for (; !err && pb->shard < completed_shards; pb->shard++)
+    {
+      apr_pool_t *task_pool = NULL;
+      shard_task_t *task;
+      void *result;
+
+      svn_pool_clear(iterpool);
+
+      /* Keep the workers busy but don't run too far ahead of the shard
+       * to publish next.  Finished shards take up disk space. */
+      while (!err
+             && next_shard < completed_shards
+             && svn_task__queue_size(queue) < max_pending)
+        err = push_shard_task(queue, pb, next_shard++);
+
+      if (!err && pb->cancel_func)
+        err = pb->cancel_func(pb->cancel_baton);
+
+      if (!err)
+        err = svn_task__queue_pop(&result, (void **)&task, &task_pool, queue);
+
+      /* Publish the packed shard just like pack_shard() would. */
+      if (!err && pb->notify_func)
+        err = pb->notify_func(pb->notify_baton, pb->shard,
+                              svn_fs_pack_notify_start, iterpool);
+
+      if (!err)
+        {
+          pb->rev_shard_path = apr_pstrdup(iterpool, task->rev_shard_path);
+          err = publish_shard(pb, iterpool);
+        }
+
+      if (task_pool)
+        svn_pool_destroy(task_pool);
+    }
+
+  /* Stop all workers and wait for them to finish.  Shards that have been
+   * packed but not published will be packed again next time. */
+  svn_atomic_set(&workers->cancelled, TRUE);
+  if (queue)
+    svn_error_clear(svn_task__queue_shutdown(queue));
+  svn_pool_destroy(queue_pool);
+
+  for (i = 0; i < workers->idle_fs->nelts; ++i)
+    svn_pool_destroy(APR_ARRAY_IDX(workers->idle_fs, i, svn_fs_t *)->pool);
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+#endif
+
 /* Read the youngest rev and the first non-packed rev info for FS from disk.
    Set *FULLY_PACKED when there is no completed unpacked shard.
    Use SCRATCH_POOL for temporary allocations.
@@ -2080,10 +2444,21 @@ pack_body(void *baton,
     pb->revsprops_dir = svn_dirent_join(pb->fs->path, PATH_REVPROPS_DIR,
                                         pool);
 
+  pb->shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
+
+#if APR_HAS_THREADS
+  /* Pack multiple shards at once, if configured and worthwhile.  All
+   * threads use the process-global cache, so that must be thread-safe. */
+  if (   ffd->pack_threads > 1
+      && completed_shards - pb->shard > 1
+      && svn_cache__global_membuffer_cache_is_thread_safe())
+    return svn_error_trace(pack_shards_concurrently(pb, completed_shards,
+                                                    ffd->pack_threads,
+                                                    pool));
+#endif
+
   iterpool = svn_pool_create(pool);
-  for (pb->shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
-       pb->shard < completed_shards;
-       pb->shard++)
+  for (; pb->shard < completed_shards; pb->shard++)
     {
       svn_pool_clear(iterpool);
 
@@ -2145,7 +2520,12 @@ svn_fs_fs__pack(svn_fs_t *fs,
   pb.notify_baton = notify_baton;
   pb.cancel_func = cancel_func;
   pb.cancel_baton = cancel_baton;
-  pb.max_mem = max_mem ? max_mem : DEFAULT_MAX_MEM;
+  if (max_mem)
+    pb.max_mem = max_mem;
+  else if (ffd->pack_memory)
+    pb.max_mem = ffd->pack_memory;
+  else
+    pb.max_mem = DEFAULT_MAX_MEM;
 
   if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
     {
@@ -2166,3 +2546,150 @@ svn_fs_fs__pack(svn_fs_t *fs,
 
   return svn_error_trace(err);
 }
+
+/* Baton struct used by stage_body(), pack_stage() and publish_stage(). */
+struct stage_baton
+{
+  svn_fs_t *fs;
+  apr_size_t max_mem;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* Valid when entering publish_stage(). */
+  svn_revnum_t start_rev;
+  int rev_count;
+};
+
+/* Part of the staging process that requires global (write) synchronization.
+ * Switch the revisions described by BATON over to their already written
+ * pack stage and remove their now redundant rev files.
+ */
+static svn_error_t *
+publish_stage(void *baton,
+              apr_pool_t *pool)
+{
+  struct stage_baton *sb = baton;
+  fs_fs_data_t *ffd = sb->fs->fsap_data;
+  svn_revnum_t end_rev = sb->start_rev + sb->rev_count;
+  svn_revnum_t rev;
+  apr_pool_t *iterpool;
+
+  /* Update the min-unstaged-rev file to reflect our new stage. */
+  SVN_ERR(svn_fs_fs__write_min_unstaged_rev(sb->fs, end_rev, pool));
+  ffd->min_unstaged_rev = end_rev;
+
+  /* Readers that still look for the rev files will retry after refreshing
+   * their MIN_UNSTAGED_REV info. */
+  iterpool = svn_pool_create(pool);
+  for (rev = sb->start_rev; rev < end_rev; ++rev)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_io_remove_file2(svn_fs_fs__path_rev(sb->fs, rev, iterpool),
+                                  TRUE, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Combine the revisions described by BATON into a single pack stage and
+ * publish it.  The caller must hold the pack lock.  Any left-overs of an
+ * interrupted attempt will be overwritten.  Use POOL for allocations.
+ */
+static svn_error_t *
+pack_stage(struct stage_baton *baton,
+           apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = baton->fs->fsap_data;
+  const char *shard_dir
+    = svn_fs_fs__path_rev_shard(baton->fs, baton->start_rev, pool);
+  const char *stage_path
+    = svn_fs_fs__path_rev_staged(baton->fs, baton->start_rev, pool);
+  const char *temp_dir = apr_pstrcat(pool, stage_path, "-tmp", SVN_VA_NULL);
+
+  /* Write the stage just like a pack file but to a temporary folder. */
+  SVN_ERR(svn_io_remove_dir2(temp_dir, TRUE, baton->cancel_func,
+                             baton->cancel_baton, pool));
+  SVN_ERR(svn_io_dir_make(temp_dir, APR_OS_DEFAULT, pool));
+  SVN_ERR(pack_log_addressed(baton->fs, temp_dir, shard_dir,
+                             baton->start_rev, baton->rev_count,
+                             baton->max_mem, ffd->flush_to_disk,
+                             baton->cancel_func, baton->cancel_baton,
+                             pool));
+
+  /* The stage will only be used once we bumped min-unstaged-rev. */
+  SVN_ERR(svn_fs_fs__move_into_place(
+             svn_dirent_join(temp_dir, PATH_PACKED, pool), stage_path,
+             svn_fs_fs__path_rev(baton->fs, baton->start_rev, pool),
+             ffd->flush_to_disk, pool));
+  SVN_ERR(svn_io_set_file_read_only(stage_path, FALSE, pool));
+  SVN_ERR(svn_io_remove_dir2(temp_dir, FALSE, baton->cancel_func,
+                             baton->cancel_baton, pool));
+
+  return svn_error_trace(svn_fs_fs__with_write_lock(baton->fs, publish_stage,
+                                                    baton, pool));
+}
+
+/* The work-horse for svn_fs_fs__pack_stages, called with the FS pack lock.
+   This implements the svn_fs_fs__with_pack_lock() 'body' callback type.
+   BATON is a 'struct stage_baton *'. */
+static svn_error_t *
+stage_body(void *baton,
+           apr_pool_t *pool)
+{
+  struct stage_baton *sb = baton;
+  fs_fs_data_t *ffd = sb->fs->fsap_data;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t youngest;
+  svn_revnum_t rev;
+
+  /* Another process might have packed or staged revisions already. */
+  SVN_ERR(svn_fs_fs__update_min_unpacked_rev(sb->fs, pool));
+  SVN_ERR(svn_fs_fs__youngest_rev(&youngest, sb->fs, pool));
+
+  /* Stages are aligned within their shard and never cross its end.
+   * Only complete stages get written. */
+  for (rev = MAX(ffd->min_unstaged_rev, ffd->min_unpacked_rev);
+       rev + svn_fs_fs__stage_size(sb->fs, rev) <= youngest + 1;
+       rev += sb->rev_count)
+    {
+      svn_pool_clear(iterpool);
+
+      if (sb->cancel_func)
+        SVN_ERR(sb->cancel_func(sb->cancel_baton));
+
+      sb->start_rev = rev;
+      sb->rev_count = (int)svn_fs_fs__stage_size(sb->fs, rev);
+      SVN_ERR(pack_stage(sb, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__pack_stages(svn_fs_t *fs,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *pool)
+{
+  struct stage_baton sb = { 0 };
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* Stages are an optimization.  Silently do nothing where unsupported
+     or where they would not be smaller than a shard. */
+  if (   ffd->format < SVN_FS_FS__MIN_PACK_STAGES_FORMAT
+      || !svn_fs_fs__use_log_addressing(fs)
+      || ffd->max_files_per_dir <= SVN_FS_FS__PACK_STAGE_SIZE)
+    return SVN_NO_ERROR;
+
+  sb.fs = fs;
+  sb.cancel_func = cancel_func;
+  sb.cancel_baton = cancel_baton;
+  sb.max_mem = ffd->pack_memory ? ffd->pack_memory : DEFAULT_MAX_MEM;
+
+  return svn_error_trace(svn_fs_fs__with_pack_lock(fs, stage_body, &sb,
+                                                   pool));
+}
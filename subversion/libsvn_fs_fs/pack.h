@@ -45,6 +45,22 @@ svn_fs_fs__pack(svn_fs_t *fs,
                 void *cancel_baton,
                 apr_pool_t *pool);
 
+/* Combine complete blocks of SVN_FS_FS__PACK_STAGE_SIZE revisions in the
+   non-packed shard(s) of FS into pack stages.  A stage is a single file
+   with the same layout as a pack file and will be merged into the shard's
+   pack file once the shard gets packed.  This reduces the number of files
+   as well as the seek distances for recent revisions long before their
+   shard is complete.
+
+   This is a no-op for repository formats that don't support stages.
+   Use optional CANCEL_FUNC/CANCEL_BATON for cancellation support and
+   POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__pack_stages(svn_fs_t *fs,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *pool);
+
 /**
  * For the packed revision @a rev in @a fs,  determine the offset within
  * the revision pack file and return it in @a rev_offset.  Use @a pool for
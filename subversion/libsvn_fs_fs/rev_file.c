@@ -42,6 +42,7 @@ init_revision_file(svn_fs_fs__revision_file_t *file,
   fs_fs_data_t *ffd = fs->fsap_data;
 
   file->is_packed = svn_fs_fs__is_packed_rev(fs, revision);
+  file->is_staged = svn_fs_fs__is_staged_rev(fs, revision);
   file->start_revision = svn_fs_fs__packed_base_rev(fs, revision);
 
   file->file = NULL;
@@ -159,6 +160,7 @@ open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
           file->stream = svn_stream_from_aprfile2(apr_file, TRUE,
                                                   result_pool);
           file->is_packed = svn_fs_fs__is_packed_rev(fs, rev);
+          file->is_staged = svn_fs_fs__is_staged_rev(fs, rev);
 
           return SVN_NO_ERROR;
         }
@@ -267,6 +269,21 @@ svn_fs_fs__auto_read_footer(svn_fs_fs__revision_file_t *file)
   return SVN_NO_ERROR;
 }
 
+svn_revnum_t
+svn_fs_fs__rev_file_rev_count(svn_fs_t *fs,
+                              svn_fs_fs__revision_file_t *file)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (file->is_packed)
+    return ffd->max_files_per_dir;
+
+  if (file->is_staged)
+    return svn_fs_fs__stage_size(fs, file->start_revision);
+
+  return 1;
+}
+
 svn_error_t *
 svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
                                svn_fs_t *fs,
@@ -284,6 +301,7 @@ svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
   *file = apr_pcalloc(result_pool, sizeof(**file));
   (*file)->file = apr_file;
   (*file)->is_packed = FALSE;
+  (*file)->is_staged = FALSE;
   (*file)->start_revision = SVN_INVALID_REVNUM;
   (*file)->stream = svn_stream_from_aprfile2(apr_file, TRUE, result_pool);
 
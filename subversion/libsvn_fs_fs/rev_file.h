@@ -51,6 +51,10 @@ typedef struct svn_fs_fs__revision_file_t
   /* the revision was packed when the first file / stream got opened */
   svn_boolean_t is_packed;
 
+  /* the revision was in a pack stage when the first file / stream got
+   * opened.  Mutually exclusive with IS_PACKED. */
+  svn_boolean_t is_staged;
+
   /* rev / pack file */
   apr_file_t *file;
 
@@ -128,6 +132,13 @@ svn_fs_fs__open_pack_or_rev_file_writable(svn_fs_fs__revision_file_t **file,
 svn_error_t *
 svn_fs_fs__auto_read_footer(svn_fs_fs__revision_file_t *file);
 
+/* Return the number of revisions stored in FILE, which has been opened
+ * for some revision in FS.
+ */
+svn_revnum_t
+svn_fs_fs__rev_file_rev_count(svn_fs_t *fs,
+                              svn_fs_fs__revision_file_t *file);
+
 /* Open the proto-rev file of transaction TXN_ID in FS and return it in *FILE.
  * Allocate *FILE in RESULT_POOL use and SCRATCH_POOL for temporaries.. */
 svn_error_t *
@@ -1157,7 +1157,8 @@ read_log_pack_file(query_t *query,
 }
 
 /* Read the content of the file for REVISION in logical addressing mode
- * and store its contents in QUERY.
+ * and store its contents in QUERY.  The file contains COUNT revisions,
+ * i.e. it is a pack stage if COUNT is larger than 1.
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
  * temporaries.
@@ -1165,10 +1166,11 @@ read_log_pack_file(query_t *query,
 static svn_error_t *
 read_log_revision_file(query_t *query,
                        svn_revnum_t revision,
+                       int count,
                        apr_pool_t *result_pool,
                        apr_pool_t *scratch_pool)
 {
-  SVN_ERR(read_log_rev_or_packfile(query, revision, 1,
+  SVN_ERR(read_log_rev_or_packfile(query, revision, count,
                                    result_pool, scratch_pool));
 
   /* show progress every 1000 revs or so */
@@ -1209,17 +1211,21 @@ read_revisions(query_t *query,
         SVN_ERR(read_phys_pack_file(query, revision, result_pool, iterpool));
     }
 
-  /* read non-packed revs */
-  for ( ; revision <= query->head; ++revision)
+  /* read non-packed revs, some of which may be in pack stages */
+  while (revision <= query->head)
     {
+      svn_revnum_t count = svn_fs_fs__pack_size(query->fs, revision);
+
       svn_pool_clear(iterpool);
 
       if (svn_fs_fs__use_log_addressing(query->fs))
-        SVN_ERR(read_log_revision_file(query, revision, result_pool,
-                                       iterpool));
+        SVN_ERR(read_log_revision_file(query, revision, (int)count,
+                                       result_pool, iterpool));
       else
         SVN_ERR(read_phys_revision_file(query, revision, result_pool,
                                         iterpool));
+
+      revision += count;
     }
 
   svn_pool_destroy(iterpool);
@@ -43,6 +43,7 @@
 #include "lock.h"
 #include "rep-cache.h"
 
+#include "private/svn_delta_private.h"
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
 #include "private/svn_sorts_private.h"
@@ -2159,24 +2160,54 @@ rep_write_cleanup(void *data)
   return APR_SUCCESS;
 }
 
-static void
+/* Set *HANDLER and *HANDLER_BATON to an svndiff writer for OUTPUT, using
+   the svndiff version configured for FS.  BASE_REP is the delta base of the
+   representation to write (may be NULL).  Return the window size to use for
+   the delta in *WINDOW_SIZE.
+
+   Deltas are combined window by window when reconstructing a fulltext,
+   so all deltas along a chain must use the same window size.  Thus, large
+   (svndiff3) windows get only used if the base is a plain representation
+   or if it has been written with large windows itself. */
+static svn_error_t *
 txdelta_to_svndiff(svn_txdelta_window_handler_t *handler,
                    void **handler_baton,
+                   apr_size_t *window_size,
                    svn_stream_t *output,
+                   representation_t *base_rep,
                    svn_fs_t *fs,
                    apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   int svndiff_version;
+  svn_boolean_t large_windows = FALSE;
 
-  if (ffd->delta_compression_type == compression_type_lz4)
+  if (ffd->format >= SVN_FS_FS__MIN_SVNDIFF3_FORMAT)
     {
-      SVN_ERR_ASSERT_NO_RETURN(ffd->format >= SVN_FS_FS__MIN_SVNDIFF2_FORMAT);
+      int base_version = -1;
+      if (base_rep)
+        SVN_ERR(svn_fs_fs__rep_svndiff_version(&base_version, base_rep, fs,
+                                               pool));
+
+      /* Plain or no base: follow the configuration. */
+      if (base_version < 0)
+        large_windows = ffd->large_delta_windows;
+      else
+        large_windows = base_version >= 3;
+    }
+
+  if (large_windows)
+    {
+      svndiff_version = 3;
+    }
+  else if (ffd->delta_compression_type == compression_type_lz4)
+    {
+      SVN_ERR_ASSERT(ffd->format >= SVN_FS_FS__MIN_SVNDIFF2_FORMAT);
       svndiff_version = 2;
     }
   else if (ffd->delta_compression_type == compression_type_zlib)
     {
-      SVN_ERR_ASSERT_NO_RETURN(ffd->format >= SVN_FS_FS__MIN_SVNDIFF1_FORMAT);
+      SVN_ERR_ASSERT(ffd->format >= SVN_FS_FS__MIN_SVNDIFF1_FORMAT);
       svndiff_version = 1;
     }
   else
@@ -2186,6 +2217,9 @@ txdelta_to_svndiff(svn_txdelta_window_handler_t *handler,
 
   svn_txdelta_to_svndiff3(handler, handler_baton, output, svndiff_version,
                           ffd->delta_compression_level, pool);
+  *window_size = svn_txdelta__window_size(svndiff_version);
+
+  return SVN_NO_ERROR;
 }
 
 /* Get a rep_write_baton and store it in *WB_P for the representation
@@ -2204,6 +2238,7 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
   svn_stream_t *source;
   svn_txdelta_window_handler_t wh;
   void *whb;
+  apr_size_t window_size;
   svn_fs_fs__rep_header_t header = { 0 };
 
   b = apr_pcalloc(pool, sizeof(*b));
@@ -2259,10 +2294,11 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
                             apr_pool_cleanup_null);
 
   /* Prepare to write the svndiff data. */
-  txdelta_to_svndiff(&wh, &whb, b->rep_stream, fs, pool);
+  SVN_ERR(txdelta_to_svndiff(&wh, &whb, &window_size, b->rep_stream,
+                             base_rep, fs, pool));
 
-  b->delta_stream = svn_txdelta_target_push(wh, whb, source,
-                                            b->scratch_pool);
+  b->delta_stream = svn_txdelta__target_push(wh, whb, source, window_size,
+                                             b->scratch_pool);
 
   *wb_p = b;
 
@@ -2902,6 +2938,7 @@ write_container_delta_rep(representation_t *rep,
 {
   svn_txdelta_window_handler_t diff_wh;
   void *diff_whb;
+  apr_size_t window_size;
 
   svn_stream_t *file_stream;
   svn_stream_t *stream;
@@ -2947,11 +2984,12 @@ write_container_delta_rep(representation_t *rep,
   SVN_ERR(svn_io_file_get_offset(&delta_start, file, scratch_pool));
 
   /* Prepare to write the svndiff data. */
-  txdelta_to_svndiff(&diff_wh, &diff_whb, file_stream, fs, scratch_pool);
+  SVN_ERR(txdelta_to_svndiff(&diff_wh, &diff_whb, &window_size, file_stream,
+                             base_rep, fs, scratch_pool));
 
   whb = apr_pcalloc(scratch_pool, sizeof(*whb));
-  whb->stream = svn_txdelta_target_push(diff_wh, diff_whb, source,
-                                        scratch_pool);
+  whb->stream = svn_txdelta__target_push(diff_wh, diff_whb, source,
+                                         window_size, scratch_pool);
   whb->size = 0;
   whb->md5_ctx = svn_checksum_ctx_create(svn_checksum_md5, scratch_pool);
   if (item_type != SVN_FS_FS__ITEM_TYPE_DIR_REP)
@@ -2362,6 +2362,11 @@ svn_fs_fs__commit_txn(const char **conflict_p,
       SVN_ERR(svn_fs_fs__pack(fs, 0, NULL, NULL, NULL, NULL, pool));
     }
 
+  if (ffd->stage_after_commit)
+    {
+      SVN_ERR(svn_fs_fs__pack_stages(fs, NULL, NULL, pool));
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -2963,6 +2968,26 @@ fs_try_process_file_contents(svn_boolean_t *success,
 /* --- End machinery for svn_fs_try_process_file_contents() ---  */
 
 
+/* --- Machinery for svn_fs__file_contents_ranges() ---  */
+
+static svn_error_t *
+fs_file_contents_ranges(apr_file_t **file,
+                        apr_array_header_t **ranges,
+                        svn_fs_root_t *root,
+                        const char *path,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  dag_node_t *node;
+  SVN_ERR(get_dag(&node, root, path, scratch_pool));
+
+  return svn_fs_fs__dag_file_contents_ranges(file, ranges, node,
+                                             result_pool, scratch_pool);
+}
+
+/* --- End machinery for svn_fs__file_contents_ranges() ---  */
+
+
 /* --- Machinery for svn_fs_apply_textdelta() ---  */
 
 
@@ -4572,6 +4597,7 @@ static root_vtable_t root_vtable = {
   fs_file_checksum,
   fs_file_contents,
   fs_try_process_file_contents,
+  fs_file_contents_ranges,
   fs_make_file,
   fs_apply_textdelta,
   fs_apply_text,
@@ -24,6 +24,7 @@
 
 #include "svn_ctype.h"
 #include "svn_dirent_uri.h"
+#include "svn_sorts.h"
 #include "private/svn_string_private.h"
 
 #include "fs_fs.h"
@@ -55,14 +56,71 @@ svn_fs_fs__is_packed_revprop(svn_fs_t *fs,
       && (ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT);
 }
 
+svn_boolean_t
+svn_fs_fs__is_staged_rev(svn_fs_t *fs,
+                         svn_revnum_t rev)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* MIN_UNSTAGED_REV may lag behind MIN_UNPACKED_REV. */
+  return (rev >= ffd->min_unpacked_rev) && (rev < ffd->min_unstaged_rev);
+}
+
 svn_revnum_t
 svn_fs_fs__packed_base_rev(svn_fs_t *fs,
                            svn_revnum_t revision)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  return (revision < ffd->min_unpacked_rev)
-       ? (revision - (revision % ffd->max_files_per_dir))
-       : revision;
+
+  if (revision < ffd->min_unpacked_rev)
+    return revision - (revision % ffd->max_files_per_dir);
+
+  if (revision < ffd->min_unstaged_rev)
+    return svn_fs_fs__stage_base_rev(fs, revision);
+
+  return revision;
+}
+
+svn_revnum_t
+svn_fs_fs__pack_size(svn_fs_t *fs,
+                     svn_revnum_t rev)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (rev < ffd->min_unpacked_rev)
+    return ffd->max_files_per_dir;
+
+  if (rev < ffd->min_unstaged_rev)
+    return svn_fs_fs__stage_size(fs, rev);
+
+  return 1;
+}
+
+svn_revnum_t
+svn_fs_fs__stage_base_rev(svn_fs_t *fs,
+                          svn_revnum_t rev)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_revnum_t shard_rev;
+
+  assert(ffd->max_files_per_dir);
+
+  /* Stages are aligned to the start of their shard. */
+  shard_rev = rev - (rev % ffd->max_files_per_dir);
+  return rev - ((rev - shard_rev) % SVN_FS_FS__PACK_STAGE_SIZE);
+}
+
+svn_revnum_t
+svn_fs_fs__stage_size(svn_fs_t *fs,
+                      svn_revnum_t rev)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_revnum_t base_rev = svn_fs_fs__stage_base_rev(fs, rev);
+  svn_revnum_t shard_end_rev = base_rev - (base_rev % ffd->max_files_per_dir)
+                             + ffd->max_files_per_dir;
+
+  /* Stages never cross shard boundaries. */
+  return MIN(SVN_FS_FS__PACK_STAGE_SIZE, shard_end_rev - base_rev);
 }
 
 const char *
@@ -118,6 +176,17 @@ svn_fs_fs__path_rev_packed(svn_fs_t *fs,
                               kind, SVN_VA_NULL);
 }
 
+const char *
+svn_fs_fs__path_rev_staged(svn_fs_t *fs,
+                           svn_revnum_t rev,
+                           apr_pool_t *pool)
+{
+  return svn_dirent_join(svn_fs_fs__path_rev_shard(fs, rev, pool),
+                         apr_psprintf(pool, "%ld" PATH_EXT_PACK_STAGE,
+                                      svn_fs_fs__stage_base_rev(fs, rev)),
+                         pool);
+}
+
 const char *
 svn_fs_fs__path_rev_shard(svn_fs_t *fs, svn_revnum_t rev, apr_pool_t *pool)
 {
@@ -148,31 +217,21 @@ svn_fs_fs__path_rev(svn_fs_t *fs, svn_revnum_t rev, apr_pool_t *pool)
                               apr_psprintf(pool, "%ld", rev), SVN_VA_NULL);
 }
 
-/* Set *PATH to the path of REV in FS with PACKED selecting whether the
-   (potential) pack file or single revision file name is returned.
-   Allocate *PATH in POOL.
-*/
-static const char *
-path_rev_absolute_internal(svn_fs_t *fs,
-                           svn_revnum_t rev,
-                           svn_boolean_t packed,
-                           apr_pool_t *pool)
-{
-  return packed
-       ? svn_fs_fs__path_rev_packed(fs, rev, PATH_PACKED, pool)
-       : svn_fs_fs__path_rev(fs, rev, pool);
-}
-
 const char *
 svn_fs_fs__path_rev_absolute(svn_fs_t *fs,
                              svn_revnum_t rev,
                              apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  svn_boolean_t is_packed = ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT
-                         && svn_fs_fs__is_packed_rev(fs, rev);
 
-  return path_rev_absolute_internal(fs, rev, is_packed, pool);
+  if (   ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT
+      && svn_fs_fs__is_packed_rev(fs, rev))
+    return svn_fs_fs__path_rev_packed(fs, rev, PATH_PACKED, pool);
+
+  if (svn_fs_fs__is_staged_rev(fs, rev))
+    return svn_fs_fs__path_rev_staged(fs, rev, pool);
+
+  return svn_fs_fs__path_rev(fs, rev, pool);
 }
 
 const char *
@@ -372,6 +431,20 @@ svn_fs_fs__path_min_unpacked_rev(svn_fs_t *fs,
   return svn_dirent_join(fs->path, PATH_MIN_UNPACKED_REV, pool);
 }
 
+const char *
+svn_fs_fs__path_min_unstaged_rev(svn_fs_t *fs,
+                                 apr_pool_t *pool)
+{
+  return svn_dirent_join(fs->path, PATH_MIN_UNSTAGED_REV, pool);
+}
+
+const char *
+svn_fs_fs__path_verify_checkpoints(svn_fs_t *fs,
+                                   apr_pool_t *pool)
+{
+  return svn_dirent_join(fs->path, PATH_VERIFY_CHECKPOINTS, pool);
+}
+
 svn_error_t *
 svn_fs_fs__check_file_buffer_numeric(const char *buf,
                                      apr_off_t offset,
@@ -390,28 +463,67 @@ svn_fs_fs__check_file_buffer_numeric(const char *buf,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_fs_fs__read_min_unpacked_rev(svn_revnum_t *min_unpacked_rev,
-                                 svn_fs_t *fs,
-                                 apr_pool_t *pool)
+/* Set *REV to the revision number stored in the file at PATH.
+ * Use POOL for temporary allocations. */
+static svn_error_t *
+read_revnum_file(svn_revnum_t *rev,
+                 const char *path,
+                 apr_pool_t *pool)
 {
   char buf[80];
   apr_file_t *file;
   apr_size_t len;
 
-  SVN_ERR(svn_io_file_open(&file,
-                           svn_fs_fs__path_min_unpacked_rev(fs, pool),
-                           APR_READ | APR_BUFFERED,
-                           APR_OS_DEFAULT,
-                           pool));
+  SVN_ERR(svn_io_file_open(&file, path, APR_READ | APR_BUFFERED,
+                           APR_OS_DEFAULT, pool));
   len = sizeof(buf);
   SVN_ERR(svn_io_read_length_line(file, buf, &len, pool));
   SVN_ERR(svn_io_file_close(file, pool));
 
-  SVN_ERR(svn_revnum_parse(min_unpacked_rev, buf, NULL));
+  SVN_ERR(svn_revnum_parse(rev, buf, NULL));
+  return SVN_NO_ERROR;
+}
+
+/* Atomically replace the file at PATH in FS with one containing REVNUM.
+ * Perform temporary allocations in SCRATCH_POOL. */
+static svn_error_t *
+write_revnum_file(svn_fs_t *fs,
+                  const char *path,
+                  svn_revnum_t revnum,
+                  apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  char buf[SVN_INT64_BUFFER_SIZE];
+  apr_size_t len = svn__i64toa(buf, revnum);
+  buf[len] = '\n';
+
+  SVN_ERR(svn_io_write_atomic2(path, buf, len + 1,
+                               path /* copy_perms */,
+                               ffd->flush_to_disk, scratch_pool));
+
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__read_min_unpacked_rev(svn_revnum_t *min_unpacked_rev,
+                                 svn_fs_t *fs,
+                                 apr_pool_t *pool)
+{
+  return svn_error_trace(read_revnum_file(min_unpacked_rev,
+                             svn_fs_fs__path_min_unpacked_rev(fs, pool),
+                             pool));
+}
+
+svn_error_t *
+svn_fs_fs__read_min_unstaged_rev(svn_revnum_t *min_unstaged_rev,
+                                 svn_fs_t *fs,
+                                 apr_pool_t *pool)
+{
+  return svn_error_trace(read_revnum_file(min_unstaged_rev,
+                             svn_fs_fs__path_min_unstaged_rev(fs, pool),
+                             pool));
+}
+
 svn_error_t *
 svn_fs_fs__update_min_unpacked_rev(svn_fs_t *fs,
                                    apr_pool_t *pool)
@@ -420,6 +532,12 @@ svn_fs_fs__update_min_unpacked_rev(svn_fs_t *fs,
 
   SVN_ERR_ASSERT(ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT);
 
+  /* Concurrent staging or packing may change either value in between.
+   * Callers detect that as missing files and simply retry. */
+  if (ffd->format >= SVN_FS_FS__MIN_PACK_STAGES_FORMAT)
+    SVN_ERR(svn_fs_fs__read_min_unstaged_rev(&ffd->min_unstaged_rev, fs,
+                                             pool));
+
   return svn_fs_fs__read_min_unpacked_rev(&ffd->min_unpacked_rev, fs, pool);
 }
 
@@ -428,19 +546,19 @@ svn_fs_fs__write_min_unpacked_rev(svn_fs_t *fs,
                                   svn_revnum_t revnum,
                                   apr_pool_t *scratch_pool)
 {
-  fs_fs_data_t *ffd = fs->fsap_data;
-  const char *final_path;
-  char buf[SVN_INT64_BUFFER_SIZE];
-  apr_size_t len = svn__i64toa(buf, revnum);
-  buf[len] = '\n';
-
-  final_path = svn_fs_fs__path_min_unpacked_rev(fs, scratch_pool);
-
-  SVN_ERR(svn_io_write_atomic2(final_path, buf, len + 1,
-                               final_path /* copy_perms */,
-                               ffd->flush_to_disk, scratch_pool));
+  return svn_error_trace(write_revnum_file(fs,
+                           svn_fs_fs__path_min_unpacked_rev(fs, scratch_pool),
+                           revnum, scratch_pool));
+}
 
-  return SVN_NO_ERROR;
+svn_error_t *
+svn_fs_fs__write_min_unstaged_rev(svn_fs_t *fs,
+                                  svn_revnum_t revnum,
+                                  apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(write_revnum_file(fs,
+                           svn_fs_fs__path_min_unstaged_rev(fs, scratch_pool),
+                           revnum, scratch_pool));
 }
 
 svn_error_t *
@@ -76,12 +76,36 @@ svn_boolean_t
 svn_fs_fs__is_packed_revprop(svn_fs_t *fs,
                              svn_revnum_t rev);
 
+/* Return TRUE is REV is in a pack stage in FS, FALSE otherwise. */
+svn_boolean_t
+svn_fs_fs__is_staged_rev(svn_fs_t *fs,
+                         svn_revnum_t rev);
+
 /* Return the first revision in the pack / rev file containing REVISION in
  * filesystem FS.  For non-packed revs, this will simply be REVISION. */
 svn_revnum_t
 svn_fs_fs__packed_base_rev(svn_fs_t *fs,
                            svn_revnum_t revision);
 
+/* Return the number of revisions in the pack / rev file containing REV in
+ * filesystem FS.  For non-packed revs, this will be 1. */
+svn_revnum_t
+svn_fs_fs__pack_size(svn_fs_t *fs,
+                     svn_revnum_t rev);
+
+/* Return the first revision of the pack stage that covers REV in FS,
+ * regardless of whether REV has already been staged. */
+svn_revnum_t
+svn_fs_fs__stage_base_rev(svn_fs_t *fs,
+                          svn_revnum_t rev);
+
+/* Return the number of revisions in the pack stage that covers REV in FS.
+ * This is SVN_FS_FS__PACK_STAGE_SIZE except for the last stage of shards
+ * whose size is not a multiple of it. */
+svn_revnum_t
+svn_fs_fs__stage_size(svn_fs_t *fs,
+                      svn_revnum_t rev);
+
 /* Return the full path of the rev shard directory that will contain
  * revision REV in FS.  Allocate the result in POOL.
  */
@@ -108,6 +132,14 @@ svn_fs_fs__path_rev_packed(svn_fs_t *fs,
                            const char *kind,
                            apr_pool_t *pool);
 
+/* Return the full path of the pack stage file that covers revision REV
+ * in FS.  Allocate the result in POOL.
+ */
+const char *
+svn_fs_fs__path_rev_staged(svn_fs_t *fs,
+                           svn_revnum_t rev,
+                           apr_pool_t *pool);
+
 /* Return the full path of the "txn-current" file in FS.
  * The result will be allocated in POOL.
  */
@@ -189,6 +221,20 @@ const char *
 svn_fs_fs__path_min_unpacked_rev(svn_fs_t *fs,
                                  apr_pool_t *pool);
 
+/* Return the path of the file storing the oldest non-staged revision in FS.
+ * The result will be allocated in POOL.
+ */
+const char *
+svn_fs_fs__path_min_unstaged_rev(svn_fs_t *fs,
+                                 apr_pool_t *pool);
+
+/* Return the path of the file listing the pack units of FS that passed
+ * incremental verification.  The result will be allocated in POOL.
+ */
+const char *
+svn_fs_fs__path_verify_checkpoints(svn_fs_t *fs,
+                                   apr_pool_t *pool);
+
 /* Return the path of the 'transactions' directory in FS.
  * The result will be allocated in POOL.
  */
@@ -296,6 +342,15 @@ svn_fs_fs__read_min_unpacked_rev(svn_revnum_t *min_unpacked_rev,
                                  svn_fs_t *fs,
                                  apr_pool_t *pool);
 
+/* Set *MIN_UNSTAGED_REV to the integer value read from the file returned
+ * by #svn_fs_fs__path_min_unstaged_rev() for FS.
+ * Use POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__read_min_unstaged_rev(svn_revnum_t *min_unstaged_rev,
+                                 svn_fs_t *fs,
+                                 apr_pool_t *pool);
+
 /* Check that BUF, a nul-terminated buffer of text from file PATH,
    contains only digits at OFFSET and beyond, raising an error if not.
    TITLE contains a user-visible description of the file, usually the
@@ -309,7 +364,8 @@ svn_fs_fs__check_file_buffer_numeric(const char *buf,
                                      const char *title,
                                      apr_pool_t *pool);
 
-/* Re-read the MIN_UNPACKED_REV member of FS from disk.
+/* Re-read the MIN_UNPACKED_REV member of FS from disk.  If FS supports
+ * pack stages, re-read MIN_UNSTAGED_REV as well.
  * Use POOL for temporary allocations.
  */
 svn_error_t *
@@ -324,6 +380,14 @@ svn_fs_fs__write_min_unpacked_rev(svn_fs_t *fs,
                                   svn_revnum_t revnum,
                                   apr_pool_t *scratch_pool);
 
+/* Atomically update the 'min-unstaged-rev' file in FS to hold the specified
+ * REVNUM.  Perform temporary allocations in SCRATCH_POOL.
+ */
+svn_error_t *
+svn_fs_fs__write_min_unstaged_rev(svn_fs_t *fs,
+                                  svn_revnum_t revnum,
+                                  apr_pool_t *scratch_pool);
+
 /* Set *REV, *NEXT_NODE_ID and *NEXT_COPY_ID to the values read from the
  * 'current' file.  For new FS formats, which only store the youngest
  * revision, set the *NEXT_NODE_ID and *NEXT_COPY_ID to 0.  Perform
@@ -24,6 +24,12 @@
 #include "svn_checksum.h"
 #include "svn_time.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+#include "private/svn_task.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_fs_fs_private.h"
+#include "private/svn_cache.h"
 
 #include "verify.h"
 #include "fs_fs.h"
@@ -784,12 +790,173 @@ verify_revprops(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
-static svn_revnum_t
-pack_size(svn_fs_t *fs, svn_revnum_t rev)
+/* Identifies the on-disk state of a pack unit, i.e. a packed shard, a pack
+ * stage or a non-packed revision, that passed verification. */
+typedef struct verify_checkpoint_t
 {
-  fs_fs_data_t *ffd = fs->fsap_data;
+  /* First revision in the pack unit. */
+  svn_revnum_t start;
+
+  /* Number of revisions in the pack unit. */
+  svn_revnum_t count;
+
+  /* Index checksums as stored in the footer of the rev / pack file. */
+  svn_checksum_t *l2p_checksum;
+  svn_checksum_t *p2l_checksum;
+
+  /* Size and last modification time of the rev / pack file. */
+  svn_filesize_t size;
+  apr_time_t mtime;
+} verify_checkpoint_t;
+
+/* Set *CHECKPOINT to the current state of the pack unit of COUNT revisions
+ * starting at START in FS.  Allocate the result in RESULT_POOL and use
+ * SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+get_checkpoint(verify_checkpoint_t **checkpoint,
+               svn_fs_t *fs,
+               svn_revnum_t start,
+               svn_revnum_t count,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__revision_file_t *rev_file;
+  apr_finfo_t finfo;
+  verify_checkpoint_t *result = apr_pcalloc(result_pool, sizeof(*result));
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, start,
+                                           scratch_pool, scratch_pool));
+  SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
+  SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_SIZE | APR_FINFO_MTIME,
+                               rev_file->file, scratch_pool));
+
+  result->start = start;
+  result->count = count;
+  result->l2p_checksum = svn_checksum_dup(rev_file->l2p_checksum,
+                                          result_pool);
+  result->p2l_checksum = svn_checksum_dup(rev_file->p2l_checksum,
+                                          result_pool);
+  result->size = finfo.size;
+  result->mtime = finfo.mtime;
+
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+  *checkpoint = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if the checkpoints LHS and RHS describe the same state of
+ * the same pack unit. */
+static svn_boolean_t
+checkpoints_match(const verify_checkpoint_t *lhs,
+                  const verify_checkpoint_t *rhs)
+{
+  return lhs->start == rhs->start
+      && lhs->count == rhs->count
+      && lhs->size == rhs->size
+      && lhs->mtime == rhs->mtime
+      && svn_checksum_match(lhs->l2p_checksum, rhs->l2p_checksum)
+      && svn_checksum_match(lhs->p2l_checksum, rhs->p2l_checksum);
+}
+
+/* Parse the checkpoint LINE and return it in *CHECKPOINT, allocated in
+ * RESULT_POOL.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+parse_checkpoint(verify_checkpoint_t **checkpoint,
+                 const char *line,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *tokens = svn_cstring_split(line, " ", TRUE,
+                                                 scratch_pool);
+  verify_checkpoint_t *result = apr_pcalloc(result_pool, sizeof(*result));
+  apr_int64_t value;
+
+  if (tokens->nelts != 6)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                             _("Malformed verification checkpoint '%s'"),
+                             line);
+
+  SVN_ERR(svn_revnum_parse(&result->start,
+                           APR_ARRAY_IDX(tokens, 0, const char *), NULL));
+  SVN_ERR(svn_revnum_parse(&result->count,
+                           APR_ARRAY_IDX(tokens, 1, const char *), NULL));
+  SVN_ERR(svn_checksum_parse_hex(&result->l2p_checksum, svn_checksum_md5,
+                                 APR_ARRAY_IDX(tokens, 2, const char *),
+                                 result_pool));
+  SVN_ERR(svn_checksum_parse_hex(&result->p2l_checksum, svn_checksum_md5,
+                                 APR_ARRAY_IDX(tokens, 3, const char *),
+                                 result_pool));
+  SVN_ERR(svn_cstring_atoi64(&value, APR_ARRAY_IDX(tokens, 4, const char *)));
+  result->size = value;
+  SVN_ERR(svn_cstring_atoi64(&value, APR_ARRAY_IDX(tokens, 5, const char *)));
+  result->mtime = value;
+
+  if (!result->l2p_checksum || !result->p2l_checksum)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                             _("Malformed verification checkpoint '%s'"),
+                             line);
+
+  *checkpoint = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the verification checkpoints file of FS and return its contents
+ * in *CHECKPOINTS, mapping the first revision (svn_revnum_t) of each pack
+ * unit to its latest verify_checkpoint_t.  Allocate the result in
+ * RESULT_POOL and use SCRATCH_POOL for temporary allocations.
+ *
+ * Lines that cannot be parsed, e.g. because a previous run got interrupted
+ * while writing them, will be ignored. */
+static svn_error_t *
+read_checkpoints(apr_hash_t **checkpoints,
+                 svn_fs_t *fs,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *content;
+  apr_array_header_t *lines;
+  apr_pool_t *iterpool;
+  svn_error_t *err;
+  int i;
+
+  *checkpoints = apr_hash_make(result_pool);
+  err = svn_stringbuf_from_file2(&content,
+                                 svn_fs_fs__path_verify_checkpoints(
+                                   fs, scratch_pool),
+                                 scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  iterpool = svn_pool_create(scratch_pool);
+  lines = svn_cstring_split(content->data, "\n", TRUE, scratch_pool);
+  for (i = 0; i < lines->nelts; ++i)
+    {
+      verify_checkpoint_t *checkpoint;
+
+      svn_pool_clear(iterpool);
+      err = parse_checkpoint(&checkpoint,
+                             APR_ARRAY_IDX(lines, i, const char *),
+                             result_pool, iterpool);
+      if (err)
+        {
+          svn_error_clear(err);
+          continue;
+        }
+
+      /* Later entries supersede earlier ones. */
+      apr_hash_set(*checkpoints, &checkpoint->start,
+                   sizeof(checkpoint->start), checkpoint);
+    }
 
-  return rev < ffd->min_unpacked_rev ? ffd->max_files_per_dir : 1;
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
 }
 
 /* Verify that on-disk representation has not been tempered with (in a way
@@ -819,7 +986,7 @@ verify_f7_metadata_consistency(svn_fs_t *fs,
     {
       svn_error_t *err = SVN_NO_ERROR;
 
-      svn_revnum_t count = pack_size(fs, revision);
+      svn_revnum_t count = svn_fs_fs__pack_size(fs, revision);
       svn_revnum_t pack_start = svn_fs_fs__packed_base_rev(fs, revision);
       svn_revnum_t pack_end = pack_start + count;
 
@@ -855,16 +1022,15 @@ verify_f7_metadata_consistency(svn_fs_t *fs,
       if (err)
         {
           svn_error_t *err2
-            = svn_fs_fs__read_min_unpacked_rev(&ffd->min_unpacked_rev,
-                                               fs, pool);
+            = svn_fs_fs__update_min_unpacked_rev(fs, pool);
 
           /* Be careful to not leak ERR. */
           if (err2)
             return svn_error_trace(svn_error_compose_create(err, err2));
         }
 
-      /* retry the whole shard if it got packed in the meantime */
-      if (err && count != pack_size(fs, revision))
+      /* retry the whole shard if it got packed or staged in the meantime */
+      if (err && count != svn_fs_fs__pack_size(fs, revision))
         {
           svn_error_clear(err);
 
@@ -884,6 +1050,214 @@ verify_f7_metadata_consistency(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+#if APR_HAS_THREADS
+
+/* State shared by all worker threads verifying pack units concurrently. */
+typedef struct verify_workers_t
+{
+  /* Filesystem instances (svn_fs_t *) not currently used by any worker.
+   * Each one lives in its own root pool. */
+  apr_array_header_t *idle_fs;
+
+  /* Serializes access to IDLE_FS. */
+  svn_mutex__t *mutex;
+
+  /* Non-zero if the workers shall stop as soon as possible. */
+  svn_atomic_t cancelled;
+} verify_workers_t;
+
+/* A range of revisions to be verified by one of the worker threads. */
+typedef struct verify_task_t
+{
+  /* First revision to verify. */
+  svn_revnum_t start;
+
+  /* Last revision to verify. */
+  svn_revnum_t end;
+} verify_task_t;
+
+/* Implements svn_cancel_func_t.  BATON is a verify_workers_t *. */
+static svn_error_t *
+check_workers_cancelled(void *baton)
+{
+  verify_workers_t *workers = baton;
+
+  if (svn_atomic_read(&workers->cancelled))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove an idle filesystem instance from WORKERS and return it in *FS. */
+static svn_error_t *
+take_idle_fs(svn_fs_t **fs,
+             verify_workers_t *workers)
+{
+  svn_fs_t **entry = apr_array_pop(workers->idle_fs);
+  SVN_ERR_ASSERT(entry);
+  *fs = *entry;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return FS to the list of idle filesystem instances in WORKERS. */
+static svn_error_t *
+release_idle_fs(verify_workers_t *workers,
+                svn_fs_t *fs)
+{
+  APR_ARRAY_PUSH(workers->idle_fs, svn_fs_t *) = fs;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  Verify the index and revprop
+ * consistency of the revision range given by the verify_task_t TASK using
+ * one of the filesystem instances in the verify_workers_t PROCESS_BATON. */
+static svn_error_t *
+verify_range_task(void **result,
+                  void *task,
+                  void *process_baton,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  verify_task_t *verify_task = task;
+  verify_workers_t *workers = process_baton;
+  svn_fs_t *fs;
+  svn_error_t *err;
+
+  /* Filesystem objects are not thread-safe.  Use one that no other thread
+   * is using right now. */
+  SVN_MUTEX__WITH_LOCK(workers->mutex, take_idle_fs(&fs, workers));
+
+  err = verify_f7_metadata_consistency(fs, verify_task->start,
+                                       verify_task->end, NULL, NULL,
+                                       check_workers_cancelled, workers,
+                                       scratch_pool);
+
+  SVN_MUTEX__WITH_LOCK(workers->mutex, release_idle_fs(workers, fs));
+
+  *result = NULL;
+
+  return svn_error_trace(err);
+}
+
+/* Push a task for verifying revisions START to END into QUEUE. */
+static svn_error_t *
+push_range_task(svn_task__queue_t *queue,
+                svn_revnum_t start,
+                svn_revnum_t end)
+{
+  apr_pool_t *task_pool = svn_pool_create(NULL);
+  verify_task_t *task = apr_pcalloc(task_pool, sizeof(*task));
+
+  task->start = start;
+  task->end = end;
+
+  return svn_error_trace(svn_task__queue_push(queue, task, task_pool));
+}
+
+/* Like verify_f7_metadata_consistency but check the pack units, i.e.
+ * shards, stages and non-packed revisions, on THREAD_COUNT threads.
+ * Errors and progress get reported in revision order.
+ *
+ * Only the calling thread will invoke NOTIFY_FUNC and CANCEL_FUNC. */
+static svn_error_t *
+verify_f7_metadata_concurrently(svn_fs_t *fs,
+                                svn_revnum_t start,
+                                svn_revnum_t end,
+                                int thread_count,
+                                svn_fs_progress_notify_func_t notify_func,
+                                void *notify_baton,
+                                svn_cancel_func_t cancel_func,
+                                void *cancel_baton,
+                                apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *queue_pool = svn_pool_create(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  verify_workers_t *workers = apr_pcalloc(pool, sizeof(*workers));
+  svn_task__queue_t *queue = NULL;
+  svn_revnum_t next_revision = start;
+  int max_pending = 2 * thread_count;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  workers->idle_fs = apr_array_make(pool, thread_count, sizeof(svn_fs_t *));
+  SVN_ERR(svn_mutex__init(&workers->mutex, TRUE, pool));
+
+  /* Each worker gets its own filesystem instance. */
+  for (i = 0; i < thread_count && !err; ++i)
+    {
+      apr_pool_t *fs_pool = svn_pool_create(NULL);
+      svn_fs_t *clone;
+
+      err = svn_fs_fs__open_clone(&clone, fs, fs_pool, iterpool);
+      if (err)
+        svn_pool_destroy(fs_pool);
+      else
+        APR_ARRAY_PUSH(workers->idle_fs, svn_fs_t *) = clone;
+    }
+
+  if (!err)
+    err = svn_task__queue_create(&queue, thread_count, 0, verify_range_task,
+                                 workers, queue_pool);
+
+  while (!err && (next_revision <= end || svn_task__queue_size(queue)))
+    {
+      apr_pool_t *task_pool = NULL;
+      verify_task_t *task;
+      void *result;
+
+      svn_pool_clear(iterpool);
+
+      /* Keep the workers busy but don't run too far ahead of the range
+       * to report next.  Each task covers one pack unit. */
+      while (   !err
+             && next_revision <= end
+             && svn_task__queue_size(queue) < max_pending)
+        {
+          svn_revnum_t pack_end = svn_fs_fs__packed_base_rev(fs, next_revision)
+                                + svn_fs_fs__pack_size(fs, next_revision);
+          svn_revnum_t last = MIN(pack_end - 1, end);
+
+          err = push_range_task(queue, next_revision, last);
+          next_revision = last + 1;
+        }
+
+      if (!err && cancel_func)
+        err = cancel_func(cancel_baton);
+
+      if (!err)
+        err = svn_task__queue_pop(&result, (void **)&task, &task_pool, queue);
+
+      if (!err && notify_func)
+        {
+          svn_revnum_t pack_start = svn_fs_fs__packed_base_rev(fs,
+                                                               task->start);
+          if (pack_start % ffd->max_files_per_dir == 0)
+            notify_func(pack_start, notify_baton, iterpool);
+        }
+
+      if (task_pool)
+        svn_pool_destroy(task_pool);
+    }
+
+  /* Stop all workers and wait for them to finish. */
+  svn_atomic_set(&workers->cancelled, TRUE);
+  if (queue)
+    svn_error_clear(svn_task__queue_shutdown(queue));
+  svn_pool_destroy(queue_pool);
+
+  for (i = 0; i < workers->idle_fs->nelts; ++i)
+    svn_pool_destroy(APR_ARRAY_IDX(workers->idle_fs, i, svn_fs_t *)->pool);
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+#endif
+
 svn_error_t *
 svn_fs_fs__verify(svn_fs_t *fs,
                   svn_revnum_t start,
@@ -895,6 +1269,7 @@ svn_fs_fs__verify(svn_fs_t *fs,
                   apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
+  int thread_count;
 
   /* Input validation. */
   if (! SVN_IS_VALID_REVNUM(start))
@@ -907,8 +1282,23 @@ svn_fs_fs__verify(svn_fs_t *fs,
   SVN_ERR(svn_fs_fs__ensure_revision_exists(start, fs, pool));
   SVN_ERR(svn_fs_fs__ensure_revision_exists(end, fs, pool));
 
+  SVN_ERR(svn_cstring_atoi(&thread_count,
+                           svn_hash__get_cstring(
+                             fs->config, SVN_FS_CONFIG_FSFS_VERIFY_JOBS,
+                             "1")));
+
   /* log/phys index consistency.  We need to check them first to make
      sure we can access the rev / pack files in format7. */
+#if APR_HAS_THREADS
+  if (   svn_fs_fs__use_log_addressing(fs)
+      && thread_count > 1
+      && svn_cache__global_membuffer_cache_is_thread_safe())
+    SVN_ERR(verify_f7_metadata_concurrently(fs, start, end, thread_count,
+                                            notify_func, notify_baton,
+                                            cancel_func, cancel_baton,
+                                            pool));
+  else
+#endif
   if (svn_fs_fs__use_log_addressing(fs))
     SVN_ERR(verify_f7_metadata_consistency(fs, start, end,
                                            notify_func, notify_baton,
@@ -921,3 +1311,210 @@ svn_fs_fs__verify(svn_fs_t *fs,
 
   return SVN_NO_ERROR;
 }
+
+/* Append the textual representation of CHECKPOINT to BUFFER. */
+static void
+unparse_checkpoint(svn_stringbuf_t *buffer,
+                   const verify_checkpoint_t *checkpoint)
+{
+  apr_pool_t *pool = buffer->pool;
+
+  svn_stringbuf_appendcstr(buffer,
+      apr_psprintf(pool,
+                   "%ld %ld %s %s %" SVN_FILESIZE_T_FMT
+                   " %" APR_TIME_T_FMT "\n",
+                   checkpoint->start, checkpoint->count,
+                   svn_checksum_to_cstring_display(checkpoint->l2p_checksum,
+                                                   pool),
+                   svn_checksum_to_cstring_display(checkpoint->p2l_checksum,
+                                                   pool),
+                   checkpoint->size, checkpoint->mtime));
+}
+
+/* Return an error if FS does not support verification checkpoints. */
+static svn_error_t *
+check_verify_checkpoints_supported(svn_fs_t *fs)
+{
+  /* The checkpoints identify the pack units by their index checksums. */
+  if (!svn_fs_fs__use_log_addressing(fs))
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("Verification checkpoints require logical "
+                              "addressing"));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_verify_checkpoints(apr_array_header_t **units,
+                                  svn_fs_t *fs,
+                                  svn_revnum_t start,
+                                  svn_revnum_t end,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
+{
+  apr_hash_t *checkpoints;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t revision, next_revision;
+
+  SVN_ERR(check_verify_checkpoints_supported(fs));
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(start, fs, scratch_pool));
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(end, fs, scratch_pool));
+  SVN_ERR(svn_fs_fs__update_min_unpacked_rev(fs, scratch_pool));
+  SVN_ERR(read_checkpoints(&checkpoints, fs, scratch_pool, scratch_pool));
+
+  *units = apr_array_make(result_pool, 16,
+                          sizeof(svn_fs_fs__verify_unit_t *));
+  for (revision = start; revision <= end; revision = next_revision)
+    {
+      svn_revnum_t pack_start = svn_fs_fs__packed_base_rev(fs, revision);
+      svn_revnum_t count = svn_fs_fs__pack_size(fs, revision);
+      verify_checkpoint_t *known = apr_hash_get(checkpoints, &pack_start,
+                                                sizeof(pack_start));
+      svn_fs_fs__verify_unit_t *unit = apr_pcalloc(result_pool,
+                                                   sizeof(*unit));
+
+      svn_pool_clear(iterpool);
+      next_revision = pack_start + count;
+
+      unit->start = revision;
+      unit->end = next_revision - 1 < end ? next_revision - 1 : end;
+      if (known)
+        {
+          verify_checkpoint_t *checkpoint;
+          svn_error_t *err = get_checkpoint(&checkpoint, fs, pack_start,
+                                            count, iterpool, iterpool);
+
+          /* Leave it to the verification to report broken files. */
+          unit->verified = !err && checkpoints_match(known, checkpoint);
+          svn_error_clear(err);
+        }
+
+      APR_ARRAY_PUSH(*units, svn_fs_fs__verify_unit_t *) = unit;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__add_verify_checkpoints(svn_fs_t *fs,
+                                  svn_revnum_t start,
+                                  svn_revnum_t end,
+                                  apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *lines = svn_stringbuf_create_empty(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t revision, next_revision;
+  apr_file_t *file;
+
+  SVN_ERR(check_verify_checkpoints_supported(fs));
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(end, fs, scratch_pool));
+  SVN_ERR(svn_fs_fs__update_min_unpacked_rev(fs, scratch_pool));
+
+  for (revision = start; revision <= end; revision = next_revision)
+    {
+      svn_revnum_t pack_start = svn_fs_fs__packed_base_rev(fs, revision);
+      svn_revnum_t count = svn_fs_fs__pack_size(fs, revision);
+      verify_checkpoint_t *checkpoint;
+
+      svn_pool_clear(iterpool);
+      next_revision = pack_start + count;
+
+      /* Only record pack units that got verified completely. */
+      if (pack_start < start || next_revision - 1 > end)
+        continue;
+
+      SVN_ERR(get_checkpoint(&checkpoint, fs, pack_start, count,
+                             iterpool, iterpool));
+      unparse_checkpoint(lines, checkpoint);
+    }
+
+  svn_pool_destroy(iterpool);
+  if (svn_stringbuf_isempty(lines))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_fs_fs__path_verify_checkpoints(fs,
+                                                              scratch_pool),
+                           APR_WRITE | APR_CREATE | APR_APPEND,
+                           APR_OS_DEFAULT, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(file, lines->data, lines->len, NULL,
+                                 scratch_pool));
+
+  return svn_error_trace(svn_io_file_close(file, scratch_pool));
+}
+
+/* Implements the comparison function of svn_sort__array() for arrays of
+ * verify_checkpoint_t *.  Orders by first revision. */
+static int
+compare_checkpoints(const void *lhs,
+                    const void *rhs)
+{
+  const verify_checkpoint_t *lhs_checkpoint
+    = *(const verify_checkpoint_t * const *)lhs;
+  const verify_checkpoint_t *rhs_checkpoint
+    = *(const verify_checkpoint_t * const *)rhs;
+
+  if (lhs_checkpoint->start < rhs_checkpoint->start)
+    return -1;
+
+  return lhs_checkpoint->start > rhs_checkpoint->start ? 1 : 0;
+}
+
+svn_error_t *
+svn_fs_fs__compact_verify_checkpoints(svn_fs_t *fs,
+                                      apr_pool_t *scratch_pool)
+{
+  apr_hash_t *checkpoints;
+  apr_array_header_t *sorted;
+  svn_stringbuf_t *lines = svn_stringbuf_create_empty(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  const char *path = svn_fs_fs__path_verify_checkpoints(fs, scratch_pool);
+  svn_revnum_t youngest;
+  apr_hash_index_t *hi;
+  int i;
+
+  SVN_ERR(check_verify_checkpoints_supported(fs));
+  SVN_ERR(svn_fs_fs__youngest_rev(&youngest, fs, scratch_pool));
+  SVN_ERR(svn_fs_fs__update_min_unpacked_rev(fs, scratch_pool));
+  SVN_ERR(read_checkpoints(&checkpoints, fs, scratch_pool, scratch_pool));
+
+  sorted = apr_array_make(scratch_pool, apr_hash_count(checkpoints),
+                          sizeof(verify_checkpoint_t *));
+  for (hi = apr_hash_first(scratch_pool, checkpoints);
+       hi;
+       hi = apr_hash_next(hi))
+    APR_ARRAY_PUSH(sorted, verify_checkpoint_t *) = apr_hash_this_val(hi);
+  svn_sort__array(sorted, compare_checkpoints);
+
+  /* Drop records of pack units that have been modified, packed or
+   * removed since. */
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      verify_checkpoint_t *known = APR_ARRAY_IDX(sorted, i,
+                                                 verify_checkpoint_t *);
+      verify_checkpoint_t *checkpoint;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+      if (   known->start + known->count - 1 > youngest
+          || svn_fs_fs__packed_base_rev(fs, known->start) != known->start
+          || svn_fs_fs__pack_size(fs, known->start) != known->count)
+        continue;
+
+      err = get_checkpoint(&checkpoint, fs, known->start, known->count,
+                           iterpool, iterpool);
+      if (!err && checkpoints_match(known, checkpoint))
+        unparse_checkpoint(lines, known);
+      svn_error_clear(err);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  if (svn_stringbuf_isempty(lines))
+    return svn_error_trace(svn_io_remove_file2(path, TRUE, scratch_pool));
+
+  return svn_error_trace(svn_io_write_atomic2(path, lines->data, lines->len,
+                                              NULL, FALSE, scratch_pool));
+}
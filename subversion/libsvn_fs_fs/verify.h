@@ -39,4 +39,37 @@ svn_error_t *svn_fs_fs__verify(svn_fs_t *fs,
                                void *cancel_baton,
                                apr_pool_t *pool);
 
+/* Set *UNITS to the pack units of FS that intersect with the revision
+ * range START to END, as an array of svn_fs_fs__verify_unit_t * in
+ * revision order.  The ranges given in the units will be limited to
+ * START and END.  A unit counts as verified if its current state matches
+ * a checkpoint added through svn_fs_fs__add_verify_checkpoints().  Only
+ * supported for repositories using logical addressing.  Allocate the
+ * result in RESULT_POOL and use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__get_verify_checkpoints(apr_array_header_t **units,
+                                  svn_fs_t *fs,
+                                  svn_revnum_t start,
+                                  svn_revnum_t end,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool);
+
+/* Record the current state of all pack units of FS that lie completely
+ * within the revision range START to END as having passed verification.
+ * The records are appended to db/verify-checkpoints.  Use SCRATCH_POOL
+ * for temporary allocations. */
+svn_error_t *
+svn_fs_fs__add_verify_checkpoints(svn_fs_t *fs,
+                                  svn_revnum_t start,
+                                  svn_revnum_t end,
+                                  apr_pool_t *scratch_pool);
+
+/* Rewrite db/verify-checkpoints of FS such that it only contains the
+ * latest record of each pack unit and only if that still matches the
+ * pack unit's current state.  Use SCRATCH_POOL for temporary
+ * allocations. */
+svn_error_t *
+svn_fs_fs__compact_verify_checkpoints(svn_fs_t *fs,
+                                      apr_pool_t *scratch_pool);
+
 #endif
@@ -1883,11 +1883,16 @@ negotiate_put_encoding(int *svndiff_version_p,
        * Note: For future compatibility, we also handle a theoretically
        * possible case where the server has advertised only svndiff2 support.
        */
-      if (session->supports_svndiff2 &&
+      if (session->supports_svndiff3 &&
           svn_ra_serf__is_low_latency_connection(session))
+        svndiff_version = 3;
+      else if (session->supports_svndiff2 &&
+               svn_ra_serf__is_low_latency_connection(session))
         svndiff_version = 2;
       else if (session->supports_svndiff1)
         svndiff_version = 1;
+      else if (session->supports_svndiff3)
+        svndiff_version = 3;
       else if (session->supports_svndiff2)
         svndiff_version = 2;
       else
@@ -1905,6 +1910,8 @@ negotiate_put_encoding(int *svndiff_version_p,
        */
       if (session->supports_svndiff1)
         svndiff_version = 1;
+      else if (session->supports_svndiff3)
+        svndiff_version = 3;
       else if (session->supports_svndiff2)
         svndiff_version = 2;
       else
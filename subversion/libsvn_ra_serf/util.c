@@ -2056,24 +2056,27 @@ svn_ra_serf__setup_svndiff_accept_encoding(serf_bucket_t *headers,
   else if (session->using_compression == svn_tristate_unknown &&
            svn_ra_serf__is_low_latency_connection(session))
     {
-      /* With http-compression=auto, advertise that we prefer svndiff2
-         to svndiff1 with a low latency connection (assuming the underlying
-         network has high bandwidth), as it is faster and in this case, we
-         don't care about worse compression ratio. */
+      /* With http-compression=auto, advertise that we prefer svndiff3
+         and svndiff2 to svndiff1 with a low latency connection (assuming
+         the underlying network has high bandwidth), as they are faster and
+         in this case, we don't care about worse compression ratio.
+         svndiff3 compresses like svndiff2 but encodes instructions more
+         compactly. */
       serf_bucket_headers_setn(
         headers, "Accept-Encoding",
-        "gzip,svndiff2;q=0.9,svndiff1;q=0.8,svndiff;q=0.7");
+        "gzip,svndiff3;q=0.9,svndiff2;q=0.85,svndiff1;q=0.8,svndiff;q=0.7");
     }
   else
     {
-      /* Otherwise, advertise that we prefer svndiff1 over svndiff2.
+      /* Otherwise, advertise that we prefer svndiff1 over svndiff3/2.
          svndiff2 is not a reasonable substitute for svndiff1 with default
          compression level, because, while it is faster, it also gives worse
          compression ratio.  While we can use svndiff2 in some cases (see
-         above), we can't do this generally. */
+         above), we can't do this generally.  The same applies to svndiff3,
+         which uses the same compression. */
       serf_bucket_headers_setn(
         headers, "Accept-Encoding",
-        "gzip,svndiff1;q=0.9,svndiff2;q=0.8,svndiff;q=0.7");
+        "gzip,svndiff1;q=0.9,svndiff3;q=0.85,svndiff2;q=0.8,svndiff;q=0.7");
     }
 }
 
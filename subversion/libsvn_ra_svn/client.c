@@ -73,6 +73,9 @@
 #define DEPTH_TO_RECURSE(d)    \
         ((d) == svn_depth_unknown || (d) > svn_depth_files)
 
+/* Upper limit for the number of connections used by a single update. */
+#define MAX_FETCH_CONNECTIONS 8
+
 typedef struct ra_svn_commit_callback_baton_t {
   svn_ra_svn__session_baton_t *sess_baton;
   apr_pool_t *pool;
@@ -87,6 +90,13 @@ typedef struct ra_svn_reporter_baton_t {
   apr_pool_t *pool;
   const svn_delta_editor_t *editor;
   void *edit_baton;
+
+  /* Anchor-relative path of the operation's target. */
+  const char *target;
+
+  /* If not NULL, record the repository-relative path of each linked path
+     here, keyed by its anchor-relative path. */
+  apr_hash_t *links;
 } ra_svn_reporter_baton_t;
 
 /* Parse an svn URL's tunnel portion into tunnel, if there is a tunnel
@@ -249,6 +259,17 @@ static svn_error_t *handle_auth_request(svn_ra_svn__session_baton_t *sess,
   SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "lc", &mechlist, &realm));
   if (mechlist->nelts == 0)
     return SVN_NO_ERROR;
+
+  /* Don't ask for credentials on worker threads.  The server keeps
+     waiting for them, so the session is unusable from now on. */
+  if (sess->defer_auth)
+    {
+      sess->auth_deferred = TRUE;
+      return svn_error_create(SVN_ERR_RA_NOT_AUTHORIZED, NULL,
+                              _("Authentication is not possible on this "
+                                "connection"));
+    }
+
   return DO_AUTH(sess, mechlist, realm, pool);
 }
 
@@ -289,6 +310,18 @@ static svn_error_t *ra_svn_link_path(void *baton, const char *path,
 
   SVN_ERR(svn_ra_svn__write_cmd_link_path(b->conn, pool, path, url, rev,
                                           start_empty, lock_token, depth));
+
+  if (b->links)
+    {
+      const char *repos_relpath
+        = svn_uri_skip_ancestor(b->conn->repos_root, url, b->pool);
+
+      if (repos_relpath)
+        svn_hash_sets(b->links,
+                      svn_relpath_join(b->target, path, b->pool),
+                      repos_relpath);
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -323,7 +356,9 @@ static svn_ra_reporter3_t ra_svn_reporter = {
 };
 
 /* Set *REPORTER and *REPORT_BATON to a new reporter which will drive
- * EDITOR/EDIT_BATON when it gets the finish_report() call.
+ * EDITOR/EDIT_BATON when it gets the finish_report() call.  If LINKS
+ * is not NULL, record the targets of linked paths in it as described
+ * for svn_ra_svn__get_fetch_editor().
  *
  * Allocate the new reporter in POOL.
  */
@@ -334,6 +369,7 @@ ra_svn_get_reporter(svn_ra_svn__session_baton_t *sess_baton,
                     void *edit_baton,
                     const char *target,
                     svn_depth_t depth,
+                    apr_hash_t *links,
                     const svn_ra_reporter3_t **reporter,
                     void **report_baton)
 {
@@ -362,6 +398,8 @@ ra_svn_get_reporter(svn_ra_svn__session_baton_t *sess_baton,
   b->pool = pool;
   b->editor = editor;
   b->edit_baton = edit_baton;
+  b->target = target;
+  b->links = links;
 
   *reporter = &ra_svn_reporter;
   *report_baton = b;
@@ -604,6 +642,49 @@ static apr_status_t close_tunnel_cleanup(void *baton)
   return APR_SUCCESS; /* ignored */
 }
 
+/* Set *CAPABILITY to the whole-stream compression capability that we shall
+   select on CONN, or to NULL if we shall not compress the data stream.
+   Take the preference from the servers section of CONFIG, honoring the
+   server group in AUTH_BATON. */
+static svn_error_t *
+choose_compression(const char **capability,
+                   svn_ra_svn_conn_t *conn,
+                   apr_hash_t *config,
+                   svn_auth_baton_t *auth_baton)
+{
+  svn_config_t *cfg;
+  const char *server_group;
+  const char *method;
+
+  cfg = config ? svn_hash_gets(config, SVN_CONFIG_CATEGORY_SERVERS) : NULL;
+  svn_config_get(cfg, &method, SVN_CONFIG_SECTION_GLOBAL,
+                 SVN_CONFIG_OPTION_SVN_COMPRESSION, "no");
+
+  server_group = svn_auth_get_parameter(auth_baton,
+                                        SVN_AUTH_PARAM_SERVER_GROUP);
+  if (server_group)
+    svn_config_get(cfg, &method, server_group,
+                   SVN_CONFIG_OPTION_SVN_COMPRESSION, method);
+
+  if (svn_cstring_casecmp(method, "lz4") == 0)
+    *capability = SVN_RA_SVN_CAP_COMPRESS_LZ4;
+  else if (svn_cstring_casecmp(method, "zlib") == 0)
+    *capability = SVN_RA_SVN_CAP_COMPRESS_ZLIB;
+  else if (svn_cstring_casecmp(method, "no") == 0)
+    *capability = NULL;
+  else
+    return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                             _("Invalid config: unknown %s '%s'"),
+                             SVN_CONFIG_OPTION_SVN_COMPRESSION, method);
+
+  /* Older servers and servers that don't want any compression don't
+     offer it. */
+  if (*capability && !svn_ra_svn_has_capability(conn, *capability))
+    *capability = NULL;
+
+  return SVN_NO_ERROR;
+}
+
 /* Open a session to URL, returning it in *SESS_P, allocating it in POOL.
    URI is a parsed version of URL.  CALLBACKS and CALLBACKS_BATON
    are provided by the caller of ra_svn_open. If TUNNEL_NAME is not NULL,
@@ -629,6 +710,7 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
   apr_uint64_t minver, maxver;
   svn_ra_svn__list_t *mechlist, *server_caplist, *repos_caplist;
   const char *client_string = NULL;
+  const char *compression;
   apr_pool_t *pool = result_pool;
   svn_ra_svn__parent_t *parent;
 
@@ -649,6 +731,9 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
   sess->callbacks_baton = callbacks_baton;
   sess->bytes_read = sess->bytes_written = 0;
   sess->auth_baton = auth_baton;
+  sess->fetch_sessions = NULL;
+  sess->defer_auth = FALSE;
+  sess->auth_deferred = FALSE;
 
   if (config)
     SVN_ERR(svn_config_copy_config(&sess->config, config, pool));
@@ -743,19 +828,23 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
     return svn_error_create(SVN_ERR_RA_SVN_BAD_VERSION, NULL,
                             _("Server does not support edit pipelining"));
 
+  SVN_ERR(choose_compression(&compression, conn, config, auth_baton));
+
   /* In protocol version 2, we send back our protocol version, our
    * capability list, and the URL, and subsequently there is an auth
    * request. */
   /* Client-side capabilities list: */
-  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwwww)cc(?c)",
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwwwww?w)cc(?c)",
                                   (apr_uint64_t) 2,
                                   SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                   SVN_RA_SVN_CAP_SVNDIFF1,
                                   SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED,
+                                  SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED,
                                   SVN_RA_SVN_CAP_ABSENT_ENTRIES,
                                   SVN_RA_SVN_CAP_DEPTH,
                                   SVN_RA_SVN_CAP_MERGEINFO,
                                   SVN_RA_SVN_CAP_LOG_REVPROPS,
+                                  compression,
                                   url,
                                   SVN_RA_SVN__DEFAULT_USERAGENT,
                                   client_string));
@@ -771,6 +860,13 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
   if (repos_caplist)
     SVN_ERR(svn_ra_svn__set_capabilities(conn, repos_caplist));
 
+  /* The server switches to the compression that we selected right after
+     this response. */
+  if (compression)
+    SVN_ERR(svn_ra_svn__enable_compression(
+              conn, strcmp(compression, SVN_RA_SVN_CAP_COMPRESS_LZ4) == 0,
+              pool));
+
   if (conn->repos_root)
     {
       conn->repos_root = svn_uri_canonicalize(conn->repos_root, pool);
@@ -1436,13 +1532,15 @@ parse_iproplist(apr_array_header_t **inherited_props,
   return SVN_NO_ERROR;
 }
 
-static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
-                                    svn_revnum_t rev, svn_stream_t *stream,
-                                    svn_revnum_t *fetched_rev,
-                                    apr_hash_t **props,
-                                    apr_pool_t *pool)
+svn_error_t *
+svn_ra_svn__get_file(svn_ra_svn__session_baton_t *sess_baton,
+                     const char *path,
+                     svn_revnum_t rev,
+                     svn_stream_t *stream,
+                     svn_revnum_t *fetched_rev,
+                     apr_hash_t **props,
+                     apr_pool_t *pool)
 {
-  svn_ra_svn__session_baton_t *sess_baton = session->priv;
   svn_ra_svn_conn_t *conn = sess_baton->conn;
   svn_ra_svn__list_t *proplist;
   const char *expected_digest;
@@ -1450,7 +1548,6 @@ static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
   svn_checksum_ctx_t *checksum_ctx;
   apr_pool_t *iterpool;
 
-  path = reparent_path(session, path, pool);
   SVN_ERR(svn_ra_svn__write_cmd_get_file(conn, pool, path, rev,
                                          (props != NULL), (stream != NULL)));
   SVN_ERR(handle_auth_request(sess_baton, pool));
@@ -1513,6 +1610,19 @@ static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
+                                    svn_revnum_t rev, svn_stream_t *stream,
+                                    svn_revnum_t *fetched_rev,
+                                    apr_hash_t **props,
+                                    apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+
+  path = reparent_path(session, path, pool);
+  return svn_error_trace(svn_ra_svn__get_file(sess_baton, path, rev, stream,
+                                              fetched_rev, props, pool));
+}
+
 /* Write the protocol words that correspond to DIRENT_FIELDS to CONN
  * and use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
@@ -1706,6 +1816,129 @@ static svn_error_t *ra_svn_get_mergeinfo(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+/* Set *MAX_CONNECTIONS to the number of connections that updates over
+ * SESS may use to fetch file contents, counting SESS itself, as configured
+ * by the svn-max-connections option.  Set it to 1 if SESS can't fetch
+ * file contents in parallel.
+ */
+static svn_error_t *
+get_max_fetch_connections(int *max_connections,
+                          svn_ra_svn__session_baton_t *sess)
+{
+#if APR_HAS_THREADS
+  svn_config_t *cfg;
+  const char *server_group;
+  apr_int64_t val;
+#endif
+
+  *max_connections = 1;
+
+#if APR_HAS_THREADS
+  /* Tunnels may ask for credentials each time they get opened. */
+  if (sess->is_tunneled || !sess->conn->repos_root
+      || !svn_ra_svn_has_capability(sess->conn, SVN_RA_SVN_CAP_FETCH_TEXTS))
+    return SVN_NO_ERROR;
+
+  cfg = sess->config ? svn_hash_gets(sess->config,
+                                     SVN_CONFIG_CATEGORY_SERVERS)
+                     : NULL;
+  SVN_ERR(svn_config_get_int64(cfg, &val,
+                               SVN_CONFIG_SECTION_GLOBAL,
+                               SVN_CONFIG_OPTION_SVN_MAX_CONNECTIONS,
+                               SVN_CONFIG_DEFAULT_OPTION_SVN_MAX_CONNECTIONS));
+
+  server_group = svn_auth_get_parameter(sess->auth_baton,
+                                        SVN_AUTH_PARAM_SERVER_GROUP);
+  if (server_group)
+    SVN_ERR(svn_config_get_int64(cfg, &val, server_group,
+                                 SVN_CONFIG_OPTION_SVN_MAX_CONNECTIONS,
+                                 val));
+
+  if (val > MAX_FETCH_CONNECTIONS)
+    *max_connections = MAX_FETCH_CONNECTIONS;
+  else if (val > 1)
+    *max_connections = (int)val;
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_svn__open_fetch_session(svn_ra_svn__session_baton_t **fetch_sess,
+                               svn_ra_svn__session_baton_t *sess,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  svn_ra_callbacks2_t *callbacks;
+  apr_uri_t uri;
+
+  /* Fetch sessions may get used on worker threads, which must not invoke
+     the progress callback. */
+  callbacks = apr_pmemdup(result_pool, sess->callbacks, sizeof(*callbacks));
+  callbacks->progress_func = NULL;
+
+  SVN_ERR(parse_url(sess->conn->repos_root, &uri, scratch_pool));
+
+  return svn_error_trace(open_session(fetch_sess, sess->conn->repos_root,
+                                      &uri, NULL, NULL, sess->config,
+                                      callbacks, sess->callbacks_baton,
+                                      sess->auth_baton,
+                                      result_pool, scratch_pool));
+}
+
+svn_error_t *
+svn_ra_svn__ensure_fetch_sessions(svn_ra_svn__session_baton_t *sess,
+                                  apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *fetch_sessions;
+  int max_connections;
+  int i;
+
+  SVN_ERR(get_max_fetch_connections(&max_connections, sess));
+
+  /* Keep the sessions that are still usable. */
+  fetch_sessions = apr_array_make(sess->pool, max_connections,
+                                  sizeof(svn_ra_svn__session_baton_t *));
+  for (i = 0; sess->fetch_sessions && i < sess->fetch_sessions->nelts; i++)
+    {
+      svn_ra_svn__session_baton_t *fetch_sess
+        = APR_ARRAY_IDX(sess->fetch_sessions, i,
+                        svn_ra_svn__session_baton_t *);
+
+      if (fetch_sess->auth_deferred)
+        svn_pool_destroy(fetch_sess->pool);
+      else
+        APR_ARRAY_PUSH(fetch_sessions, svn_ra_svn__session_baton_t *)
+          = fetch_sess;
+    }
+  sess->fetch_sessions = fetch_sessions;
+
+  /* SESS itself counts as one of the connections. */
+  while (fetch_sessions->nelts < max_connections - 1)
+    {
+      apr_pool_t *fetch_pool = svn_pool_create(sess->pool);
+      svn_ra_svn__session_baton_t *fetch_sess;
+      svn_error_t *err;
+
+      err = svn_ra_svn__open_fetch_session(&fetch_sess, sess, fetch_pool,
+                                           scratch_pool);
+
+      /* Make do with the connections that the server accepts. */
+      if (err)
+        {
+          svn_error_clear(err);
+          svn_pool_destroy(fetch_pool);
+          break;
+        }
+
+      fetch_sess->defer_auth = TRUE;
+      APR_ARRAY_PUSH(fetch_sessions, svn_ra_svn__session_baton_t *)
+        = fetch_sess;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *ra_svn_update(svn_ra_session_t *session,
                                   const svn_ra_reporter3_t **reporter,
                                   void **report_baton, svn_revnum_t rev,
@@ -1720,20 +1953,39 @@ static svn_error_t *ra_svn_update(svn_ra_session_t *session,
   svn_ra_svn__session_baton_t *sess_baton = session->priv;
   svn_ra_svn_conn_t *conn = sess_baton->conn;
   svn_boolean_t recurse = DEPTH_TO_RECURSE(depth);
+  const char *anchor_relpath = NULL;
+  apr_hash_t *links = NULL;
+  int max_connections;
 
   /* Callbacks may assume that all data is relative the sessions's URL. */
   SVN_ERR(ensure_exact_server_parent(session, scratch_pool));
 
+  /* Let the server leave out the contents of added files and fetch them
+   * on auxiliary connections, which get opened once they are needed. */
+  SVN_ERR(get_max_fetch_connections(&max_connections, sess_baton));
+  if (max_connections > 1)
+    anchor_relpath = svn_uri_skip_ancestor(conn->repos_root,
+                                           sess_baton->parent->client_url->data,
+                                           pool);
+  if (anchor_relpath)
+    {
+      links = apr_hash_make(pool);
+      SVN_ERR(svn_ra_svn__get_fetch_editor(&update_editor, &update_baton,
+                                           update_editor, update_baton,
+                                           sess_baton, anchor_relpath, links,
+                                           pool));
+    }
+
   /* Tell the server we want to start an update. */
   SVN_ERR(svn_ra_svn__write_cmd_update(conn, pool, rev, target, recurse,
                                        depth, send_copyfrom_args,
-                                       ignore_ancestry));
+                                       ignore_ancestry, links == NULL));
   SVN_ERR(handle_auth_request(sess_baton, pool));
 
   /* Fetch a reporter for the caller to drive.  The reporter will drive
    * update_editor upon finish_report(). */
   SVN_ERR(ra_svn_get_reporter(sess_baton, pool, update_editor, update_baton,
-                              target, depth, reporter, report_baton));
+                              target, depth, links, reporter, report_baton));
   return SVN_NO_ERROR;
 }
 
@@ -1767,7 +2019,7 @@ ra_svn_switch(svn_ra_session_t *session,
   /* Fetch a reporter for the caller to drive.  The reporter will drive
    * update_editor upon finish_report(). */
   SVN_ERR(ra_svn_get_reporter(sess_baton, pool, update_editor, update_baton,
-                              target, depth, reporter, report_baton));
+                              target, depth, NULL, reporter, report_baton));
   return SVN_NO_ERROR;
 }
 
@@ -1794,7 +2046,7 @@ static svn_error_t *ra_svn_status(svn_ra_session_t *session,
   /* Fetch a reporter for the caller to drive.  The reporter will drive
    * status_editor upon finish_report(). */
   SVN_ERR(ra_svn_get_reporter(sess_baton, pool, status_editor, status_baton,
-                              target, depth, reporter, report_baton));
+                              target, depth, NULL, reporter, report_baton));
   return SVN_NO_ERROR;
 }
 
@@ -1825,7 +2077,7 @@ static svn_error_t *ra_svn_diff(svn_ra_session_t *session,
   /* Fetch a reporter for the caller to drive.  The reporter will drive
    * diff_editor upon finish_report(). */
   SVN_ERR(ra_svn_get_reporter(sess_baton, pool, diff_editor, diff_baton,
-                              target, depth, reporter, report_baton));
+                              target, depth, NULL, reporter, report_baton));
   return SVN_NO_ERROR;
 }
 
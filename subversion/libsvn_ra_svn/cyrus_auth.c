@@ -766,7 +766,9 @@ svn_error_t *svn_ra_svn__enable_sasl_encryption(svn_ra_svn_conn_t *conn,
               conn->read_end = conn->read_ptr;
             }
 
-          /* Wrap the existing stream. */
+          /* Wrap the existing stream.  If that one is already compressed,
+             i.e. this is a re-authentication within the session, the
+             security layer ends up on top of the compression layer. */
           sasl_baton->stream = conn->stream;
 
           {
@@ -62,6 +62,9 @@ typedef struct ra_svn_edit_baton_t {
   void *callback_baton;
   apr_uint64_t next_token;
   svn_boolean_t got_status;
+
+  /* Whether to leave out the texts of files without a delta base. */
+  svn_boolean_t omit_fulltexts;
 } ra_svn_edit_baton_t;
 
 /* Works for both directories and files. */
@@ -344,6 +347,17 @@ static svn_error_t *ra_svn_apply_textdelta(void *file_baton,
   SVN_ERR(svn_ra_svn__write_cmd_apply_textdelta(b->conn, pool, b->token,
                                                 base_checksum));
 
+  /* A delta against the empty stream is the whole text, which the other
+   * side fetches by itself.  Returning the no-op handler tells the
+   * driver not to produce any windows. */
+  if (b->eb->omit_fulltexts && !base_checksum)
+    {
+      SVN_ERR(svn_ra_svn__write_cmd_textdelta_end(b->conn, pool, b->token));
+      *wh = svn_delta_noop_window_handler;
+      *wh_baton = NULL;
+      return SVN_NO_ERROR;
+    }
+
   /* Transform the window stream to an svndiff stream.  Reuse the
    * file baton for the stream handler, since it has all the
    * needed information. */
@@ -429,11 +443,15 @@ static svn_error_t *ra_svn_abort_edit(void *edit_baton, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
-void svn_ra_svn_get_editor(const svn_delta_editor_t **editor,
-                           void **edit_baton, svn_ra_svn_conn_t *conn,
-                           apr_pool_t *pool,
-                           svn_ra_svn_edit_callback callback,
-                           void *callback_baton)
+/* Implement svn_ra_svn_get_editor() and
+ * svn_ra_svn__get_editor_without_fulltexts(), the latter if
+ * OMIT_FULLTEXTS is set. */
+static void get_editor(const svn_delta_editor_t **editor,
+                       void **edit_baton, svn_ra_svn_conn_t *conn,
+                       svn_boolean_t omit_fulltexts,
+                       apr_pool_t *pool,
+                       svn_ra_svn_edit_callback callback,
+                       void *callback_baton)
 {
   svn_delta_editor_t *ra_svn_editor = svn_delta_default_editor(pool);
   ra_svn_edit_baton_t *eb;
@@ -444,6 +462,7 @@ void svn_ra_svn_get_editor(const svn_delta_editor_t **editor,
   eb->callback_baton = callback_baton;
   eb->next_token = 0;
   eb->got_status = FALSE;
+  eb->omit_fulltexts = omit_fulltexts;
 
   ra_svn_editor->set_target_revision = ra_svn_target_rev;
   ra_svn_editor->open_root = ra_svn_open_root;
@@ -471,6 +490,25 @@ void svn_ra_svn_get_editor(const svn_delta_editor_t **editor,
                                            pool, pool));
 }
 
+void svn_ra_svn_get_editor(const svn_delta_editor_t **editor,
+                           void **edit_baton, svn_ra_svn_conn_t *conn,
+                           apr_pool_t *pool,
+                           svn_ra_svn_edit_callback callback,
+                           void *callback_baton)
+{
+  get_editor(editor, edit_baton, conn, FALSE, pool, callback,
+             callback_baton);
+}
+
+void
+svn_ra_svn__get_editor_without_fulltexts(const svn_delta_editor_t **editor,
+                                         void **edit_baton,
+                                         svn_ra_svn_conn_t *conn,
+                                         apr_pool_t *pool)
+{
+  get_editor(editor, edit_baton, conn, TRUE, pool, NULL, NULL);
+}
+
 /* --- DRIVING AN EDITOR --- */
 
 /* Store a token entry.  The token string will be copied into pool. */
@@ -0,0 +1,745 @@
+/*
+ * fetch.c :  Fetching file contents of an update on parallel connections
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include <apr_strings.h>
+
+#include "svn_hash.h"
+#include "svn_types.h"
+#include "svn_error.h"
+#include "svn_delta.h"
+#include "svn_dirent_uri.h"
+#include "svn_pools.h"
+#include "svn_private_config.h"
+
+#include "private/svn_mutex.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_task.h"
+
+#include "ra_svn.h"
+
+/*
+ * When the server supports it, an update may be run without the texts of
+ * added files, i.e. without text deltas against the empty stream.  The
+ * server then only tells us which files it added and we fetch their
+ * contents with get-file commands on a number of auxiliary connections,
+ * each one served by a worker thread.  Deltas against the previous
+ * contents of files still arrive with the edit.
+ *
+ * The editor in this file sits between the editor drive received from
+ * the server and the caller's update editor.  It passes all edits
+ * through, except that the apply_textdelta() and close_file() calls of
+ * added files are deferred until their contents have been fetched.
+ * Fetches complete in the order in which the files were closed by the
+ * server.  Directories are closed only after all their files, so the
+ * caller still sees a single, properly nested editor drive.
+ *
+ * The auxiliary connections are opened when the first text needs to be
+ * fetched.  Worker threads must not ask for credentials.  If the server
+ * wants a worker to authenticate, the worker gives up its connection and
+ * the text is fetched on the editor thread instead.
+ */
+
+/* Block size and maximum in-memory size of the buffers that hold the
+   fetched file contents until they are passed on to the editor. */
+#define FETCH_BLOCKSIZE 0x4000
+#define FETCH_MAXSIZE 0x100000
+
+/* Number of file contents per connection that may be fetched ahead of
+   the editor drive. */
+#define FETCH_PENDING_PER_CONNECTION 8
+
+/* The auxiliary connections, shared between the worker threads. */
+typedef struct fetch_sessions_t
+{
+  /* Serializes access to IDLE. */
+  svn_mutex__t *mutex;
+
+  /* svn_ra_svn__session_baton_t * that are currently not in use. */
+  apr_array_header_t *idle;
+} fetch_sessions_t;
+
+typedef struct fetch_edit_baton_t
+{
+  const svn_delta_editor_t *wrapped_editor;
+  void *wrapped_baton;
+
+  /* The session that receives the edit and the session that we use to
+     fetch texts on the editor thread, if opened already. */
+  svn_ra_svn__session_baton_t *sess;
+  svn_ra_svn__session_baton_t *main_fetch_sess;
+
+  /* Repository-relative path of the edit anchor. */
+  const char *anchor_relpath;
+
+  /* Maps anchor-relative paths to the repository-relative paths that the
+     edit brings them to, where those differ from their parent's. */
+  apr_hash_t *links;
+
+  /* The revision that the edit brings the tree to. */
+  svn_revnum_t revision;
+
+  /* Whether we tried to start the worker threads.  QUEUE is NULL if there
+     are none. */
+  svn_boolean_t started;
+  svn_task__queue_t *queue;
+  apr_pool_t *queue_pool;
+  int max_pending;
+
+  apr_pool_t *pool;
+} fetch_edit_baton_t;
+
+typedef struct fetch_dir_baton_t
+{
+  fetch_edit_baton_t *eb;
+  struct fetch_dir_baton_t *parent;
+  void *wrapped_baton;
+  const char *repos_relpath;
+
+  /* One for the directory itself until it has been closed by the server,
+     plus one for each child that has not been closed on the wrapped
+     editor, yet. */
+  int ref_count;
+
+  apr_pool_t *pool;
+} fetch_dir_baton_t;
+
+typedef struct fetch_file_baton_t
+{
+  fetch_edit_baton_t *eb;
+  fetch_dir_baton_t *parent;
+  void *wrapped_baton;
+  const char *repos_relpath;
+
+  /* Whether the server left out the text of the file, i.e. whether we
+     need to fetch the file contents. */
+  svn_boolean_t text_changed;
+  const char *text_checksum;
+
+  apr_pool_t *pool;
+} fetch_file_baton_t;
+
+/* A file whose contents to fetch.  The worker threads only use the first
+   two members. */
+typedef struct fetch_task_t
+{
+  const char *repos_relpath;
+  svn_revnum_t revision;
+  fetch_file_baton_t *fb;
+} fetch_task_t;
+
+
+/*** Worker threads ***/
+
+/* Remove an idle session from SESSIONS and return it in *SESS.  Set *SESS
+   to NULL if there is none, because sessions have been given up. */
+static svn_error_t *
+take_session(svn_ra_svn__session_baton_t **sess,
+             fetch_sessions_t *sessions)
+{
+  if (sessions->idle->nelts > 0)
+    *sess = *(svn_ra_svn__session_baton_t **)apr_array_pop(sessions->idle);
+  else
+    *sess = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return SESS to the idle sessions in SESSIONS. */
+static svn_error_t *
+return_session(fetch_sessions_t *sessions,
+               svn_ra_svn__session_baton_t *sess)
+{
+  APR_ARRAY_PUSH(sessions->idle, svn_ra_svn__session_baton_t *) = sess;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  Fetch the contents of the file
+   described by the fetch_task_t TASK on one of the fetch_sessions_t
+   PROCESS_BATON and return them as an svn_spillbuf_t in *RESULT.  Set
+   *RESULT to NULL if the editor thread has to fetch them. */
+static svn_error_t *
+fetch_contents(void **result,
+               void *task,
+               void *process_baton,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  fetch_task_t *ft = task;
+  fetch_sessions_t *sessions = process_baton;
+  svn_ra_svn__session_baton_t *sess;
+  svn_spillbuf_t *contents;
+  svn_error_t *err;
+
+  contents = svn_spillbuf__create(FETCH_BLOCKSIZE, FETCH_MAXSIZE,
+                                  result_pool);
+
+  *result = NULL;
+  SVN_MUTEX__WITH_LOCK(sessions->mutex, take_session(&sess, sessions));
+  if (!sess)
+    return SVN_NO_ERROR;
+
+  err = svn_ra_svn__get_file(sess, ft->repos_relpath, ft->revision,
+                             svn_stream__from_spillbuf(contents,
+                                                       scratch_pool),
+                             NULL, NULL, scratch_pool);
+
+  /* The server wants credentials that we must not ask for here.  The
+     session is stuck in the authentication exchange, so give it up. */
+  if (err && sess->auth_deferred)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  /* Any error fails the whole edit, but other workers may still pick up
+     a task before the queue gets shut down. */
+  SVN_MUTEX__WITH_LOCK(sessions->mutex, return_session(sessions, sess));
+  SVN_ERR(err);
+
+  *result = contents;
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** Editor thread ***/
+
+/* Drop a reference to DB and close it on the wrapped editor once it has
+   no references left.  Do the same for its parents as necessary. */
+static svn_error_t *
+release_dir(fetch_dir_baton_t *db)
+{
+  while (db && --db->ref_count == 0)
+    {
+      fetch_dir_baton_t *parent = db->parent;
+
+      SVN_ERR(db->eb->wrapped_editor->close_directory(db->wrapped_baton,
+                                                      db->pool));
+      svn_pool_destroy(db->pool);
+      db = parent;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Close FB on the wrapped editor and release its parent directory. */
+static svn_error_t *
+finish_file(fetch_file_baton_t *fb)
+{
+  fetch_dir_baton_t *parent = fb->parent;
+
+  SVN_ERR(fb->eb->wrapped_editor->close_file(fb->wrapped_baton,
+                                             fb->text_checksum, fb->pool));
+  svn_pool_destroy(fb->pool);
+
+  return svn_error_trace(release_dir(parent));
+}
+
+/* Fetch the contents of the file described by FT on the editor thread of
+   EB and return them in *CONTENTS, allocated in RESULT_POOL.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+fetch_on_editor_thread(svn_spillbuf_t **contents,
+                       fetch_edit_baton_t *eb,
+                       const fetch_task_t *ft,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  /* This session may ask for credentials. */
+  if (!eb->main_fetch_sess)
+    SVN_ERR(svn_ra_svn__open_fetch_session(&eb->main_fetch_sess, eb->sess,
+                                           eb->pool, scratch_pool));
+
+  *contents = svn_spillbuf__create(FETCH_BLOCKSIZE, FETCH_MAXSIZE,
+                                   result_pool);
+
+  return svn_error_trace(svn_ra_svn__get_file(
+                           eb->main_fetch_sess, ft->repos_relpath,
+                           ft->revision,
+                           svn_stream__from_spillbuf(*contents, scratch_pool),
+                           NULL, NULL, scratch_pool));
+}
+
+/* Send CONTENTS of the file described by FT to the wrapped editor of EB
+   and close the file.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+apply_contents(fetch_edit_baton_t *eb,
+               const fetch_task_t *ft,
+               svn_spillbuf_t *contents,
+               apr_pool_t *scratch_pool)
+{
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+
+  SVN_ERR(eb->wrapped_editor->apply_textdelta(ft->fb->wrapped_baton, NULL,
+                                              ft->fb->pool,
+                                              &handler, &handler_baton));
+
+  /* Send the fetched fulltext as a delta against the empty stream. */
+  SVN_ERR(svn_txdelta_send_stream(svn_stream__from_spillbuf(contents,
+                                                            scratch_pool),
+                                  handler, handler_baton, NULL,
+                                  scratch_pool));
+
+  return svn_error_trace(finish_file(ft->fb));
+}
+
+/* Wait for the oldest pending fetch in EB's queue, send the contents to
+   the wrapped editor and close the file. */
+static svn_error_t *
+apply_next_contents(fetch_edit_baton_t *eb)
+{
+  fetch_task_t *ft;
+  svn_spillbuf_t *contents;
+  apr_pool_t *task_pool = NULL;
+  svn_error_t *err;
+
+  err = svn_task__queue_pop((void **)&contents, (void **)&ft, &task_pool,
+                            eb->queue);
+  if (!err && !contents)
+    err = fetch_on_editor_thread(&contents, eb, ft, task_pool, task_pool);
+  if (!err)
+    err = apply_contents(eb, ft, contents, task_pool);
+
+  if (task_pool)
+    svn_pool_destroy(task_pool);
+
+  return svn_error_trace(err);
+}
+
+/* Start the worker threads of EB, unless we tried that before.  There
+   may be none if the server does not accept any more connections.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+start_fetching(fetch_edit_baton_t *eb,
+               apr_pool_t *scratch_pool)
+{
+  fetch_sessions_t *fetch_sessions;
+  int nthreads;
+
+  if (eb->started)
+    return SVN_NO_ERROR;
+  eb->started = TRUE;
+
+  SVN_ERR(svn_ra_svn__ensure_fetch_sessions(eb->sess, scratch_pool));
+  nthreads = eb->sess->fetch_sessions->nelts;
+  if (nthreads == 0)
+    return SVN_NO_ERROR;
+
+  fetch_sessions = apr_pcalloc(eb->pool, sizeof(*fetch_sessions));
+  SVN_ERR(svn_mutex__init(&fetch_sessions->mutex, TRUE, eb->pool));
+  fetch_sessions->idle = apr_array_copy(eb->pool, eb->sess->fetch_sessions);
+
+  eb->max_pending = FETCH_PENDING_PER_CONNECTION * nthreads;
+  eb->queue_pool = svn_pool_create(eb->pool);
+  SVN_ERR(svn_task__queue_create(&eb->queue, nthreads, 0,
+                                 fetch_contents, fetch_sessions,
+                                 eb->queue_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Shut down the fetch queue of EB, discarding all pending fetches. */
+static void
+shutdown_queue(fetch_edit_baton_t *eb)
+{
+  if (eb->queue)
+    {
+      svn_error_clear(svn_task__queue_shutdown(eb->queue));
+      svn_pool_destroy(eb->queue_pool);
+      eb->queue = NULL;
+    }
+}
+
+/* Return the repository-relative path that the edit brings PATH in
+   directory PB to. */
+static const char *
+child_relpath(fetch_dir_baton_t *pb,
+              const char *path,
+              apr_pool_t *result_pool)
+{
+  const char *repos_relpath = svn_hash_gets(pb->eb->links, path);
+
+  if (repos_relpath)
+    return repos_relpath;
+
+  return svn_relpath_join(pb->repos_relpath, svn_relpath_basename(path, NULL),
+                          result_pool);
+}
+
+static fetch_dir_baton_t *
+make_dir_baton(fetch_edit_baton_t *eb,
+               fetch_dir_baton_t *pb,
+               const char *path)
+{
+  apr_pool_t *dir_pool = svn_pool_create(eb->pool);
+  fetch_dir_baton_t *db = apr_pcalloc(dir_pool, sizeof(*db));
+
+  db->eb = eb;
+  db->parent = pb;
+  db->pool = dir_pool;
+  db->ref_count = 1;
+
+  if (pb)
+    {
+      db->repos_relpath = child_relpath(pb, path, dir_pool);
+      pb->ref_count++;
+    }
+  else
+    {
+      db->repos_relpath = svn_hash_gets(eb->links, "");
+      if (!db->repos_relpath)
+        db->repos_relpath = eb->anchor_relpath;
+    }
+
+  return db;
+}
+
+static fetch_file_baton_t *
+make_file_baton(fetch_dir_baton_t *pb,
+                const char *path)
+{
+  apr_pool_t *file_pool = svn_pool_create(pb->eb->pool);
+  fetch_file_baton_t *fb = apr_pcalloc(file_pool, sizeof(*fb));
+
+  fb->eb = pb->eb;
+  fb->parent = pb;
+  fb->pool = file_pool;
+  fb->repos_relpath = child_relpath(pb, path, file_pool);
+  pb->ref_count++;
+
+  return fb;
+}
+
+static svn_error_t *
+fetch_set_target_revision(void *edit_baton,
+                          svn_revnum_t target_revision,
+                          apr_pool_t *pool)
+{
+  fetch_edit_baton_t *eb = edit_baton;
+
+  eb->revision = target_revision;
+
+  return svn_error_trace(eb->wrapped_editor->set_target_revision(
+                           eb->wrapped_baton, target_revision, pool));
+}
+
+static svn_error_t *
+fetch_open_root(void *edit_baton,
+                svn_revnum_t base_revision,
+                apr_pool_t *dir_pool,
+                void **root_baton)
+{
+  fetch_edit_baton_t *eb = edit_baton;
+  fetch_dir_baton_t *db = make_dir_baton(eb, NULL, "");
+
+  SVN_ERR(eb->wrapped_editor->open_root(eb->wrapped_baton, base_revision,
+                                        db->pool, &db->wrapped_baton));
+  *root_baton = db;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+fetch_delete_entry(const char *path,
+                   svn_revnum_t base_revision,
+                   void *parent_baton,
+                   apr_pool_t *pool)
+{
+  fetch_dir_baton_t *pb = parent_baton;
+
+  return svn_error_trace(pb->eb->wrapped_editor->delete_entry(
+                           path, base_revision, pb->wrapped_baton, pool));
+}
+
+static svn_error_t *
+fetch_add_directory(const char *path,
+                    void *parent_baton,
+                    const char *copyfrom_path,
+                    svn_revnum_t copyfrom_revision,
+                    apr_pool_t *dir_pool,
+                    void **child_baton)
+{
+  fetch_dir_baton_t *pb = parent_baton;
+  fetch_dir_baton_t *db = make_dir_baton(pb->eb, pb, path);
+
+  SVN_ERR(pb->eb->wrapped_editor->add_directory(path, pb->wrapped_baton,
+                                                copyfrom_path,
+                                                copyfrom_revision,
+                                                db->pool,
+                                                &db->wrapped_baton));
+  *child_baton = db;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+fetch_open_directory(const char *path,
+                     void *parent_baton,
+                     svn_revnum_t base_revision,
+                     apr_pool_t *dir_pool,
+                     void **child_baton)
+{
+  fetch_dir_baton_t *pb = parent_baton;
+  fetch_dir_baton_t *db = make_dir_baton(pb->eb, pb, path);
+
+  SVN_ERR(pb->eb->wrapped_editor->open_directory(path, pb->wrapped_baton,
+                                                 base_revision, db->pool,
+                                                 &db->wrapped_baton));
+  *child_baton = db;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+fetch_change_dir_prop(void *dir_baton,
+                      const char *name,
+                      const svn_string_t *value,
+                      apr_pool_t *pool)
+{
+  fetch_dir_baton_t *db = dir_baton;
+
+  return svn_error_trace(db->eb->wrapped_editor->change_dir_prop(
+                           db->wrapped_baton, name, value, pool));
+}
+
+static svn_error_t *
+fetch_close_directory(void *dir_baton,
+                      apr_pool_t *pool)
+{
+  return svn_error_trace(release_dir(dir_baton));
+}
+
+static svn_error_t *
+fetch_absent_directory(const char *path,
+                       void *parent_baton,
+                       apr_pool_t *pool)
+{
+  fetch_dir_baton_t *pb = parent_baton;
+
+  return svn_error_trace(pb->eb->wrapped_editor->absent_directory(
+                           path, pb->wrapped_baton, pool));
+}
+
+static svn_error_t *
+fetch_add_file(const char *path,
+               void *parent_baton,
+               const char *copyfrom_path,
+               svn_revnum_t copyfrom_revision,
+               apr_pool_t *file_pool,
+               void **file_baton)
+{
+  fetch_dir_baton_t *pb = parent_baton;
+  fetch_file_baton_t *fb = make_file_baton(pb, path);
+
+  SVN_ERR(pb->eb->wrapped_editor->add_file(path, pb->wrapped_baton,
+                                           copyfrom_path, copyfrom_revision,
+                                           fb->pool, &fb->wrapped_baton));
+  *file_baton = fb;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+fetch_open_file(const char *path,
+                void *parent_baton,
+                svn_revnum_t base_revision,
+                apr_pool_t *file_pool,
+                void **file_baton)
+{
+  fetch_dir_baton_t *pb = parent_baton;
+  fetch_file_baton_t *fb = make_file_baton(pb, path);
+
+  SVN_ERR(pb->eb->wrapped_editor->open_file(path, pb->wrapped_baton,
+                                            base_revision, fb->pool,
+                                            &fb->wrapped_baton));
+  *file_baton = fb;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+fetch_apply_textdelta(void *file_baton,
+                      const char *base_checksum,
+                      apr_pool_t *pool,
+                      svn_txdelta_window_handler_t *handler,
+                      void **handler_baton)
+{
+  fetch_file_baton_t *fb = file_baton;
+
+  /* Deltas against previous contents arrive as usual. */
+  if (base_checksum)
+    return svn_error_trace(fb->eb->wrapped_editor->apply_textdelta(
+                             fb->wrapped_baton, base_checksum, pool,
+                             handler, handler_baton));
+
+  /* For other texts, the server sends no delta windows, only the end of
+     the delta. */
+  fb->text_changed = TRUE;
+  *handler = svn_delta_noop_window_handler;
+  *handler_baton = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+fetch_change_file_prop(void *file_baton,
+                       const char *name,
+                       const svn_string_t *value,
+                       apr_pool_t *pool)
+{
+  fetch_file_baton_t *fb = file_baton;
+
+  return svn_error_trace(fb->eb->wrapped_editor->change_file_prop(
+                           fb->wrapped_baton, name, value, pool));
+}
+
+static svn_error_t *
+fetch_close_file(void *file_baton,
+                 const char *text_checksum,
+                 apr_pool_t *pool)
+{
+  fetch_file_baton_t *fb = file_baton;
+  fetch_edit_baton_t *eb = fb->eb;
+  fetch_task_t *ft;
+  apr_pool_t *task_pool;
+
+  fb->text_checksum = apr_pstrdup(fb->pool, text_checksum);
+  if (!fb->text_changed)
+    return svn_error_trace(finish_file(fb));
+
+  SVN_ERR(start_fetching(eb, pool));
+
+  task_pool = svn_pool_create(eb->queue ? NULL : pool);
+  ft = apr_palloc(task_pool, sizeof(*ft));
+  ft->repos_relpath = apr_pstrdup(task_pool, fb->repos_relpath);
+  ft->revision = eb->revision;
+  ft->fb = fb;
+
+  /* Without worker threads, fetch the text right away. */
+  if (!eb->queue)
+    {
+      svn_spillbuf_t *contents;
+      svn_error_t *err;
+
+      err = fetch_on_editor_thread(&contents, eb, ft, task_pool, task_pool);
+      if (!err)
+        err = apply_contents(eb, ft, contents, task_pool);
+      svn_pool_destroy(task_pool);
+
+      return svn_error_trace(err);
+    }
+
+  SVN_ERR(svn_task__queue_push(eb->queue, ft, task_pool));
+
+  /* Don't let the fetches get too far ahead of the editor drive. */
+  if (svn_task__queue_size(eb->queue) > eb->max_pending)
+    SVN_ERR(apply_next_contents(eb));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+fetch_absent_file(const char *path,
+                  void *parent_baton,
+                  apr_pool_t *pool)
+{
+  fetch_dir_baton_t *pb = parent_baton;
+
+  return svn_error_trace(pb->eb->wrapped_editor->absent_file(
+                           path, pb->wrapped_baton, pool));
+}
+
+static svn_error_t *
+fetch_close_edit(void *edit_baton,
+                 apr_pool_t *pool)
+{
+  fetch_edit_baton_t *eb = edit_baton;
+
+  while (eb->queue && svn_task__queue_size(eb->queue) > 0)
+    SVN_ERR(apply_next_contents(eb));
+
+  shutdown_queue(eb);
+
+  return svn_error_trace(eb->wrapped_editor->close_edit(eb->wrapped_baton,
+                                                        pool));
+}
+
+static svn_error_t *
+fetch_abort_edit(void *edit_baton,
+                 apr_pool_t *pool)
+{
+  fetch_edit_baton_t *eb = edit_baton;
+
+  shutdown_queue(eb);
+
+  return svn_error_trace(eb->wrapped_editor->abort_edit(eb->wrapped_baton,
+                                                        pool));
+}
+
+svn_error_t *
+svn_ra_svn__get_fetch_editor(const svn_delta_editor_t **editor,
+                             void **edit_baton,
+                             const svn_delta_editor_t *wrapped_editor,
+                             void *wrapped_baton,
+                             svn_ra_svn__session_baton_t *sess,
+                             const char *anchor_relpath,
+                             apr_hash_t *links,
+                             apr_pool_t *pool)
+{
+  svn_delta_editor_t *fetch_editor = svn_delta_default_editor(pool);
+  fetch_edit_baton_t *eb = apr_pcalloc(pool, sizeof(*eb));
+
+  eb->wrapped_editor = wrapped_editor;
+  eb->wrapped_baton = wrapped_baton;
+  eb->sess = sess;
+  eb->anchor_relpath = anchor_relpath;
+  eb->links = links;
+  eb->revision = SVN_INVALID_REVNUM;
+  eb->pool = pool;
+
+  fetch_editor->set_target_revision = fetch_set_target_revision;
+  fetch_editor->open_root = fetch_open_root;
+  fetch_editor->delete_entry = fetch_delete_entry;
+  fetch_editor->add_directory = fetch_add_directory;
+  fetch_editor->open_directory = fetch_open_directory;
+  fetch_editor->change_dir_prop = fetch_change_dir_prop;
+  fetch_editor->close_directory = fetch_close_directory;
+  fetch_editor->absent_directory = fetch_absent_directory;
+  fetch_editor->add_file = fetch_add_file;
+  fetch_editor->open_file = fetch_open_file;
+  fetch_editor->apply_textdelta = fetch_apply_textdelta;
+  fetch_editor->change_file_prop = fetch_change_file_prop;
+  fetch_editor->close_file = fetch_close_file;
+  fetch_editor->absent_file = fetch_absent_file;
+  fetch_editor->close_edit = fetch_close_edit;
+  fetch_editor->abort_edit = fetch_abort_edit;
+
+  *editor = fetch_editor;
+  *edit_baton = eb;
+
+  return SVN_NO_ERROR;
+}
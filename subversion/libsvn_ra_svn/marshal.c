@@ -60,18 +60,21 @@
 
 /* We don't use "words" longer than this in our protocol.  The longest word
  * we are currently using is only about 16 chars long but we leave room for
- * longer future capability and command names.  See read_item() to understand
- * why MAX_WORD_LENGTH - 1 should be a multiple of 8.
+ * longer future capability and command names.
  */
 #define MAX_WORD_LENGTH 25
 
-/* The generic parsers will use the following value to limit the recursion
+/* The generic parsers will use the following value to limit the nesting
  * depth to some reasonable value.  The current protocol implementation
  * actually uses only maximum item nesting level of around 5.  So, there is
  * plenty of headroom here.
  */
 #define ITEM_NESTING_LIMIT 64
 
+/* Number of list elements that read_item() can hold on the C stack
+ * before it has to allocate a larger buffer. */
+#define ITEM_STACK_SIZE 128
+
 /* The protocol words for booleans. */
 static const svn_string_t str_true = SVN__STATIC_STRING("true");
 static const svn_string_t str_false = SVN__STATIC_STRING("false");
@@ -214,6 +217,7 @@ svn_ra_svn_conn_t *svn_ra_svn_create_conn5(apr_socket_t *sock,
   conn->block_baton = NULL;
   conn->capabilities = apr_hash_make(result_pool);
   conn->compression_level = compression_level;
+  conn->compressed = FALSE;
   conn->zero_copy_limit = zero_copy_limit;
   conn->pool = result_pool;
 
@@ -273,7 +277,14 @@ svn_ra_svn__svndiff_version(svn_ra_svn_conn_t *conn)
   if (svn_ra_svn_compression_level(conn) <= 0)
     return 0;
 
-  /* Prefer SVNDIFF2 over SVNDIFF1. */
+  /* Don't compress the data twice. */
+  if (conn->compressed)
+    return 0;
+
+  /* Prefer SVNDIFF3 over SVNDIFF2 over SVNDIFF1.  SVNDIFF3 uses the same
+   * compression as SVNDIFF2 but encodes instructions more compactly. */
+  if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED))
+    return 3;
   if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED))
     return 2;
   if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF1))
@@ -283,6 +294,28 @@ svn_ra_svn__svndiff_version(svn_ra_svn_conn_t *conn)
   return 0;
 }
 
+svn_error_t *
+svn_ra_svn__enable_compression(svn_ra_svn_conn_t *conn,
+                               svn_boolean_t use_lz4,
+                               apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT(!conn->compressed);
+
+  /* Flush the connection, as we're about to replace its stream. */
+  SVN_ERR(svn_ra_svn__flush(conn, scratch_pool));
+
+  /* Any data left in the read buffer has been compressed already. */
+  conn->stream = svn_ra_svn__stream_compressed(conn->stream, use_lz4,
+                                               conn->compression_level,
+                                               conn->read_ptr,
+                                               conn->read_end - conn->read_ptr,
+                                               conn->pool);
+  conn->read_end = conn->read_ptr;
+  conn->compressed = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
 apr_pool_t *
 svn_ra_svn__get_pool(svn_ra_svn_conn_t *conn)
 {
@@ -771,6 +804,68 @@ svn_ra_svn__write_cstring(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_svn__write_file_range(svn_ra_svn_conn_t *conn,
+                             apr_pool_t *pool,
+                             apr_file_t *file,
+                             apr_off_t offset,
+                             apr_size_t len)
+{
+  apr_size_t count;
+  apr_pool_t *subpool = NULL;
+
+  /* The string length goes through the write buffer, which must be sent
+     before the contents. */
+  SVN_ERR(write_number(conn, pool, len, ':'));
+  SVN_ERR(writebuf_flush(conn, pool));
+
+  conn->current_out += len;
+  SVN_ERR(check_io_limits(conn));
+
+  conn->written_since_error_check += len;
+  conn->may_check_for_error
+    = conn->written_since_error_check >= conn->error_check_interval;
+
+  /* Same as writebuf_output() but for data in FILE. */
+  while (len > 0)
+    {
+      svn_ra_svn__session_baton_t *session = conn->session;
+
+      if (session && session->callbacks && session->callbacks->cancel_func)
+        SVN_ERR((session->callbacks->cancel_func)(session->callbacks_baton));
+
+      count = len;
+      SVN_ERR(svn_ra_svn__stream_write_file(conn->stream, file, offset,
+                                            &count, pool));
+      if (count == 0)
+        {
+          if (!subpool)
+            subpool = svn_pool_create(pool);
+          else
+            svn_pool_clear(subpool);
+          SVN_ERR(conn->block_handler(conn, subpool, conn->block_baton));
+        }
+
+      offset += count;
+      len -= count;
+
+      if (session)
+        {
+          const svn_ra_callbacks2_t *cb = session->callbacks;
+          session->bytes_written += count;
+
+          if (cb && cb->progress_func)
+            (cb->progress_func)(session->bytes_written + session->bytes_read,
+                                -1, cb->progress_baton, subpool);
+        }
+    }
+
+  if (subpool)
+    svn_pool_destroy(subpool);
+
+  return svn_error_trace(writebuf_writechar(conn, pool, ' '));
+}
+
 svn_error_t *
 svn_ra_svn__write_word(svn_ra_svn_conn_t *conn,
                        apr_pool_t *pool,
@@ -1291,173 +1386,225 @@ static svn_error_t *read_string(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   return SVN_NO_ERROR;
 }
 
-/* Given the first non-whitespace character FIRST_CHAR, read an item
- * into the already allocated structure ITEM.  LEVEL should be set
- * to 0 for the first call and is used to enforce a recursion limit
- * on the parser. */
-static svn_error_t *read_item(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
-                              svn_ra_svn__item_t *item, char first_char,
-                              int level)
+/* Read the digits of a number that started with FIRST_DIGIT from CONN.
+ * Return its value in *VALUE and the first character after it in *C.
+ * The digits in the read buffer are scanned in one go, i.e. the buffer
+ * gets only checked for refills when we reach its end. */
+static svn_error_t *
+read_number(apr_uint64_t *value, char *c, svn_ra_svn_conn_t *conn,
+            apr_pool_t *pool, char first_digit)
 {
-  char c = first_char;
-  apr_uint64_t val;
-  svn_ra_svn__item_t *listitem;
-
-  if (++level >= ITEM_NESTING_LIMIT)
-    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
-                            _("Items are nested too deeply"));
+  apr_uint64_t val = first_digit - '0';
 
-
-  /* Determine the item type and read it in.  Make sure that c is the
-   * first character at the end of the item so we can test to make
-   * sure it's whitespace. */
-  if (svn_ctype_isdigit(c))
+  while (1)
     {
-      /* It's a number or a string.  Read the number part, either way. */
-      val = c - '0';
-      while (1)
+      char *p = conn->read_ptr;
+      char *end = conn->read_end;
+
+      for (; p < end && svn_ctype_isdigit(*p); ++p)
         {
-          apr_uint64_t prev_val = val;
-          SVN_ERR(readbuf_getchar(conn, pool, &c));
-          if (!svn_ctype_isdigit(c))
-            break;
-          val = val * 10 + (c - '0');
-          /* val wrapped past maximum value? */
-          if ((prev_val >= (APR_UINT64_MAX / 10))
-              && (val < APR_UINT64_MAX - 10))
+          int digit = *p - '0';
+
+          /* Would VAL wrap past the maximum value? */
+          if (val >= APR_UINT64_MAX / 10
+              && val > (APR_UINT64_MAX - digit) / 10)
             return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
                                     _("Number is larger than maximum"));
+
+          val = val * 10 + digit;
         }
-      if (c == ':')
-        {
-          /* It's a string. */
-          SVN_ERR(read_string(conn, pool, item, val));
-          SVN_ERR(readbuf_getchar(conn, pool, &c));
-        }
-      else
-        {
-          /* It's a number. */
-          item->kind = SVN_RA_SVN_NUMBER;
-          item->u.number = val;
-        }
+
+      conn->read_ptr = p;
+      if (p < end)
+        break;
+
+      SVN_ERR(readbuf_fill(conn, pool));
     }
-  else if (svn_ctype_isalpha(c))
-    {
-      /* It's a word.  Read it into a buffer of limited size. */
-      char *buffer = apr_palloc(pool, MAX_WORD_LENGTH + 1);
-      char *end = buffer + MAX_WORD_LENGTH;
-      char *p = buffer + 1;
 
-      buffer[0] = c;
-      if (conn->read_ptr + MAX_WORD_LENGTH <= conn->read_end)
-        {
-          /* Fast path: we can simply take a chunk from the read
-           * buffer and inspect it with no overflow checks etc.
-           *
-           * Copying these 24 bytes unconditionally is also faster
-           * than a variable-sized memcpy.  Note that P is at BUFFER[1].
-           */
-          memcpy(p, conn->read_ptr, MAX_WORD_LENGTH - 1);
-          *end = 0;
-
-          /* This will terminate at P == END because of *END == NUL. */
-          while (svn_ctype_isalnum(*p) || *p == '-')
-            ++p;
-
-          /* Only now do we mark data as actually read. */
-          conn->read_ptr += p - buffer;
-        }
-      else
-        {
-          /* Slow path. Byte-by-byte copying and checking for
-           * input and output buffer boundaries. */
-          for (p = buffer + 1; p != end; ++p)
-            {
-              SVN_ERR(readbuf_getchar(conn, pool, p));
-              if (!svn_ctype_isalnum(*p) && *p != '-')
-                break;
-            }
-        }
+  *value = val;
+  *c = *conn->read_ptr++;
 
-      if (p == end)
-        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
-                                _("Word is too long"));
+  return SVN_NO_ERROR;
+}
 
-      c = *p;
-      *p = '\0';
+/* Read a word that started with FIRST_CHAR from CONN into ITEM, allocated
+ * in POOL.  Return the first character after it in *C. */
+static svn_error_t *
+read_word(svn_ra_svn__item_t *item, char *c, svn_ra_svn_conn_t *conn,
+          apr_pool_t *pool, char first_char)
+{
+  char *buffer;
+  char *p = conn->read_ptr;
+  apr_size_t available = conn->read_end - conn->read_ptr;
+  apr_size_t len;
 
-      /* Store the word in ITEM. */
-      item->kind = SVN_RA_SVN_WORD;
-      item->u.word.data = buffer;
-      item->u.word.len = p - buffer;
-    }
-  else if (c == '(')
+  /* Fast path: scan the read buffer in place.  Words are short and the
+   * protocol limits them to MAX_WORD_LENGTH - 1 chars.  So, we will either
+   * find the end of the word or detect an overlong one, unless we hit the
+   * end of the buffer first. */
+  char *end = p + (available < MAX_WORD_LENGTH - 1
+                   ? available
+                   : MAX_WORD_LENGTH - 1);
+
+  while (p < end && (svn_ctype_isalnum(*p) || *p == '-'))
+    ++p;
+
+  len = p - conn->read_ptr + 1;
+  if (len < MAX_WORD_LENGTH && p < conn->read_end)
     {
-      /* The largest struct that the protocol currently defines has 10
-       * elements (log-entry) and add some headroom for future extensions.
-       * At a maximum nesting level of 64 this use <= 18kB of stack.
-       *
-       * All system-defined data structures will fit into this and will be
-       * copied into ITEM after a single apr_palloc with no over-provision.
-       * Unbounded lists with more than 12 but less than 25 entries will
-       * also see only a single allocation from POOL.  However, there will
-       * be some over-provision.  Longer lists will see log N resizes and
-       * O(N) total cost.
-       */
-      svn_ra_svn__item_t stack_items[12];
-      svn_ra_svn__item_t *items = stack_items;
-      int capacity = sizeof(stack_items) / sizeof(stack_items[0]);
-      int count = 0;
+      /* Allocate exactly what we need. */
+      buffer = apr_palloc(pool, len + 1);
+      buffer[0] = first_char;
+      memcpy(buffer + 1, conn->read_ptr, len - 1);
 
-      /* Read in the list items. */
-      item->kind = SVN_RA_SVN_LIST;
-      while (1)
+      conn->read_ptr = p + 1;
+      *c = *p;
+    }
+  else if (len < MAX_WORD_LENGTH)
+    {
+      /* Slow path.  The word continues beyond the read buffer.
+       * Byte-by-byte copying and checking for input and output
+       * buffer boundaries. */
+      buffer = apr_palloc(pool, MAX_WORD_LENGTH + 1);
+      buffer[0] = first_char;
+      end = buffer + MAX_WORD_LENGTH;
+      for (p = buffer + 1; p != end; ++p)
         {
-          SVN_ERR(readbuf_getchar_skip_whitespace(conn, pool, &c));
-          if (c == ')')
+          SVN_ERR(readbuf_getchar(conn, pool, p));
+          if (!svn_ctype_isalnum(*p) && *p != '-')
             break;
+        }
 
-          /* Auto-expand the list. */
-          if (count == capacity)
-            {
-              svn_ra_svn__item_t *new_items
-                = apr_palloc(pool, 2 * capacity * sizeof(*new_items));
-              memcpy(new_items, items, capacity * sizeof(*new_items));
-              items = new_items;
-              capacity = 2 * capacity;
-            }
+      len = p - buffer;
+      *c = *p;
+    }
+
+  if (len >= MAX_WORD_LENGTH)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Word is too long"));
+
+  buffer[len] = '\0';
+
+  /* Store the word in ITEM. */
+  item->kind = SVN_RA_SVN_WORD;
+  item->u.word.data = buffer;
+  item->u.word.len = len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Given the first non-whitespace character FIRST_CHAR, read an item
+ * into the already allocated structure ITEM.  Allocate all of its
+ * contents in POOL.
+ *
+ * Lists are parsed without recursion: the elements of all lists that
+ * are still open live on a single stack, which is initially located
+ * on the C stack and only moves into POOL for large responses.  When a
+ * list gets closed, its elements are copied into POOL with no
+ * over-provision and removed from the stack. */
+static svn_error_t *read_item(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
+                              svn_ra_svn__item_t *item, char first_char)
+{
+  svn_ra_svn__item_t stack_items[ITEM_STACK_SIZE];
+  svn_ra_svn__item_t *items = stack_items;
+  int capacity = ITEM_STACK_SIZE;
+  int count = 0;
+
+  /* Index in ITEMS of the first element for each open list. */
+  int list_starts[ITEM_NESTING_LIMIT];
+  int level = 0;
+
+  char c = first_char;
 
-          listitem = &items[count];
-          ++count;
+  while (1)
+    {
+      svn_ra_svn__item_t value;
 
-          SVN_ERR(read_item(conn, pool, listitem, c, level));
+      /* Determine the item type and read it in.  Make sure that c is the
+       * first character at the end of the item so we can test to make
+       * sure it's whitespace. */
+      if (c == '(')
+        {
+          if (level + 1 >= ITEM_NESTING_LIMIT)
+            return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                    _("Items are nested too deeply"));
+
+          /* Open a new list and continue with its first element. */
+          list_starts[level++] = count;
+          SVN_ERR(readbuf_getchar_skip_whitespace(conn, pool, &c));
+          continue;
         }
+      else if (c == ')' && level > 0)
+        {
+          /* Close the innermost list.  Its elements are at the top of
+           * the stack. */
+          int start = list_starts[--level];
+
+          value.kind = SVN_RA_SVN_LIST;
+          value.u.list.nelts = count - start;
+          value.u.list.items
+            = value.u.list.nelts
+            ? apr_pmemdup(pool, items + start,
+                          value.u.list.nelts * sizeof(*items))
+            : NULL;
+          count = start;
 
-      /* Store the list in ITEM - if not empty (= default). */
-      if (count)
+          SVN_ERR(readbuf_getchar(conn, pool, &c));
+        }
+      else if (svn_ctype_isdigit(c))
         {
-          item->u.list.nelts = count;
+          /* It's a number or a string.  Read the number part, either way. */
+          apr_uint64_t val;
+          SVN_ERR(read_number(&val, &c, conn, pool, c));
 
-          /* If we haven't allocated from POOL, yet, do it now. */
-          if (items == stack_items)
-            item->u.list.items = apr_pmemdup(pool, items,
-                                             count * sizeof(*items));
+          if (c == ':')
+            {
+              /* It's a string. */
+              SVN_ERR(read_string(conn, pool, &value, val));
+              SVN_ERR(readbuf_getchar(conn, pool, &c));
+            }
           else
-            item->u.list.items = items;
+            {
+              /* It's a number. */
+              value.kind = SVN_RA_SVN_NUMBER;
+              value.u.number = val;
+            }
+        }
+      else if (svn_ctype_isalpha(c))
+        {
+          /* It's a word. */
+          SVN_ERR(read_word(&value, &c, conn, pool, c));
         }
       else
         {
-          item->u.list.items = NULL;
-          item->u.list.nelts = 0;
+          return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                  _("Malformed network data"));
         }
 
-      SVN_ERR(readbuf_getchar(conn, pool, &c));
-    }
+      if (!svn_iswhitespace(c))
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Malformed network data"));
 
-  if (!svn_iswhitespace(c))
-    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
-                            _("Malformed network data"));
-  return SVN_NO_ERROR;
+      /* Done with the top-level item? */
+      if (level == 0)
+        {
+          *item = value;
+          return SVN_NO_ERROR;
+        }
+
+      /* Add VALUE to the current list, auto-expanding the stack. */
+      if (count == capacity)
+        {
+          svn_ra_svn__item_t *new_items
+            = apr_palloc(pool, 2 * capacity * sizeof(*new_items));
+          memcpy(new_items, items, capacity * sizeof(*new_items));
+          items = new_items;
+          capacity = 2 * capacity;
+        }
+
+      items[count++] = value;
+      SVN_ERR(readbuf_getchar_skip_whitespace(conn, pool, &c));
+    }
 }
 
 /* Given the first non-whitespace character FIRST_CHAR, read the first
@@ -1475,19 +1622,8 @@ read_command_only(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   if (svn_ctype_isdigit(c))
     {
       /* It's a number or a string.  Read the number part, either way. */
-      apr_uint64_t val, prev_val=0;
-      val = c - '0';
-      while (1)
-        {
-          prev_val = val;
-          SVN_ERR(readbuf_getchar(conn, pool, &c));
-          if (!svn_ctype_isdigit(c))
-            break;
-          val = val * 10 + (c - '0');
-          if (prev_val >= (APR_UINT64_MAX / 10)) /* > maximum value? */
-            return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
-                                    _("Number is larger than maximum"));
-        }
+      apr_uint64_t val;
+      SVN_ERR(read_number(&val, &c, conn, pool, c));
       if (c == ':')
         {
           /* It's a string. */
@@ -1560,7 +1696,7 @@ svn_ra_svn__read_item(svn_ra_svn_conn_t *conn,
    * the work.  This makes sense because of the way lists are read. */
   *item = apr_palloc(pool, sizeof(**item));
   SVN_ERR(readbuf_getchar_skip_whitespace(conn, pool, &c));
-  return read_item(conn, pool, *item, c, 0);
+  return read_item(conn, pool, *item, c);
 }
 
 /* Drain existing whitespace from the receive buffer of CONN until either
@@ -2463,7 +2599,8 @@ svn_ra_svn__write_cmd_update(svn_ra_svn_conn_t *conn,
                              svn_boolean_t recurse,
                              svn_depth_t depth,
                              svn_boolean_t send_copyfrom_args,
-                             svn_boolean_t ignore_ancestry)
+                             svn_boolean_t ignore_ancestry,
+                             svn_boolean_t text_deltas)
 {
   SVN_ERR(writebuf_write_literal(conn, pool, "( update ( "));
   SVN_ERR(write_tuple_start_list(conn, pool));
@@ -2474,6 +2611,7 @@ svn_ra_svn__write_cmd_update(svn_ra_svn_conn_t *conn,
   SVN_ERR(write_tuple_depth(conn, pool, depth));
   SVN_ERR(write_tuple_boolean(conn, pool, send_copyfrom_args));
   SVN_ERR(write_tuple_boolean(conn, pool, ignore_ancestry));
+  SVN_ERR(write_tuple_boolean(conn, pool, text_deltas));
   SVN_ERR(writebuf_write_literal(conn, pool, ") ) "));
 
   return SVN_NO_ERROR;
@@ -115,6 +115,9 @@ struct svn_ra_svn_conn_st {
   int compression_level;
   apr_size_t zero_copy_limit;
 
+  /* whether STREAM compresses all data, see svn_ra_svn__enable_compression */
+  svn_boolean_t compressed;
+
   /* who's on the other side of the connection? */
   char *remote_ip;
 
@@ -160,6 +163,17 @@ struct svn_ra_svn__session_baton_t {
   apr_off_t bytes_read, bytes_written; /* apr_off_t's because that's what
                                           the callback interface uses */
   const char *useragent;
+
+  /* Auxiliary sessions to the repository root for fetching file contents
+     in parallel, or NULL if they have not been opened (yet). */
+  apr_array_header_t *fetch_sessions;
+
+  /* If set, fail authentication requests received after the session has
+     been opened instead of asking for credentials, and set AUTH_DEFERRED.
+     The session can't be used after that.  This is for sessions used on
+     worker threads. */
+  svn_boolean_t defer_auth;
+  svn_boolean_t auth_deferred;
 };
 
 /* Set a callback for blocked writes on conn.  This handler may
@@ -207,6 +221,20 @@ svn_ra_svn__stream_t *svn_ra_svn__stream_from_streams(svn_stream_t *in_stream,
                                                       svn_stream_t *out_stream,
                                                       apr_pool_t *pool);
 
+/* Return a stream that compresses all data written to STREAM and
+ * decompresses all data read from it, using LZ4 if USE_LZ4 is set and
+ * zlib with COMPRESSION_LEVEL otherwise.  LEN bytes at DATA have already
+ * been read from STREAM and will be decompressed first.  Allocate the
+ * result in RESULT_POOL.
+ */
+svn_ra_svn__stream_t *
+svn_ra_svn__stream_compressed(svn_ra_svn__stream_t *stream,
+                              svn_boolean_t use_lz4,
+                              int compression_level,
+                              const char *data,
+                              apr_size_t len,
+                              apr_pool_t *result_pool);
+
 /* Create an svn_ra_svn__stream_t using READ_CB, WRITE_CB, TIMEOUT_CB,
  * PENDING_CB, and BATON.
  */
@@ -222,6 +250,17 @@ svn_ra_svn__stream_t *svn_ra_svn__stream_create(svn_stream_t *in_stream,
 svn_error_t *svn_ra_svn__stream_write(svn_ra_svn__stream_t *stream,
                                       const char *data, apr_size_t *len);
 
+/* Write up to *LEN bytes starting at OFFSET in FILE to STREAM, returning
+ * the number of bytes written in *LEN.  If STREAM is a socket stream and
+ * APR supports it, use sendfile to avoid copying the data.  Use POOL for
+ * temporary allocations.
+ */
+svn_error_t *svn_ra_svn__stream_write_file(svn_ra_svn__stream_t *stream,
+                                           apr_file_t *file,
+                                           apr_off_t offset,
+                                           apr_size_t *len,
+                                           apr_pool_t *pool);
+
 /* Read *LEN bytes from STREAM into DATA, returning the number of bytes
  * read in *LEN.
  */
@@ -275,6 +314,67 @@ svn_boolean_t svn_ra_svn__find_mech(const svn_ra_svn__list_t *mechlist,
 /* Initialize the SASL library. */
 svn_error_t *svn_ra_svn__sasl_init(void);
 
+/* Fetch the contents of PATH, relative to the session URL of SESS, in
+ * revision REV like svn_ra_get_file() does.  Only SESS will be used. */
+svn_error_t *
+svn_ra_svn__get_file(svn_ra_svn__session_baton_t *sess,
+                     const char *path,
+                     svn_revnum_t rev,
+                     svn_stream_t *stream,
+                     svn_revnum_t *fetched_rev,
+                     apr_hash_t **props,
+                     apr_pool_t *pool);
+
+/* Open a new session to the repository root of SESS, with the same
+ * configuration and credentials, in *FETCH_SESS.  Allocate it in
+ * RESULT_POOL and use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_ra_svn__open_fetch_session(svn_ra_svn__session_baton_t **fetch_sess,
+                               svn_ra_svn__session_baton_t *sess,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
+/* Make SESS->FETCH_SESSIONS hold the auxiliary sessions that updates over
+ * SESS may use to fetch file contents in parallel, as configured by the
+ * svn-max-connections option.  Open them as necessary, with DEFER_AUTH
+ * set, and drop those that can't be used anymore.  That may leave the
+ * array empty.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_ra_svn__ensure_fetch_sessions(svn_ra_svn__session_baton_t *sess,
+                                  apr_pool_t *scratch_pool);
+
+/* Set *EDITOR and *EDIT_BATON to an editor that consumes an update edit
+ * driven without the texts of added files and passes it on to
+ * WRAPPED_EDITOR and WRAPPED_BATON, fetching those texts from the server.
+ * Text deltas of other files are passed through.
+ *
+ * The texts get fetched on worker threads, using the auxiliary sessions
+ * of SESS, which get opened when the first text is needed.  A text that
+ * can't be fetched that way, e.g. because the server asks for
+ * authentication, is fetched on the calling thread over another session.
+ * The auxiliary sessions must not be used by anyone else until the edit
+ * has been completed or aborted.
+ *
+ * ANCHOR_RELPATH is the repository-relative path of the edit's anchor.
+ * LINKS maps anchor-relative paths to the repository-relative paths that
+ * the edit brings them to, where those are not implied by their parent
+ * directory, i.e. for paths that had been reported through link_path().
+ * It may be filled in until the edit starts.
+ *
+ * Allocate the editor in POOL.
+ */
+svn_error_t *
+svn_ra_svn__get_fetch_editor(const svn_delta_editor_t **editor,
+                             void **edit_baton,
+                             const svn_delta_editor_t *wrapped_editor,
+                             void *wrapped_baton,
+                             svn_ra_svn__session_baton_t *sess,
+                             const char *anchor_relpath,
+                             apr_hash_t *links,
+                             apr_pool_t *pool);
+
 
 #ifdef __cplusplus
 }
@@ -34,6 +34,7 @@
 #include "svn_private_config.h"
 
 #include "private/svn_io_private.h"
+#include "private/svn_subr_private.h"
 
 #include "ra_svn.h"
 
@@ -42,6 +43,10 @@ struct svn_ra_svn__stream_st {
   svn_stream_t *out_stream;
   void *timeout_baton;
   ra_svn_timeout_fn_t timeout_fn;
+
+  /* The socket that OUT_STREAM writes to without any further processing,
+     or NULL if this is not a plain socket stream. */
+  apr_socket_t *sock;
 };
 
 typedef struct sock_baton_t {
@@ -49,6 +54,38 @@ typedef struct sock_baton_t {
   apr_pool_t *pool;
 } sock_baton_t;
 
+/* Maximum amount of data that a compressed stream puts into a single
+   frame.  This is also the most we will ever decompress a frame into. */
+#define COMPRESSION_BLOCK_SIZE 0x10000
+
+/* Upper limit for the size of a compressed frame.  Compressed data may
+   be slightly larger than the original when it does not compress. */
+#define MAX_COMPRESSED_FRAME_SIZE (2 * COMPRESSION_BLOCK_SIZE)
+
+/* Baton for a compressed svn_ra_svn__stream_t.
+ *
+ * The data is sent as a sequence of frames, each consisting of the
+ * length of its payload, encoded with svn__encode_uint(), followed by
+ * a block of at most COMPRESSION_BLOCK_SIZE bytes of user data that has
+ * been compressed with either svn__compress_lz4() or svn__compress_zlib().
+ */
+typedef struct compress_baton_t {
+  svn_ra_svn__stream_t *stream; /* Inherited stream. */
+  svn_boolean_t use_lz4;        /* Use LZ4 instead of zlib. */
+  int compression_level;        /* The zlib compression level. */
+
+  svn_stringbuf_t *read_buf;    /* Data read from STREAM that has not been
+                                   decompressed, yet. */
+  svn_stringbuf_t *read_data;   /* The last decompressed frame. */
+  apr_size_t read_pos;          /* Data in READ_DATA before this has already
+                                   been returned. */
+
+  svn_stringbuf_t *compressed;  /* Scratch buffer for compression. */
+  svn_stringbuf_t *write_buf;   /* The frame being written to STREAM. */
+  apr_size_t write_pos;         /* WRITE_BUF up to here has been written. */
+  apr_size_t write_len;         /* Size of the user data in WRITE_BUF. */
+} compress_baton_t;
+
 
 /* Returns TRUE if PFD has pending data, FALSE otherwise. */
 static svn_boolean_t pending(apr_pollfd_t *pfd, apr_pool_t *pool)
@@ -167,6 +204,7 @@ svn_ra_svn__stream_from_sock(apr_socket_t *sock,
 {
   sock_baton_t *b = apr_palloc(result_pool, sizeof(*b));
   svn_stream_t *sock_stream;
+  svn_ra_svn__stream_t *stream;
 
   b->sock = sock;
   b->pool = svn_pool_create(result_pool);
@@ -177,8 +215,192 @@ svn_ra_svn__stream_from_sock(apr_socket_t *sock,
   svn_stream_set_write(sock_stream, sock_write_cb);
   svn_stream_set_data_available(sock_stream, sock_pending_cb);
 
-  return svn_ra_svn__stream_create(sock_stream, sock_stream,
-                                   b, sock_timeout_cb, result_pool);
+  stream = svn_ra_svn__stream_create(sock_stream, sock_stream,
+                                     b, sock_timeout_cb, result_pool);
+  stream->sock = sock;
+
+  return stream;
+}
+
+/* Functions to implement a compressed svn_ra_svn__stream_t. */
+
+/* Read the next frame from B->STREAM and decompress it into B->READ_DATA.
+ */
+static svn_error_t *
+decompress_next_frame(compress_baton_t *b)
+{
+  apr_uint64_t frame_len;
+  const unsigned char *start;
+  const unsigned char *p;
+
+  /* Read until we got at least one complete frame. */
+  while (1)
+    {
+      apr_size_t len;
+
+      start = (const unsigned char *)b->read_buf->data;
+      p = svn__decode_uint(&frame_len, start, start + b->read_buf->len);
+
+      if (p && frame_len > MAX_COMPRESSED_FRAME_SIZE)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Compressed frame is too large"));
+      if (p && frame_len <= (apr_size_t)(b->read_buf->len - (p - start)))
+        break;
+      if (!p && b->read_buf->len >= SVN__MAX_ENCODED_UINT_LEN)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Malformed compressed frame header"));
+
+      len = SVN__STREAM_CHUNK_SIZE;
+      svn_stringbuf_ensure(b->read_buf, b->read_buf->len + len);
+      SVN_ERR(svn_ra_svn__stream_read(b->stream,
+                                      b->read_buf->data + b->read_buf->len,
+                                      &len));
+      b->read_buf->len += len;
+      b->read_buf->data[b->read_buf->len] = '\0';
+    }
+
+  if (b->use_lz4)
+    SVN_ERR(svn__decompress_lz4(p, (apr_size_t)frame_len, b->read_data,
+                                COMPRESSION_BLOCK_SIZE));
+  else
+    SVN_ERR(svn__decompress_zlib(p, (apr_size_t)frame_len, b->read_data,
+                                 COMPRESSION_BLOCK_SIZE));
+  b->read_pos = 0;
+
+  /* Keep whatever we read beyond this frame. */
+  svn_stringbuf_remove(b->read_buf, 0,
+                       (p - start) + (apr_size_t)frame_len);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_read_fn_t. */
+static svn_error_t *
+compress_read_cb(void *baton, char *buffer, apr_size_t *len)
+{
+  compress_baton_t *b = baton;
+  apr_size_t available;
+
+  /* Frames may be empty, so loop until we have some data. */
+  while (b->read_pos == b->read_data->len)
+    SVN_ERR(decompress_next_frame(b));
+
+  available = b->read_data->len - b->read_pos;
+  if (*len > available)
+    *len = available;
+
+  memcpy(buffer, b->read_data->data + b->read_pos, *len);
+  b->read_pos += *len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_write_fn_t. */
+static svn_error_t *
+compress_write_cb(void *baton, const char *buffer, apr_size_t *len)
+{
+  compress_baton_t *b = baton;
+
+  /* If the last frame has been sent completely, compress a new one from
+     BUFFER.  Otherwise, we got called with the same arguments as last
+     time and continue sending the pending frame. */
+  if (b->write_pos == b->write_buf->len)
+    {
+      unsigned char header[SVN__MAX_ENCODED_UINT_LEN];
+      unsigned char *header_end;
+
+      b->write_len = *len > COMPRESSION_BLOCK_SIZE
+                   ? COMPRESSION_BLOCK_SIZE
+                   : *len;
+
+      if (b->use_lz4)
+        SVN_ERR(svn__compress_lz4(buffer, b->write_len, b->compressed));
+      else
+        SVN_ERR(svn__compress_zlib(buffer, b->write_len, b->compressed,
+                                   b->compression_level));
+
+      header_end = svn__encode_uint(header, b->compressed->len);
+      svn_stringbuf_setempty(b->write_buf);
+      svn_stringbuf_appendbytes(b->write_buf, (const char *)header,
+                                header_end - header);
+      svn_stringbuf_appendbytes(b->write_buf, b->compressed->data,
+                                b->compressed->len);
+      b->write_pos = 0;
+    }
+
+  while (b->write_pos < b->write_buf->len)
+    {
+      apr_size_t tmplen = b->write_buf->len - b->write_pos;
+      SVN_ERR(svn_ra_svn__stream_write(b->stream,
+                                       b->write_buf->data + b->write_pos,
+                                       &tmplen));
+      if (tmplen == 0)
+        {
+          /* The remainder of the frame will be written out during the
+             next call to this function. */
+          *len = 0;
+          return SVN_NO_ERROR;
+        }
+
+      b->write_pos += tmplen;
+    }
+
+  *len = b->write_len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements ra_svn_timeout_fn_t. */
+static void
+compress_timeout_cb(void *baton, apr_interval_time_t interval)
+{
+  compress_baton_t *b = baton;
+  svn_ra_svn__stream_timeout(b->stream, interval);
+}
+
+/* Implements svn_stream_data_available_fn_t. */
+static svn_error_t *
+compress_data_available_cb(void *baton, svn_boolean_t *data_available)
+{
+  compress_baton_t *b = baton;
+
+  /* A partial frame means that the rest is on its way. */
+  if (b->read_pos < b->read_data->len || b->read_buf->len > 0)
+    {
+      *data_available = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(svn_ra_svn__stream_data_available(b->stream,
+                                                           data_available));
+}
+
+svn_ra_svn__stream_t *
+svn_ra_svn__stream_compressed(svn_ra_svn__stream_t *stream,
+                              svn_boolean_t use_lz4,
+                              int compression_level,
+                              const char *data,
+                              apr_size_t len,
+                              apr_pool_t *result_pool)
+{
+  compress_baton_t *b = apr_pcalloc(result_pool, sizeof(*b));
+  svn_stream_t *in = svn_stream_create(b, result_pool);
+  svn_stream_t *out = svn_stream_create(b, result_pool);
+
+  b->stream = stream;
+  b->use_lz4 = use_lz4;
+  b->compression_level = compression_level;
+  b->read_buf = svn_stringbuf_ncreate(data, len, result_pool);
+  b->read_data = svn_stringbuf_create_empty(result_pool);
+  b->compressed = svn_stringbuf_create_empty(result_pool);
+  b->write_buf = svn_stringbuf_create_empty(result_pool);
+
+  svn_stream_set_read2(in, compress_read_cb, NULL /* use default */);
+  svn_stream_set_data_available(in, compress_data_available_cb);
+  svn_stream_set_write(out, compress_write_cb);
+
+  return svn_ra_svn__stream_create(in, out, b, compress_timeout_cb,
+                                   result_pool);
 }
 
 svn_ra_svn__stream_t *
@@ -193,6 +415,7 @@ svn_ra_svn__stream_create(svn_stream_t *in_stream,
   s->out_stream = out_stream;
   s->timeout_baton = timeout_baton;
   s->timeout_fn = timeout_cb;
+  s->sock = NULL;
   return s;
 }
 
@@ -203,6 +426,37 @@ svn_ra_svn__stream_write(svn_ra_svn__stream_t *stream,
   return svn_error_trace(svn_stream_write(stream->out_stream, data, len));
 }
 
+svn_error_t *
+svn_ra_svn__stream_write_file(svn_ra_svn__stream_t *stream,
+                              apr_file_t *file,
+                              apr_off_t offset,
+                              apr_size_t *len,
+                              apr_pool_t *pool)
+{
+  char buffer[SVN__STREAM_CHUNK_SIZE];
+
+#if APR_HAS_SENDFILE
+  if (stream->sock)
+    {
+      apr_status_t status = apr_socket_sendfile(stream->sock, file, NULL,
+                                                &offset, len, 0);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't write to connection"));
+
+      return SVN_NO_ERROR;
+    }
+#endif
+
+  /* Copy the data through BUFFER. */
+  if (*len > sizeof(buffer))
+    *len = sizeof(buffer);
+
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+  SVN_ERR(svn_io_file_read_full2(file, buffer, *len, NULL, NULL, pool));
+
+  return svn_error_trace(svn_stream_write(stream->out_stream, buffer, len));
+}
+
 svn_error_t *
 svn_ra_svn__stream_read(svn_ra_svn__stream_t *stream, char *data,
                         apr_size_t *len)
@@ -45,6 +45,9 @@
 #include "private/svn_utf_private.h"
 #include "private/svn_cache.h"
 #include "private/svn_fspath.h"
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+#include "private/svn_task.h"
 
 #define ARE_VALID_COPY_ARGS(p,r) ((p) && SVN_IS_VALID_REVNUM(r))
 
@@ -2459,12 +2462,277 @@ report_error(svn_revnum_t revision,
     }
 }
 
+#if APR_HAS_THREADS
+
+/* State shared by all threads verifying revisions concurrently. */
+typedef struct verify_workers_t
+{
+  /* Filesystem instances (svn_fs_t *) not currently used by any worker.
+   * Each one lives in its own root pool. */
+  apr_array_header_t *idle_fs;
+
+  /* The root pools (apr_pool_t *) of all instances in IDLE_FS. */
+  apr_array_header_t *fs_pools;
+
+  /* Serializes access to IDLE_FS. */
+  svn_mutex__t *mutex;
+
+  /* Parameters to pass to verify_one_revision(). */
+  svn_revnum_t start_rev;
+  svn_boolean_t check_normalization;
+
+  /* Whether the caller wants to receive notifications at all. */
+  svn_boolean_t notify;
+
+  /* Non-zero if the workers shall stop as soon as possible. */
+  svn_atomic_t cancelled;
+} verify_workers_t;
+
+/* A single revision to be verified by one of the worker threads. */
+typedef struct verify_task_t
+{
+  /* The revision to verify. */
+  svn_revnum_t revision;
+
+  /* Notifications (svn_repos_notify_t *) sent while verifying REVISION,
+   * to be forwarded to the caller in order. */
+  apr_array_header_t *notifications;
+} verify_task_t;
+
+/* Implements svn_cancel_func_t.  BATON is a verify_workers_t *. */
+static svn_error_t *
+check_workers_cancelled(void *baton)
+{
+  verify_workers_t *workers = baton;
+
+  if (svn_atomic_read(&workers->cancelled))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove an idle filesystem instance from WORKERS and return it in *FS. */
+static svn_error_t *
+take_idle_fs(svn_fs_t **fs,
+             verify_workers_t *workers)
+{
+  svn_fs_t **entry = apr_array_pop(workers->idle_fs);
+  SVN_ERR_ASSERT(entry);
+  *fs = *entry;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return FS to the list of idle filesystem instances in WORKERS. */
+static svn_error_t *
+release_idle_fs(verify_workers_t *workers,
+                svn_fs_t *fs)
+{
+  APR_ARRAY_PUSH(workers->idle_fs, svn_fs_t *) = fs;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_notify_func_t.  Append a copy of NOTIFY to the
+ * notifications array in the verify_task_t BATON. */
+static void
+record_notification(void *baton,
+                    const svn_repos_notify_t *notify,
+                    apr_pool_t *scratch_pool)
+{
+  verify_task_t *task = baton;
+  apr_pool_t *pool = task->notifications->pool;
+  svn_repos_notify_t *copy = apr_pmemdup(pool, notify, sizeof(*notify));
+
+  copy->warning_str = apr_pstrdup(pool, notify->warning_str);
+  copy->path = apr_pstrdup(pool, notify->path);
+  APR_ARRAY_PUSH(task->notifications, svn_repos_notify_t *) = copy;
+}
+
+/* Implements svn_task__process_func_t.  Verify the revision given by
+ * the verify_task_t TASK using one of the filesystem instances in the
+ * verify_workers_t PROCESS_BATON. */
+static svn_error_t *
+verify_revision_task(void **result,
+                     void *task,
+                     void *process_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  verify_task_t *verify_task = task;
+  verify_workers_t *workers = process_baton;
+  svn_fs_t *fs;
+  svn_error_t *err;
+
+  /* Filesystem objects are not thread-safe.  Use one that no other thread
+   * is using right now. */
+  SVN_MUTEX__WITH_LOCK(workers->mutex, take_idle_fs(&fs, workers));
+
+  err = verify_one_revision(fs, verify_task->revision,
+                            workers->notify ? record_notification : NULL,
+                            verify_task, workers->start_rev,
+                            workers->check_normalization,
+                            check_workers_cancelled, workers,
+                            scratch_pool);
+
+  SVN_MUTEX__WITH_LOCK(workers->mutex, release_idle_fs(workers, fs));
+
+  *result = NULL;
+
+  return svn_error_trace(err);
+}
+
+/* Push a task for verifying REVISION into QUEUE. */
+static svn_error_t *
+push_revision_task(svn_task__queue_t *queue,
+                   svn_revnum_t revision)
+{
+  apr_pool_t *task_pool = svn_pool_create(NULL);
+  verify_task_t *task = apr_pcalloc(task_pool, sizeof(*task));
+
+  task->revision = revision;
+  task->notifications = apr_array_make(task_pool, 0,
+                                       sizeof(svn_repos_notify_t *));
+
+  return svn_error_trace(svn_task__queue_push(queue, task, task_pool));
+}
+
+/* Verify revisions START_REV through END_REV in FS on JOBS threads, each
+ * using its own instance of FS.  Report results, i.e. forward
+ * notifications to NOTIFY_FUNC and errors to VERIFY_CALLBACK, strictly in
+ * revision order.  NOTIFY will be used to report verified revisions.
+ * The other parameters are the same as for svn_repos_verify_fs4().
+ *
+ * Only the calling thread will invoke the caller's callbacks. */
+static svn_error_t *
+verify_revisions_concurrently(svn_fs_t *fs,
+                              svn_revnum_t start_rev,
+                              svn_revnum_t end_rev,
+                              svn_boolean_t check_normalization,
+                              int jobs,
+                              svn_repos_notify_t *notify,
+                              svn_repos_notify_func_t notify_func,
+                              void *notify_baton,
+                              svn_repos_verify_callback_t verify_callback,
+                              void *verify_baton,
+                              svn_cancel_func_t cancel_func,
+                              void *cancel_baton,
+                              apr_pool_t *pool)
+{
+  apr_pool_t *queue_pool = svn_pool_create(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  verify_workers_t *workers = apr_pcalloc(pool, sizeof(*workers));
+  svn_task__queue_t *queue = NULL;
+  const char *fs_path = svn_fs_path(fs, pool);
+  apr_hash_t *fs_config = svn_fs_config(fs, pool);
+  svn_revnum_t next_rev = start_rev;
+  svn_revnum_t rev;
+  int max_pending = 2 * jobs;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  workers->start_rev = start_rev;
+  workers->check_normalization = check_normalization;
+  workers->notify = notify_func != NULL;
+  workers->idle_fs = apr_array_make(pool, jobs, sizeof(svn_fs_t *));
+  workers->fs_pools = apr_array_make(pool, jobs, sizeof(apr_pool_t *));
+  SVN_ERR(svn_mutex__init(&workers->mutex, TRUE, pool));
+
+  /* Each worker gets its own filesystem instance.  With the same config,
+   * they all share the same process-wide caches. */
+  for (i = 0; i < jobs && !err; ++i)
+    {
+      apr_pool_t *fs_pool = svn_pool_create(NULL);
+      svn_fs_t *worker_fs;
+
+      err = svn_fs_open2(&worker_fs, fs_path, fs_config, fs_pool, iterpool);
+      APR_ARRAY_PUSH(workers->fs_pools, apr_pool_t *) = fs_pool;
+      if (!err)
+        APR_ARRAY_PUSH(workers->idle_fs, svn_fs_t *) = worker_fs;
+    }
+
+  if (!err)
+    err = svn_task__queue_create(&queue, jobs, 0, verify_revision_task,
+                                 workers, queue_pool);
+
+  for (rev = start_rev; !err && rev <= end_rev; rev++)
+    {
+      apr_pool_t *task_pool = NULL;
+      verify_task_t *task;
+      svn_error_t *verify_err;
+      void *result;
+
+      svn_pool_clear(iterpool);
+
+      /* Keep the workers busy but don't run too far ahead of the
+       * revision to report next. */
+      while (   !err
+             && next_rev <= end_rev
+             && svn_task__queue_size(queue) < max_pending)
+        err = push_revision_task(queue, next_rev++);
+
+      if (!err && cancel_func)
+        err = cancel_func(cancel_baton);
+      if (err)
+        break;
+
+      verify_err = svn_task__queue_pop(&result, (void **)&task, &task_pool,
+                                       queue);
+      if (!task_pool)
+        {
+          err = verify_err;
+          break;
+        }
+
+      /* Replay the worker's notifications as if we had run it here. */
+      for (i = 0; notify_func && i < task->notifications->nelts; ++i)
+        notify_func(notify_baton,
+                    APR_ARRAY_IDX(task->notifications, i,
+                                  svn_repos_notify_t *),
+                    iterpool);
+
+      if (verify_err && verify_err->apr_err == SVN_ERR_CANCELLED)
+        {
+          err = verify_err;
+        }
+      else if (verify_err)
+        {
+          err = report_error(rev, verify_err, verify_callback, verify_baton,
+                             iterpool);
+        }
+      else if (notify_func)
+        {
+          /* Tell the caller that we're done with this revision. */
+          notify->revision = rev;
+          notify_func(notify_baton, notify, iterpool);
+        }
+
+      svn_pool_destroy(task_pool);
+    }
+
+  /* Stop all workers and wait for them to finish. */
+  svn_atomic_set(&workers->cancelled, TRUE);
+  if (queue)
+    svn_error_clear(svn_task__queue_shutdown(queue));
+  svn_pool_destroy(queue_pool);
+
+  for (i = 0; i < workers->fs_pools->nelts; ++i)
+    svn_pool_destroy(APR_ARRAY_IDX(workers->fs_pools, i, apr_pool_t *));
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+#endif
+
 svn_error_t *
-svn_repos_verify_fs3(svn_repos_t *repos,
+svn_repos_verify_fs4(svn_repos_t *repos,
                      svn_revnum_t start_rev,
                      svn_revnum_t end_rev,
                      svn_boolean_t check_normalization,
                      svn_boolean_t metadata_only,
+                     int jobs,
                      svn_repos_notify_func_t notify_func,
                      void *notify_baton,
                      svn_repos_verify_callback_t verify_callback,
@@ -2480,8 +2748,14 @@ svn_repos_verify_fs3(svn_repos_t *repos,
   svn_repos_notify_t *notify;
   svn_fs_progress_notify_func_t verify_notify = NULL;
   struct verify_fs_notify_func_baton_t *verify_notify_baton = NULL;
+  apr_hash_t *fs_config;
   svn_error_t *err;
 
+  /* All worker threads use the process-global cache.  Don't start any
+   * if that cache is not thread-safe. */
+  if (jobs > 1 && !svn_cache__global_membuffer_cache_is_thread_safe())
+    jobs = 1;
+
   /* Make sure we catch up on the latest revprop changes.  This is the only
    * time we will refresh the revprop data in this query. */
   SVN_ERR(svn_fs_refresh_revision_props(fs, pool));
@@ -2521,8 +2795,19 @@ svn_repos_verify_fs3(svn_repos_t *repos,
         = svn_repos_notify_create(svn_repos_notify_verify_rev_structure, pool);
     }
 
+  /* Let the backend use multiple threads as well. */
+  fs_config = svn_fs_config(fs, pool);
+  if (jobs > 1)
+    {
+      if (!fs_config)
+        fs_config = apr_hash_make(pool);
+
+      svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_VERIFY_JOBS,
+                    apr_itoa(pool, jobs));
+    }
+
   /* Verify global metadata and backend-specific data first. */
-  err = svn_fs_verify(svn_fs_path(fs, pool), svn_fs_config(fs, pool),
+  err = svn_fs_verify(svn_fs_path(fs, pool), fs_config,
                       start_rev, end_rev,
                       verify_notify, verify_notify_baton,
                       cancel_func, cancel_baton, pool);
@@ -2537,6 +2822,16 @@ svn_repos_verify_fs3(svn_repos_t *repos,
                            verify_baton, iterpool));
     }
 
+#if APR_HAS_THREADS
+  if (!metadata_only && jobs > 1 && start_rev < end_rev)
+    SVN_ERR(verify_revisions_concurrently(fs, start_rev, end_rev,
+                                          check_normalization, jobs,
+                                          notify, notify_func, notify_baton,
+                                          verify_callback, verify_baton,
+                                          cancel_func, cancel_baton,
+                                          pool));
+  else
+#endif
   if (!metadata_only)
     for (rev = start_rev; rev <= end_rev; rev++)
       {
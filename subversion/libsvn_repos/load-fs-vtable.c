@@ -1272,22 +1272,23 @@ svn_repos_get_fs_build_parser6(const svn_repos_parse_fns3_t **callbacks,
 
 
 svn_error_t *
-svn_repos_load_fs6(svn_repos_t *repos,
-                   svn_stream_t *dumpstream,
-                   svn_revnum_t start_rev,
-                   svn_revnum_t end_rev,
-                   enum svn_repos_load_uuid uuid_action,
-                   const char *parent_dir,
-                   svn_boolean_t use_pre_commit_hook,
-                   svn_boolean_t use_post_commit_hook,
-                   svn_boolean_t validate_props,
-                   svn_boolean_t ignore_dates,
-                   svn_boolean_t normalize_props,
-                   svn_repos_notify_func_t notify_func,
-                   void *notify_baton,
-                   svn_cancel_func_t cancel_func,
-                   void *cancel_baton,
-                   apr_pool_t *pool)
+svn_repos__load_fs_pipelined(svn_repos_t *repos,
+                             svn_stream_t *dumpstream,
+                             svn_revnum_t start_rev,
+                             svn_revnum_t end_rev,
+                             enum svn_repos_load_uuid uuid_action,
+                             const char *parent_dir,
+                             svn_boolean_t use_pre_commit_hook,
+                             svn_boolean_t use_post_commit_hook,
+                             svn_boolean_t validate_props,
+                             svn_boolean_t ignore_dates,
+                             svn_boolean_t normalize_props,
+                             int jobs,
+                             svn_repos_notify_func_t notify_func,
+                             void *notify_baton,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *pool)
 {
   const svn_repos_parse_fns3_t *parser;
   void *parse_baton;
@@ -1309,8 +1310,43 @@ svn_repos_load_fs6(svn_repos_t *repos,
                                          notify_baton,
                                          pool));
 
-  return svn_repos_parse_dumpstream3(dumpstream, parser, parse_baton, FALSE,
-                                     cancel_func, cancel_baton, pool);
+  return svn_repos__parse_dumpstream_pipelined(dumpstream, parser,
+                                               parse_baton, jobs,
+                                               cancel_func, cancel_baton,
+                                               pool);
+}
+
+svn_error_t *
+svn_repos_load_fs6(svn_repos_t *repos,
+                   svn_stream_t *dumpstream,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   enum svn_repos_load_uuid uuid_action,
+                   const char *parent_dir,
+                   svn_boolean_t use_pre_commit_hook,
+                   svn_boolean_t use_post_commit_hook,
+                   svn_boolean_t validate_props,
+                   svn_boolean_t ignore_dates,
+                   svn_boolean_t normalize_props,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool)
+{
+  return svn_error_trace(svn_repos__load_fs_pipelined(repos, dumpstream,
+                                                      start_rev, end_rev,
+                                                      uuid_action,
+                                                      parent_dir,
+                                                      use_pre_commit_hook,
+                                                      use_post_commit_hook,
+                                                      validate_props,
+                                                      ignore_dates,
+                                                      normalize_props,
+                                                      1, notify_func,
+                                                      notify_baton,
+                                                      cancel_func,
+                                                      cancel_baton, pool));
 }
 
 /*----------------------------------------------------------------------*/
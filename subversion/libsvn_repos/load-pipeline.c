@@ -0,0 +1,819 @@
+/* load-pipeline.c --- parse a dumpstream ahead of its consumer
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* The pipeline consists of three stages:
+ *
+ * 1. A reader thread runs the standard dumpstream parser with a vtable
+ *    that records all callbacks of one revision in a "batch".  Texts
+ *    are buffered in spill buffers, i.e. in memory or in temp files.
+ *
+ * 2. Worker threads decode the svndiff data of text deltas in each
+ *    batch, so the expensive decompression does not happen on the
+ *    committing thread.
+ *
+ * 3. The caller's thread replays the batches strictly in stream order
+ *    against the consumer's vtable.  Thus, the consumer sees exactly the
+ *    same sequence of callbacks as with svn_repos_parse_dumpstream3().
+ */
+
+#include "svn_private_config.h"
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_delta.h"
+#include "svn_repos.h"
+#include "svn_string.h"
+#include "repos.h"
+
+#include "private/svn_subr_private.h"
+#include "private/svn_task.h"
+
+#if APR_HAS_THREADS
+
+/* Block size and in-memory limit of the spill buffers used to hold the
+ * text contents. */
+#define TEXT_BLOCKSIZE SVN__STREAM_CHUNK_SIZE
+#define TEXT_MAXSIZE (64 * 1024)
+
+/* Text deltas up to this size get decoded ahead of time.  Larger deltas
+ * get decoded when replaying them to keep memory usage in check. */
+#define MAX_DECODED_DELTA (256 * 1024)
+
+/* Types of recorded parser callbacks. */
+typedef enum event_kind_t
+{
+  event_magic_header,
+  event_uuid,
+  event_new_revision,
+  event_new_node,
+  event_set_revision_property,
+  event_set_node_property,
+  event_delete_node_property,
+  event_remove_node_props,
+  event_text,
+  event_close_node,
+  event_close_revision
+} event_kind_t;
+
+/* Contents of a text block. */
+typedef struct text_t
+{
+  /* Whether this is an svndiff delta rather than a fulltext. */
+  svn_boolean_t is_delta;
+
+  /* The raw text block, unless it got decoded.  Exactly one of CONTENT,
+   * DATA and WINDOWS is set. */
+  svn_spillbuf_t *content;
+
+  /* Like CONTENT but read into memory already. */
+  svn_stringbuf_t *data;
+
+  /* Decoded delta windows (svn_txdelta_window_t *). */
+  apr_array_header_t *windows;
+} text_t;
+
+/* A single recorded parser callback. */
+typedef struct event_t
+{
+  event_kind_t kind;
+
+  /* Dumpfile format version for event_magic_header. */
+  int version;
+
+  /* UUID or property name. */
+  const char *name;
+
+  /* Property value. */
+  const svn_string_t *value;
+
+  /* Headers of revision and node records. */
+  apr_hash_t *headers;
+
+  /* Text block for event_text. */
+  text_t *text;
+} event_t;
+
+/* All events from the end of the previous revision up to and including
+ * the close_revision callback of the next revision.  Each batch has its
+ * own root pool. */
+typedef struct batch_t
+{
+  /* The events (event_t *) in stream order. */
+  apr_array_header_t *events;
+
+  /* Set for the empty batch that signals the end of the stream. */
+  svn_boolean_t is_last;
+} batch_t;
+
+/* Baton for the recording vtable, used as parse, revision and node baton. */
+typedef struct recorder_t
+{
+  /* Push completed batches into this queue. */
+  svn_task__queue_t *queue;
+
+  /* Batch currently being recorded and its pool.  May be NULL. */
+  batch_t *batch;
+  apr_pool_t *batch_pool;
+
+  /* Headers of the current revision or node record. */
+  apr_hash_t *headers;
+
+  /* Dumpstream to parse. */
+  svn_stream_t *stream;
+
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} recorder_t;
+
+/* Return a new event of KIND, appended to the current batch in RECORDER. */
+static event_t *
+add_event(recorder_t *recorder,
+          event_kind_t kind)
+{
+  event_t *event;
+
+  if (!recorder->batch)
+    {
+      recorder->batch_pool = svn_pool_create(NULL);
+      recorder->batch = apr_pcalloc(recorder->batch_pool,
+                                    sizeof(*recorder->batch));
+      recorder->batch->events = apr_array_make(recorder->batch_pool, 16,
+                                               sizeof(event));
+    }
+
+  event = apr_pcalloc(recorder->batch_pool, sizeof(*event));
+  event->kind = kind;
+  APR_ARRAY_PUSH(recorder->batch->events, event_t *) = event;
+
+  return event;
+}
+
+/* Hand the current batch in RECORDER over to the next pipeline stage. */
+static svn_error_t *
+finish_batch(recorder_t *recorder)
+{
+  batch_t *batch = recorder->batch;
+  apr_pool_t *batch_pool = recorder->batch_pool;
+
+  if (!batch)
+    return SVN_NO_ERROR;
+
+  recorder->batch = NULL;
+  recorder->batch_pool = NULL;
+
+  return svn_error_trace(svn_task__queue_push(recorder->queue, batch,
+                                              batch_pool));
+}
+
+/* Return a deep copy of HEADERS allocated in RESULT_POOL. */
+static apr_hash_t *
+copy_headers(apr_hash_t *headers,
+             apr_pool_t *result_pool)
+{
+  apr_hash_t *result = apr_hash_make(result_pool);
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(result_pool, headers); hi; hi = apr_hash_next(hi))
+    svn_hash_sets(result,
+                  apr_pstrdup(result_pool, apr_hash_this_key(hi)),
+                  apr_pstrdup(result_pool, apr_hash_this_val(hi)));
+
+  return result;
+}
+
+/* Implements svn_repos_parse_fns3_t.magic_header_record. */
+static svn_error_t *
+record_magic_header(int version,
+                    void *parse_baton,
+                    apr_pool_t *pool)
+{
+  add_event(parse_baton, event_magic_header)->version = version;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_parse_fns3_t.uuid_record. */
+static svn_error_t *
+record_uuid(const char *uuid,
+            void *parse_baton,
+            apr_pool_t *pool)
+{
+  recorder_t *recorder = parse_baton;
+  event_t *event = add_event(recorder, event_uuid);
+  event->name = apr_pstrdup(recorder->batch_pool, uuid);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_parse_fns3_t.new_revision_record. */
+static svn_error_t *
+record_new_revision(void **revision_baton,
+                    apr_hash_t *headers,
+                    void *parse_baton,
+                    apr_pool_t *pool)
+{
+  recorder_t *recorder = parse_baton;
+  event_t *event = add_event(recorder, event_new_revision);
+  event->headers = copy_headers(headers, recorder->batch_pool);
+
+  recorder->headers = event->headers;
+  *revision_baton = recorder;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_parse_fns3_t.new_node_record. */
+static svn_error_t *
+record_new_node(void **node_baton,
+                apr_hash_t *headers,
+                void *revision_baton,
+                apr_pool_t *pool)
+{
+  recorder_t *recorder = revision_baton;
+  event_t *event = add_event(recorder, event_new_node);
+  event->headers = copy_headers(headers, recorder->batch_pool);
+
+  recorder->headers = event->headers;
+  *node_baton = recorder;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_parse_fns3_t.set_revision_property. */
+static svn_error_t *
+record_set_revision_property(void *revision_baton,
+                             const char *name,
+                             const svn_string_t *value)
+{
+  recorder_t *recorder = revision_baton;
+  event_t *event = add_event(recorder, event_set_revision_property);
+  event->name = apr_pstrdup(recorder->batch_pool, name);
+  event->value = svn_string_dup(value, recorder->batch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_parse_fns3_t.set_node_property. */
+static svn_error_t *
+record_set_node_property(void *node_baton,
+                         const char *name,
+                         const svn_string_t *value)
+{
+  recorder_t *recorder = node_baton;
+  event_t *event = add_event(recorder, event_set_node_property);
+  event->name = apr_pstrdup(recorder->batch_pool, name);
+  event->value = svn_string_dup(value, recorder->batch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_parse_fns3_t.delete_node_property. */
+static svn_error_t *
+record_delete_node_property(void *node_baton,
+                            const char *name)
+{
+  recorder_t *recorder = node_baton;
+  event_t *event = add_event(recorder, event_delete_node_property);
+  event->name = apr_pstrdup(recorder->batch_pool, name);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_parse_fns3_t.remove_node_props. */
+static svn_error_t *
+record_remove_node_props(void *node_baton)
+{
+  add_event(node_baton, event_remove_node_props);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_parse_fns3_t.set_fulltext.
+ *
+ * The parser runs with DELTAS_ARE_TEXT set, so this receives the raw
+ * svndiff data of text deltas as well. */
+static svn_error_t *
+record_text(svn_stream_t **stream,
+            void *node_baton)
+{
+  recorder_t *recorder = node_baton;
+  event_t *event = add_event(recorder, event_text);
+  const char *delta = svn_hash_gets(recorder->headers,
+                                    SVN_REPOS_DUMPFILE_TEXT_DELTA);
+
+  event->text = apr_pcalloc(recorder->batch_pool, sizeof(*event->text));
+  event->text->is_delta = delta && strcmp(delta, "true") == 0;
+  event->text->content = svn_spillbuf__create(TEXT_BLOCKSIZE, TEXT_MAXSIZE,
+                                              recorder->batch_pool);
+
+  *stream = svn_stream__from_spillbuf(event->text->content,
+                                      recorder->batch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_parse_fns3_t.close_node. */
+static svn_error_t *
+record_close_node(void *node_baton)
+{
+  add_event(node_baton, event_close_node);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_parse_fns3_t.close_revision. */
+static svn_error_t *
+record_close_revision(void *revision_baton)
+{
+  recorder_t *recorder = revision_baton;
+  add_event(recorder, event_close_revision);
+
+  return svn_error_trace(finish_batch(recorder));
+}
+
+/* Implements svn_task__process_func_t.  Parse the dumpstream given by the
+ * recorder_t in TASK and push the batches into its queue.  Note that this
+ * task runs on a separate thread while the caller replays the batches.
+ */
+static svn_error_t *
+read_dumpstream(void **result,
+                void *task,
+                void *process_baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  recorder_t *recorder = task;
+  const svn_repos_parse_fns3_t *parse_fns = process_baton;
+  svn_error_t *err;
+  batch_t *last;
+  apr_pool_t *last_pool;
+
+  err = svn_repos_parse_dumpstream3(recorder->stream, parse_fns, recorder,
+                                    TRUE, recorder->cancel_func,
+                                    recorder->cancel_baton, scratch_pool);
+
+  /* Even if parsing failed, pass the incomplete batch on such that the
+   * consumer gets all callbacks up to the failure - just like the
+   * non-pipelined parser would do.  Then signal the end of the stream.
+   * The consumer will fetch ERR from our queue afterwards. */
+  err = svn_error_compose_create(err, finish_batch(recorder));
+
+  last_pool = svn_pool_create(NULL);
+  last = apr_pcalloc(last_pool, sizeof(*last));
+  last->is_last = TRUE;
+  err = svn_error_compose_create(err, svn_task__queue_push(recorder->queue,
+                                                           last, last_pool));
+
+  *result = NULL;
+
+  return svn_error_trace(err);
+}
+
+/* Implements svn_txdelta_window_handler_t.  Append a copy of WINDOW to
+ * the array of windows in BATON. */
+static svn_error_t *
+collect_window(svn_txdelta_window_t *window,
+               void *baton)
+{
+  apr_array_header_t *windows = baton;
+
+  if (window)
+    APR_ARRAY_PUSH(windows, svn_txdelta_window_t *)
+      = svn_txdelta_window_dup(window, windows->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the remaining contents of BUF into a new *DATA allocated in
+ * RESULT_POOL.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+read_spillbuf(svn_stringbuf_t **data,
+              svn_spillbuf_t *buf,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  *data = svn_stringbuf_create_ensure((apr_size_t)svn_spillbuf__get_size(buf),
+                                      result_pool);
+  while (TRUE)
+    {
+      const char *block;
+      apr_size_t len;
+
+      SVN_ERR(svn_spillbuf__read(&block, &len, buf, scratch_pool));
+      if (!block)
+        break;
+
+      svn_stringbuf_appendbytes(*data, block, len);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* If TEXT is a reasonably small delta, decode it into windows allocated
+ * in RESULT_POOL.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+decode_text(text_t *text,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *windows;
+  svn_stream_t *stream;
+  apr_size_t len;
+  svn_error_t *err;
+
+  if (   !text->is_delta
+      || svn_spillbuf__get_size(text->content) > MAX_DECODED_DELTA)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(read_spillbuf(&text->data, text->content, result_pool,
+                        scratch_pool));
+  text->content = NULL;
+
+  windows = apr_array_make(result_pool, 4, sizeof(svn_txdelta_window_t *));
+  stream = svn_txdelta_parse_svndiff(collect_window, windows, TRUE,
+                                     scratch_pool);
+  len = text->data->len;
+  err = svn_stream_write(stream, text->data->data, &len);
+  if (!err)
+    err = svn_stream_close(stream);
+
+  /* The consumer may not even be interested in this text.  Thus, don't
+   * report invalid data here but leave it to the replay to do so. */
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  text->windows = windows;
+  text->data = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  Decode the text deltas in the
+ * batch_t given as TASK and return the batch as *RESULT. */
+static svn_error_t *
+prepare_batch(void **result,
+              void *task,
+              void *process_baton,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  batch_t *batch = task;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; !batch->is_last && i < batch->events->nelts; ++i)
+    {
+      event_t *event = APR_ARRAY_IDX(batch->events, i, event_t *);
+
+      svn_pool_clear(iterpool);
+      if (event->kind == event_text)
+        SVN_ERR(decode_text(event->text, result_pool, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  *result = batch;
+
+  return SVN_NO_ERROR;
+}
+
+/* Send the contents of TEXT to STREAM and close it.  Use SCRATCH_POOL for
+ * temporaries. */
+static svn_error_t *
+send_text(svn_stream_t *stream,
+          text_t *text,
+          apr_pool_t *scratch_pool)
+{
+  if (text->data)
+    {
+      apr_size_t len = text->data->len;
+      SVN_ERR(svn_stream_write(stream, text->data->data, &len));
+    }
+  else
+    {
+      while (TRUE)
+        {
+          const char *block;
+          apr_size_t len;
+
+          SVN_ERR(svn_spillbuf__read(&block, &len, text->content,
+                                     scratch_pool));
+          if (!block)
+            break;
+
+          SVN_ERR(svn_stream_write(stream, block, &len));
+        }
+    }
+
+  return svn_error_trace(svn_stream_close(stream));
+}
+
+/* Replay TEXT to the PARSE_FNS callbacks for RECORD_BATON.  Use POOL for
+ * allocations. */
+static svn_error_t *
+replay_text(text_t *text,
+            const svn_repos_parse_fns3_t *parse_fns,
+            void *record_baton,
+            apr_pool_t *pool)
+{
+  svn_stream_t *stream = NULL;
+
+  if (text->is_delta)
+    {
+      svn_txdelta_window_handler_t wh = NULL;
+      void *whb;
+
+      if (parse_fns->apply_textdelta)
+        SVN_ERR(parse_fns->apply_textdelta(&wh, &whb, record_baton));
+      if (!wh)
+        return SVN_NO_ERROR;
+
+      if (text->windows)
+        {
+          int i;
+          for (i = 0; i < text->windows->nelts; ++i)
+            SVN_ERR(wh(APR_ARRAY_IDX(text->windows, i,
+                                     svn_txdelta_window_t *), whb));
+
+          return svn_error_trace(wh(NULL, whb));
+        }
+
+      stream = svn_txdelta_parse_svndiff(wh, whb, TRUE, pool);
+    }
+  else if (parse_fns->set_fulltext)
+    {
+      SVN_ERR(parse_fns->set_fulltext(&stream, record_baton));
+    }
+
+  if (!stream)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(send_text(stream, text, pool));
+}
+
+/* State of the replay stage that persists across batches. */
+typedef struct replay_t
+{
+  /* The consumer's vtable and parse baton. */
+  const svn_repos_parse_fns3_t *parse_fns;
+  void *parse_baton;
+
+  /* Current revision and node batons.  May be NULL. */
+  void *rev_baton;
+  void *node_baton;
+
+  /* Whether we are within a node record. */
+  svn_boolean_t in_node;
+
+  /* Pools as used by svn_repos_parse_dumpstream3(). */
+  apr_pool_t *pool;
+  apr_pool_t *revpool;
+  apr_pool_t *nodepool;
+} replay_t;
+
+/* Replay all events in BATCH to the consumer in REPLAY. */
+static svn_error_t *
+replay_batch(replay_t *replay,
+             batch_t *batch)
+{
+  const svn_repos_parse_fns3_t *parse_fns = replay->parse_fns;
+  int i;
+
+  for (i = 0; i < batch->events->nelts; ++i)
+    {
+      event_t *event = APR_ARRAY_IDX(batch->events, i, event_t *);
+
+      switch (event->kind)
+        {
+          case event_magic_header:
+            if (parse_fns->magic_header_record)
+              SVN_ERR(parse_fns->magic_header_record(event->version,
+                                                     replay->parse_baton,
+                                                     replay->pool));
+            break;
+
+          case event_uuid:
+            if (parse_fns->uuid_record)
+              SVN_ERR(parse_fns->uuid_record(event->name,
+                                             replay->parse_baton,
+                                             replay->pool));
+            break;
+
+          case event_new_revision:
+            replay->rev_baton = NULL;
+            if (parse_fns->new_revision_record)
+              SVN_ERR(parse_fns->new_revision_record(&replay->rev_baton,
+                                                     event->headers,
+                                                     replay->parse_baton,
+                                                     replay->revpool));
+            break;
+
+          case event_new_node:
+            replay->node_baton = NULL;
+            replay->in_node = TRUE;
+            if (parse_fns->new_node_record)
+              SVN_ERR(parse_fns->new_node_record(&replay->node_baton,
+                                                 event->headers,
+                                                 replay->rev_baton,
+                                                 replay->nodepool));
+            break;
+
+          case event_set_revision_property:
+            if (parse_fns->set_revision_property)
+              SVN_ERR(parse_fns->set_revision_property(replay->rev_baton,
+                                                       event->name,
+                                                       event->value));
+            break;
+
+          case event_set_node_property:
+            if (parse_fns->set_node_property)
+              SVN_ERR(parse_fns->set_node_property(replay->node_baton,
+                                                   event->name,
+                                                   event->value));
+            break;
+
+          case event_delete_node_property:
+            if (parse_fns->delete_node_property)
+              SVN_ERR(parse_fns->delete_node_property(replay->node_baton,
+                                                      event->name));
+            break;
+
+          case event_remove_node_props:
+            if (parse_fns->remove_node_props)
+              SVN_ERR(parse_fns->remove_node_props(replay->node_baton));
+            break;
+
+          case event_text:
+            /* Text blocks of revision records go to the revision baton. */
+            SVN_ERR(replay_text(event->text, parse_fns,
+                                replay->in_node ? replay->node_baton
+                                                : replay->rev_baton,
+                                replay->in_node ? replay->nodepool
+                                                : replay->revpool));
+            break;
+
+          case event_close_node:
+            if (parse_fns->close_node)
+              SVN_ERR(parse_fns->close_node(replay->node_baton));
+            replay->node_baton = NULL;
+            replay->in_node = FALSE;
+            svn_pool_clear(replay->nodepool);
+            break;
+
+          case event_close_revision:
+            /* Like the parser, only close revisions that got opened. */
+            if (replay->rev_baton && parse_fns->close_revision)
+              SVN_ERR(parse_fns->close_revision(replay->rev_baton));
+            replay->rev_baton = NULL;
+            svn_pool_clear(replay->revpool);
+            break;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Pop batches from PREPARED and replay them using REPLAY until the end of
+ * the stream has been reached.  Then, return the parser result from
+ * READER.  Check for cancellation using CANCEL_FUNC and CANCEL_BATON. */
+static svn_error_t *
+run_pipeline(replay_t *replay,
+             svn_task__queue_t *prepared,
+             svn_task__queue_t *reader,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton)
+{
+  void *result;
+  apr_pool_t *reader_pool = NULL;
+  svn_error_t *err;
+
+  while (TRUE)
+    {
+      batch_t *batch;
+      apr_pool_t *batch_pool = NULL;
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      err = svn_task__queue_pop(&result, NULL, &batch_pool, prepared);
+      batch = result;
+      if (!err && !batch->is_last)
+        err = replay_batch(replay, batch);
+      else if (!err)
+        batch = NULL;
+
+      if (batch_pool)
+        svn_pool_destroy(batch_pool);
+      SVN_ERR(err);
+
+      if (!batch)
+        break;
+    }
+
+  err = svn_task__queue_pop(&result, NULL, &reader_pool, reader);
+  if (reader_pool)
+    svn_pool_destroy(reader_pool);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
+svn_error_t *
+svn_repos__parse_dumpstream_pipelined(svn_stream_t *stream,
+                                      const svn_repos_parse_fns3_t *parse_fns,
+                                      void *parse_baton,
+                                      int jobs,
+                                      svn_cancel_func_t cancel_func,
+                                      void *cancel_baton,
+                                      apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  svn_repos_parse_fns3_t *recorder_fns;
+  recorder_t *recorder;
+  replay_t replay = { 0 };
+  svn_task__queue_t *prepared;
+  svn_task__queue_t *reader;
+  apr_pool_t *queue_pool;
+  apr_pool_t *reader_pool;
+  svn_error_t *err;
+
+  /* Without concurrency, there is no point in pipelining. */
+  if (jobs <= 1)
+#endif
+    return svn_error_trace(svn_repos_parse_dumpstream3(stream, parse_fns,
+                                                       parse_baton, FALSE,
+                                                       cancel_func,
+                                                       cancel_baton, pool));
+
+#if APR_HAS_THREADS
+  recorder_fns = apr_pcalloc(pool, sizeof(*recorder_fns));
+  recorder_fns->magic_header_record = record_magic_header;
+  recorder_fns->uuid_record = record_uuid;
+  recorder_fns->new_revision_record = record_new_revision;
+  recorder_fns->new_node_record = record_new_node;
+  recorder_fns->set_revision_property = record_set_revision_property;
+  recorder_fns->set_node_property = record_set_node_property;
+  recorder_fns->delete_node_property = record_delete_node_property;
+  recorder_fns->remove_node_props = record_remove_node_props;
+  recorder_fns->set_fulltext = record_text;
+  recorder_fns->close_node = record_close_node;
+  recorder_fns->close_revision = record_close_revision;
+
+  /* One thread is busy reading, the others are decoding.  Allow for
+   * enough pending batches to keep all of them busy. */
+  queue_pool = svn_pool_create(pool);
+  SVN_ERR(svn_task__queue_create(&prepared, jobs - 1, 2 * jobs,
+                                 prepare_batch, NULL, queue_pool));
+  SVN_ERR(svn_task__queue_create(&reader, 1, 0, read_dumpstream,
+                                 recorder_fns, queue_pool));
+
+  recorder = apr_pcalloc(pool, sizeof(*recorder));
+  recorder->queue = prepared;
+  recorder->stream = stream;
+  recorder->cancel_func = cancel_func;
+  recorder->cancel_baton = cancel_baton;
+
+  reader_pool = svn_pool_create(NULL);
+  SVN_ERR(svn_task__queue_push(reader, recorder, reader_pool));
+
+  replay.parse_fns = parse_fns;
+  replay.parse_baton = parse_baton;
+  replay.pool = pool;
+  replay.revpool = svn_pool_create(pool);
+  replay.nodepool = svn_pool_create(pool);
+
+  err = run_pipeline(&replay, prepared, reader, cancel_func, cancel_baton);
+
+  /* Unblock the reader in case we bailed out early.  Destroying the queues
+   * will then wait for all threads to finish. */
+  svn_error_clear(svn_task__queue_shutdown(prepared));
+  svn_pool_destroy(queue_pool);
+
+  svn_pool_destroy(replay.revpool);
+  svn_pool_destroy(replay.nodepool);
+
+  return svn_error_trace(err);
+#endif
+}
@@ -362,6 +362,26 @@ svn_repos__hooks_post_unlock(svn_repos_t *repos,
                              const char *username,
                              apr_pool_t *pool);
 
+
+
+/*** Dump stream loading ***/
+
+/* Like svn_repos_parse_dumpstream3() with DELTAS_ARE_TEXT set to FALSE
+   but, if JOBS is larger than 1, read STREAM and decode its text deltas
+   on separate threads ahead of calling PARSE_FNS.  The PARSE_FNS
+   callbacks will still be invoked sequentially, in stream order and
+   from the calling thread only.  CANCEL_FUNC, however, may be called
+   from other threads.  */
+svn_error_t *
+svn_repos__parse_dumpstream_pipelined(svn_stream_t *stream,
+                                      const svn_repos_parse_fns3_t *parse_fns,
+                                      void *parse_baton,
+                                      int jobs,
+                                      svn_cancel_func_t cancel_func,
+                                      void *cancel_baton,
+                                      apr_pool_t *pool);
+
+
 
 /*** Utility Functions ***/
 
@@ -24,9 +24,12 @@
 #include <assert.h>
 #include <apr_md5.h>
 #include <apr_thread_rwlock.h>
+#include <apr_global_mutex.h>
+#include <apr_shm.h>
 
 #include "svn_pools.h"
 #include "svn_checksum.h"
+#include "svn_io.h"
 #include "svn_private_config.h"
 #include "svn_hash.h"
 #include "svn_string.h"
@@ -146,6 +149,53 @@
 #  define USE_SIMPLE_MUTEX 0
 #endif
 
+/* Even with a r/w lock, all readers of a segment still have to update
+ * the same lock object, i.e. its cache line bounces between the cores.
+ * Therefore, readers may first try to access a segment without taking any
+ * lock and detect concurrent modifications through a version counter,
+ * i.e. treat the segment like a seqlock.  Only if there was a concurrent
+ * write, the lookup will be repeated under the read lock.
+ *
+ * Readers place acquire fences around the data accesses such that
+ * neither the compiler nor the CPU may move them past the version checks.
+ * We still enable this only for x86 type CPUs, where the writer side does
+ * not need extra fences either.  Debug builds need to lock the segment
+ * to verify the tags.
+ */
+#if APR_HAS_THREADS && !USE_SIMPLE_MUTEX \
+    && !defined(SVN_DEBUG_CACHE_MEMBUFFER) \
+    && (defined(__i386__) || defined(__x86_64__)) \
+    && defined(__ATOMIC_ACQUIRE) \
+    && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8)
+#  define USE_OPTIMISTIC_READS 1
+#else
+#  define USE_OPTIMISTIC_READS 0
+#endif
+
+/* Increment the 64 bit statistics COUNTER of a cache segment.  Readers
+ * run concurrently, either under a shared lock or without any lock.
+ * Where the compiler provides lock-free 64 bit atomics, use those to not
+ * lose any counts.  Otherwise, the counters are purely approximate.
+ */
+#if defined(__ATOMIC_RELAXED) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8)
+#  define INCREMENT_STATISTICS(counter) \
+     ((void)__atomic_fetch_add(&(counter), 1, __ATOMIC_RELAXED))
+#else
+#  define INCREMENT_STATISTICS(counter) ((void)(counter)++)
+#endif
+
+/* A membuffer cache may be placed in anonymous shared memory, such that
+ * all processes forked from the creator after the cache has been created
+ * work on the same cache contents.  This requires fork() and the same
+ * address mapping in all processes.  We use process-global mutexes to
+ * serialize access to the cache segments in that case.
+ */
+#if APR_HAS_SHARED_MEMORY && APR_HAS_FORK && !defined(WIN32)
+#  define USE_SHARED_MEMORY 1
+#else
+#  define USE_SHARED_MEMORY 0
+#endif
+
 /* For more efficient copy operations, let's align all data items properly.
  * Since we can't portably align pointers, this is rather the item size
  * granularity which ensures *relative* alignment within the cache - still
@@ -777,8 +827,7 @@ struct svn_membuffer_t
 
   /* Total number of calls to membuffer_cache_get.
    * Purely statistical information that may be used for profiling only.
-   * Updates are not synchronized and values may be nonsensicle on some
-   * platforms.
+   * Updated through INCREMENT_STATISTICS.
    */
   apr_uint64_t total_reads;
 
@@ -791,8 +840,7 @@ struct svn_membuffer_t
 
   /* Total number of hits since the cache's creation.
    * Purely statistical information that may be used for profiling only.
-   * Updates are not synchronized and values may be nonsensicle on some
-   * platforms.
+   * Updated through INCREMENT_STATISTICS.
    */
   apr_uint64_t total_hits;
 
@@ -805,14 +853,38 @@ struct svn_membuffer_t
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
   /* Same for read-write lock. */
   apr_thread_rwlock_t *lock;
+#endif
+
+#if USE_SHARED_MEMORY
+  /* If not NULL, this segment lives in shared memory and this lock will
+   * be used instead of LOCK to serialize all access to it.  Readers and
+   * writers alike will acquire it exclusively.
+   */
+  apr_global_mutex_t *global_lock;
+
+  /* Set while a writer holds GLOBAL_LOCK.  Finding it set after acquiring
+   * the lock means that the previous writer died in the middle of its
+   * modifications and left the segment in an undefined state.
+   */
+  svn_boolean_t write_in_progress;
+#endif
 
+#if (APR_HAS_THREADS && !USE_SIMPLE_MUTEX) || USE_SHARED_MEMORY
   /* If set, write access will wait until they get exclusive access.
    * Otherwise, they will become no-ops if the segment is currently
-   * read-locked.  Only used when LOCK is an r/w lock.
+   * locked.  Only used when LOCK is an r/w lock or GLOBAL_LOCK is set.
    */
   svn_boolean_t allow_blocking_writes;
 #endif
 
+#if USE_OPTIMISTIC_READS
+  /* Incremented whenever the write lock gets acquired or released, i.e.
+   * it will be odd while there is a writer.  Lock-free readers use this
+   * to detect concurrent modifications of this segment.
+   */
+  svn_atomic_t write_version;
+#endif
+
   /* A write lock counter, must be either 0 or 1.
    * This one is only used in debug assertions to verify that you used
    * the correct multi-threading settings. */
@@ -823,11 +895,115 @@ struct svn_membuffer_t
  */
 #define ALIGN_VALUE(value) (((value) + ITEM_ALIGNMENT-1) & -ITEM_ALIGNMENT)
 
+/* Signal to lock-free readers that CACHE is about to be modified or
+ * that the modification has been completed, respectively.  Must be called
+ * while holding the write lock.
+ */
+static APR_INLINE void
+bump_write_version(svn_membuffer_t *cache)
+{
+#if USE_OPTIMISTIC_READS
+  svn_atomic_inc(&cache->write_version);
+#endif
+}
+
+/* Drop all contents of the segment CACHE.  The caller must hold the
+ * write lock.
+ */
+static void
+reset_segment(svn_membuffer_t *cache)
+{
+  /* Length of the group_initialized array in bytes.
+     See also svn_cache__membuffer_cache_create(). */
+  apr_size_t group_init_size
+    = 1 + (cache->group_count + cache->spare_group_count)
+            / (8 * GROUP_INIT_GRANULARITY);
+
+  /* Mark all groups as "not initialized", which implies "empty". */
+  cache->first_spare_group = NO_INDEX;
+  cache->max_spare_used = 0;
+
+  memset(cache->group_initialized, 0, group_init_size);
+
+  /* Unlink L1 contents. */
+  cache->l1.first = NO_INDEX;
+  cache->l1.last = NO_INDEX;
+  cache->l1.next = NO_INDEX;
+  cache->l1.current_data = cache->l1.start_offset;
+
+  /* Unlink L2 contents. */
+  cache->l2.first = NO_INDEX;
+  cache->l2.last = NO_INDEX;
+  cache->l2.next = NO_INDEX;
+  cache->l2.current_data = cache->l2.start_offset;
+
+  /* Reset content counters. */
+  cache->data_used = 0;
+  cache->used_entries = 0;
+}
+
+#if USE_SHARED_MEMORY
+/* Acquire the process-global lock of the shared segment CACHE.
+ * If WAIT is not set and the lock is currently held by someone else,
+ * set *SUCCESS to FALSE and return immediately.
+ *
+ * Processes may die while holding the lock.  The lock mechanisms that we
+ * use will release it in that case: SysV semaphores and fcntl locks are
+ * released by the OS and APR makes process-shared pthread mutexes robust
+ * where supported.  So, we may get a segment that a writer left in an
+ * inconsistent state.  Detect that and reset the segment before use.
+ */
+static svn_error_t *
+global_lock_cache(svn_membuffer_t *cache,
+                  svn_boolean_t wait,
+                  svn_boolean_t *success)
+{
+  apr_status_t status;
+  if (wait)
+    {
+      status = apr_global_mutex_lock(cache->global_lock);
+    }
+  else
+    {
+      status = apr_global_mutex_trylock(cache->global_lock);
+      if (APR_STATUS_IS_EBUSY(status))
+        {
+          *success = FALSE;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't lock shared cache mutex"));
+
+  if (cache->write_in_progress)
+    {
+      /* Make lock-free readers back off while we clean up.  The writer
+       * may or may not have bumped the version before it died. */
+#if USE_OPTIMISTIC_READS
+      if ((svn_atomic_read(&cache->write_version) & 1) == 0)
+        bump_write_version(cache);
+#endif
+
+      reset_segment(cache);
+      cache->write_in_progress = FALSE;
+      bump_write_version(cache);
+    }
+
+  return SVN_NO_ERROR;
+}
+#endif
+
 /* If locking is supported for CACHE, acquire a read lock for it.
  */
 static svn_error_t *
 read_lock_cache(svn_membuffer_t *cache)
 {
+#if USE_SHARED_MEMORY
+  if (cache->global_lock)
+    return global_lock_cache(cache, TRUE, NULL);
+#endif
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -851,6 +1027,24 @@ read_lock_cache(svn_membuffer_t *cache)
 static svn_error_t *
 write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
 {
+#if USE_SHARED_MEMORY
+  if (cache->global_lock)
+    {
+      svn_boolean_t locked = TRUE;
+      SVN_ERR(global_lock_cache(cache, cache->allow_blocking_writes,
+                                &locked));
+      if (!locked)
+        {
+          *success = FALSE;
+          return SVN_NO_ERROR;
+        }
+
+      cache->write_in_progress = TRUE;
+      bump_write_version(cache);
+      return SVN_NO_ERROR;
+    }
+#endif
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -867,7 +1061,7 @@ write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
           if (SVN_LOCK_IS_BUSY(status))
             {
               *success = FALSE;
-              status = APR_SUCCESS;
+              return SVN_NO_ERROR;
             }
         }
 
@@ -876,6 +1070,7 @@ write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
                                   _("Can't write-lock cache mutex"));
     }
 
+  bump_write_version(cache);
   return SVN_NO_ERROR;
 #else
   return SVN_NO_ERROR;
@@ -888,14 +1083,27 @@ write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
 static svn_error_t *
 force_write_lock_cache(svn_membuffer_t *cache)
 {
+#if USE_SHARED_MEMORY
+  if (cache->global_lock)
+    {
+      SVN_ERR(global_lock_cache(cache, TRUE, NULL));
+      cache->write_in_progress = TRUE;
+      bump_write_version(cache);
+      return SVN_NO_ERROR;
+    }
+#endif
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
-  apr_status_t status = apr_thread_rwlock_wrlock(cache->lock);
-  if (status)
-    return svn_error_wrap_apr(status,
-                              _("Can't write-lock cache mutex"));
+  {
+    apr_status_t status = apr_thread_rwlock_wrlock(cache->lock);
+    if (status)
+      return svn_error_wrap_apr(status,
+                                _("Can't write-lock cache mutex"));
+  }
 
+  bump_write_version(cache);
   return SVN_NO_ERROR;
 #else
   return SVN_NO_ERROR;
@@ -908,6 +1116,21 @@ force_write_lock_cache(svn_membuffer_t *cache)
 static svn_error_t *
 unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
 {
+#if USE_SHARED_MEMORY
+  if (cache->global_lock)
+    {
+      apr_status_t status = apr_global_mutex_unlock(cache->global_lock);
+      if (err)
+        return err;
+
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't unlock shared cache mutex"));
+
+      return SVN_NO_ERROR;
+    }
+#endif
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__unlock(cache->lock, err);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -927,6 +1150,19 @@ unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
 #endif
 }
 
+/* Release the write lock acquired by write_lock_cache or
+ * force_write_lock_cache for CACHE.  Return ERR upon success.
+ */
+static svn_error_t *
+write_unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
+{
+  bump_write_version(cache);
+#if USE_SHARED_MEMORY
+  cache->write_in_progress = FALSE;
+#endif
+  return unlock_cache(cache, err);
+}
+
 /* If supported, guard the execution of EXPR with a read lock to CACHE.
  * The macro has been modeled after SVN_MUTEX__WITH_LOCK.
  */
@@ -959,7 +1195,7 @@ do {                                                            \
       else                                                      \
         break;                                                  \
     }                                                           \
-  SVN_ERR(unlock_cache(cache, (expr)));                         \
+  SVN_ERR(write_unlock_cache(cache, (expr)));                   \
 } while (0)
 
 /* Returns 0 if the entry group identified by GROUP_INDEX in CACHE has not
@@ -1832,17 +2068,80 @@ ensure_data_insertable_l1(svn_membuffer_t *cache, apr_size_t size)
    * right answer. */
 }
 
-svn_error_t *
-svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
-                                  apr_size_t total_size,
-                                  apr_size_t directory_size,
-                                  apr_size_t segment_count,
-                                  svn_boolean_t thread_safe,
-                                  svn_boolean_t allow_blocking_writes,
-                                  apr_pool_t *pool)
+/* Allocate SIZE bytes from POOL and return them in *RESULT.  If SHARED
+ * is set, the memory will be taken from a new anonymous shared memory
+ * segment, i.e. it will be shared with all processes forked afterwards.
+ * Otherwise, *RESULT may be NULL if we ran out of memory.
+ */
+static svn_error_t *
+cache_alloc(void **result,
+            apr_size_t size,
+            svn_boolean_t shared,
+            apr_pool_t *pool)
+{
+#if USE_SHARED_MEMORY
+  if (shared)
+    {
+      apr_shm_t *shm;
+      apr_status_t status = apr_shm_create(&shm, size, NULL, pool);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't create shared memory for cache"));
+
+      *result = apr_shm_baseaddr_get(shm);
+      return SVN_NO_ERROR;
+    }
+#endif
+
+  *result = apr_palloc(pool, size);
+  return SVN_NO_ERROR;
+}
+
+#if USE_SHARED_MEMORY
+/* Create a new process-global mutex for a shared cache segment in *LOCK,
+ * allocated in POOL.  Prefer locking mechanisms that continue to work in
+ * forked child processes without re-initialization.
+ */
+static svn_error_t *
+create_global_lock(apr_global_mutex_t **lock,
+                   apr_pool_t *pool)
+{
+#if APR_HAS_PROC_PTHREAD_SERIALIZE
+  const apr_lockmech_e mech = APR_LOCK_PROC_PTHREAD;
+#elif APR_HAS_SYSVSEM_SERIALIZE
+  const apr_lockmech_e mech = APR_LOCK_SYSVSEM;
+#elif APR_HAS_FCNTL_SERIALIZE
+  const apr_lockmech_e mech = APR_LOCK_FCNTL;
+#else
+  const apr_lockmech_e mech = APR_LOCK_DEFAULT;
+#endif
+
+  apr_status_t status = apr_global_mutex_create(lock, NULL, mech, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create shared cache mutex"));
+
+  return SVN_NO_ERROR;
+}
+#endif
+
+/* Implement svn_cache__membuffer_cache_create and
+ * svn_cache__membuffer_cache_create_shared.  If SHARED is set, all cache
+ * structures will be placed in shared memory and the process-local prefix
+ * pool will not be used.
+ */
+static svn_error_t *
+membuffer_cache_create(svn_membuffer_t **cache,
+                       apr_size_t total_size,
+                       apr_size_t directory_size,
+                       apr_size_t segment_count,
+                       svn_boolean_t thread_safe,
+                       svn_boolean_t allow_blocking_writes,
+                       svn_boolean_t shared,
+                       apr_pool_t *pool)
 {
   svn_membuffer_t *c;
   prefix_pool_t *prefix_pool;
+  void *mem;
 
   apr_uint32_t seg;
   apr_uint32_t group_count;
@@ -1853,10 +2152,19 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   apr_uint64_t max_entry_size;
 
   /* Allocate 1% of the cache capacity to the prefix string pool.
+   * Prefix indexes are only valid within the process that assigned them,
+   * so shared caches must always store the full keys.
    */
-  SVN_ERR(prefix_pool_create(&prefix_pool, total_size / 100, thread_safe,
-                             pool));
-  total_size -= total_size / 100;
+  if (shared)
+    {
+      SVN_ERR(prefix_pool_create(&prefix_pool, 0, thread_safe, pool));
+    }
+  else
+    {
+      SVN_ERR(prefix_pool_create(&prefix_pool, total_size / 100, thread_safe,
+                                 pool));
+      total_size -= total_size / 100;
+    }
 
   /* Limit the total size (only relevant if we can address > 4GB)
    */
@@ -1911,7 +2219,10 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
     segment_count *= 2;
 
   /* allocate cache as an array of segments / cache objects */
-  c = apr_palloc(pool, segment_count * sizeof(*c));
+  SVN_ERR(cache_alloc(&mem, segment_count * sizeof(*c), shared, pool));
+  c = mem;
+  if (c == NULL)
+    return svn_error_wrap_apr(APR_ENOMEM, "OOM");
 
   /* Split total cache size into segments of equal size
    */
@@ -1978,12 +2289,16 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       /* Allocate but don't clear / zero the directory because it would add
          significantly to the server start-up time if the caches are large.
          Group initialization will take care of that in stead. */
-      c[seg].directory = apr_palloc(pool,
-                                    group_count * sizeof(entry_group_t));
+      SVN_ERR(cache_alloc(&mem, group_count * sizeof(entry_group_t),
+                          shared, pool));
+      c[seg].directory = mem;
 
       /* Allocate and initialize directory entries as "not initialized",
          hence "unused" */
-      c[seg].group_initialized = apr_pcalloc(pool, group_init_size);
+      SVN_ERR(cache_alloc(&mem, group_init_size, shared, pool));
+      c[seg].group_initialized = mem;
+      if (c[seg].group_initialized)
+        memset(c[seg].group_initialized, 0, group_init_size);
 
       /* Allocate 1/4th of the data buffer to L1
        */
@@ -2004,7 +2319,9 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       c[seg].l2.current_data = c[seg].l2.start_offset;
 
       /* This cast is safe because DATA_SIZE <= MAX_SEGMENT_SIZE. */
-      c[seg].data = apr_palloc(pool, (apr_size_t)ALIGN_VALUE(data_size));
+      SVN_ERR(cache_alloc(&mem, (apr_size_t)ALIGN_VALUE(data_size),
+                          shared, pool));
+      c[seg].data = mem;
       c[seg].data_used = 0;
       c[seg].max_entry_size = max_entry_size;
 
@@ -2016,7 +2333,9 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       /* were allocations successful?
        * If not, initialize a minimal cache structure.
        */
-      if (c[seg].data == NULL || c[seg].directory == NULL)
+      if (   c[seg].data == NULL
+          || c[seg].directory == NULL
+          || c[seg].group_initialized == NULL)
         {
           /* We are OOM. There is no need to proceed with "half a cache".
            */
@@ -2030,22 +2349,36 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
        */
       SVN_ERR(svn_mutex__init(&c[seg].lock, thread_safe, pool));
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
-      /* Same for read-write lock. */
+      /* Same for read-write lock.  Shared segments use GLOBAL_LOCK only. */
       c[seg].lock = NULL;
-      if (thread_safe)
+      if (thread_safe && !shared)
         {
           apr_status_t status =
               apr_thread_rwlock_create(&(c[seg].lock), pool);
           if (status)
             return svn_error_wrap_apr(status, _("Can't create cache mutex"));
         }
+#endif
 
+#if USE_SHARED_MEMORY
+      /* Serialize access from all processes sharing this segment.
+       */
+      c[seg].global_lock = NULL;
+      c[seg].write_in_progress = FALSE;
+      if (shared)
+        SVN_ERR(create_global_lock(&c[seg].global_lock, pool));
+#endif
+
+#if (APR_HAS_THREADS && !USE_SIMPLE_MUTEX) || USE_SHARED_MEMORY
       /* Select the behavior of write operations.
        */
       c[seg].allow_blocking_writes = allow_blocking_writes;
 #endif
       /* No writers at the moment. */
       c[seg].write_lock_count = 0;
+#if USE_OPTIMISTIC_READS
+      c[seg].write_version = 0;
+#endif
     }
 
   /* done here
@@ -2054,18 +2387,51 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
+                                  apr_size_t total_size,
+                                  apr_size_t directory_size,
+                                  apr_size_t segment_count,
+                                  svn_boolean_t thread_safe,
+                                  svn_boolean_t allow_blocking_writes,
+                                  apr_pool_t *pool)
+{
+  return svn_error_trace(membuffer_cache_create(cache, total_size,
+                                                directory_size,
+                                                segment_count,
+                                                thread_safe,
+                                                allow_blocking_writes,
+                                                FALSE, pool));
+}
+
+svn_error_t *
+svn_cache__membuffer_cache_create_shared(svn_membuffer_t **cache,
+                                         apr_size_t total_size,
+                                         apr_size_t directory_size,
+                                         apr_size_t segment_count,
+                                         svn_boolean_t allow_blocking_writes,
+                                         apr_pool_t *pool)
+{
+#if USE_SHARED_MEMORY
+  return svn_error_trace(membuffer_cache_create(cache, total_size,
+                                                directory_size,
+                                                segment_count,
+                                                TRUE,
+                                                allow_blocking_writes,
+                                                TRUE, pool));
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Shared memory caches are not supported "
+                            "on this platform"));
+#endif
+}
+
 svn_error_t *
 svn_cache__membuffer_clear(svn_membuffer_t *cache)
 {
   apr_size_t seg;
   apr_size_t segment_count = cache->segment_count;
 
-  /* Length of the group_initialized array in bytes.
-     See also svn_cache__membuffer_cache_create(). */
-  apr_size_t group_init_size
-    = 1 + (cache->group_count + cache->spare_group_count)
-            / (8 * GROUP_INIT_GRANULARITY);
-
   /* Clear segment by segment.  This implies that other thread may read
      and write to other segments after we cleared them and before the
      last segment is done.
@@ -2079,30 +2445,10 @@ svn_cache__membuffer_clear(svn_membuffer_t *cache)
       /* Unconditionally acquire the write lock. */
       SVN_ERR(force_write_lock_cache(&cache[seg]));
 
-      /* Mark all groups as "not initialized", which implies "empty". */
-      cache[seg].first_spare_group = NO_INDEX;
-      cache[seg].max_spare_used = 0;
-
-      memset(cache[seg].group_initialized, 0, group_init_size);
-
-      /* Unlink L1 contents. */
-      cache[seg].l1.first = NO_INDEX;
-      cache[seg].l1.last = NO_INDEX;
-      cache[seg].l1.next = NO_INDEX;
-      cache[seg].l1.current_data = cache[seg].l1.start_offset;
-
-      /* Unlink L2 contents. */
-      cache[seg].l2.first = NO_INDEX;
-      cache[seg].l2.last = NO_INDEX;
-      cache[seg].l2.next = NO_INDEX;
-      cache[seg].l2.current_data = cache[seg].l2.start_offset;
-
-      /* Reset content counters. */
-      cache[seg].data_used = 0;
-      cache[seg].used_entries = 0;
+      reset_segment(&cache[seg]);
 
       /* Segment may be used again. */
-      SVN_ERR(unlock_cache(&cache[seg], SVN_NO_ERROR));
+      SVN_ERR(write_unlock_cache(&cache[seg], SVN_NO_ERROR));
     }
 
   /* done here */
@@ -2367,7 +2713,7 @@ increment_hit_counters(svn_membuffer_t *cache, entry_t *entry)
   svn_atomic_inc(&entry->hit_count);
 
   /* That one is for stats only. */
-  cache->total_hits++;
+  INCREMENT_STATISTICS(cache->total_hits);
 }
 
 /* Look for the cache entry in group GROUP_INDEX of CACHE, identified
@@ -2394,7 +2740,7 @@ membuffer_cache_get_internal(svn_membuffer_t *cache,
   /* The actual cache data access needs to sync'ed
    */
   entry = find_entry(cache, group_index, to_find, FALSE);
-  cache->total_reads++;
+  INCREMENT_STATISTICS(cache->total_reads);
   if (entry == NULL)
     {
       /* no such entry found.
@@ -2433,6 +2779,145 @@ membuffer_cache_get_internal(svn_membuffer_t *cache,
   return SVN_NO_ERROR;
 }
 
+#if USE_OPTIMISTIC_READS
+
+/* Return TRUE if the WRITE_VERSION of CACHE still equals VERSION, i.e. if
+ * all data read from CACHE since VERSION had been taken is consistent.
+ * The acquire fence prevents those reads from being moved past the check.
+ */
+static APR_INLINE svn_boolean_t
+write_version_unchanged(svn_membuffer_t *cache,
+                        apr_uint32_t version)
+{
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return svn_atomic_read(&cache->write_version) == version;
+}
+
+/* Same as membuffer_cache_get_internal but without any locking.  Instead,
+ * the content of CACHE is only considered valid if its WRITE_VERSION was
+ * even before and has not changed after accessing the data.  Because the
+ * directory and the data buffer may be modified while we read them, all
+ * indexes and offsets are being range-checked before their use.
+ *
+ * Return TRUE if *BUFFER and *ITEM_SIZE contain a valid lookup result.
+ * Return FALSE if there was a concurrent write.  In that case, the caller
+ * must repeat the lookup with the read lock being held.
+ *
+ * Hits found here are counted in the segment statistics only.  The entry's
+ * own hit counter is not touched as the entry may get replaced by a writer
+ * at any time.
+ */
+static svn_boolean_t
+membuffer_cache_get_optimistic(svn_membuffer_t *cache,
+                               apr_uint32_t group_index,
+                               const full_key_t *to_find,
+                               char **buffer,
+                               apr_size_t *item_size,
+                               apr_pool_t *result_pool)
+{
+  apr_uint32_t version = svn_atomic_read(&cache->write_version);
+  apr_uint32_t group_limit;
+  apr_uint64_t data_size;
+  entry_t *entry = NULL;
+  entry_t found;
+  apr_size_t size;
+
+  /* Don't even try while there is an active writer. */
+  if (version & 1)
+    return FALSE;
+
+  /* Nothing of the segment may be read before VERSION. */
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  group_limit = cache->group_count + cache->spare_group_count;
+  data_size = cache->l1.size + cache->l2.size;
+
+  /* Same as find_entry(FIND_EMPTY=FALSE) but with added sanity checks.
+   */
+  if (is_group_initialized(cache, group_index))
+    {
+      entry_group_t *group = &cache->directory[group_index];
+      apr_uint32_t chain_length = 0;
+
+      while (entry == NULL)
+        {
+          apr_uint32_t used = group->header.used;
+          apr_uint32_t next = group->header.next;
+          apr_uint32_t i;
+
+          if (used > GROUP_SIZE)
+            return FALSE;
+
+          for (i = 0; i < used; ++i)
+            if (entry_keys_match(&group->entries[i].key,
+                                 &to_find->entry_key))
+              {
+                entry = &group->entries[i];
+                break;
+              }
+
+          if (entry || next == NO_INDEX)
+            break;
+
+          if (next >= group_limit || ++chain_length >= MAX_GROUP_CHAIN_LENGTH)
+            return FALSE;
+
+          group = &cache->directory[next];
+        }
+    }
+
+  /* Take a snapshot of the entry header.  It is only consistent if no
+   * writer got active in the meantime. */
+  if (entry)
+    found = *entry;
+
+  if (!write_version_unchanged(cache, version))
+    return FALSE;
+
+  if (entry == NULL)
+    {
+      *buffer = NULL;
+      *item_size = 0;
+      INCREMENT_STATISTICS(cache->total_reads);
+
+      return TRUE;
+    }
+
+  if (   found.key.key_len > found.size
+      || found.offset + ALIGN_VALUE(found.size) > data_size)
+    return FALSE;
+
+  /* Key conflict? */
+  if (   found.key.key_len
+      && memcmp(to_find->full_key.data, cache->data + found.offset,
+                found.key.key_len) != 0)
+    {
+      if (!write_version_unchanged(cache, version))
+        return FALSE;
+
+      *buffer = NULL;
+      *item_size = 0;
+      INCREMENT_STATISTICS(cache->total_reads);
+
+      return TRUE;
+    }
+
+  size = ALIGN_VALUE(found.size) - found.key.key_len;
+  *buffer = apr_palloc(result_pool, size);
+  memcpy(*buffer, cache->data + found.offset + found.key.key_len, size);
+
+  /* Was the data overwritten while we were copying it? */
+  if (!write_version_unchanged(cache, version))
+    return FALSE;
+
+  INCREMENT_STATISTICS(cache->total_reads);
+  INCREMENT_STATISTICS(cache->total_hits);
+  *item_size = found.size - found.key.key_len;
+
+  return TRUE;
+}
+
+#endif
+
 /* Look for the *ITEM identified by KEY. If no item has been stored
  * for KEY, *ITEM will be NULL. Otherwise, the DESERIALIZER is called
  * to re-construct the proper object from the serialized data.
@@ -2453,6 +2938,14 @@ membuffer_cache_get(svn_membuffer_t *cache,
   /* find the entry group that will hold the key.
    */
   group_index = get_group_index(&cache, &key->entry_key);
+
+  /* Try without locking first and fall back to the read lock only if
+   * there has been a concurrent write.
+   */
+#if USE_OPTIMISTIC_READS
+  if (!membuffer_cache_get_optimistic(cache, group_index, key, &buffer,
+                                      &size, result_pool))
+#endif
   WITH_READ_LOCK(cache,
                  membuffer_cache_get_internal(cache,
                                               group_index,
@@ -2515,7 +3008,7 @@ membuffer_cache_has_key(svn_membuffer_t *cache,
   /* find the entry group that will hold the key.
    */
   apr_uint32_t group_index = get_group_index(&cache, &key->entry_key);
-  cache->total_reads++;
+  INCREMENT_STATISTICS(cache->total_reads);
 
   WITH_READ_LOCK(cache,
                  membuffer_cache_has_key_internal(cache,
@@ -2549,7 +3042,7 @@ membuffer_cache_get_partial_internal(svn_membuffer_t *cache,
                                      apr_pool_t *result_pool)
 {
   entry_t *entry = find_entry(cache, group_index, to_find, FALSE);
-  cache->total_reads++;
+  INCREMENT_STATISTICS(cache->total_reads);
   if (entry == NULL)
     {
       *item = NULL;
@@ -2632,7 +3125,7 @@ membuffer_cache_set_partial_internal(svn_membuffer_t *cache,
   /* cache item lookup
    */
   entry_t *entry = find_entry(cache, group_index, to_find, FALSE);
-  cache->total_reads++;
+  INCREMENT_STATISTICS(cache->total_reads);
 
   /* this function is a no-op if the item is not in cache
    */
@@ -3478,3 +3971,327 @@ svn_cache__membuffer_get_global_info(apr_pool_t *pool)
 
   return info;
 }
+
+
+/* Cache snapshots.
+ *
+ * A snapshot is a sequence of records, one per cached item.  Each record
+ * starts with a RECORD_ENTRY byte and a snapshot_record_t header, followed
+ * by the key prefix (for items using a shared prefix), the full key (for
+ * all others), the debug tag (if enabled) and the serialized item data.
+ * A single RECORD_END byte terminates the snapshot.
+ *
+ * Integers are written in native byte order.  Snapshots are meant to warm
+ * up caches after a server restart, not to be moved between machines.
+ */
+
+/* Identifies the snapshot format, including byte order and key layout.
+ */
+#define SNAPSHOT_MAGIC (APR_UINT64_C(0x53564e4d42460000) + ITEM_ALIGNMENT)
+
+/* Record type markers. */
+#define RECORD_ENTRY 'E'
+#define RECORD_END 'Z'
+
+/* Fixed-size part of a snapshot record.
+ */
+typedef struct snapshot_record_t
+{
+  /* Entry key fingerprint.  It does not depend on process-local data. */
+  apr_uint64_t fingerprint[2];
+
+  /* Length of the full key in bytes.  0 for shared prefixes. */
+  apr_uint64_t key_len;
+
+  /* Length of the shared prefix string including the terminating NUL.
+   * 0 if the full key is being stored. */
+  apr_uint64_t prefix_len;
+
+  /* Length of the serialized item data. */
+  apr_uint64_t item_size;
+
+  /* Priority of the item. */
+  apr_uint64_t priority;
+} snapshot_record_t;
+
+/* Append the record for ENTRY in CACHE to BUFFER.  Set *PREFIX to the key
+ * prefix of that entry.  Call this with CACHE being read-locked.
+ */
+static void
+append_snapshot_record(svn_stringbuf_t *buffer,
+                       const char **prefix,
+                       svn_membuffer_t *cache,
+                       const entry_t *entry)
+{
+  snapshot_record_t record = { { 0 } };
+  const char *key = (const char *)cache->data + entry->offset;
+
+  record.fingerprint[0] = entry->key.fingerprint[0];
+  record.fingerprint[1] = entry->key.fingerprint[1];
+  record.key_len = entry->key.key_len;
+  record.item_size = entry->size - entry->key.key_len;
+  record.priority = entry->priority;
+
+  /* Full keys start with the NUL-terminated prefix. */
+  if (entry->key.prefix_idx == NO_INDEX)
+    {
+      *prefix = memchr(key, 0, entry->key.key_len) ? key : "";
+    }
+  else
+    {
+      *prefix = cache->prefix_pool->values[entry->key.prefix_idx];
+      record.prefix_len = strlen(*prefix) + 1;
+    }
+
+  svn_stringbuf_appendbyte(buffer, RECORD_ENTRY);
+  svn_stringbuf_appendbytes(buffer, (const char *)&record, sizeof(record));
+  if (record.prefix_len)
+    svn_stringbuf_appendbytes(buffer, *prefix, (apr_size_t)record.prefix_len);
+
+#ifdef SVN_DEBUG_CACHE_MEMBUFFER
+  svn_stringbuf_appendbytes(buffer, (const char *)&entry->tag,
+                            sizeof(entry->tag));
+#endif
+
+  svn_stringbuf_appendbytes(buffer, key, entry->size);
+}
+
+/* Serialize all items from the group chain starting at GROUP_INDEX in
+ * CACHE to BUFFER, if their key prefix passes FILTER_FUNC.  Call this with
+ * CACHE being read-locked.
+ */
+static svn_error_t *
+save_group_chain(svn_stringbuf_t *buffer,
+                 svn_membuffer_t *cache,
+                 apr_uint32_t group_index,
+                 svn_cache__snapshot_filter_t filter_func,
+                 void *filter_baton,
+                 apr_pool_t *scratch_pool)
+{
+  entry_group_t *group;
+  apr_uint32_t i;
+
+  if (!is_group_initialized(cache, group_index))
+    return SVN_NO_ERROR;
+
+  for (group = &cache->directory[group_index];
+       group;
+       group = group->header.next == NO_INDEX
+             ? NULL
+             : &cache->directory[group->header.next])
+    for (i = 0; i < group->header.used; ++i)
+      {
+        const char *prefix;
+        svn_boolean_t keep = TRUE;
+        apr_size_t old_len = buffer->len;
+
+        append_snapshot_record(buffer, &prefix, cache, &group->entries[i]);
+        if (filter_func)
+          SVN_ERR(filter_func(&keep, filter_baton, prefix, scratch_pool));
+
+        if (!keep)
+          svn_stringbuf_chop(buffer, buffer->len - old_len);
+      }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__membuffer_save(svn_membuffer_t *cache,
+                          svn_stream_t *stream,
+                          svn_cache__snapshot_filter_t filter_func,
+                          void *filter_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool)
+{
+  apr_uint64_t magic = SNAPSHOT_MAGIC;
+  apr_size_t len = sizeof(magic);
+  apr_uint32_t seg, group_index;
+  svn_stringbuf_t *buffer = svn_stringbuf_create_empty(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_stream_write(stream, (const char *)&magic, &len));
+
+  /* Copy one group chain at a time to keep the lock durations short. */
+  for (seg = 0; seg < cache->segment_count; ++seg)
+    {
+      svn_membuffer_t *segment = &cache[seg];
+      for (group_index = 0; group_index < segment->group_count; ++group_index)
+        {
+          svn_pool_clear(iterpool);
+          svn_stringbuf_setempty(buffer);
+
+          WITH_READ_LOCK(segment,
+                         save_group_chain(buffer, segment, group_index,
+                                          filter_func, filter_baton,
+                                          iterpool));
+
+          if (buffer->len)
+            {
+              len = buffer->len;
+              SVN_ERR(svn_stream_write(stream, buffer->data, &len));
+            }
+
+          if (cancel_func && group_index % 1024 == 0)
+            SVN_ERR(cancel_func(cancel_baton));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  svn_stringbuf_setempty(buffer);
+  svn_stringbuf_appendbyte(buffer, RECORD_END);
+  len = buffer->len;
+  SVN_ERR(svn_stream_write(stream, buffer->data, &len));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read exactly LEN bytes from STREAM into BUFFER.  Error out if the data
+ * is incomplete.
+ */
+static svn_error_t *
+read_snapshot_data(svn_stream_t *stream,
+                   void *buffer,
+                   apr_size_t len)
+{
+  apr_size_t read = len;
+  SVN_ERR(svn_stream_read_full(stream, buffer, &read));
+  if (read != len)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                            _("Unexpected end of cache snapshot"));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__membuffer_load(svn_membuffer_t *cache,
+                          svn_stream_t *stream,
+                          svn_cache__snapshot_filter_t filter_func,
+                          void *filter_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool)
+{
+  apr_uint64_t magic;
+  apr_uint64_t count;
+  full_key_t key_buffer = { { { 0 } } };
+  full_key_t *key = &key_buffer;
+  svn_membuf_t prefix;
+  svn_membuf_t data;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  svn_membuf__create(&key->full_key, 256, scratch_pool);
+  svn_membuf__create(&prefix, 256, scratch_pool);
+  svn_membuf__create(&data, 0x10000, scratch_pool);
+
+  SVN_ERR(read_snapshot_data(stream, &magic, sizeof(magic)));
+  if (magic != SNAPSHOT_MAGIC)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                            _("Unsupported cache snapshot format"));
+
+  for (count = 0; ; ++count)
+    {
+      char record_type;
+      snapshot_record_t record;
+      svn_membuffer_t *segment = cache;
+      apr_uint32_t group_index;
+      const char *key_prefix;
+      svn_boolean_t keep = TRUE;
+#ifdef SVN_DEBUG_CACHE_MEMBUFFER
+      entry_tag_t _tag;
+      entry_tag_t *tag = &_tag;
+#endif
+
+      svn_pool_clear(iterpool);
+      if (cancel_func && count % 1024 == 0)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(read_snapshot_data(stream, &record_type, 1));
+      if (record_type == RECORD_END)
+        break;
+      if (record_type != RECORD_ENTRY)
+        return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                _("Malformed cache snapshot"));
+
+      SVN_ERR(read_snapshot_data(stream, &record, sizeof(record)));
+      if (   record.item_size > MAX_ITEM_SIZE
+          || record.key_len > MAX_ITEM_SIZE
+          || record.prefix_len > MAX_ITEM_SIZE
+          || (record.key_len == 0) == (record.prefix_len == 0)
+          || ALIGN_VALUE(record.key_len) != record.key_len)
+        return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                _("Malformed cache snapshot"));
+
+      if (record.prefix_len)
+        {
+          svn_membuf__ensure(&prefix, (apr_size_t)record.prefix_len);
+          SVN_ERR(read_snapshot_data(stream, prefix.data,
+                                     (apr_size_t)record.prefix_len));
+          key_prefix = prefix.data;
+          if (key_prefix[record.prefix_len - 1] != '\0')
+            return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                    _("Malformed cache snapshot"));
+        }
+
+#ifdef SVN_DEBUG_CACHE_MEMBUFFER
+      SVN_ERR(read_snapshot_data(stream, tag, sizeof(*tag)));
+#endif
+
+      svn_membuf__ensure(&key->full_key, (apr_size_t)record.key_len);
+      SVN_ERR(read_snapshot_data(stream, key->full_key.data,
+                                 (apr_size_t)record.key_len));
+      if (record.key_len)
+        {
+          key_prefix = key->full_key.data;
+          if (!memchr(key_prefix, 0, (apr_size_t)record.key_len))
+            return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                    _("Malformed cache snapshot"));
+        }
+
+      svn_membuf__ensure(&data, (apr_size_t)record.item_size);
+      SVN_ERR(read_snapshot_data(stream, data.data,
+                                 (apr_size_t)record.item_size));
+
+      if (filter_func)
+        SVN_ERR(filter_func(&keep, filter_baton, key_prefix, iterpool));
+      if (!keep)
+        continue;
+
+      /* Reconstruct the entry key.  Shared prefixes get indexes that are
+       * local to this process. */
+      key->entry_key.fingerprint[0] = record.fingerprint[0];
+      key->entry_key.fingerprint[1] = record.fingerprint[1];
+      key->entry_key.key_len = (apr_size_t)record.key_len;
+      if (record.prefix_len)
+        {
+          SVN_ERR(prefix_pool_get(&key->entry_key.prefix_idx,
+                                  cache->prefix_pool, key_prefix));
+
+          /* No index available, i.e. we can't store this short key. */
+          if (key->entry_key.prefix_idx == NO_INDEX)
+            continue;
+        }
+      else
+        {
+          key->entry_key.prefix_idx = NO_INDEX;
+        }
+
+      group_index = get_group_index(&segment, &key->entry_key);
+      WITH_WRITE_LOCK(segment,
+                      membuffer_cache_set_internal(segment,
+                                                   key,
+                                                   group_index,
+                                                   data.data,
+                                                   (apr_size_t)
+                                                     record.item_size,
+                                                   (apr_uint32_t)
+                                                     record.priority,
+                                                   DEBUG_CACHE_MEMBUFFER_TAG
+                                                   iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
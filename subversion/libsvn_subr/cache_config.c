@@ -28,6 +28,7 @@
 
 #include "svn_pools.h"
 #include "svn_sorts.h"
+#include "svn_private_config.h"
 
 /* The cache settings as a process-wide singleton.
  */
@@ -64,6 +65,21 @@ static svn_cache_config_t cache_settings =
 #endif
 };
 
+/* If set, the process-global membuffer cache will be created in shared
+ * memory.  See svn_cache__create_shared_global_membuffer_cache().
+ */
+static svn_boolean_t share_global_cache = FALSE;
+
+/* The process-global membuffer cache and its initialization state.
+ */
+static svn_membuffer_t *global_cache = NULL;
+static svn_atomic_t global_cache_initialized = 0;
+
+/* Whether GLOBAL_CACHE may be used by multiple threads at once.  Also TRUE
+ * if there is no such cache.
+ */
+static svn_boolean_t global_cache_thread_safe = TRUE;
+
 /* Get the current FSFS cache configuration. */
 const svn_cache_config_t *
 svn_cache_config_get(void)
@@ -120,14 +136,23 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
         return SVN_NO_ERROR;
       apr_allocator_owner_set(allocator, pool);
 
-      err = svn_cache__membuffer_cache_create(
-          &cache,
-          (apr_size_t)cache_size,
-          (apr_size_t)(cache_size / 5),
-          0,
-          ! svn_cache_config_get()->single_threaded,
-          FALSE,
-          pool);
+      if (share_global_cache)
+        err = svn_cache__membuffer_cache_create_shared(
+            &cache,
+            (apr_size_t)cache_size,
+            (apr_size_t)(cache_size / 5),
+            0,
+            FALSE,
+            pool);
+      else
+        err = svn_cache__membuffer_cache_create(
+            &cache,
+            (apr_size_t)cache_size,
+            (apr_size_t)(cache_size / 5),
+            0,
+            ! svn_cache_config_get()->single_threaded,
+            FALSE,
+            pool);
 
       /* Some error occurred. Most likely it's an OOM error but we don't
        * really care. Simply release all cache memory and disable caching
@@ -145,6 +170,11 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
 
       /* done */
       *cache_p = cache;
+
+      /* The shared cache serializes all access through its global locks,
+       * which also work between threads. */
+      global_cache_thread_safe =    share_global_cache
+                                 || !svn_cache_config_get()->single_threaded;
     }
 
   return SVN_NO_ERROR;
@@ -158,11 +188,9 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
 svn_membuffer_t *
 svn_cache__get_global_membuffer_cache(void)
 {
-  static svn_membuffer_t *cache = NULL;
-  static svn_atomic_t initialized = 0;
-
   svn_error_t *err
-    = svn_atomic__init_once(&initialized, initialize_cache, &cache, NULL);
+    = svn_atomic__init_once(&global_cache_initialized, initialize_cache,
+                            &global_cache, NULL);
   if (err)
     {
       /* no caches today ... */
@@ -170,7 +198,30 @@ svn_cache__get_global_membuffer_cache(void)
       return NULL;
     }
 
-  return cache;
+  return global_cache;
+}
+
+svn_boolean_t
+svn_cache__global_membuffer_cache_is_thread_safe(void)
+{
+  /* The settings are only final once the cache exists. */
+  svn_cache__get_global_membuffer_cache();
+
+  return global_cache_thread_safe;
+}
+
+svn_error_t *
+svn_cache__create_shared_global_membuffer_cache(void)
+{
+  /* Too late if the process-local cache has already been created. */
+  if (svn_atomic_read(&global_cache_initialized))
+    return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                            _("The global cache has already been created"));
+
+  share_global_cache = TRUE;
+  return svn_error_trace(svn_atomic__init_once(&global_cache_initialized,
+                                               initialize_cache,
+                                               &global_cache, NULL));
 }
 
 void
@@ -1169,6 +1169,15 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "###   http-bulk-updates          Whether to request bulk update"    NL
         "###                              responses or to fetch each file"   NL
         "###                              in an individual request. "        NL
+        "###   svn-max-connections        Maximum number of parallel server" NL
+        "###                              connections to use for an update"  NL
+        "###                              over the svn protocol."            NL
+        "###   svn-compression            How to compress the svn protocol"  NL
+        "###                              data stream (lz4/zlib/no).  lz4"   NL
+        "###                              suits fast networks, zlib"         NL
+        "###                              compresses better on slow ones."   NL
+        "###                              Default is no, which keeps the"    NL
+        "###                              server's sendfile() path usable."  NL
         "###   store-passwords            Specifies whether passwords used"  NL
         "###                              to authenticate against a"         NL
         "###                              Subversion server may be cached"   NL
@@ -1552,6 +1561,33 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### returning an error.  The default is 10000, i.e. 10 seconds."    NL
         "### Longer values may be useful when exclusive locking is enabled." NL
         "# busy-timeout = 10000"                                             NL
+        "### Set the number of threads that working copy operations may use."NL
+        "### 'svn status' uses them to scan large working copies unless"     NL
+        "### exclusive locking is enabled.  Checkouts and updates use them"  NL
+        "### to install working files concurrently."                         NL
+        "# threads = 1"                                                      NL
+        "### Set the size in megabytes of the local cache of pristine texts" NL
+        "### kept by working copies that were checked out without a"         NL
+        "### pristine store ('svn checkout --store-pristine=no').  Texts"    NL
+        "### that are not needed anymore are removed, least recently used"   NL
+        "### first, when the cache grows beyond this size.  The default is"  NL
+        "### 64."                                                            NL
+        "# pristine-cache-size = 64"                                         NL
+        "### Set this to 'yes' to store pristine texts LZ4-compressed.  This"NL
+        "### saves disk space for text files at a small CPU cost.  New"      NL
+        "### working copies then use a format that Subversion 1.14 and"      NL
+        "### older can't read; existing working copies that use that format" NL
+        "### compress the pristine texts that they add from then on."        NL
+        "# compress-pristines = no"                                          NL
+        "### Set this to the path of a directory to share pristine texts"    NL
+        "### between all working copies of this user on the same file"       NL
+        "### system.  Working copies then hard link their pristine files"    NL
+        "### to the files in that directory instead of keeping their own"    NL
+        "### copies, and fetch texts from there instead of downloading"      NL
+        "### them again.  'svn cleanup' removes texts that no working copy"  NL
+        "### uses anymore.  Only trusted users should be able to write to"   NL
+        "### the directory.  Compressed pristine texts are not shared."      NL
+        "# shared-pristine-store ="                                          NL
         ;
 
       err = svn_io_file_open(&f, path,
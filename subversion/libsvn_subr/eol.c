@@ -29,10 +29,29 @@
 #include "svn_io.h"
 #include "private/svn_eol_private.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_sse2.h"
 
 char *
 svn_eol__find_eol_start(char *buf, apr_size_t len)
 {
+#ifdef SVN_HAVE_SSE2
+
+  /* Skip 16 byte chunks that contain neither \r nor \n.  The word-wise
+   * and naive loops below find the exact position within the first chunk
+   * that does. */
+  const __m128i crs = _mm_set1_epi8('\r');
+  const __m128i lfs = _mm_set1_epi8('\n');
+
+  for (; len >= sizeof(__m128i)
+       ; buf += sizeof(__m128i), len -= sizeof(__m128i))
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)buf);
+      if (_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, crs),
+                                         _mm_cmpeq_epi8(chunk, lfs))))
+        break;
+    }
+
+#endif
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Scan the input one machine word at a time. */
@@ -1410,13 +1410,13 @@ svn_io_sleep_for_timestamps(const char *path, apr_pool_t *pool)
                Linux/ext4 with CONFIG_HZ=250 has high resolution
                apr_time_now and although the filesystem timestamps
                have similar high precision they are only updated with
-               a coarser 4ms resolution. */
+               a coarser 4ms resolution.
 
-          /* 10 milliseconds after now. */
-#ifndef SVN_HI_RES_SLEEP_MS
-#define SVN_HI_RES_SLEEP_MS 10
-#endif
-          then = now + apr_time_from_msec(SVN_HI_RES_SLEEP_MS);
+             The working copy doesn't record sub-second timestamps that
+             are younger than SVN_HI_RES_SLEEP_MS (see
+             svn_io__is_timestamp_racy()), so there is nothing to wait
+             for on such filesystems. */
+          return;
         }
 
       /* Remove time taken to do stat() from sleep. */
@@ -1434,6 +1434,14 @@ svn_io_sleep_for_timestamps(const char *path, apr_pool_t *pool)
 }
 
 
+svn_boolean_t
+svn_io__is_timestamp_racy(apr_time_t mtime, apr_time_t now)
+{
+  /* Clocks may also go backwards, so be careful with the future too. */
+  return (now < mtime + apr_time_from_msec(SVN_HI_RES_SLEEP_MS));
+}
+
+
 svn_error_t *
 svn_io_filesizes_different_p(svn_boolean_t *different_p,
                              const char *file1,
@@ -4599,6 +4607,27 @@ svn_io_file_move(const char *from_path, const char *to_path,
   return err;
 }
 
+
+svn_error_t *
+svn_io__file_link(const char *from_path, const char *to_path,
+                  apr_pool_t *scratch_pool)
+{
+  apr_status_t status;
+  const char *from_path_apr, *to_path_apr;
+
+  SVN_ERR(cstring_from_utf8(&from_path_apr, from_path, scratch_pool));
+  SVN_ERR(cstring_from_utf8(&to_path_apr, to_path, scratch_pool));
+
+  status = apr_file_link(from_path_apr, to_path_apr);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't link '%s' to '%s'"),
+                              svn_dirent_local_style(to_path, scratch_pool),
+                              svn_dirent_local_style(from_path,
+                                                     scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Common implementation of svn_io_dir_make and svn_io_dir_make_hidden.
    HIDDEN determines if the hidden attribute
    should be set on the newly created directory. */
@@ -737,6 +737,264 @@ svn_sqlite__column_bytes(svn_sqlite__stmt_t *stmt, int column)
   return sqlite3_column_bytes(stmt->s3stmt, column);
 }
 
+/* One column of a svn_sqlite__rows_t. */
+typedef struct rows_column_t
+{
+  /* The SQLite type of each value: SQLITE_NULL, SQLITE_INTEGER, ... */
+  unsigned char *types;
+
+  /* The integer for SQLITE_INTEGER and SQLITE_FLOAT values, the length in
+     bytes for SQLITE_TEXT and SQLITE_BLOB values, 0 otherwise. */
+  apr_int64_t *values;
+
+  /* The NUL-terminated data of SQLITE_TEXT and SQLITE_BLOB values,
+     NULL otherwise. */
+  const char **data;
+
+  /* Maps data to its interned copy while fetching, or NULL if the column
+     is not interned. */
+  apr_hash_t *interned;
+} rows_column_t;
+
+struct svn_sqlite__rows_t
+{
+  int nrows;
+  int ncols;
+  rows_column_t *columns;
+};
+
+/* Make room for CAPACITY rows in the columns of ROWS, keeping the NROWS
+   rows stored so far.  Allocate the arrays in POOL. */
+static void
+resize_rows(svn_sqlite__rows_t *rows,
+            int capacity,
+            apr_pool_t *pool)
+{
+  int i;
+
+  for (i = 0; i < rows->ncols; i++)
+    {
+      rows_column_t *column = &rows->columns[i];
+      unsigned char *types = apr_palloc(pool, capacity * sizeof(*types));
+      apr_int64_t *values = apr_palloc(pool, capacity * sizeof(*values));
+      const char **data = apr_palloc(pool, capacity * sizeof(*data));
+
+      if (rows->nrows)
+        {
+          memcpy(types, column->types, rows->nrows * sizeof(*types));
+          memcpy(values, column->values, rows->nrows * sizeof(*values));
+          memcpy(data, column->data, rows->nrows * sizeof(*data));
+        }
+
+      column->types = types;
+      column->values = values;
+      column->data = data;
+    }
+}
+
+svn_error_t *
+svn_sqlite__fetch_rows(svn_sqlite__rows_t **rows_p,
+                       svn_sqlite__stmt_t *stmt,
+                       apr_uint32_t intern_columns,
+                       apr_pool_t *result_pool)
+{
+  svn_sqlite__rows_t *rows = apr_pcalloc(result_pool, sizeof(*rows));
+  apr_pool_t *scratch_pool = svn_pool_create(result_pool);
+  svn_boolean_t have_row;
+  int capacity = 0;
+  int i;
+
+  rows->ncols = sqlite3_column_count(stmt->s3stmt);
+  rows->columns = apr_pcalloc(result_pool,
+                              rows->ncols * sizeof(*rows->columns));
+  for (i = 0; i < rows->ncols && i < 32; i++)
+    if (intern_columns & ((apr_uint32_t)1 << i))
+      rows->columns[i].interned = apr_hash_make(scratch_pool);
+
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      if (rows->nrows == capacity)
+        {
+          /* The arrays grow in SCRATCH_POOL and only the final ones are
+             copied to RESULT_POOL. */
+          capacity = capacity ? 2 * capacity : 64;
+          resize_rows(rows, capacity, scratch_pool);
+        }
+
+      for (i = 0; i < rows->ncols; i++)
+        {
+          rows_column_t *column = &rows->columns[i];
+          int type = sqlite3_column_type(stmt->s3stmt, i);
+          const char *data = NULL;
+          apr_int64_t value = 0;
+
+          if (type == SQLITE_TEXT || type == SQLITE_BLOB)
+            {
+              const char *val;
+
+              /* Ask for the data first: it may change the length. */
+              if (type == SQLITE_TEXT)
+                val = (const char *)sqlite3_column_text(stmt->s3stmt, i);
+              else
+                val = sqlite3_column_blob(stmt->s3stmt, i);
+              value = sqlite3_column_bytes(stmt->s3stmt, i);
+              if (!val)
+                val = "";
+
+              if (column->interned)
+                data = apr_hash_get(column->interned, val,
+                                    (apr_ssize_t)value);
+
+              if (!data)
+                {
+                  data = apr_pstrmemdup(result_pool, val, (apr_size_t)value);
+                  if (column->interned)
+                    apr_hash_set(column->interned, data, (apr_ssize_t)value,
+                                 data);
+                }
+            }
+          else if (type != SQLITE_NULL)
+            value = sqlite3_column_int64(stmt->s3stmt, i);
+
+          column->types[rows->nrows] = (unsigned char)type;
+          column->values[rows->nrows] = value;
+          column->data[rows->nrows] = data;
+        }
+
+      rows->nrows++;
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  if (rows->nrows)
+    resize_rows(rows, rows->nrows, result_pool);
+
+  /* The interning hashes go away with SCRATCH_POOL. */
+  for (i = 0; i < rows->ncols; i++)
+    rows->columns[i].interned = NULL;
+  svn_pool_destroy(scratch_pool);
+
+  *rows_p = rows;
+
+  return SVN_NO_ERROR;
+}
+
+int
+svn_sqlite__rows_count(const svn_sqlite__rows_t *rows)
+{
+  return rows->nrows;
+}
+
+const char *
+svn_sqlite__rows_text(const svn_sqlite__rows_t *rows, int row, int column)
+{
+  return rows->columns[column].data[row];
+}
+
+const void *
+svn_sqlite__rows_blob(const svn_sqlite__rows_t *rows, int row, int column,
+                      apr_size_t *len)
+{
+  *len = svn_sqlite__rows_bytes(rows, row, column);
+  return rows->columns[column].data[row];
+}
+
+apr_int64_t
+svn_sqlite__rows_int64(const svn_sqlite__rows_t *rows, int row, int column)
+{
+  const rows_column_t *col = &rows->columns[column];
+
+  if (col->types[row] == SQLITE_INTEGER || col->types[row] == SQLITE_FLOAT)
+    return col->values[row];
+  return 0;
+}
+
+int
+svn_sqlite__rows_int(const svn_sqlite__rows_t *rows, int row, int column)
+{
+  return (int)svn_sqlite__rows_int64(rows, row, column);
+}
+
+svn_revnum_t
+svn_sqlite__rows_revnum(const svn_sqlite__rows_t *rows, int row, int column)
+{
+  if (svn_sqlite__rows_is_null(rows, row, column))
+    return SVN_INVALID_REVNUM;
+  return (svn_revnum_t) svn_sqlite__rows_int64(rows, row, column);
+}
+
+svn_boolean_t
+svn_sqlite__rows_boolean(const svn_sqlite__rows_t *rows, int row,
+                         int column)
+{
+  return svn_sqlite__rows_int64(rows, row, column) != 0;
+}
+
+int
+svn_sqlite__rows_token(const svn_sqlite__rows_t *rows, int row, int column,
+                       const svn_token_map_t *map)
+{
+  return svn_token__from_word_strict(map, rows->columns[column].data[row]);
+}
+
+int
+svn_sqlite__rows_token_null(const svn_sqlite__rows_t *rows, int row,
+                            int column, const svn_token_map_t *map,
+                            int null_val)
+{
+  const char *word = rows->columns[column].data[row];
+
+  if (!word)
+    return null_val;
+
+  return svn_token__from_word_strict(map, word);
+}
+
+svn_error_t *
+svn_sqlite__rows_properties(apr_hash_t **props,
+                            const svn_sqlite__rows_t *rows,
+                            int row,
+                            int column,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  apr_size_t len;
+  const void *val;
+
+  /* svn_skel__parse_proplist copies everything needed to result_pool */
+  val = svn_sqlite__rows_blob(rows, row, column, &len);
+  if (val == NULL)
+    {
+      *props = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_skel__parse_proplist(props,
+                                   svn_skel__parse(val, len, scratch_pool),
+                                   result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_boolean_t
+svn_sqlite__rows_is_null(const svn_sqlite__rows_t *rows, int row,
+                         int column)
+{
+  return rows->columns[column].types[row] == SQLITE_NULL;
+}
+
+apr_size_t
+svn_sqlite__rows_bytes(const svn_sqlite__rows_t *rows, int row, int column)
+{
+  const rows_column_t *col = &rows->columns[column];
+
+  if (col->types[row] == SQLITE_TEXT || col->types[row] == SQLITE_BLOB)
+    return (apr_size_t)col->values[row];
+  return 0;
+}
+
 svn_error_t *
 svn_sqlite__finalize(svn_sqlite__stmt_t *stmt)
 {
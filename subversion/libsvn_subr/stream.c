@@ -1358,6 +1358,203 @@ svn_stream_compressed(svn_stream_t *stream, apr_pool_t *pool)
   return zstream;
 }
 
+
+/* LZ4 compressed stream support */
+
+/* The amount of uncompressed data per block of an LZ4 compressed stream.
+   Every block is stored as its compressed length, encoded like
+   svn__encode_uint(), followed by the output of svn__compress_lz4(). */
+#define LZ4_BLOCK_SIZE (64 * 1024)
+
+struct lz4_baton_t {
+  svn_stream_t *substream;      /* The substream */
+  svn_stringbuf_t *block;       /* Uncompressed data of the current block */
+  svn_stringbuf_t *compressed;  /* Compressed data of the current block */
+  apr_size_t read_pos;          /* Read offset within BLOCK */
+  svn_boolean_t writing;        /* Whether BLOCK holds data to write */
+};
+
+/* Compress the LEN bytes at DATA as one block and write it to the
+   substream of BTN. */
+static svn_error_t *
+write_block_lz4(struct lz4_baton_t *btn,
+                const char *data,
+                apr_size_t len)
+{
+  unsigned char header[SVN__MAX_ENCODED_UINT_LEN];
+  apr_size_t header_len;
+  apr_size_t compressed_len;
+
+  SVN_ERR(svn__compress_lz4(data, len, btn->compressed));
+
+  compressed_len = btn->compressed->len;
+  header_len = svn__encode_uint(header, compressed_len) - header;
+  SVN_ERR(svn_stream_write(btn->substream, (const char *)header,
+                           &header_len));
+  return svn_error_trace(svn_stream_write(btn->substream,
+                                          btn->compressed->data,
+                                          &compressed_len));
+}
+
+/* Read the next block from the substream of BTN and make its uncompressed
+   contents the current block.  Leave the current block empty at the end
+   of the stream. */
+static svn_error_t *
+read_block_lz4(struct lz4_baton_t *btn)
+{
+  unsigned char header[SVN__MAX_ENCODED_UINT_LEN];
+  apr_size_t header_len = 0;
+  apr_uint64_t compressed_len;
+  apr_size_t len;
+
+  svn_stringbuf_setempty(btn->block);
+  btn->read_pos = 0;
+
+  /* Read the length header, which ends with the first byte that doesn't
+     have its high bit set. */
+  do
+    {
+      if (header_len == sizeof(header))
+        return svn_error_create(SVN_ERR_STREAM_MALFORMED_DATA, NULL,
+                                _("Invalid block header in LZ4 "
+                                  "compressed stream"));
+
+      len = 1;
+      SVN_ERR(svn_stream_read_full(btn->substream,
+                                   (char *)header + header_len, &len));
+      if (len == 0)
+        {
+          if (header_len == 0)
+            return SVN_NO_ERROR;
+
+          return svn_error_create(SVN_ERR_STREAM_MALFORMED_DATA, NULL,
+                                  _("Unexpected end of LZ4 compressed "
+                                    "stream"));
+        }
+    }
+  while (header[header_len++] & 0x80);
+
+  svn__decode_uint(&compressed_len, header, header + header_len);
+  if (compressed_len > 2 * LZ4_BLOCK_SIZE)
+    return svn_error_create(SVN_ERR_STREAM_MALFORMED_DATA, NULL,
+                            _("Invalid block size in LZ4 compressed "
+                              "stream"));
+
+  svn_stringbuf_ensure(btn->compressed, (apr_size_t)compressed_len);
+  len = (apr_size_t)compressed_len;
+  SVN_ERR(svn_stream_read_full(btn->substream, btn->compressed->data, &len));
+  if (len != compressed_len)
+    return svn_error_create(SVN_ERR_STREAM_MALFORMED_DATA, NULL,
+                            _("Unexpected end of LZ4 compressed stream"));
+  btn->compressed->len = len;
+
+  return svn_error_trace(svn__decompress_lz4(btn->compressed->data,
+                                             btn->compressed->len,
+                                             btn->block, LZ4_BLOCK_SIZE));
+}
+
+/* Handle reading from an LZ4 compressed stream */
+static svn_error_t *
+read_handler_lz4(void *baton, char *buffer, apr_size_t *len)
+{
+  struct lz4_baton_t *btn = baton;
+  apr_size_t copied = 0;
+
+  while (copied < *len)
+    {
+      apr_size_t available;
+
+      if (btn->read_pos == btn->block->len)
+        {
+          SVN_ERR(read_block_lz4(btn));
+          if (btn->block->len == 0)
+            break;
+        }
+
+      available = MIN(*len - copied, btn->block->len - btn->read_pos);
+      memcpy(buffer + copied, btn->block->data + btn->read_pos, available);
+      btn->read_pos += available;
+      copied += available;
+    }
+
+  *len = copied;
+  return SVN_NO_ERROR;
+}
+
+/* Compress data in blocks of LZ4_BLOCK_SIZE and write it to the
+   substream */
+static svn_error_t *
+write_handler_lz4(void *baton, const char *buffer, apr_size_t *len)
+{
+  struct lz4_baton_t *btn = baton;
+  apr_size_t remaining = *len;
+
+  btn->writing = TRUE;
+
+  /* Complete the pending block first. */
+  if (btn->block->len > 0)
+    {
+      apr_size_t fill = MIN(remaining, LZ4_BLOCK_SIZE - btn->block->len);
+
+      svn_stringbuf_appendbytes(btn->block, buffer, fill);
+      buffer += fill;
+      remaining -= fill;
+
+      if (btn->block->len < LZ4_BLOCK_SIZE)
+        return SVN_NO_ERROR;
+
+      SVN_ERR(write_block_lz4(btn, btn->block->data, btn->block->len));
+      svn_stringbuf_setempty(btn->block);
+    }
+
+  /* Compress full blocks directly from the caller's buffer. */
+  while (remaining >= LZ4_BLOCK_SIZE)
+    {
+      SVN_ERR(write_block_lz4(btn, buffer, LZ4_BLOCK_SIZE));
+      buffer += LZ4_BLOCK_SIZE;
+      remaining -= LZ4_BLOCK_SIZE;
+    }
+
+  svn_stringbuf_appendbytes(btn->block, buffer, remaining);
+
+  return SVN_NO_ERROR;
+}
+
+/* Handle flushing and closing the stream */
+static svn_error_t *
+close_handler_lz4(void *baton)
+{
+  struct lz4_baton_t *btn = baton;
+
+  if (btn->writing && btn->block->len > 0)
+    SVN_ERR(write_block_lz4(btn, btn->block->data, btn->block->len));
+
+  return svn_error_trace(svn_stream_close(btn->substream));
+}
+
+svn_stream_t *
+svn_stream__compressed_lz4(svn_stream_t *stream,
+                           apr_pool_t *result_pool)
+{
+  struct svn_stream_t *lz4_stream;
+  struct lz4_baton_t *baton;
+
+  assert(stream != NULL);
+
+  baton = apr_pcalloc(result_pool, sizeof(*baton));
+  baton->substream = stream;
+  baton->block = svn_stringbuf_create_ensure(LZ4_BLOCK_SIZE, result_pool);
+  baton->compressed = svn_stringbuf_create_empty(result_pool);
+
+  lz4_stream = svn_stream_create(baton, result_pool);
+  svn_stream_set_read2(lz4_stream, NULL /* only full read support */,
+                       read_handler_lz4);
+  svn_stream_set_write(lz4_stream, write_handler_lz4);
+  svn_stream_set_close(lz4_stream, close_handler_lz4);
+
+  return lz4_stream;
+}
+
 
 /* Checksummed stream support */
 
@@ -30,10 +30,12 @@
 
 #include <string.h>      /* for memcpy(), memcmp(), strlen() */
 #include <apr_fnmatch.h>
+
 #include "svn_string.h"  /* loads "svn_types.h" and <apr_pools.h> */
 #include "svn_ctype.h"
 #include "private/svn_dep_compat.h"
 #include "private/svn_string_private.h"
+#include "private/svn_sse2.h"
 
 #include "svn_private_config.h"
 
@@ -1508,6 +1510,22 @@ svn_cstring__match_length(const char *a,
 {
   apr_size_t pos = 0;
 
+#ifdef SVN_HAVE_SSE2
+
+  /* Compare 16 bytes at a time.  SSE2 is part of the x86-64 baseline, so
+   * no runtime detection is needed.  Once a chunk differs, the loops below
+   * locate the exact position within it.
+   */
+  for (; max_len - pos >= sizeof(__m128i); pos += sizeof(__m128i))
+    {
+      __m128i chunk_a = _mm_loadu_si128((const __m128i *)(a + pos));
+      __m128i chunk_b = _mm_loadu_si128((const __m128i *)(b + pos));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(chunk_a, chunk_b)) != 0xffff)
+        break;
+    }
+
+#endif
+
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Chunky processing is so much faster ...
@@ -1536,6 +1554,21 @@ svn_cstring__reverse_match_length(const char *a,
 {
   apr_size_t pos = 0;
 
+#ifdef SVN_HAVE_SSE2
+
+  /* Same as above: skip over equal 16 byte chunks first. */
+  for (pos = sizeof(__m128i); pos <= max_len; pos += sizeof(__m128i))
+    {
+      __m128i chunk_a = _mm_loadu_si128((const __m128i *)(a - pos));
+      __m128i chunk_b = _mm_loadu_si128((const __m128i *)(b - pos));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(chunk_a, chunk_b)) != 0xffff)
+        break;
+    }
+
+  pos -= sizeof(__m128i);
+
+#endif
+
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Chunky processing is so much faster ...
@@ -1544,7 +1577,7 @@ svn_cstring__reverse_match_length(const char *a,
    * because A and B will probably have different alignment. So, skipping
    * the first few chars until alignment is reached is not an option.
    */
-  for (pos = sizeof(apr_size_t); pos <= max_len; pos += sizeof(apr_size_t))
+  for (pos += sizeof(apr_size_t); pos <= max_len; pos += sizeof(apr_size_t))
     if (*(const apr_size_t*)(a - pos) != *(const apr_size_t*)(b - pos))
       break;
 
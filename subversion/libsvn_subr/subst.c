@@ -45,12 +45,15 @@
 #include "svn_io.h"
 #include "svn_subst.h"
 #include "svn_pools.h"
+#include "svn_sorts.h"
 #include "private/svn_io_private.h"
 
 #include "svn_private_config.h"
 
 #include "private/svn_string_private.h"
 #include "private/svn_eol_private.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_sse2.h"
 
 /**
  * The textual elements of a detranslated special file.  One of these
@@ -1125,6 +1128,30 @@ translate_chunk(svn_stream_t *dst,
 
               if (b->keywords)
                 {
+#ifdef SVN_HAVE_SSE2
+                  /* Skip 16 byte chunks without '$' (and without CR or LF
+                     if we translate EOLs as well). */
+                  const __m128i dollars = _mm_set1_epi8('$');
+                  const __m128i crs = _mm_set1_epi8('\r');
+                  const __m128i lfs = _mm_set1_epi8('\n');
+
+                  while ((apr_size_t)(end - p) >= len + sizeof(__m128i))
+                    {
+                      __m128i chunk
+                        = _mm_loadu_si128((const __m128i *)(p + len));
+                      __m128i hits = _mm_cmpeq_epi8(chunk, dollars);
+
+                      if (b->eol_str)
+                        hits = _mm_or_si128(hits,
+                                 _mm_or_si128(_mm_cmpeq_epi8(chunk, crs),
+                                              _mm_cmpeq_epi8(chunk, lfs)));
+                      if (_mm_movemask_epi8(hits))
+                        break;
+
+                      len += sizeof(__m128i);
+                    }
+#endif
+
                   /* Check 4 bytes at once to allow for efficient pipelining
                     and to reduce loop condition overhead. */
                   while ((end - p) >= (len + 4))
@@ -1559,6 +1586,190 @@ svn_subst_stream_translated(svn_stream_t *stream,
                            result_pool);
 }
 
+/* Read SOURCE to its end and feed its contents through translate_chunk()
+ * with baton B, writing the result to DST.  Stop reading early once *DONE
+ * becomes TRUE.  Close SOURCE afterwards.
+ *
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+translate_stream_contents(svn_stream_t *dst,
+                          struct translation_baton *b,
+                          svn_stream_t *source,
+                          const svn_boolean_t *done,
+                          apr_pool_t *scratch_pool)
+{
+  char *buf = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_size_t len;
+
+  do
+    {
+      svn_pool_clear(iterpool);
+
+      len = SVN__STREAM_CHUNK_SIZE;
+      SVN_ERR(svn_stream_read_full(source, buf, &len));
+
+      /* Without anything to translate, pass the data on as is. */
+      if (b->eol_str || b->keywords)
+        SVN_ERR(translate_chunk(dst, b, buf, len, iterpool));
+      else
+        SVN_ERR(translate_write(dst, buf, len));
+    }
+  while (len == SVN__STREAM_CHUNK_SIZE && !*done);
+
+  /* Flush the keyword and newline buffers. */
+  if (!*done)
+    SVN_ERR(translate_chunk(dst, b, NULL, 0, iterpool));
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_stream_close(source));
+}
+
+/* Baton for compare_write(). */
+typedef struct compare_baton_t
+{
+  /* The stream to compare the translated data with. */
+  svn_stream_t *stream;
+
+  /* Data read from STREAM, of which the first POS of LEN bytes have
+     already been compared. */
+  char *buf;
+  apr_size_t len;
+  apr_size_t pos;
+
+  /* TRUE once STREAM has returned its last byte. */
+  svn_boolean_t eof;
+
+  /* FALSE once a difference has been found. */
+  svn_boolean_t same;
+
+  /* TRUE if no more data needs to be compared, i.e. when SAME is FALSE. */
+  svn_boolean_t done;
+} compare_baton_t;
+
+/* Implements svn_write_fn_t.  Compare the LEN bytes at DATA with the next
+ * bytes of the stream in compare_baton_t BATON. */
+static svn_error_t *
+compare_write(void *baton,
+              const char *data,
+              apr_size_t *len)
+{
+  compare_baton_t *cb = baton;
+  apr_size_t remaining = *len;
+
+  while (remaining && !cb->done)
+    {
+      apr_size_t to_compare;
+
+      if (cb->pos == cb->len)
+        {
+          if (cb->eof)
+            {
+              /* The translated data is longer. */
+              cb->same = FALSE;
+              cb->done = TRUE;
+              break;
+            }
+
+          cb->len = SVN__STREAM_CHUNK_SIZE;
+          cb->pos = 0;
+          SVN_ERR(svn_stream_read_full(cb->stream, cb->buf, &cb->len));
+          cb->eof = (cb->len < SVN__STREAM_CHUNK_SIZE);
+          continue;
+        }
+
+      to_compare = MIN(remaining, cb->len - cb->pos);
+      if (memcmp(data, cb->buf + cb->pos, to_compare))
+        {
+          cb->same = FALSE;
+          cb->done = TRUE;
+          break;
+        }
+
+      cb->pos += to_compare;
+      data += to_compare;
+      remaining -= to_compare;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_subst__translated_contents_same(svn_boolean_t *same,
+                                    svn_stream_t *source,
+                                    svn_stream_t *compare_to,
+                                    const char *eol_str,
+                                    svn_boolean_t repair,
+                                    apr_hash_t *keywords,
+                                    svn_boolean_t expand,
+                                    apr_pool_t *scratch_pool)
+{
+  struct translation_baton *b
+    = create_translation_baton(eol_str, NULL, repair, keywords, expand,
+                               scratch_pool);
+  compare_baton_t cb = { 0 };
+  svn_stream_t *sink = svn_stream_create(&cb, scratch_pool);
+
+  cb.stream = compare_to;
+  cb.buf = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
+  cb.same = TRUE;
+  svn_stream_set_write(sink, compare_write);
+
+  SVN_ERR(translate_stream_contents(sink, b, source, &cb.done,
+                                    scratch_pool));
+
+  /* Anything left in COMPARE_TO means the translated data is shorter. */
+  if (cb.same && cb.pos == cb.len && !cb.eof)
+    {
+      cb.len = 1;
+      cb.pos = 0;
+      SVN_ERR(svn_stream_read_full(compare_to, cb.buf, &cb.len));
+    }
+  if (cb.pos < cb.len)
+    cb.same = FALSE;
+
+  *same = cb.same;
+
+  return svn_error_trace(svn_stream_close(compare_to));
+}
+
+/* Implements svn_write_fn_t.  Add the LEN bytes at DATA to the
+ * svn_checksum_ctx_t BATON. */
+static svn_error_t *
+checksum_write(void *baton,
+               const char *data,
+               apr_size_t *len)
+{
+  return svn_error_trace(svn_checksum_update(baton, data, *len));
+}
+
+svn_error_t *
+svn_subst__translated_checksum(svn_checksum_t **checksum,
+                               svn_stream_t *source,
+                               svn_checksum_kind_t kind,
+                               const char *eol_str,
+                               svn_boolean_t repair,
+                               apr_hash_t *keywords,
+                               svn_boolean_t expand,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  struct translation_baton *b
+    = create_translation_baton(eol_str, NULL, repair, keywords, expand,
+                               scratch_pool);
+  svn_checksum_ctx_t *ctx = svn_checksum_ctx_create(kind, scratch_pool);
+  svn_stream_t *sink = svn_stream_create(ctx, scratch_pool);
+  svn_boolean_t done = FALSE;
+
+  svn_stream_set_write(sink, checksum_write);
+
+  SVN_ERR(translate_stream_contents(sink, b, source, &done, scratch_pool));
+
+  return svn_error_trace(svn_checksum_final(checksum, ctx, result_pool));
+}
+
 /* Same as svn_subst_translate_cstring2(), except for the following.
  *
  * If TRANSLATED_EOL is not NULL, then set *TRANSLATED_EOL to TRUE if an
@@ -0,0 +1,471 @@
+/*
+ * task.c: concurrent processing of work items with in-order results
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
+
+#include "svn_pools.h"
+#include "svn_error.h"
+
+#include "private/svn_mutex.h"
+#include "private/svn_task.h"
+
+#include "svn_private_config.h"
+
+/* Handy macro to check APR function results and turning them into
+ * svn_error_t upon failure. */
+#define WRAP_APR_ERR(x,msg)                     \
+  {                                             \
+    apr_status_t status_ = (x);                 \
+    if (status_)                                \
+      return svn_error_wrap_apr(status_, msg);  \
+  }
+
+/* Processing state of a task. */
+typedef enum task_state_t
+{
+  /* Waiting for a worker thread to pick it up. */
+  task_state_waiting,
+
+  /* Currently being processed by a worker thread. */
+  task_state_running,
+
+  /* Processing completed, RESULT and ERR are valid. */
+  task_state_done
+} task_state_t;
+
+/* A single entry in the queue.  It is allocated in its own POOL. */
+typedef struct task_t
+{
+  /* The user-provided task data. */
+  void *task;
+
+  /* The task's root pool, owned by the queue until the task gets popped. */
+  apr_pool_t *pool;
+
+  /* Processing results.  Only valid if STATE is task_state_done. */
+  void *result;
+  svn_error_t *err;
+
+  /* Current processing state. */
+  task_state_t state;
+
+  /* Next younger task in the queue. */
+  struct task_t *next;
+} task_t;
+
+struct svn_task__queue_t
+{
+  /* Process tasks using this function and baton. */
+  svn_task__process_func_t process_func;
+  void *process_baton;
+
+  /* Pushed but not yet popped tasks, oldest first.  LAST is the youngest
+   * task and NEXT_WAITING the oldest task that has not been picked up by
+   * any worker, yet.  Any of them may be NULL. */
+  task_t *first;
+  task_t *last;
+  task_t *next_waiting;
+
+  /* Number of tasks in the FIRST .. LAST list. */
+  int size;
+
+  /* Block pushes while SIZE has reached this limit.  0 = unlimited. */
+  int max_pending;
+
+  /* Set once the queue is being shut down. */
+  svn_boolean_t shutdown;
+
+  /* Serializes access to all of the above. */
+  svn_mutex__t *mutex;
+
+#if APR_HAS_THREADS
+  /* Gets signaled whenever any of the above changes. */
+  apr_thread_cond_t *changed;
+
+  /* Worker threads. */
+  apr_thread_t **threads;
+#endif
+
+  /* Number of elements in THREADS. */
+  int thread_count;
+};
+
+/* Run QUEUE's process function on TASK and store the results in TASK.
+ * Use SCRATCH_POOL for temporaries. */
+static void
+process_task(svn_task__queue_t *queue,
+             task_t *task,
+             apr_pool_t *scratch_pool)
+{
+  task->err = queue->process_func(&task->result, task->task,
+                                  queue->process_baton, task->pool,
+                                  scratch_pool);
+}
+
+/* Destroy all tasks in QUEUE and their pools.  Clear their errors. */
+static void
+destroy_tasks(svn_task__queue_t *queue)
+{
+  while (queue->first)
+    {
+      task_t *task = queue->first;
+      queue->first = task->next;
+
+      svn_error_clear(task->err);
+      svn_pool_destroy(task->pool);
+    }
+
+  queue->last = NULL;
+  queue->next_waiting = NULL;
+  queue->size = 0;
+}
+
+#if APR_HAS_THREADS
+
+/* Wait for QUEUE->CHANGED to be signaled.  QUEUE->MUTEX must be locked. */
+static svn_error_t *
+wait_for_change(svn_task__queue_t *queue)
+{
+  WRAP_APR_ERR(apr_thread_cond_wait(queue->changed,
+                                    svn_mutex__get(queue->mutex)),
+               _("Can't wait on condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Wake up all threads waiting on QUEUE->CHANGED. */
+static svn_error_t *
+signal_change(svn_task__queue_t *queue)
+{
+  WRAP_APR_ERR(apr_thread_cond_broadcast(queue->changed),
+               _("Can't broadcast condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *TASK to the next task of QUEUE that needs processing and mark it
+ * as running.  Set it to NULL if the queue is being shut down. */
+static svn_error_t *
+take_next_task(task_t **task,
+               svn_task__queue_t *queue)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(queue->mutex));
+
+  while (!queue->shutdown && !queue->next_waiting && !err)
+    err = wait_for_change(queue);
+
+  if (queue->shutdown || err)
+    {
+      *task = NULL;
+    }
+  else
+    {
+      *task = queue->next_waiting;
+      (*task)->state = task_state_running;
+      queue->next_waiting = (*task)->next;
+    }
+
+  return svn_error_trace(svn_mutex__unlock(queue->mutex, err));
+}
+
+/* Mark TASK in QUEUE as processed and notify any waiting consumers. */
+static svn_error_t *
+complete_task(svn_task__queue_t *queue,
+              task_t *task)
+{
+  SVN_ERR(svn_mutex__lock(queue->mutex));
+  task->state = task_state_done;
+
+  return svn_error_trace(svn_mutex__unlock(queue->mutex,
+                                           signal_change(queue)));
+}
+
+/* Worker thread function.  DATA is the svn_task__queue_t to serve. */
+static void * APR_THREAD_FUNC
+worker_thread(apr_thread_t *thread, void *data)
+{
+  svn_task__queue_t *queue = data;
+  apr_pool_t *scratch_pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  svn_error_t *err = SVN_NO_ERROR;
+
+  while (!err)
+    {
+      task_t *task;
+
+      err = take_next_task(&task, queue);
+      if (err || !task)
+        break;
+
+      process_task(queue, task, scratch_pool);
+      svn_pool_clear(scratch_pool);
+
+      err = complete_task(queue, task);
+    }
+
+  /* Errors here are failures of the synchronization primitives.  There
+   * is nobody to report them to. */
+  svn_error_clear(err);
+  svn_pool_destroy(scratch_pool);
+  apr_thread_exit(thread, APR_SUCCESS);
+
+  return NULL;
+}
+
+#endif
+
+/* Pool pre-cleanup handler shutting the svn_task__queue_t in DATA down,
+ * waiting for all workers to terminate and releasing all pending tasks.
+ *
+ * This must be a pre-cleanup because the thread objects live in sub-pools
+ * of the queue's pool. */
+static apr_status_t
+queue_pre_cleanup(void *data)
+{
+  svn_task__queue_t *queue = data;
+
+  svn_error_clear(svn_task__queue_shutdown(queue));
+
+#if APR_HAS_THREADS
+  {
+    int i;
+    for (i = 0; i < queue->thread_count; ++i)
+      if (queue->threads[i])
+        {
+          apr_status_t retval;
+          apr_thread_join(&retval, queue->threads[i]);
+        }
+  }
+#endif
+
+  destroy_tasks(queue);
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_task__queue_create(svn_task__queue_t **queue,
+                       int thread_count,
+                       int max_pending,
+                       svn_task__process_func_t process_func,
+                       void *process_baton,
+                       apr_pool_t *result_pool)
+{
+  svn_task__queue_t *result = apr_pcalloc(result_pool, sizeof(*result));
+
+  result->process_func = process_func;
+  result->process_baton = process_baton;
+  result->max_pending = max_pending;
+
+#if APR_HAS_THREADS
+  result->thread_count = thread_count > 0 ? thread_count : 0;
+#else
+  result->thread_count = 0;
+#endif
+
+  SVN_ERR(svn_mutex__init(&result->mutex, result->thread_count > 0,
+                          result_pool));
+
+#if APR_HAS_THREADS
+  if (result->thread_count)
+    {
+      int i;
+
+      WRAP_APR_ERR(apr_thread_cond_create(&result->changed, result_pool),
+                   _("Can't create condition variable"));
+
+      result->threads = apr_pcalloc(result_pool,
+                                    result->thread_count
+                                      * sizeof(*result->threads));
+
+      /* From here on, the cleanup must take care of the threads. */
+      apr_pool_pre_cleanup_register(result_pool, result, queue_pre_cleanup);
+
+      for (i = 0; i < result->thread_count; ++i)
+        WRAP_APR_ERR(apr_thread_create(&result->threads[i], NULL,
+                                       worker_thread, result, result_pool),
+                     _("Can't create worker thread"));
+    }
+  else
+#endif
+    {
+      apr_pool_pre_cleanup_register(result_pool, result, queue_pre_cleanup);
+    }
+
+  *queue = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_task__queue_push() for QUEUE->MUTEX being locked. */
+static svn_error_t *
+push_locked(svn_task__queue_t *queue,
+            task_t *task)
+{
+#if APR_HAS_THREADS
+  if (queue->thread_count && queue->max_pending)
+    while (!queue->shutdown && queue->size >= queue->max_pending)
+      SVN_ERR(wait_for_change(queue));
+#endif
+
+  if (queue->shutdown)
+    return svn_error_create(SVN_ERR_CANCELLED, NULL,
+                            _("Task queue has been shut down"));
+
+  if (queue->last)
+    queue->last->next = task;
+  else
+    queue->first = task;
+
+  queue->last = task;
+  if (!queue->next_waiting && task->state == task_state_waiting)
+    queue->next_waiting = task;
+
+  queue->size++;
+
+#if APR_HAS_THREADS
+  if (queue->thread_count)
+    SVN_ERR(signal_change(queue));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_task__queue_push(svn_task__queue_t *queue,
+                     void *task,
+                     apr_pool_t *task_pool)
+{
+  svn_error_t *err;
+  task_t *entry = apr_pcalloc(task_pool, sizeof(*entry));
+  entry->task = task;
+  entry->pool = task_pool;
+  entry->state = task_state_waiting;
+
+  /* Without worker threads, process the task right away. */
+  if (queue->thread_count == 0)
+    {
+      apr_pool_t *scratch_pool = svn_pool_create(task_pool);
+      process_task(queue, entry, scratch_pool);
+      svn_pool_destroy(scratch_pool);
+
+      entry->state = task_state_done;
+    }
+
+  SVN_ERR(svn_mutex__lock(queue->mutex));
+  err = svn_mutex__unlock(queue->mutex, push_locked(queue, entry));
+
+  /* The queue did not take the task.  Release it. */
+  if (err && queue->last != entry)
+    {
+      svn_error_clear(entry->err);
+      svn_pool_destroy(task_pool);
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Implement svn_task__queue_pop() for QUEUE->MUTEX being locked.
+ * Return the entry removed from the queue in *ENTRY. */
+static svn_error_t *
+pop_locked(task_t **entry,
+           svn_task__queue_t *queue)
+{
+  if (queue->thread_count == 0)
+    SVN_ERR_ASSERT(queue->first);
+
+#if APR_HAS_THREADS
+  while (!queue->shutdown
+         && (!queue->first || queue->first->state != task_state_done))
+    SVN_ERR(wait_for_change(queue));
+#endif
+
+  if (queue->shutdown)
+    return svn_error_create(SVN_ERR_CANCELLED, NULL,
+                            _("Task queue has been shut down"));
+
+  *entry = queue->first;
+  queue->first = (*entry)->next;
+  if (!queue->first)
+    queue->last = NULL;
+
+  queue->size--;
+
+#if APR_HAS_THREADS
+  /* Wake up producers blocked by MAX_PENDING. */
+  if (queue->thread_count)
+    SVN_ERR(signal_change(queue));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_task__queue_pop(void **result,
+                    void **task,
+                    apr_pool_t **task_pool,
+                    svn_task__queue_t *queue)
+{
+  task_t *entry = NULL;
+
+  SVN_ERR(svn_mutex__lock(queue->mutex));
+  SVN_ERR(svn_mutex__unlock(queue->mutex, pop_locked(&entry, queue)));
+
+  *result = entry->result;
+  if (task)
+    *task = entry->task;
+  *task_pool = entry->pool;
+
+  return svn_error_trace(entry->err);
+}
+
+int
+svn_task__queue_size(svn_task__queue_t *queue)
+{
+  int size;
+
+  /* Failures to lock / unlock are neither expected nor recoverable. */
+  svn_error_clear(svn_mutex__lock(queue->mutex));
+  size = queue->size;
+  svn_error_clear(svn_mutex__unlock(queue->mutex, SVN_NO_ERROR));
+
+  return size;
+}
+
+svn_error_t *
+svn_task__queue_shutdown(svn_task__queue_t *queue)
+{
+  SVN_ERR(svn_mutex__lock(queue->mutex));
+  queue->shutdown = TRUE;
+
+#if APR_HAS_THREADS
+  if (queue->thread_count)
+    return svn_error_trace(svn_mutex__unlock(queue->mutex,
+                                             signal_change(queue)));
+#endif
+
+  return svn_error_trace(svn_mutex__unlock(queue->mutex, SVN_NO_ERROR));
+}
@@ -44,6 +44,7 @@
 #include "wc.h"
 #include "adm_files.h"
 #include "translate.h"
+#include "textbase.h"
 #include "workqueue.h"
 #include "conflicts.h"
 
@@ -1107,8 +1108,9 @@ svn_wc__internal_transmit_text_deltas(svn_stream_t *tempstream,
     }
 
   /* If sending a full text is requested, or if there is no pristine text
-   * (e.g. the node is locally added), then set BASE_STREAM to an empty
-   * stream and leave EXPECTED_MD5_CHECKSUM and VERIFY_CHECKSUM as NULL.
+   * (e.g. the node is locally added, or its pristine text is not stored
+   * locally), then set BASE_STREAM to an empty stream and leave
+   * EXPECTED_MD5_CHECKSUM and VERIFY_CHECKSUM as NULL.
    *
    * Otherwise, set BASE_STREAM to a stream providing the base (source) text
    * for the delta, set EXPECTED_MD5_CHECKSUM to its stored MD5 checksum,
@@ -1118,13 +1120,23 @@ svn_wc__internal_transmit_text_deltas(svn_stream_t *tempstream,
       /* We will be computing a delta against the pristine contents */
       /* We need the expected checksum to be an MD-5 checksum rather than a
        * SHA-1 because we want to pass it to apply_textdelta(). */
-      SVN_ERR(read_and_checksum_pristine_text(&base_stream,
-                                              &expected_md5_checksum,
-                                              &verify_checksum,
-                                              db, local_abspath,
-                                              scratch_pool, scratch_pool));
+      err = read_and_checksum_pristine_text(&base_stream,
+                                            &expected_md5_checksum,
+                                            &verify_checksum,
+                                            db, local_abspath,
+                                            scratch_pool, scratch_pool);
+
+      /* Without a local pristine text, a fulltext will do just as well. */
+      if (err && err->apr_err == SVN_ERR_WC_PRISTINE_DEHYDRATED)
+        {
+          svn_error_clear(err);
+          fulltext = TRUE;
+        }
+      else
+        SVN_ERR(err);
     }
-  else
+
+  if (fulltext)
     {
       /* Send a fulltext. */
       base_stream = svn_stream_empty(scratch_pool);
@@ -1247,6 +1259,304 @@ svn_wc_transmit_text_deltas3(const svn_checksum_t **new_text_base_md5_checksum,
                                                scratch_pool);
 }
 
+
+struct svn_wc__text_deltas_t
+{
+  const char *local_abspath;
+
+  /* Delta source and target, see svn_wc__internal_transmit_text_deltas().
+     LOCAL_STREAM also writes the new pristine text. */
+  svn_stream_t *base_stream;
+  svn_stream_t *local_stream;
+
+  /* Recorded MD5 of BASE_STREAM, or NULL when sending a fulltext. */
+  const svn_checksum_t *expected_md5_checksum;
+
+  /* Calculated MD5 of BASE_STREAM and MD5 and SHA-1 of LOCAL_STREAM. */
+  svn_checksum_t *verify_checksum;
+  svn_checksum_t *local_md5_checksum;
+  svn_checksum_t *local_sha1_checksum;
+
+  svn_wc__db_install_data_t *install_data;
+
+  /* The directory for the delta file, the delta file itself and the
+     number of svndiff windows in it. */
+  const char *tmpdir_abspath;
+  const char *delta_abspath;
+  int window_count;
+
+  /* The pool that this structure lives in. */
+  apr_pool_t *pool;
+};
+
+svn_error_t *
+svn_wc__prepare_text_deltas(svn_wc__text_deltas_t **text_deltas,
+                            svn_wc_context_t *wc_ctx,
+                            const char *local_abspath,
+                            svn_boolean_t fulltext,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  svn_wc__db_t *db = wc_ctx->db;
+  svn_wc__text_deltas_t *td = apr_pcalloc(result_pool, sizeof(*td));
+  svn_stream_t *new_pristine_stream;
+
+  td->local_abspath = apr_pstrdup(result_pool, local_abspath);
+  td->pool = result_pool;
+
+  SVN_ERR(svn_wc__internal_translated_stream(&td->local_stream, db,
+                                             local_abspath, local_abspath,
+                                             SVN_WC_TRANSLATE_TO_NF,
+                                             result_pool, scratch_pool));
+
+  SVN_ERR(svn_wc__db_pristine_prepare_install(&new_pristine_stream,
+                                              &td->install_data,
+                                              &td->local_sha1_checksum, NULL,
+                                              db, local_abspath,
+                                              result_pool, scratch_pool));
+  td->local_stream = copying_stream(td->local_stream, new_pristine_stream,
+                                    result_pool);
+
+  if (! fulltext)
+    {
+      svn_error_t *err;
+
+      err = read_and_checksum_pristine_text(&td->base_stream,
+                                            &td->expected_md5_checksum,
+                                            &td->verify_checksum,
+                                            db, local_abspath,
+                                            result_pool, scratch_pool);
+
+      /* Without a local pristine text, a fulltext will do just as well. */
+      if (err && err->apr_err == SVN_ERR_WC_PRISTINE_DEHYDRATED)
+        {
+          svn_error_clear(err);
+          fulltext = TRUE;
+        }
+      else
+        SVN_ERR(err);
+    }
+
+  if (fulltext)
+    {
+      td->base_stream = svn_stream_empty(result_pool);
+      td->expected_md5_checksum = NULL;
+      td->verify_checksum = NULL;
+    }
+
+  td->local_stream = svn_stream_checksummed2(td->local_stream,
+                                             &td->local_md5_checksum,
+                                             NULL, svn_checksum_md5, TRUE,
+                                             result_pool);
+
+  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&td->tmpdir_abspath, db,
+                                         local_abspath,
+                                         result_pool, scratch_pool));
+
+  *text_deltas = td;
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for count_windows(). */
+typedef struct count_windows_baton_t
+{
+  svn_wc__text_deltas_t *td;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+} count_windows_baton_t;
+
+/* Implements svn_txdelta_window_handler_t, counting the windows for
+   BATON->TD and passing them on to BATON->HANDLER. */
+static svn_error_t *
+count_windows(svn_txdelta_window_t *window,
+              void *baton)
+{
+  count_windows_baton_t *b = baton;
+
+  if (window)
+    b->td->window_count++;
+
+  return svn_error_trace(b->handler(window, b->handler_baton));
+}
+
+svn_error_t *
+svn_wc__compute_text_deltas(svn_wc__text_deltas_t *td,
+                            apr_pool_t *scratch_pool)
+{
+  svn_stream_t *delta_stream;
+  svn_txdelta_stream_t *txdelta_stream;
+  count_windows_baton_t baton;
+  svn_error_t *err;
+  svn_error_t *err2;
+
+  /* The delta only lives until it is sent, so don't bother compressing
+     it. */
+  SVN_ERR(svn_stream_open_unique(&delta_stream, &td->delta_abspath,
+                                 td->tmpdir_abspath,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 td->pool, scratch_pool));
+  svn_txdelta_to_svndiff3(&baton.handler, &baton.handler_baton,
+                          delta_stream, 0, SVN_DELTA_COMPRESSION_LEVEL_NONE,
+                          scratch_pool);
+  baton.td = td;
+
+  svn_txdelta2(&txdelta_stream, td->base_stream, td->local_stream,
+               FALSE, scratch_pool);
+  err = svn_txdelta_send_txstream(txdelta_stream, count_windows, &baton,
+                                  scratch_pool);
+
+  /* Close the two streams to force writing the digests */
+  err2 = svn_stream_close(td->base_stream);
+  if (err2)
+    {
+      td->verify_checksum = NULL;
+      err = svn_error_compose_create(err, err2);
+    }
+
+  err = svn_error_compose_create(err, svn_stream_close(td->local_stream));
+
+  /* As in svn_wc__internal_transmit_text_deltas(), a corrupt text base
+     is worse than any other error. */
+  if (td->expected_md5_checksum && td->verify_checksum
+      && !svn_checksum_match(td->expected_md5_checksum, td->verify_checksum))
+    {
+      err = svn_error_compose_create(
+              svn_checksum_mismatch_err(td->expected_md5_checksum,
+                                        td->verify_checksum, scratch_pool,
+                            _("Checksum mismatch for text base of '%s'"),
+                            svn_dirent_local_style(td->local_abspath,
+                                                   scratch_pool)),
+              err);
+
+      return svn_error_create(SVN_ERR_WC_CORRUPT_TEXT_BASE, err, NULL);
+    }
+
+  SVN_ERR_W(err, apr_psprintf(scratch_pool,
+                              _("While preparing '%s' for commit"),
+                              svn_dirent_local_style(td->local_abspath,
+                                                     scratch_pool)));
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for the svn_txdelta_stream_t reading back the delta file of an
+   svn_wc__text_deltas_t. */
+typedef struct delta_file_baton_t
+{
+  svn_stream_t *stream;
+  int svndiff_version;
+  int windows_left;
+  const svn_checksum_t *md5_checksum;
+} delta_file_baton_t;
+
+/* Implements svn_txdelta_next_window_fn_t */
+static svn_error_t *
+delta_file_next_window(svn_txdelta_window_t **window,
+                       void *baton,
+                       apr_pool_t *pool)
+{
+  delta_file_baton_t *b = baton;
+
+  if (b->windows_left == 0)
+    {
+      *window = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_txdelta_read_svndiff_window(window, b->stream,
+                                          b->svndiff_version, pool));
+  b->windows_left--;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_txdelta_md5_digest_fn_t */
+static const unsigned char *
+delta_file_md5_digest(void *baton)
+{
+  delta_file_baton_t *b = baton;
+
+  return b->md5_checksum->digest;
+}
+
+/* Implements svn_txdelta_stream_open_func_t, reading the delta file of
+   the svn_wc__text_deltas_t in BATON from its start on every call. */
+static svn_error_t *
+open_delta_file(svn_txdelta_stream_t **txdelta_stream_p,
+                void *baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  svn_wc__text_deltas_t *td = baton;
+  delta_file_baton_t *b = apr_palloc(result_pool, sizeof(*b));
+  char header[4];
+  apr_size_t len = sizeof(header);
+
+  SVN_ERR(svn_stream_open_readonly(&b->stream, td->delta_abspath,
+                                   result_pool, scratch_pool));
+  SVN_ERR(svn_stream_read_full(b->stream, header, &len));
+  if (len != sizeof(header) || memcmp(header, "SVN", 3) != 0)
+    return svn_error_createf(SVN_ERR_SVNDIFF_INVALID_HEADER, NULL,
+                             _("Invalid delta for '%s'"),
+                             svn_dirent_local_style(td->local_abspath,
+                                                    scratch_pool));
+
+  b->svndiff_version = header[3];
+  b->windows_left = td->window_count;
+  b->md5_checksum = td->local_md5_checksum;
+
+  *txdelta_stream_p = svn_txdelta_stream_create(b, delta_file_next_window,
+                                                delta_file_md5_digest,
+                                                result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__send_text_deltas(const svn_checksum_t **new_text_base_md5_checksum,
+                         const svn_checksum_t **new_text_base_sha1_checksum,
+                         svn_wc_context_t *wc_ctx,
+                         svn_wc__text_deltas_t *td,
+                         const svn_delta_editor_t *editor,
+                         void *file_baton,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  const char *base_digest_hex = NULL;
+
+  if (td->expected_md5_checksum)
+    base_digest_hex = svn_checksum_to_cstring_display(
+                        td->expected_md5_checksum, scratch_pool);
+
+  SVN_ERR_W(editor->apply_textdelta_stream(editor, file_baton,
+                                           base_digest_hex,
+                                           open_delta_file, td,
+                                           scratch_pool),
+            apr_psprintf(scratch_pool,
+                         _("While preparing '%s' for commit"),
+                         svn_dirent_local_style(td->local_abspath,
+                                                scratch_pool)));
+
+  SVN_ERR(svn_wc__db_pristine_install(td->install_data,
+                                      td->local_sha1_checksum,
+                                      td->local_md5_checksum,
+                                      scratch_pool));
+
+  if (new_text_base_md5_checksum)
+    *new_text_base_md5_checksum = svn_checksum_dup(td->local_md5_checksum,
+                                                   result_pool);
+  if (new_text_base_sha1_checksum)
+    *new_text_base_sha1_checksum = svn_checksum_dup(td->local_sha1_checksum,
+                                                    result_pool);
+
+  return svn_error_trace(
+             editor->close_file(file_baton,
+                                svn_checksum_to_cstring(td->local_md5_checksum,
+                                                        scratch_pool),
+                                scratch_pool));
+}
+
 svn_error_t *
 svn_wc__internal_transmit_prop_deltas(svn_wc__db_t *db,
                                      const char *local_abspath,
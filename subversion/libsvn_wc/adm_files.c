@@ -43,6 +43,7 @@
 #include "adm_files.h"
 #include "entries.h"
 #include "lock.h"
+#include "textbase.h"
 
 #include "svn_private_config.h"
 #include "private/svn_wc_private.h"
@@ -209,9 +210,9 @@ svn_wc__text_base_path_to_read(const char **result_abspath,
                              _("Node '%s' has no pristine text"),
                              svn_dirent_local_style(local_abspath,
                                                     scratch_pool));
-  SVN_ERR(svn_wc__db_pristine_get_path(result_abspath, db, local_abspath,
-                                       checksum,
-                                       result_pool, scratch_pool));
+  SVN_ERR(svn_wc__textbase_get_path(result_abspath, db, local_abspath,
+                                    checksum,
+                                    result_pool, scratch_pool));
   return SVN_NO_ERROR;
 }
 
@@ -266,9 +267,26 @@ svn_wc__get_pristine_contents(svn_stream_t **contents,
                              svn_dirent_local_style(local_abspath,
                                                     scratch_pool));
   if (sha1_checksum)
-    SVN_ERR(svn_wc__db_pristine_read(contents, size, db, local_abspath,
+    {
+      svn_error_t *err;
+
+      err = svn_wc__db_pristine_read(contents, size, db, local_abspath,
                                      sha1_checksum,
-                                     result_pool, scratch_pool));
+                                     result_pool, scratch_pool);
+      if (err && err->apr_err == SVN_ERR_WC_PRISTINE_DEHYDRATED)
+        {
+          /* The size is known, so just look for the text elsewhere. */
+          svn_error_clear(err);
+          SVN_ERR(svn_wc__db_pristine_read(NULL, size, db, local_abspath,
+                                           sha1_checksum,
+                                           scratch_pool, scratch_pool));
+          SVN_ERR(svn_wc__textbase_get_contents(contents, db, local_abspath,
+                                                sha1_checksum,
+                                                result_pool, scratch_pool));
+        }
+      else
+        SVN_ERR(err);
+    }
   else
     *contents = NULL;
 
@@ -312,7 +330,8 @@ init_adm_tmp_area(const char *path, apr_pool_t *pool)
 /* Set up a new adm area for PATH, with REPOS_* as the repos info, and
    INITIAL_REV as the starting revision.  The entries file starts out
    marked as 'incomplete.  The adm area starts out locked; remember to
-   unlock it when done. */
+   unlock it when done.  If STORE_PRISTINE is FALSE, the working copy
+   will only keep the pristine texts it needs. */
 static svn_error_t *
 init_adm(svn_wc__db_t *db,
          const char *local_abspath,
@@ -321,6 +340,7 @@ init_adm(svn_wc__db_t *db,
          const char *repos_uuid,
          svn_revnum_t initial_rev,
          svn_depth_t depth,
+         svn_boolean_t store_pristine,
          apr_pool_t *pool)
 {
   /* First, make an empty administrative area. */
@@ -342,7 +362,7 @@ init_adm(svn_wc__db_t *db,
   /* Create the SDB. */
   SVN_ERR(svn_wc__db_init(db, local_abspath,
                           repos_relpath, repos_root_url, repos_uuid,
-                          initial_rev, depth,
+                          initial_rev, depth, store_pristine,
                           pool));
 
   /* Stamp ENTRIES and FORMAT files for old clients.  */
@@ -368,6 +388,7 @@ svn_wc__internal_ensure_adm(svn_wc__db_t *db,
                             const char *repos_uuid,
                             svn_revnum_t revision,
                             svn_depth_t depth,
+                            svn_boolean_t store_pristine,
                             apr_pool_t *scratch_pool)
 {
   int format;
@@ -394,7 +415,8 @@ svn_wc__internal_ensure_adm(svn_wc__db_t *db,
   if (format == 0)
     return svn_error_trace(init_adm(db, local_abspath,
                                     repos_relpath, repos_root_url, repos_uuid,
-                                    revision, depth, scratch_pool));
+                                    revision, depth, store_pristine,
+                                    scratch_pool));
 
   SVN_ERR(svn_wc__db_read_info(&status, NULL,
                                &db_revision, &db_repos_relpath,
@@ -473,18 +495,20 @@ svn_wc__internal_ensure_adm(svn_wc__db_t *db,
 }
 
 svn_error_t *
-svn_wc_ensure_adm4(svn_wc_context_t *wc_ctx,
+svn_wc_ensure_adm5(svn_wc_context_t *wc_ctx,
                    const char *local_abspath,
                    const char *url,
                    const char *repos_root_url,
                    const char *repos_uuid,
                    svn_revnum_t revision,
                    svn_depth_t depth,
+                   svn_boolean_t store_pristine,
                    apr_pool_t *scratch_pool)
 {
   return svn_error_trace(
     svn_wc__internal_ensure_adm(wc_ctx->db, local_abspath, url, repos_root_url,
-                                repos_uuid, revision, depth, scratch_pool));
+                                repos_uuid, revision, depth, store_pristine,
+                                scratch_pool));
 }
 
 svn_error_t *
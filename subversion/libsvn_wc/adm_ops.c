@@ -820,6 +820,9 @@ typedef struct get_pristine_lazyopen_baton_t
   const char *wri_abspath;
   const svn_checksum_t *checksum;
 
+  /* The file in the shared pristine store to read instead, or NULL. */
+  const char *shared_abspath;
+
 } get_pristine_lazyopen_baton_t;
 
 
@@ -833,6 +836,12 @@ get_pristine_lazyopen_func(svn_stream_t **stream,
   get_pristine_lazyopen_baton_t *b = baton;
   const svn_checksum_t *sha1_checksum;
 
+  if (b->shared_abspath)
+    return svn_error_trace(svn_stream_open_readonly(stream,
+                                                    b->shared_abspath,
+                                                    result_pool,
+                                                    scratch_pool));
+
   /* svn_wc__db_pristine_read() wants a SHA1, so if we have an MD5,
      we'll use it to lookup the SHA1. */
   if (b->checksum->kind == svn_checksum_sha1)
@@ -857,13 +866,20 @@ svn_wc__get_pristine_contents_by_checksum(svn_stream_t **contents,
                                           apr_pool_t *scratch_pool)
 {
   svn_boolean_t present;
+  const char *shared_abspath = NULL;
 
   *contents = NULL;
 
   SVN_ERR(svn_wc__db_pristine_check(&present, wc_ctx->db, wri_abspath,
                                     checksum, scratch_pool));
 
-  if (present)
+  /* Another working copy on this host may have the text. */
+  if (!present)
+    SVN_ERR(svn_wc__db_pristine_get_shared_path(&shared_abspath, wc_ctx->db,
+                                                checksum, result_pool,
+                                                scratch_pool));
+
+  if (present || shared_abspath)
     {
       get_pristine_lazyopen_baton_t *gpl_baton;
 
@@ -871,6 +887,7 @@ svn_wc__get_pristine_contents_by_checksum(svn_stream_t **contents,
       gpl_baton->wc_ctx = wc_ctx;
       gpl_baton->wri_abspath = wri_abspath;
       gpl_baton->checksum = checksum;
+      gpl_baton->shared_abspath = shared_abspath;
 
       *contents = svn_stream_lazyopen_create(get_pristine_lazyopen_func,
                                              gpl_baton, FALSE, result_pool);
@@ -114,3 +114,9 @@ svn_wc_context_destroy(svn_wc_context_t *wc_ctx)
 
   return SVN_NO_ERROR;
 }
+
+int
+svn_wc__get_io_threads(svn_wc_context_t *wc_ctx)
+{
+  return svn_wc__db_get_io_threads(wc_ctx->db);
+}
@@ -51,6 +51,7 @@
 #include "adm_files.h"
 #include "props.h"
 #include "translate.h"
+#include "textbase.h"
 #include "workqueue.h"
 #include "conflicts.h"
 
@@ -631,9 +632,10 @@ apply_textdelta(void *file_baton,
                                                            pool)));
         }
 
-      SVN_ERR(svn_wc__db_pristine_read(&src_stream, NULL, eb->db,
-                                       eb->wri_abspath, eb->original_checksum,
-                                       pool, pool));
+      SVN_ERR(svn_wc__textbase_get_contents(&src_stream, eb->db,
+                                            eb->local_abspath,
+                                            eb->original_checksum,
+                                            pool, pool));
     }
   else
     src_stream = svn_stream_empty(pool);
@@ -0,0 +1,533 @@
+/*
+ * fsmonitor.c :  skipping unchanged directories using a change journal
+ *                kept by an external file system monitor
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_pools.h>
+#include <apr_time.h>
+
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_string.h"
+
+#include "wc.h"
+#include "adm_files.h"
+#include "fsmonitor.h"
+
+#include "private/svn_mutex.h"
+
+#include "svn_private_config.h"
+
+/* Files in the admin area of the working copy root. */
+#define JOURNAL_FILE  "fsmonitor-journal"
+#define BASELINE_FILE "fsmonitor-baseline"
+#define COOKIE_FILE   "fsmonitor-cookie"
+#define SDB_FILE      "wc.db"
+
+/* Prefixes of the journal header and of cookie lines. */
+#define JOURNAL_HEADER "svn-fsmonitor 1 "
+#define COOKIE_LINE    "!cookie "
+
+/* How long to wait for the monitor to journal our cookie and how often
+   to look for it in the meantime. */
+#define SYNC_TIMEOUT  apr_time_from_sec(2)
+#define SYNC_INTERVAL (APR_USEC_PER_SEC / 1000)
+
+struct svn_wc__fsmonitor_t
+{
+  /* The working copy being watched. */
+  const char *wcroot_abspath;
+
+  /* Monitor session from the journal header. */
+  const char *token;
+
+  /* Number of bytes in the complete lines of the journal when we read it.
+     Journal lines past this point belong to the next baseline. */
+  apr_size_t journal_len;
+
+  /* Size and modification time of wc.db when we read the journal. */
+  apr_off_t db_size;
+  apr_time_t db_mtime;
+
+  /* Relpaths of nodes that may differ from the working copy's recorded
+     state, together with all their ancestors.  NULL if there is no usable
+     baseline. */
+  apr_hash_t *dirty;
+
+  /* Relpaths to put into the next baseline, allocated in RECORD_POOL,
+     which is a root pool so that RECORDED may be added to from any thread
+     while holding MUTEX. */
+  apr_array_header_t *recorded;
+  apr_pool_t *record_pool;
+  svn_mutex__t *mutex;
+};
+
+/* Implements apr_pool_cleanup_t, destroying the pool given as DATA. */
+static apr_status_t
+destroy_record_pool(void *data)
+{
+  svn_pool_destroy(data);
+  return APR_SUCCESS;
+}
+
+/* Set *SIZE and *MTIME to those of wc.db in WCROOT_ABSPATH. */
+static svn_error_t *
+stat_db(apr_off_t *size,
+        apr_time_t *mtime,
+        const char *wcroot_abspath,
+        apr_pool_t *scratch_pool)
+{
+  apr_finfo_t finfo;
+
+  SVN_ERR(svn_io_stat(&finfo,
+                      svn_wc__adm_child(wcroot_abspath, SDB_FILE,
+                                        scratch_pool),
+                      APR_FINFO_SIZE | APR_FINFO_MTIME, scratch_pool));
+  *size = finfo.size;
+  *mtime = finfo.mtime;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CONTENTS to the contents of the journal in WCROOT_ABSPATH.  Set it
+   to NULL if the journal does not exist or if no monitor holds its lock,
+   i.e. if the journal may be missing changes. */
+static svn_error_t *
+read_journal(svn_stringbuf_t **contents,
+             const char *wcroot_abspath,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  svn_error_t *err;
+
+  *contents = NULL;
+
+  err = svn_io_file_open(&file,
+                         svn_wc__adm_child(wcroot_abspath, JOURNAL_FILE,
+                                           scratch_pool),
+                         APR_READ, APR_OS_DEFAULT, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* Being able to lock the journal means that the monitor is gone. */
+  err = svn_io_lock_open_file(file, FALSE, TRUE, scratch_pool);
+  if (err && (APR_STATUS_IS_EAGAIN(err->apr_err)
+              || APR_STATUS_IS_EACCES(err->apr_err)))
+    {
+      svn_error_clear(err);
+      SVN_ERR(svn_stringbuf_from_aprfile(contents, file, result_pool));
+    }
+  else
+    svn_error_clear(err);
+
+  return svn_error_trace(svn_io_file_close(file, scratch_pool));
+}
+
+/* If JOURNAL starts with a valid header, set *TOKEN to the token found in
+   it and *BODY to the first line after the header.  Otherwise, set both to
+   NULL.  This modifies JOURNAL. */
+static void
+parse_header(const char **token,
+             char **body,
+             svn_stringbuf_t *journal)
+{
+  char *eol;
+
+  *token = NULL;
+  *body = NULL;
+
+  if (strncmp(journal->data, JOURNAL_HEADER, strlen(JOURNAL_HEADER)) != 0)
+    return;
+
+  eol = strchr(journal->data, '\n');
+  if (!eol)
+    return;
+
+  *eol = '\0';
+  *token = journal->data + strlen(JOURNAL_HEADER);
+  *body = eol + 1;
+}
+
+/* Create a cookie file in the admin area of WCROOT_ABSPATH and wait for
+   the monitor to journal it.  This guarantees that all changes made
+   before this call are in the journal.  Set *JOURNAL to the journal
+   contents including the cookie or to NULL if there is no monitor that
+   keeps the journal up to date. */
+static svn_error_t *
+sync_journal(svn_stringbuf_t **journal,
+             const char *wcroot_abspath,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  apr_pool_t *cookie_pool = svn_pool_create(scratch_pool);
+  apr_file_t *cookie;
+  const char *cookie_abspath;
+  const char *needle;
+  apr_time_t deadline = apr_time_now() + SYNC_TIMEOUT;
+  svn_error_t *err;
+
+  *journal = NULL;
+
+  /* Make the name unique across time, too, so that we can't mistake the
+     cookie of an earlier status walk for ours. */
+  err = svn_io_open_uniquely_named(&cookie, &cookie_abspath,
+                                   svn_wc__adm_child(wcroot_abspath, NULL,
+                                                     scratch_pool),
+                                   apr_psprintf(scratch_pool,
+                                                "%s-%" APR_TIME_T_FMT,
+                                                COOKIE_FILE,
+                                                apr_time_now()),
+                                   ".tmp", svn_io_file_del_on_pool_cleanup,
+                                   cookie_pool, scratch_pool);
+  if (err)
+    {
+      /* E.g. a read-only working copy.  Just don't use the journal. */
+      svn_error_clear(err);
+      svn_pool_destroy(cookie_pool);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_io_file_close(cookie, scratch_pool));
+  needle = apr_pstrcat(scratch_pool, "\n" COOKIE_LINE,
+                       svn_dirent_basename(cookie_abspath, NULL), "\n",
+                       SVN_VA_NULL);
+
+  while (TRUE)
+    {
+      svn_stringbuf_t *contents;
+
+      SVN_ERR(read_journal(&contents, wcroot_abspath, result_pool,
+                           scratch_pool));
+      if (!contents)
+        break;
+
+      if (strstr(contents->data, needle))
+        {
+          *journal = contents;
+          break;
+        }
+
+      if (apr_time_now() > deadline)
+        break;
+
+      apr_sleep(SYNC_INTERVAL);
+    }
+
+  svn_pool_destroy(cookie_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Add RELPATH and all its ancestors to DIRTY, allocated in RESULT_POOL. */
+static void
+mark_dirty(apr_hash_t *dirty,
+           const char *relpath,
+           apr_pool_t *result_pool)
+{
+  /* All ancestors of paths in DIRTY are in DIRTY as well. */
+  while (!svn_hash_gets(dirty, relpath))
+    {
+      svn_hash_sets(dirty, relpath, "");
+      if (*relpath == '\0')
+        break;
+
+      relpath = svn_relpath_dirname(relpath, result_pool);
+    }
+}
+
+/* Add the paths listed in the complete lines between START and END to
+   DIRTY, allocated in RESULT_POOL.  Skip control lines starting with '!'.
+   Return FALSE if some path is not a canonical relpath.  This modifies
+   the data between START and END. */
+static svn_boolean_t
+mark_lines_dirty(apr_hash_t *dirty,
+                 char *start,
+                 const char *end,
+                 apr_pool_t *result_pool)
+{
+  while (start < end)
+    {
+      char *eol = memchr(start, '\n', end - start);
+      if (!eol)
+        break;
+
+      *eol = '\0';
+      if (*start != '!')
+        {
+          if (!svn_relpath_is_canonical(start))
+            return FALSE;
+
+          mark_dirty(dirty, start, result_pool);
+        }
+
+      start = eol + 1;
+    }
+
+  return TRUE;
+}
+
+/* Set MONITOR->DIRTY from the baseline in MONITOR's working copy and the
+   journal lines in JOURNAL_BODY up to MONITOR->JOURNAL_LEN if the baseline
+   belongs to the current journal and wc.db.  Allocate the result in
+   RESULT_POOL.  This modifies JOURNAL_BODY. */
+static svn_error_t *
+read_baseline(svn_wc__fsmonitor_t *monitor,
+              char *journal_body,
+              const char *journal_end,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *baseline;
+  char *eol;
+  apr_array_header_t *fields;
+  apr_uint64_t journal_len, db_size;
+  apr_int64_t db_mtime;
+  apr_hash_t *dirty;
+  svn_error_t *err;
+
+  err = svn_stringbuf_from_file2(&baseline,
+                                 svn_wc__adm_child(monitor->wcroot_abspath,
+                                                   BASELINE_FILE,
+                                                   scratch_pool),
+                                 result_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* "TOKEN JOURNAL_LEN DB_SIZE DB_MTIME" */
+  eol = strchr(baseline->data, '\n');
+  if (!eol)
+    return SVN_NO_ERROR;
+
+  *eol = '\0';
+  fields = svn_cstring_split(baseline->data, " ", FALSE, scratch_pool);
+  if (fields->nelts != 4
+      || strcmp(APR_ARRAY_IDX(fields, 0, const char *), monitor->token))
+    return SVN_NO_ERROR;
+
+  err = svn_cstring_atoui64(&journal_len,
+                            APR_ARRAY_IDX(fields, 1, const char *));
+  if (!err)
+    err = svn_cstring_atoui64(&db_size,
+                              APR_ARRAY_IDX(fields, 2, const char *));
+  if (!err)
+    err = svn_cstring_atoi64(&db_mtime,
+                             APR_ARRAY_IDX(fields, 3, const char *));
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  if (journal_len > monitor->journal_len
+      || db_size != (apr_uint64_t)monitor->db_size
+      || db_mtime != monitor->db_mtime)
+    return SVN_NO_ERROR;
+
+  /* Everything the last walk did not report as normal may still be
+     dirty, and so may be everything journaled after the walk started. */
+  dirty = apr_hash_make(result_pool);
+  if (!mark_lines_dirty(dirty, eol + 1, baseline->data + baseline->len,
+                        result_pool))
+    return SVN_NO_ERROR;
+
+  if (!mark_lines_dirty(dirty,
+                        journal_body + (apr_size_t)journal_len,
+                        journal_end, result_pool))
+    return SVN_NO_ERROR;
+
+  monitor->dirty = dirty;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__fsmonitor_open(svn_wc__fsmonitor_t **monitor,
+                       svn_wc__db_t *db,
+                       const char *local_abspath,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  svn_wc__fsmonitor_t *m;
+  const char *wcroot_abspath;
+  svn_node_kind_t kind;
+  svn_stringbuf_t *journal;
+  const char *token;
+  char *body;
+  const char *end;
+  apr_off_t db_size;
+  apr_time_t db_mtime;
+
+  *monitor = NULL;
+
+  SVN_ERR(svn_wc__db_get_wcroot(&wcroot_abspath, db, local_abspath,
+                                result_pool, scratch_pool));
+
+  /* Most working copies are not being watched. */
+  SVN_ERR(svn_io_check_path(svn_wc__adm_child(wcroot_abspath, JOURNAL_FILE,
+                                              scratch_pool),
+                            &kind, scratch_pool));
+  if (kind != svn_node_file)
+    return SVN_NO_ERROR;
+
+  /* Look at wc.db first, so we notice any change made to it afterwards. */
+  SVN_ERR(stat_db(&db_size, &db_mtime, wcroot_abspath, scratch_pool));
+
+  SVN_ERR(sync_journal(&journal, wcroot_abspath, result_pool,
+                       scratch_pool));
+  if (!journal)
+    return SVN_NO_ERROR;
+
+  parse_header(&token, &body, journal);
+  if (!token)
+    return SVN_NO_ERROR;
+
+  /* Ignore a line that the monitor is still writing. */
+  end = strrchr(body, '\n');
+  end = end ? end + 1 : body;
+
+  m = apr_pcalloc(result_pool, sizeof(*m));
+  m->wcroot_abspath = wcroot_abspath;
+  m->token = token;
+  m->journal_len = end - body;
+  m->db_size = db_size;
+  m->db_mtime = db_mtime;
+
+  m->record_pool = svn_pool_create(NULL);
+  apr_pool_cleanup_register(result_pool, m->record_pool, destroy_record_pool,
+                            apr_pool_cleanup_null);
+  m->recorded = apr_array_make(m->record_pool, 16, sizeof(const char *));
+  SVN_ERR(svn_mutex__init(&m->mutex, TRUE, result_pool));
+
+  SVN_ERR(read_baseline(m, body, end, result_pool, scratch_pool));
+
+  *monitor = m;
+
+  return SVN_NO_ERROR;
+}
+
+svn_boolean_t
+svn_wc__fsmonitor_is_clean(const svn_wc__fsmonitor_t *monitor,
+                           const char *local_abspath)
+{
+  const char *relpath;
+
+  if (!monitor->dirty)
+    return FALSE;
+
+  relpath = svn_dirent_skip_ancestor(monitor->wcroot_abspath, local_abspath);
+
+  return relpath && !svn_hash_gets(monitor->dirty, relpath);
+}
+
+/* Append RELPATH to MONITOR->RECORDED.  MONITOR->MUTEX must be held. */
+static svn_error_t *
+record_relpath(svn_wc__fsmonitor_t *monitor,
+               const char *relpath)
+{
+  APR_ARRAY_PUSH(monitor->recorded, const char *)
+    = apr_pstrdup(monitor->record_pool, relpath);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__fsmonitor_record(svn_wc__fsmonitor_t *monitor,
+                         const char *local_abspath)
+{
+  const char *relpath = svn_dirent_skip_ancestor(monitor->wcroot_abspath,
+                                                 local_abspath);
+
+  if (relpath)
+    SVN_MUTEX__WITH_LOCK(monitor->mutex, record_relpath(monitor, relpath));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__fsmonitor_save_baseline(svn_wc__fsmonitor_t *monitor,
+                                apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *journal;
+  svn_stringbuf_t *baseline;
+  const char *token;
+  char *body;
+  apr_off_t db_size;
+  apr_time_t db_mtime;
+  int i;
+
+  /* Someone else may have changed the working copy meanwhile. */
+  SVN_ERR(stat_db(&db_size, &db_mtime, monitor->wcroot_abspath,
+                  scratch_pool));
+  if (db_size != monitor->db_size || db_mtime != monitor->db_mtime)
+    return SVN_NO_ERROR;
+
+  /* Without a monitor session spanning the whole walk, changes that the
+     walk didn't see might not have been journaled. */
+  SVN_ERR(read_journal(&journal, monitor->wcroot_abspath, scratch_pool,
+                       scratch_pool));
+  if (!journal)
+    return SVN_NO_ERROR;
+
+  parse_header(&token, &body, journal);
+  if (!token || strcmp(token, monitor->token)
+      || strlen(body) < monitor->journal_len)
+    return SVN_NO_ERROR;
+
+  baseline = svn_stringbuf_createf(scratch_pool,
+                                   "%s %" APR_SIZE_T_FMT " %" APR_OFF_T_FMT
+                                   " %" APR_TIME_T_FMT "\n",
+                                   monitor->token, monitor->journal_len,
+                                   monitor->db_size, monitor->db_mtime);
+  for (i = 0; i < monitor->recorded->nelts; i++)
+    {
+      svn_stringbuf_appendcstr(baseline,
+                               APR_ARRAY_IDX(monitor->recorded, i,
+                                             const char *));
+      svn_stringbuf_appendbyte(baseline, '\n');
+    }
+
+  return svn_error_trace(
+           svn_io_write_atomic2(svn_wc__adm_child(monitor->wcroot_abspath,
+                                                  BASELINE_FILE,
+                                                  scratch_pool),
+                                baseline->data, baseline->len,
+                                NULL, FALSE, scratch_pool));
+}
+
+const char *
+svn_wc__fsmonitor_get_wcroot(const svn_wc__fsmonitor_t *monitor)
+{
+  return monitor->wcroot_abspath;
+}
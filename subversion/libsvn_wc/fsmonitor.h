@@ -0,0 +1,112 @@
+/*
+ * fsmonitor.h :  skipping unchanged directories using a change journal
+ *                kept by an external file system monitor
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* A file system monitor (see tools/client-side/svn-fsmonitor.py) may
+   watch a working copy and append the wcroot-relative path of every
+   node that changes on disk to the journal file .svn/fsmonitor-journal.
+   The journal starts with a header line
+
+       svn-fsmonitor 1 TOKEN
+
+   where TOKEN identifies the monitor session.  While it runs, the monitor
+   keeps an exclusive lock on the journal, so a journal that we can lock
+   has no live monitor behind it and must not be trusted.
+
+   To make sure that all changes made before a status walk have been
+   journaled, the walk creates a cookie file in the admin area and waits
+   for the monitor to append the line "!cookie NAME" for it.
+
+   A complete status walk records every path that it reports with a status
+   other than normal, including ignored nodes, in .svn/fsmonitor-baseline
+   along with the journal TOKEN, the journal length and the state of wc.db
+   at the beginning of the walk.  Later walks consider a directory to be
+   clean if neither the baseline nor any journal line written after that
+   point refer to it or to any of its descendants.  The contents of clean
+   directories need not be read from disk because they can only contain
+   versioned nodes that still match their recorded size and timestamp.
+
+   Any mismatch between journal, baseline and wc.db simply disables the
+   shortcut and makes the walk read everything from disk.
+ */
+
+#ifndef SVN_WC_FSMONITOR_H
+#define SVN_WC_FSMONITOR_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+
+#include "wc_db.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Access to the change journal of a working copy. */
+typedef struct svn_wc__fsmonitor_t svn_wc__fsmonitor_t;
+
+/* Set *MONITOR to the change journal of the working copy that contains
+   LOCAL_ABSPATH in DB, after making sure that the monitor has caught up
+   with all changes made so far.  Set *MONITOR to NULL if there is no
+   journal or no live monitor that keeps it up to date.
+
+   Allocate *MONITOR in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_wc__fsmonitor_open(svn_wc__fsmonitor_t **monitor,
+                       svn_wc__db_t *db,
+                       const char *local_abspath,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool);
+
+/* Return TRUE if neither the directory LOCAL_ABSPATH nor any node below it
+   may have changed on disk since MONITOR's baseline had been recorded. */
+svn_boolean_t
+svn_wc__fsmonitor_is_clean(const svn_wc__fsmonitor_t *monitor,
+                           const char *local_abspath);
+
+/* Record LOCAL_ABSPATH as not being normal in MONITOR's next baseline.
+   This function may be called from multiple threads. */
+svn_error_t *
+svn_wc__fsmonitor_record(svn_wc__fsmonitor_t *monitor,
+                         const char *local_abspath);
+
+/* Store the paths passed to svn_wc__fsmonitor_record() as MONITOR's new
+   baseline.  This must only be called after a successful status walk of
+   the whole working copy with text modification checks.  Do nothing if
+   the journal or wc.db have changed in ways that could make the new
+   baseline incomplete.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_wc__fsmonitor_save_baseline(svn_wc__fsmonitor_t *monitor,
+                                apr_pool_t *scratch_pool);
+
+/* Return the root of the working copy watched by MONITOR. */
+const char *
+svn_wc__fsmonitor_get_wcroot(const svn_wc__fsmonitor_t *monitor);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_WC_FSMONITOR_H */
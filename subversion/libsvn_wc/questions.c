@@ -46,6 +46,7 @@
 
 #include "svn_private_config.h"
 #include "private/svn_wc_private.h"
+#include "private/svn_subr_private.h"
 
 
 
@@ -177,24 +178,27 @@ compare_and_verify(svn_boolean_t *modified_p,
                 return svn_error_create(SVN_ERR_IO_UNKNOWN_EOL,
                                         svn_stream_close(v_stream), NULL);
 
-              /* Wrap file stream to detranslate into normal form,
-               * "repairing" the EOL style if it is inconsistent. */
-              v_stream = svn_subst_stream_translated(v_stream,
-                                                     eol_str,
-                                                     TRUE /* repair */,
-                                                     keywords,
-                                                     FALSE /* expand */,
-                                                     scratch_pool);
+              /* Detranslate the file into normal form, "repairing" the
+               * EOL style if it is inconsistent, and compare the result
+               * with the pristine in the same pass. */
+              SVN_ERR(svn_subst__translated_contents_same(
+                        &same, v_stream, pristine_stream, eol_str,
+                        TRUE /* repair */, keywords, FALSE /* expand */,
+                        scratch_pool));
             }
           else
             {
-              /* Wrap base stream to translate into working copy form, and
-               * arrange to throw an error if its EOL style is inconsistent. */
-              pristine_stream = svn_subst_stream_translated(pristine_stream,
-                                                            eol_str, FALSE,
-                                                            keywords, TRUE,
-                                                            scratch_pool);
+              /* Translate the base into working copy form, and arrange
+               * to throw an error if its EOL style is inconsistent. */
+              SVN_ERR(svn_subst__translated_contents_same(
+                        &same, pristine_stream, v_stream, eol_str,
+                        FALSE /* repair */, keywords, TRUE /* expand */,
+                        scratch_pool));
             }
+
+          *modified_p = (! same);
+
+          return SVN_NO_ERROR;
         }
     }
 
@@ -206,6 +210,66 @@ compare_and_verify(svn_boolean_t *modified_p,
   return SVN_NO_ERROR;
 }
 
+/* Set *MODIFIED_P to TRUE if the repository normal form of
+ * VERSIONED_FILE_ABSPATH does not have the checksum SHA1_CHECKSUM, else
+ * to FALSE.
+ *
+ * This is how we detect modifications when the pristine text is not
+ * available in a working copy without a pristine store.
+ *
+ * DB is a wc_db; use SCRATCH_POOL for temporary allocation.
+ */
+static svn_error_t *
+compare_with_checksum(svn_boolean_t *modified_p,
+                      svn_wc__db_t *db,
+                      const char *versioned_file_abspath,
+                      const svn_checksum_t *sha1_checksum,
+                      apr_pool_t *scratch_pool)
+{
+  svn_stream_t *v_stream;
+  svn_checksum_t *actual_checksum;
+  svn_subst_eol_style_t eol_style;
+  const char *eol_str;
+  apr_hash_t *keywords;
+  svn_boolean_t special;
+
+  SVN_ERR(svn_wc__get_translate_info(&eol_style, &eol_str, &keywords,
+                                     &special, db, versioned_file_abspath,
+                                     NULL, FALSE, scratch_pool, scratch_pool));
+
+  if (special)
+    {
+      SVN_ERR(svn_subst_read_specialfile(&v_stream, versioned_file_abspath,
+                                         scratch_pool, scratch_pool));
+      v_stream = svn_stream_checksummed2(v_stream, &actual_checksum, NULL,
+                                         svn_checksum_sha1, TRUE,
+                                         scratch_pool);
+      SVN_ERR(svn_stream_close(v_stream));
+    }
+  else
+    {
+      if (eol_style == svn_subst_eol_style_native)
+        eol_str = SVN_SUBST_NATIVE_EOL_STR;
+      else if (eol_style != svn_subst_eol_style_fixed
+               && eol_style != svn_subst_eol_style_none)
+        return svn_error_create(SVN_ERR_IO_UNKNOWN_EOL, NULL, NULL);
+
+      /* Detranslate and checksum the file in a single pass, "repairing"
+       * the EOL style if it is inconsistent. */
+      SVN_ERR(svn_stream_open_readonly(&v_stream, versioned_file_abspath,
+                                       scratch_pool, scratch_pool));
+      SVN_ERR(svn_subst__translated_checksum(&actual_checksum, v_stream,
+                                             svn_checksum_sha1, eol_str,
+                                             TRUE /* repair */, keywords,
+                                             FALSE /* expand */,
+                                             scratch_pool, scratch_pool));
+    }
+
+  *modified_p = !svn_checksum_match(actual_checksum, sha1_checksum);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
                                  svn_wc__db_t *db,
@@ -223,6 +287,7 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
   svn_boolean_t has_props;
   svn_boolean_t props_mod;
   const svn_io_dirent2_t *dirent;
+  svn_error_t *err;
 
   /* Read the relevant info */
   SVN_ERR(svn_wc__db_read_info(&status, &kind, NULL, NULL, NULL, NULL, NULL,
@@ -302,27 +367,51 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
     }
 
  compare_them:
-  SVN_ERR(svn_wc__db_pristine_read(&pristine_stream, &pristine_size,
-                                   db, local_abspath, checksum,
-                                   scratch_pool, scratch_pool));
+  err = svn_wc__db_pristine_read(&pristine_stream, &pristine_size,
+                                 db, local_abspath, checksum,
+                                 scratch_pool, scratch_pool);
+  if (err && err->apr_err == SVN_ERR_WC_PRISTINE_DEHYDRATED)
+    {
+      /* The pristine text is not stored locally, but its checksum tells
+         whether the working file still matches it.  If it does, the
+         normal form of the working file is as good as the pristine text
+         for an exact comparison. */
+      svn_error_clear(err);
+      SVN_ERR(compare_with_checksum(modified_p, db, local_abspath, checksum,
+                                    scratch_pool));
+
+      if (*modified_p || !exact_comparison)
+        pristine_stream = NULL;
+      else
+        {
+          SVN_ERR(svn_wc__internal_translated_stream(
+                    &pristine_stream, db, local_abspath, local_abspath,
+                    SVN_WC_TRANSLATE_TO_NF
+                      | SVN_WC_TRANSLATE_FORCE_EOL_REPAIR,
+                    scratch_pool, scratch_pool));
+          pristine_size = dirent->filesize;
+        }
+    }
+  else
+    SVN_ERR(err);
 
   /* Check all bytes, and verify checksum if requested. */
-  {
-    svn_error_t *err;
-    err = compare_and_verify(modified_p, db,
-                             local_abspath, dirent->filesize,
-                             pristine_stream, pristine_size,
-                             has_props, props_mod,
-                             exact_comparison,
-                             scratch_pool);
-
-    /* At this point we already opened the pristine file, so we know that
-       the access denied applies to the working copy path */
-    if (err && APR_STATUS_IS_EACCES(err->apr_err))
-      return svn_error_create(SVN_ERR_WC_PATH_ACCESS_DENIED, err, NULL);
-    else
-      SVN_ERR(err);
-  }
+  if (pristine_stream)
+    {
+      err = compare_and_verify(modified_p, db,
+                               local_abspath, dirent->filesize,
+                               pristine_stream, pristine_size,
+                               has_props, props_mod,
+                               exact_comparison,
+                               scratch_pool);
+
+      /* At this point we already opened the pristine file, so we know that
+         the access denied applies to the working copy path */
+      if (err && APR_STATUS_IS_EACCES(err->apr_err))
+        return svn_error_create(SVN_ERR_WC_PATH_ACCESS_DENIED, err, NULL);
+      else
+        SVN_ERR(err);
+    }
 
   if (!*modified_p)
     {
@@ -46,11 +46,15 @@
 
 #include "wc.h"
 #include "props.h"
+#include "fsmonitor.h"
 
 #include "private/svn_sorts_private.h"
 #include "private/svn_wc_private.h"
 #include "private/svn_fspath.h"
 #include "private/svn_editor.h"
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+#include "private/svn_task.h"
 
 
 /* The file internal variant of svn_wc_status3_t, with slightly more
@@ -100,6 +104,15 @@ struct walk_status_baton
 
   /* Repository locks, if set. */
   apr_hash_t *repos_locks;
+
+  /* Number of threads to use for walking the subtrees below the walk's
+     target directory.  1 walks everything on the calling thread. */
+  int threads;
+
+  /* The change journal of the working copy, if it is being watched by
+     a file system monitor.  Used to skip reading unchanged directories
+     and to record which nodes are not normal. */
+  svn_wc__fsmonitor_t *fsmonitor;
 };
 
 /*** Editor batons ***/
@@ -833,6 +846,10 @@ send_status_structure(const struct walk_status_baton *wb,
                           wb->ignore_text_mods, wb->check_working_copy,
                           repos_lock, scratch_pool, scratch_pool));
 
+  if (wb->fsmonitor && statstruct
+      && statstruct->s.node_status != svn_wc_status_normal)
+    SVN_ERR(svn_wc__fsmonitor_record(wb->fsmonitor, local_abspath));
+
   if (statstruct && status_func)
     return svn_error_trace((*status_func)(status_baton, local_abspath,
                                           &statstruct->s,
@@ -1012,6 +1029,10 @@ send_unversioned_item(const struct walk_status_baton *wb,
   if (status->s.conflicted)
     is_ignored = FALSE;
 
+  /* Clean directories have no unversioned children, ignored or not. */
+  if (wb->fsmonitor)
+    SVN_ERR(svn_wc__fsmonitor_record(wb->fsmonitor, local_abspath));
+
   /* If we aren't ignoring it, or if it's an externals path, pass this
      entry to the status func. */
   if (no_ignore
@@ -1188,6 +1209,444 @@ one_child_status(const struct walk_status_baton *wb,
   return SVN_NO_ERROR;
 }
 
+#if APR_HAS_THREADS
+
+/* State shared by all worker threads of a concurrent status walk. */
+typedef struct status_workers_t
+{
+  /* Walk batons (struct walk_status_baton *) not currently used by any
+   * worker.  Each one has its own read-only DB in its own root pool. */
+  apr_array_header_t *idle_batons;
+
+  /* Serializes access to IDLE_BATONS. */
+  svn_mutex__t *mutex;
+
+  /* Parameters of the walk, see get_dir_status(). */
+  const apr_array_header_t *ignore_patterns;
+  svn_boolean_t get_all;
+  svn_boolean_t no_ignore;
+
+  /* Non-zero if the workers shall stop as soon as possible. */
+  svn_atomic_t cancelled;
+} status_workers_t;
+
+/* A versioned subdirectory whose status tree shall be collected by one of
+ * the worker threads.  The node data belongs to the parent directory's
+ * get_dir_status() call, which outlives the task. */
+typedef struct status_task_t
+{
+  const char *local_abspath;
+  const char *parent_abspath;
+  const struct svn_wc__db_info_t *info;
+  const svn_io_dirent2_t *dirent;
+  const char *dir_repos_root_url;
+  const char *dir_repos_relpath;
+  const char *dir_repos_uuid;
+
+  /* Paths (const char *) and their status (svn_wc_status3_t *), in the
+   * order in which the walk reported them. */
+  apr_array_header_t *paths;
+  apr_array_header_t *statuses;
+} status_task_t;
+
+/* Implements svn_cancel_func_t.  BATON is a status_workers_t *. */
+static svn_error_t *
+check_workers_cancelled(void *baton)
+{
+  status_workers_t *workers = baton;
+
+  if (svn_atomic_read(&workers->cancelled))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove an idle walk baton from WORKERS and return it in *WB. */
+static svn_error_t *
+take_idle_baton(struct walk_status_baton **wb,
+                status_workers_t *workers)
+{
+  struct walk_status_baton **entry = apr_array_pop(workers->idle_batons);
+  SVN_ERR_ASSERT(entry);
+  *wb = *entry;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return WB to the list of idle walk batons in WORKERS. */
+static svn_error_t *
+release_idle_baton(status_workers_t *workers,
+                   struct walk_status_baton *wb)
+{
+  APR_ARRAY_PUSH(workers->idle_batons, struct walk_status_baton *) = wb;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_wc_status_func4_t.  Append copies of PATH and STATUS
+ * to the status_task_t BATON. */
+static svn_error_t *
+record_status(void *baton,
+              const char *path,
+              const svn_wc_status3_t *status,
+              apr_pool_t *scratch_pool)
+{
+  status_task_t *task = baton;
+  apr_pool_t *pool = task->statuses->pool;
+  void *new_status = svn_wc_dup_status3(status, pool);
+  const svn_wc__internal_status_t *old_status = (const void*)status;
+
+  /* Copy the internal/private data. */
+  svn_wc__internal_status_t *is = new_status;
+  is->has_descendants = old_status->has_descendants;
+  is->op_root = old_status->op_root;
+
+  APR_ARRAY_PUSH(task->paths, const char *) = apr_pstrdup(pool, path);
+  APR_ARRAY_PUSH(task->statuses, svn_wc_status3_t *) = new_status;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  Collect the status of the
+ * status_task_t TASK and its subtree using one of the walk batons in the
+ * status_workers_t PROCESS_BATON. */
+static svn_error_t *
+status_subtree_task(void **result,
+                    void *task,
+                    void *process_baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  status_task_t *status_task = task;
+  status_workers_t *workers = process_baton;
+  struct walk_status_baton *wb;
+  apr_array_header_t *collected_ignore_patterns = NULL;
+  svn_error_t *err;
+
+  /* DB handles are not thread-safe.  Use one that no other thread is
+   * using right now. */
+  SVN_MUTEX__WITH_LOCK(workers->mutex, take_idle_baton(&wb, workers));
+
+  err = one_child_status(wb,
+                         status_task->local_abspath,
+                         status_task->parent_abspath,
+                         status_task->info,
+                         status_task->dirent,
+                         status_task->dir_repos_root_url,
+                         status_task->dir_repos_relpath,
+                         status_task->dir_repos_uuid,
+                         FALSE /* unversioned_tree_conflicted */,
+                         &collected_ignore_patterns,
+                         workers->ignore_patterns,
+                         svn_depth_infinity,
+                         workers->get_all,
+                         workers->no_ignore,
+                         record_status, status_task,
+                         check_workers_cancelled, workers,
+                         scratch_pool, scratch_pool);
+
+  SVN_MUTEX__WITH_LOCK(workers->mutex, release_idle_baton(workers, wb));
+
+  *result = NULL;
+
+  return svn_error_trace(err);
+}
+
+/* Return TRUE if one_child_status() would recurse into the node described
+ * by INFO when walking with DEPTH. */
+static svn_boolean_t
+is_versioned_subtree(const struct svn_wc__db_info_t *info,
+                     svn_depth_t depth)
+{
+  return info
+      && info->status != svn_wc__db_status_not_present
+      && info->status != svn_wc__db_status_excluded
+      && info->status != svn_wc__db_status_server_excluded
+      && !(info->kind == svn_node_unknown
+           && info->status == svn_wc__db_status_normal)
+      && depth == svn_depth_infinity
+      && info->has_descendants;
+}
+
+/* Push a task for walking the subtree at the child named NAME of
+ * LOCAL_ABSPATH into QUEUE.  The remaining parameters describe the child
+ * as in one_child_status(). */
+static svn_error_t *
+push_subtree_task(svn_task__queue_t *queue,
+                  const char *local_abspath,
+                  const char *name,
+                  const struct svn_wc__db_info_t *info,
+                  const svn_io_dirent2_t *dirent,
+                  const char *dir_repos_root_url,
+                  const char *dir_repos_relpath,
+                  const char *dir_repos_uuid)
+{
+  apr_pool_t *task_pool = svn_pool_create(NULL);
+  status_task_t *task = apr_pcalloc(task_pool, sizeof(*task));
+
+  task->local_abspath = svn_dirent_join(local_abspath, name, task_pool);
+  task->parent_abspath = local_abspath;
+  task->info = info;
+  task->dirent = dirent;
+  task->dir_repos_root_url = dir_repos_root_url;
+  task->dir_repos_relpath = dir_repos_relpath;
+  task->dir_repos_uuid = dir_repos_uuid;
+  task->paths = apr_array_make(task_pool, 0, sizeof(const char *));
+  task->statuses = apr_array_make(task_pool, 0, sizeof(svn_wc_status3_t *));
+
+  return svn_error_trace(svn_task__queue_push(queue, task, task_pool));
+}
+
+/* Like the children loop of get_dir_status() but let WB->THREADS worker
+ * threads walk the versioned subdirectories among SORTED_CHILDREN of
+ * LOCAL_ABSPATH, each using its own read-only DB.  Their statuses will be
+ * reported through STATUS_FUNC / STATUS_BATON in the same order as the
+ * serial walk would.
+ *
+ * DIRENTS, NODES and CONFLICTS map the children's names to their dirent,
+ * info and conflict information, respectively.  The other parameters are
+ * the same as for get_dir_status().
+ *
+ * Only the calling thread will invoke STATUS_FUNC and CANCEL_FUNC. */
+static svn_error_t *
+get_children_status_concurrently(const struct walk_status_baton *wb,
+                                 const char *local_abspath,
+                                 const apr_array_header_t *sorted_children,
+                                 apr_hash_t *dirents,
+                                 apr_hash_t *nodes,
+                                 apr_hash_t *conflicts,
+                                 const char *dir_repos_root_url,
+                                 const char *dir_repos_relpath,
+                                 const char *dir_repos_uuid,
+                                 const apr_array_header_t *ignore_patterns,
+                                 svn_boolean_t get_all,
+                                 svn_boolean_t no_ignore,
+                                 svn_wc_status_func4_t status_func,
+                                 void *status_baton,
+                                 svn_cancel_func_t cancel_func,
+                                 void *cancel_baton,
+                                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *queue_pool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_array_header_t *db_pools = apr_array_make(scratch_pool, wb->threads,
+                                                sizeof(apr_pool_t *));
+  apr_array_header_t *collected_ignore_patterns = NULL;
+  status_workers_t *workers = apr_pcalloc(scratch_pool, sizeof(*workers));
+  svn_task__queue_t *queue = NULL;
+  int max_pending = 2 * wb->threads;
+  int next_child = 0;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  workers->ignore_patterns = ignore_patterns;
+  workers->get_all = get_all;
+  workers->no_ignore = no_ignore;
+  workers->idle_batons = apr_array_make(scratch_pool, wb->threads,
+                                        sizeof(struct walk_status_baton *));
+  SVN_ERR(svn_mutex__init(&workers->mutex, TRUE, scratch_pool));
+
+  /* Each worker gets its own DB and, hence, its own SQLite connections.
+   * They walk their subtrees on a single thread each. */
+  for (i = 0; i < wb->threads && !err; ++i)
+    {
+      apr_pool_t *db_pool = svn_pool_create(NULL);
+      struct walk_status_baton *worker_wb = apr_pmemdup(db_pool, wb,
+                                                        sizeof(*wb));
+
+      APR_ARRAY_PUSH(db_pools, apr_pool_t *) = db_pool;
+      worker_wb->threads = 1;
+      err = svn_wc__db_open_readonly_clone(&worker_wb->db, wb->db, db_pool,
+                                           iterpool);
+      if (!err)
+        APR_ARRAY_PUSH(workers->idle_batons, struct walk_status_baton *)
+          = worker_wb;
+    }
+
+  if (!err)
+    err = svn_task__queue_create(&queue, wb->threads, 0, status_subtree_task,
+                                 workers, queue_pool);
+
+  for (i = 0; !err && i < sorted_children->nelts; i++)
+    {
+      svn_sort__item_t item;
+      const struct svn_wc__db_info_t *child_info;
+      apr_pool_t *task_pool = NULL;
+      status_task_t *task;
+      svn_error_t *task_err;
+      void *result;
+      int k;
+
+      svn_pool_clear(iterpool);
+
+      /* Keep the workers busy but don't run too far ahead of the child
+       * to report next. */
+      for (;    !err
+             && next_child < sorted_children->nelts
+             && svn_task__queue_size(queue) < max_pending;
+           ++next_child)
+        {
+          item = APR_ARRAY_IDX(sorted_children, next_child,
+                               svn_sort__item_t);
+          child_info = apr_hash_get(nodes, item.key, item.klen);
+
+          if (is_versioned_subtree(child_info, svn_depth_infinity))
+            err = push_subtree_task(queue, local_abspath, item.key,
+                                    child_info,
+                                    apr_hash_get(dirents, item.key,
+                                                 item.klen),
+                                    dir_repos_root_url, dir_repos_relpath,
+                                    dir_repos_uuid);
+        }
+
+      if (err)
+        break;
+
+      item = APR_ARRAY_IDX(sorted_children, i, svn_sort__item_t);
+      child_info = apr_hash_get(nodes, item.key, item.klen);
+
+      /* Everything but versioned subtrees is cheap to do right here. */
+      if (!is_versioned_subtree(child_info, svn_depth_infinity))
+        {
+          err = one_child_status(wb,
+                                 svn_dirent_join(local_abspath, item.key,
+                                                 iterpool),
+                                 local_abspath,
+                                 child_info,
+                                 apr_hash_get(dirents, item.key, item.klen),
+                                 dir_repos_root_url,
+                                 dir_repos_relpath,
+                                 dir_repos_uuid,
+                                 apr_hash_get(conflicts, item.key,
+                                              item.klen) != NULL,
+                                 &collected_ignore_patterns,
+                                 ignore_patterns,
+                                 svn_depth_infinity,
+                                 get_all,
+                                 no_ignore,
+                                 status_func,
+                                 status_baton,
+                                 cancel_func,
+                                 cancel_baton,
+                                 scratch_pool,
+                                 iterpool);
+          continue;
+        }
+
+      if (cancel_func)
+        err = cancel_func(cancel_baton);
+      if (err)
+        break;
+
+      /* The oldest pending task belongs to this child. */
+      task_err = svn_task__queue_pop(&result, (void **)&task, &task_pool,
+                                     queue);
+      if (!task_pool)
+        {
+          err = task_err;
+          break;
+        }
+
+      /* Report whatever the worker found before it finished or failed. */
+      for (k = 0; !err && k < task->paths->nelts; ++k)
+        err = status_func(status_baton,
+                          APR_ARRAY_IDX(task->paths, k, const char *),
+                          APR_ARRAY_IDX(task->statuses, k,
+                                        svn_wc_status3_t *),
+                          iterpool);
+
+      err = svn_error_compose_create(err, task_err);
+      svn_pool_destroy(task_pool);
+    }
+
+  /* Stop all workers and wait for them to finish. */
+  svn_atomic_set(&workers->cancelled, TRUE);
+  if (queue)
+    svn_error_clear(svn_task__queue_shutdown(queue));
+  svn_pool_destroy(queue_pool);
+
+  for (i = 0; i < db_pools->nelts; ++i)
+    svn_pool_destroy(APR_ARRAY_IDX(db_pools, i, apr_pool_t *));
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+#endif
+
+
+/* Return a hash mapping the names of the children in NODES, as returned by
+   svn_wc__db_read_children_info(), to dirents that describe them as they
+   were recorded in the working copy.  This is what reading the directory
+   would return if none of its children had been changed on disk.
+
+   Return NULL if NODES contains children that can't be described that
+   way or if CONFLICTS is not empty.  Allocate the result in RESULT_POOL.
+ */
+static apr_hash_t *
+recorded_dirents(apr_hash_t *nodes,
+                 apr_hash_t *conflicts,
+                 apr_pool_t *result_pool)
+{
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+
+  if (apr_hash_count(conflicts) > 0)
+    return NULL;
+
+  dirents = apr_hash_make(result_pool);
+  for (hi = apr_hash_first(result_pool, nodes); hi; hi = apr_hash_next(hi))
+    {
+      const struct svn_wc__db_info_t *info = apr_hash_this_val(hi);
+      svn_io_dirent2_t *dirent;
+
+      switch (info->status)
+        {
+          case svn_wc__db_status_not_present:
+          case svn_wc__db_status_excluded:
+          case svn_wc__db_status_server_excluded:
+            continue;
+
+          case svn_wc__db_status_normal:
+          case svn_wc__db_status_added:
+            break;
+
+          default:
+            return NULL;
+        }
+
+      dirent = svn_io_dirent2_create(result_pool);
+      if (info->kind == svn_node_dir)
+        {
+          dirent->kind = svn_node_dir;
+        }
+      else if (info->kind == svn_node_file || info->kind == svn_node_symlink)
+        {
+          if (info->has_checksum
+              && (info->recorded_size == SVN_INVALID_FILESIZE
+                  || info->recorded_time == 0))
+            return NULL;
+
+          dirent->kind = svn_node_file;
+          dirent->filesize = info->recorded_size;
+          dirent->mtime = info->recorded_time;
+#ifdef HAVE_SYMLINK
+          dirent->special = info->special;
+#else
+          dirent->special = (info->kind == svn_node_symlink);
+#endif
+        }
+      else
+        return NULL;
+
+      apr_hash_set(dirents, apr_hash_this_key(hi), apr_hash_this_key_len(hi),
+                   dirent);
+    }
+
+  return dirents;
+}
+
 /* Send svn_wc_status3_t * structures for the directory LOCAL_ABSPATH and
    for all its child nodes (according to DEPTH) through STATUS_FUNC /
    STATUS_BATON.
@@ -1245,20 +1704,35 @@ get_dir_status(const struct walk_status_baton *wb,
 
   iterpool = svn_pool_create(scratch_pool);
 
+  SVN_ERR(svn_wc__db_read_children_info(&nodes, &conflicts,
+                                        wb->db, local_abspath,
+                                        !wb->check_working_copy,
+                                        scratch_pool, iterpool));
+
   if (wb->check_working_copy)
     {
-      err = svn_io_get_dirents3(&dirents, local_abspath,
-                                wb->ignore_text_mods /* only_check_type*/,
-                                scratch_pool, iterpool);
-      if (err
-          && (APR_STATUS_IS_ENOENT(err->apr_err)
-              || SVN__APR_STATUS_IS_ENOTDIR(err->apr_err)))
+      dirents = NULL;
+
+      /* Nothing changed on disk?  Then we know what we would read. */
+      if (wb->fsmonitor
+          && svn_wc__fsmonitor_is_clean(wb->fsmonitor, local_abspath))
+        dirents = recorded_dirents(nodes, conflicts, scratch_pool);
+
+      if (!dirents)
         {
-          svn_error_clear(err);
-          dirents = apr_hash_make(scratch_pool);
+          err = svn_io_get_dirents3(&dirents, local_abspath,
+                                    wb->ignore_text_mods /* only_check_type*/,
+                                    scratch_pool, iterpool);
+          if (err
+              && (APR_STATUS_IS_ENOENT(err->apr_err)
+                  || SVN__APR_STATUS_IS_ENOTDIR(err->apr_err)))
+            {
+              svn_error_clear(err);
+              dirents = apr_hash_make(scratch_pool);
+            }
+          else
+            SVN_ERR(err);
         }
-      else
-        SVN_ERR(err);
     }
   else
     dirents = apr_hash_make(scratch_pool);
@@ -1278,11 +1752,6 @@ get_dir_status(const struct walk_status_baton *wb,
   /* Create a hash containing all children.  The source hashes
      don't all map the same types, but only the keys of the result
      hash are subsequently used. */
-  SVN_ERR(svn_wc__db_read_children_info(&nodes, &conflicts,
-                                        wb->db, local_abspath,
-                                        !wb->check_working_copy,
-                                        scratch_pool, iterpool));
-
   all_children = apr_hash_overlay(scratch_pool, nodes, dirents);
   if (apr_hash_count(conflicts) > 0)
     all_children = apr_hash_overlay(scratch_pool, conflicts, all_children);
@@ -1340,6 +1809,28 @@ get_dir_status(const struct walk_status_baton *wb,
   sorted_children = svn_sort__hash(all_children,
                                    svn_sort_compare_items_lexically,
                                    scratch_pool);
+
+#if APR_HAS_THREADS
+  /* Walk the subdirectories on multiple threads? */
+  if (wb->threads > 1 && depth == svn_depth_infinity)
+    {
+      SVN_ERR(get_children_status_concurrently(wb, local_abspath,
+                                               sorted_children,
+                                               dirents, nodes, conflicts,
+                                               dir_repos_root_url,
+                                               dir_repos_relpath,
+                                               dir_repos_uuid,
+                                               ignore_patterns,
+                                               get_all, no_ignore,
+                                               status_func, status_baton,
+                                               cancel_func, cancel_baton,
+                                               iterpool));
+      svn_pool_destroy(iterpool);
+
+      return SVN_NO_ERROR;
+    }
+#endif
+
   for (i = 0; i < sorted_children->nelts; i++)
     {
       const void *key;
@@ -2513,6 +3004,8 @@ svn_wc__get_status_editor(const svn_delta_editor_t **editor,
   eb->wb.check_working_copy = check_working_copy;
   eb->wb.repos_locks      = NULL;
   eb->wb.repos_root       = NULL;
+  eb->wb.threads          = 1; /* The editor drives the walk. */
+  eb->wb.fsmonitor        = NULL;
 
   SVN_ERR(svn_wc__db_externals_defined_below(&eb->wb.externals,
                                              wc_ctx->db, eb->target_abspath,
@@ -2644,6 +3137,8 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
   wb.check_working_copy = TRUE;
   wb.repos_root = NULL;
   wb.repos_locks = NULL;
+  wb.threads = svn_wc__db_get_threads(db);
+  wb.fsmonitor = NULL;
 
   /* Use the caller-provided ignore patterns if provided; the build-time
      configured defaults otherwise. */
@@ -2690,6 +3185,21 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
       && info->status != svn_wc__db_status_excluded
       && info->status != svn_wc__db_status_server_excluded)
     {
+      /* Worker threads cannot fix up timestamps in locked working copies
+         like the calling thread does, so stay on that thread then. */
+      if (wb.threads > 1)
+        {
+          svn_boolean_t own_lock;
+
+          SVN_ERR(svn_wc__db_wclock_owns_lock(&own_lock, db, local_abspath,
+                                              FALSE, scratch_pool));
+          if (own_lock)
+            wb.threads = 1;
+        }
+
+      SVN_ERR(svn_wc__fsmonitor_open(&wb.fsmonitor, db, local_abspath,
+                                     scratch_pool, scratch_pool));
+
       SVN_ERR(get_dir_status(&wb,
                              local_abspath,
                              FALSE /* skip_root */,
@@ -2703,6 +3213,15 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
                              status_func, status_baton,
                              cancel_func, cancel_baton,
                              scratch_pool));
+
+      /* Having looked at every node of the working copy, we know which
+         ones are not normal. */
+      if (wb.fsmonitor
+          && (depth == svn_depth_infinity || depth == svn_depth_unknown)
+          && !ignore_text_mods
+          && !strcmp(local_abspath,
+                     svn_wc__fsmonitor_get_wcroot(wb.fsmonitor)))
+        SVN_ERR(svn_wc__fsmonitor_save_baseline(wb.fsmonitor, scratch_pool));
     }
   else
     {
@@ -0,0 +1,423 @@
+/*
+ * textbase.c :  access to the pristine texts of working files
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_props.h"
+
+#include "wc.h"
+#include "textbase.h"
+#include "translate.h"
+
+#include "svn_private_config.h"
+
+
+/* Set *USABLE to TRUE if LOCAL_ABSPATH in DB is a working file whose
+   repository normal form is the pristine text with SHA-1 checksum
+   CHECKSUM, else to FALSE. */
+static svn_error_t *
+working_file_is_textbase(svn_boolean_t *usable,
+                         svn_wc__db_t *db,
+                         const char *local_abspath,
+                         const svn_checksum_t *checksum,
+                         apr_pool_t *scratch_pool)
+{
+  svn_wc__db_status_t status;
+  svn_node_kind_t kind;
+  const svn_checksum_t *working_checksum;
+  svn_node_kind_t kind_on_disk;
+  svn_boolean_t modified;
+
+  *usable = FALSE;
+
+  SVN_ERR(svn_wc__db_read_info(&status, &kind, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, &working_checksum, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL,
+                               db, local_abspath,
+                               scratch_pool, scratch_pool));
+
+  if (kind != svn_node_file
+      || (status != svn_wc__db_status_normal
+          && status != svn_wc__db_status_added)
+      || !working_checksum
+      || !svn_checksum_match(working_checksum, checksum))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_check_path(local_abspath, &kind_on_disk, scratch_pool));
+  if (kind_on_disk != svn_node_file)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, db, local_abspath,
+                                           FALSE, scratch_pool));
+  *usable = !modified;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__textbase_get_contents(svn_stream_t **contents,
+                              svn_wc__db_t *db,
+                              const char *local_abspath,
+                              const svn_checksum_t *checksum,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+  svn_boolean_t usable;
+
+  err = svn_wc__db_pristine_read(contents, NULL, db, local_abspath, checksum,
+                                 result_pool, scratch_pool);
+  if (!err || err->apr_err != SVN_ERR_WC_PRISTINE_DEHYDRATED)
+    return svn_error_trace(err);
+
+  SVN_ERR(svn_error_compose_create(
+            err,
+            working_file_is_textbase(&usable, db, local_abspath, checksum,
+                                     scratch_pool)));
+  if (!usable)
+    return svn_error_trace(err);
+  svn_error_clear(err);
+
+  return svn_error_trace(svn_wc__internal_translated_stream(
+                           contents, db, local_abspath, local_abspath,
+                           SVN_WC_TRANSLATE_TO_NF
+                             | SVN_WC_TRANSLATE_FORCE_EOL_REPAIR,
+                           result_pool, scratch_pool));
+}
+
+svn_error_t *
+svn_wc__textbase_get_path(const char **pristine_abspath,
+                          svn_wc__db_t *db,
+                          const char *local_abspath,
+                          const svn_checksum_t *checksum,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+  svn_boolean_t usable;
+
+  err = svn_wc__db_pristine_get_path(pristine_abspath, db, local_abspath,
+                                     checksum, result_pool, scratch_pool);
+  if (!err || err->apr_err != SVN_ERR_WC_PRISTINE_DEHYDRATED)
+    return svn_error_trace(err);
+
+  SVN_ERR(svn_error_compose_create(
+            err,
+            working_file_is_textbase(&usable, db, local_abspath, checksum,
+                                     scratch_pool)));
+  if (!usable)
+    return svn_error_trace(err);
+  svn_error_clear(err);
+
+  return svn_error_trace(svn_wc__internal_translated_file(
+                           pristine_abspath, local_abspath, db, local_abspath,
+                           SVN_WC_TRANSLATE_TO_NF
+                             | SVN_WC_TRANSLATE_FORCE_EOL_REPAIR,
+                           NULL, NULL, result_pool, scratch_pool));
+}
+
+svn_error_t *
+svn_wc__textbase_store_working(svn_wc__db_t *db,
+                               const char *local_abspath,
+                               const svn_checksum_t *checksum,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *scratch_pool)
+{
+  svn_boolean_t store_pristine;
+  svn_boolean_t present;
+  svn_boolean_t usable;
+  svn_stream_t *contents;
+  svn_stream_t *install_stream;
+  svn_wc__db_install_data_t *install_data;
+  svn_checksum_t *sha1_checksum;
+  svn_checksum_t *md5_checksum;
+  svn_error_t *err;
+
+  SVN_ERR(svn_wc__db_get_store_pristine(&store_pristine, db, local_abspath,
+                                        scratch_pool));
+  if (store_pristine || !checksum)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_wc__db_pristine_check(&present, db, local_abspath, checksum,
+                                    scratch_pool));
+  if (present)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(working_file_is_textbase(&usable, db, local_abspath, checksum,
+                                   scratch_pool));
+  if (!usable)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_wc__internal_translated_stream(
+            &contents, db, local_abspath, local_abspath,
+            SVN_WC_TRANSLATE_TO_NF | SVN_WC_TRANSLATE_FORCE_EOL_REPAIR,
+            scratch_pool, scratch_pool));
+  SVN_ERR(svn_wc__db_pristine_prepare_install(&install_stream,
+                                              &install_data,
+                                              &sha1_checksum, &md5_checksum,
+                                              db, local_abspath,
+                                              scratch_pool, scratch_pool));
+
+  err = svn_stream_copy3(contents, install_stream, cancel_func, cancel_baton,
+                         scratch_pool);
+
+  /* The file may have changed since we checked it; then there is nothing
+     we can store. */
+  if (err || !svn_checksum_match(sha1_checksum, checksum))
+    return svn_error_compose_create(
+             err,
+             svn_wc__db_pristine_install_abort(install_data, scratch_pool));
+
+  return svn_error_trace(svn_wc__db_pristine_install(install_data,
+                                                     sha1_checksum,
+                                                     md5_checksum,
+                                                     scratch_pool));
+}
+
+
+svn_error_t *
+svn_wc__get_store_pristine(svn_boolean_t *store_pristine,
+                           svn_wc_context_t *wc_ctx,
+                           const char *local_abspath,
+                           apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_wc__db_get_store_pristine(store_pristine,
+                                                       wc_ctx->db,
+                                                       local_abspath,
+                                                       scratch_pool));
+}
+
+/* Set *NEEDED to TRUE if the pristine text described by TEXTBASE may be
+   needed by an operation and cannot be derived from the working file. */
+static svn_error_t *
+textbase_is_needed(svn_boolean_t *needed,
+                   svn_wc__db_t *db,
+                   const svn_wc__db_textbase_t *textbase,
+                   apr_pool_t *scratch_pool)
+{
+  svn_boolean_t usable;
+
+  if (!textbase->in_working_tree)
+    {
+      /* Needed to revert a delete or replacement, or to commit one. */
+      *needed = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(working_file_is_textbase(&usable, db, textbase->local_abspath,
+                                   textbase->checksum, scratch_pool));
+  *needed = !usable;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *MODIFIED to TRUE if LOCAL_ABSPATH in DB has local changes of the
+   properties that define the translation of its working file. */
+static svn_error_t *
+translation_props_modified(svn_boolean_t *modified,
+                           svn_wc__db_t *db,
+                           const char *local_abspath,
+                           apr_pool_t *scratch_pool)
+{
+  static const char *const translation_props[] =
+    { SVN_PROP_EOL_STYLE, SVN_PROP_KEYWORDS, SVN_PROP_SPECIAL, NULL };
+  svn_boolean_t props_mod;
+  apr_hash_t *actual_props;
+  apr_hash_t *pristine_props;
+  int i;
+
+  *modified = FALSE;
+
+  SVN_ERR(svn_wc__db_read_info(NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, &props_mod, NULL, NULL, NULL,
+                               db, local_abspath,
+                               scratch_pool, scratch_pool));
+  if (!props_mod)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_wc__db_read_props(&actual_props, db, local_abspath,
+                                scratch_pool, scratch_pool));
+  SVN_ERR(svn_wc__db_read_pristine_props(&pristine_props, db, local_abspath,
+                                         scratch_pool, scratch_pool));
+
+  for (i = 0; translation_props[i]; i++)
+    {
+      const svn_string_t *actual = actual_props
+        ? svn_hash_gets(actual_props, translation_props[i]) : NULL;
+      const svn_string_t *pristine = pristine_props
+        ? svn_hash_gets(pristine_props, translation_props[i]) : NULL;
+
+      if (!actual != !pristine
+          || (actual && !svn_string_compare(actual, pristine)))
+        {
+          *modified = TRUE;
+          break;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Fetch the pristine text described by TEXTBASE with FETCH_FUNC and
+   FETCH_BATON and install it in the pristine store of DB. */
+static svn_error_t *
+hydrate_textbase(svn_wc__db_t *db,
+                 const svn_wc__db_textbase_t *textbase,
+                 svn_wc__textbase_fetch_t fetch_func,
+                 void *fetch_baton,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
+{
+  svn_stream_t *install_stream;
+  svn_wc__db_install_data_t *install_data;
+  svn_checksum_t *sha1_checksum;
+  svn_checksum_t *md5_checksum;
+  svn_error_t *err;
+
+  SVN_ERR(svn_wc__db_pristine_prepare_install(&install_stream,
+                                              &install_data,
+                                              &sha1_checksum, &md5_checksum,
+                                              db, textbase->local_abspath,
+                                              scratch_pool, scratch_pool));
+
+  err = fetch_func(fetch_baton, textbase->repos_root_url,
+                   textbase->repos_relpath, textbase->revision,
+                   install_stream, cancel_func, cancel_baton, scratch_pool);
+
+  if (!err && !svn_checksum_match(sha1_checksum, textbase->checksum))
+    err = svn_checksum_mismatch_err(
+            textbase->checksum, sha1_checksum, scratch_pool,
+            _("Checksum mismatch while fetching the pristine text of '%s'"),
+            svn_dirent_local_style(textbase->local_abspath, scratch_pool));
+
+  if (err)
+    return svn_error_compose_create(
+             err,
+             svn_wc__db_pristine_install_abort(install_data, scratch_pool));
+
+  return svn_error_trace(svn_wc__db_pristine_install(install_data,
+                                                     sha1_checksum,
+                                                     md5_checksum,
+                                                     scratch_pool));
+}
+
+svn_error_t *
+svn_wc__textbase_sync(svn_wc_context_t *wc_ctx,
+                      const char *local_abspath,
+                      svn_boolean_t allow_hydrate,
+                      svn_boolean_t allow_dehydrate,
+                      svn_wc__textbase_fetch_t fetch_func,
+                      void *fetch_baton,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *scratch_pool)
+{
+  svn_wc__db_t *db = wc_ctx->db;
+  svn_boolean_t store_pristine;
+  apr_hash_t *needed = NULL;
+
+  SVN_ERR(svn_wc__db_get_store_pristine(&store_pristine, db, local_abspath,
+                                        scratch_pool));
+  if (store_pristine)
+    return SVN_NO_ERROR;
+
+  if (allow_hydrate)
+    {
+      apr_array_header_t *textbases;
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      int i;
+
+      SVN_ERR(svn_wc__db_read_textbases(&textbases, db, local_abspath,
+                                        scratch_pool, iterpool));
+
+      needed = apr_hash_make(scratch_pool);
+      for (i = 0; i < textbases->nelts; i++)
+        {
+          const svn_wc__db_textbase_t *textbase
+            = APR_ARRAY_IDX(textbases, i, const svn_wc__db_textbase_t *);
+          const char *hexdigest;
+          svn_boolean_t present;
+          svn_boolean_t is_needed;
+
+          svn_pool_clear(iterpool);
+
+          if (cancel_func)
+            SVN_ERR(cancel_func(cancel_baton));
+
+          hexdigest = svn_checksum_to_cstring(textbase->checksum,
+                                              scratch_pool);
+          if (svn_hash_gets(needed, hexdigest))
+            continue;
+
+          SVN_ERR(textbase_is_needed(&is_needed, db, textbase, iterpool));
+          if (!is_needed)
+            {
+              svn_boolean_t modified;
+
+              /* Reverting a local change of the translation properties
+                 reinstalls the working file from its pristine text, but
+                 the file still serves as that text right now. */
+              SVN_ERR(translation_props_modified(&modified, db,
+                                                 textbase->local_abspath,
+                                                 iterpool));
+              if (modified)
+                {
+                  SVN_ERR(svn_wc__textbase_store_working(
+                            db, textbase->local_abspath, textbase->checksum,
+                            cancel_func, cancel_baton, iterpool));
+                  svn_hash_sets(needed, hexdigest, hexdigest);
+                }
+              continue;
+            }
+
+          svn_hash_sets(needed, hexdigest, hexdigest);
+
+          SVN_ERR(svn_wc__db_pristine_check(&present, db,
+                                            textbase->local_abspath,
+                                            textbase->checksum, iterpool));
+          if (present || !textbase->repos_root_url)
+            continue;
+
+          SVN_ERR(hydrate_textbase(db, textbase, fetch_func, fetch_baton,
+                                   cancel_func, cancel_baton, iterpool));
+        }
+
+      svn_pool_destroy(iterpool);
+    }
+
+  if (allow_dehydrate)
+    SVN_ERR(svn_wc__db_pristine_trim(db, local_abspath, needed,
+                                     scratch_pool));
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,103 @@
+/*
+ * textbase.h :  access to the pristine texts of working files
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* A working copy that was checked out without a pristine store (see
+   svn_wc__db_get_store_pristine()) keeps the pristine text of a file only
+   while it may need it: when the file is modified, missing, shadowed or
+   deleted, and for a while after it was last used.  The pristine text of
+   an unmodified file is simply the repository normal form of that file.
+
+   The functions in this file read pristine texts like the pristine store
+   does, but fall back to the working file where that is possible.  Code
+   that needs the pristine text of a modified file relies on the client
+   to have fetched it beforehand through svn_wc__textbase_sync().
+ */
+
+#ifndef SVN_WC_TEXTBASE_H
+#define SVN_WC_TEXTBASE_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+#include "svn_io.h"
+#include "svn_checksum.h"
+
+#include "wc_db.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Set *CONTENTS to a readable stream of the pristine text with SHA-1
+   checksum CHECKSUM, which LOCAL_ABSPATH in DB refers to.
+
+   If the pristine store does not have that text, but LOCAL_ABSPATH is an
+   unmodified working file with that pristine text, read the repository
+   normal form of LOCAL_ABSPATH instead.  Otherwise return
+   SVN_ERR_WC_PRISTINE_DEHYDRATED.
+
+   Allocate the stream in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_wc__textbase_get_contents(svn_stream_t **contents,
+                              svn_wc__db_t *db,
+                              const char *local_abspath,
+                              const svn_checksum_t *checksum,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
+/* Like svn_wc__textbase_get_contents(), but set *PRISTINE_ABSPATH to the
+   path of a file with the pristine text.  That may be a temporary file
+   that is removed when RESULT_POOL is cleared, or LOCAL_ABSPATH itself.
+   The file must not be modified. */
+svn_error_t *
+svn_wc__textbase_get_path(const char **pristine_abspath,
+                          svn_wc__db_t *db,
+                          const char *local_abspath,
+                          const svn_checksum_t *checksum,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+/* Make sure that the pristine store of DB has the pristine text with
+   SHA-1 checksum CHECKSUM, which LOCAL_ABSPATH refers to, if it can be
+   derived from the working file.  That is, if the store lacks the text
+   and LOCAL_ABSPATH is an unmodified working file with that pristine
+   text, store the repository normal form of LOCAL_ABSPATH.
+
+   Call this before queueing the reinstallation of an unmodified working
+   file from its pristine text while DB still describes the current
+   translation of the file: once its translation properties change, the
+   working file can no longer serve as its own pristine text. */
+svn_error_t *
+svn_wc__textbase_store_working(svn_wc__db_t *db,
+                               const char *local_abspath,
+                               const svn_checksum_t *checksum,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_WC_TEXTBASE_H */
@@ -47,6 +47,7 @@
 #include "adm_files.h"
 #include "conflicts.h"
 #include "translate.h"
+#include "textbase.h"
 #include "workqueue.h"
 
 #include "private/svn_subr_private.h"
@@ -3569,10 +3570,10 @@ lazy_open_source(svn_stream_t **stream,
 {
   struct file_baton *fb = baton;
 
-  SVN_ERR(svn_wc__db_pristine_read(stream, NULL, fb->edit_baton->db,
-                                   fb->local_abspath,
-                                   fb->original_checksum,
-                                   result_pool, scratch_pool));
+  SVN_ERR(svn_wc__textbase_get_contents(stream, fb->edit_baton->db,
+                                        fb->local_abspath,
+                                        fb->original_checksum,
+                                        result_pool, scratch_pool));
 
 
   return SVN_NO_ERROR;
@@ -4164,6 +4165,13 @@ merge_file(svn_skel_t **work_items,
                  to update the recorded size and modification time.
                  (Issue #3842) */
               *install_pristine = TRUE;
+
+              /* Without a pristine store, that copy may be the working
+                 file itself.  Keep it while we still know how to
+                 detranslate the file. */
+              SVN_ERR(svn_wc__textbase_store_working(
+                        eb->db, fb->local_abspath, fb->original_checksum,
+                        eb->cancel_func, eb->cancel_baton, scratch_pool));
             }
         }
     }
@@ -1672,8 +1672,8 @@ svn_wc__upgrade_sdb(int *result_format,
   /* ### need lock-out. only one upgrade at a time. note that other code
      ### cannot use this un-upgraded database until we finish the upgrade.  */
 
-  /* Note: none of these have "break" statements; the fall-through is
-     intentional. */
+  /* Note: none of the upgrade steps have "break" statements; the
+     fall-through is intentional. */
   switch (start_format)
     {
       case 29:
@@ -1702,6 +1702,13 @@ svn_wc__upgrade_sdb(int *result_format,
         SVN_SQLITE__WITH_LOCK(
             svn_wc__db_install_schema_statistics(sdb, scratch_pool),
             sdb);
+        break;
+
+      case SVN_WC__HAS_OPTIONAL_PRISTINE:
+        /* Newer than the default format, but understood by this client;
+           there is nothing to upgrade. */
+        *result_format = start_format;
+        break;
     }
 
 #ifdef SVN_DEBUG
@@ -1933,7 +1940,7 @@ svn_wc_upgrade(svn_wc_context_t *wc_ctx,
       /* Auto-upgrade worked! */
       SVN_ERR(svn_wc__db_close(db));
 
-      SVN_ERR_ASSERT(result_format == SVN_WC__VERSION);
+      SVN_ERR_ASSERT(result_format >= SVN_WC__VERSION);
 
       if (bumped_format && notify_func)
         {
@@ -699,9 +699,26 @@ WHERE l.op_depth = 0
 
 
 /* ------------------------------------------------------------------------- */
-/* Format 32 ....  */
-/* -- STMT_UPGRADE_TO_32
-PRAGMA user_version = 32; */
+/* Format 32 adds the SETTINGS table and the PRISTINE.compression column.
+   It is not the result of an upgrade; working copies are only created in
+   this format when they need one of its features. */
+-- STMT_UPGRADE_TO_32
+CREATE TABLE SETTINGS (
+  wc_id  INTEGER NOT NULL PRIMARY KEY REFERENCES WCROOT (id),
+
+  /* 1 if the pristine store keeps the pristine text of every file, 0 if
+     it only caches those that were needed recently.  In the latter case
+     the PRISTINE table still lists all pristine texts, but their files
+     may be missing and must then be fetched from the repository. */
+  store_pristine  INTEGER NOT NULL
+  );
+
+/* How the file of the pristine text is stored: NULL for the plain text,
+   1 for blocks compressed with LZ4 (see svn_stream__compressed_lz4()).
+   The size column always holds the size of the uncompressed text. */
+ALTER TABLE PRISTINE ADD COLUMN compression INTEGER;
+
+PRAGMA user_version = 32;
 
 
 /* ------------------------------------------------------------------------- */
@@ -880,6 +880,9 @@ INSERT INTO work_queue (work) VALUES (?1)
 -- STMT_SELECT_WORK_ITEM
 SELECT id, work FROM work_queue ORDER BY id LIMIT 1
 
+-- STMT_SELECT_WORK_ITEMS
+SELECT id, work FROM work_queue ORDER BY id LIMIT ?1
+
 -- STMT_DELETE_WORK_ITEM
 DELETE FROM work_queue WHERE id = ?1
 
@@ -901,6 +904,15 @@ SELECT size
 FROM pristine
 WHERE checksum = ?1 LIMIT 1
 
+-- STMT_SELECT_PRISTINE_COMPRESSION
+SELECT size, compression
+FROM pristine
+WHERE checksum = ?1 LIMIT 1
+
+-- STMT_UPDATE_PRISTINE_COMPRESSION
+UPDATE pristine SET compression = ?2
+WHERE checksum = ?1
+
 -- STMT_SELECT_PRISTINE_BY_MD5
 SELECT checksum
 FROM pristine
@@ -934,6 +946,27 @@ WHERE wc_id = ?1
       (SELECT MAX(op_depth) FROM nodes WHERE wc_id = ?1 AND local_relpath = ?2)
   AND n.checksum IS NOT NULL
 
+-- STMT_SELECT_PRISTINE_REFCOUNT
+SELECT refcount FROM pristine WHERE checksum = ?1
+
+-- STMT_SELECT_TEXTBASES
+/* Every node at or below ?2 that has a pristine text, noting whether it is
+   the node that is in the working tree and where to get the text from. */
+SELECT local_relpath, presence, checksum, repos_id, repos_path, revision,
+       op_depth = (SELECT MAX(op_depth) FROM nodes w
+                   WHERE w.wc_id = ?1
+                     AND w.local_relpath = n.local_relpath)
+FROM nodes n
+WHERE wc_id = ?1
+  AND (local_relpath = ?2 OR IS_STRICT_DESCENDANT_OF(local_relpath, ?2))
+  AND checksum IS NOT NULL
+
+-- STMT_SELECT_STORE_PRISTINE
+SELECT store_pristine FROM settings WHERE wc_id = ?1
+
+-- STMT_INSERT_SETTINGS
+INSERT INTO settings (wc_id, store_pristine) VALUES (?1, ?2)
+
 -- STMT_VACUUM
 VACUUM
 
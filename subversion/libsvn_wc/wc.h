@@ -161,11 +161,22 @@ extern "C" {
  * == 1.9.x shipped with format 31
  * == 1.10.x shipped with format 31
  *
+ * The bump to 32 added the SETTINGS table, which records whether the
+ *   working copy keeps a pristine copy of every file. Unlike earlier bumps
+ *   this format is only used for working copies that don't, so that older
+ *   clients refuse to work with them; everything else stays at format 31.
+ *   It also added the PRISTINE.compression column, and working copies
+ *   that compress their pristine texts are created in this format too.
+ *
  * Please document any further format changes here.
  */
 
 #define SVN_WC__VERSION 31
 
+/* The newest format this client can work with.  Working copies newer
+   than SVN_WC__VERSION are only created when asked for.  */
+#define SVN_WC__MAX_VERSION 32
+
 
 /* Formats <= this have no concept of "revert text-base/props".  */
 #define SVN_WC__NO_REVERT_FILES 4
@@ -196,6 +207,14 @@ extern "C" {
    sqlite_stat1 table on opening */
 #define SVN_WC__ENSURE_STAT1_TABLE 31
 
+/* A version >= this may not have all pristine texts in its pristine store.
+   See svn_wc__db_get_store_pristine(). */
+#define SVN_WC__HAS_OPTIONAL_PRISTINE 32
+
+/* A version >= this may store pristine texts compressed.  See the
+   compression column of the PRISTINE table. */
+#define SVN_WC__HAS_COMPRESSED_PRISTINE 32
+
 /* Return a string indicating the released version (or versions) of
  * Subversion that used WC format number WC_FORMAT, or some other
  * suitable string if no released version used WC_FORMAT.
@@ -501,7 +520,7 @@ svn_wc__internal_transmit_prop_deltas(svn_wc__db_t *db,
                                      void *baton,
                                      apr_pool_t *scratch_pool);
 
-/* Library-internal version of svn_wc_ensure_adm4(). */
+/* Library-internal version of svn_wc_ensure_adm5(). */
 svn_error_t *
 svn_wc__internal_ensure_adm(svn_wc__db_t *db,
                             const char *local_abspath,
@@ -510,6 +529,7 @@ svn_wc__internal_ensure_adm(svn_wc__db_t *db,
                             const char *repos_uuid,
                             svn_revnum_t revision,
                             svn_depth_t depth,
+                            svn_boolean_t store_pristine,
                             apr_pool_t *scratch_pool);
 
 
@@ -49,6 +49,7 @@
 #include "workqueue.h"
 #include "token-map.h"
 
+#include "private/svn_io_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_sqlite.h"
 #include "private/svn_skel.h"
@@ -413,6 +414,35 @@ lock_from_columns(svn_sqlite__stmt_t *stmt,
   return lock;
 }
 
+/* Return a lock info structure constructed from the given columns of ROW
+   in ROWS, or return NULL if the token column value is null.  */
+static svn_wc__db_lock_t *
+lock_from_rows(const svn_sqlite__rows_t *rows,
+               int row,
+               int col_token,
+               int col_owner,
+               int col_comment,
+               int col_date,
+               apr_pool_t *result_pool)
+{
+  svn_wc__db_lock_t *lock;
+
+  if (svn_sqlite__rows_is_null(rows, row, col_token))
+    return NULL;
+
+  /* apr_pstrdup() passes NULL through. */
+  lock = apr_pcalloc(result_pool, sizeof(svn_wc__db_lock_t));
+  lock->token = apr_pstrdup(result_pool,
+                            svn_sqlite__rows_text(rows, row, col_token));
+  lock->owner = apr_pstrdup(result_pool,
+                            svn_sqlite__rows_text(rows, row, col_owner));
+  lock->comment = apr_pstrdup(result_pool,
+                              svn_sqlite__rows_text(rows, row, col_comment));
+  lock->date = svn_sqlite__rows_int64(rows, row, col_date);
+
+  return lock;
+}
+
 
 svn_error_t *
 svn_wc__db_fetch_repos_info(const char **repos_root_url,
@@ -1365,6 +1395,8 @@ init_db(/* output values */
         const char *root_node_repos_relpath,
         svn_revnum_t root_node_revision,
         svn_depth_t root_node_depth,
+        svn_boolean_t store_pristine,
+        svn_boolean_t compress_pristines,
         apr_pool_t *scratch_pool)
 {
   svn_sqlite__stmt_t *stmt;
@@ -1372,6 +1404,13 @@ init_db(/* output values */
   /* Create the database's schema.  */
   SVN_ERR(svn_sqlite__exec_statements(db, STMT_CREATE_SCHEMA));
 
+  /* Working copies without a pristine store, or with compressed pristine
+     texts, need the newer format, so that older clients refuse to touch
+     them.  Everything else keeps the format that all 1.8+ clients
+     understand. */
+  if (!store_pristine || compress_pristines)
+    SVN_ERR(svn_sqlite__exec_statements(db, STMT_UPGRADE_TO_32));
+
   SVN_ERR(svn_wc__db_install_schema_statistics(db, scratch_pool));
 
   /* Insert the repository. */
@@ -1383,6 +1422,13 @@ init_db(/* output values */
   SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_INSERT_WCROOT));
   SVN_ERR(svn_sqlite__insert(wc_id, stmt));
 
+  if (!store_pristine)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_INSERT_SETTINGS));
+      SVN_ERR(svn_sqlite__bindf(stmt, "id", *wc_id, (int)store_pristine));
+      SVN_ERR(svn_sqlite__insert(NULL, stmt));
+    }
+
   if (root_node_repos_relpath)
     {
       svn_wc__db_status_t status = svn_wc__db_status_normal;
@@ -1418,6 +1464,10 @@ init_db(/* output values */
    If ROOT_NODE_REPOS_RELPATH is not NULL, insert a BASE node at
    the working copy root with repository relpath ROOT_NODE_REPOS_RELPATH,
    revision ROOT_NODE_REVISION and depth ROOT_NODE_DEPTH.
+
+   If STORE_PRISTINE is FALSE, create a working copy that only stores
+   pristine texts while they are needed.  If COMPRESS_PRISTINES is TRUE,
+   create it in a format that allows compressed pristine texts.
    */
 static svn_error_t *
 create_db(svn_sqlite__db_t **sdb,
@@ -1430,6 +1480,8 @@ create_db(svn_sqlite__db_t **sdb,
           const char *root_node_repos_relpath,
           svn_revnum_t root_node_revision,
           svn_depth_t root_node_depth,
+          svn_boolean_t store_pristine,
+          svn_boolean_t compress_pristines,
           svn_boolean_t exclusive,
           apr_int32_t timeout,
           apr_pool_t *result_pool,
@@ -1444,7 +1496,8 @@ create_db(svn_sqlite__db_t **sdb,
   SVN_SQLITE__WITH_LOCK(init_db(repos_id, wc_id,
                                 *sdb, repos_root_url, repos_uuid,
                                 root_node_repos_relpath, root_node_revision,
-                                root_node_depth, scratch_pool),
+                                root_node_depth, store_pristine,
+                                compress_pristines, scratch_pool),
                         *sdb);
 
   return SVN_NO_ERROR;
@@ -1459,6 +1512,7 @@ svn_wc__db_init(svn_wc__db_t *db,
                 const char *repos_uuid,
                 svn_revnum_t initial_rev,
                 svn_depth_t depth,
+                svn_boolean_t store_pristine,
                 apr_pool_t *scratch_pool)
 {
   svn_sqlite__db_t *sdb;
@@ -1486,8 +1540,9 @@ svn_wc__db_init(svn_wc__db_t *db,
   /* Create the SDB and insert the basic rows.  */
   SVN_ERR(create_db(&sdb, &repos_id, &wc_id, local_abspath, repos_root_url,
                     repos_uuid, SDB_FILE,
-                    repos_relpath, initial_rev, depth, sqlite_exclusive,
-                    sqlite_timeout,
+                    repos_relpath, initial_rev, depth, store_pristine,
+                    db->compress_pristines,
+                    sqlite_exclusive, sqlite_timeout,
                     db->state_pool, scratch_pool));
 
   /* Create the WCROOT for this directory.  */
@@ -6057,6 +6112,14 @@ db_record_fileinfo(svn_wc__db_wcroot_t *wcroot,
   svn_sqlite__stmt_t *stmt;
   int affected_rows;
 
+  /* A sub-second timestamp that a modification could still repeat is not
+     worth recording; the file will be compared by its contents instead.
+     That allows svn_io_sleep_for_timestamps() to return right away on
+     such filesystems.  Whole-second timestamps still rely on sleeping. */
+  if (recorded_time % APR_USEC_PER_SEC
+      && svn_io__is_timestamp_racy(recorded_time, apr_time_now()))
+    recorded_time = 0;
+
   SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
                                     STMT_UPDATE_NODE_FILEINFO));
   SVN_ERR(svn_sqlite__bindf(stmt, "isii", wcroot->wc_id, local_relpath,
@@ -9271,6 +9334,11 @@ struct read_children_info_item_t
   svn_boolean_t was_dir;
 };
 
+/* Columns of STMT_SELECT_NODE_CHILDREN_INFO with few distinct values:
+   presence, kind, changed_author and depth. */
+#define CHILDREN_INFO_INTERNED_COLUMNS \
+  ((1 << 3) | (1 << 4) | (1 << 10) | (1 << 11))
+
 /* Implementation of svn_wc__db_read_children_info */
 static svn_error_t *
 read_children_info(svn_wc__db_wcroot_t *wcroot,
@@ -9282,27 +9350,38 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
                    apr_pool_t *scratch_pool)
 {
   svn_sqlite__stmt_t *stmt;
-  svn_boolean_t have_row;
+  svn_sqlite__rows_t *rows;
+  struct read_children_info_item_t *items;
+  apr_hash_t *authors = apr_hash_make(scratch_pool);
+  int nrows;
+  int next_item = 0;
+  int row;
   const char *repos_root_url = NULL;
   const char *repos_uuid = NULL;
   apr_int64_t last_repos_id = INVALID_REPOS_ID;
   const char *last_repos_root_url = NULL;
 
+  /* Fetch all rows at once, so that the queries below don't interleave
+     with stepping this statement and the child items can be allocated
+     in a single block. */
   SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
                                     (base_tree_only
                                      ? STMT_SELECT_BASE_NODE_CHILDREN_INFO
                                      : STMT_SELECT_NODE_CHILDREN_INFO)));
   SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, dir_relpath));
-  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  SVN_ERR(svn_sqlite__fetch_rows(&rows, stmt, CHILDREN_INFO_INTERNED_COLUMNS,
+                                 scratch_pool));
 
-  while (have_row)
+  nrows = svn_sqlite__rows_count(rows);
+  items = apr_pcalloc(result_pool, (nrows ? nrows : 1) * sizeof(*items));
+
+  for (row = 0; row < nrows; row++)
     {
       /* CHILD item points to what we have about the node. We only provide
          CHILD->item to our caller. */
       struct read_children_info_item_t *child_item;
-      const char *child_relpath = svn_sqlite__column_text(stmt, 19, NULL);
+      const char *child_relpath = svn_sqlite__rows_text(rows, row, 19);
       const char *name = svn_relpath_basename(child_relpath, NULL);
-      svn_error_t *err;
       int op_depth;
       svn_boolean_t new_child;
 
@@ -9311,61 +9390,60 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
         new_child = FALSE;
       else
         {
-          child_item = apr_pcalloc(result_pool, sizeof(*child_item));
+          child_item = &items[next_item++];
           new_child = TRUE;
         }
 
-      op_depth = svn_sqlite__column_int(stmt, 0);
+      op_depth = svn_sqlite__rows_int(rows, row, 0);
 
       /* Do we have new or better information? */
       if (new_child)
         {
           struct svn_wc__db_info_t *child = &child_item->info;
+          const char *changed_author;
           child_item->op_depth = op_depth;
 
-          child->kind = svn_sqlite__column_token(stmt, 4, kind_map);
+          child->kind = svn_sqlite__rows_token(rows, row, 4, kind_map);
 
-          child->status = svn_sqlite__column_token(stmt, 3, presence_map);
+          child->status = svn_sqlite__rows_token(rows, row, 3, presence_map);
           if (op_depth != 0)
             {
               if (child->status == svn_wc__db_status_incomplete)
                 child->incomplete = TRUE;
-              err = convert_to_working_status(&child->status, child->status);
-              if (err)
-                SVN_ERR(svn_error_compose_create(err, svn_sqlite__reset(stmt)));
+              SVN_ERR(convert_to_working_status(&child->status,
+                                                child->status));
             }
 
           if (op_depth != 0)
             child->revnum = SVN_INVALID_REVNUM;
           else
-            child->revnum = svn_sqlite__column_revnum(stmt, 5);
+            child->revnum = svn_sqlite__rows_revnum(rows, row, 5);
 
-          if (op_depth != 0)
+          if (op_depth != 0 || svn_sqlite__rows_is_null(rows, row, 2))
             child->repos_relpath = NULL;
           else
-            child->repos_relpath = svn_sqlite__column_text(stmt, 2,
-                                                           result_pool);
+            child->repos_relpath = apr_pstrmemdup(
+                                     result_pool,
+                                     svn_sqlite__rows_text(rows, row, 2),
+                                     svn_sqlite__rows_bytes(rows, row, 2));
 
-          if (op_depth != 0 || svn_sqlite__column_is_null(stmt, 1))
+          if (op_depth != 0 || svn_sqlite__rows_is_null(rows, row, 1))
             {
               child->repos_root_url = NULL;
               child->repos_uuid = NULL;
             }
           else
             {
-              apr_int64_t repos_id = svn_sqlite__column_int64(stmt, 1);
+              apr_int64_t repos_id = svn_sqlite__rows_int64(rows, row, 1);
               if (!repos_root_url ||
                   (last_repos_id != INVALID_REPOS_ID &&
                    repos_id != last_repos_id))
                 {
                   last_repos_root_url = repos_root_url;
-                  err = svn_wc__db_fetch_repos_info(&repos_root_url,
-                                                    &repos_uuid,
-                                                    wcroot, repos_id,
-                                                    result_pool);
-                  if (err)
-                    SVN_ERR(svn_error_compose_create(err,
-                                                 svn_sqlite__reset(stmt)));
+                  SVN_ERR(svn_wc__db_fetch_repos_info(&repos_root_url,
+                                                      &repos_uuid,
+                                                      wcroot, repos_id,
+                                                      result_pool));
                 }
 
               if (last_repos_id == INVALID_REPOS_ID)
@@ -9375,25 +9453,38 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
                  single cached value is sufficient. */
               if (repos_id != last_repos_id)
                 {
-                  err= svn_error_createf(
+                  return svn_error_createf(
                          SVN_ERR_WC_DB_ERROR, NULL,
                          _("The node '%s' comes from unexpected repository "
                            "'%s', expected '%s'; if this node is a file "
                            "external using the correct URL in the external "
                            "definition can fix the problem, see issue #4087"),
                          child_relpath, repos_root_url, last_repos_root_url);
-                  return svn_error_compose_create(err, svn_sqlite__reset(stmt));
                 }
               child->repos_root_url = repos_root_url;
               child->repos_uuid = repos_uuid;
             }
 
-          child->changed_rev = svn_sqlite__column_revnum(stmt, 8);
+          child->changed_rev = svn_sqlite__rows_revnum(rows, row, 8);
 
-          child->changed_date = svn_sqlite__column_int64(stmt, 9);
+          child->changed_date = svn_sqlite__rows_int64(rows, row, 9);
 
-          child->changed_author = svn_sqlite__column_text(stmt, 10,
-                                                          result_pool);
+          /* The author column is interned, so only copy each distinct
+             author once. */
+          changed_author = svn_sqlite__rows_text(rows, row, 10);
+          if (changed_author)
+            {
+              const char *author_copy = svn_hash_gets(authors,
+                                                      changed_author);
+
+              if (!author_copy)
+                {
+                  author_copy = apr_pstrdup(result_pool, changed_author);
+                  svn_hash_sets(authors, changed_author, author_copy);
+                }
+              changed_author = author_copy;
+            }
+          child->changed_author = changed_author;
 
           if (child->kind != svn_node_dir)
             child->depth = svn_depth_unknown;
@@ -9401,32 +9492,30 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
             {
               child->has_descendants = TRUE;
               child_item->was_dir = TRUE;
-              child->depth = svn_sqlite__column_token_null(stmt, 11, depth_map,
-                                                           svn_depth_unknown);
+              child->depth = svn_sqlite__rows_token_null(rows, row, 11,
+                                                         depth_map,
+                                                         svn_depth_unknown);
               if (new_child)
-                {
-                  err = is_wclocked(&child->locked, wcroot, child_relpath,
-                                    scratch_pool);
-
-                  if (err)
-                    SVN_ERR(svn_error_compose_create(err,
-                                                     svn_sqlite__reset(stmt)));
-                }
+                SVN_ERR(is_wclocked(&child->locked, wcroot, child_relpath,
+                                    scratch_pool));
             }
 
-          child->recorded_time = svn_sqlite__column_int64(stmt, 13);
-          child->recorded_size = get_recorded_size(stmt, 7);
-          child->has_checksum = !svn_sqlite__column_is_null(stmt, 6);
-          child->copied = op_depth > 0 && !svn_sqlite__column_is_null(stmt, 2);
-          child->had_props = SQLITE_PROPERTIES_AVAILABLE(stmt, 14);
+          child->recorded_time = svn_sqlite__rows_int64(rows, row, 13);
+          if (svn_sqlite__rows_is_null(rows, row, 7))
+            child->recorded_size = SVN_INVALID_FILESIZE;
+          else
+            child->recorded_size = svn_sqlite__rows_int64(rows, row, 7);
+          child->has_checksum = !svn_sqlite__rows_is_null(rows, row, 6);
+          child->copied = (op_depth > 0
+                           && !svn_sqlite__rows_is_null(rows, row, 2));
+          child->had_props = (svn_sqlite__rows_bytes(rows, row, 14) > 2);
 #ifdef HAVE_SYMLINK
           if (child->had_props)
             {
               apr_hash_t *properties;
-              err = svn_sqlite__column_properties(&properties, stmt, 14,
-                                                  scratch_pool, scratch_pool);
-              if (err)
-                SVN_ERR(svn_error_compose_create(err, svn_sqlite__reset(stmt)));
+              SVN_ERR(svn_sqlite__rows_properties(&properties, rows, row, 14,
+                                                  scratch_pool,
+                                                  scratch_pool));
 
               child->special = (child->had_props
                                 && svn_hash_gets(properties, SVN_PROP_SPECIAL));
@@ -9438,21 +9527,21 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
             child->op_root = (op_depth == relpath_depth(child_relpath));
 
           if (op_depth && child->op_root)
-            child_item->info.moved_here = svn_sqlite__column_boolean(stmt, 20);
+            child_item->info.moved_here = svn_sqlite__rows_boolean(rows, row,
+                                                                   20);
 
           if (new_child)
             svn_hash_sets(nodes, apr_pstrdup(result_pool, name), child);
         }
       else if (!child_item->was_dir
-               && svn_sqlite__column_token(stmt, 4, kind_map) == svn_node_dir)
+               && svn_sqlite__rows_token(rows, row, 4, kind_map)
+                    == svn_node_dir)
         {
           child_item->was_dir = TRUE;
 
-          err = find_conflict_descendants(&child_item->info.has_descendants,
-                                          wcroot, child_relpath,
-                                          scratch_pool);
-          if (err)
-            SVN_ERR(svn_error_compose_create(err, svn_sqlite__reset(stmt)));
+          SVN_ERR(find_conflict_descendants(&child_item->info.has_descendants,
+                                            wcroot, child_relpath,
+                                            scratch_pool));
         }
 
       if (op_depth == 0)
@@ -9460,12 +9549,12 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
           child_item->info.have_base = TRUE;
 
           /* Get the lock info, available only at op_depth 0. */
-          child_item->info.lock = lock_from_columns(stmt, 15, 16, 17, 18,
-                                                    result_pool);
+          child_item->info.lock = lock_from_rows(rows, row, 15, 16, 17, 18,
+                                                 result_pool);
 
           /* FILE_EXTERNAL flag only on op_depth 0. */
-          child_item->info.file_external = svn_sqlite__column_boolean(stmt,
-                                                                      22);
+          child_item->info.file_external = svn_sqlite__rows_boolean(rows,
+                                                                    row, 22);
         }
       else
         {
@@ -9479,7 +9568,7 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
              depths and it really depends on the caller what is interesting.
              We provide a simple linked list with the moved_from information */
 
-          moved_to_relpath = svn_sqlite__column_text(stmt, 21, NULL);
+          moved_to_relpath = svn_sqlite__rows_text(rows, row, 21);
           if (moved_to_relpath)
             {
               struct svn_wc__db_moved_to_info_t *moved_to;
@@ -9509,24 +9598,21 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
               *next = moved_to;
             }
         }
-
-      SVN_ERR(svn_sqlite__step(&have_row, stmt));
     }
 
-  SVN_ERR(svn_sqlite__reset(stmt));
-
   if (!base_tree_only)
     {
       SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
                                         STMT_SELECT_ACTUAL_CHILDREN_INFO));
       SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, dir_relpath));
-      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      SVN_ERR(svn_sqlite__fetch_rows(&rows, stmt, 0, scratch_pool));
 
-      while (have_row)
+      nrows = svn_sqlite__rows_count(rows);
+      for (row = 0; row < nrows; row++)
         {
           struct read_children_info_item_t *child_item;
           struct svn_wc__db_info_t *child;
-          const char *child_relpath = svn_sqlite__column_text(stmt, 0, NULL);
+          const char *child_relpath = svn_sqlite__rows_text(rows, row, 0);
           const char *name = svn_relpath_basename(child_relpath, NULL);
 
           child_item = svn_hash_gets(nodes, name);
@@ -9538,34 +9624,29 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
 
           child = &child_item->info;
 
-          child->changelist = svn_sqlite__column_text(stmt, 1, result_pool);
+          child->changelist = apr_pstrdup(result_pool,
+                                          svn_sqlite__rows_text(rows, row, 1));
 
-          child->props_mod = !svn_sqlite__column_is_null(stmt, 2);
+          child->props_mod = !svn_sqlite__rows_is_null(rows, row, 2);
 #ifdef HAVE_SYMLINK
           if (child->props_mod)
             {
-              svn_error_t *err;
               apr_hash_t *properties;
 
-              err = svn_sqlite__column_properties(&properties, stmt, 2,
-                                                  scratch_pool, scratch_pool);
-              if (err)
-                SVN_ERR(svn_error_compose_create(err, svn_sqlite__reset(stmt)));
+              SVN_ERR(svn_sqlite__rows_properties(&properties, rows, row, 2,
+                                                  scratch_pool,
+                                                  scratch_pool));
               child->special = (NULL != svn_hash_gets(properties,
                                                       SVN_PROP_SPECIAL));
             }
 #endif
 
           /* conflict */
-          child->conflicted = !svn_sqlite__column_is_null(stmt, 3);
+          child->conflicted = !svn_sqlite__rows_is_null(rows, row, 3);
 
           if (child->conflicted)
             svn_hash_sets(conflicts, apr_pstrdup(result_pool, name), "");
-
-          SVN_ERR(svn_sqlite__step(&have_row, stmt));
         }
-
-      SVN_ERR(svn_sqlite__reset(stmt));
     }
 
   return SVN_NO_ERROR;
@@ -9971,8 +10052,11 @@ svn_wc__db_read_children_walker_info(const apr_array_header_t **items,
   svn_wc__db_wcroot_t *wcroot;
   const char *dir_relpath;
   svn_sqlite__stmt_t *stmt;
-  svn_boolean_t have_row;
+  svn_sqlite__rows_t *rows;
+  struct svn_wc__db_walker_info_t *children;
   apr_array_header_t *nodes;
+  int nrows;
+  int row;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(dir_abspath));
 
@@ -9981,39 +10065,32 @@ svn_wc__db_read_children_walker_info(const apr_array_header_t **items,
                                              scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
+  /* Interning the presence and kind columns keeps the rows small. */
   SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
                                     STMT_SELECT_NODE_CHILDREN_WALKER_INFO));
   SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, dir_relpath));
-  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  SVN_ERR(svn_sqlite__fetch_rows(&rows, stmt, (1 << 2) | (1 << 3),
+                                 scratch_pool));
 
-  nodes = apr_array_make(result_pool, 16,
-                          sizeof(struct svn_wc__db_walker_info_t *));
-  while (have_row)
+  nrows = svn_sqlite__rows_count(rows);
+  nodes = apr_array_make(result_pool, nrows ? nrows : 1,
+                         sizeof(struct svn_wc__db_walker_info_t *));
+  children = apr_palloc(result_pool, (nrows ? nrows : 1) * sizeof(*children));
+  for (row = 0; row < nrows; row++)
     {
-      struct svn_wc__db_walker_info_t *child;
-      const char *child_relpath = svn_sqlite__column_text(stmt, 0, NULL);
-      const char *name = svn_relpath_basename(child_relpath, result_pool);
-      int op_depth = svn_sqlite__column_int(stmt, 1);
-      svn_error_t *err;
+      struct svn_wc__db_walker_info_t *child = &children[row];
+      const char *child_relpath = svn_sqlite__rows_text(rows, row, 0);
+      int op_depth = svn_sqlite__rows_int(rows, row, 1);
 
-      child = apr_palloc(result_pool, sizeof(*child));
-      child->name = name;
-      child->status = svn_sqlite__column_token(stmt, 2, presence_map);
+      child->name = svn_relpath_basename(child_relpath, result_pool);
+      child->status = svn_sqlite__rows_token(rows, row, 2, presence_map);
       if (op_depth > 0)
-        {
-          err = convert_to_working_status(&child->status, child->status);
-          if (err)
-            SVN_ERR(svn_error_compose_create(err, svn_sqlite__reset(stmt)));
-        }
-      child->kind = svn_sqlite__column_token(stmt, 3, kind_map);
+        SVN_ERR(convert_to_working_status(&child->status, child->status));
+      child->kind = svn_sqlite__rows_token(rows, row, 3, kind_map);
 
       APR_ARRAY_PUSH(nodes, struct svn_wc__db_walker_info_t *) = child;
-
-      SVN_ERR(svn_sqlite__step(&have_row, stmt));
     }
 
-  SVN_ERR(svn_sqlite__reset(stmt));
-
   *items = nodes;
 
   return SVN_NO_ERROR;
@@ -13332,6 +13409,8 @@ svn_wc__db_upgrade_begin(svn_sqlite__db_t **sdb,
                     repos_root_url, repos_uuid,
                     SDB_FILE,
                     NULL, SVN_INVALID_REVNUM, svn_depth_unknown,
+                    TRUE /* store_pristine */,
+                    FALSE /* compress_pristines */,
                     TRUE /* exclusive */,
                     0 /* timeout */,
                     wc_db->state_pool, scratch_pool));
@@ -13564,33 +13643,86 @@ wq_record(svn_wc__db_wcroot_t *wcroot,
   return SVN_NO_ERROR;
 }
 
+/* The body of svn_wc__db_wq_record_and_fetch_batch().
+ */
+static svn_error_t *
+wq_fetch_batch(apr_array_header_t *ids,
+               apr_array_header_t *work_items,
+               svn_wc__db_wcroot_t *wcroot,
+               const apr_array_header_t *completed_ids,
+               apr_hash_t *record_map,
+               int max_items,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  int i;
+
+  for (i = 0; i < completed_ids->nelts; i++)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                        STMT_DELETE_WORK_ITEM));
+      SVN_ERR(svn_sqlite__bind_int64(stmt, 1,
+                                     APR_ARRAY_IDX(completed_ids, i,
+                                                   apr_uint64_t)));
+      SVN_ERR(svn_sqlite__step_done(stmt));
+    }
+
+  if (record_map)
+    SVN_ERR(wq_record(wcroot, record_map, scratch_pool));
+
+  if (max_items == 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_WORK_ITEMS));
+  SVN_ERR(svn_sqlite__bind_int(stmt, 1, max_items));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+
+  while (have_row)
+    {
+      apr_size_t len;
+      const void *val;
+
+      APR_ARRAY_PUSH(ids, apr_uint64_t) = svn_sqlite__column_int64(stmt, 0);
+
+      val = svn_sqlite__column_blob(stmt, 1, &len, result_pool);
+      APR_ARRAY_PUSH(work_items, svn_skel_t *)
+        = svn_skel__parse(val, len, result_pool);
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
 svn_error_t *
-svn_wc__db_wq_record_and_fetch_next(apr_uint64_t *id,
-                                    svn_skel_t **work_item,
-                                    svn_wc__db_t *db,
-                                    const char *wri_abspath,
-                                    apr_uint64_t completed_id,
-                                    apr_hash_t *record_map,
-                                    apr_pool_t *result_pool,
-                                    apr_pool_t *scratch_pool)
+svn_wc__db_wq_record_and_fetch_batch(apr_array_header_t **ids,
+                                     apr_array_header_t **work_items,
+                                     svn_wc__db_t *db,
+                                     const char *wri_abspath,
+                                     const apr_array_header_t *completed_ids,
+                                     apr_hash_t *record_map,
+                                     int max_items,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool)
 {
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
 
-  SVN_ERR_ASSERT(id != NULL);
-  SVN_ERR_ASSERT(work_item != NULL);
   SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
 
   SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
                               wri_abspath, scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
+  *ids = apr_array_make(result_pool, max_items, sizeof(apr_uint64_t));
+  *work_items = apr_array_make(result_pool, max_items, sizeof(svn_skel_t *));
+
   SVN_WC__DB_WITH_TXN(
-    svn_error_compose_create(
-            wq_fetch_next(id, work_item,
-                          wcroot, local_relpath, completed_id,
-                          result_pool, scratch_pool),
-            wq_record(wcroot, record_map, scratch_pool)),
+    wq_fetch_batch(*ids, *work_items, wcroot, completed_ids, record_map,
+                   max_items, result_pool, scratch_pool),
     wcroot);
 
   return SVN_NO_ERROR;
@@ -15624,6 +15756,82 @@ svn_wc__db_get_excluded_subtrees(apr_hash_t **excluded_subtrees,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__db_read_textbases(apr_array_header_t **textbases,
+                          svn_wc__db_t *db,
+                          const char *local_abspath,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  apr_int64_t last_repos_id = INVALID_REPOS_ID;
+  const char *repos_root_url = NULL;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath,
+                                                db, local_abspath,
+                                                scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  *textbases = apr_array_make(result_pool, 0,
+                              sizeof(svn_wc__db_textbase_t *));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_TEXTBASES));
+  SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, local_relpath));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+
+  while (have_row)
+    {
+      svn_wc__db_textbase_t *tb = apr_pcalloc(result_pool, sizeof(*tb));
+      svn_wc__db_status_t presence;
+      svn_error_t *err;
+
+      tb->local_abspath = svn_dirent_join(wcroot->abspath,
+                                          svn_sqlite__column_text(stmt, 0,
+                                                                  NULL),
+                                          result_pool);
+      presence = svn_sqlite__column_token(stmt, 1, presence_map);
+      err = svn_sqlite__column_checksum(&tb->checksum, stmt, 2, result_pool);
+      if (err)
+        return svn_error_compose_create(err, svn_sqlite__reset(stmt));
+
+      if (!svn_sqlite__column_is_null(stmt, 3))
+        {
+          apr_int64_t repos_id = svn_sqlite__column_int64(stmt, 3);
+
+          if (repos_id != last_repos_id)
+            {
+              err = svn_wc__db_fetch_repos_info(&repos_root_url, NULL,
+                                                wcroot, repos_id,
+                                                result_pool);
+              if (err)
+                return svn_error_compose_create(err,
+                                                svn_sqlite__reset(stmt));
+              last_repos_id = repos_id;
+            }
+
+          tb->repos_root_url = repos_root_url;
+          tb->repos_relpath = svn_sqlite__column_text(stmt, 4, result_pool);
+          tb->revision = svn_sqlite__column_revnum(stmt, 5);
+        }
+      else
+        tb->revision = SVN_INVALID_REVNUM;
+
+      tb->in_working_tree = (svn_sqlite__column_boolean(stmt, 6)
+                             && presence == svn_wc__db_status_normal);
+
+      APR_ARRAY_PUSH(*textbases, svn_wc__db_textbase_t *) = tb;
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
 /* Like svn_wc__db_has_db_mods(),
  * but accepts a WCROOT/LOCAL_RELPATH pair.
  * ### This needs a DB as well as a WCROOT/RELPATH pair... */
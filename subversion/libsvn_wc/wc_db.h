@@ -269,6 +269,33 @@ svn_error_t *
 svn_wc__db_close(svn_wc__db_t *db);
 
 
+/* Set *CLONE to a new context with the same configuration as DB, except
+   that all SQLite databases will be opened read-only and without exclusive
+   locking.  *CLONE may only be used for queries, but it may be used by a
+   different thread than DB.
+
+   The context is allocated in RESULT_POOL and will be closed when that
+   pool is cleared.  Temporary allocations will be made in SCRATCH_POOL. */
+svn_error_t *
+svn_wc__db_open_readonly_clone(svn_wc__db_t **clone,
+                               svn_wc__db_t *db,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
+
+/* Return the number of threads that operations on DB may use to read the
+   working copy concurrently, as configured in the [working-copy] section
+   of DB's config.  This is always 1 if DB uses exclusive locking.  */
+int
+svn_wc__db_get_threads(svn_wc__db_t *db);
+
+/* Return the number of threads that operations on DB may use for file
+   system work that does not access DB, like installing working files, as
+   configured in the [working-copy] section of DB's config.  */
+int
+svn_wc__db_get_io_threads(svn_wc__db_t *db);
+
+
 /* Initialize the SDB for LOCAL_ABSPATH, which should be a working copy path.
 
    A REPOSITORY row will be constructed for the repository identified by
@@ -287,6 +314,11 @@ svn_wc__db_close(svn_wc__db_t *db);
    DEPTH is the initial depth of the working copy; it must be a definite
    depth, not svn_depth_unknown.
 
+   If STORE_PRISTINE is FALSE, the working copy will not keep a pristine
+   copy of every file, but only of those it currently needs; the others
+   are fetched from the repository on demand.  Such working copies use
+   format SVN_WC__HAS_OPTIONAL_PRISTINE.
+
    Use SCRATCH_POOL for temporary allocations.
 */
 svn_error_t *
@@ -297,6 +329,7 @@ svn_wc__db_init(svn_wc__db_t *db,
                 const char *repos_uuid,
                 svn_revnum_t initial_rev,
                 svn_depth_t depth,
+                svn_boolean_t store_pristine,
                 apr_pool_t *scratch_pool);
 
 
@@ -905,6 +938,10 @@ svn_wc__db_base_get_lock_tokens_recursive(apr_hash_t **lock_tokens,
    ### This is temporary - callers should not be looking at the file
    directly.
 
+   If the pristine text is stored compressed, the path is that of a
+   decompressed copy outside the working copy, which is removed when
+   RESULT_POOL is cleaned up.
+
    Allocate the path in RESULT_POOL. */
 svn_error_t *
 svn_wc__db_pristine_get_path(const char **pristine_abspath,
@@ -1057,6 +1094,101 @@ svn_wc__db_pristine_check(svn_boolean_t *present,
                           const svn_checksum_t *sha1_checksum,
                           apr_pool_t *scratch_pool);
 
+/* Set *STORE_PRISTINE to TRUE if the working copy of WRI_ABSPATH in DB
+   keeps the pristine text of every file, and to FALSE if it only keeps
+   those it currently needs.
+
+   In the latter case the PRISTINE table still lists every text the working
+   copy refers to, but the file of a text may be missing.  Reading such a
+   text through svn_wc__db_pristine_read() or svn_wc__db_pristine_get_path()
+   fails with SVN_ERR_WC_PRISTINE_DEHYDRATED and installing it again with
+   svn_wc__db_pristine_install() restores the file. */
+svn_error_t *
+svn_wc__db_get_store_pristine(svn_boolean_t *store_pristine,
+                              svn_wc__db_t *db,
+                              const char *wri_abspath,
+                              apr_pool_t *scratch_pool);
+
+/* Set *DISPOSABLE to TRUE if the working copy of WRI_ABSPATH in DB does
+   not keep a pristine store and the pristine text with SHA-1 checksum
+   SHA1_CHECKSUM is used by just a single node and its file has no other
+   hard links, so that the file may be turned into that node's working
+   file.  Otherwise set it to FALSE. */
+svn_error_t *
+svn_wc__db_pristine_is_disposable(svn_boolean_t *disposable,
+                                  svn_wc__db_t *db,
+                                  const char *wri_abspath,
+                                  const svn_checksum_t *sha1_checksum,
+                                  apr_pool_t *scratch_pool);
+
+/* Set *SHARED_ABSPATH to the path of the file with the pristine text
+   SHA1_CHECKSUM in the pristine store that DB shares with other working
+   copies on this host, or to NULL if there is no such store or it does
+   not have that text.  The text is not verified; callers must check it
+   against its checksum.  The file must not be modified.
+
+   Allocate *SHARED_ABSPATH in RESULT_POOL. */
+svn_error_t *
+svn_wc__db_pristine_get_shared_path(const char **shared_abspath,
+                                    svn_wc__db_t *db,
+                                    const svn_checksum_t *sha1_checksum,
+                                    apr_pool_t *result_pool,
+                                    apr_pool_t *scratch_pool);
+
+/* Set *COMPRESSED to TRUE if the file of the pristine text with SHA-1
+   checksum SHA1_CHECKSUM in the working copy of WRI_ABSPATH in DB holds
+   that text in the format of svn_stream__compressed_lz4(), rather than
+   the text itself.  Otherwise, also if the text is unknown, set it to
+   FALSE.  svn_wc__db_pristine_read() decompresses such files itself. */
+svn_error_t *
+svn_wc__db_pristine_is_compressed(svn_boolean_t *compressed,
+                                  svn_wc__db_t *db,
+                                  const char *wri_abspath,
+                                  const svn_checksum_t *sha1_checksum,
+                                  apr_pool_t *scratch_pool);
+
+/* If the working copy of WRI_ABSPATH in DB does not keep a pristine store,
+   remove the least recently used pristine files until the remaining ones
+   fit in the configured pristine cache size.  Never remove the texts
+   whose hex SHA-1 digests are keys of KEEP, which may be NULL.
+
+   Like svn_wc__db_pristine_remove(), do nothing if the work queue is not
+   empty. */
+svn_error_t *
+svn_wc__db_pristine_trim(svn_wc__db_t *db,
+                         const char *wri_abspath,
+                         apr_hash_t *keep,
+                         apr_pool_t *scratch_pool);
+
+/* A pristine text that a node refers to, as returned by
+   svn_wc__db_read_textbases(). */
+typedef struct svn_wc__db_textbase_t
+{
+  /* The node and the SHA-1 checksum of its pristine text. */
+  const char *local_abspath;
+  const svn_checksum_t *checksum;
+
+  /* Where the text can be found in the repository. REPOS_ROOT_URL and
+     REPOS_RELPATH are NULL for texts without a repository location. */
+  const char *repos_root_url;
+  const char *repos_relpath;
+  svn_revnum_t revision;
+
+  /* TRUE if this is the text of the file in the working tree, FALSE if it
+     belongs to a node that is shadowed, deleted or not present. */
+  svn_boolean_t in_working_tree;
+} svn_wc__db_textbase_t;
+
+/* Set *TEXTBASES to an array of svn_wc__db_textbase_t * describing every
+   pristine text that LOCAL_ABSPATH and its descendants in DB refer to, in
+   any layer.  Allocate the result in RESULT_POOL. */
+svn_error_t *
+svn_wc__db_read_textbases(apr_array_header_t **textbases,
+                          svn_wc__db_t *db,
+                          const char *local_abspath,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
 /* @defgroup svn_wc__db_external  External management
    @{ */
 
@@ -3016,17 +3148,26 @@ svn_wc__db_wq_fetch_next(apr_uint64_t *id,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool);
 
-/* Special variant of svn_wc__db_wq_fetch_next(), which in the same transaction
-   also records timestamps and sizes for one or more nodes */
+/* Batch variant of svn_wc__db_wq_fetch_next().  In a single transaction,
+   mark the work items whose ids (apr_uint64_t) are listed in
+   COMPLETED_IDS as completed, record the timestamps and sizes in
+   RECORD_MAP, which may be NULL, and fetch up to MAX_ITEMS of the next
+   work items to be processed.
+
+   Return the ids (apr_uint64_t) of the fetched items in *IDS and the items
+   themselves (svn_skel_t *) in *WORK_ITEMS, both in queue order and both
+   allocated in RESULT_POOL.  MAX_ITEMS may be 0 to only complete and
+   record.  */
 svn_error_t *
-svn_wc__db_wq_record_and_fetch_next(apr_uint64_t *id,
-                                    svn_skel_t **work_item,
-                                    svn_wc__db_t *db,
-                                    const char *wri_abspath,
-                                    apr_uint64_t completed_id,
-                                    apr_hash_t *record_map,
-                                    apr_pool_t *result_pool,
-                                    apr_pool_t *scratch_pool);
+svn_wc__db_wq_record_and_fetch_batch(apr_array_header_t **ids,
+                                     apr_array_header_t **work_items,
+                                     svn_wc__db_t *db,
+                                     const char *wri_abspath,
+                                     const apr_array_header_t *completed_ids,
+                                     apr_hash_t *record_map,
+                                     int max_items,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool);
 
 
 /* @} */
@@ -28,8 +28,10 @@
 #include "svn_pools.h"
 #include "svn_io.h"
 #include "svn_dirent_uri.h"
+#include "svn_hash.h"
 
 #include "private/svn_io_private.h"
+#include "private/svn_sorts_private.h"
 
 #include "wc.h"
 #include "wc_db.h"
@@ -44,34 +46,27 @@
 
 /* Returns in PRISTINE_ABSPATH a new string allocated from RESULT_POOL,
    holding the local absolute path to the file location that is dedicated
-   to hold CHECKSUM's pristine file, relating to the pristine store
-   configured for the working copy indicated by PDH. The returned path
-   does not necessarily currently exist.
+   to hold CHECKSUM's pristine file in the pristine store directory
+   BASE_DIR_ABSPATH.  The returned path does not necessarily currently
+   exist.
 
    Any other allocations are made in SCRATCH_POOL. */
 static svn_error_t *
-get_pristine_fname(const char **pristine_abspath,
-                   const char *wcroot_abspath,
-                   const svn_checksum_t *sha1_checksum,
-                   apr_pool_t *result_pool,
-                   apr_pool_t *scratch_pool)
+get_store_fname(const char **pristine_abspath,
+                const char *base_dir_abspath,
+                const svn_checksum_t *sha1_checksum,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
 {
-  const char *base_dir_abspath;
   const char *hexdigest = svn_checksum_to_cstring(sha1_checksum, scratch_pool);
   char subdir[3];
 
   /* ### code is in transition. make sure we have the proper data.  */
   SVN_ERR_ASSERT(pristine_abspath != NULL);
-  SVN_ERR_ASSERT(svn_dirent_is_absolute(wcroot_abspath));
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(base_dir_abspath));
   SVN_ERR_ASSERT(sha1_checksum != NULL);
   SVN_ERR_ASSERT(sha1_checksum->kind == svn_checksum_sha1);
 
-  base_dir_abspath = svn_dirent_join_many(scratch_pool,
-                                          wcroot_abspath,
-                                          svn_wc_get_adm_dir(scratch_pool),
-                                          PRISTINE_STORAGE_RELPATH,
-                                          SVN_VA_NULL);
-
   /* We should have a valid checksum and (thus) a valid digest. */
   SVN_ERR_ASSERT(hexdigest != NULL);
 
@@ -83,7 +78,7 @@ get_pristine_fname(const char **pristine_abspath,
   hexdigest = apr_pstrcat(scratch_pool, hexdigest, PRISTINE_STORAGE_EXT,
                           SVN_VA_NULL);
 
-  /* The file is located at DIR/.svn/pristine/XX/XXYYZZ...svn-base */
+  /* The file is located at BASE_DIR/XX/XXYYZZ...svn-base */
   *pristine_abspath = svn_dirent_join_many(result_pool,
                                            base_dir_abspath,
                                            subdir,
@@ -92,6 +87,205 @@ get_pristine_fname(const char **pristine_abspath,
   return SVN_NO_ERROR;
 }
 
+/* Like get_store_fname(), but for the pristine store of the working copy
+   at WCROOT_ABSPATH, in WCROOT_ABSPATH/.svn/pristine. */
+static svn_error_t *
+get_pristine_fname(const char **pristine_abspath,
+                   const char *wcroot_abspath,
+                   const svn_checksum_t *sha1_checksum,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wcroot_abspath));
+
+  return svn_error_trace(get_store_fname(
+                           pristine_abspath,
+                           svn_dirent_join_many(
+                             scratch_pool, wcroot_abspath,
+                             svn_wc_get_adm_dir(scratch_pool),
+                             PRISTINE_STORAGE_RELPATH, SVN_VA_NULL),
+                           sha1_checksum, result_pool, scratch_pool));
+}
+
+/* Create a hard link TO_ABSPATH to the file FROM_ABSPATH, creating the
+   parent directory of TO_ABSPATH if needed. */
+static svn_error_t *
+link_pristine_file(const char *from_abspath,
+                   const char *to_abspath,
+                   apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+
+  err = svn_io__file_link(from_abspath, to_abspath, scratch_pool);
+
+  /* Maybe the directory doesn't exist yet? */
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_node_kind_t kind;
+
+      SVN_ERR(svn_error_compose_create(
+                err, svn_io_check_path(from_abspath, &kind, scratch_pool)));
+      if (kind != svn_node_file)
+        return svn_error_trace(err);
+
+      svn_error_clear(err);
+      SVN_ERR(svn_io_make_dir_recursively(svn_dirent_dirname(to_abspath,
+                                                             scratch_pool),
+                                          scratch_pool));
+      err = svn_io__file_link(from_abspath, to_abspath, scratch_pool);
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Put the pristine text in INSTALL_STREAM, whose SHA-1 checksum is
+   SHA1_CHECKSUM and whose size is SIZE, in place at PRISTINE_ABSPATH.
+
+   If SHARED_STORE_ABSPATH is not NULL, it is the directory of the pristine
+   store shared by the working copies on this host.  If that already has
+   the text, link PRISTINE_ABSPATH to its file and discard INSTALL_STREAM;
+   otherwise add the new file to it.  Sharing is just an optimization, so
+   failing to link is not an error.
+
+   Files of the shared store never change and are only removed when no
+   working copy links to them anymore, see shared_pristine_cleanup().  A
+   file that is removed concurrently simply makes linking fail. */
+static svn_error_t *
+put_pristine_file(svn_stream_t *install_stream,
+                  const char *pristine_abspath,
+                  const char *shared_store_abspath,
+                  const svn_checksum_t *sha1_checksum,
+                  svn_filesize_t size,
+                  apr_pool_t *scratch_pool)
+{
+  const char *shared_abspath = NULL;
+  svn_error_t *err;
+
+  if (shared_store_abspath)
+    {
+      apr_finfo_t finfo;
+
+      SVN_ERR(get_store_fname(&shared_abspath, shared_store_abspath,
+                              sha1_checksum, scratch_pool, scratch_pool));
+
+      /* A file of another size can't hold this text. */
+      err = svn_io_stat(&finfo, shared_abspath, APR_FINFO_SIZE,
+                        scratch_pool);
+      if (!err && finfo.size == size)
+        {
+          /* Any file at PRISTINE_ABSPATH is an orphan. */
+          svn_error_clear(svn_io_remove_file2(pristine_abspath, TRUE,
+                                              scratch_pool));
+          err = link_pristine_file(shared_abspath, pristine_abspath,
+                                   scratch_pool);
+          if (!err)
+            return svn_error_trace(svn_stream__install_delete(install_stream,
+                                                              scratch_pool));
+        }
+      svn_error_clear(err);
+    }
+
+  /* Move the file to its target location.  (If it is already there, it is
+   * an orphan file and it doesn't matter if we overwrite it.) */
+  SVN_ERR(svn_stream__install_stream(install_stream, pristine_abspath,
+                                     TRUE, scratch_pool));
+  SVN_ERR(svn_io_set_file_read_only(pristine_abspath, FALSE, scratch_pool));
+
+  /* Offer the text to the other working copies.  Somebody else may have
+     been faster. */
+  if (shared_abspath)
+    svn_error_clear(link_pristine_file(pristine_abspath, shared_abspath,
+                                       scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the error that tells that the pristine text SHA1_CHECKSUM is
+   known to WCROOT, which does not keep a pristine store, but that its
+   file is not present. */
+static svn_error_t *
+dehydrated_error(const svn_checksum_t *sha1_checksum,
+                 apr_pool_t *scratch_pool)
+{
+  return svn_error_createf(SVN_ERR_WC_PRISTINE_DEHYDRATED, NULL,
+                           _("Pristine text '%s' is not available in the "
+                             "working copy"),
+                           svn_checksum_to_cstring_display(sha1_checksum,
+                                                           scratch_pool));
+}
+
+/* Record that the pristine file PRISTINE_ABSPATH of WCROOT was just used,
+   if WCROOT keeps only the pristine texts it needs.  The file's timestamp
+   decides which texts svn_wc__db_pristine_trim() removes first, so this
+   is just a hint and errors are ignored. */
+static void
+touch_pristine(svn_wc__db_wcroot_t *wcroot,
+               const char *pristine_abspath,
+               apr_pool_t *scratch_pool)
+{
+  if (!wcroot->store_pristine)
+    svn_error_clear(svn_io_set_file_affected_time(apr_time_now(),
+                                                  pristine_abspath,
+                                                  scratch_pool));
+}
+
+/* Look up the pristine text SHA1_CHECKSUM in WCROOT.  Set *HAVE_ROW to
+   whether it is known, and if so, set *SIZE to its size in bytes (if SIZE
+   is not NULL) and *COMPRESSED to whether its file is stored compressed
+   (if COMPRESSED is not NULL). */
+static svn_error_t *
+select_pristine_info(svn_boolean_t *have_row,
+                     svn_filesize_t *size,
+                     svn_boolean_t *compressed,
+                     svn_wc__db_wcroot_t *wcroot,
+                     const svn_checksum_t *sha1_checksum,
+                     apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t has_compression
+    = (wcroot->format >= SVN_WC__HAS_COMPRESSED_PRISTINE);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    has_compression
+                                      ? STMT_SELECT_PRISTINE_COMPRESSION
+                                      : STMT_SELECT_PRISTINE_SIZE));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
+  SVN_ERR(svn_sqlite__step(have_row, stmt));
+
+  if (size)
+    *size = *have_row ? svn_sqlite__column_int64(stmt, 0) : 0;
+  if (compressed)
+    *compressed = (*have_row && has_compression
+                   && !svn_sqlite__column_is_null(stmt, 1));
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Set *TEMP_ABSPATH to a new temporary file outside any working copy that
+   holds the decompressed text of the compressed pristine file
+   PRISTINE_ABSPATH.  The file is removed when RESULT_POOL is cleaned up. */
+static svn_error_t *
+decompress_pristine(const char **temp_abspath,
+                    const char *pristine_abspath,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  svn_stream_t *src_stream;
+  svn_stream_t *dst_stream;
+  const char *temp_dir_abspath;
+
+  SVN_ERR(svn_io_temp_dir(&temp_dir_abspath, scratch_pool));
+  SVN_ERR(svn_stream_open_readonly(&src_stream, pristine_abspath,
+                                   scratch_pool, scratch_pool));
+  SVN_ERR(svn_stream_open_unique(&dst_stream, temp_abspath, temp_dir_abspath,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 result_pool, scratch_pool));
+
+  return svn_error_trace(svn_stream_copy3(
+                           svn_stream__compressed_lz4(src_stream,
+                                                      scratch_pool),
+                           dst_stream, NULL, NULL, scratch_pool));
+}
 
 svn_error_t *
 svn_wc__db_pristine_get_path(const char **pristine_abspath,
@@ -104,6 +298,7 @@ svn_wc__db_pristine_get_path(const char **pristine_abspath,
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
   svn_boolean_t present;
+  svn_boolean_t compressed;
 
   SVN_ERR_ASSERT(pristine_abspath != NULL);
   SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
@@ -123,7 +318,9 @@ svn_wc__db_pristine_get_path(const char **pristine_abspath,
 
   SVN_ERR(svn_wc__db_pristine_check(&present, db, wri_abspath, sha1_checksum,
                                     scratch_pool));
-  if (! present)
+  if (! present && ! wcroot->store_pristine)
+    return svn_error_trace(dehydrated_error(sha1_checksum, scratch_pool));
+  else if (! present)
     return svn_error_createf(SVN_ERR_WC_DB_ERROR, NULL,
                              _("The pristine text with checksum '%s' was "
                                "not found"),
@@ -133,6 +330,15 @@ svn_wc__db_pristine_get_path(const char **pristine_abspath,
   SVN_ERR(get_pristine_fname(pristine_abspath, wcroot->abspath,
                              sha1_checksum,
                              result_pool, scratch_pool));
+  touch_pristine(wcroot, *pristine_abspath, scratch_pool);
+
+  /* Callers expect a plain file, so hand out a decompressed copy.  Callers
+     that copy the file into the working copy do so from outside it. */
+  SVN_ERR(select_pristine_info(&present, NULL, &compressed, wcroot,
+                               sha1_checksum, scratch_pool));
+  if (compressed)
+    SVN_ERR(decompress_pristine(pristine_abspath, *pristine_abspath,
+                                result_pool, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -154,7 +360,8 @@ svn_wc__db_pristine_get_future_path(const char **pristine_abspath,
  * identified by SHA1_CHECKSUM and PRISTINE_ABSPATH can be read from the
  * pristine store of WCROOT.  If SIZE is not null, set *SIZE to the size
  * in bytes of that text. If that text is not in the pristine store,
- * return an error.
+ * return an error.  If WCROOT does not keep a pristine store and only
+ * the file of that text is missing, return SVN_ERR_WC_PRISTINE_DEHYDRATED.
  *
  * Even if the pristine text is removed from the store while it is being
  * read, the stream will remain valid and readable until it is closed.
@@ -174,20 +381,13 @@ pristine_read_txn(svn_stream_t **contents,
                   apr_pool_t *result_pool,
                   apr_pool_t *scratch_pool)
 {
-  svn_sqlite__stmt_t *stmt;
   svn_boolean_t have_row;
+  svn_boolean_t compressed;
 
   /* Check that this pristine text is present in the store.  (The presence
    * of the file is not sufficient.) */
-  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
-                                    STMT_SELECT_PRISTINE_SIZE));
-  SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
-  SVN_ERR(svn_sqlite__step(&have_row, stmt));
-
-  if (size)
-    *size = svn_sqlite__column_int64(stmt, 0);
-
-  SVN_ERR(svn_sqlite__reset(stmt));
+  SVN_ERR(select_pristine_info(&have_row, size, &compressed, wcroot,
+                               sha1_checksum, scratch_pool));
   if (! have_row)
     {
       return svn_error_createf(SVN_ERR_WC_PATH_NOT_FOUND, NULL,
@@ -206,9 +406,23 @@ pristine_read_txn(svn_stream_t **contents,
   if (contents)
     {
       apr_file_t *file;
-      SVN_ERR(svn_io_file_open(&file, pristine_abspath, APR_READ,
-                               APR_OS_DEFAULT, result_pool));
+      svn_error_t *err;
+
+      err = svn_io_file_open(&file, pristine_abspath, APR_READ,
+                             APR_OS_DEFAULT, result_pool);
+      if (err && APR_STATUS_IS_ENOENT(err->apr_err)
+          && !wcroot->store_pristine)
+        {
+          svn_error_clear(err);
+          return svn_error_trace(dehydrated_error(sha1_checksum,
+                                                  scratch_pool));
+        }
+      SVN_ERR(err);
+
       *contents = svn_stream_from_aprfile2(file, FALSE, result_pool);
+      if (compressed)
+        *contents = svn_stream__compressed_lz4(*contents, result_pool);
+      touch_pristine(wcroot, pristine_abspath, scratch_pool);
     }
 
   return SVN_NO_ERROR;
@@ -270,7 +484,14 @@ pristine_get_tempdir(svn_wc__db_wcroot_t *wcroot,
 
 /* Install the pristine text described by BATON into the pristine store of
  * SDB.  If it is already stored then just delete the new file
- * BATON->tempfile_abspath.
+ * BATON->tempfile_abspath.  If STORE_PRISTINE is FALSE and the text is
+ * known but its file is missing, put the new file in its place.
+ *
+ * If COMPRESSED is TRUE, the new file holds the text in the format of
+ * svn_stream__compressed_lz4().  SIZE is the size of the text itself.
+ *
+ * If SHARED_STORE_ABSPATH is not NULL, share the file with other working
+ * copies through the pristine store in that directory.
  *
  * This function expects to be executed inside a SQLite txn that has already
  * acquired a 'RESERVED' lock.
@@ -287,41 +508,71 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
                      const svn_checksum_t *sha1_checksum,
                      /* The pristine text's MD-5 checksum. */
                      const svn_checksum_t *md5_checksum,
+                     /* Whether the WC keeps a file for every text. */
+                     svn_boolean_t store_pristine,
+                     /* Whether the new file is compressed. */
+                     svn_boolean_t compressed,
+                     /* The size of the pristine text. */
+                     svn_filesize_t size,
+                     /* The shared pristine store to link to, or NULL. */
+                     const char *shared_store_abspath,
                      apr_pool_t *scratch_pool)
 {
   svn_sqlite__stmt_t *stmt;
   svn_boolean_t have_row;
+#ifdef SVN_DEBUG
+  svn_filesize_t stored_size = 0;
+#endif
 
   /* If this pristine text is already present in the store, just keep it:
    * delete the new one and return. */
-  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SELECT_PRISTINE));
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SELECT_PRISTINE_SIZE));
   SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
   SVN_ERR(svn_sqlite__step(&have_row, stmt));
+#ifdef SVN_DEBUG
+  if (have_row)
+    stored_size = svn_sqlite__column_int64(stmt, 0);
+#endif
   SVN_ERR(svn_sqlite__reset(stmt));
 
+  if (have_row && !store_pristine)
+    {
+      svn_node_kind_t kind;
+
+      SVN_ERR(svn_io_check_path(pristine_abspath, &kind, scratch_pool));
+      if (kind == svn_node_none)
+        {
+          /* Bring the text back into the store.  Working copies without
+             a pristine store always record how the file is stored. */
+          SVN_ERR(put_pristine_file(install_stream, pristine_abspath,
+                                    shared_store_abspath, sha1_checksum,
+                                    size, scratch_pool));
+
+          SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                            STMT_UPDATE_PRISTINE_COMPRESSION));
+          SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum,
+                                            scratch_pool));
+          if (compressed)
+            SVN_ERR(svn_sqlite__bind_int(stmt, 2, 1));
+          return svn_error_trace(svn_sqlite__update(NULL, stmt));
+        }
+    }
+
   if (have_row)
     {
 #ifdef SVN_DEBUG
-      /* Consistency checks.  Verify both files exist and match.
+      /* Consistency checks.  Verify both texts have the same size; the
+       * files themselves may be stored differently.
        * ### We could check much more. */
-      {
-        apr_finfo_t finfo1, finfo2;
-
-        SVN_ERR(svn_stream__install_get_info(&finfo1, install_stream, APR_FINFO_SIZE,
-                                             scratch_pool));
-
-        SVN_ERR(svn_io_stat(&finfo2, pristine_abspath, APR_FINFO_SIZE,
-                            scratch_pool));
-        if (finfo1.size != finfo2.size)
-          {
-            return svn_error_createf(
-              SVN_ERR_WC_CORRUPT_TEXT_BASE, NULL,
-              _("New pristine text '%s' has different size: %s versus %s"),
-              svn_checksum_to_cstring_display(sha1_checksum, scratch_pool),
-              apr_off_t_toa(scratch_pool, finfo1.size),
-              apr_off_t_toa(scratch_pool, finfo2.size));
-          }
-      }
+      if (size != stored_size)
+        {
+          return svn_error_createf(
+            SVN_ERR_WC_CORRUPT_TEXT_BASE, NULL,
+            _("New pristine text '%s' has different size: %s versus %s"),
+            svn_checksum_to_cstring_display(sha1_checksum, scratch_pool),
+            apr_off_t_toa(scratch_pool, size),
+            apr_off_t_toa(scratch_pool, stored_size));
+        }
 #endif
 
       /* Remove the temp file: it's already there */
@@ -329,22 +580,27 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
       return SVN_NO_ERROR;
     }
 
-  /* Move the file to its target location.  (If it is already there, it is
-   * an orphan file and it doesn't matter if we overwrite it.) */
+  /* Put the file in place and record it. */
   {
-    apr_finfo_t finfo;
-    SVN_ERR(svn_stream__install_get_info(&finfo, install_stream,
-                                         APR_FINFO_SIZE, scratch_pool));
-    SVN_ERR(svn_stream__install_stream(install_stream, pristine_abspath,
-                                       TRUE, scratch_pool));
+    SVN_ERR(put_pristine_file(install_stream, pristine_abspath,
+                              shared_store_abspath, sha1_checksum, size,
+                              scratch_pool));
 
     SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_PRISTINE));
     SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
     SVN_ERR(svn_sqlite__bind_checksum(stmt, 2, md5_checksum, scratch_pool));
-    SVN_ERR(svn_sqlite__bind_int64(stmt, 3, finfo.size));
+    SVN_ERR(svn_sqlite__bind_int64(stmt, 3, size));
     SVN_ERR(svn_sqlite__insert(NULL, stmt));
 
-    SVN_ERR(svn_io_set_file_read_only(pristine_abspath, FALSE, scratch_pool));
+    if (compressed)
+      {
+        SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                          STMT_UPDATE_PRISTINE_COMPRESSION));
+        SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum,
+                                          scratch_pool));
+        SVN_ERR(svn_sqlite__bind_int(stmt, 2, 1));
+        SVN_ERR(svn_sqlite__update(NULL, stmt));
+      }
   }
 
   return SVN_NO_ERROR;
@@ -354,8 +610,44 @@ struct svn_wc__db_install_data_t
 {
   svn_wc__db_wcroot_t *wcroot;
   svn_stream_t *inner_stream;
+
+  /* Whether INNER_STREAM receives the compressed text. */
+  svn_boolean_t compressed;
+
+  /* The stream that receives the text: INNER_STREAM or a compressing
+     stream wrapped around it. */
+  svn_stream_t *text_stream;
+
+  /* The number of bytes of the text written so far. */
+  svn_filesize_t size;
+
+  /* The shared pristine store to install the text into as well, or NULL
+     if the text is not shared. */
+  const char *shared_store_abspath;
 };
 
+/* Implements svn_write_fn_t, counting the bytes passed to the stream
+   of an svn_wc__db_install_data_t. */
+static svn_error_t *
+count_install_write(void *baton, const char *data, apr_size_t *len)
+{
+  svn_wc__db_install_data_t *install_data = baton;
+
+  SVN_ERR(svn_stream_write(install_data->text_stream, data, len));
+  install_data->size += *len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t for the counting stream. */
+static svn_error_t *
+count_install_close(void *baton)
+{
+  svn_wc__db_install_data_t *install_data = baton;
+
+  return svn_error_trace(svn_stream_close(install_data->text_stream));
+}
+
 svn_error_t *
 svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
                                     svn_wc__db_install_data_t **install_data,
@@ -387,6 +679,22 @@ svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
             _("Unable to create pristine install stream"));
 
   (*install_data)->inner_stream = *stream;
+  (*install_data)->compressed
+    = (db->compress_pristines
+       && wcroot->format >= SVN_WC__HAS_COMPRESSED_PRISTINE);
+  (*install_data)->text_stream
+    = (*install_data)->compressed
+        ? svn_stream__compressed_lz4(*stream, result_pool)
+        : *stream;
+
+  /* Compressed files would need a shared store of their own. */
+  if (!(*install_data)->compressed)
+    (*install_data)->shared_store_abspath = db->shared_pristine_abspath;
+
+  /* Count the bytes of the text, as the file may be smaller. */
+  *stream = svn_stream_create(*install_data, result_pool);
+  svn_stream_set_write(*stream, count_install_write);
+  svn_stream_set_close(*stream, count_install_close);
 
   if (md5_checksum)
     *stream = svn_stream_checksummed2(*stream, NULL, md5_checksum,
@@ -422,6 +730,9 @@ svn_wc__db_pristine_install(svn_wc__db_install_data_t *install_data,
     pristine_install_txn(wcroot->sdb,
                          install_data->inner_stream, pristine_abspath,
                          sha1_checksum, md5_checksum,
+                         wcroot->store_pristine,
+                         install_data->compressed, install_data->size,
+                         install_data->shared_store_abspath,
                          scratch_pool),
     wcroot->sdb);
 
@@ -514,13 +825,15 @@ svn_wc__db_pristine_get_sha1(const svn_checksum_t **sha1_checksum,
 }
 
 /* Handle the moving of a pristine from SRC_WCROOT to DST_WCROOT. The existing
-   pristine in SRC_WCROOT is described by CHECKSUM, MD5_CHECKSUM and SIZE */
+   pristine in SRC_WCROOT is described by CHECKSUM, MD5_CHECKSUM and SIZE.
+   If COMPRESS is TRUE, store the file compressed in DST_WCROOT. */
 static svn_error_t *
 maybe_transfer_one_pristine(svn_wc__db_wcroot_t *src_wcroot,
                             svn_wc__db_wcroot_t *dst_wcroot,
                             const svn_checksum_t *checksum,
                             const svn_checksum_t *md5_checksum,
                             apr_int64_t size,
+                            svn_boolean_t compress,
                             svn_cancel_func_t cancel_func,
                             void *cancel_baton,
                             apr_pool_t *scratch_pool)
@@ -531,6 +844,8 @@ maybe_transfer_one_pristine(svn_wc__db_wcroot_t *src_wcroot,
   svn_stream_t *dst_stream;
   const char *tmp_abspath;
   const char *src_abspath;
+  svn_boolean_t have_row;
+  svn_boolean_t src_compressed;
   int affected_rows;
   svn_error_t *err;
 
@@ -555,8 +870,36 @@ maybe_transfer_one_pristine(svn_wc__db_wcroot_t *src_wcroot,
   SVN_ERR(get_pristine_fname(&src_abspath, src_wcroot->abspath, checksum,
                              scratch_pool, scratch_pool));
 
-  SVN_ERR(svn_stream_open_readonly(&src_stream, src_abspath,
-                                   scratch_pool, scratch_pool));
+  err = svn_stream_open_readonly(&src_stream, src_abspath,
+                                 scratch_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err)
+      && !src_wcroot->store_pristine)
+    {
+      svn_error_clear(err);
+
+      /* A working copy without a pristine store can do without the file
+         as well, but any other working copy needs the actual text. */
+      if (!dst_wcroot->store_pristine)
+        return svn_error_trace(svn_stream_close(dst_stream));
+      else
+        return svn_error_trace(dehydrated_error(checksum, scratch_pool));
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(select_pristine_info(&have_row, NULL, &src_compressed, src_wcroot,
+                               checksum, scratch_pool));
+  if (src_compressed)
+    src_stream = svn_stream__compressed_lz4(src_stream, scratch_pool);
+  if (compress)
+    {
+      dst_stream = svn_stream__compressed_lz4(dst_stream, scratch_pool);
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, dst_wcroot->sdb,
+                                        STMT_UPDATE_PRISTINE_COMPRESSION));
+      SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, checksum, scratch_pool));
+      SVN_ERR(svn_sqlite__bind_int(stmt, 2, 1));
+      SVN_ERR(svn_sqlite__update(NULL, stmt));
+    }
 
   /* ### Should we verify the SHA1 or MD5 here, or is that too expensive? */
   SVN_ERR(svn_stream_copy3(src_stream, dst_stream,
@@ -603,6 +946,7 @@ static svn_error_t *
 pristine_transfer_txn(svn_wc__db_wcroot_t *src_wcroot,
                        svn_wc__db_wcroot_t *dst_wcroot,
                        const char *src_relpath,
+                       svn_boolean_t compress,
                        svn_cancel_func_t cancel_func,
                        void *cancel_baton,
                        apr_pool_t *scratch_pool)
@@ -633,7 +977,7 @@ pristine_transfer_txn(svn_wc__db_wcroot_t *src_wcroot,
 
       err = maybe_transfer_one_pristine(src_wcroot, dst_wcroot,
                                         checksum, md5_checksum, size,
-                                        cancel_func, cancel_baton,
+                                        compress, cancel_func, cancel_baton,
                                         iterpool);
 
       if (err)
@@ -678,6 +1022,9 @@ svn_wc__db_pristine_transfer(svn_wc__db_t *db,
 
   SVN_WC__DB_WITH_TXN(
     pristine_transfer_txn(src_wcroot, dst_wcroot, src_relpath,
+                          (db->compress_pristines
+                           && dst_wcroot->format
+                                >= SVN_WC__HAS_COMPRESSED_PRISTINE),
                           cancel_func, cancel_baton, scratch_pool),
     dst_wcroot);
 
@@ -717,7 +1064,7 @@ pristine_remove_if_unreferenced_txn(svn_sqlite__db_t *sdb,
        * point it no longer matters.  In a debug build, raise an error, but
        * in a release build, it is more helpful to ignore it and continue. */
 #ifdef SVN_DEBUG
-      svn_boolean_t ignore_enoent = FALSE;
+      svn_boolean_t ignore_enoent = !wcroot->store_pristine;
 #else
       svn_boolean_t ignore_enoent = TRUE;
 #endif
@@ -863,6 +1210,80 @@ pristine_cleanup_wcroot(svn_wc__db_wcroot_t *wcroot,
       svn_error_compose_create(err, svn_sqlite__reset(stmt)));
 }
 
+/* Remove the files of the shared pristine store in SHARED_STORE_ABSPATH
+   that no working copy links to anymore.
+
+   A working copy that links to such a file concurrently either gets its
+   link before the file is removed, in which case it keeps the text, or
+   fails to link and keeps its own copy. */
+static svn_error_t *
+shared_pristine_cleanup(const char *shared_store_abspath,
+                        apr_pool_t *scratch_pool)
+{
+  apr_hash_t *subdirs;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err;
+
+  err = svn_io_get_dirents3(&subdirs, shared_store_abspath, TRUE,
+                            scratch_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  for (hi = apr_hash_first(scratch_pool, subdirs); hi; hi = apr_hash_next(hi))
+    {
+      const char *subdir_abspath;
+      apr_hash_t *dirents;
+      apr_hash_index_t *hi2;
+      const svn_io_dirent2_t *subdir = apr_hash_this_val(hi);
+
+      if (subdir->kind != svn_node_dir)
+        continue;
+
+      svn_pool_clear(iterpool);
+      subdir_abspath = svn_dirent_join(shared_store_abspath,
+                                       apr_hash_this_key(hi), iterpool);
+      SVN_ERR(svn_io_get_dirents3(&dirents, subdir_abspath, TRUE,
+                                  iterpool, iterpool));
+
+      for (hi2 = apr_hash_first(iterpool, dirents); hi2;
+           hi2 = apr_hash_next(hi2))
+        {
+          const char *name = apr_hash_this_key(hi2);
+          const svn_io_dirent2_t *dirent = apr_hash_this_val(hi2);
+          const char *file_abspath;
+          apr_size_t len = strlen(name);
+          apr_finfo_t finfo;
+
+          if (dirent->kind != svn_node_file
+              || len <= sizeof(PRISTINE_STORAGE_EXT) - 1
+              || strcmp(name + len - (sizeof(PRISTINE_STORAGE_EXT) - 1),
+                        PRISTINE_STORAGE_EXT) != 0)
+            continue;
+
+          file_abspath = svn_dirent_join(subdir_abspath, name, iterpool);
+          err = svn_io_stat(&finfo, file_abspath, APR_FINFO_NLINK, iterpool);
+          if (err)
+            {
+              /* Somebody else removed it first. */
+              svn_error_clear(err);
+              continue;
+            }
+
+          if ((finfo.valid & APR_FINFO_NLINK) && finfo.nlink == 1)
+            SVN_ERR(svn_io_remove_file2(file_abspath, TRUE, iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
                             const char *wri_abspath,
@@ -879,6 +1300,10 @@ svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
 
   SVN_ERR(pristine_cleanup_wcroot(wcroot, scratch_pool));
 
+  if (db->shared_pristine_abspath)
+    SVN_ERR(shared_pristine_cleanup(db->shared_pristine_abspath,
+                                    scratch_pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -951,3 +1376,295 @@ svn_wc__db_pristine_check(svn_boolean_t *present,
   *present = have_row;
   return SVN_NO_ERROR;
 }
+
+
+svn_error_t *
+svn_wc__db_get_store_pristine(svn_boolean_t *store_pristine,
+                              svn_wc__db_t *db,
+                              const char *wri_abspath,
+                              apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  *store_pristine = wcroot->store_pristine;
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_wc__db_pristine_is_disposable(svn_boolean_t *disposable,
+                                  svn_wc__db_t *db,
+                                  const char *wri_abspath,
+                                  const svn_checksum_t *sha1_checksum,
+                                  apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+  SVN_ERR_ASSERT(sha1_checksum != NULL);
+  SVN_ERR_ASSERT(sha1_checksum->kind == svn_checksum_sha1);
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  /* A file that may be linked to the shared store must never become a
+     working file. */
+  *disposable = FALSE;
+  if (wcroot->store_pristine || db->shared_pristine_abspath)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_PRISTINE_REFCOUNT));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (have_row)
+    *disposable = (svn_sqlite__column_int64(stmt, 0) == 1);
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  /* The shared store may have been enabled when this file was installed,
+     so ask the file itself.  Moving a file with other links into the
+     working copy would let edits of the working file corrupt them. */
+  if (*disposable)
+    {
+      const char *pristine_abspath;
+      apr_finfo_t finfo;
+      svn_error_t *err;
+
+      SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
+                                 sha1_checksum, scratch_pool, scratch_pool));
+      err = svn_io_stat(&finfo, pristine_abspath, APR_FINFO_NLINK,
+                        scratch_pool);
+
+      /* A missing file was moved into place by an interrupted install. */
+      if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+        svn_error_clear(err);
+      else if (err)
+        return svn_error_trace(err);
+      else if (finfo.nlink > 1)
+        *disposable = FALSE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_pristine_get_shared_path(const char **shared_abspath,
+                                    svn_wc__db_t *db,
+                                    const svn_checksum_t *sha1_checksum,
+                                    apr_pool_t *result_pool,
+                                    apr_pool_t *scratch_pool)
+{
+  svn_node_kind_t kind;
+
+  *shared_abspath = NULL;
+  if (!db->shared_pristine_abspath
+      || sha1_checksum->kind != svn_checksum_sha1)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_store_fname(shared_abspath, db->shared_pristine_abspath,
+                          sha1_checksum, result_pool, scratch_pool));
+  SVN_ERR(svn_io_check_path(*shared_abspath, &kind, scratch_pool));
+  if (kind != svn_node_file)
+    *shared_abspath = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_pristine_is_compressed(svn_boolean_t *compressed,
+                                  svn_wc__db_t *db,
+                                  const char *wri_abspath,
+                                  const svn_checksum_t *sha1_checksum,
+                                  apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_boolean_t have_row;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+  SVN_ERR_ASSERT(sha1_checksum != NULL);
+  SVN_ERR_ASSERT(sha1_checksum->kind == svn_checksum_sha1);
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  return svn_error_trace(select_pristine_info(&have_row, NULL, compressed,
+                                              wcroot, sha1_checksum,
+                                              scratch_pool));
+}
+
+
+/* A file in the pristine store, as seen by pristine_trim_txn(). */
+typedef struct pristine_file_t
+{
+  const char *abspath;
+  svn_filesize_t size;
+  apr_time_t mtime;
+} pristine_file_t;
+
+/* Sort pristine_file_t pointers by ascending mtime.
+   Implements the comparison function of svn_sort__array(). */
+static int
+compare_pristine_mtime(const void *a, const void *b)
+{
+  const pristine_file_t *file_a = *(const pristine_file_t *const *)a;
+  const pristine_file_t *file_b = *(const pristine_file_t *const *)b;
+
+  if (file_a->mtime < file_b->mtime)
+    return -1;
+  else if (file_a->mtime > file_b->mtime)
+    return 1;
+  else
+    return strcmp(file_a->abspath, file_b->abspath);
+}
+
+/* Remove the least recently used pristine files of WCROOT that are not
+ * listed in KEEP until those that remain take at most MAX_SIZE bytes.
+ *
+ * This function expects to be executed inside a SQLite txn that has already
+ * acquired a 'RESERVED' lock.
+ */
+static svn_error_t *
+pristine_trim_txn(svn_wc__db_wcroot_t *wcroot,
+                  apr_hash_t *keep,
+                  apr_int64_t max_size,
+                  apr_pool_t *scratch_pool)
+{
+  const char *store_abspath;
+  apr_hash_t *subdirs;
+  apr_hash_index_t *hi;
+  apr_array_header_t *files;
+  apr_int64_t total_size = 0;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err;
+  int i;
+
+  store_abspath = svn_dirent_join_many(scratch_pool, wcroot->abspath,
+                                       svn_wc_get_adm_dir(scratch_pool),
+                                       PRISTINE_STORAGE_RELPATH,
+                                       SVN_VA_NULL);
+
+  err = svn_io_get_dirents3(&subdirs, store_abspath, TRUE,
+                            scratch_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  files = apr_array_make(scratch_pool, 0, sizeof(pristine_file_t *));
+  for (hi = apr_hash_first(scratch_pool, subdirs); hi; hi = apr_hash_next(hi))
+    {
+      const char *subdir_abspath;
+      apr_hash_t *dirents;
+      apr_hash_index_t *hi2;
+      const svn_io_dirent2_t *subdir = apr_hash_this_val(hi);
+
+      if (subdir->kind != svn_node_dir)
+        continue;
+
+      svn_pool_clear(iterpool);
+      subdir_abspath = svn_dirent_join(store_abspath, apr_hash_this_key(hi),
+                                       iterpool);
+      SVN_ERR(svn_io_get_dirents3(&dirents, subdir_abspath, FALSE,
+                                  iterpool, iterpool));
+
+      for (hi2 = apr_hash_first(iterpool, dirents); hi2;
+           hi2 = apr_hash_next(hi2))
+        {
+          const char *name = apr_hash_this_key(hi2);
+          const svn_io_dirent2_t *dirent = apr_hash_this_val(hi2);
+          apr_size_t len = strlen(name);
+          pristine_file_t *file;
+
+          if (dirent->kind != svn_node_file)
+            continue;
+
+          total_size += dirent->filesize;
+
+          /* Don't ever remove what we were told to keep, or anything that
+             doesn't look like a pristine file. */
+          if (len <= sizeof(PRISTINE_STORAGE_EXT) - 1
+              || strcmp(name + len - (sizeof(PRISTINE_STORAGE_EXT) - 1),
+                        PRISTINE_STORAGE_EXT) != 0
+              || (keep && apr_hash_get(keep, name,
+                                       len - (sizeof(PRISTINE_STORAGE_EXT)
+                                              - 1))))
+            continue;
+
+          file = apr_palloc(scratch_pool, sizeof(*file));
+          file->abspath = svn_dirent_join(subdir_abspath, name,
+                                          scratch_pool);
+          file->size = dirent->filesize;
+          file->mtime = dirent->mtime;
+          APR_ARRAY_PUSH(files, pristine_file_t *) = file;
+        }
+    }
+
+  svn_sort__array(files, compare_pristine_mtime);
+
+  for (i = 0; i < files->nelts && total_size > max_size; i++)
+    {
+      const pristine_file_t *file = APR_ARRAY_IDX(files, i,
+                                                  pristine_file_t *);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_io_remove_file2(file->abspath, TRUE, iterpool));
+      total_size -= file->size;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_pristine_trim(svn_wc__db_t *db,
+                         const char *wri_abspath,
+                         apr_hash_t *keep,
+                         apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  if (wcroot->store_pristine)
+    return SVN_NO_ERROR;
+
+  /* As in svn_wc__db_pristine_remove(), queued work may still need any
+   * of the files. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb, STMT_LOOK_FOR_WORK));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  if (have_row)
+    return SVN_NO_ERROR;
+
+  /* Ensure the SQL txn has at least a 'RESERVED' lock before we start looking
+   * at the disk, to ensure no concurrent pristine install/delete txn. */
+  SVN_SQLITE__WITH_IMMEDIATE_TXN(
+    pristine_trim_txn(wcroot, keep, db->pristine_cache_size, scratch_pool),
+    wcroot->sdb);
+
+  return SVN_NO_ERROR;
+}
@@ -52,6 +52,25 @@ struct svn_wc__db_t {
   /* Busy timeout in ms., 0 for the libsvn_subr default. */
   apr_int32_t timeout;
 
+  /* Open Sqlite databases read-only. */
+  svn_boolean_t read_only;
+
+  /* Number of threads that may read the working copy concurrently. */
+  int threads;
+
+  /* Maximum number of bytes of pristine texts that working copies
+     without a pristine store keep around after they stopped needing
+     them.  */
+  apr_int64_t pristine_cache_size;
+
+  /* Whether to compress new pristine texts in working copies whose format
+     supports that, and to create new working copies in such a format. */
+  svn_boolean_t compress_pristines;
+
+  /* The directory of the pristine store that working copies on this host
+     share by hard linking their pristine files, or NULL. */
+  const char *shared_pristine_abspath;
+
   /* Map a given working copy directory to its relevant data.
      const char *local_abspath -> svn_wc__db_wcroot_t *wcroot  */
   apr_hash_t *dir_data;
@@ -99,6 +118,11 @@ typedef struct svn_wc__db_wcroot_t {
      format has not (yet) been determined, this will be UNKNOWN_FORMAT.  */
   int format;
 
+  /* Whether this working copy keeps a pristine copy of every file.  If
+     FALSE, pristine texts are only stored while they are needed and are
+     otherwise fetched from the repository on demand.  */
+  svn_boolean_t store_pristine;
+
   /* Array of svn_wc__db_wclock_t structures (not pointers!).
      Typically just one or two locks maximum. */
   apr_array_header_t *owned_locks;
@@ -155,7 +179,7 @@ svn_wc__db_verify_no_work(svn_sqlite__db_t *sdb);
 /* Assert that the given WCROOT is usable.
    NOTE: the expression is multiply-evaluated!!  */
 #define VERIFY_USABLE_WCROOT(wcroot)  SVN_ERR_ASSERT(               \
-    (wcroot) != NULL && (wcroot)->format == SVN_WC__VERSION)
+    (wcroot) != NULL && (wcroot)->format >= SVN_WC__VERSION)
 
 /* Check if the WCROOT is usable for light db operations such as path
    calculations */
@@ -232,6 +232,8 @@ svn_wc__db_open(svn_wc__db_t **db,
   (*db)->verify_format = !open_without_upgrade;
   (*db)->enforce_empty_wq = enforce_empty_wq;
   (*db)->dir_data = apr_hash_make(result_pool);
+  (*db)->threads = 1;
+  (*db)->pristine_cache_size = APR_INT64_C(64) * 1024 * 1024;
 
   (*db)->state_pool = result_pool;
 
@@ -241,6 +243,9 @@ svn_wc__db_open(svn_wc__db_t **db,
       svn_error_t *err;
       svn_boolean_t sqlite_exclusive = FALSE;
       apr_int64_t timeout;
+      apr_int64_t threads;
+      apr_int64_t cache_size;
+      const char *shared_store;
 
       err = svn_config_get_bool(config, &sqlite_exclusive,
                                 SVN_CONFIG_SECTION_WORKING_COPY,
@@ -261,12 +266,91 @@ svn_wc__db_open(svn_wc__db_t **db,
         svn_error_clear(err);
       else
         (*db)->timeout = (apr_int32_t)timeout;
+
+      err = svn_config_get_int64(config, &threads,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_WC_THREADS,
+                                 1);
+      if (err || threads < 1 || threads > APR_INT16_MAX)
+        svn_error_clear(err);
+      else
+        (*db)->threads = (int)threads;
+
+      err = svn_config_get_int64(config, &cache_size,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_PRISTINE_CACHE_SIZE,
+                                 64);
+      if (err || cache_size < 0 || cache_size > APR_INT32_MAX)
+        svn_error_clear(err);
+      else
+        (*db)->pristine_cache_size = cache_size * 1024 * 1024;
+
+      err = svn_config_get_bool(config, &(*db)->compress_pristines,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_COMPRESS_PRISTINES,
+                                FALSE);
+      if (err)
+        {
+          svn_error_clear(err);
+          (*db)->compress_pristines = FALSE;
+        }
+
+      svn_config_get(config, &shared_store, SVN_CONFIG_SECTION_WORKING_COPY,
+                     SVN_CONFIG_OPTION_SHARED_PRISTINE_STORE, NULL);
+      if (shared_store && *shared_store)
+        {
+          err = svn_dirent_get_absolute(&(*db)->shared_pristine_abspath,
+                                        svn_dirent_internal_style(
+                                          shared_store, scratch_pool),
+                                        result_pool);
+          if (err)
+            {
+              svn_error_clear(err);
+              (*db)->shared_pristine_abspath = NULL;
+            }
+        }
     }
 
   return SVN_NO_ERROR;
 }
 
 
+svn_error_t *
+svn_wc__db_open_readonly_clone(svn_wc__db_t **clone,
+                               svn_wc__db_t *db,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  SVN_ERR(svn_wc__db_open(clone, db->config, !db->verify_format,
+                          db->enforce_empty_wq, result_pool, scratch_pool));
+
+  (*clone)->read_only = TRUE;
+  (*clone)->exclusive = FALSE;
+  (*clone)->timeout = db->timeout;
+  (*clone)->threads = 1;
+  (*clone)->pristine_cache_size = db->pristine_cache_size;
+  (*clone)->compress_pristines = db->compress_pristines;
+  (*clone)->shared_pristine_abspath = db->shared_pristine_abspath;
+
+  return SVN_NO_ERROR;
+}
+
+
+int
+svn_wc__db_get_threads(svn_wc__db_t *db)
+{
+  /* Other connections would be blocked by an exclusive one. */
+  return db->exclusive ? 1 : db->threads;
+}
+
+
+int
+svn_wc__db_get_io_threads(svn_wc__db_t *db)
+{
+  return db->threads;
+}
+
+
 svn_error_t *
 svn_wc__db_close(svn_wc__db_t *db)
 {
@@ -321,7 +405,7 @@ svn_wc__db_pdh_create_wcroot(svn_wc__db_wcroot_t **wcroot,
     }
 
   /* If this working copy is from a future version, then bail out.  */
-  if (format > SVN_WC__VERSION)
+  if (format > SVN_WC__MAX_VERSION)
     {
       return svn_error_createf(
         SVN_ERR_WC_UNSUPPORTED_FORMAT, NULL,
@@ -372,6 +456,7 @@ svn_wc__db_pdh_create_wcroot(svn_wc__db_wcroot_t **wcroot,
   (*wcroot)->sdb = sdb;
   (*wcroot)->wc_id = wc_id;
   (*wcroot)->format = format;
+  (*wcroot)->store_pristine = TRUE;
   /* 8 concurrent locks is probably more than a typical wc_ng based svn client
      uses. */
   (*wcroot)->owned_locks = apr_array_make(result_pool, 8,
@@ -383,6 +468,24 @@ svn_wc__db_pdh_create_wcroot(svn_wc__db_wcroot_t **wcroot,
   if (sdb != NULL)
     apr_pool_cleanup_register(result_pool, *wcroot, close_wcroot,
                               apr_pool_cleanup_null);
+
+  /* Working copies that may lack a pristine store say so in their
+     SETTINGS table.  */
+  if (sdb != NULL && wc_id != UNKNOWN_WC_ID
+      && format >= SVN_WC__HAS_OPTIONAL_PRISTINE)
+    {
+      svn_sqlite__stmt_t *stmt;
+      svn_boolean_t have_row;
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                        STMT_SELECT_STORE_PRISTINE));
+      SVN_ERR(svn_sqlite__bindf(stmt, "i", wc_id));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      if (have_row)
+        (*wcroot)->store_pristine = svn_sqlite__column_boolean(stmt, 0);
+      SVN_ERR(svn_sqlite__reset(stmt));
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -640,7 +743,9 @@ svn_wc__db_wcroot_parse_local_abspath(svn_wc__db_wcroot_t **wcroot,
              we're caching database handles, it make sense to be as permissive
              as the filesystem allows. */
           err = svn_wc__db_util_open_db(&sdb, local_abspath, SDB_FILE,
-                                        svn_sqlite__mode_readwrite,
+                                        db->read_only
+                                          ? svn_sqlite__mode_readonly
+                                          : svn_sqlite__mode_readwrite,
                                         db->exclusive, db->timeout, NULL,
                                         db->state_pool, scratch_pool);
           if (err == NULL)
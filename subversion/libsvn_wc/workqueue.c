@@ -38,8 +38,10 @@
 #include "conflicts.h"
 #include "translate.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_io_private.h"
 #include "private/svn_skel.h"
+#include "private/svn_task.h"
 
 
 /* Workqueue operation names.  */
@@ -77,13 +79,18 @@ struct work_item_dispatch {
                        apr_pool_t *scratch_pool);
 };
 
-/* Forward definition */
+/* Forward definitions */
 static svn_error_t *
 get_and_record_fileinfo(work_item_baton_t *wqb,
                         const char *local_abspath,
                         svn_boolean_t ignore_enoent,
                         apr_pool_t *scratch_pool);
 
+static void
+record_fileinfo(work_item_baton_t *wqb,
+                const char *local_abspath,
+                const svn_io_dirent2_t *dirent);
+
 /* ------------------------------------------------------------------------ */
 /* OP_REMOVE_BASE  */
 
@@ -445,60 +452,87 @@ svn_wc__wq_build_postupgrade(svn_skel_t **work_item,
 
 /* OP_FILE_INSTALL */
 
-/* Process the OP_FILE_INSTALL work item WORK_ITEM.
- * See svn_wc__wq_build_file_install() which generates this work item.
- * Implements (struct work_item_dispatch).func. */
+/* Everything needed to install a working file, as read from the DB.  This
+   allows installing the file without access to the DB. */
+typedef struct file_install_t
+{
+  /* The working file to install and the pristine or other file to
+     install it from. */
+  const char *local_abspath;
+  const char *source_abspath;
+
+  /* Whether SOURCE_ABSPATH is a pristine file that nothing else needs, so
+     that it can be moved into place instead of being copied. */
+  svn_boolean_t move_source;
+
+  /* Whether SOURCE_ABSPATH is a pristine file that is stored compressed. */
+  svn_boolean_t source_compressed;
+
+  /* Where to create the file before moving it into place. */
+  const char *temp_dir_abspath;
+
+  /* Translation from the repository normal form. */
+  svn_subst_eol_style_t style;
+  const char *eol;
+  apr_hash_t *keywords;
+  svn_boolean_t special;
+
+  /* File flags to set after installing the file. */
+  svn_boolean_t executable;
+  svn_boolean_t read_only;
+
+  /* Timestamp to set on the file or 0 to leave it alone. */
+  apr_time_t affected_time;
+
+  /* Whether the size and timestamp of the file need to be recorded. */
+  svn_boolean_t record_fileinfo;
+} file_install_t;
+
+/* Read everything needed to process the OP_FILE_INSTALL work item
+   WORK_ITEM from DB and return it in *INSTALL, allocated in RESULT_POOL.
+   Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
-run_file_install(work_item_baton_t *wqb,
-                 svn_wc__db_t *db,
-                 const svn_skel_t *work_item,
-                 const char *wri_abspath,
-                 svn_cancel_func_t cancel_func,
-                 void *cancel_baton,
-                 apr_pool_t *scratch_pool)
+prepare_file_install(file_install_t **install,
+                     svn_wc__db_t *db,
+                     const svn_skel_t *work_item,
+                     const char *wri_abspath,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
 {
   const svn_skel_t *arg1 = work_item->children->next;
   const svn_skel_t *arg4 = arg1->next->next->next;
+  file_install_t *fi = apr_pcalloc(result_pool, sizeof(*fi));
   const char *local_relpath;
-  const char *local_abspath;
   svn_boolean_t use_commit_times;
-  svn_boolean_t record_fileinfo;
-  svn_boolean_t special;
-  svn_stream_t *src_stream;
-  svn_subst_eol_style_t style;
-  const char *eol;
-  apr_hash_t *keywords;
-  const char *temp_dir_abspath;
-  svn_stream_t *dst_stream;
   apr_int64_t val;
   const char *wcroot_abspath;
-  const char *source_abspath;
   const svn_checksum_t *checksum;
   apr_hash_t *props;
   apr_time_t changed_date;
 
   local_relpath = apr_pstrmemdup(scratch_pool, arg1->data, arg1->len);
-  SVN_ERR(svn_wc__db_from_relpath(&local_abspath, db, wri_abspath,
-                                  local_relpath, scratch_pool, scratch_pool));
+  SVN_ERR(svn_wc__db_from_relpath(&fi->local_abspath, db, wri_abspath,
+                                  local_relpath, result_pool, scratch_pool));
 
   SVN_ERR(svn_skel__parse_int(&val, arg1->next, scratch_pool));
   use_commit_times = (val != 0);
   SVN_ERR(svn_skel__parse_int(&val, arg1->next->next, scratch_pool));
-  record_fileinfo = (val != 0);
+  fi->record_fileinfo = (val != 0);
 
   SVN_ERR(svn_wc__db_read_node_install_info(&wcroot_abspath,
                                             &checksum, &props,
                                             &changed_date,
-                                            db, local_abspath, wri_abspath,
+                                            db, fi->local_abspath,
+                                            wri_abspath,
                                             scratch_pool, scratch_pool));
 
   if (arg4 != NULL)
     {
       /* Use the provided path for the source.  */
       local_relpath = apr_pstrmemdup(scratch_pool, arg4->data, arg4->len);
-      SVN_ERR(svn_wc__db_from_relpath(&source_abspath, db, wri_abspath,
+      SVN_ERR(svn_wc__db_from_relpath(&fi->source_abspath, db, wri_abspath,
                                       local_relpath,
-                                      scratch_pool, scratch_pool));
+                                      result_pool, scratch_pool));
     }
   else if (! checksum)
     {
@@ -513,27 +547,184 @@ run_file_install(work_item_baton_t *wqb,
                                _("Can't install '%s' from pristine store, "
                                  "because no checksum is recorded for this "
                                  "file"),
-                               svn_dirent_local_style(local_abspath,
+                               svn_dirent_local_style(fi->local_abspath,
                                                       scratch_pool));
     }
   else
     {
-      SVN_ERR(svn_wc__db_pristine_get_future_path(&source_abspath,
+      SVN_ERR(svn_wc__db_pristine_get_future_path(&fi->source_abspath,
                                                   wcroot_abspath,
                                                   checksum,
-                                                  scratch_pool, scratch_pool));
-    }
+                                                  result_pool, scratch_pool));
 
-  SVN_ERR(svn_stream_open_readonly(&src_stream, source_abspath,
-                                   scratch_pool, scratch_pool));
+      /* Working copies without a pristine store don't keep the pristine
+         text of an unmodified file, so there is no need to copy it. */
+      SVN_ERR(svn_wc__db_pristine_is_disposable(&fi->move_source, db,
+                                                wri_abspath, checksum,
+                                                scratch_pool));
+
+      SVN_ERR(svn_wc__db_pristine_is_compressed(&fi->source_compressed, db,
+                                                wri_abspath, checksum,
+                                                scratch_pool));
+      if (fi->source_compressed)
+        fi->move_source = FALSE;
+    }
 
   /* Fetch all the translation bits.  */
-  SVN_ERR(svn_wc__get_translate_info(&style, &eol,
-                                     &keywords,
-                                     &special, db, local_abspath,
+  SVN_ERR(svn_wc__get_translate_info(&fi->style, &fi->eol,
+                                     &fi->keywords,
+                                     &fi->special, db, fi->local_abspath,
                                      props, FALSE,
-                                     scratch_pool, scratch_pool));
-  if (special)
+                                     result_pool, scratch_pool));
+  if (fi->special)
+    {
+      /* No need to set exec or read-only flags on special files.  */
+      fi->move_source = FALSE;
+      *install = fi;
+      return SVN_NO_ERROR;
+    }
+
+  if (svn_subst_translation_required(fi->style, fi->eol, fi->keywords,
+                                     FALSE /* special */,
+                                     TRUE /* force_eol_check */))
+    fi->move_source = FALSE;
+
+  /* Where is the Right Place to put a temp file in this working copy?  */
+  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&fi->temp_dir_abspath,
+                                         db, wcroot_abspath,
+                                         result_pool, scratch_pool));
+
+#ifndef WIN32
+  fi->executable = (props && svn_hash_gets(props, SVN_PROP_EXECUTABLE));
+#endif
+
+  /* Note that this explicitly checks the pristine properties, to make sure
+     that when the lock is locally set (=modification) it is not read only */
+  if (props && svn_hash_gets(props, SVN_PROP_NEEDS_LOCK))
+    {
+      svn_wc__db_status_t status;
+      svn_wc__db_lock_t *lock;
+      SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, &lock, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL,
+                                   db, fi->local_abspath,
+                                   scratch_pool, scratch_pool));
+
+      fi->read_only = (!lock && status != svn_wc__db_status_added);
+    }
+
+  if (use_commit_times)
+    fi->affected_time = changed_date;
+
+  *install = fi;
+  return SVN_NO_ERROR;
+}
+
+/* Tweak the working file described by INSTALL, which was just put in
+   place, according to its properties.  If its size and timestamp need to
+   be recorded, return its dirent in *DIRENT, allocated in RESULT_POOL.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+finish_file_install(const svn_io_dirent2_t **dirent,
+                    const file_install_t *install,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  const char *local_abspath = install->local_abspath;
+
+  if (install->executable)
+    SVN_ERR(svn_io_set_file_executable(local_abspath, TRUE, FALSE,
+                                       scratch_pool));
+
+  if (install->read_only)
+    SVN_ERR(svn_io_set_file_read_only(local_abspath, FALSE, scratch_pool));
+
+  if (install->affected_time)
+    SVN_ERR(svn_io_set_file_affected_time(install->affected_time,
+                                          local_abspath,
+                                          scratch_pool));
+
+  /* ### this should happen before we rename the file into place.  */
+  if (install->record_fileinfo)
+    SVN_ERR(svn_io_stat_dirent2(dirent, local_abspath, FALSE, FALSE,
+                                result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Install the working file described by INSTALL.  If its size and
+   timestamp need to be recorded, return its dirent in *DIRENT, allocated
+   in RESULT_POOL; otherwise set *DIRENT to NULL.  This does not access the
+   DB and may be called concurrently for different files.  Use SCRATCH_POOL
+   for temporary allocations. */
+static svn_error_t *
+perform_file_install(const svn_io_dirent2_t **dirent,
+                     const file_install_t *install,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  const char *local_abspath = install->local_abspath;
+  svn_stream_t *src_stream;
+  svn_stream_t *dst_stream;
+
+  *dirent = NULL;
+
+  if (install->move_source)
+    {
+      svn_error_t *err;
+
+      err = svn_io_file_rename2(install->source_abspath, local_abspath,
+                                FALSE, scratch_pool);
+
+      /* If the source is gone, we already moved it into place but
+         were interrupted before the work item was completed. */
+      if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+        {
+          svn_node_kind_t kind;
+
+          SVN_ERR(svn_io_check_path(install->source_abspath, &kind,
+                                    scratch_pool));
+          if (kind == svn_node_none)
+            {
+              SVN_ERR(svn_io_check_path(local_abspath, &kind, scratch_pool));
+              if (kind != svn_node_file)
+                return svn_error_trace(err);
+              svn_error_clear(err);
+            }
+          else
+            {
+              /* The parent directory of the working file is missing. */
+              svn_error_clear(err);
+              SVN_ERR(svn_io_make_dir_recursively(
+                        svn_dirent_dirname(local_abspath, scratch_pool),
+                        scratch_pool));
+              SVN_ERR(svn_io_file_rename2(install->source_abspath,
+                                          local_abspath, FALSE,
+                                          scratch_pool));
+            }
+        }
+      else
+        SVN_ERR(err);
+
+      /* Pristine files are read-only. */
+      if (!install->read_only)
+        SVN_ERR(svn_io_set_file_read_write(local_abspath, FALSE,
+                                           scratch_pool));
+
+      return svn_error_trace(finish_file_install(dirent, install,
+                                                 result_pool,
+                                                 scratch_pool));
+    }
+
+  SVN_ERR(svn_stream_open_readonly(&src_stream, install->source_abspath,
+                                   scratch_pool, scratch_pool));
+  if (install->source_compressed)
+    src_stream = svn_stream__compressed_lz4(src_stream, scratch_pool);
+
+  if (install->special)
     {
       /* When this stream is closed, the resulting special file will
          atomically be created/moved into place at LOCAL_ABSPATH.  */
@@ -546,33 +737,28 @@ run_file_install(work_item_baton_t *wqb,
                                cancel_func, cancel_baton,
                                scratch_pool));
 
-      /* No need to set exec or read-only flags on special files.  */
-
       /* ### Shouldn't this record a timestamp and size, etc.? */
       return SVN_NO_ERROR;
     }
 
-  if (svn_subst_translation_required(style, eol, keywords,
+  if (svn_subst_translation_required(install->style, install->eol,
+                                     install->keywords,
                                      FALSE /* special */,
                                      TRUE /* force_eol_check */))
     {
       /* Wrap it in a translating (expanding) stream.  */
-      src_stream = svn_subst_stream_translated(src_stream, eol,
+      src_stream = svn_subst_stream_translated(src_stream, install->eol,
                                                TRUE /* repair */,
-                                               keywords,
+                                               install->keywords,
                                                TRUE /* expand */,
                                                scratch_pool);
     }
 
-  /* Where is the Right Place to put a temp file in this working copy?  */
-  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&temp_dir_abspath,
-                                         db, wcroot_abspath,
-                                         scratch_pool, scratch_pool));
-
   /* Translate to a temporary file. We don't want the user seeing a partial
      file, nor let them muck with it while we translate. We may also need to
      get its TRANSLATED_SIZE before the user can monkey it.  */
-  SVN_ERR(svn_stream__create_for_install(&dst_stream, temp_dir_abspath,
+  SVN_ERR(svn_stream__create_for_install(&dst_stream,
+                                         install->temp_dir_abspath,
                                          scratch_pool, scratch_pool));
 
   /* Copy from the source to the dest, translating as we go. This will also
@@ -588,45 +774,32 @@ run_file_install(work_item_baton_t *wqb,
   SVN_ERR(svn_stream__install_stream(dst_stream, local_abspath,
                                      TRUE /* make_parents*/, scratch_pool));
 
-  /* Tweak the on-disk file according to its properties.  */
-#ifndef WIN32
-  if (props && svn_hash_gets(props, SVN_PROP_EXECUTABLE))
-    SVN_ERR(svn_io_set_file_executable(local_abspath, TRUE, FALSE,
-                                       scratch_pool));
-#endif
-
-  /* Note that this explicitly checks the pristine properties, to make sure
-     that when the lock is locally set (=modification) it is not read only */
-  if (props && svn_hash_gets(props, SVN_PROP_NEEDS_LOCK))
-    {
-      svn_wc__db_status_t status;
-      svn_wc__db_lock_t *lock;
-      SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, &lock, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL,
-                                   db, local_abspath,
-                                   scratch_pool, scratch_pool));
+  return svn_error_trace(finish_file_install(dirent, install, result_pool,
+                                             scratch_pool));
+}
 
-      if (!lock && status != svn_wc__db_status_added)
-        SVN_ERR(svn_io_set_file_read_only(local_abspath, FALSE, scratch_pool));
-    }
+/* Process the OP_FILE_INSTALL work item WORK_ITEM.
+ * See svn_wc__wq_build_file_install() which generates this work item.
+ * Implements (struct work_item_dispatch).func. */
+static svn_error_t *
+run_file_install(work_item_baton_t *wqb,
+                 svn_wc__db_t *db,
+                 const svn_skel_t *work_item,
+                 const char *wri_abspath,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
+{
+  file_install_t *install;
+  const svn_io_dirent2_t *dirent;
 
-  if (use_commit_times)
-    {
-      if (changed_date)
-        SVN_ERR(svn_io_set_file_affected_time(changed_date,
-                                              local_abspath,
-                                              scratch_pool));
-    }
+  SVN_ERR(prepare_file_install(&install, db, work_item, wri_abspath,
+                               scratch_pool, scratch_pool));
+  SVN_ERR(perform_file_install(&dirent, install, cancel_func, cancel_baton,
+                               scratch_pool, scratch_pool));
 
-  /* ### this should happen before we rename the file into place.  */
-  if (record_fileinfo)
-    {
-      SVN_ERR(get_and_record_fileinfo(wqb, local_abspath,
-                                      FALSE /* ignore_enoent */,
-                                      scratch_pool));
-    }
+  if (dirent)
+    record_fileinfo(wqb, install->local_abspath, dirent);
 
   return SVN_NO_ERROR;
 }
@@ -1474,98 +1647,387 @@ dispatch_work_item(work_item_baton_t *wqb,
 }
 
 
-svn_error_t *
-svn_wc__wq_run(svn_wc__db_t *db,
-               const char *wri_abspath,
-               svn_cancel_func_t cancel_func,
-               void *cancel_baton,
-               apr_pool_t *scratch_pool)
+/* Wrap ERR, returned by processing the work item WORK_ITEM with ID from
+   the work queue of WRI_ABSPATH. */
+static svn_error_t *
+work_item_error(svn_error_t *err,
+                const char *wri_abspath,
+                apr_uint64_t id,
+                const svn_skel_t *work_item,
+                apr_pool_t *scratch_pool)
 {
-  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
-  apr_uint64_t last_id = 0;
-  work_item_baton_t wib = { 0 };
-  wib.result_pool = svn_pool_create(scratch_pool);
+  const char *skel = svn_skel__unparse(work_item, scratch_pool)->data;
+
+  return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
+                           _("Failed to run the WC DB work queue "
+                             "associated with '%s', work item %d %s"),
+                           svn_dirent_local_style(wri_abspath,
+                                                  scratch_pool),
+                           (int)id, skel);
+}
 
-#ifdef SVN_DEBUG_WORK_QUEUE
-  SVN_DBG(("wq_run: wri='%s'\n", wri_abspath));
-  {
-    static int count = 0;
-    const char *count_env_var = getenv("SVN_DEBUG_WORK_QUEUE");
-    int count_env_val;
+/* Number of work items to fetch and complete per DB transaction. */
+#define WQ_BATCH_SIZE 1000
 
-    SVN_ERR(svn_cstring_atoi(&count_env_val, count_env_var));
+#if APR_HAS_THREADS
 
-    if (count_env_var && ++count == count_env_val)
-      return svn_error_create(SVN_ERR_CANCELLED, NULL, "fake cancel");
-  }
-#endif
+/* State shared by the threads installing files concurrently. */
+typedef struct install_workers_t
+{
+  /* Non-zero if the workers shall stop as soon as possible. */
+  svn_atomic_t cancelled;
+} install_workers_t;
 
-  while (TRUE)
+/* Implements svn_cancel_func_t.  BATON is an install_workers_t *. */
+static svn_error_t *
+check_workers_cancelled(void *baton)
+{
+  install_workers_t *workers = baton;
+
+  if (svn_atomic_read(&workers->cancelled))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  Install the file_install_t TASK
+   and return the dirent to record for it, if any, in *RESULT.
+   PROCESS_BATON is the install_workers_t *. */
+static svn_error_t *
+install_file_task(void **result,
+                  void *task,
+                  void *process_baton,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  const svn_io_dirent2_t *dirent;
+
+  SVN_ERR(perform_file_install(&dirent, task,
+                               check_workers_cancelled, process_baton,
+                               result_pool, scratch_pool));
+  *result = (void *)dirent;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the number of OP_FILE_INSTALL items in WORK_ITEMS, starting at
+   index FIRST, that can be processed independently of each other because
+   none of them installs a file that another one reads or writes. */
+static int
+count_file_installs(const apr_array_header_t *work_items,
+                    int first,
+                    apr_pool_t *scratch_pool)
+{
+  apr_hash_t *paths = apr_hash_make(scratch_pool);
+  int i;
+
+  for (i = first; i < work_items->nelts; i++)
     {
-      apr_uint64_t id;
-      svn_skel_t *work_item;
-      svn_error_t *err;
+      const svn_skel_t *work_item = APR_ARRAY_IDX(work_items, i,
+                                                  const svn_skel_t *);
+      const svn_skel_t *arg1;
+      const svn_skel_t *arg4;
+
+      if (!svn_skel__matches_atom(work_item->children, OP_FILE_INSTALL))
+        break;
+
+      arg1 = work_item->children->next;
+      arg4 = arg1->next->next->next;
+
+      if (apr_hash_get(paths, arg1->data, arg1->len)
+          || (arg4 && apr_hash_get(paths, arg4->data, arg4->len)))
+        break;
+
+      apr_hash_set(paths, arg1->data, arg1->len, arg1);
+      if (arg4)
+        apr_hash_set(paths, arg4->data, arg4->len, arg4);
+    }
+
+  return i - first;
+}
+
+/* Process the COUNT OP_FILE_INSTALL work items in WORK_ITEMS, starting at
+   index FIRST, on THREADS worker threads.  IDS holds the work item ids.
+   Append the ids of the items that completed, in queue order, to
+   COMPLETED_IDS and note their file info in WQB.
+
+   The DB is only accessed from the calling thread. */
+static svn_error_t *
+install_files_concurrently(work_item_baton_t *wqb,
+                           apr_array_header_t *completed_ids,
+                           svn_wc__db_t *db,
+                           const char *wri_abspath,
+                           const apr_array_header_t *ids,
+                           const apr_array_header_t *work_items,
+                           int first,
+                           int count,
+                           int threads,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *queue_pool = svn_pool_create(scratch_pool);
+  install_workers_t workers = { 0 };
+  svn_task__queue_t *queue = NULL;
+  int max_pending = 2 * threads;
+  int pushed = 0;
+  int popped = 0;
+  svn_error_t *err;
+
+  err = svn_task__queue_create(&queue, threads, max_pending,
+                               install_file_task, &workers, queue_pool);
+
+  while (!err && popped < count)
+    {
+      const svn_io_dirent2_t *dirent;
+      file_install_t *install;
+      apr_pool_t *task_pool;
+      svn_error_t *task_err;
 
       svn_pool_clear(iterpool);
 
-      if (! wib.used)
+      /* Keep the workers busy.  Reading the DB is not thread-safe, so
+         prepare the installation right here. */
+      if (pushed < count && svn_task__queue_size(queue) < max_pending)
+        {
+          const svn_skel_t *work_item
+            = APR_ARRAY_IDX(work_items, first + pushed, const svn_skel_t *);
+
+          task_pool = svn_pool_create(NULL);
+          err = prepare_file_install(&install, db, work_item, wri_abspath,
+                                     task_pool, iterpool);
+          if (err)
+            {
+              svn_pool_destroy(task_pool);
+              err = work_item_error(err, wri_abspath,
+                                    APR_ARRAY_IDX(ids, first + pushed,
+                                                  apr_uint64_t),
+                                    work_item, scratch_pool);
+            }
+          else
+            err = svn_task__queue_push(queue, install, task_pool);
+
+          ++pushed;
+          continue;
+        }
+
+      if (cancel_func)
+        err = cancel_func(cancel_baton);
+      if (err)
+        break;
+
+      /* The oldest pending task belongs to the next item in the queue. */
+      task_pool = NULL;
+      task_err = svn_task__queue_pop((void **)&dirent, (void **)&install,
+                                     &task_pool, queue);
+      if (task_err)
         {
-          /* Make sure to do this *early* in the loop iteration. There may
-             be a LAST_ID that needs to be marked as completed, *before* we
-             start worrying about anything else.  */
-          SVN_ERR(svn_wc__db_wq_fetch_next(&id, &work_item, db, wri_abspath,
-                                           last_id, iterpool, iterpool));
+          err = task_pool
+              ? work_item_error(task_err, wri_abspath,
+                                APR_ARRAY_IDX(ids, first + popped,
+                                              apr_uint64_t),
+                                APR_ARRAY_IDX(work_items, first + popped,
+                                              const svn_skel_t *),
+                                scratch_pool)
+              : task_err;
         }
       else
         {
-          /* Make sure to do this *early* in the loop iteration. There may
-             be a LAST_ID that needs to be marked as completed, *before* we
-             start worrying about anything else.  */
-          SVN_ERR(svn_wc__db_wq_record_and_fetch_next(&id, &work_item,
-                                                      db, wri_abspath,
-                                                      last_id, wib.record_map,
-                                                      iterpool,
-                                                      wib.result_pool));
-
-          svn_pool_clear(wib.result_pool);
-          wib.record_map = NULL;
-          wib.used = FALSE;
+          if (dirent)
+            record_fileinfo(wqb, install->local_abspath, dirent);
+
+          APR_ARRAY_PUSH(completed_ids, apr_uint64_t)
+            = APR_ARRAY_IDX(ids, first + popped, apr_uint64_t);
+          ++popped;
         }
 
-      /* Stop work queue processing, if requested. A future 'svn cleanup'
-         should be able to continue the processing. Note that we may
-         have WORK_ITEM, but we'll just skip its processing for now.  */
-      if (cancel_func)
-        SVN_ERR(cancel_func(cancel_baton));
+      if (task_pool)
+        svn_pool_destroy(task_pool);
+    }
+
+  /* Stop all workers and wait for them to finish. */
+  svn_atomic_set(&workers.cancelled, TRUE);
+  if (queue)
+    svn_error_clear(svn_task__queue_shutdown(queue));
+  svn_pool_destroy(queue_pool);
 
-      /* If we have a WORK_ITEM, then process the sucker. Otherwise,
-         we're done.  */
-      if (work_item == NULL)
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+#endif
+
+/* Mark the work items in COMPLETED_IDS as completed and record the file
+   info collected in WQB.  Reset both afterwards. */
+static svn_error_t *
+complete_work_items(work_item_baton_t *wqb,
+                    apr_array_header_t *completed_ids,
+                    svn_wc__db_t *db,
+                    const char *wri_abspath,
+                    apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *ids;
+  apr_array_header_t *work_items;
+
+  SVN_ERR(svn_wc__db_wq_record_and_fetch_batch(&ids, &work_items,
+                                               db, wri_abspath,
+                                               completed_ids,
+                                               wqb->record_map, 0,
+                                               scratch_pool, scratch_pool));
+
+  apr_array_clear(completed_ids);
+  svn_pool_clear(wqb->result_pool);
+  wqb->record_map = NULL;
+  wqb->used = FALSE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_wc__wq_run(), completing work items in batches of up to
+   WQ_BATCH_SIZE per DB transaction.  If THREADS is greater than 1, process
+   runs of consecutive file installs on that many threads. */
+static svn_error_t *
+run_work_queue_batched(svn_wc__db_t *db,
+                       const char *wri_abspath,
+                       int threads,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *scratch_pool)
+{
+  apr_pool_t *batchpool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_array_header_t *completed_ids = apr_array_make(scratch_pool,
+                                                     WQ_BATCH_SIZE,
+                                                     sizeof(apr_uint64_t));
+  work_item_baton_t wib = { 0 };
+  wib.result_pool = svn_pool_create(scratch_pool);
+
+  while (TRUE)
+    {
+      apr_array_header_t *ids;
+      apr_array_header_t *work_items;
+      int i = 0;
+
+      svn_pool_clear(batchpool);
+
+      /* Complete the previous batch and fetch the next one in the same
+         transaction. */
+      SVN_ERR(svn_wc__db_wq_record_and_fetch_batch(&ids, &work_items,
+                                                   db, wri_abspath,
+                                                   completed_ids,
+                                                   wib.record_map,
+                                                   WQ_BATCH_SIZE,
+                                                   batchpool, batchpool));
+      apr_array_clear(completed_ids);
+      svn_pool_clear(wib.result_pool);
+      wib.record_map = NULL;
+      wib.used = FALSE;
+
+      if (work_items->nelts == 0)
         break;
 
-      err = dispatch_work_item(&wib, db, wri_abspath, work_item,
-                               cancel_func, cancel_baton, iterpool);
-      if (err)
+      while (i < work_items->nelts)
         {
-          const char *skel = svn_skel__unparse(work_item, scratch_pool)->data;
-
-          return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
-                                   _("Failed to run the WC DB work queue "
-                                     "associated with '%s', work item %d %s"),
-                                   svn_dirent_local_style(wri_abspath,
-                                                          scratch_pool),
-                                   (int)id, skel);
-        }
+          const svn_skel_t *work_item = APR_ARRAY_IDX(work_items, i,
+                                                      const svn_skel_t *);
+          apr_uint64_t id = APR_ARRAY_IDX(ids, i, apr_uint64_t);
+          svn_error_t *err = SVN_NO_ERROR;
+#if APR_HAS_THREADS
+          int count;
+#endif
 
-      /* The work item finished without error. Mark it completed
-         in the next loop.  */
-      last_id = id;
+          svn_pool_clear(iterpool);
+
+          /* Stop work queue processing, if requested. A future 'svn
+             cleanup' should be able to continue the processing. */
+          if (cancel_func)
+            err = cancel_func(cancel_baton);
+
+#if APR_HAS_THREADS
+          count = (err || threads <= 1)
+                    ? 0
+                    : count_file_installs(work_items, i, iterpool);
+          if (count > 1)
+            {
+              err = install_files_concurrently(&wib, completed_ids,
+                                               db, wri_abspath,
+                                               ids, work_items, i, count,
+                                               threads,
+                                               cancel_func, cancel_baton,
+                                               iterpool);
+              i += count;
+            }
+          else
+#endif
+          if (!err)
+            {
+              /* A file install only reads what earlier items changed on
+                 disk and in the NODES table, so its file info can wait.
+                 Anything else may depend on all previous work items to be
+                 reflected in the DB. */
+              if (!svn_skel__matches_atom(work_item->children,
+                                          OP_FILE_INSTALL)
+                  && (completed_ids->nelts || wib.used))
+                SVN_ERR(complete_work_items(&wib, completed_ids,
+                                            db, wri_abspath, iterpool));
+
+              err = dispatch_work_item(&wib, db, wri_abspath, work_item,
+                                       cancel_func, cancel_baton, iterpool);
+              if (err)
+                err = work_item_error(err, wri_abspath, id, work_item,
+                                      scratch_pool);
+              else
+                APR_ARRAY_PUSH(completed_ids, apr_uint64_t) = id;
+
+              ++i;
+            }
+
+          /* Don't run the items that did complete again. */
+          if (err)
+            return svn_error_compose_create(
+                     err,
+                     complete_work_items(&wib, completed_ids,
+                                         db, wri_abspath, iterpool));
+        }
     }
 
   svn_pool_destroy(iterpool);
+  svn_pool_destroy(batchpool);
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__wq_run(svn_wc__db_t *db,
+               const char *wri_abspath,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *scratch_pool)
+{
+#ifdef SVN_DEBUG_WORK_QUEUE
+  SVN_DBG(("wq_run: wri='%s'\n", wri_abspath));
+  {
+    static int count = 0;
+    const char *count_env_var = getenv("SVN_DEBUG_WORK_QUEUE");
+    int count_env_val;
+
+    SVN_ERR(svn_cstring_atoi(&count_env_val, count_env_var));
+
+    if (count_env_var && ++count == count_env_val)
+      return svn_error_create(SVN_ERR_CANCELLED, NULL, "fake cancel");
+  }
+#endif
+
+  /* Files can be installed concurrently; everything else still happens
+     in queue order. */
+  return svn_error_trace(
+           run_work_queue_batched(db, wri_abspath,
+                                  svn_wc__db_get_io_threads(db),
+                                  cancel_func, cancel_baton,
+                                  scratch_pool));
+}
+
 
 svn_skel_t *
 svn_wc__wq_merge(svn_skel_t *work_item1,
@@ -1624,18 +2086,28 @@ get_and_record_fileinfo(work_item_baton_t *wqb,
   const svn_io_dirent2_t *dirent;
 
   SVN_ERR(svn_io_stat_dirent2(&dirent, local_abspath, FALSE, ignore_enoent,
-                              wqb->result_pool, scratch_pool));
+                              scratch_pool, scratch_pool));
 
   if (dirent->kind != svn_node_file)
     return SVN_NO_ERROR;
 
+  record_fileinfo(wqb, local_abspath, dirent);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remember to record the size and timestamp of the file LOCAL_ABSPATH
+   from DIRENT when the current work item completes. */
+static void
+record_fileinfo(work_item_baton_t *wqb,
+                const char *local_abspath,
+                const svn_io_dirent2_t *dirent)
+{
   wqb->used = TRUE;
 
   if (! wqb->record_map)
     wqb->record_map = apr_hash_make(wqb->result_pool);
 
   svn_hash_sets(wqb->record_map, apr_pstrdup(wqb->result_pool, local_abspath),
-                dirent);
-
-  return SVN_NO_ERROR;
+                svn_io_dirent2_dup(dirent, wqb->result_pool));
 }
@@ -270,6 +270,7 @@ typedef struct svn_cl__opt_state_t
   svn_boolean_t vacuum_pristines; /* remove unreferenced pristines */
   svn_boolean_t drop;             /* drop shelf after successful unshelve */
   svn_cl__size_unit_t file_size_unit; /* file size format */
+  svn_tristate_t store_pristine;  /* keep local pristine texts on checkout */
   enum svn_cl__viewspec_t {
       svn_cl__viewspec_unspecified = 0 /* default */,
       svn_cl__viewspec_classic,
@@ -374,6 +375,7 @@ typedef enum svn_cl__longopt_t {
   opt_vacuum_pristines,
   opt_drop,
   opt_viewspec,
+  opt_store_pristine,
 } svn_cl__longopt_t;
 
 /* Options for giving a log message.  (Some of these also have other uses.)
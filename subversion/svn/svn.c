@@ -408,6 +408,15 @@ const apr_getopt_option_t svn_cl__options[] =
                           "                             "
                           "to ARG: 'classic' or 'svn11'")},
 
+  {"store-pristine", opt_store_pristine, 1,
+                       N_("keep a local copy of the pristine text of every\n"
+                          "                             "
+                          "file; ARG is 'yes' (default) or 'no'. Without a\n"
+                          "                             "
+                          "local copy, pristine texts are fetched from the\n"
+                          "                             "
+                          "repository when needed")},
+
   /* Long-opt Aliases
    *
    * These have NULL descriptions, but an option code that matches some
@@ -570,10 +579,18 @@ svn_cl__cmd_table_main[] =
      "  to the working copy.  All properties from the repository are applied\n"
      "  to the obstructing path.\n"
      "\n"), N_(
+     "  If --store-pristine=no is used, the working copy does not keep a\n"
+     "  local copy of the pristine text of every file.  This halves the disk\n"
+     "  space and I/O needed by the checkout, at the cost of fetching texts\n"
+     "  from the repository when an operation such as diff or revert needs\n"
+     "  them.  A few recently used texts are kept; see 'pristine-cache-size'\n"
+     "  in the 'working-copy' section of the client configuration.\n"
+     "\n"), N_(
      "  See also 'svn help update' for a list of possible characters\n"
      "  reporting the action taken.\n"
     )},
-    {'r', 'q', 'N', opt_depth, opt_force, opt_ignore_externals},
+    {'r', 'q', 'N', opt_depth, opt_force, opt_ignore_externals,
+     opt_store_pristine},
     {{'N', N_("obsolete; same as --depth=files")}} },
 
   { "cleanup", svn_cl__cleanup, {0}, {N_(
@@ -2643,6 +2660,15 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
         SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
         SVN_ERR(viewspec_from_word(&opt_state.viewspec, utf8_opt_arg));
         break;
+      case opt_store_pristine:
+        SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
+        opt_state.store_pristine = svn_tristate__from_word(utf8_opt_arg);
+        if (opt_state.store_pristine == svn_tristate_unknown)
+          return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                   _("'%s' is not a valid --store-pristine "
+                                     "value"),
+                                   utf8_opt_arg);
+        break;
       default:
         /* Hmmm. Perhaps this would be a good place to squirrel away
            opts that commands like svn diff might need. Hmmm indeed. */
@@ -51,6 +51,7 @@
 #include "private/svn_cmdline_private.h"
 #include "private/svn_fspath.h"
 #include "private/svn_fs_fs_private.h"
+#include "private/svn_repos_private.h"
 
 #include "svn_private_config.h"
 
@@ -159,7 +160,8 @@ enum svnadmin__cmdline_options_t
     svnadmin__normalize_props,
     svnadmin__exclude,
     svnadmin__include,
-    svnadmin__glob
+    svnadmin__glob,
+    svnadmin__jobs
   };
 
 /* Option codes and descriptions.
@@ -184,7 +186,7 @@ static const apr_getopt_option_t options_table[] =
      N_("specify transaction name ARG")},
 
     {"incremental",   svnadmin__incremental, 0,
-     N_("dump or hotcopy incrementally")},
+     N_("dump, hotcopy or verify incrementally")},
 
     {"deltas",        svnadmin__deltas, 0,
      N_("use deltas in dump output")},
@@ -286,6 +288,10 @@ static const apr_getopt_option_t options_table[] =
      N_("normalize property values found in the dumpstream\n"
         "                             (currently, only translates non-LF line endings)")},
 
+    {"jobs", svnadmin__jobs, 1,
+     N_("use up to ARG threads for loading or verifying\n"
+        "                             (default: 1)")},
+
     {"exclude", svnadmin__exclude, 1,
      N_("filter out nodes with given prefix(es) from dump")},
 
@@ -470,7 +476,7 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     svnadmin__use_pre_commit_hook, svnadmin__use_post_commit_hook,
     svnadmin__parent_dir, svnadmin__normalize_props,
     svnadmin__bypass_prop_validation, 'M',
-    svnadmin__no_flush_to_disk, 'F'},
+    svnadmin__no_flush_to_disk, svnadmin__jobs, 'F'},
    {{'F', N_("read from file ARG instead of stdin")}} },
 
   {"load-revprops", subcommand_load_revprops, {0}, {N_(
@@ -628,9 +634,16 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "usage: svnadmin verify REPOS_PATH\n"
     "\n"), N_(
     "Verify the data stored in the repository.\n"
+    "\n"
+    "If --incremental is passed, revisions that passed verification before\n"
+    "and have not been modified since will be skipped.  Progress will be\n"
+    "recorded along the way, so that an interrupted verification resumes\n"
+    "where it stopped.  Runs with --metadata-only record nothing.  Only\n"
+    "supported for FSFS repositories using logical addressing.\n"
    )},
    {'t', 'r', 'q', svnadmin__keep_going, 'M',
-    svnadmin__check_normalization, svnadmin__metadata_only} },
+    svnadmin__check_normalization, svnadmin__metadata_only,
+    svnadmin__jobs, svnadmin__incremental} },
 
   { NULL, NULL, {0}, {NULL}, {0} }
 };
@@ -673,6 +686,7 @@ struct svnadmin_opt_state
   apr_array_header_t *exclude;                      /* --exclude */
   apr_array_header_t *include;                      /* --include */
   svn_boolean_t glob;                               /* --pattern */
+  int jobs;                                         /* --jobs */
 
   const char *config_dir;    /* Overriding Configuration Directory */
 };
@@ -1015,7 +1029,7 @@ struct repos_verify_callback_baton
 };
 
 /* Implementation of svn_repos_verify_callback_t to handle errors coming
-   from svn_repos_verify_fs3(). */
+   from svn_repos_verify_fs4(). */
 static svn_error_t *
 repos_verify_callback(void *baton,
                       svn_revnum_t revision,
@@ -1732,15 +1746,19 @@ subcommand_load(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   if (! opt_state->quiet)
     feedback_stream = recode_stream_create(stdout, pool);
 
-  err = svn_repos_load_fs6(repos, in_stream, lower, upper,
-                           opt_state->uuid_action, opt_state->parent_dir,
-                           opt_state->use_pre_commit_hook,
-                           opt_state->use_post_commit_hook,
-                           !opt_state->bypass_prop_validation,
-                           opt_state->ignore_dates,
-                           opt_state->normalize_props,
-                           opt_state->quiet ? NULL : repos_notify_handler,
-                           feedback_stream, check_cancel, NULL, pool);
+  err = svn_repos__load_fs_pipelined(repos, in_stream, lower, upper,
+                                     opt_state->uuid_action,
+                                     opt_state->parent_dir,
+                                     opt_state->use_pre_commit_hook,
+                                     opt_state->use_post_commit_hook,
+                                     !opt_state->bypass_prop_validation,
+                                     opt_state->ignore_dates,
+                                     opt_state->normalize_props,
+                                     opt_state->jobs,
+                                     opt_state->quiet
+                                       ? NULL : repos_notify_handler,
+                                     feedback_stream, check_cancel, NULL,
+                                     pool);
 
   if (svn_error_find_cause(err, SVN_ERR_BAD_PROPERTY_VALUE_EOL))
     {
@@ -2211,6 +2229,88 @@ subcommand_pack(apr_getopt_t *os, void *baton, apr_pool_t *pool)
 }
 
 
+/* Number of revisions that 'svnadmin verify --incremental' verifies at
+   most before it records them as verified. */
+#define VERIFY_BATCH_SIZE 1000
+
+/* Verify the revisions of REPOS covered by UNITS, an array of
+   svn_fs_fs__verify_unit_t * as returned by the
+   SVN_FS_FS__IOCTL_GET_VERIFY_CHECKPOINTS ioctl, according to OPT_STATE.
+   Skip units that passed verification before and record the ones that
+   pass now.  FEEDBACK_STREAM and VERIFY_BATON are as for
+   svn_repos_verify_fs4().  Use POOL for temporary allocations. */
+static svn_error_t *
+verify_incrementally(svn_repos_t *repos,
+                     const apr_array_header_t *units,
+                     struct svnadmin_opt_state *opt_state,
+                     svn_stream_t *feedback_stream,
+                     struct repos_verify_callback_baton *verify_baton,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i = 0;
+
+  while (i < units->nelts)
+    {
+      svn_fs_fs__ioctl_verify_checkpoints_input_t input;
+      const svn_fs_fs__verify_unit_t *unit
+        = APR_ARRAY_IDX(units, i, const svn_fs_fs__verify_unit_t *);
+      svn_boolean_t verified = unit->verified;
+      int error_count = verify_baton->error_summary->nelts;
+
+      svn_pool_clear(iterpool);
+
+      /* Group consecutive units of the same kind.  Keep the batches of
+         units to verify small enough to make progress. */
+      input.start_rev = unit->start;
+      do
+        {
+          input.end_rev = unit->end;
+          if (++i < units->nelts)
+            unit = APR_ARRAY_IDX(units, i, const svn_fs_fs__verify_unit_t *);
+        }
+      while (i < units->nelts
+             && unit->verified == verified
+             && (verified
+                 || input.end_rev - input.start_rev + 1 < VERIFY_BATCH_SIZE));
+
+      if (verified)
+        {
+          if (feedback_stream)
+            SVN_ERR(svn_stream_printf(feedback_stream, iterpool,
+                                      _("* Skipped revisions %ld to %ld, "
+                                        "verified before.\n"),
+                                      input.start_rev, input.end_rev));
+          continue;
+        }
+
+      SVN_ERR(svn_repos_verify_fs4(repos, input.start_rev, input.end_rev,
+                                   opt_state->check_normalization,
+                                   opt_state->metadata_only,
+                                   opt_state->jobs,
+                                   feedback_stream
+                                     ? repos_notify_handler : NULL,
+                                   feedback_stream,
+                                   repos_verify_callback, verify_baton,
+                                   check_cancel, NULL, iterpool));
+
+      /* With --keep-going, errors only show up in the summary. */
+      if (!opt_state->metadata_only
+          && verify_baton->error_summary->nelts == error_count)
+        SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_ADD_VERIFY_CHECKPOINTS,
+                             &input, NULL, check_cancel, NULL,
+                             iterpool, iterpool));
+    }
+
+  /* Don't let the checkpoints pile up over many runs. */
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_COMPACT_VERIFY_CHECKPOINTS,
+                       NULL, NULL, check_cancel, NULL, iterpool, iterpool));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_verify(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -2221,6 +2321,7 @@ subcommand_verify(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   svn_revnum_t youngest, lower, upper;
   svn_stream_t *feedback_stream = NULL;
   struct repos_verify_callback_baton verify_baton = { 0 };
+  svn_boolean_t verified_incrementally = FALSE;
 
   /* Expect no more arguments. */
   SVN_ERR(parse_args(NULL, os, 0, 0, pool));
@@ -2272,14 +2373,43 @@ subcommand_verify(apr_getopt_t *os, void *baton, apr_pool_t *pool)
     apr_array_make(pool, 0, sizeof(struct verification_error *));
   verify_baton.result_pool = pool;
 
-  SVN_ERR(svn_repos_verify_fs3(repos, lower, upper,
-                               opt_state->check_normalization,
-                               opt_state->metadata_only,
-                               !opt_state->quiet
-                                 ? repos_notify_handler : NULL,
-                               feedback_stream,
-                               repos_verify_callback, &verify_baton,
-                               check_cancel, NULL, pool));
+  if (opt_state->incremental)
+    {
+      svn_fs_fs__ioctl_verify_checkpoints_input_t input;
+      svn_fs_fs__ioctl_get_verify_checkpoints_output_t *output;
+      svn_error_t *err;
+
+      input.start_rev = lower;
+      input.end_rev = upper;
+      err = svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_GET_VERIFY_CHECKPOINTS,
+                         &input, (void **)&output, check_cancel, NULL,
+                         pool, pool);
+
+      /* Other repositories get verified completely. */
+      if (err && (err->apr_err == SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE
+                  || err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE))
+        svn_error_clear(err);
+      else if (err)
+        return svn_error_trace(err);
+      else
+        {
+          SVN_ERR(verify_incrementally(repos, output->units, opt_state,
+                                       feedback_stream, &verify_baton,
+                                       pool));
+          verified_incrementally = TRUE;
+        }
+    }
+
+  if (!verified_incrementally)
+    SVN_ERR(svn_repos_verify_fs4(repos, lower, upper,
+                                 opt_state->check_normalization,
+                                 opt_state->metadata_only,
+                                 opt_state->jobs,
+                                 !opt_state->quiet
+                                   ? repos_notify_handler : NULL,
+                                 feedback_stream,
+                                 repos_verify_callback, &verify_baton,
+                                 check_cancel, NULL, pool));
 
   /* Show the --keep-going error summary. */
   if (opt_state->keep_going && verify_baton.error_summary->nelts > 0)
@@ -3076,6 +3206,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   opt_state.start_revision.kind = svn_opt_revision_unspecified;
   opt_state.end_revision.kind = svn_opt_revision_unspecified;
   opt_state.memory_cache_size = svn_cache_config_get()->cache_size;
+  opt_state.jobs = 1;
 
   /* Parse options. */
   SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
@@ -3273,6 +3404,12 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnadmin__normalize_props:
         opt_state.normalize_props = TRUE;
         break;
+      case svnadmin__jobs:
+        SVN_ERR(svn_cstring_atoi(&opt_state.jobs, opt_arg));
+        if (opt_state.jobs < 1)
+          return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                  _("--jobs must be a positive number"));
+        break;
       case svnadmin__exclude:
         SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
 
@@ -3412,12 +3549,20 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   check_cancel = svn_cmdline__setup_cancellation_handler();
 
   /* Configure FSFS caches for maximum efficiency with svnadmin.
-   * Also, apply the respective command line parameters, if given. */
+   * Also, apply the respective command line parameters, if given.
+   *
+   * The caches must be thread-safe if the FS may use multiple threads.
+   * That is the case with --jobs and for packing, which may also happen
+   * after each commit during a load.  This must be set before the first
+   * FS gets opened.  The FS would fall back to a single thread otherwise.
+   */
   {
     svn_cache_config_t settings = *svn_cache_config_get();
 
     settings.cache_size = opt_state.memory_cache_size;
-    settings.single_threaded = TRUE;
+    settings.single_threaded =    opt_state.jobs <= 1
+                               && subcommand->cmd_func != subcommand_pack
+                               && subcommand->cmd_func != subcommand_load;
 
     svn_cache_config_set(&settings);
   }
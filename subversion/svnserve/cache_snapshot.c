@@ -0,0 +1,294 @@
+/*
+ * cache_snapshot.c : Background thread saving and loading FSFS caches
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+
+#include "svn_error.h"
+#include "svn_fs.h"
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_repos.h"
+#include "svn_time.h"
+
+#include "private/svn_fs_fs_private.h"
+
+#include "svn_private_config.h"
+#include "cache_snapshot.h"
+
+#if APR_HAS_THREADS
+
+struct cache_snapshots_t
+{
+  /* Time between saving snapshots. */
+  apr_interval_time_t interval;
+
+  /* Used to open the repositories. */
+  apr_hash_t *fs_config;
+
+  /* Where to report errors.  May be NULL. */
+  logger_t *logger;
+
+  /* The snapshot thread. */
+  apr_thread_t *thread;
+
+  /* Mutex serializing access to the members below and the condition
+     that wakes the snapshot thread up. */
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *cond;
+
+  /* Maps repository root paths to svn_boolean_t *.  The value is TRUE
+     for repositories whose snapshot we tried to load already. */
+  apr_hash_t *repositories;
+
+  /* Number of entries in REPOSITORIES with a FALSE value. */
+  int pending;
+
+  /* Set to tell the snapshot thread to terminate. */
+  svn_boolean_t shutdown;
+
+  /* Pool for the members above. */
+  apr_pool_t *pool;
+};
+
+/* Load the cache snapshot of the repository at REPOS_ROOT or, if SAVE is
+ * set, save a new one.  Open the repository with FS_CONFIG.  Use
+ * SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+process_repository(const char *repos_root,
+                   svn_boolean_t save,
+                   apr_hash_t *fs_config,
+                   apr_pool_t *scratch_pool)
+{
+  svn_repos_t *repos;
+  svn_fs_fs__ioctl_cache_snapshot_input_t input = { NULL };
+  void *output;
+  svn_error_t *err;
+
+  SVN_ERR(svn_repos_open3(&repos, repos_root, fs_config, scratch_pool,
+                          scratch_pool));
+  err = svn_fs_ioctl(svn_repos_fs(repos),
+                     save ? SVN_FS_FS__IOCTL_SAVE_CACHE_SNAPSHOT
+                          : SVN_FS_FS__IOCTL_LOAD_CACHE_SNAPSHOT,
+                     &input, &output, NULL, NULL,
+                     scratch_pool, scratch_pool);
+
+  /* Only FSFS supports cache snapshots. */
+  if (err && err->apr_err == SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Thread function that does all the snapshot I/O for the
+ * cache_snapshots_t in DATA.
+ */
+static void * APR_THREAD_FUNC
+snapshot_thread(apr_thread_t *tid,
+                void *data)
+{
+  cache_snapshots_t *snapshots = data;
+  apr_pool_t *pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_time_t next_save = apr_time_now() + snapshots->interval;
+
+  apr_thread_mutex_lock(snapshots->mutex);
+  while (!snapshots->shutdown)
+    {
+      apr_array_header_t *roots;
+      svn_boolean_t save;
+      apr_hash_index_t *hi;
+      apr_time_t now;
+      int i;
+
+      now = apr_time_now();
+      if (snapshots->pending == 0 && now < next_save)
+        {
+          apr_thread_cond_timedwait(snapshots->cond, snapshots->mutex,
+                                    next_save - now);
+          continue;
+        }
+
+      /* Loading snapshots of new repositories takes precedence.  Pick
+         the work items while holding the lock but do the I/O without. */
+      svn_pool_clear(iterpool);
+      save = snapshots->pending == 0;
+      roots = apr_array_make(iterpool, 16, sizeof(const char *));
+      for (hi = apr_hash_first(iterpool, snapshots->repositories);
+           hi;
+           hi = apr_hash_next(hi))
+        {
+          svn_boolean_t *loaded = apr_hash_this_val(hi);
+          if (save || !*loaded)
+            APR_ARRAY_PUSH(roots, const char *) = apr_hash_this_key(hi);
+
+          *loaded = TRUE;
+        }
+
+      snapshots->pending = 0;
+      if (save)
+        next_save = now + snapshots->interval;
+
+      apr_thread_mutex_unlock(snapshots->mutex);
+
+      /* Snapshots are an optimization only.  Just log errors. */
+      for (i = 0; i < roots->nelts; i++)
+        {
+          svn_error_t *err;
+
+          err = process_repository(APR_ARRAY_IDX(roots, i, const char *),
+                                   save, snapshots->fs_config, iterpool);
+          if (err)
+            {
+              logger__log_warning(snapshots->logger, err, NULL, NULL);
+              svn_error_clear(err);
+            }
+        }
+
+      apr_thread_mutex_lock(snapshots->mutex);
+    }
+  apr_thread_mutex_unlock(snapshots->mutex);
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Pool cleanup function stopping the snapshot thread of the
+ * cache_snapshots_t in DATA.
+ */
+static apr_status_t
+stop_snapshot_thread(void *data)
+{
+  cache_snapshots_t *snapshots = data;
+  apr_status_t retval;
+
+  apr_thread_mutex_lock(snapshots->mutex);
+  snapshots->shutdown = TRUE;
+  apr_thread_cond_signal(snapshots->cond);
+  apr_thread_mutex_unlock(snapshots->mutex);
+
+  return apr_thread_join(&retval, snapshots->thread);
+}
+
+svn_error_t *
+cache_snapshots__create(cache_snapshots_t **snapshots,
+                        apr_int64_t interval,
+                        apr_hash_t *fs_config,
+                        logger_t *logger,
+                        apr_pool_t *pool)
+{
+  cache_snapshots_t *result = apr_pcalloc(pool, sizeof(*result));
+  apr_status_t status;
+
+  /* Connection threads allocate from this pool while holding the mutex,
+     so it must not be shared with anyone else. */
+  result->pool = svn_pool_create(pool);
+  pool = result->pool;
+
+  result->interval = apr_time_from_sec(interval);
+  result->fs_config = fs_config;
+  result->logger = logger;
+  result->repositories = apr_hash_make(pool);
+
+  status = apr_thread_mutex_create(&result->mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   pool);
+  if (!status)
+    status = apr_thread_cond_create(&result->cond, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create cache snapshot lock"));
+
+  status = apr_thread_create(&result->thread, NULL, snapshot_thread,
+                             result, pool);
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't create cache snapshot thread"));
+
+  /* Stop the thread before any of the above gets destroyed. */
+  apr_pool_pre_cleanup_register(pool, result, stop_snapshot_thread);
+
+  *snapshots = result;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+cache_snapshots__add(cache_snapshots_t *snapshots,
+                     const char *repos_root)
+{
+  apr_status_t status;
+
+  if (snapshots == NULL)
+    return SVN_NO_ERROR;
+
+  status = apr_thread_mutex_lock(snapshots->mutex);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't lock mutex"));
+
+  if (!svn_hash_gets(snapshots->repositories, repos_root))
+    {
+      svn_boolean_t *loaded = apr_pcalloc(snapshots->pool, sizeof(*loaded));
+      svn_hash_sets(snapshots->repositories,
+                    apr_pstrdup(snapshots->pool, repos_root), loaded);
+      snapshots->pending++;
+      apr_thread_cond_signal(snapshots->cond);
+    }
+
+  status = apr_thread_mutex_unlock(snapshots->mutex);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't unlock mutex"));
+
+  return SVN_NO_ERROR;
+}
+
+#else /* !APR_HAS_THREADS */
+
+svn_error_t *
+cache_snapshots__create(cache_snapshots_t **snapshots,
+                        apr_int64_t interval,
+                        apr_hash_t *fs_config,
+                        logger_t *logger,
+                        apr_pool_t *pool)
+{
+  *snapshots = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+cache_snapshots__add(cache_snapshots_t *snapshots,
+                     const char *repos_root)
+{
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
@@ -0,0 +1,72 @@
+/*
+ * cache_snapshot.h : FSFS cache snapshots of a long-running server
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef CACHE_SNAPSHOT_H
+#define CACHE_SNAPSHOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "server.h"
+#include "logger.h"
+
+
+
+/* Opaque background writer of FSFS cache snapshots.  All access to it
+ * will be serialized among threads within the same process.
+ */
+typedef struct cache_snapshots_t cache_snapshots_t;
+
+/* In POOL, create a background thread that loads the FSFS cache snapshot
+ * of each repository passed to cache_snapshots__add() and that saves new
+ * snapshots of all these repositories every INTERVAL seconds.  Open the
+ * repositories with FS_CONFIG and log errors to LOGGER, which may be NULL.
+ * Return the object controlling the thread in *SNAPSHOTS.  The thread
+ * will be stopped when POOL gets cleared or destroyed.
+ *
+ * The thread shares the FSFS caches with the connections being served,
+ * i.e. those caches must support multi-threaded access.  Without thread
+ * support, set *SNAPSHOTS to NULL.
+ */
+svn_error_t *
+cache_snapshots__create(cache_snapshots_t **snapshots,
+                        apr_int64_t interval,
+                        apr_hash_t *fs_config,
+                        logger_t *logger,
+                        apr_pool_t *pool);
+
+/* Tell SNAPSHOTS about the repository at REPOS_ROOT, which a connection
+ * just opened.  The first time we see a repository, its cache snapshot
+ * will be loaded in the background.  This does not do any I/O.
+ * SNAPSHOTS may be NULL, in which case this is a no-op.
+ */
+svn_error_t *
+cache_snapshots__add(cache_snapshots_t *snapshots,
+                     const char *repos_root);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CACHE_SNAPSHOT_H */
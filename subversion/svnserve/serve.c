@@ -48,6 +48,7 @@
 #include "svn_time.h"
 #include "svn_config.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
 #include "svn_mergeinfo.h"
 #include "svn_user.h"
 
@@ -55,6 +56,7 @@
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_ra_svn_private.h"
 #include "private/svn_fspath.h"
+#include "private/svn_fs_private.h"
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>   /* For getpid() */
@@ -62,6 +64,7 @@
 
 #include "server.h"
 #include "logger.h"
+#include "cache_snapshot.h"
 
 typedef struct commit_callback_baton_t {
   apr_pool_t *pool;
@@ -982,6 +985,9 @@ static const svn_ra_svn__cmd_entry_t report_commands[] = {
  * If from_rev is not NULL, set *from_rev to the revision number from
  * the set-path on ""; if somehow set-path "" never happens, set
  * *from_rev to SVN_INVALID_REVNUM.
+ *
+ * If omit_fulltexts is TRUE, send the contents of files that have no
+ * delta base as empty deltas; the client fetches those by itself.
  */
 static svn_error_t *accept_report(svn_boolean_t *only_empty_entry,
                                   svn_revnum_t *from_rev,
@@ -989,6 +995,7 @@ static svn_error_t *accept_report(svn_boolean_t *only_empty_entry,
                                   server_baton_t *b, svn_revnum_t rev,
                                   const char *target, const char *tgt_path,
                                   svn_boolean_t text_deltas,
+                                  svn_boolean_t omit_fulltexts,
                                   svn_depth_t depth,
                                   svn_boolean_t send_copyfrom_args,
                                   svn_boolean_t ignore_ancestry)
@@ -1004,7 +1011,11 @@ static svn_error_t *accept_report(svn_boolean_t *only_empty_entry,
 
   /* Make an svn_repos report baton.  Tell it to drive the network editor
    * when the report is complete. */
-  svn_ra_svn_get_editor(&editor, &edit_baton, conn, pool, NULL, NULL);
+  if (omit_fulltexts)
+    svn_ra_svn__get_editor_without_fulltexts(&editor, &edit_baton, conn,
+                                             pool);
+  else
+    svn_ra_svn_get_editor(&editor, &edit_baton, conn, pool, NULL, NULL);
   SVN_CMD_ERR(svn_repos_begin_report3(&report_baton, rev,
                                       b->repository->repos,
                                       b->repository->fs_path->data, target,
@@ -1582,6 +1593,63 @@ commit(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+/* Fulltexts that are stored verbatim in the repository and are at least
+   this large get sent straight from the repository files. */
+#define VERBATIM_CONTENTS_THRESHOLD 0x10000
+
+/* Maximum length of the strings that verbatim contents are sent in. */
+#define VERBATIM_CONTENTS_CHUNK_SIZE 0x100000
+
+/* Return the total length of the svn_fs__file_range_t in RANGES. */
+static apr_off_t
+ranges_length(const apr_array_header_t *ranges)
+{
+  apr_off_t total = 0;
+  int i;
+
+  for (i = 0; i < ranges->nelts; i++)
+    total += APR_ARRAY_IDX(ranges, i, svn_fs__file_range_t).length;
+
+  return total;
+}
+
+/* Send the svn_fs__file_range_t RANGES of FILE over CONN as a sequence
+   of strings, like get_file() sends the contents of a file stream.  Use
+   POOL for temporary allocations. */
+static svn_error_t *
+write_file_ranges(svn_ra_svn_conn_t *conn,
+                  apr_file_t *file,
+                  const apr_array_header_t *ranges,
+                  apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  for (i = 0; i < ranges->nelts; i++)
+    {
+      const svn_fs__file_range_t *range
+        = &APR_ARRAY_IDX(ranges, i, svn_fs__file_range_t);
+      apr_off_t offset = range->offset;
+      apr_off_t remaining = range->length;
+
+      while (remaining > 0)
+        {
+          apr_size_t len = (apr_size_t)MIN(remaining,
+                                           VERBATIM_CONTENTS_CHUNK_SIZE);
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_ra_svn__write_file_range(conn, iterpool, file,
+                                               offset, len));
+          offset += len;
+          remaining -= len;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 get_file(svn_ra_svn_conn_t *conn,
          apr_pool_t *pool,
@@ -1592,7 +1660,9 @@ get_file(svn_ra_svn_conn_t *conn,
   const char *path, *full_path, *hex_digest, *canonical_path;
   svn_revnum_t rev;
   svn_fs_root_t *root;
-  svn_stream_t *contents;
+  svn_stream_t *contents = NULL;
+  apr_file_t *contents_file = NULL;
+  apr_array_header_t *contents_ranges;
   apr_hash_t *props = NULL;
   apr_array_header_t *inherited_props;
   svn_string_t write_str;
@@ -1647,7 +1717,20 @@ get_file(svn_ra_svn_conn_t *conn,
                           &ab, root, full_path,
                           pool));
   if (want_contents)
-    SVN_CMD_ERR(svn_fs_file_contents(&contents, root, full_path, pool));
+    {
+      /* Large fulltexts that the repository stores verbatim can be sent
+         without passing them through our buffers. */
+      SVN_CMD_ERR(svn_fs__file_contents_ranges(&contents_file,
+                                               &contents_ranges,
+                                               root, full_path,
+                                               pool, pool));
+      if (contents_file
+          && ranges_length(contents_ranges) < VERBATIM_CONTENTS_THRESHOLD)
+        contents_file = NULL;
+
+      if (!contents_file)
+        SVN_CMD_ERR(svn_fs_file_contents(&contents, root, full_path, pool));
+    }
 
   /* Send successful command response with revision and props. */
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w((?c)r(!", "success",
@@ -1677,7 +1760,13 @@ get_file(svn_ra_svn_conn_t *conn,
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!))"));
 
   /* Now send the file's contents. */
-  if (want_contents)
+  if (want_contents && contents_file)
+    {
+      SVN_ERR(write_file_ranges(conn, contents_file, contents_ranges, pool));
+      SVN_ERR(svn_ra_svn__write_cstring(conn, pool, ""));
+      SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
+    }
+  else if (want_contents)
     {
       err = SVN_NO_ERROR;
       while (1)
@@ -1956,15 +2045,17 @@ update(svn_ra_svn_conn_t *conn,
   svn_boolean_t recurse;
   svn_tristate_t send_copyfrom_args; /* Optional; default FALSE */
   svn_tristate_t ignore_ancestry; /* Optional; default FALSE */
+  svn_tristate_t text_deltas; /* Optional; default TRUE */
   /* Default to unknown.  Old clients won't send depth, but we'll
      handle that by converting recurse if necessary. */
   svn_depth_t depth = svn_depth_unknown;
   svn_boolean_t is_checkout;
 
   /* Parse the arguments. */
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "(?r)cb?w3?3", &rev, &target,
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "(?r)cb?w3?3?3", &rev, &target,
                                   &recurse, &depth_word,
-                                  &send_copyfrom_args, &ignore_ancestry));
+                                  &send_copyfrom_args, &ignore_ancestry,
+                                  &text_deltas));
   SVN_ERR(svn_relpath_canonicalize_safe(&canonical_target, NULL, target,
                                         pool, pool));
   target = canonical_target;
@@ -1982,7 +2073,8 @@ update(svn_ra_svn_conn_t *conn,
     SVN_CMD_ERR(svn_fs_youngest_rev(&rev, b->repository->fs, pool));
 
   SVN_ERR(accept_report(&is_checkout, NULL,
-                        conn, pool, b, rev, target, NULL, TRUE,
+                        conn, pool, b, rev, target, NULL,
+                        TRUE, (text_deltas == svn_tristate_false),
                         depth,
                         (send_copyfrom_args == svn_tristate_true),
                         (ignore_ancestry == svn_tristate_true)));
@@ -2054,7 +2146,7 @@ switch_cmd(svn_ra_svn_conn_t *conn,
   }
 
   return accept_report(NULL, NULL,
-                       conn, pool, b, rev, target, switch_path, TRUE,
+                       conn, pool, b, rev, target, switch_path, TRUE, FALSE,
                        depth,
                        (send_copyfrom_args == svn_tristate_true),
                        (ignore_ancestry != svn_tristate_false));
@@ -2098,7 +2190,7 @@ status(svn_ra_svn_conn_t *conn,
   }
 
   return accept_report(NULL, NULL, conn, pool, b, rev, target, NULL, FALSE,
-                       depth, FALSE, FALSE);
+                       FALSE, depth, FALSE, FALSE);
 }
 
 static svn_error_t *
@@ -2160,7 +2252,8 @@ diff(svn_ra_svn_conn_t *conn,
     svn_revnum_t from_rev;
     SVN_ERR(accept_report(NULL, &from_rev,
                           conn, pool, b, rev, target, versus_path,
-                          text_deltas, depth, FALSE, ignore_ancestry));
+                          text_deltas, FALSE, depth, FALSE,
+                          ignore_ancestry));
     SVN_ERR(log_command(b, conn, pool, "%s",
                         svn_log__diff(full_path, from_rev, versus_path,
                                       rev, depth, ignore_ancestry,
@@ -4239,11 +4332,12 @@ construct_server_baton(server_baton_t **baton,
    * send an empty mechlist. */
   if (params->compression_level > 0)
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwwwwwwww)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_SVNDIFF1,
                                            SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED,
+                                           SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED,
                                            SVN_RA_SVN_CAP_ABSENT_ENTRIES,
                                            SVN_RA_SVN_CAP_COMMIT_REVPROPS,
                                            SVN_RA_SVN_CAP_DEPTH,
@@ -4253,11 +4347,14 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_FETCH_TEXTS,
+                                           SVN_RA_SVN_CAP_COMPRESS_LZ4,
+                                           SVN_RA_SVN_CAP_COMPRESS_ZLIB
                                            ));
   else
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwww)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_ABSENT_ENTRIES,
@@ -4269,7 +4366,8 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_FETCH_TEXTS
                                            ));
 
   /* Read client response, which we assume to be in version 2 format:
@@ -4340,6 +4438,9 @@ construct_server_baton(server_baton_t **baton,
                                        handle_authz_warning, b,
                                        conn_pool, scratch_pool),
                             b);
+  if (!err)
+    err = cache_snapshots__add(params->cache_snapshots,
+                               b->repository->repos_root);
   if (!err)
     {
       if (b->repository->anon_access == NO_ACCESS
@@ -4393,6 +4494,16 @@ construct_server_baton(server_baton_t **baton,
     SVN_ERR(svn_ra_svn__flush(conn, scratch_pool));
   }
 
+  /* Compress everything from here on if the client selected one of the
+     compression methods that we offered. */
+  if (params->compression_level > 0)
+    {
+      if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_COMPRESS_LZ4))
+        SVN_ERR(svn_ra_svn__enable_compression(conn, TRUE, scratch_pool));
+      else if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_COMPRESS_ZLIB))
+        SVN_ERR(svn_ra_svn__enable_compression(conn, FALSE, scratch_pool));
+    }
+
   /* Log the open. */
   if (ra_client_string == NULL || ra_client_string[0] == '\0')
     ra_client_string = "-";
@@ -4432,6 +4543,59 @@ construct_server_baton(server_baton_t **baton,
   return SVN_NO_ERROR;
 }
 
+/* Create the ra_svn connection object for CONNECTION, which has just
+ * been accepted, construct its server baton and open the repository.
+ * Use POOL for temporary allocations. */
+static svn_error_t *
+init_connection(connection_t *connection,
+                apr_pool_t *pool)
+{
+  apr_status_t ar;
+
+  /* Enable TCP keep-alives on the socket so we time out when
+   * the connection breaks due to network-layer problems.
+   * If the peer has dropped the connection due to a network partition
+   * or a crash, or if the peer no longer considers the connection
+   * valid because we are behind a NAT and our public IP has changed,
+   * it will respond to the keep-alive probe with a RST instead of an
+   * acknowledgment segment, which will cause svn to abort the session
+   * even while it is currently blocked waiting for data from the peer. */
+  ar = apr_socket_opt_set(connection->usock, APR_SO_KEEPALIVE, 1);
+  if (ar)
+    {
+      /* It's not a fatal error if we cannot enable keep-alives. */
+    }
+
+  /* create the connection, configure ports etc. */
+  connection->conn
+    = svn_ra_svn_create_conn5(connection->usock, NULL, NULL,
+                              connection->params->compression_level,
+                              connection->params->zero_copy_limit,
+                              connection->params->error_check_interval,
+                              connection->params->max_request_size,
+                              connection->params->max_response_size,
+                              connection->pool);
+
+  /* Construct server baton and open the repository for the first time. */
+  return svn_error_trace(construct_server_baton(&connection->baton,
+                                                connection->conn,
+                                                connection->params,
+                                                pool));
+}
+
+/* Return a command table for main_commands, allocated in POOL. */
+static apr_hash_t *
+make_command_hash(apr_pool_t *pool)
+{
+  const svn_ra_svn__cmd_entry_t *command;
+  apr_hash_t *cmd_hash = apr_hash_make(pool);
+
+  for (command = main_commands; command->cmdname; command++)
+    svn_hash_sets(cmd_hash, command->cmdname, command);
+
+  return cmd_hash;
+}
+
 svn_error_t *
 serve_interruptable(svn_boolean_t *terminate_p,
                     connection_t *connection,
@@ -4440,47 +4604,14 @@ serve_interruptable(svn_boolean_t *terminate_p,
 {
   svn_boolean_t terminate = FALSE;
   svn_error_t *err = NULL;
-  const svn_ra_svn__cmd_entry_t *command;
   apr_pool_t *iterpool = svn_pool_create(pool);
 
   /* Prepare command parser. */
-  apr_hash_t *cmd_hash = apr_hash_make(pool);
-  for (command = main_commands; command->cmdname; command++)
-    svn_hash_sets(cmd_hash, command->cmdname, command);
+  apr_hash_t *cmd_hash = make_command_hash(pool);
 
   /* Auto-initialize connection */
   if (! connection->conn)
-    {
-      apr_status_t ar;
-
-      /* Enable TCP keep-alives on the socket so we time out when
-       * the connection breaks due to network-layer problems.
-       * If the peer has dropped the connection due to a network partition
-       * or a crash, or if the peer no longer considers the connection
-       * valid because we are behind a NAT and our public IP has changed,
-       * it will respond to the keep-alive probe with a RST instead of an
-       * acknowledgment segment, which will cause svn to abort the session
-       * even while it is currently blocked waiting for data from the peer. */
-      ar = apr_socket_opt_set(connection->usock, APR_SO_KEEPALIVE, 1);
-      if (ar)
-        {
-          /* It's not a fatal error if we cannot enable keep-alives. */
-        }
-
-      /* create the connection, configure ports etc. */
-      connection->conn
-        = svn_ra_svn_create_conn5(connection->usock, NULL, NULL,
-                                  connection->params->compression_level,
-                                  connection->params->zero_copy_limit,
-                                  connection->params->error_check_interval,
-                                  connection->params->max_request_size,
-                                  connection->params->max_response_size,
-                                  connection->pool);
-
-      /* Construct server baton and open the repository for the first time. */
-      err = construct_server_baton(&connection->baton, connection->conn,
-                                   connection->params, pool);
-    }
+    err = init_connection(connection, pool);
 
   /* If we can't access the repo for some reason, end this connection. */
   if (err)
@@ -4529,6 +4660,45 @@ serve_interruptable(svn_boolean_t *terminate_p,
   return svn_error_trace(err);
 }
 
+svn_error_t *
+serve_pending(svn_boolean_t *terminate_p,
+              connection_t *connection,
+              apr_pool_t *pool)
+{
+  svn_boolean_t terminate = FALSE;
+  svn_boolean_t has_command = TRUE;
+  svn_error_t *err = NULL;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_hash_t *cmd_hash = make_command_hash(pool);
+
+  /* Auto-initialize connection */
+  if (! connection->conn)
+    err = init_connection(connection, pool);
+
+  /* If we can't access the repo for some reason, end this connection. */
+  if (err)
+    terminate = TRUE;
+
+  /* Execute commands for as long as the client has sent some. */
+  while (!terminate && !err && has_command)
+    {
+      svn_pool_clear(iterpool);
+
+      err = svn_ra_svn__has_command(&has_command, &terminate,
+                                    connection->conn, iterpool);
+      if (!err && !terminate && has_command)
+        err = svn_ra_svn__handle_command(&terminate, cmd_hash,
+                                         connection->baton,
+                                         connection->conn,
+                                         FALSE, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+  *terminate_p = terminate;
+
+  return svn_error_trace(err);
+}
+
 svn_error_t *serve(svn_ra_svn_conn_t *conn,
                    serve_params_t *params,
                    apr_pool_t *pool)
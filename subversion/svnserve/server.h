@@ -131,6 +131,10 @@ typedef struct serve_params_t {
      It mainly contains things like cache settings. */
   apr_hash_t *fs_config;
 
+  /* Loads and saves FSFS cache snapshots in the background; possibly
+     NULL. */
+  struct cache_snapshots_t *cache_snapshots;
+
   /* Username case normalization style. */
   enum username_case_type username_case;
 
@@ -221,6 +225,20 @@ serve_interruptable(svn_boolean_t *terminate_p,
                     svn_boolean_t (* is_busy)(connection_t *),
                     apr_pool_t *pool);
 
+/* Serve the commands that the client of CONNECTION has already sent, but
+   return as soon as there is no further input pending, i.e. when serving
+   the next command would block until the client sends it.  Set
+   *TERMINATE_P to TRUE if the connection got terminated, else to FALSE.
+
+   As with serve_interruptable(), CONNECTION->CONN may be NULL for the
+   first call.  This is used to serve connections that are otherwise
+   parked in an event loop while idle.
+ */
+svn_error_t *
+serve_pending(svn_boolean_t *terminate_p,
+              connection_t *connection,
+              apr_pool_t *pool);
+
 /* Initialize the Cyrus SASL library. POOL is used for allocations. */
 svn_error_t *cyrus_init(apr_pool_t *pool);
 
@@ -55,11 +55,13 @@
 #include "private/svn_dep_compat.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_atomic.h"
+#include "private/svn_cache.h"
 #include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
 
 #if APR_HAS_THREADS
 #    include <apr_thread_pool.h>
+#    include <apr_poll.h>
 #endif
 
 #include "winservice.h"
@@ -70,12 +72,15 @@
 
 #include "server.h"
 #include "logger.h"
+#include "cache_snapshot.h"
 
 /* The strategy for handling incoming connections.  Some of these may be
    unavailable due to platform limitations. */
 enum connection_handling_mode {
   connection_mode_fork,   /* Create a process per connection */
   connection_mode_thread, /* Create a thread per connection */
+  connection_mode_event,  /* Serve commands in threads, park idle
+                             connections in a poll set */
   connection_mode_single  /* One connection at a time in this process */
 };
 
@@ -145,6 +150,21 @@ enum run_mode {
  */
 #define THREADPOOL_THREAD_IDLE_LIMIT 1000000
 
+/* Default maximum number of connections that may be open at the same time
+ * in event mode.  Further clients are left in the listen queue until some
+ * of the open connections get closed.
+ *
+ * Idle connections only cost a file descriptor and their connection pool,
+ * so this can be much larger than THREADPOOL_MAX_SIZE.  It should not
+ * exceed the process' limit on open file descriptors, though.
+ */
+#define EVENT_MAX_CONNECTIONS 4096
+
+/* Number of microseconds after which the event loop re-checks whether it
+ * may accept new connections again while it is not doing so.
+ */
+#define EVENT_BACKPRESSURE_INTERVAL 50000
+
 /* Number of client to server connections that may concurrently in the
  * TCP 3-way handshake state, i.e. are in the process of being created.
  *
@@ -222,6 +242,10 @@ void winservice_notify_stop(void)
 #define SVNSERVE_OPT_MAX_REQUEST     274
 #define SVNSERVE_OPT_MAX_RESPONSE    275
 #define SVNSERVE_OPT_CACHE_NODEPROPS 276
+#define SVNSERVE_OPT_SHARED_CACHE    277
+#define SVNSERVE_OPT_CACHE_SNAPSHOT  278
+#define SVNSERVE_OPT_EVENT           279
+#define SVNSERVE_OPT_MAX_CONNECTIONS 280
 
 /* Text macro because we can't use #ifdef sections inside a N_("...")
    macro expansion. */
@@ -229,7 +253,7 @@ void winservice_notify_stop(void)
 #define ONLY_AVAILABLE_WITH_THEADS \
         "\n" \
         "                             "\
-        "[used only with --threads]"
+        "[used only with --threads or --event]"
 #else
 #define ONLY_AVAILABLE_WITH_THEADS ""
 #endif
@@ -325,6 +349,24 @@ static const apr_getopt_option_t svnserve__options[] =
         "Default is yes.\n"
         "                             "
         "[used for FSFS repositories only]")},
+#if APR_HAS_FORK
+    {"shared-cache", SVNSERVE_OPT_SHARED_CACHE, 0,
+     N_("share the in-memory cache between all connection\n"
+        "                             "
+        "processes instead of using one cache per process.\n"
+        "                             "
+        "[mode: daemon; only with process per connection]")},
+#endif
+    {"cache-snapshot-interval", SVNSERVE_OPT_CACHE_SNAPSHOT, 1,
+     N_("save the cache contents of each repository every\n"
+        "                             "
+        "ARG seconds and reload them after a restart.\n"
+        "                             "
+        "Default is 0 (disabled).\n"
+        "                             "
+        "[used for FSFS repositories only; ignored when\n"
+        "                             "
+        " not using threads]")},
     {"client-speed", SVNSERVE_OPT_CLIENT_SPEED, 1,
      N_("Optimize network handling based on the assumption\n"
         "                             "
@@ -362,6 +404,26 @@ static const apr_getopt_option_t svnserve__options[] =
         "                             "
         "Default is " APR_STRINGIFY(THREADPOOL_MAX_SIZE) "."
         ONLY_AVAILABLE_WITH_THEADS)},
+    {"event",            SVNSERVE_OPT_EVENT, 0,
+     N_("serve commands in a pool of threads and wait for\n"
+        "                             "
+        "the next command of idle connections in a single\n"
+        "                             "
+        "event loop.  Scales to many mostly idle clients.\n"
+        "                             "
+        "Uses --min-threads and --max-threads.\n"
+        "                             "
+        "[mode: daemon]")},
+    {"max-connections",  SVNSERVE_OPT_MAX_CONNECTIONS, 1,
+     N_("Maximum number of open client connections.\n"
+        "                             "
+        "Further clients have to wait until some of the\n"
+        "                             "
+        "open connections get closed.  Minimum value is 1.\n"
+        "                             "
+        "Default is " APR_STRINGIFY(EVENT_MAX_CONNECTIONS) ".\n"
+        "                             "
+        "[used only with --event]")},
 #endif
     {"max-request-size", SVNSERVE_OPT_MAX_REQUEST, 1,
      N_("Maximum acceptable size of a client request in MB.\n"
@@ -656,6 +718,169 @@ static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
   return NULL;
 }
 
+/* In event mode, the poll set that contains all idle connections, i.e.
+   those that wait for their client to send the next command.  It also
+   contains the listening socket while we accept new connections. */
+static apr_pollset_t *idle_connections;
+
+/* Number of connections that are currently open in event mode. */
+static volatile svn_atomic_t open_connections = 0;
+
+/* Add CONNECTION to IDLE_CONNECTIONS, such that serve_events() will
+   hand it to a worker thread once the next command comes in. */
+static apr_status_t
+park_connection(connection_t *connection)
+{
+  apr_pollfd_t pfd = { 0 };
+
+  pfd.p = connection->pool;
+  pfd.desc_type = APR_POLL_SOCKET;
+  pfd.reqevents = APR_POLLIN;
+  pfd.desc.s = connection->usock;
+  pfd.client_data = connection;
+
+  return apr_pollset_add(idle_connections, &pfd);
+}
+
+/* Serve all commands that have been sent over the connection given by
+   DATA and park the connection in IDLE_CONNECTIONS afterwards.  Close the
+   connection instead, if it got terminated. */
+static void * APR_THREAD_FUNC serve_event_thread(apr_thread_t *tid,
+                                                 void *data)
+{
+  svn_boolean_t done;
+  connection_t *connection = data;
+  svn_error_t *err;
+
+  apr_pool_t *pool = svn_root_pools__acquire_pool(connection_pools);
+
+  /* process the actual requests and log errors */
+  err = serve_pending(&done, connection, pool);
+  if (err)
+    {
+      logger__log_error(connection->params->logger, err, NULL,
+                        get_client_info(connection->conn, connection->params,
+                                        pool));
+      svn_error_clear(err);
+      done = TRUE;
+    }
+  svn_root_pools__release_pool(pool, connection_pools);
+
+  /* Wait for the next command or close the connection.  Once parked,
+     the connection may already be served by another thread. */
+  if (!done && park_connection(connection))
+    done = TRUE;
+
+  if (done)
+    {
+      close_connection(connection);
+      svn_atomic_dec(&open_connections);
+    }
+
+  return NULL;
+}
+
+/* Accept connections on SOCK with PARAMS and serve them in event mode,
+   i.e. use the worker threads only while there are commands to execute.
+   Have at most MAX_CONNECTIONS open at any time.
+
+   When a connection becomes idle, it gets parked in IDLE_CONNECTIONS.
+   This function waits for activity on all of them and on SOCK, accepts
+   new connections and hands connections with incoming commands to the
+   worker threads.
+
+   New clients are not accepted while there are MAX_CONNECTIONS open
+   or while there are more commands waiting for a worker thread than
+   there are threads.  They then remain in SOCK's listen queue.
+
+   Use POOL for allocations.  This function only returns on error.
+ */
+static svn_error_t *
+serve_events(apr_socket_t *sock,
+             serve_params_t *params,
+             apr_size_t max_connections,
+             apr_pool_t *pool)
+{
+  apr_pollfd_t listener = { 0 };
+  svn_boolean_t accepting = FALSE;
+  apr_status_t status;
+
+  if (max_connections < 1)
+    max_connections = 1;
+
+  /* Worker threads park their connections while we are polling. */
+  status = apr_pollset_create(&idle_connections,
+                              (apr_uint32_t)max_connections + 1, pool,
+                              APR_POLLSET_THREADSAFE);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create poll set"));
+
+  listener.p = pool;
+  listener.desc_type = APR_POLL_SOCKET;
+  listener.reqevents = APR_POLLIN;
+  listener.desc.s = sock;
+  listener.client_data = NULL;
+
+  while (1)
+    {
+      const apr_pollfd_t *results;
+      apr_int32_t count;
+      apr_int32_t i;
+
+      /* Apply back pressure to new clients if we are at our limits. */
+      svn_boolean_t may_accept
+        =    (apr_size_t)svn_atomic_read(&open_connections) < max_connections
+          && apr_thread_pool_tasks_count(threads)
+               <= apr_thread_pool_thread_max_get(threads);
+
+      status = APR_SUCCESS;
+      if (may_accept && !accepting)
+        status = apr_pollset_add(idle_connections, &listener);
+      else if (!may_accept && accepting)
+        status = apr_pollset_remove(idle_connections, &listener);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't update poll set"));
+      accepting = may_accept;
+
+      /* The limits above may only change in our favor while we wait. */
+      status = apr_pollset_poll(idle_connections,
+                                accepting ? -1 : EVENT_BACKPRESSURE_INTERVAL,
+                                &count, &results);
+      if (APR_STATUS_IS_EINTR(status) || APR_STATUS_IS_TIMEUP(status))
+        continue;
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't poll connections"));
+
+      for (i = 0; i < count; ++i)
+        {
+          connection_t *connection = results[i].client_data;
+
+          if (connection)
+            {
+              /* The client sent a command or closed the connection.
+                 Don't watch the connection while a worker serves it. */
+              status = apr_pollset_remove(idle_connections, &results[i]);
+              if (status)
+                return svn_error_wrap_apr(status,
+                                          _("Can't update poll set"));
+            }
+          else
+            {
+              SVN_ERR(accept_connection(&connection, sock, params,
+                                        connection_mode_event, pool));
+              svn_atomic_inc(&open_connections);
+            }
+
+          status = apr_thread_pool_push(threads, serve_event_thread,
+                                        connection, 0, NULL);
+          if (status)
+            return svn_error_wrap_apr(status, _("Can't push task"));
+        }
+    }
+
+  /* NOTREACHED */
+}
+
 #endif
 
 /* Write the PID of the current process as a decimal number, followed by a
@@ -725,6 +950,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   svn_boolean_t cache_txdeltas = TRUE;
   svn_boolean_t cache_revprops = FALSE;
   svn_boolean_t use_block_read = FALSE;
+  svn_boolean_t shared_cache = FALSE;
+  apr_int64_t cache_snapshot_interval = 0;
   apr_uint16_t port = SVN_RA_SVN_PORT;
   const char *host = NULL;
   int family = APR_INET;
@@ -742,6 +969,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   svn_node_kind_t kind;
   apr_size_t min_thread_count = THREADPOOL_MIN_SIZE;
   apr_size_t max_thread_count = THREADPOOL_MAX_SIZE;
+  apr_size_t max_connections = EVENT_MAX_CONNECTIONS;
 #ifdef SVN_HAVE_SASL
   SVN_ERR(cyrus_init(pool));
 #endif
@@ -767,6 +995,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   params.logger = NULL;
   params.config_pool = NULL;
   params.fs_config = NULL;
+  params.cache_snapshots = NULL;
   params.vhost = FALSE;
   params.username_case = CASE_ASIS;
   params.memory_cache_size = (apr_uint64_t)-1;
@@ -892,6 +1121,11 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           handling_opt_count++;
           break;
 
+        case SVNSERVE_OPT_EVENT:
+          handling_mode = connection_mode_event;
+          handling_opt_count++;
+          break;
+
         case 'c':
           params.compression_level = atoi(arg);
           if (params.compression_level < SVN_DELTA_COMPRESSION_LEVEL_NONE)
@@ -929,6 +1163,14 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           use_block_read = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
 
+        case SVNSERVE_OPT_SHARED_CACHE:
+          shared_cache = TRUE;
+          break;
+
+        case SVNSERVE_OPT_CACHE_SNAPSHOT:
+          SVN_ERR(svn_cstring_atoi64(&cache_snapshot_interval, arg));
+          break;
+
         case SVNSERVE_OPT_CLIENT_SPEED:
           {
             apr_size_t bandwidth = (apr_size_t)apr_strtoi64(arg, NULL, 0);
@@ -962,6 +1204,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           max_thread_count = (apr_size_t)apr_strtoi64(arg, NULL, 0);
           break;
 
+        case SVNSERVE_OPT_MAX_CONNECTIONS:
+          max_connections = (apr_size_t)apr_strtoi64(arg, NULL, 0);
+          break;
+
 #ifdef WIN32
         case SVNSERVE_OPT_SERVICE:
           if (run_mode != run_mode_service)
@@ -1029,7 +1275,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   if (handling_opt_count > 1)
     {
       svn_error_clear(svn_cmdline_fputs(
-                      _("You may only specify one of -T or --single-thread\n"),
+                      _("You may only specify one of -T, --event or "
+                        "--single-thread\n"),
                       stderr, pool));
       usage(argv[0], pool);
       *exit_code = EXIT_FAILURE;
@@ -1037,7 +1284,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     }
 
   /* construct object pools */
-  is_multi_threaded = handling_mode == connection_mode_thread;
+  is_multi_threaded = handling_mode == connection_mode_thread
+                   || handling_mode == connection_mode_event;
   params.fs_config = apr_hash_make(pool);
   svn_hash_sets(params.fs_config, SVN_FS_CONFIG_FSFS_CACHE_DELTAS,
                 cache_txdeltas ? "1" :"0");
@@ -1079,6 +1327,15 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
                _("Option --tunnel-user is only valid in tunnel mode"));
     }
 
+  if (shared_cache
+      && (run_mode != run_mode_daemon
+          || handling_mode != connection_mode_fork))
+    {
+      return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+               _("Option --shared-cache is only valid in daemon mode "
+                 "with one process per connection"));
+    }
+
   if (run_mode == run_mode_inetd || run_mode == run_mode_tunnel)
     {
       apr_pool_t *connection_pool;
@@ -1280,7 +1537,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       settings.cache_size = params.memory_cache_size;
 
     settings.single_threaded = TRUE;
-    if (handling_mode == connection_mode_thread)
+    if (is_multi_threaded)
       {
 #if APR_HAS_THREADS
         settings.single_threaded = FALSE;
@@ -1295,12 +1552,17 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       }
 
     svn_cache_config_set(&settings);
+
+    /* All connection processes may use the same cache.  It must be
+     * created before we fork the first one. */
+    if (shared_cache)
+      SVN_ERR(svn_cache__create_shared_global_membuffer_cache());
   }
 
 #if APR_HAS_THREADS
   SVN_ERR(svn_root_pools__create(&connection_pools));
 
-  if (handling_mode == connection_mode_thread)
+  if (is_multi_threaded)
     {
       /* create the thread pool with a valid range of threads */
       if (max_thread_count < 1)
@@ -1330,6 +1592,23 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     }
 #endif
 
+  /* A background thread loads and saves the cache snapshots, so that
+   * connections never wait for them.  It shares the caches with the
+   * connection threads and is only useful for long-running servers. */
+  if (cache_snapshot_interval > 0 && is_multi_threaded
+      && run_mode != run_mode_listen_once)
+    SVN_ERR(cache_snapshots__create(&params.cache_snapshots,
+                                    cache_snapshot_interval,
+                                    params.fs_config, params.logger,
+                                    pool));
+
+#if APR_HAS_THREADS
+  if (handling_mode == connection_mode_event
+      && run_mode != run_mode_listen_once)
+    return svn_error_trace(serve_events(sock, &params, max_connections,
+                                        pool));
+#endif
+
   while (1)
     {
       connection_t *connection = NULL;
@@ -1382,6 +1661,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 #endif
           break;
 
+        case connection_mode_event:
+          /* Handled by serve_events() above. */
+          break;
+
         case connection_mode_single:
           /* Serve one connection at a time. */
           /* serve_socket() logs any error it returns, so ignore it. */
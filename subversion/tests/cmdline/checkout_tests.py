@@ -1042,6 +1042,96 @@ def co_with_obstructing_local_adds(sbox):
     })
   svntest.actions.run_and_verify_status(wc_dir, expected_status)
 
+#----------------------------------------------------------------------
+def checkout_without_pristines(sbox):
+  "checkout without a pristine store"
+
+  sbox.build(create_wc = False, read_only = True)
+  wc_dir = sbox.wc_dir
+
+  expected_output = svntest.main.greek_state.copy()
+  expected_output.wc_dir = wc_dir
+  expected_output.tweak(status='A ', contents=None)
+
+  expected_wc = svntest.main.greek_state.copy()
+
+  svntest.actions.run_and_verify_checkout(sbox.repo_url, wc_dir,
+                                          expected_output, expected_wc,
+                                          [], '--store-pristine=no')
+
+  def count_pristines():
+    pristine_dir = os.path.join(wc_dir, svntest.main.get_admin_name(),
+                                'pristine')
+    count = 0
+    for root, dirs, files in os.walk(pristine_dir):
+      count += len(files)
+    return count
+
+  # The working files are the only copies of the checked out texts.
+  if count_pristines() != 0:
+    raise svntest.Failure("Unexpected pristine texts after checkout")
+
+  # A local modification is diffed against a pristine text that is
+  # fetched from the repository on demand.
+  sbox.simple_append('A/mu', 'appended mu text\n')
+  svntest.actions.run_and_verify_svn(
+    svntest.verify.RegexOutput(r'^\+appended mu text$', match_all=False),
+    [], 'diff', sbox.ospath('A/mu'))
+
+  # Reverting restores the pristine text, which is then dropped again.
+  sbox.simple_revert('A/mu')
+  expected_status = svntest.actions.get_virginal_state(wc_dir, 1)
+  svntest.actions.run_and_verify_status(wc_dir, expected_status)
+  svntest.actions.verify_disk(wc_dir, expected_wc)
+  if count_pristines() != 0:
+    raise svntest.Failure("Unexpected pristine texts after revert")
+
+  # The invalid values are rejected.
+  svntest.actions.run_and_verify_svn(None, '.*not a valid --store-pristine',
+                                     'checkout', '--store-pristine=maybe',
+                                     sbox.repo_url,
+                                     sbox.add_wc_path('invalid'))
+
+#----------------------------------------------------------------------
+def update_props_without_pristines(sbox):
+  "prop-only update without a pristine store"
+
+  sbox.build()
+  wc_dir = sbox.wc_dir
+
+  sbox.simple_append('iota', '$Revision$\n')
+  sbox.simple_commit(message='Add a keyword')
+
+  # The pristine texts of this working copy are moved into place.
+  other_wc = sbox.add_wc_path('other')
+  svntest.actions.run_and_verify_svn(None, [], 'checkout',
+                                     '--store-pristine=no',
+                                     sbox.repo_url, other_wc)
+
+  # Change the translation of the unmodified files, which have to be
+  # reinstalled from their pristine texts.
+  sbox.simple_propset('svn:eol-style', 'CRLF', 'A/mu')
+  sbox.simple_propset('svn:keywords', 'Revision', 'iota')
+  sbox.simple_commit(message='Change translation')
+
+  expected_output = svntest.wc.State(other_wc, {
+    'A/mu' : Item(status=' U'),
+    'iota' : Item(status=' U'),
+    })
+
+  expected_disk = svntest.main.greek_state.copy()
+  expected_disk.tweak('A/mu', contents="This is the file 'mu'.\r\n")
+  expected_disk.tweak('iota', contents="This is the file 'iota'.\n"
+                                       "$Revision: 3 $\n")
+
+  expected_status = svntest.actions.get_virginal_state(other_wc, 3)
+
+  svntest.actions.run_and_verify_update2(other_wc,
+                                         expected_output,
+                                         expected_disk,
+                                         expected_status,
+                                         keep_eol_style=True)
+
 #----------------------------------------------------------------------
 # Test if checking out from a Windows driveroot is supported.
 @SkipUnless(svntest.main.is_os_windows)
@@ -1202,7 +1292,9 @@ test_list = [ None,
               checkout_peg_rev,
               checkout_peg_rev_date,
               co_with_obstructing_local_adds,
-              checkout_wc_from_drive
+              checkout_wc_from_drive,
+              checkout_without_pristines,
+              update_props_without_pristines,
             ]
 
 if __name__ == "__main__":
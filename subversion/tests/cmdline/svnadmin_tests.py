@@ -2909,6 +2909,50 @@ def verify_quickly(sbox):
   svntest.main.safe_rmtree(sbox.repo_dir, True)
 
 
+@SkipUnless(svntest.main.is_fs_log_addressing)
+def verify_incrementally(sbox):
+  "svnadmin verify --incremental"
+
+  # Packing changes the units that get recorded.
+  if svntest.main.options.fsfs_packing:
+    raise svntest.Skip('fsfs packing set')
+
+  sbox.build(create_wc=False)
+  sbox.simple_repo_copy('A', 'B')
+
+  def verify(expected_lines, unexpected_lines):
+    exit_code, output, errput = svntest.main.run_svnadmin("verify",
+                                                          "--incremental",
+                                                          sbox.repo_dir)
+    if errput:
+      raise svntest.main.SVNUnexpectedStderr(errput)
+    for line in expected_lines:
+      if line not in output:
+        raise svntest.Failure("Expected '%s' in output" % line.rstrip())
+    for line in unexpected_lines:
+      if line in output:
+        raise svntest.Failure("Unexpected '%s' in output" % line.rstrip())
+
+  # The first run verifies and records everything.
+  verify(['* Verified revision 2.\n'],
+         ['* Skipped revisions 0 to 2, verified before.\n'])
+
+  # The second run skips all revisions, including the per-revision checks.
+  verify(['* Skipped revisions 0 to 2, verified before.\n'],
+         ['* Verified revision 0.\n', '* Verified revision 2.\n'])
+
+  # New revisions get verified, old ones still skipped.
+  sbox.simple_repo_copy('A', 'C')
+  verify(['* Skipped revisions 0 to 2, verified before.\n',
+          '* Verified revision 3.\n'],
+         ['* Verified revision 2.\n'])
+
+  # Compaction keeps one record per revision.
+  checkpoints = open(os.path.join(sbox.repo_dir, 'db', 'verify-checkpoints'))
+  if len(checkpoints.readlines()) != 4:
+    raise svntest.Failure("Verification checkpoints not compacted")
+  checkpoints.close()
+
 @SkipUnless(svntest.main.is_fs_type_fsfs)
 @SkipUnless(svntest.main.fs_has_pack)
 def fsfs_hotcopy_progress(sbox):
@@ -4108,6 +4152,7 @@ test_list = [ None,
               freeze_freeze,
               verify_metadata_only,
               verify_quickly,
+              verify_incrementally,
               fsfs_hotcopy_progress,
               fsfs_hotcopy_progress_with_revprop_changes,
               fsfs_hotcopy_progress_old,
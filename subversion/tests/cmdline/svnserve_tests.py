@@ -0,0 +1,310 @@
+#!/usr/bin/env python
+#
+#  svnserve_tests.py:  testing the svnserve connection handling by talking
+#                      the ra_svn protocol to it directly.
+#
+#  Subversion is a tool for revision control.
+#  See http://subversion.apache.org for more information.
+#
+# ====================================================================
+#    Licensed to the Apache Software Foundation (ASF) under one
+#    or more contributor license agreements.  See the NOTICE file
+#    distributed with this work for additional information
+#    regarding copyright ownership.  The ASF licenses this file
+#    to you under the Apache License, Version 2.0 (the
+#    "License"); you may not use this file except in compliance
+#    with the License.  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing,
+#    software distributed under the License is distributed on an
+#    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+#    KIND, either express or implied.  See the License for the
+#    specific language governing permissions and limitations
+#    under the License.
+######################################################################
+
+# These tests only run against svnserve.  They work with every connection
+# handling mode but are most interesting for event mode, where idle
+# connections get parked in a poll set between commands:
+#
+#   make svnserveautocheck EVENT=1 TESTS=subversion/tests/cmdline/svnserve_tests.py
+
+# General modules
+import re, socket, struct
+
+# Our testing module
+import svntest
+
+# (abbreviation)
+Skip = svntest.testcase.Skip_deco
+SkipUnless = svntest.testcase.SkipUnless_deco
+XFail = svntest.testcase.XFail_deco
+Issues = svntest.testcase.Issues_deco
+Issue = svntest.testcase.Issue_deco
+Wimp = svntest.testcase.Wimp_deco
+
+######################################################################
+# Helper routines
+
+def is_ra_svn_without_sasl():
+  """Return True iff running tests over ra_svn with the built-in
+     authentication, i.e. anonymous access does not go through SASL."""
+  return svntest.main.is_ra_type_svn() and not svntest.main.options.enable_sasl
+
+def encode_string(value):
+  """Return VALUE encoded as an ra_svn string item."""
+  if not isinstance(value, bytes):
+    value = value.encode('utf-8')
+  return str(len(value)).encode('ascii') + b':' + value
+
+class RaSvnConnection:
+  """A minimal ra_svn client on top of a plain socket.  Unlike the svn
+     client, it lets a test control exactly which bytes get sent when.
+
+     Items read from the server are returned as Python values: lists as
+     lists, numbers as ints, strings as bytes and words as str."""
+
+  def __init__(self, url):
+    match = re.match(r'svn://([^/:]+)(?::(\d+))?', url)
+    self.url = url
+    self.sock = socket.create_connection((match.group(1),
+                                          int(match.group(2) or 3690)),
+                                         60)
+    self.buffer = b''
+
+  def send(self, data):
+    self.sock.sendall(data)
+
+  def close(self, reset=False):
+    """Close the connection.  If RESET is set, make the OS send a TCP RST
+       instead of a regular shutdown."""
+    if reset:
+      self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER,
+                           struct.pack('ii', 1, 0))
+    self.sock.close()
+
+  def _peek(self):
+    "Return the next byte without consuming it."
+    if not self.buffer:
+      data = self.sock.recv(4096)
+      if not data:
+        raise svntest.Failure('svnserve closed the connection')
+      self.buffer = data
+    return self.buffer[0:1]
+
+  def _take(self, count):
+    "Consume COUNT bytes and return them."
+    while len(self.buffer) < count:
+      data = self.sock.recv(4096)
+      if not data:
+        raise svntest.Failure('svnserve closed the connection')
+      self.buffer += data
+    result = self.buffer[:count]
+    self.buffer = self.buffer[count:]
+    return result
+
+  def read_item(self):
+    "Read the next item sent by the server."
+    while self._peek() in (b' ', b'\n'):
+      self._take(1)
+
+    first = self._take(1)
+    if first == b'(':
+      items = []
+      while True:
+        while self._peek() in (b' ', b'\n'):
+          self._take(1)
+        if self._peek() == b')':
+          self._take(1)
+          return items
+        items.append(self.read_item())
+
+    token = first
+    while self._peek().isalnum() or self._peek() == b'-':
+      token += self._take(1)
+
+    if token.isdigit():
+      if self._peek() == b':':
+        self._take(1)
+        return self._take(int(token))
+      return int(token)
+
+    if not token[0:1].isalpha():
+      raise svntest.Failure('Malformed ra_svn data: %r' % token)
+    return token.decode('ascii')
+
+  def read_response(self):
+    """Read the response to a command, skipping the trivial auth request
+       that svnserve sends ahead of the responses to most commands."""
+    response = self.read_item()
+    if response == ['success', [[], b'']]:
+      response = self.read_item()
+    return response
+
+  def handshake(self):
+    """Run the greeting and the anonymous authentication.  Return the
+       repos-info response."""
+    greeting = self.read_item()
+    if greeting[0] != 'success':
+      raise svntest.Failure('Unexpected greeting: %r' % greeting)
+
+    self.send(b'( 2 ( edit-pipeline ) ' + encode_string(self.url)
+              + b' 13:svnserve-test ( ) ) ')
+
+    auth_request = self.read_item()
+    if auth_request[0] != 'success':
+      raise svntest.Failure('Unexpected auth request: %r' % auth_request)
+    if auth_request[1][0]:
+      if 'ANONYMOUS' not in auth_request[1][0]:
+        raise svntest.Failure('Anonymous access not offered: %r'
+                              % auth_request)
+      self.send(b'( ANONYMOUS ( 0: ) ) ')
+      auth_result = self.read_item()
+      if auth_result[0] != 'success':
+        raise svntest.Failure('Anonymous access denied: %r' % auth_result)
+
+    repos_info = self.read_item()
+    if repos_info[0] != 'success':
+      raise svntest.Failure('Unexpected repos-info: %r' % repos_info)
+    return repos_info
+
+  def verify_latest_rev(self, expected_rev):
+    """Run get-latest-rev and verify that it returns EXPECTED_REV."""
+    self.send(b'( get-latest-rev ( ) ) ')
+    response = self.read_response()
+    if response != ['success', [expected_rev]]:
+      raise svntest.Failure('Unexpected get-latest-rev response: %r'
+                            % response)
+
+######################################################################
+# Tests
+#
+#   Each test must return on success or raise on failure.
+
+
+#----------------------------------------------------------------------
+
+@SkipUnless(is_ra_svn_without_sasl)
+def pipelined_commands(sbox):
+  "serve commands sent in one go"
+
+  sbox.build(create_wc=False, read_only=True)
+
+  conn = RaSvnConnection(sbox.repo_url)
+  conn.handshake()
+
+  # Send a batch of commands, including a broken one, in a single write.
+  # The server must answer all of them in order without waiting for more
+  # input in between.
+  conn.send(b'( get-latest-rev ( ) ) '
+            b'( get-latest-rev ( ) ) '
+            b'( no-such-command ( ) ) '
+            b'( get-latest-rev ( ) ) ')
+
+  for expected in (['success', [1]],
+                   ['success', [1]],
+                   None,
+                   ['success', [1]]):
+    response = conn.read_response()
+    if expected is None:
+      if response[0] != 'failure':
+        raise svntest.Failure('Unknown command not rejected: %r'
+                              % response)
+    elif response != expected:
+      raise svntest.Failure('Unexpected response: %r' % response)
+
+  # Split a command across two writes.  The server must wait for the rest.
+  conn.send(b'( get-latest-')
+  conn.send(b'rev ( ) ) ')
+  if conn.read_response() != ['success', [1]]:
+    raise svntest.Failure('Split command not served')
+
+  conn.close()
+
+@SkipUnless(is_ra_svn_without_sasl)
+def many_idle_connections(sbox):
+  "serve many idle connections"
+
+  sbox.build(create_wc=False, read_only=True)
+
+  # Open more connections than we need worker threads for, let all of them
+  # go idle and then wake them in the reverse order.
+  connections = []
+  for i in range(40):
+    conn = RaSvnConnection(sbox.repo_url)
+    conn.handshake()
+    connections.append(conn)
+
+  for conn in reversed(connections):
+    conn.verify_latest_rev(1)
+
+  # Commands on several connections at once.
+  for conn in connections:
+    conn.send(b'( get-latest-rev ( ) ) ( get-latest-rev ( ) ) ')
+  for conn in connections:
+    for i in range(2):
+      if conn.read_response() != ['success', [1]]:
+        raise svntest.Failure('Concurrent command not served')
+
+  for conn in connections:
+    conn.close()
+
+@SkipUnless(is_ra_svn_without_sasl)
+def disconnect_while_parked(sbox):
+  "clients disconnecting while idle"
+
+  sbox.build(create_wc=False, read_only=True)
+
+  # This one stays idle across all disconnects.
+  survivor = RaSvnConnection(sbox.repo_url)
+  survivor.handshake()
+
+  for i in range(30):
+    conn = RaSvnConnection(sbox.repo_url)
+    variant = i % 5
+
+    # Disconnect during the handshake.
+    if variant == 0:
+      conn.close()
+      continue
+    if variant == 1:
+      conn.read_item()
+      conn.close()
+      continue
+
+    conn.handshake()
+    conn.verify_latest_rev(1)
+
+    # Disconnect with an incomplete command pending.
+    if variant == 3:
+      conn.send(b'( get-latest-rev ')
+
+    # Reset the connection instead of shutting it down.
+    conn.close(variant == 4 and not svntest.main.is_os_windows())
+
+  # Both, the idle connection and new clients must still be served.
+  survivor.verify_latest_rev(1)
+  survivor.close()
+
+  svntest.actions.run_and_verify_svn(None, [], 'info', sbox.repo_url)
+
+
+########################################################################
+# Run the tests
+
+
+# list all tests here, starting with None:
+test_list = [ None,
+              pipelined_commands,
+              many_idle_connections,
+              disconnect_while_parked,
+             ]
+
+if __name__ == '__main__':
+  svntest.main.run_tests(test_list)
+  # NOTREACHED
+
+
+### End of file.
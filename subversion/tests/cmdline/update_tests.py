@@ -6897,6 +6897,137 @@ def update_keeps_unversioned_items_in_deleted_dir(sbox):
                                         expected_status,
                                         [], True)
 
+@SkipUnless(svntest.main.is_ra_type_svn)
+def update_fetch_texts_switched(sbox):
+  "fetch texts of files added below a switch"
+
+  sbox.build()
+  wc_dir = sbox.wc_dir
+
+  sbox.simple_repo_copy('A/D/G', 'A/G2')
+  sbox.simple_update()
+  sbox.simple_switch(sbox.repo_url + '/A/G2', 'A/D/G')
+
+  # Add files with the same names but different contents to both trees,
+  # more than fit on the fetch connections at once.
+  new_file = sbox.get_tempname()
+  other_file = sbox.get_tempname()
+  svntest.main.file_write(new_file, "This is a new file in G2.\n")
+  svntest.main.file_write(other_file, "This is a new file in G.\n")
+  mucc_args = []
+  for i in range(10):
+    mucc_args += ['put', new_file, 'A/G2/new%d' % i,
+                  'put', other_file, 'A/D/G/new%d' % i]
+  svntest.actions.run_and_verify_svnmucc(None, [],
+                                         '-U', sbox.repo_url, '-m', 'r3',
+                                         *mucc_args)
+
+  expected_output = svntest.wc.State(wc_dir, {})
+  expected_disk = svntest.main.greek_state.copy()
+  expected_disk.add({
+    'A/G2'     : Item(),
+    'A/G2/pi'  : Item("This is the file 'pi'.\n"),
+    'A/G2/rho' : Item("This is the file 'rho'.\n"),
+    'A/G2/tau' : Item("This is the file 'tau'.\n"),
+    })
+  expected_status = svntest.actions.get_virginal_state(wc_dir, 3)
+  expected_status.add({
+    'A/G2'     : Item(status='  ', wc_rev=3),
+    'A/G2/pi'  : Item(status='  ', wc_rev=3),
+    'A/G2/rho' : Item(status='  ', wc_rev=3),
+    'A/G2/tau' : Item(status='  ', wc_rev=3),
+    })
+  expected_status.tweak('A/D/G', switched='S')
+  for i in range(10):
+    expected_output.add({
+      'A/G2/new%d' % i  : Item(status='A '),
+      'A/D/G/new%d' % i : Item(status='A '),
+      })
+    expected_disk.add({
+      'A/G2/new%d' % i  : Item("This is a new file in G2.\n"),
+      'A/D/G/new%d' % i : Item("This is a new file in G2.\n"),
+      })
+    expected_status.add({
+      'A/G2/new%d' % i  : Item(status='  ', wc_rev=3),
+      'A/D/G/new%d' % i : Item(status='  ', wc_rev=3),
+      })
+
+  svntest.actions.run_and_verify_update(wc_dir,
+                                        expected_output,
+                                        expected_disk,
+                                        expected_status)
+
+@SkipUnless(svntest.main.is_ra_type_svn)
+def update_fetch_texts_file_target(sbox):
+  "fetch the text of an update target"
+
+  sbox.build()
+  wc_dir = sbox.wc_dir
+
+  sbox.simple_update('A/mu', revision='0')
+
+  expected_output = svntest.wc.State(wc_dir, {
+    'A/mu' : Item(status='A '),
+    })
+  expected_disk = svntest.main.greek_state.copy()
+  expected_status = svntest.actions.get_virginal_state(wc_dir, 1)
+
+  svntest.actions.run_and_verify_update(wc_dir,
+                                        expected_output,
+                                        expected_disk,
+                                        expected_status,
+                                        [], False,
+                                        sbox.ospath('A/mu'))
+
+@SkipUnless(svntest.main.is_ra_type_svn)
+@SkipUnless(svntest.main.is_fs_type_fsfs)
+def update_fetch_texts_error(sbox):
+  "failing to fetch a text aborts the update"
+
+  sbox.build()
+  wc_dir = sbox.wc_dir
+
+  # Store texts uncompressed, so that we can find them in the rev file.
+  fsfs_conf = svntest.main.get_fsfs_conf_file_path(sbox.repo_dir)
+  lines = open(fsfs_conf).readlines()
+  with open(fsfs_conf, 'w') as f:
+    for line in lines:
+      if line.startswith('# compression '):
+        line = 'compression = none\n'
+      f.write(line)
+
+  # Commit directly to the repository, so that svnserve has nothing cached.
+  new_file = sbox.get_tempname()
+  svntest.main.file_write(new_file, "Fetch-texts marker text.\n")
+  svntest.actions.run_and_verify_svnmucc(None, [],
+                                         '-U', sbox.file_protocol_repo_url(),
+                                         '-m', 'r2',
+                                         'put', new_file, 'A/new')
+
+  # Corrupt the text of the new file.
+  corrupted = False
+  for root, dirs, files in os.walk(os.path.join(sbox.repo_dir, 'db', 'revs')):
+    for name in files:
+      path = os.path.join(root, name)
+      contents = open(path, 'rb').read()
+      if b'Fetch-texts marker text.' in contents:
+        contents = contents.replace(b'Fetch-texts marker text.',
+                                    b'Fetch-texts broken text.')
+        open(path, 'wb').write(contents)
+        corrupted = True
+  if not corrupted:
+    raise svntest.Failure("Text of 'A/new' not found in the repository")
+
+  # The server sends the edit, but the text of the new file can't be
+  # fetched.  That must fail the update instead of adding the file.
+  svntest.actions.run_and_verify_svn(None, svntest.verify.AnyOutput,
+                                     'update', wc_dir)
+  if os.path.exists(sbox.ospath('A/new')):
+    raise svntest.Failure("Unexpected file 'A/new'")
+
+  # Don't leave a corrupt repository
+  svntest.main.safe_rmtree(sbox.repo_dir, True)
+
 #######################################################################
 # Run the tests
 
@@ -6989,6 +7120,9 @@ test_list = [ None,
               update_delete_switched,
               update_add_missing_local_add,
               update_keeps_unversioned_items_in_deleted_dir,
+              update_fetch_texts_switched,
+              update_fetch_texts_file_target,
+              update_fetch_texts_error,
              ]
 
 if __name__ == '__main__':
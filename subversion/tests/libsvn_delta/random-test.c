@@ -36,6 +36,9 @@
 #include "svn_delta.h"
 #include "svn_pools.h"
 #include "svn_error.h"
+#include "svn_string.h"
+#include "private/svn_delta_private.h"
+#include "private/svn_string_private.h"
 
 #include "../../libsvn_delta/delta.h"
 #include "delta-window-test.h"
@@ -569,7 +572,7 @@ do_random_txdelta_to_svndiff_stream_test(apr_pool_t *pool,
                    svn_stream_from_aprfile2(source, TRUE, iterpool),
                    svn_stream_from_aprfile2(target, TRUE, iterpool),
                    FALSE, iterpool);
-      delta_stream = svn_txdelta_to_svndiff_stream(txstream, i % 3, i % 10,
+      delta_stream = svn_txdelta_to_svndiff_stream(txstream, i % 4, i % 10,
                                                    iterpool);
 
       /* Apply it to a copy of the source file to see if we get the
@@ -605,6 +608,303 @@ random_txdelta_to_svndiff_stream_test(apr_pool_t *pool)
   return err;
 }
 
+/* Size of the source text used by the xdelta benchmark. */
+#define BENCHMARK_SIZE (4 * 1024 * 1024)
+
+/* Number of times each benchmark workload gets deltified. */
+#define BENCHMARK_ROUNDS 10
+
+/* Fill BUFFER with LEN bytes of source-code-like pseudo-random text.
+ * Use and update *SEED.
+ */
+static void
+generate_text(char *buffer, apr_size_t len, apr_uint32_t *seed)
+{
+  static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz_(){};= \n";
+  apr_size_t i;
+
+  for (i = 0; i < len; ++i)
+    buffer[i] = alphabet[svn_test_rand(seed) % (sizeof(alphabet) - 1)];
+}
+
+/* Deltify TARGET against SOURCE BENCHMARK_ROUNDS times, print the
+ * throughput in MB/s of target data under the given workload NAME.
+ * Use POOL for temporary allocations.
+ */
+static svn_error_t *
+run_delta_benchmark(const char *name,
+                    const svn_string_t *source,
+                    const svn_string_t *target,
+                    apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_time_t start = apr_time_now();
+  apr_time_t duration;
+  apr_size_t ops = 0;
+  int i;
+
+  for (i = 0; i < BENCHMARK_ROUNDS; ++i)
+    {
+      svn_txdelta_stream_t *stream;
+      svn_txdelta_window_t *window;
+
+      svn_pool_clear(iterpool);
+      svn_txdelta2(&stream,
+                   svn_stream_from_string(source, iterpool),
+                   svn_stream_from_string(target, iterpool),
+                   FALSE, iterpool);
+      do
+        {
+          SVN_ERR(svn_txdelta_next_window(&window, stream, iterpool));
+          if (window)
+            ops += window->num_ops;
+        }
+      while (window);
+    }
+
+  duration = apr_time_now() - start;
+  printf("%-8s %8.1f MB/s  (%lu ops per round)\n", name,
+         (double)target->len * BENCHMARK_ROUNDS
+           / (duration ? duration : 1),
+         (unsigned long)(ops / BENCHMARK_ROUNDS));
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_test_driver_t.
+ * Measure xdelta throughput for typical edit patterns: scattered
+ * insertions, scattered deletions and re-ordered blocks.
+ */
+static svn_error_t *
+xdelta_benchmark(apr_pool_t *pool)
+{
+  apr_uint32_t seed = 0x4711;
+  apr_size_t block_size = 1024;
+  apr_size_t block_count = BENCHMARK_SIZE / block_size;
+  svn_string_t *source;
+  svn_stringbuf_t *target;
+  char *data = apr_palloc(pool, BENCHMARK_SIZE);
+  char insertion[64];
+  apr_size_t *order;
+  apr_size_t i;
+
+  generate_text(data, BENCHMARK_SIZE, &seed);
+  source = svn_string_ncreate(data, BENCHMARK_SIZE, pool);
+
+  /* Short insertions every 4kB. */
+  target = svn_stringbuf_create_ensure(2 * BENCHMARK_SIZE, pool);
+  for (i = 0; i < BENCHMARK_SIZE; i += 4096)
+    {
+      apr_size_t len = svn_test_rand(&seed) % sizeof(insertion) + 1;
+      generate_text(insertion, len, &seed);
+      svn_stringbuf_appendbytes(target, data + i, 4096);
+      svn_stringbuf_appendbytes(target, insertion, len);
+    }
+  SVN_ERR(run_delta_benchmark("insert", source,
+                              svn_stringbuf__morph_into_string(target),
+                              pool));
+
+  /* Short deletions every 4kB. */
+  target = svn_stringbuf_create_ensure(BENCHMARK_SIZE, pool);
+  for (i = 0; i < BENCHMARK_SIZE; i += 4096)
+    {
+      apr_size_t len = svn_test_rand(&seed) % 64 + 1;
+      svn_stringbuf_appendbytes(target, data + i + len, 4096 - len);
+    }
+  SVN_ERR(run_delta_benchmark("delete", source,
+                              svn_stringbuf__morph_into_string(target),
+                              pool));
+
+  /* Shuffle 1kB blocks within a window's reach. */
+  order = apr_palloc(pool, block_count * sizeof(*order));
+  for (i = 0; i < block_count; ++i)
+    order[i] = i;
+  for (i = 0; i + 1 < block_count; ++i)
+    {
+      apr_size_t range = block_count - i < 64 ? block_count - i : 64;
+      apr_size_t k = i + svn_test_rand(&seed) % range;
+      apr_size_t temp = order[i];
+      order[i] = order[k];
+      order[k] = temp;
+    }
+
+  target = svn_stringbuf_create_ensure(BENCHMARK_SIZE, pool);
+  for (i = 0; i < block_count; ++i)
+    svn_stringbuf_appendbytes(target, data + order[i] * block_size,
+                              block_size);
+  SVN_ERR(run_delta_benchmark("shuffle", source,
+                              svn_stringbuf__morph_into_string(target),
+                              pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Deltify TARGET against SOURCE using WINDOW_SIZE, encode the result as
+ * svndiff version SVNDIFF_VERSION, and return the encoded delta in
+ * *DIFF.  Allocate *DIFF in RESULT_POOL.
+ */
+static svn_error_t *
+encode_delta(svn_stringbuf_t **diff,
+             const svn_string_t *source,
+             const svn_string_t *target,
+             apr_size_t window_size,
+             int svndiff_version,
+             apr_pool_t *result_pool)
+{
+  svn_txdelta_stream_t *txstream;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+
+  *diff = svn_stringbuf_create_empty(result_pool);
+  svn_txdelta__create(&txstream,
+                      svn_stream_from_string(source, result_pool),
+                      svn_stream_from_string(target, result_pool),
+                      FALSE, window_size, result_pool);
+  svn_txdelta_to_svndiff3(&handler, &handler_baton,
+                          svn_stream_from_stringbuf(*diff, result_pool),
+                          svndiff_version,
+                          SVN_DELTA_COMPRESSION_LEVEL_DEFAULT, result_pool);
+
+  return svn_error_trace(svn_txdelta_send_txstream(txstream, handler,
+                                                   handler_baton,
+                                                   result_pool));
+}
+
+/* Apply the svndiff DIFF to SOURCE and return the result in *TARGET.
+ * Allocate *TARGET in RESULT_POOL.
+ */
+static svn_error_t *
+decode_delta(svn_stringbuf_t **target,
+             const svn_string_t *source,
+             const svn_stringbuf_t *diff,
+             apr_pool_t *result_pool)
+{
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_stream_t *stream;
+  apr_size_t len = diff->len;
+
+  *target = svn_stringbuf_create_empty(result_pool);
+  svn_txdelta_apply(svn_stream_from_string(source, result_pool),
+                    svn_stream_from_stringbuf(*target, result_pool),
+                    NULL, NULL, result_pool, &handler, &handler_baton);
+  stream = svn_txdelta_parse_svndiff(handler, handler_baton, TRUE,
+                                     result_pool);
+  SVN_ERR(svn_stream_write(stream, diff->data, &len));
+
+  return svn_error_trace(svn_stream_close(stream));
+}
+
+/* Return a copy of SOURCE with SHIFT bytes of new text inserted at its
+ * beginning.  Use and update *SEED.  Allocate the result in POOL.
+ */
+static svn_string_t *
+shifted_text(const svn_string_t *source,
+             apr_size_t shift,
+             apr_uint32_t *seed,
+             apr_pool_t *pool)
+{
+  svn_stringbuf_t *target
+    = svn_stringbuf_create_ensure(source->len + shift, pool);
+
+  generate_text(target->data, shift, seed);
+  target->len = shift;
+  svn_stringbuf_appendbytes(target, source->data, source->len);
+
+  return svn_stringbuf__morph_into_string(target);
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+svndiff3_large_window_test(apr_pool_t *pool)
+{
+  apr_uint32_t seed = 0x1234;
+  apr_size_t size = 2 * SVN_DELTA_LARGE_WINDOW_SIZE;
+  apr_size_t shift = 3 * SVN_DELTA_WINDOW_SIZE;
+  char *data = apr_palloc(pool, size);
+  svn_string_t *source;
+  svn_string_t *target;
+  svn_stringbuf_t *small_diff;
+  svn_stringbuf_t *large_diff;
+  svn_stringbuf_t *result;
+
+  generate_text(data, size, &seed);
+  source = svn_string_ncreate(data, size, pool);
+  target = shifted_text(source, shift, &seed, pool);
+
+  /* Both window sizes must round-trip through svndiff3. */
+  SVN_ERR(encode_delta(&small_diff, source, target, SVN_DELTA_WINDOW_SIZE,
+                       3, pool));
+  SVN_ERR(decode_delta(&result, source, small_diff, pool));
+  SVN_TEST_STRING_ASSERT(result->data, target->data);
+
+  SVN_ERR(encode_delta(&large_diff, source, target,
+                       SVN_DELTA_LARGE_WINDOW_SIZE, 3, pool));
+  SVN_ERR(decode_delta(&result, source, large_diff, pool));
+  SVN_TEST_STRING_ASSERT(result->data, target->data);
+
+  /* Small windows cannot see across a shift larger than the window size
+   * while large windows can.  The latter must produce a much smaller
+   * delta. */
+  if (large_diff->len * 4 > small_diff->len)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "svndiff3 delta with large windows is %lu "
+                             "bytes, with small windows %lu bytes",
+                             (unsigned long)large_diff->len,
+                             (unsigned long)small_diff->len);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_test_driver_t.
+ * Compare encoded size, encoding and reconstruction time of the svndiff
+ * versions for a large file whose content has shifted.
+ */
+static svn_error_t *
+svndiff_version_benchmark(apr_pool_t *pool)
+{
+  apr_uint32_t seed = 0x4711;
+  apr_size_t size = 4 * BENCHMARK_SIZE;
+  char *data = apr_palloc(pool, size);
+  svn_string_t *source;
+  svn_string_t *target;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int version;
+
+  generate_text(data, size, &seed);
+  source = svn_string_ncreate(data, size, pool);
+  target = shifted_text(source, 256 * 1024, &seed, pool);
+
+  for (version = 1; version <= 3; ++version)
+    {
+      svn_stringbuf_t *diff;
+      svn_stringbuf_t *result;
+      apr_time_t start, encoded, decoded;
+
+      svn_pool_clear(iterpool);
+
+      start = apr_time_now();
+      SVN_ERR(encode_delta(&diff, source, target,
+                           svn_txdelta__window_size(version), version,
+                           iterpool));
+      encoded = apr_time_now();
+      SVN_ERR(decode_delta(&result, source, diff, iterpool));
+      decoded = apr_time_now();
+
+      SVN_TEST_ASSERT(result->len == target->len);
+      printf("svndiff%d %10lu bytes  encode %6.1f ms  decode %6.1f ms\n",
+             version, (unsigned long)diff->len,
+             (double)(encoded - start) / 1000,
+             (double)(decoded - encoded) / 1000);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Change to 1 to enable the unit test for the delta combiner's range index: */
 #if 0
 #include "range-index-test.h"
@@ -625,6 +925,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "random combine delta test"),
     SVN_TEST_PASS2(random_txdelta_to_svndiff_stream_test,
                    "random txdelta to svndiff stream test"),
+    SVN_TEST_SKIP2(xdelta_benchmark, TRUE,
+                   "xdelta throughput benchmark"),
+    SVN_TEST_PASS2(svndiff3_large_window_test,
+                   "svndiff3 with large delta windows"),
+    SVN_TEST_SKIP2(svndiff_version_benchmark, TRUE,
+                   "svndiff version size and speed benchmark"),
 #ifdef SVN_RANGE_INDEX_TEST_H
     SVN_TEST_PASS2(random_range_index_test,
                    "random range index test"),
@@ -37,6 +37,9 @@
 #include "svn_mergeinfo.h"
 #include "svn_props.h"
 #include "svn_version.h"
+#include "svn_cache_config.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
 
 #include "svn_private_config.h"
 #include "private/svn_fs_util.h"
@@ -396,6 +399,103 @@ revprop_refresh(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* ------------------------------------------------------------------------ */
+
+/* The part of threads_with_single_threaded_cache that runs with the
+ * modified cache config. */
+static svn_error_t *
+pack_and_verify_on_threads(const svn_test_opts_t *opts,
+                           apr_pool_t *pool)
+{
+  const char *fs_path = "test-repo-single-threaded-cache";
+  const char *pack_config = "[pack]\n"
+                            "threads = 4\n";
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t head_rev = 0;
+  svn_stringbuf_t *contents;
+  apr_hash_t *config;
+  apr_file_t *file;
+  int i;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* Several small shards to pack and verify in parallel. */
+  config = apr_hash_make(pool);
+  svn_hash_sets(config, SVN_FS_CONFIG_FSFS_SHARD_SIZE, "2");
+  SVN_ERR(svn_test__create_fs2(&fs, fs_path, opts, config, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, head_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(test_commit_txn(&head_rev, txn, NULL, pool));
+
+  for (i = 0; i < 10; ++i)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, head_rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, "iota",
+                                          apr_itoa(iterpool, i),
+                                          iterpool));
+      SVN_ERR(test_commit_txn(&head_rev, txn, NULL, iterpool));
+    }
+
+  /* Unless some earlier code created the global cache, it has been
+   * created without locks.  FSFS must not use it from several threads. */
+  SVN_ERR(svn_io_file_open(&file, svn_dirent_join(fs_path, "fsfs.conf",
+                                                  pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, pack_config, strlen(pack_config),
+                                 NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  SVN_ERR(svn_fs_pack(fs_path, NULL, NULL, NULL, NULL, pool));
+
+  config = apr_hash_make(pool);
+  svn_hash_sets(config, SVN_FS_CONFIG_FSFS_VERIFY_JOBS, "4");
+  SVN_ERR(svn_fs_verify(fs_path, config, 0, SVN_INVALID_REVNUM,
+                        NULL, NULL, NULL, NULL, pool));
+
+  /* All data must be intact. */
+  SVN_ERR(svn_fs_open2(&fs, fs_path, NULL, pool, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, head_rev, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "iota", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "9");
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Pack and verify with multiple threads configured while the cache config
+ * asks for single-threaded caches.  FSFS must fall back to a single
+ * thread in that case.  The global cache gets created when the first FS
+ * is being opened, so this is the first test in this file. */
+static svn_error_t *
+threads_with_single_threaded_cache(const svn_test_opts_t *opts,
+                                   apr_pool_t *pool)
+{
+  svn_cache_config_t original = *svn_cache_config_get();
+  svn_cache_config_t settings = original;
+  svn_error_t *err;
+
+  if (strcmp(opts->fs_type, SVN_FS_TYPE_FSFS))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this test is FSFS-specific");
+
+  settings.single_threaded = TRUE;
+  svn_cache_config_set(&settings);
+
+  err = pack_and_verify_on_threads(opts, pool);
+
+  svn_cache_config_set(&original);
+
+  return svn_error_trace(err);
+}
+
+
 /* ------------------------------------------------------------------------ */
 
 /* The test table.  */
@@ -405,6 +505,8 @@ static int max_threads = 1;  /* Run tests sequentially. */
 static struct svn_test_descriptor_t test_funcs[] =
   {
     SVN_TEST_NULL,
+    SVN_TEST_OPTS_PASS(threads_with_single_threaded_cache,
+                       "pack and verify with a single-threaded cache"),
     SVN_TEST_OPTS_PASS(reopen_modify,
                        "test reopen and modify txn"),
     SVN_TEST_OPTS_PASS(revprop_refresh,
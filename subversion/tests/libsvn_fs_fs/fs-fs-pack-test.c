@@ -1890,6 +1890,157 @@ large_delta_against_plain(const svn_test_opts_t *opts,
 
 
 
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-pack-concurrently"
+#define SHARD_SIZE 3
+#define MAX_REV 40
+static svn_error_t *
+pack_concurrently(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  struct pack_notify_baton pnb;
+  svn_fs_t *fs;
+  apr_file_t *file;
+  const char *config = "[pack]\n"
+                       "threads = 4\n"
+                       "memory-per-thread = 1\n";
+  svn_revnum_t i;
+
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                       pool));
+
+  /* Enable concurrent packing. */
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  /* Shards must still be reported - and published - in order. */
+  pnb.expected_shard = 0;
+  pnb.expected_action = svn_fs_pack_notify_start;
+  SVN_ERR(svn_fs_pack(REPO_NAME, pack_notify, &pnb, NULL, NULL, pool));
+  SVN_TEST_ASSERT(pnb.expected_shard == (MAX_REV + 1) / SHARD_SIZE);
+  SVN_TEST_ASSERT(pnb.expected_action == svn_fs_pack_notify_start);
+
+  /* All data must be intact. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, SVN_INVALID_REVNUM,
+                        NULL, NULL, NULL, NULL, pool));
+
+  for (i = 2; i <= MAX_REV; i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stream_t *stream;
+      svn_stringbuf_t *contents;
+
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, pool));
+      SVN_ERR(svn_fs_file_contents(&stream, rev_root, "iota", pool));
+      SVN_ERR(svn_test__stream_to_string(&contents, stream, pool));
+      SVN_TEST_STRING_ASSERT(contents->data, get_rev_contents(i, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-pack-stages"
+#define SHARD_SIZE 32
+#define MAX_REV 80
+static svn_error_t *
+pack_stages(const svn_test_opts_t *opts,
+            apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t rev;
+  svn_node_kind_t kind;
+  apr_file_t *file;
+  const char *config = "[pack]\n"
+                       "stage-after-commit = true\n";
+  svn_revnum_t i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (opts->server_minor_version && (opts->server_minor_version < 15))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.15 SVN doesn't support pack stages");
+
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, MAX_REV - 1,
+                                       SHARD_SIZE, pool));
+
+  /* Enable staging. */
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  /* The next commit stages all complete blocks of revisions. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, MAX_REV - 1, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                      get_rev_contents(MAX_REV, pool),
+                                      pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == MAX_REV);
+
+  SVN_ERR(svn_io_check_path(svn_dirent_join(REPO_NAME, "revs/0/0.stage",
+                                            pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(svn_io_check_path(svn_dirent_join(REPO_NAME, "revs/0/5", pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_io_check_path(svn_dirent_join(REPO_NAME, "revs/2/64.stage",
+                                            pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(svn_io_check_path(svn_dirent_join(REPO_NAME, "revs/2/80", pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  /* Stages must be readable and merge into the shard packs. */
+  for (i = 0; i < 2; ++i)
+    {
+      SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, SVN_INVALID_REVNUM,
+                            NULL, NULL, NULL, NULL, pool));
+
+      SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+      for (rev = 2; rev <= MAX_REV; rev++)
+        {
+          svn_fs_root_t *rev_root;
+          svn_stream_t *stream;
+          svn_stringbuf_t *contents;
+
+          SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+          SVN_ERR(svn_fs_file_contents(&stream, rev_root, "iota", pool));
+          SVN_ERR(svn_test__stream_to_string(&contents, stream, pool));
+          SVN_TEST_STRING_ASSERT(contents->data,
+                                 get_rev_contents(rev, pool));
+        }
+
+      SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+    }
+
+  SVN_ERR(svn_io_check_path(svn_dirent_join(REPO_NAME, "revs/0.pack", pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_dir);
+  SVN_ERR(svn_io_check_path(svn_dirent_join(REPO_NAME, "revs/2/64.stage",
+                                            pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -1943,6 +2094,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pack with limited memory for metadata"),
     SVN_TEST_OPTS_PASS(large_delta_against_plain,
                        "large deltas against PLAIN, issue #4658"),
+    SVN_TEST_OPTS_PASS(pack_concurrently,
+                       "pack multiple shards concurrently"),
+    SVN_TEST_OPTS_PASS(pack_stages,
+                       "stage revisions before packing their shard"),
     SVN_TEST_NULL
   };
 
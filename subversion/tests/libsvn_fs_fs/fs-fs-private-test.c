@@ -30,12 +30,15 @@
 #include "svn_props.h"
 #include "svn_fs.h"
 
+#include "private/svn_cache.h"
 #include "private/svn_string_private.h"
 #include "private/svn_fs_fs_private.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_subr_private.h"
 
 #include "../../libsvn_fs_fs/index.h"
 #include "../../libsvn_fs_fs/rep-cache.h"
+#include "../../libsvn_fs_fs/util.h"
 #include "../../libsvn_fs/fs-loader.h"
 
 #include "../svn_test_fs.h"
@@ -444,6 +447,242 @@ load_index(const svn_test_opts_t *opts, apr_pool_t *pool)
 
 /* ------------------------------------------------------------------------ */
 
+#define REPO_NAME "test-repo-verify-concurrently-test"
+
+/* Implements svn_repos_notify_func_t.  Append the revision of every
+ * svn_repos_notify_verify_rev_end notification to the array BATON. */
+static void
+record_verified_rev(void *baton,
+                    const svn_repos_notify_t *notify,
+                    apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *revisions = baton;
+
+  if (notify->action == svn_repos_notify_verify_rev_end)
+    APR_ARRAY_PUSH(revisions, svn_revnum_t) = notify->revision;
+}
+
+static svn_error_t *
+verify_concurrently(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_revnum_t rev, youngest;
+  apr_array_header_t *revisions = apr_array_make(pool, 0,
+                                                 sizeof(svn_revnum_t));
+  apr_array_header_t *entries = apr_array_make(pool, 41, sizeof(void *));
+  apr_array_header_t *alt_entries = apr_array_make(pool, 1, sizeof(void *));
+  svn_fs_fs__p2l_entry_t entry;
+  svn_fs_fs__ioctl_dump_index_input_t dump_input = {0};
+  svn_fs_fs__ioctl_load_index_input_t load_input = {0};
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 9))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.9 SVN doesn't have FSFS indexes");
+
+  /* Create a filesystem with a few more revisions. */
+  SVN_ERR(create_greek_repo(&repos, &rev, opts, REPO_NAME, pool, pool));
+  fs = svn_repos_fs(repos);
+  for (i = 0; i < 20; ++i)
+    {
+      svn_fs_txn_t *txn;
+      svn_fs_root_t *txn_root;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev + i, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                          apr_psprintf(iterpool, "%d\n", i),
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &youngest, txn, iterpool));
+    }
+
+  /* All revisions get reported, in order. */
+  SVN_ERR(svn_repos_verify_fs4(repos, 0, youngest, FALSE, FALSE, 4,
+                               record_verified_rev, revisions, NULL, NULL,
+                               NULL, NULL, pool));
+  SVN_TEST_INT_ASSERT(revisions->nelts, youngest + 1);
+  for (i = 0; i < revisions->nelts; ++i)
+    SVN_TEST_INT_ASSERT(APR_ARRAY_IDX(revisions, i, svn_revnum_t), i);
+
+  /* Corrupt the index of a revision in the middle. */
+  rev = youngest / 2;
+  dump_input.revision = rev;
+  dump_input.callback_func = receive_index;
+  dump_input.callback_baton = entries;
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_DUMP_INDEX,
+                       &dump_input, NULL, NULL, NULL, pool, pool));
+
+  entry = *APR_ARRAY_IDX(entries, entries->nelts-1, svn_fs_fs__p2l_entry_t *);
+  entry.size += entry.offset;
+  entry.offset = 0;
+  entry.type = SVN_FS_FS__ITEM_TYPE_UNUSED;
+  entry.item.number = SVN_FS_FS__ITEM_INDEX_UNUSED;
+  entry.item.revision = SVN_INVALID_REVNUM;
+  APR_ARRAY_PUSH(alt_entries, svn_fs_fs__p2l_entry_t *) = &entry;
+
+  load_input.revision = rev;
+  load_input.entries = alt_entries;
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_LOAD_INDEX,
+                       &load_input, NULL, NULL, NULL, pool, pool));
+
+  /* The concurrent checks must detect that just like the serial ones. */
+  SVN_TEST_ASSERT_ERROR(svn_repos_verify_fs4(repos, 0, youngest, FALSE,
+                                             FALSE, 4, NULL, NULL, NULL,
+                                             NULL, NULL, NULL, pool),
+                        SVN_ERR_FS_INDEX_CORRUPTION);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-verify-incrementally-test"
+
+/* Set *COUNT to the number of lines in the verification checkpoints file
+ * of FS.  Use POOL for temporary allocations. */
+static svn_error_t *
+count_checkpoints(int *count,
+                  svn_fs_t *fs,
+                  apr_pool_t *pool)
+{
+  svn_stringbuf_t *content;
+  const char *path = svn_dirent_join(svn_fs_path(fs, pool),
+                                     "verify-checkpoints", pool);
+
+  SVN_ERR(svn_stringbuf_from_file2(&content, path, pool));
+  *count = svn_cstring_count_newlines(content->data);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *VERIFIED to the number of pack units of FS within revisions 0 to
+ * END that passed verification before.  Use POOL for all allocations. */
+static svn_error_t *
+count_verified(int *verified,
+               svn_fs_t *fs,
+               svn_revnum_t end,
+               apr_pool_t *pool)
+{
+  svn_fs_fs__ioctl_verify_checkpoints_input_t input;
+  svn_fs_fs__ioctl_get_verify_checkpoints_output_t *output;
+  int i;
+
+  input.start_rev = 0;
+  input.end_rev = end;
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_GET_VERIFY_CHECKPOINTS,
+                       &input, (void **)&output, NULL, NULL, pool, pool));
+
+  /* The repository is not packed. */
+  SVN_TEST_INT_ASSERT(output->units->nelts, end + 1);
+
+  *verified = 0;
+  for (i = 0; i < output->units->nelts; ++i)
+    if (APR_ARRAY_IDX(output->units, i, svn_fs_fs__verify_unit_t *)->verified)
+      ++*verified;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+verify_incrementally(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_revnum_t rev;
+  apr_array_header_t *entries = apr_array_make(pool, 41, sizeof(void *));
+  apr_array_header_t *alt_entries = apr_array_make(pool, 1, sizeof(void *));
+  svn_fs_fs__p2l_entry_t entry;
+  svn_fs_fs__ioctl_dump_index_input_t dump_input = {0};
+  svn_fs_fs__ioctl_load_index_input_t load_input = {0};
+  svn_fs_fs__ioctl_verify_checkpoints_input_t input;
+  int count, verified;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 9))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.9 SVN doesn't have FSFS indexes");
+
+  SVN_ERR(create_greek_repo(&repos, &rev, opts, REPO_NAME, pool, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Nothing has been verified yet. */
+  SVN_ERR(count_verified(&verified, fs, rev, pool));
+  SVN_TEST_INT_ASSERT(verified, 0);
+
+  /* Record some revisions, then all of them. */
+  input.start_rev = 1;
+  input.end_rev = rev;
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_ADD_VERIFY_CHECKPOINTS,
+                       &input, NULL, NULL, NULL, pool, pool));
+  SVN_ERR(count_verified(&verified, fs, rev, pool));
+  SVN_TEST_INT_ASSERT(verified, rev);
+
+  input.start_rev = 0;
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_ADD_VERIFY_CHECKPOINTS,
+                       &input, NULL, NULL, NULL, pool, pool));
+  SVN_ERR(count_verified(&verified, fs, rev, pool));
+  SVN_TEST_INT_ASSERT(verified, rev + 1);
+  SVN_ERR(count_checkpoints(&count, fs, pool));
+  SVN_TEST_INT_ASSERT(count, 2 * rev + 1);
+
+  /* Compaction drops the superseded records. */
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_COMPACT_VERIFY_CHECKPOINTS,
+                       NULL, NULL, NULL, NULL, pool, pool));
+  SVN_ERR(count_checkpoints(&count, fs, pool));
+  SVN_TEST_INT_ASSERT(count, rev + 1);
+
+  /* Modified revisions must be checked again. */
+  dump_input.revision = rev;
+  dump_input.callback_func = receive_index;
+  dump_input.callback_baton = entries;
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_DUMP_INDEX,
+                       &dump_input, NULL, NULL, NULL, pool, pool));
+
+  entry = *APR_ARRAY_IDX(entries, entries->nelts-1, svn_fs_fs__p2l_entry_t *);
+  entry.size += entry.offset;
+  entry.offset = 0;
+  entry.type = SVN_FS_FS__ITEM_TYPE_UNUSED;
+  entry.item.number = SVN_FS_FS__ITEM_INDEX_UNUSED;
+  entry.item.revision = SVN_INVALID_REVNUM;
+  APR_ARRAY_PUSH(alt_entries, svn_fs_fs__p2l_entry_t *) = &entry;
+
+  load_input.revision = rev;
+  load_input.entries = alt_entries;
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_LOAD_INDEX,
+                       &load_input, NULL, NULL, NULL, pool, pool));
+
+  SVN_ERR(count_verified(&verified, fs, rev, pool));
+  SVN_TEST_INT_ASSERT(verified, rev);
+
+  /* Compaction drops records that don't match anymore. */
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_COMPACT_VERIFY_CHECKPOINTS,
+                       NULL, NULL, NULL, NULL, pool, pool));
+  SVN_ERR(count_checkpoints(&count, fs, pool));
+  SVN_TEST_INT_ASSERT(count, rev);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
 static svn_error_t *
 build_rep_cache(const svn_test_opts_t *opts, apr_pool_t *pool)
 {
@@ -499,6 +738,189 @@ build_rep_cache(const svn_test_opts_t *opts, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* ------------------------------------------------------------------------ */
+
+static svn_error_t *
+cache_snapshot(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *contents;
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  svn_fs_fs__ioctl_cache_snapshot_input_t input = { NULL };
+  svn_fs_fs__ioctl_load_cache_snapshot_output_t *output;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (membuffer == NULL)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "no membuffer cache available");
+
+  /* Create a repository with some contents and read it once. */
+  SVN_ERR(svn_test__create_fs2(&fs, "test-repo-cache-snapshot", opts, NULL,
+                               pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "A/D/G/rho", &contents, pool));
+
+  /* Take a snapshot and reload it into an empty cache. */
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_SAVE_CACHE_SNAPSHOT,
+                       &input, NULL, NULL, NULL, pool, pool));
+  SVN_ERR(svn_cache__membuffer_clear(membuffer));
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_LOAD_CACHE_SNAPSHOT,
+                       &input, (void **)&output, NULL, NULL, pool, pool));
+  SVN_TEST_ASSERT(output->loaded);
+
+  /* Any new revision invalidates the snapshot. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_delete(root, "iota", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_LOAD_CACHE_SNAPSHOT,
+                       &input, (void **)&output, NULL, NULL, pool, pool));
+  SVN_TEST_ASSERT(!output->loaded);
+
+  /* So does a different youngest revision with the same number, as after
+   * restoring an older backup and committing to it.  Simulate that by
+   * touching the revision file. */
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_SAVE_CACHE_SNAPSHOT,
+                       &input, NULL, NULL, NULL, pool, pool));
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_LOAD_CACHE_SNAPSHOT,
+                       &input, (void **)&output, NULL, NULL, pool, pool));
+  SVN_TEST_ASSERT(output->loaded);
+
+  SVN_ERR(svn_io_set_file_affected_time(apr_time_now()
+                                          + apr_time_from_sec(10),
+                                        svn_fs_fs__path_rev_absolute(fs, rev,
+                                                                     pool),
+                                        pool));
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_LOAD_CACHE_SNAPSHOT,
+                       &input, (void **)&output, NULL, NULL, pool, pool));
+  SVN_TEST_ASSERT(!output->loaded);
+
+  /* Nor for a different repository. */
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_SAVE_CACHE_SNAPSHOT,
+                       &input, NULL, NULL, NULL, pool, pool));
+  SVN_ERR(svn_fs_set_uuid(fs, NULL, pool));
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_LOAD_CACHE_SNAPSHOT,
+                       &input, (void **)&output, NULL, NULL, pool, pool));
+  SVN_TEST_ASSERT(!output->loaded);
+
+  return SVN_NO_ERROR;
+}
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-file-contents-ranges"
+
+/* Write the LEN bytes at DATA as the new contents of PATH in ROOT. */
+static svn_error_t *
+set_file_data(svn_fs_root_t *root,
+              const char *path,
+              const char *data,
+              apr_size_t len,
+              apr_pool_t *pool)
+{
+  svn_stream_t *stream;
+
+  SVN_ERR(svn_fs_apply_text(&stream, root, path, NULL, pool));
+  SVN_ERR(svn_stream_write(stream, data, &len));
+  SVN_ERR(svn_stream_close(stream));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+file_contents_ranges(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_revnum_t rev;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  apr_file_t *file;
+  apr_array_header_t *ranges;
+  svn_stringbuf_t *contents;
+  apr_size_t len = 250000;
+  char *data = apr_palloc(pool, len);
+  apr_uint32_t seed = 0x5eed;
+  apr_size_t i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  /* Random data cannot be compressed and gets stored verbatim, spread
+   * over several svndiff windows.  Repetitive data gets deltified. */
+  for (i = 0; i < len; ++i)
+    data[i] = (char)svn_test_rand(&seed);
+
+  SVN_ERR(create_greek_repo(&repos, &rev, opts, REPO_NAME, pool, pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "random", pool));
+  SVN_ERR(set_file_data(root, "random", data, len, pool));
+  SVN_ERR(svn_fs_make_file(root, "repetitive", pool));
+  SVN_ERR(set_file_data(root, "repetitive",
+                        memset(apr_palloc(pool, len), 'a', len), len, pool));
+
+  /* Uncommitted contents are never reported. */
+  SVN_ERR(svn_fs__file_contents_ranges(&file, &ranges, root, "random",
+                                       pool, pool));
+  SVN_TEST_ASSERT(file == NULL);
+
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+
+  SVN_ERR(svn_fs__file_contents_ranges(&file, &ranges, root, "repetitive",
+                                       pool, pool));
+  SVN_TEST_ASSERT(file == NULL);
+
+  /* The ranges must add up to the file contents. */
+  SVN_ERR(svn_fs__file_contents_ranges(&file, &ranges, root, "random",
+                                       pool, pool));
+  SVN_TEST_ASSERT(file != NULL);
+  SVN_TEST_ASSERT(ranges->nelts > 1);
+
+  contents = svn_stringbuf_create_empty(pool);
+  for (i = 0; i < (apr_size_t)ranges->nelts; ++i)
+    {
+      const svn_fs__file_range_t *range
+        = &APR_ARRAY_IDX(ranges, i, svn_fs__file_range_t);
+      apr_off_t offset = range->offset;
+      apr_size_t range_len = (apr_size_t)range->length;
+
+      svn_stringbuf_ensure(contents, contents->len + range_len);
+      SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+      SVN_ERR(svn_io_file_read_full2(file, contents->data + contents->len,
+                                     range_len, NULL, NULL, pool));
+      contents->len += range_len;
+    }
+
+  SVN_TEST_INT_ASSERT(contents->len, len);
+  SVN_TEST_ASSERT(memcmp(contents->data, data, len) == 0);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
 
 
 /* The test table.  */
@@ -514,8 +936,16 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "dump the P2L index"),
     SVN_TEST_OPTS_PASS(load_index,
                        "load the P2L index"),
+    SVN_TEST_OPTS_PASS(verify_concurrently,
+                       "verify revisions on multiple threads"),
+    SVN_TEST_OPTS_PASS(verify_incrementally,
+                       "verify only modified revisions"),
     SVN_TEST_OPTS_PASS(build_rep_cache,
                        "build the representation cache"),
+    SVN_TEST_OPTS_PASS(cache_snapshot,
+                       "save and load a cache snapshot"),
+    SVN_TEST_OPTS_PASS(file_contents_ranges,
+                       "locate verbatim file contents"),
     SVN_TEST_NULL
   };
 
@@ -0,0 +1,455 @@
+/*
+ * ra-svn-test.c :  tests for the ra_svn protocol parser and streams
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <apr_strings.h>
+#include <apr_time.h>
+
+#include "svn_delta.h"
+#include "svn_error.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_ra_svn.h"
+#include "svn_string.h"
+
+#include "private/svn_ra_svn_private.h"
+
+#include "../svn_test.h"
+
+
+/*** Helpers ***/
+
+/* Baton for short_read_fn. */
+typedef struct short_read_baton_t
+{
+  svn_stream_t *stream;
+  apr_size_t max_read;
+} short_read_baton_t;
+
+/* Implements svn_read_fn_t.  Read at most BATON->MAX_READ bytes at a time,
+   so that items straddle the boundaries of the connection's read buffer
+   at every possible position. */
+static svn_error_t *
+short_read_fn(void *baton,
+              char *buffer,
+              apr_size_t *len)
+{
+  short_read_baton_t *b = baton;
+
+  if (*len > b->max_read)
+    *len = b->max_read;
+
+  return svn_error_trace(svn_stream_read2(b->stream, buffer, len));
+}
+
+/* Return a connection that replays the protocol stream DATA.
+   If MAX_READ is not 0, deliver DATA in chunks of at most that many bytes.
+   Allocate everything in RESULT_POOL. */
+static svn_ra_svn_conn_t *
+replay_conn(const svn_stringbuf_t *data,
+            apr_size_t max_read,
+            apr_pool_t *result_pool)
+{
+  svn_stream_t *in = svn_stream_from_stringbuf((svn_stringbuf_t *)data,
+                                               result_pool);
+
+  if (max_read)
+    {
+      short_read_baton_t *b = apr_pcalloc(result_pool, sizeof(*b));
+
+      b->stream = in;
+      b->max_read = max_read;
+      in = svn_stream_create(b, result_pool);
+      svn_stream_set_read2(in, short_read_fn, NULL);
+    }
+
+  return svn_ra_svn_create_conn5(NULL, in, svn_stream_empty(result_pool),
+                                 SVN_DELTA_COMPRESSION_LEVEL_NONE, 0, 0, 0, 0,
+                                 result_pool);
+}
+
+/* Append a log-entry item for revision REV, as svnserve would send it in
+   response to a log command with changed paths, to DATA. */
+static void
+append_log_entry(svn_stringbuf_t *data,
+                 svn_revnum_t rev,
+                 apr_pool_t *scratch_pool)
+{
+  const char *path = apr_psprintf(scratch_pool, "/trunk/subversion/"
+                                  "libsvn_ra_svn/file-%ld.c", rev);
+  const char *message = apr_psprintf(scratch_pool, "Log message of r%ld,\n"
+                                     "spanning (two) lines.", rev);
+
+  svn_stringbuf_appendcstr(data,
+    apr_psprintf(scratch_pool,
+                 "( ( ( %lu:%s M ( ) ( 4:file true false ) ) ) %ld "
+                 "( 6:jrandom ) ( 27:2024-01-01T00:00:00.000000Z ) "
+                 "( %lu:%s ) false false 0 ( ) false ) ",
+                 (unsigned long)strlen(path), path, rev,
+                 (unsigned long)strlen(message), message));
+}
+
+/* Append a dirent item for entry number I, as svnserve would send it in
+   response to a list command with all dirent fields, to DATA. */
+static void
+append_list_dirent(svn_stringbuf_t *data,
+                   int i,
+                   apr_pool_t *scratch_pool)
+{
+  const char *path = apr_psprintf(scratch_pool, "trunk/dir-%d/file-%d.txt",
+                                  i / 100, i);
+
+  svn_stringbuf_appendcstr(data,
+    apr_psprintf(scratch_pool,
+                 "( %lu:%s file ( %d ) ( false ) ( %d ) "
+                 "( 27:2024-01-01T00:00:00.000000Z ) ( 6:jrandom ) ) ",
+                 (unsigned long)strlen(path), path, 1000 + i, i + 1));
+}
+
+/* Verify that ITEM is a word equal to EXPECTED. */
+static svn_error_t *
+check_word(const svn_ra_svn__item_t *item,
+           const char *expected)
+{
+  SVN_TEST_ASSERT(item->kind == SVN_RA_SVN_WORD);
+  SVN_TEST_STRING_ASSERT(item->u.word.data, expected);
+  SVN_TEST_ASSERT(item->u.word.len == strlen(expected));
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify that ITEM is a string equal to EXPECTED. */
+static svn_error_t *
+check_string(const svn_ra_svn__item_t *item,
+             const char *expected)
+{
+  SVN_TEST_ASSERT(item->kind == SVN_RA_SVN_STRING);
+  SVN_TEST_ASSERT(item->u.string.len == strlen(expected));
+  SVN_TEST_ASSERT(!memcmp(item->u.string.data, expected,
+                          item->u.string.len));
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify that ITEM is a list with NELTS elements. */
+static svn_error_t *
+check_list(const svn_ra_svn__item_t *item,
+           int nelts)
+{
+  SVN_TEST_ASSERT(item->kind == SVN_RA_SVN_LIST);
+  SVN_TEST_ASSERT(item->u.list.nelts == nelts);
+  SVN_TEST_ASSERT(nelts > 0 || item->u.list.items == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** Tests ***/
+
+static svn_error_t *
+test_parse_items(apr_pool_t *pool)
+{
+  static const char data[] =
+    "( success ( 0 18446744073709551615 ( ) \n"
+    "abcdefghijklmnopqrstuvwx   12:( \n spaces ) ( ( ( nested ) ) ) ) ) "
+    "0: word-with-dashes ";
+  static const apr_size_t max_reads[] = { 1, 2, 3, 7, 25, 0 };
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  for (i = 0; i < sizeof(max_reads) / sizeof(max_reads[0]); i++)
+    {
+      svn_ra_svn_conn_t *conn;
+      svn_ra_svn__item_t *item;
+      const svn_ra_svn__list_t *list;
+
+      svn_pool_clear(iterpool);
+      conn = replay_conn(svn_stringbuf_create(data, iterpool), max_reads[i],
+                         iterpool);
+
+      SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+      SVN_ERR(check_list(item, 2));
+      SVN_ERR(check_word(&item->u.list.items[0], "success"));
+
+      list = &item->u.list.items[1].u.list;
+      SVN_ERR(check_list(&item->u.list.items[1], 6));
+      SVN_TEST_ASSERT(list->items[0].kind == SVN_RA_SVN_NUMBER);
+      SVN_TEST_ASSERT(list->items[0].u.number == 0);
+      SVN_TEST_ASSERT(list->items[1].kind == SVN_RA_SVN_NUMBER);
+      SVN_TEST_ASSERT(list->items[1].u.number == APR_UINT64_MAX);
+      SVN_ERR(check_list(&list->items[2], 0));
+      SVN_ERR(check_word(&list->items[3], "abcdefghijklmnopqrstuvwx"));
+      SVN_ERR(check_string(&list->items[4], "( \n spaces )"));
+
+      SVN_ERR(check_list(&list->items[5], 1));
+      SVN_ERR(check_list(&list->items[5].u.list.items[0], 1));
+      SVN_ERR(check_word(&list->items[5].u.list.items[0].u.list.items[0],
+                         "nested"));
+
+      SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+      SVN_ERR(check_string(item, ""));
+
+      SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+      SVN_ERR(check_word(item, "word-with-dashes"));
+
+      SVN_TEST_ASSERT_ERROR(svn_ra_svn__read_item(conn, iterpool, &item),
+                            SVN_ERR_RA_SVN_CONNECTION_CLOSED);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_parse_malformed(apr_pool_t *pool)
+{
+  static const char *const data[] =
+    {
+      "( word) ",
+      ") ",
+      "( 12( ) ) ",
+      "18446744073709551616 ",
+      "abcdefghijklmnopqrstuvwxy ",
+      "word_with_underscore ",
+      "3:abc) ",
+      "( # ) ",
+    };
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_stringbuf_t *deep = svn_stringbuf_create_empty(pool);
+  svn_ra_svn__item_t *item;
+  int i;
+
+  for (i = 0; i < sizeof(data) / sizeof(data[0]); i++)
+    {
+      svn_ra_svn_conn_t *conn;
+
+      svn_pool_clear(iterpool);
+      conn = replay_conn(svn_stringbuf_create(data[i], iterpool), 0,
+                         iterpool);
+      SVN_TEST_ASSERT_ERROR(svn_ra_svn__read_item(conn, iterpool, &item),
+                            SVN_ERR_RA_SVN_MALFORMED_DATA);
+    }
+
+  /* Items nested too deeply. */
+  for (i = 0; i < 100; i++)
+    svn_stringbuf_appendcstr(deep, "( ");
+  for (i = 0; i < 100; i++)
+    svn_stringbuf_appendcstr(deep, ") ");
+
+  SVN_TEST_ASSERT_ERROR(svn_ra_svn__read_item(replay_conn(deep, 0, pool),
+                                              pool, &item),
+                        SVN_ERR_RA_SVN_MALFORMED_DATA);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_parse_long_list(apr_pool_t *pool)
+{
+  /* A get-dir style response with enough entries to exceed any
+     pre-allocated list storage several times over. */
+  enum { ENTRIES = 10000 };
+  svn_stringbuf_t *data = svn_stringbuf_create("( ", pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_ra_svn__item_t *item;
+  const svn_ra_svn__item_t *entry;
+  int i;
+
+  for (i = 0; i < ENTRIES; i++)
+    {
+      svn_pool_clear(iterpool);
+      append_list_dirent(data, i, iterpool);
+    }
+  svn_stringbuf_appendcstr(data, ") ");
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_ra_svn__read_item(replay_conn(data, 1000, pool), pool, &item));
+  SVN_ERR(check_list(item, ENTRIES));
+
+  for (i = 0; i < ENTRIES; i++)
+    {
+      entry = &item->u.list.items[i];
+      SVN_ERR(check_list(entry, 7));
+      SVN_ERR(check_word(&entry->u.list.items[1], "file"));
+      SVN_ERR(check_list(&entry->u.list.items[4], 1));
+      SVN_TEST_ASSERT(entry->u.list.items[4].u.list.items[0].u.number
+                      == i + 1);
+    }
+
+  entry = &item->u.list.items[ENTRIES - 1];
+  SVN_ERR(check_string(&entry->u.list.items[0],
+                       apr_psprintf(pool, "trunk/dir-%d/file-%d.txt",
+                                    (ENTRIES - 1) / 100, ENTRIES - 1)));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_compressed_stream(apr_pool_t *pool)
+{
+  /* Enough data to span several compression frames. */
+  enum { ENTRIES = 5000 };
+  apr_size_t max_reads[] = { 0, 7, 1000 };
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int method, k, i;
+
+  for (method = 0; method < 2; method++)
+    for (k = 0; k < sizeof(max_reads) / sizeof(max_reads[0]); k++)
+      {
+        svn_stringbuf_t *data;
+        svn_ra_svn_conn_t *conn;
+        svn_ra_svn__item_t *item;
+
+        svn_pool_clear(iterpool);
+        data = svn_stringbuf_create_empty(iterpool);
+
+        /* Write one plain item, then switch to compression as the
+           handshake does. */
+        conn = svn_ra_svn_create_conn5(NULL, svn_stream_empty(iterpool),
+                                       svn_stream_from_stringbuf(data,
+                                                                 iterpool),
+                                       SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                                       0, 0, 0, 0, iterpool);
+        SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "w", "plain"));
+        SVN_ERR(svn_ra_svn__enable_compression(conn, method == 0,
+                                               iterpool));
+        SVN_ERR(svn_ra_svn__start_list(conn, iterpool));
+        for (i = 0; i < ENTRIES; i++)
+          SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "nc",
+                                          (apr_uint64_t) i,
+                                          "trunk/some/file.txt"));
+        SVN_ERR(svn_ra_svn__end_list(conn, iterpool));
+        SVN_ERR(svn_ra_svn__flush(conn, iterpool));
+
+        /* The compressed part has to be smaller than the plain text. */
+        SVN_TEST_ASSERT(data->len < ENTRIES * 20);
+
+        /* Read it back.  The read buffer may already contain compressed
+           data when we switch. */
+        conn = replay_conn(data, max_reads[k], iterpool);
+        SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+        SVN_ERR(check_list(item, 1));
+        SVN_ERR(check_word(&item->u.list.items[0], "plain"));
+
+        SVN_ERR(svn_ra_svn__enable_compression(conn, method == 0,
+                                               iterpool));
+        SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+        SVN_ERR(check_list(item, ENTRIES));
+        for (i = 0; i < ENTRIES; i++)
+          {
+            const svn_ra_svn__item_t *entry = &item->u.list.items[i];
+
+            SVN_ERR(check_list(entry, 2));
+            SVN_TEST_ASSERT(entry->u.list.items[0].u.number == i);
+            SVN_ERR(check_string(&entry->u.list.items[1],
+                                 "trunk/some/file.txt"));
+          }
+      }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Replay a log response with many entries and a list response with
+   many dirents and report the parser throughput. */
+static svn_error_t *
+test_parse_performance(apr_pool_t *pool)
+{
+  enum { ENTRIES = 200000 };
+  svn_stringbuf_t *log_data = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *list_data = svn_stringbuf_create_empty(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_ra_svn_conn_t *conn;
+  apr_time_t start;
+  apr_time_t duration;
+  int i;
+
+  for (i = 0; i < ENTRIES; i++)
+    {
+      svn_pool_clear(iterpool);
+      append_log_entry(log_data, i, iterpool);
+      append_list_dirent(list_data, i, iterpool);
+    }
+
+  /* Parse the responses item by item, like the command handlers do. */
+  conn = replay_conn(log_data, 0, pool);
+  start = apr_time_now();
+  for (i = 0; i < ENTRIES; i++)
+    {
+      svn_ra_svn__item_t *item;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+    }
+  duration = apr_time_now() - start;
+
+  printf("log:  %d entries, %" APR_SIZE_T_FMT " bytes in %"
+         APR_TIME_T_FMT " usec\n", ENTRIES, log_data->len, duration);
+
+  conn = replay_conn(list_data, 0, pool);
+  start = apr_time_now();
+  for (i = 0; i < ENTRIES; i++)
+    {
+      svn_ra_svn__item_t *item;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+    }
+  duration = apr_time_now() - start;
+
+  printf("list: %d entries, %" APR_SIZE_T_FMT " bytes in %"
+         APR_TIME_T_FMT " usec\n", ENTRIES, list_data->len, duration);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* The test table.  */
+
+static int max_threads = 1;
+
+static struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_PASS2(test_parse_items,
+                   "parse items across read buffer boundaries"),
+    SVN_TEST_PASS2(test_parse_malformed,
+                   "reject malformed protocol data"),
+    SVN_TEST_PASS2(test_parse_long_list,
+                   "parse a list with many elements"),
+    SVN_TEST_PASS2(test_compressed_stream,
+                   "read and write a compressed stream"),
+    SVN_TEST_SKIP2(test_parse_performance, TRUE,
+                   "protocol parser throughput"),
+    SVN_TEST_NULL
+  };
+
+SVN_TEST_MAIN
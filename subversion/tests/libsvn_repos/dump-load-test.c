@@ -273,6 +273,135 @@ test_load_r0_mergeinfo(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Dump all revisions of REPOS into a new *DUMP_DATA allocated in POOL.
+ * Use text deltas if USE_DELTAS is set. */
+static svn_error_t *
+dump_repos(svn_stringbuf_t **dump_data,
+           svn_repos_t *repos,
+           svn_boolean_t use_deltas,
+           apr_pool_t *pool)
+{
+  svn_stream_t *stream;
+
+  *dump_data = svn_stringbuf_create_empty(pool);
+  stream = svn_stream_from_stringbuf(*dump_data, pool);
+  SVN_ERR(svn_repos_dump_fs4(repos, stream,
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             FALSE, use_deltas, TRUE, TRUE,
+                             NULL, NULL, NULL, NULL, NULL, NULL,
+                             pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  return SVN_NO_ERROR;
+}
+
+/* Load DUMP_DATA into a new repository named NAME using JOBS threads and
+ * verify that dumping it again reproduces EXPECTED. */
+static svn_error_t *
+check_load_with_jobs(svn_stringbuf_t *dump_data,
+                     const svn_stringbuf_t *expected,
+                     const char *name,
+                     int jobs,
+                     const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_stream_t *stream = svn_stream_from_stringbuf(dump_data, pool);
+  svn_stringbuf_t *actual;
+
+  SVN_ERR(svn_test__create_repos(&repos, name, opts, pool));
+  SVN_ERR(svn_repos__load_fs_pipelined(repos, stream,
+                                       SVN_INVALID_REVNUM,
+                                       SVN_INVALID_REVNUM,
+                                       svn_repos_load_uuid_default, NULL,
+                                       FALSE, FALSE, /*use_*_commit_hook*/
+                                       TRUE /*validate_props*/,
+                                       FALSE /*ignore_dates*/,
+                                       FALSE /*normalize_props*/,
+                                       jobs,
+                                       NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_ERR(dump_repos(&actual, repos, FALSE, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(actual, expected));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_load_jobs(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_stringbuf_t *expected;
+  svn_stringbuf_t *dump_data;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-load-jobs",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the greek tree */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* Many revisions with text and property changes such that the dump
+   * contains plenty of deltas and the pipeline has to wrap around. */
+  for (i = 0; i < 50; ++i)
+    {
+      const char *contents;
+
+      svn_pool_clear(iterpool);
+      contents = apr_psprintf(iterpool, "This is the file 'iota'.\n"
+                                        "Version %d.\n", i);
+
+      SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "iota", contents,
+                                          iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu",
+                                          apr_psprintf(iterpool,
+                                                       "mu %d\n", i * i),
+                                          iterpool));
+      SVN_ERR(svn_fs_change_node_prop(txn_root, "A/B",
+                                      "prop", i % 3
+                                        ? svn_string_createf(iterpool,
+                                                             "%d", i)
+                                        : NULL,
+                                      iterpool));
+      if (i == 25)
+        SVN_ERR(svn_fs_delete(txn_root, "A/D/G", iterpool));
+
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(dump_repos(&expected, repos, FALSE, pool));
+
+  /* Loading fulltexts and deltas with or without threads must produce the
+   * same repository. */
+  SVN_ERR(check_load_with_jobs(expected, expected,
+                               "test-repo-load-jobs-1", 1, opts, pool));
+  SVN_ERR(check_load_with_jobs(expected, expected,
+                               "test-repo-load-jobs-2", 4, opts, pool));
+
+  SVN_ERR(dump_repos(&dump_data, repos, TRUE, pool));
+  SVN_ERR(check_load_with_jobs(dump_data, expected,
+                               "test-repo-load-jobs-3", 1, opts, pool));
+  SVN_ERR(check_load_with_jobs(dump_data, expected,
+                               "test-repo-load-jobs-4", 4, opts, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -284,6 +413,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test dumping with r0 mergeinfo"),
     SVN_TEST_OPTS_PASS(test_load_r0_mergeinfo,
                        "test loading with r0 mergeinfo"),
+    SVN_TEST_OPTS_PASS(test_load_jobs,
+                       "test loading with multiple jobs"),
     SVN_TEST_NULL
   };
 
@@ -22,10 +22,13 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <signal.h>
 #include <apr_general.h>
 #include <apr_lib.h>
 #include <apr_time.h>
+#include <apr_thread_proc.h>
 
 #include "svn_pools.h"
 
@@ -590,6 +593,475 @@ test_membuffer_unaligned_fixed_keys(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Shared state and results of a thread in run_membuffer_threads. */
+typedef struct cache_thread_baton_t
+{
+  /* Cache backend shared between all threads. */
+  svn_membuffer_t *membuffer;
+
+  /* Thread number. */
+  int id;
+
+  /* Number of cache operations to execute. */
+  int iterations;
+
+  /* Number of distinct keys to use. */
+  int key_count;
+
+  /* Result of the thread's operations. */
+  svn_error_t *err;
+} cache_thread_baton_t;
+
+/* Execute BATON->ITERATIONS mixed get/set operations on a cache front-end
+ * for BATON->MEMBUFFER, using keys of varying length.  Fail if we find a
+ * cached value that does not match its key.  Use POOL for allocations.
+ */
+static svn_error_t *
+exercise_membuffer(cache_thread_baton_t *baton,
+                   apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            baton->membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            FALSE,
+                                            pool, pool));
+
+  for (i = 0; i < baton->iterations; ++i)
+    {
+      svn_revnum_t value = ((svn_revnum_t)i * 31 + baton->id * 1009)
+                         % baton->key_count;
+      svn_revnum_t *answer;
+      svn_boolean_t found;
+      const char *key;
+
+      svn_pool_clear(iterpool);
+
+      /* Every other key exceeds 16 bytes and must be stored in full. */
+      key = value % 2
+          ? apr_psprintf(iterpool, "%ld", value)
+          : apr_psprintf(iterpool, "long-key-%ld-%032ld", value, value);
+
+      if (i % 4 == 0)
+        {
+          SVN_ERR(svn_cache__set(cache, key, &value, iterpool));
+        }
+      else
+        {
+          SVN_ERR(svn_cache__get((void **) &answer, &found, cache, key,
+                                 iterpool));
+          if (found && *answer != value)
+            return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                     "expected %ld but found '%ld'",
+                                     value, *answer);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+static void *
+APR_THREAD_FUNC cache_thread_func(apr_thread_t *tid, void *data)
+{
+  cache_thread_baton_t *baton = data;
+  apr_pool_t *pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+  /* give all threads a good chance to get started by the scheduler */
+  apr_thread_yield();
+
+  baton->err = exercise_membuffer(baton, pool);
+  svn_pool_destroy(pool);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+#endif
+
+#define APR_ERR(expr)                           \
+  do {                                          \
+    apr_status_t status = (expr);               \
+    if (status)                                 \
+      return svn_error_wrap_apr(status, NULL);  \
+  } while (0)
+
+/* Let THREAD_COUNT threads execute ITERATIONS cache operations each on
+ * the shared MEMBUFFER.  Use POOL for allocations.
+ */
+static svn_error_t *
+run_membuffer_threads(svn_membuffer_t *membuffer,
+                      int thread_count,
+                      int iterations,
+                      apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  apr_thread_t **threads = apr_pcalloc(pool, thread_count * sizeof(*threads));
+  cache_thread_baton_t *batons
+    = apr_pcalloc(pool, thread_count * sizeof(*batons));
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  for (i = 0; i < thread_count; ++i)
+    {
+      batons[i].membuffer = membuffer;
+      batons[i].id = i;
+      batons[i].iterations = iterations;
+      batons[i].key_count = 10000;
+
+      APR_ERR(apr_thread_create(&threads[i], NULL, cache_thread_func,
+                                &batons[i], pool));
+    }
+
+  /* wait for the threads to finish */
+  for (i = 0; i < thread_count; ++i)
+    {
+      apr_status_t retval;
+      APR_ERR(apr_thread_join(&retval, threads[i]));
+      APR_ERR(retval);
+
+      err = svn_error_compose_create(err, batons[i].err);
+    }
+
+  return svn_error_trace(err);
+#else
+  return SVN_NO_ERROR;
+#endif
+}
+
+static svn_error_t *
+test_membuffer_cache_concurrency(apr_pool_t *pool)
+{
+  /* Lookups may run without holding a lock.  Make sure that concurrent
+   * writes and evictions never result in corrupted data being returned.
+   * Keep the cache small to have plenty of evictions.
+   */
+  svn_membuffer_t *membuffer;
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 256 * 1024,
+                                            16 * 1024, 0, TRUE, TRUE, pool));
+
+  return svn_error_trace(run_membuffer_threads(membuffer, 8, 100000, pool));
+}
+
+static svn_error_t *
+test_membuffer_cache_scaling(apr_pool_t *pool)
+{
+  /* Measure how the throughput scales with the number of threads sharing
+   * the same cache.  Use only a few segments to keep contention high.
+   */
+  enum { ITERATIONS = 1000000 };
+  svn_membuffer_t *membuffer;
+  int thread_count;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 64 * 1024 * 1024,
+                                            4 * 1024 * 1024, 4, TRUE, TRUE,
+                                            pool));
+
+  for (thread_count = 1; thread_count <= 64; thread_count *= 2)
+    {
+      apr_time_t start = apr_time_now();
+      apr_time_t end;
+
+      SVN_ERR(run_membuffer_threads(membuffer, thread_count, ITERATIONS,
+                                    pool));
+      end = apr_time_now();
+
+      printf("%2d threads: %"APR_TIME_T_FMT" musecs, "
+             "%"APR_TIME_T_FMT" ops / sec\n",
+             thread_count, end - start,
+             ((apr_time_t)thread_count * ITERATIONS * 1000000)
+               / (end - start));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_cache_shared(apr_pool_t *pool)
+{
+#if APR_HAS_FORK
+  svn_membuffer_t *membuffer;
+  svn_cache__t *cache;
+  svn_error_t *err;
+  apr_proc_t proc;
+  apr_status_t status;
+  int exit_code;
+  apr_exit_why_e exit_why;
+  svn_boolean_t found;
+  svn_revnum_t *value;
+  svn_revnum_t twenty = 20;
+  apr_uint32_t key = 1;
+
+  err = svn_cache__membuffer_cache_create_shared(&membuffer, 64 * 1024,
+                                                 8 * 1024, 0, TRUE, pool);
+  if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+    {
+      svn_error_clear(err);
+      return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                              "shared memory caches not supported");
+    }
+  SVN_ERR(err);
+
+  /* Use short fixed-size keys that would normally get abbreviated
+   * using process-local prefix indexes. */
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(key),
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            TRUE,
+                                            FALSE,
+                                            pool, pool));
+
+  /* Let a child process fill the cache. */
+  fflush(stdout);
+  status = apr_proc_fork(&proc, pool);
+  if (status == APR_INCHILD)
+    {
+      err = svn_cache__set(cache, &key, &twenty, pool);
+      exit(err ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+  else if (status != APR_INPARENT)
+    {
+      return svn_error_wrap_apr(status, "apr_proc_fork");
+    }
+
+  status = apr_proc_wait(&proc, &exit_code, &exit_why, APR_WAIT);
+  if (status != APR_CHILD_DONE)
+    return svn_error_wrap_apr(status, "apr_proc_wait");
+  SVN_TEST_ASSERT(APR_PROC_CHECK_EXIT(exit_why));
+  SVN_TEST_ASSERT(exit_code == EXIT_SUCCESS);
+
+  /* The parent must see the data written by the child. */
+  SVN_ERR(svn_cache__get((void **) &value, &found, cache, &key, pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_ASSERT(*value == 20);
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "fork() not supported");
+#endif
+}
+
+#if APR_HAS_FORK
+/* Implements svn_cache__partial_setter_func_t.  Start overwriting the
+ * cached item in-place and kill the current process before completing
+ * the change. */
+static svn_error_t *
+die_while_writing(void **data,
+                  apr_size_t *data_len,
+                  void *baton,
+                  apr_pool_t *result_pool)
+{
+  memset(*data, 0xff, *data_len / 2);
+  raise(SIGKILL);
+
+  /* NOTREACHED */
+  return SVN_NO_ERROR;
+}
+#endif
+
+static svn_error_t *
+test_membuffer_cache_shared_writer_died(apr_pool_t *pool)
+{
+#if APR_HAS_FORK
+  svn_membuffer_t *membuffer;
+  svn_cache__t *cache;
+  svn_error_t *err;
+  apr_proc_t proc;
+  apr_status_t status;
+  int exit_code;
+  apr_exit_why_e exit_why;
+  svn_boolean_t found;
+  svn_revnum_t *value;
+  svn_revnum_t ten = 10;
+  svn_revnum_t twenty = 20;
+  apr_uint32_t key1 = 1;
+  apr_uint32_t key2 = 2;
+
+  /* Use a single segment, so both entries live in the same one. */
+  err = svn_cache__membuffer_cache_create_shared(&membuffer, 64 * 1024,
+                                                 8 * 1024, 1, TRUE, pool);
+  if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+    {
+      svn_error_clear(err);
+      return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                              "shared memory caches not supported");
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(key1),
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            TRUE,
+                                            FALSE,
+                                            pool, pool));
+
+  SVN_ERR(svn_cache__set(cache, &key1, &ten, pool));
+  SVN_ERR(svn_cache__set(cache, &key2, &twenty, pool));
+
+  /* Let a child process die while it holds the write lock. */
+  fflush(stdout);
+  status = apr_proc_fork(&proc, pool);
+  if (status == APR_INCHILD)
+    {
+      svn_error_clear(svn_cache__set_partial(cache, &key1,
+                                             die_while_writing, NULL,
+                                             pool));
+      exit(EXIT_FAILURE);
+    }
+  else if (status != APR_INPARENT)
+    {
+      return svn_error_wrap_apr(status, "apr_proc_fork");
+    }
+
+  status = apr_proc_wait(&proc, &exit_code, &exit_why, APR_WAIT);
+  if (status != APR_CHILD_DONE)
+    return svn_error_wrap_apr(status, "apr_proc_wait");
+  SVN_TEST_ASSERT(APR_PROC_CHECK_SIGNALED(exit_why));
+  SVN_TEST_ASSERT(exit_code == SIGKILL);
+
+  /* The lock must still be usable and the half-written segment must have
+   * been reset instead of returning corrupted data. */
+  SVN_ERR(svn_cache__get((void **) &value, &found, cache, &key1, pool));
+  SVN_TEST_ASSERT(!found);
+  SVN_ERR(svn_cache__get((void **) &value, &found, cache, &key2, pool));
+  SVN_TEST_ASSERT(!found);
+
+  /* The segment works as usual afterwards. */
+  SVN_ERR(svn_cache__set(cache, &key1, &twenty, pool));
+  SVN_ERR(svn_cache__get((void **) &value, &found, cache, &key1, pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_ASSERT(*value == 20);
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "fork() not supported");
+#endif
+}
+
+
+/* Implements svn_cache__snapshot_filter_t.  Reject all prefixes equal
+ * to the C string BATON. */
+static svn_error_t *
+reject_prefix(svn_boolean_t *keep,
+              void *baton,
+              const char *prefix,
+              apr_pool_t *scratch_pool)
+{
+  *keep = strcmp(prefix, baton) != 0;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_cache_snapshot(apr_pool_t *pool)
+{
+  svn_membuffer_t *source, *target;
+  svn_cache__t *source_short, *source_long, *source_rejected;
+  svn_cache__t *target_short, *target_long, *target_rejected;
+  svn_stringbuf_t *snapshot = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream;
+  svn_revnum_t twenty = 20, thirty = 30;
+  apr_uint32_t short_key = 1;
+  const char *long_key = "a key that is longer than 16 bytes";
+  svn_revnum_t *value;
+  svn_boolean_t found;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&source, 10*1024, 1, 0,
+                                            TRUE, TRUE, pool));
+  SVN_ERR(svn_cache__membuffer_cache_create(&target, 20*1024, 1, 0,
+                                            TRUE, TRUE, pool));
+
+  /* Fill the source cache with items using shared and full keys. */
+  SVN_ERR(svn_cache__create_membuffer_cache(&source_short, source,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(short_key), "short:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&source_long, source,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING, "long:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&source_rejected, source,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(short_key), "rejected:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+
+  SVN_ERR(svn_cache__set(source_short, &short_key, &twenty, pool));
+  SVN_ERR(svn_cache__set(source_long, long_key, &thirty, pool));
+  SVN_ERR(svn_cache__set(source_rejected, &short_key, &twenty, pool));
+
+  /* Copy the contents to the target cache via a snapshot. */
+  stream = svn_stream_from_stringbuf(snapshot, pool);
+  SVN_ERR(svn_cache__membuffer_save(source, stream, NULL, NULL, NULL, NULL,
+                                    pool));
+  stream = svn_stream_from_stringbuf(snapshot, pool);
+  SVN_ERR(svn_cache__membuffer_load(target, stream, reject_prefix,
+                                    "rejected:", NULL, NULL, pool));
+
+  /* Check the target cache contents. */
+  SVN_ERR(svn_cache__create_membuffer_cache(&target_short, target,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(short_key), "short:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&target_long, target,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING, "long:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&target_rejected, target,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(short_key), "rejected:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+
+  SVN_ERR(svn_cache__get((void **) &value, &found, target_short, &short_key,
+                         pool));
+  SVN_TEST_ASSERT(found && *value == 20);
+  SVN_ERR(svn_cache__get((void **) &value, &found, target_long, long_key,
+                         pool));
+  SVN_TEST_ASSERT(found && *value == 30);
+  SVN_ERR(svn_cache__get((void **) &value, &found, target_rejected,
+                         &short_key, pool));
+  SVN_TEST_ASSERT(!found);
+
+  /* Truncated snapshots must be detected. */
+  svn_stringbuf_chop(snapshot, 1);
+  stream = svn_stream_from_stringbuf(snapshot, pool);
+  SVN_TEST_ASSERT_ERROR(svn_cache__membuffer_load(target, stream, NULL, NULL,
+                                                  NULL, NULL, pool),
+                        SVN_ERR_MALFORMED_FILE);
+
+  return SVN_NO_ERROR;
+}
+
+
 
 /* The test table.  */
 
@@ -616,6 +1088,17 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test membuffer cache with unaligned string keys"),
     SVN_TEST_PASS2(test_membuffer_unaligned_fixed_keys,
                    "test membuffer cache with unaligned fixed keys"),
+    SVN_TEST_SKIP2(test_membuffer_cache_concurrency,
+                   ! APR_HAS_THREADS,
+                   "test concurrent membuffer cache access"),
+    SVN_TEST_SKIP2(test_membuffer_cache_scaling, TRUE,
+                   "membuffer cache multi-threaded scaling"),
+    SVN_TEST_PASS2(test_membuffer_cache_shared,
+                   "membuffer cache shared between processes"),
+    SVN_TEST_PASS2(test_membuffer_cache_shared_writer_died,
+                   "shared membuffer cache survives a dying writer"),
+    SVN_TEST_PASS2(test_membuffer_cache_snapshot,
+                   "save and load membuffer cache snapshots"),
     SVN_TEST_NULL
   };
 
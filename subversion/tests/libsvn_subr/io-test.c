@@ -1228,6 +1228,25 @@ test_rmtree_all_readonly(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_timestamp_racy(apr_pool_t *pool)
+{
+  apr_time_t now = apr_time_now();
+  apr_time_t margin = apr_time_from_msec(SVN_HI_RES_SLEEP_MS);
+
+  SVN_TEST_ASSERT(svn_io__is_timestamp_racy(now, now));
+  SVN_TEST_ASSERT(svn_io__is_timestamp_racy(now - margin + 1, now));
+  SVN_TEST_ASSERT(!svn_io__is_timestamp_racy(now - margin, now));
+  SVN_TEST_ASSERT(!svn_io__is_timestamp_racy(now - apr_time_from_sec(60),
+                                             now));
+
+  /* Timestamps from the future could still be repeated. */
+  SVN_TEST_ASSERT(svn_io__is_timestamp_racy(now + apr_time_from_sec(60),
+                                            now));
+
+  return SVN_NO_ERROR;
+}
+
 
 /* The test table.  */
 
@@ -1274,6 +1293,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_io_remove_dir2() with read-only directory"),
     SVN_TEST_PASS2(test_rmtree_all_readonly,
                    "test svn_io_remove_dir2() with read-only tree"),
+    SVN_TEST_PASS2(test_timestamp_racy,
+                   "test svn_io__is_timestamp_racy()"),
     SVN_TEST_NULL
   };
 
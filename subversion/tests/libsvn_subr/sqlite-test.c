@@ -21,6 +21,9 @@
  * ====================================================================
  */
 
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+
 #include "private/svn_sqlite.h"
 #include "../svn_test.h"
 
@@ -170,6 +173,224 @@ test_sqlite_txn_commit_busy(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_sqlite_fetch_rows(apr_pool_t *pool)
+{
+  svn_sqlite__db_t *sdb;
+  svn_sqlite__stmt_t *stmt;
+  svn_sqlite__rows_t *rows;
+  apr_size_t len;
+  const void *blob;
+  int i;
+
+  static const char *const statements[] = {
+    "CREATE TABLE rows ("
+    "    name TEXT NOT NULL PRIMARY KEY,"
+    "    kind TEXT,"
+    "    num INTEGER,"
+    "    data BLOB"
+    ");",
+
+    "INSERT INTO rows(name, kind, num, data) VALUES (?1, ?2, ?3, ?4)",
+
+    "SELECT name, kind, num, data FROM rows ORDER BY num",
+
+    NULL
+  };
+
+  SVN_ERR(open_db(&sdb, NULL, "fetch_rows", statements, 0, pool));
+  SVN_ERR(svn_sqlite__exec_statements(sdb, 0));
+
+  /* More rows than fit into the initial arrays. */
+  SVN_ERR(svn_sqlite__begin_transaction(sdb));
+  for (i = 0; i < 200; i++)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 1));
+      SVN_ERR(svn_sqlite__bindf(stmt, "ssi",
+                                apr_psprintf(pool, "name-%03d", i),
+                                (i % 2) ? "file" : "dir",
+                                (apr_int64_t)i));
+      if (i % 3)
+        SVN_ERR(svn_sqlite__bind_blob(stmt, 4, "a\0b", 3));
+      SVN_ERR(svn_sqlite__insert(NULL, stmt));
+    }
+  SVN_ERR(svn_sqlite__finish_transaction(sdb, SVN_NO_ERROR));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 2));
+  SVN_ERR(svn_sqlite__fetch_rows(&rows, stmt, 1 << 1, pool));
+
+  SVN_TEST_INT_ASSERT(svn_sqlite__rows_count(rows), 200);
+  for (i = 0; i < 200; i++)
+    {
+      SVN_TEST_STRING_ASSERT(svn_sqlite__rows_text(rows, i, 0),
+                             apr_psprintf(pool, "name-%03d", i));
+      SVN_TEST_STRING_ASSERT(svn_sqlite__rows_text(rows, i, 1),
+                             (i % 2) ? "file" : "dir");
+      SVN_TEST_INT_ASSERT(svn_sqlite__rows_int(rows, i, 2), i);
+      SVN_TEST_ASSERT(svn_sqlite__rows_text(rows, i, 2) == NULL);
+
+      blob = svn_sqlite__rows_blob(rows, i, 3, &len);
+      if (i % 3)
+        {
+          SVN_TEST_INT_ASSERT(len, 3);
+          SVN_TEST_ASSERT(memcmp(blob, "a\0b", 3) == 0);
+        }
+      else
+        {
+          SVN_TEST_ASSERT(blob == NULL);
+          SVN_TEST_INT_ASSERT(len, 0);
+          SVN_TEST_ASSERT(svn_sqlite__rows_is_null(rows, i, 3));
+        }
+    }
+
+  /* Interned values share their storage, others don't. */
+  SVN_TEST_ASSERT(svn_sqlite__rows_text(rows, 0, 1)
+                  == svn_sqlite__rows_text(rows, 2, 1));
+  SVN_TEST_ASSERT(svn_sqlite__rows_text(rows, 1, 1)
+                  == svn_sqlite__rows_text(rows, 3, 1));
+  SVN_TEST_ASSERT(svn_sqlite__rows_blob(rows, 1, 3, &len)
+                  != svn_sqlite__rows_blob(rows, 2, 3, &len));
+
+  /* The statement has been reset and can be used for the next query. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 2));
+  SVN_ERR(svn_sqlite__fetch_rows(&rows, stmt, 0, pool));
+  SVN_TEST_INT_ASSERT(svn_sqlite__rows_count(rows), 200);
+
+  return SVN_NO_ERROR;
+}
+
+/* Number of rows in the directory used by the fetch rows benchmark. */
+#define BENCHMARK_ROWS 50000
+
+/* The per-child information collected by the fetch rows benchmark. */
+typedef struct benchmark_child_t
+{
+  const char *name;
+  const char *kind;
+  const char *author;
+  apr_int64_t revision;
+  apr_int64_t size;
+} benchmark_child_t;
+
+/* Implements svn_test_driver_t.
+ * Compare reading the children of a synthetic large directory row by row,
+ * the way wc_db used to, with fetching them all at once.
+ */
+static svn_error_t *
+fetch_rows_benchmark(apr_pool_t *pool)
+{
+  static const char *const authors[] = { "alice", "bob", "carol", "dave" };
+  svn_sqlite__db_t *sdb;
+  svn_sqlite__stmt_t *stmt;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_time_t start;
+  int round;
+  int i;
+
+  static const char *const statements[] = {
+    "CREATE TABLE nodes ("
+    "    local_relpath TEXT NOT NULL PRIMARY KEY,"
+    "    parent_relpath TEXT,"
+    "    kind TEXT,"
+    "    changed_author TEXT,"
+    "    changed_revision INTEGER,"
+    "    translated_size INTEGER"
+    ");"
+    "CREATE INDEX i_parent ON nodes (parent_relpath, local_relpath);",
+
+    "INSERT INTO nodes VALUES (?1, ?2, ?3, ?4, ?5, ?6)",
+
+    "SELECT local_relpath, kind, changed_author, changed_revision,"
+    "       translated_size "
+    "FROM nodes WHERE parent_relpath = ?1",
+
+    NULL
+  };
+
+  SVN_ERR(open_db(&sdb, NULL, "fetch_rows_benchmark", statements, 0, pool));
+  SVN_ERR(svn_sqlite__exec_statements(sdb, 0));
+
+  SVN_ERR(svn_sqlite__begin_transaction(sdb));
+  for (i = 0; i < BENCHMARK_ROWS; i++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 1));
+      SVN_ERR(svn_sqlite__bindf(stmt, "ssssii",
+                                apr_psprintf(iterpool, "big/file-%06d", i),
+                                "big", (i % 10) ? "file" : "dir",
+                                authors[i % 4],
+                                (apr_int64_t)i / 7,
+                                (apr_int64_t)i * 3));
+      SVN_ERR(svn_sqlite__insert(NULL, stmt));
+    }
+  SVN_ERR(svn_sqlite__finish_transaction(sdb, SVN_NO_ERROR));
+
+  for (round = 0; round < 3; round++)
+    {
+      apr_hash_t *children;
+      svn_boolean_t have_row;
+      svn_sqlite__rows_t *rows;
+      benchmark_child_t *items;
+      int nrows;
+
+      /* Row by row, allocating each child and its strings separately. */
+      svn_pool_clear(iterpool);
+      start = apr_time_now();
+      children = apr_hash_make(iterpool);
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 2));
+      SVN_ERR(svn_sqlite__bindf(stmt, "s", "big"));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      while (have_row)
+        {
+          benchmark_child_t *child = apr_pcalloc(iterpool, sizeof(*child));
+          const char *relpath = svn_sqlite__column_text(stmt, 0, NULL);
+
+          child->name = svn_relpath_basename(relpath, iterpool);
+          child->kind = svn_sqlite__column_text(stmt, 1, iterpool);
+          child->author = svn_sqlite__column_text(stmt, 2, iterpool);
+          child->revision = svn_sqlite__column_int64(stmt, 3);
+          child->size = svn_sqlite__column_int64(stmt, 4);
+          apr_hash_set(children, child->name, APR_HASH_KEY_STRING, child);
+
+          SVN_ERR(svn_sqlite__step(&have_row, stmt));
+        }
+      SVN_ERR(svn_sqlite__reset(stmt));
+      SVN_TEST_INT_ASSERT(apr_hash_count(children), BENCHMARK_ROWS);
+      printf("row by row  %8.1f ms\n",
+             (double)(apr_time_now() - start) / 1000);
+
+      /* All at once, with interned kinds and authors. */
+      svn_pool_clear(iterpool);
+      start = apr_time_now();
+      children = apr_hash_make(iterpool);
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 2));
+      SVN_ERR(svn_sqlite__bindf(stmt, "s", "big"));
+      SVN_ERR(svn_sqlite__fetch_rows(&rows, stmt, (1 << 1) | (1 << 2),
+                                     iterpool));
+      nrows = svn_sqlite__rows_count(rows);
+      items = apr_pcalloc(iterpool, nrows * sizeof(*items));
+      for (i = 0; i < nrows; i++)
+        {
+          benchmark_child_t *child = &items[i];
+
+          child->name = svn_relpath_basename(
+                          svn_sqlite__rows_text(rows, i, 0), NULL);
+          child->kind = svn_sqlite__rows_text(rows, i, 1);
+          child->author = svn_sqlite__rows_text(rows, i, 2);
+          child->revision = svn_sqlite__rows_int64(rows, i, 3);
+          child->size = svn_sqlite__rows_int64(rows, i, 4);
+          apr_hash_set(children, child->name, APR_HASH_KEY_STRING, child);
+        }
+      SVN_TEST_INT_ASSERT(apr_hash_count(children), BENCHMARK_ROWS);
+      printf("bulk        %8.1f ms\n",
+             (double)(apr_time_now() - start) / 1000);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 
 static int max_threads = 1;
 
@@ -180,6 +401,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "sqlite reset"),
     SVN_TEST_PASS2(test_sqlite_txn_commit_busy,
                    "sqlite busy on transaction commit"),
+    SVN_TEST_PASS2(test_sqlite_fetch_rows,
+                   "sqlite fetch rows in bulk"),
+    SVN_TEST_SKIP2(fetch_rows_benchmark, TRUE,
+                   "fetch rows of a large directory benchmark"),
     SVN_TEST_NULL
   };
 
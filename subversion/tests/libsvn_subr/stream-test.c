@@ -26,6 +26,7 @@
 #include "svn_io.h"
 #include "svn_subst.h"
 #include "svn_base64.h"
+#include "svn_sorts.h"
 #include <apr_general.h>
 
 #include "private/svn_io_private.h"
@@ -848,6 +849,98 @@ test_stream_compressed_read_full(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_stream_compressed_lz4(apr_pool_t *pool)
+{
+  /* Sizes around the compressor's block size of 64k, written in pieces
+     that don't line up with the blocks. */
+  static const int sizes[] = { 0, 1, 1000, 65535, 65536, 65537, 300000 };
+  static const apr_size_t chunk_sizes[] = { 1, 77, 4096, 100000 };
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_size_t i, j;
+
+  for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    for (j = 0; j < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); j++)
+      {
+        svn_stringbuf_t *origbuf, *compressed, *inbuf;
+        svn_stream_t *stream;
+        apr_size_t pos;
+        apr_size_t len;
+        char buf[1000];
+
+        svn_pool_clear(iterpool);
+
+        origbuf = generate_test_bytes(sizes[i], iterpool);
+        compressed = svn_stringbuf_create_empty(iterpool);
+        inbuf = svn_stringbuf_create_empty(iterpool);
+
+        stream = svn_stream__compressed_lz4(
+                   svn_stream_from_stringbuf(compressed, iterpool),
+                   iterpool);
+        for (pos = 0; pos < origbuf->len; pos += len)
+          {
+            len = MIN(chunk_sizes[j], origbuf->len - pos);
+            SVN_ERR(svn_stream_write(stream, origbuf->data + pos, &len));
+          }
+        SVN_ERR(svn_stream_close(stream));
+
+        /* The generated data is very repetitive. */
+        if (sizes[i] >= 1000)
+          SVN_TEST_ASSERT(compressed->len < origbuf->len);
+
+        stream = svn_stream__compressed_lz4(
+                   svn_stream_from_stringbuf(compressed, iterpool),
+                   iterpool);
+        do
+          {
+            len = sizeof(buf);
+            SVN_ERR(svn_stream_read_full(stream, buf, &len));
+            svn_stringbuf_appendbytes(inbuf, buf, len);
+          }
+        while (len == sizeof(buf));
+        SVN_ERR(svn_stream_close(stream));
+
+        SVN_TEST_ASSERT(svn_stringbuf_compare(inbuf, origbuf));
+      }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_stream_compressed_lz4_truncated(apr_pool_t *pool)
+{
+  svn_stringbuf_t *origbuf = generate_test_bytes(100000, pool);
+  svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream;
+  apr_size_t len = origbuf->len;
+  char buf[1000];
+  svn_error_t *err;
+
+  stream = svn_stream__compressed_lz4(svn_stream_from_stringbuf(compressed,
+                                                                pool),
+                                      pool);
+  SVN_ERR(svn_stream_write(stream, origbuf->data, &len));
+  SVN_ERR(svn_stream_close(stream));
+
+  /* Cut the last block short. */
+  svn_stringbuf_chop(compressed, 10);
+
+  stream = svn_stream__compressed_lz4(svn_stream_from_stringbuf(compressed,
+                                                                pool),
+                                      pool);
+  do
+    {
+      len = sizeof(buf);
+      err = svn_stream_read_full(stream, buf, &len);
+    }
+  while (!err && len == sizeof(buf));
+
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_STREAM_MALFORMED_DATA);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_stream_checksum(apr_pool_t *pool)
 {
@@ -1104,6 +1197,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test reading CRLF-terminated lines from file"),
     SVN_TEST_PASS2(test_stream_readline_file_nul,
                    "test reading line from file with nul bytes"),
+    SVN_TEST_PASS2(test_stream_compressed_lz4,
+                   "test LZ4 compressed streams"),
+    SVN_TEST_PASS2(test_stream_compressed_lz4_truncated,
+                   "test truncated LZ4 compressed streams"),
     SVN_TEST_NULL
   };
 
@@ -849,6 +849,14 @@ test_string_matching(apr_pool_t *pool)
       {"x_234567890abcdef", "x1234567890abcdef", 1, 15},
       {"1234567890abcdefx", "1234567890abcdex", 15, 1},
 
+      /* matches spanning multiple 16 byte chunks */
+      {"0123456789abcdef0123456789abcdef0123456789_",
+       "0123456789abcdef0123456789abcdef0123456789x", 42, 0},
+      {"_0123456789abcdef0123456789abcdef0123456789",
+       "x0123456789abcdef0123456789abcdef0123456789", 0, 42},
+      {"0123456789abcdef0123_56789abcdef0123456789abcdef",
+       "0123456789abcdef0123456789abcdef0123456789abcdef", 20, 27},
+
       /* list terminator */
       {NULL}
     };
@@ -31,6 +31,7 @@
 #include "svn_string.h"
 #include "svn_subst.h"
 #include "svn_hash.h"
+#include "private/svn_subr_private.h"
 
 #define ARRAY_LEN(ary) ((sizeof (ary)) / (sizeof ((ary)[0])))
 
@@ -500,6 +501,122 @@ test_svn_subst_long_keywords(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Compare the results of svn_subst__translated_contents_same() and
+ * svn_subst__translated_checksum() on SOURCE with those of a translated
+ * stream, using EOL_STR, REPAIR, KEYWORDS and EXPAND. */
+static svn_error_t *
+check_translated_contents(const svn_string_t *source,
+                          const char *eol_str,
+                          svn_boolean_t repair,
+                          apr_hash_t *keywords,
+                          svn_boolean_t expand,
+                          apr_pool_t *pool)
+{
+  svn_stringbuf_t *expected = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *other;
+  svn_stream_t *stream;
+  svn_checksum_t *checksum;
+  svn_checksum_t *expected_checksum;
+  svn_boolean_t same;
+
+  stream = svn_subst_stream_translated(
+             svn_stream_from_stringbuf(expected, pool),
+             eol_str, repair, keywords, expand, pool);
+  SVN_ERR(svn_stream_copy3(svn_stream_from_string(source, pool), stream,
+                           NULL, NULL, pool));
+
+  SVN_ERR(svn_subst__translated_contents_same(
+            &same, svn_stream_from_string(source, pool),
+            svn_stream_from_stringbuf(expected, pool),
+            eol_str, repair, keywords, expand, pool));
+  SVN_TEST_ASSERT(same);
+
+  SVN_ERR(svn_checksum(&expected_checksum, svn_checksum_sha1,
+                       expected->data, expected->len, pool));
+  SVN_ERR(svn_subst__translated_checksum(
+            &checksum, svn_stream_from_string(source, pool),
+            svn_checksum_sha1, eol_str, repair, keywords, expand,
+            pool, pool));
+  SVN_TEST_ASSERT(svn_checksum_match(checksum, expected_checksum));
+
+  /* A difference in the last byte. */
+  other = svn_stringbuf_dup(expected, pool);
+  other->data[other->len - 1] ^= 1;
+  SVN_ERR(svn_subst__translated_contents_same(
+            &same, svn_stream_from_string(source, pool),
+            svn_stream_from_stringbuf(other, pool),
+            eol_str, repair, keywords, expand, pool));
+  SVN_TEST_ASSERT(!same);
+
+  /* One byte short. */
+  other = svn_stringbuf_dup(expected, pool);
+  svn_stringbuf_chop(other, 1);
+  SVN_ERR(svn_subst__translated_contents_same(
+            &same, svn_stream_from_string(source, pool),
+            svn_stream_from_stringbuf(other, pool),
+            eol_str, repair, keywords, expand, pool));
+  SVN_TEST_ASSERT(!same);
+
+  /* One byte too many. */
+  other = svn_stringbuf_dup(expected, pool);
+  svn_stringbuf_appendbyte(other, 'x');
+  SVN_ERR(svn_subst__translated_contents_same(
+            &same, svn_stream_from_string(source, pool),
+            svn_stream_from_stringbuf(other, pool),
+            eol_str, repair, keywords, expand, pool));
+  SVN_TEST_ASSERT(!same);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_svn_subst_translated_contents(apr_pool_t *pool)
+{
+  svn_stringbuf_t *expanded = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *contracted = svn_stringbuf_create_empty(pool);
+  apr_hash_t *keywords = apr_hash_make(pool);
+  int i;
+
+  svn_hash_sets(keywords, "Rev", svn_string_create("1234", pool));
+  svn_hash_sets(keywords, "Author", svn_string_create("jrandom", pool));
+
+  /* Several chunks worth of lines, so that keywords and CRLF pairs get
+     split between reads. */
+  for (i = 0; expanded->len < 3 * SVN__STREAM_CHUNK_SIZE + 100; i++)
+    {
+      const char *eol = (i % 3) ? "\r\n" : "\n";
+
+      svn_stringbuf_appendcstr(contracted,
+                               apr_psprintf(pool, "line %d $Rev$ and "
+                                            "$Author$ cost $%d%s",
+                                            i, i, eol));
+      svn_stringbuf_appendcstr(expanded,
+                               apr_psprintf(pool, "line %d $Rev: 1234 $ and "
+                                            "$Author: jrandom $ cost $%d%s",
+                                            i, i, eol));
+    }
+
+  /* Detranslating a working file, repairing its EOLs. */
+  SVN_ERR(check_translated_contents(svn_string_create_from_buf(expanded,
+                                                                pool),
+                                    "\n", TRUE, keywords, FALSE, pool));
+  SVN_ERR(check_translated_contents(svn_string_create_from_buf(expanded,
+                                                                pool),
+                                    "\r\n", TRUE, NULL, FALSE, pool));
+
+  /* Translating a pristine text into working copy form. */
+  SVN_ERR(check_translated_contents(svn_string_create_from_buf(contracted,
+                                                                pool),
+                                    NULL, FALSE, keywords, TRUE, pool));
+
+  /* Without any translation. */
+  SVN_ERR(check_translated_contents(svn_string_create_from_buf(contracted,
+                                                                pool),
+                                    NULL, FALSE, NULL, FALSE, pool));
+
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = 1;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -519,6 +636,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test truncated keywords (issue 4349)"),
     SVN_TEST_PASS2(test_svn_subst_long_keywords,
                    "test long keywords (issue 4350)"),
+    SVN_TEST_PASS2(test_svn_subst_translated_contents,
+                   "test single-pass translated compare and checksum"),
     SVN_TEST_NULL
   };
 
@@ -0,0 +1,193 @@
+/*
+ * task-test.c -- test the svn_task__* API
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+#include <apr_thread_proc.h>
+
+#include "svn_pools.h"
+#include "private/svn_task.h"
+
+#include "../svn_test.h"
+
+/* Number of tasks to push in each test. */
+#define TASK_COUNT 1000
+
+/* Implements svn_task__process_func_t.  TASK is an int.  Return its square
+ * as result unless it equals *PROCESS_BATON, in which case return an
+ * error. */
+static svn_error_t *
+square(void **result,
+       void *task,
+       void *process_baton,
+       apr_pool_t *result_pool,
+       apr_pool_t *scratch_pool)
+{
+  int value = *(int *)task;
+  int *squared;
+
+  if (process_baton && value == *(int *)process_baton)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Failing task %d", value);
+
+  /* Make tasks complete out of order. */
+#if APR_HAS_THREADS
+  if (value % 7 == 0)
+    apr_thread_yield();
+#endif
+
+  squared = apr_palloc(result_pool, sizeof(*squared));
+  *squared = value * value;
+  *result = squared;
+
+  return SVN_NO_ERROR;
+}
+
+/* Push an int task with VALUE into QUEUE. */
+static svn_error_t *
+push_value(svn_task__queue_t *queue,
+           int value)
+{
+  apr_pool_t *task_pool = svn_pool_create(NULL);
+  int *task = apr_palloc(task_pool, sizeof(*task));
+  *task = value;
+
+  return svn_error_trace(svn_task__queue_push(queue, task, task_pool));
+}
+
+/* Pop the next result from QUEUE and verify that it belongs to VALUE. */
+static svn_error_t *
+pop_value(svn_task__queue_t *queue,
+          int value)
+{
+  void *result;
+  void *task;
+  apr_pool_t *task_pool;
+
+  SVN_ERR(svn_task__queue_pop(&result, &task, &task_pool, queue));
+  SVN_TEST_INT_ASSERT(*(int *)task, value);
+  SVN_TEST_INT_ASSERT(*(int *)result, value * value);
+  svn_pool_destroy(task_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Run TASK_COUNT tasks through a queue with THREAD_COUNT workers, never
+ * having more than WINDOW of them pending. */
+static svn_error_t *
+run_ordered(int thread_count,
+            int window,
+            apr_pool_t *pool)
+{
+  svn_task__queue_t *queue;
+  apr_pool_t *queue_pool = svn_pool_create(pool);
+  int pushed, popped;
+
+  SVN_ERR(svn_task__queue_create(&queue, thread_count, window, square,
+                                 NULL, queue_pool));
+
+  for (pushed = 0, popped = 0; pushed < TASK_COUNT; ++pushed)
+    {
+      if (svn_task__queue_size(queue) == window)
+        SVN_ERR(pop_value(queue, popped++));
+
+      SVN_ERR(push_value(queue, pushed));
+    }
+
+  while (popped < TASK_COUNT)
+    SVN_ERR(pop_value(queue, popped++));
+
+  SVN_TEST_INT_ASSERT(svn_task__queue_size(queue), 0);
+  svn_pool_destroy(queue_pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_sequential(apr_pool_t *pool)
+{
+  return svn_error_trace(run_ordered(0, 16, pool));
+}
+
+static svn_error_t *
+test_concurrent(apr_pool_t *pool)
+{
+  return svn_error_trace(run_ordered(8, 64, pool));
+}
+
+static svn_error_t *
+test_errors(apr_pool_t *pool)
+{
+  svn_task__queue_t *queue;
+  apr_pool_t *queue_pool = svn_pool_create(pool);
+  int failing = 5;
+  int i;
+  void *result;
+  apr_pool_t *task_pool;
+
+  SVN_ERR(svn_task__queue_create(&queue, 4, 0, square, &failing,
+                                 queue_pool));
+  for (i = 0; i < 10; ++i)
+    SVN_ERR(push_value(queue, i));
+
+  /* Errors get reported in order, too, and don't affect other tasks. */
+  for (i = 0; i < failing; ++i)
+    SVN_ERR(pop_value(queue, i));
+
+  SVN_TEST_ASSERT_ERROR(svn_task__queue_pop(&result, NULL, &task_pool,
+                                            queue),
+                        SVN_ERR_TEST_FAILED);
+  svn_pool_destroy(task_pool);
+
+  SVN_ERR(pop_value(queue, failing + 1));
+
+  /* Pending tasks get discarded upon shutdown. */
+  SVN_ERR(svn_task__queue_shutdown(queue));
+  SVN_TEST_ASSERT_ERROR(push_value(queue, 42), SVN_ERR_CANCELLED);
+  SVN_TEST_ASSERT_ERROR(svn_task__queue_pop(&result, NULL, &task_pool,
+                                            queue),
+                        SVN_ERR_CANCELLED);
+  svn_pool_destroy(queue_pool);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* The test table.  */
+
+static int max_threads = 1;
+
+static struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_PASS2(test_sequential,
+                   "test task queue without threads"),
+    SVN_TEST_SKIP2(test_concurrent,
+                   ! APR_HAS_THREADS,
+                   "test in-order results of concurrent tasks"),
+    SVN_TEST_SKIP2(test_errors,
+                   ! APR_HAS_THREADS,
+                   "test error reporting and shutdown of task queues"),
+    SVN_TEST_NULL
+  };
+
+SVN_TEST_MAIN
@@ -39,6 +39,7 @@
 #include "svn_repos.h"
 #include "svn_wc.h"
 #include "svn_client.h"
+#include "svn_config.h"
 
 #include "utils.h"
 
@@ -306,6 +307,185 @@ reject_mismatching_text(const svn_test_opts_t *opts,
 #endif
 }
 
+/* Install and read back a pristine text in a working copy that stores
+ * pristine texts compressed. */
+static svn_error_t *
+pristine_compressed(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_test__sandbox_t sandbox;
+  svn_config_t *config;
+  svn_wc_context_t *wc_ctx;
+  const char *wc_abspath;
+  svn_wc__db_install_data_t *install_data;
+  svn_stream_t *pristine_stream;
+  svn_checksum_t *data_sha1, *data_md5;
+  svn_stringbuf_t *data = svn_stringbuf_create_empty(pool);
+  apr_size_t sz;
+  int i;
+
+  SVN_ERR(svn_test__sandbox_create(&sandbox, "pristine_compressed", opts,
+                                   pool));
+
+  /* Create a second working copy with a DB that compresses pristines. */
+  SVN_ERR(svn_config_create2(&config, FALSE, FALSE, pool));
+  svn_config_set_bool(config, SVN_CONFIG_SECTION_WORKING_COPY,
+                      SVN_CONFIG_OPTION_COMPRESS_PRISTINES, TRUE);
+  SVN_ERR(svn_wc_context_create(&wc_ctx, config, pool, pool));
+
+  wc_abspath = svn_dirent_join(sandbox.wc_abspath, "compressed", pool);
+  SVN_ERR(svn_io_make_dir_recursively(wc_abspath, pool));
+  SVN_ERR(svn_wc_ensure_adm5(wc_ctx, wc_abspath, sandbox.repos_url,
+                             sandbox.repos_url,
+                             "00000000-0000-0000-0000-000000000000",
+                             0, svn_depth_infinity, TRUE, pool));
+
+  for (i = 0; i < 1000; i++)
+    svn_stringbuf_appendcstr(data, "A line of very compressible text.\n");
+
+  SVN_ERR(svn_wc__db_pristine_prepare_install(&pristine_stream,
+                                              &install_data,
+                                              &data_sha1, &data_md5,
+                                              wc_ctx->db, wc_abspath,
+                                              pool, pool));
+  sz = data->len;
+  SVN_ERR(svn_stream_write(pristine_stream, data->data, &sz));
+  SVN_ERR(svn_stream_close(pristine_stream));
+  SVN_ERR(svn_wc__db_pristine_install(install_data, data_sha1, data_md5,
+                                      pool));
+
+  /* The text is stored compressed. */
+  {
+    svn_boolean_t compressed;
+
+    SVN_ERR(svn_wc__db_pristine_is_compressed(&compressed, wc_ctx->db,
+                                              wc_abspath, data_sha1, pool));
+    SVN_TEST_ASSERT(compressed);
+  }
+
+  /* Reading it gives the original text and size. */
+  {
+    svn_stream_t *data_read_back;
+    svn_filesize_t size;
+    svn_boolean_t same;
+
+    SVN_ERR(svn_wc__db_pristine_read(&data_read_back, &size, wc_ctx->db,
+                                     wc_abspath, data_sha1, pool, pool));
+    SVN_TEST_ASSERT(size == (svn_filesize_t)data->len);
+    SVN_ERR(svn_stream_contents_same2(
+              &same, data_read_back,
+              svn_stream_from_stringbuf(data, pool), pool));
+    SVN_TEST_ASSERT(same);
+  }
+
+  /* Its path is that of a file with the original text. */
+  {
+    const char *pristine_abspath;
+    svn_stringbuf_t *contents;
+
+    SVN_ERR(svn_wc__db_pristine_get_path(&pristine_abspath, wc_ctx->db,
+                                         wc_abspath, data_sha1, pool, pool));
+    SVN_ERR(svn_stringbuf_from_file2(&contents, pristine_abspath, pool));
+    SVN_TEST_ASSERT(svn_stringbuf_compare(contents, data));
+  }
+
+  return SVN_NO_ERROR;
+}
+
+/* Install TEXT as a pristine text in the working copy WC_ABSPATH of DB.
+ * Set *SHA1 to its checksum. */
+static svn_error_t *
+install_text(svn_checksum_t **sha1,
+             svn_wc__db_t *db,
+             const char *wc_abspath,
+             const char *text,
+             apr_pool_t *pool)
+{
+  svn_wc__db_install_data_t *install_data;
+  svn_stream_t *pristine_stream;
+  svn_checksum_t *md5;
+  apr_size_t sz = strlen(text);
+
+  SVN_ERR(svn_wc__db_pristine_prepare_install(&pristine_stream,
+                                              &install_data, sha1, &md5,
+                                              db, wc_abspath, pool, pool));
+  SVN_ERR(svn_stream_write(pristine_stream, text, &sz));
+  SVN_ERR(svn_stream_close(pristine_stream));
+
+  return svn_error_trace(svn_wc__db_pristine_install(install_data,
+                                                     *sha1, md5, pool));
+}
+
+/* Share a pristine text between two working copies through a shared
+ * pristine store, and remove it from there once neither uses it. */
+static svn_error_t *
+pristine_shared_store(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_test__sandbox_t sandbox;
+  svn_config_t *config;
+  svn_wc_context_t *wc_ctx;
+  const char *shared_abspath;
+  const char *wc1_abspath, *wc2_abspath;
+  const char *text_abspath;
+  svn_checksum_t *sha1;
+  apr_finfo_t finfo;
+  const char data[] = "Shared text";
+
+  SVN_ERR(svn_test__sandbox_create(&sandbox, "pristine_shared_store", opts,
+                                   pool));
+
+  shared_abspath = svn_dirent_join(sandbox.wc_abspath, "shared", pool);
+  SVN_ERR(svn_config_create2(&config, FALSE, FALSE, pool));
+  svn_config_set(config, SVN_CONFIG_SECTION_WORKING_COPY,
+                 SVN_CONFIG_OPTION_SHARED_PRISTINE_STORE, shared_abspath);
+  SVN_ERR(svn_wc_context_create(&wc_ctx, config, pool, pool));
+
+  wc1_abspath = svn_dirent_join(sandbox.wc_abspath, "wc1", pool);
+  wc2_abspath = svn_dirent_join(sandbox.wc_abspath, "wc2", pool);
+  SVN_ERR(svn_io_make_dir_recursively(wc1_abspath, pool));
+  SVN_ERR(svn_io_make_dir_recursively(wc2_abspath, pool));
+  SVN_ERR(svn_wc_ensure_adm5(wc_ctx, wc1_abspath, sandbox.repos_url,
+                             sandbox.repos_url,
+                             "00000000-0000-0000-0000-000000000000",
+                             0, svn_depth_infinity, TRUE, pool));
+  SVN_ERR(svn_wc_ensure_adm5(wc_ctx, wc2_abspath, sandbox.repos_url,
+                             sandbox.repos_url,
+                             "00000000-0000-0000-0000-000000000000",
+                             0, svn_depth_infinity, TRUE, pool));
+
+  /* The first working copy adds the text to the shared store. */
+  SVN_ERR(install_text(&sha1, wc_ctx->db, wc1_abspath, data, pool));
+  SVN_ERR(svn_wc__db_pristine_get_shared_path(&text_abspath, wc_ctx->db,
+                                              sha1, pool, pool));
+  SVN_TEST_ASSERT(text_abspath != NULL);
+
+  SVN_ERR(svn_io_stat(&finfo, text_abspath, APR_FINFO_NLINK, pool));
+  if (!(finfo.valid & APR_FINFO_NLINK) || finfo.nlink != 2)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "Hard links are not supported here");
+
+  /* The second one links to the same file. */
+  SVN_ERR(install_text(&sha1, wc_ctx->db, wc2_abspath, data, pool));
+  SVN_ERR(svn_io_stat(&finfo, text_abspath, APR_FINFO_NLINK, pool));
+  SVN_TEST_ASSERT(finfo.nlink == 3);
+
+  /* Cleaning up keeps the text while a working copy still links to it. */
+  SVN_ERR(svn_wc__db_pristine_remove(wc_ctx->db, wc1_abspath, sha1, pool));
+  SVN_ERR(svn_wc__db_pristine_cleanup(wc_ctx->db, wc1_abspath, pool));
+  SVN_ERR(svn_wc__db_pristine_get_shared_path(&text_abspath, wc_ctx->db,
+                                              sha1, pool, pool));
+  SVN_TEST_ASSERT(text_abspath != NULL);
+
+  SVN_ERR(svn_wc__db_pristine_remove(wc_ctx->db, wc2_abspath, sha1, pool));
+  SVN_ERR(svn_wc__db_pristine_cleanup(wc_ctx->db, wc2_abspath, pool));
+  SVN_ERR(svn_wc__db_pristine_get_shared_path(&text_abspath, wc_ctx->db,
+                                              sha1, pool, pool));
+  SVN_TEST_ASSERT(text_abspath == NULL);
+
+  return SVN_NO_ERROR;
+}
+
 
 static int max_threads = -1;
 
@@ -318,6 +498,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pristine_delete_while_open"),
     SVN_TEST_OPTS_PASS(reject_mismatching_text,
                        "reject_mismatching_text"),
+    SVN_TEST_OPTS_PASS(pristine_compressed,
+                       "pristine_compressed"),
+    SVN_TEST_OPTS_PASS(pristine_shared_store,
+                       "pristine_shared_store"),
     SVN_TEST_NULL
   };
 
@@ -71,6 +71,7 @@ static const int schema_statements[] =
   /* Usual tables */
   STMT_CREATE_SCHEMA,
   STMT_INSTALL_SCHEMA_STATISTICS,
+  STMT_UPGRADE_TO_32,
   /* Memory tables */
   STMT_CREATE_TARGETS_LIST,
   STMT_CREATE_CHANGELIST_LIST,
@@ -122,6 +123,7 @@ static const int primary_key_statements[] =
      and primary key instead of adding a list? */
   STMT_LOOK_FOR_WORK,
   STMT_SELECT_WORK_ITEM,
+  STMT_SELECT_WORK_ITEMS,
 
   -1 /* final marker */
 };
@@ -35,6 +35,7 @@
 #include "svn_wc.h"
 #include "svn_client.h"
 #include "svn_hash.h"
+#include "svn_props.h"
 
 #include "utils.h"
 
@@ -493,6 +494,237 @@ test_internal_file_modified(const svn_test_opts_t *opts, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_wc_status_func4_t.  Append a string describing PATH and
+ * the node status in STATUS to the array BATON. */
+static svn_error_t *
+record_status_line(void *baton,
+                   const char *path,
+                   const svn_wc_status3_t *status,
+                   apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *lines = baton;
+
+  APR_ARRAY_PUSH(lines, const char *)
+    = apr_psprintf(lines->pool, "%d %s", status->node_status, path);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_walk_status_concurrently(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  apr_array_header_t *expected = apr_array_make(pool, 0, sizeof(char *));
+  apr_array_header_t *actual = apr_array_make(pool, 0, sizeof(char *));
+  int i;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "walk_status_concurrently",
+                                   opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  /* Local modifications in various subtrees. */
+  SVN_ERR(sbox_file_write(&b, "iota", "new iota"));
+  SVN_ERR(sbox_file_write(&b, "A/B/E/alpha", "new alpha"));
+  SVN_ERR(sbox_file_write(&b, "A/D/G/pi", "new pi"));
+  SVN_ERR(sbox_file_write(&b, "A/C/unversioned", "new file"));
+  SVN_ERR(sbox_wc_delete(&b, "A/D/H/psi"));
+  SVN_ERR(sbox_wc_mkdir(&b, "A/D/H/added"));
+
+  SVN_ERR(svn_wc__internal_walk_status(b.wc_ctx->db, b.wc_abspath,
+                                       svn_depth_infinity, TRUE, FALSE,
+                                       FALSE, NULL,
+                                       record_status_line, expected,
+                                       NULL, NULL, pool));
+
+  /* Walking on multiple threads must report the same in the same order. */
+  b.wc_ctx->db->threads = 4;
+  SVN_ERR(svn_wc__internal_walk_status(b.wc_ctx->db, b.wc_abspath,
+                                       svn_depth_infinity, TRUE, FALSE,
+                                       FALSE, NULL,
+                                       record_status_line, actual,
+                                       NULL, NULL, pool));
+
+  SVN_TEST_INT_ASSERT(actual->nelts, expected->nelts);
+  for (i = 0; i < expected->nelts; ++i)
+    SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(actual, i, const char *),
+                           APR_ARRAY_IDX(expected, i, const char *));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_walk_status_stale_fsmonitor(const svn_test_opts_t *opts,
+                                 apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  apr_array_header_t *expected = apr_array_make(pool, 0, sizeof(char *));
+  apr_array_header_t *actual = apr_array_make(pool, 0, sizeof(char *));
+  const char *adm_abspath;
+  apr_finfo_t finfo;
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+  int i;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "walk_status_stale_fsmonitor",
+                                   opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  SVN_ERR(sbox_file_write(&b, "iota", "new iota"));
+  SVN_ERR(sbox_file_write(&b, "A/B/E/alpha", "new alpha"));
+  SVN_ERR(sbox_file_write(&b, "A/C/unversioned", "new file"));
+
+  SVN_ERR(svn_wc__internal_walk_status(b.wc_ctx->db, b.wc_abspath,
+                                       svn_depth_infinity, FALSE, FALSE,
+                                       FALSE, NULL,
+                                       record_status_line, expected,
+                                       NULL, NULL, pool));
+  SVN_TEST_INT_ASSERT(expected->nelts, 3);
+
+  /* A journal without a monitor holding its lock and a baseline claiming
+     that nothing has changed must not hide any of the changes. */
+  adm_abspath = svn_dirent_join(b.wc_abspath, SVN_WC_ADM_DIR_NAME, pool);
+  SVN_ERR(svn_io_file_create(svn_dirent_join(adm_abspath,
+                                             "fsmonitor-journal", pool),
+                             "svn-fsmonitor 1 stale\n", pool));
+  SVN_ERR(svn_io_stat(&finfo, svn_dirent_join(adm_abspath, "wc.db", pool),
+                      APR_FINFO_SIZE | APR_FINFO_MTIME, pool));
+  SVN_ERR(svn_io_file_create(svn_dirent_join(adm_abspath,
+                                             "fsmonitor-baseline", pool),
+                             apr_psprintf(pool,
+                                          "stale 0 %" APR_OFF_T_FMT
+                                          " %" APR_TIME_T_FMT "\n",
+                                          finfo.size, finfo.mtime),
+                             pool));
+
+  SVN_ERR(svn_wc__internal_walk_status(b.wc_ctx->db, b.wc_abspath,
+                                       svn_depth_infinity, FALSE, FALSE,
+                                       FALSE, NULL,
+                                       record_status_line, actual,
+                                       NULL, NULL, pool));
+
+  SVN_TEST_INT_ASSERT(actual->nelts, expected->nelts);
+  for (i = 0; i < expected->nelts; ++i)
+    SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(actual, i, const char *),
+                           APR_ARRAY_IDX(expected, i, const char *));
+
+  /* The walk must not leave its journal cookie behind. */
+  SVN_ERR(svn_io_get_dirents3(&dirents, adm_abspath, TRUE, pool, pool));
+  for (hi = apr_hash_first(pool, dirents); hi; hi = apr_hash_next(hi))
+    SVN_TEST_ASSERT(strncmp(apr_hash_this_key(hi), "fsmonitor-cookie",
+                            strlen("fsmonitor-cookie")) != 0);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_install_files_concurrently(const svn_test_opts_t *opts,
+                                apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  apr_array_header_t *changes = apr_array_make(pool, 0, sizeof(char *));
+  const struct svn_wc__db_info_t *info;
+  svn_stringbuf_t *contents;
+  apr_uint64_t id;
+  svn_skel_t *work_item;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "install_files_concurrently",
+                                   opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+  SVN_ERR(sbox_file_write(&b, "A/D/G/pi", "new pi\n"));
+  SVN_ERR(sbox_wc_propset(&b, SVN_PROP_EXECUTABLE, "*", "A/D/G/pi"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  /* Remove all files and install them again on multiple threads. */
+  b.wc_ctx->db->threads = 4;
+  SVN_ERR(sbox_wc_update(&b, "", 0));
+  SVN_ERR(sbox_wc_update(&b, "", 2));
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents, sbox_wc_path(&b, "A/D/G/pi"),
+                                   pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "new pi\n");
+
+#ifndef WIN32
+  {
+    svn_boolean_t executable;
+
+    SVN_ERR(svn_io_is_file_executable(&executable,
+                                      sbox_wc_path(&b, "A/D/G/pi"), pool));
+    SVN_TEST_ASSERT(executable);
+  }
+#endif
+
+  SVN_ERR(svn_wc__db_read_single_info(&info, b.wc_ctx->db,
+                                      sbox_wc_path(&b, "A/D/G/pi"),
+                                      FALSE, pool, pool));
+  /* The recorded time may be 0 when the file was written within the
+     timestamp granularity of its filesystem. */
+  SVN_TEST_INT_ASSERT(info->recorded_size, strlen("new pi\n"));
+
+  /* Nothing is left to do and nothing looks modified. */
+  SVN_ERR(svn_wc__db_wq_fetch_next(&id, &work_item, b.wc_ctx->db,
+                                   b.wc_abspath, 0, pool, pool));
+  SVN_TEST_ASSERT(work_item == NULL);
+
+  SVN_ERR(svn_wc__internal_walk_status(b.wc_ctx->db, b.wc_abspath,
+                                       svn_depth_infinity, FALSE, FALSE,
+                                       FALSE, NULL,
+                                       record_status_line, changes,
+                                       NULL, NULL, pool));
+  SVN_TEST_INT_ASSERT(changes->nelts, 0);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_commit_text_deltas_concurrently(const svn_test_opts_t *opts,
+                                     apr_pool_t *pool)
+{
+  static const char *const files[] = {
+    "iota", "A/mu", "A/B/lambda", "A/B/E/alpha", "A/B/E/beta",
+    "A/D/gamma", "A/D/G/pi", "A/D/G/rho", "A/D/G/tau", "A/D/H/chi",
+    "A/D/H/omega", "A/D/H/psi", "A/new", NULL
+  };
+  svn_test__sandbox_t b;
+  apr_array_header_t *changes = apr_array_make(pool, 0, sizeof(char *));
+  svn_stringbuf_t *contents;
+  int i;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "commit_text_deltas_concurrently",
+                                   opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  /* Modify all files, add one and commit them on multiple threads. */
+  for (i = 0; files[i]; i++)
+    SVN_ERR(sbox_file_write(&b, files[i],
+                            apr_psprintf(pool, "new text of %s\n", files[i])));
+  SVN_ERR(sbox_wc_add(&b, "A/new"));
+
+  b.wc_ctx->db->threads = 4;
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  /* Nothing looks modified afterwards. */
+  SVN_ERR(svn_wc__internal_walk_status(b.wc_ctx->db, b.wc_abspath,
+                                       svn_depth_infinity, FALSE, FALSE,
+                                       FALSE, NULL,
+                                       record_status_line, changes,
+                                       NULL, NULL, pool));
+  SVN_TEST_INT_ASSERT(changes->nelts, 0);
+
+  /* The repository got the new texts. */
+  SVN_ERR(sbox_wc_update(&b, "", 0));
+  SVN_ERR(sbox_wc_update(&b, "", 2));
+  for (i = 0; files[i]; i++)
+    {
+      SVN_ERR(svn_stringbuf_from_file2(&contents, sbox_wc_path(&b, files[i]),
+                                       pool));
+      SVN_TEST_STRING_ASSERT(contents->data,
+                             apr_psprintf(pool, "new text of %s\n",
+                                          files[i]));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* ---------------------------------------------------------------------- */
 /* The list of test functions */
 
@@ -515,6 +747,14 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test legacy commit2"),
     SVN_TEST_OPTS_PASS(test_internal_file_modified,
                        "test internal_file_modified"),
+    SVN_TEST_OPTS_PASS(test_walk_status_concurrently,
+                       "walk status on multiple threads"),
+    SVN_TEST_OPTS_PASS(test_walk_status_stale_fsmonitor,
+                       "walk status ignoring a stale change journal"),
+    SVN_TEST_OPTS_PASS(test_install_files_concurrently,
+                       "install working files on multiple threads"),
+    SVN_TEST_OPTS_PASS(test_commit_text_deltas_concurrently,
+                       "commit text deltas computed on multiple threads"),
     SVN_TEST_NULL
   };
 
@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+#
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+#
+#
+# svn-fsmonitor.py: keep a change journal for a working copy
+#
+# USAGE: svn-fsmonitor.py [--max-journal-size BYTES] WCROOT
+#
+# Watches the working copy rooted at WCROOT using Linux' inotify and
+# appends the path of every node that changes to .svn/fsmonitor-journal.
+# As long as this script runs, 'svn status', 'svn commit' and everything
+# else that walks the working copy status can skip reading directories
+# that have not changed since the previous complete status walk.
+#
+# The journal format is described in subversion/libsvn_wc/fsmonitor.h.
+# Stopping this script makes Subversion ignore the journal again.
+#
+
+import argparse
+import ctypes
+import errno
+import fcntl
+import os
+import struct
+import sys
+import time
+
+IN_MODIFY      = 0x00000002
+IN_ATTRIB      = 0x00000004
+IN_CLOSE_WRITE = 0x00000008
+IN_MOVED_FROM  = 0x00000040
+IN_MOVED_TO    = 0x00000080
+IN_CREATE      = 0x00000100
+IN_DELETE      = 0x00000200
+IN_DELETE_SELF = 0x00000400
+IN_MOVE_SELF   = 0x00000800
+IN_Q_OVERFLOW  = 0x00004000
+IN_IGNORED     = 0x00008000
+IN_ONLYDIR     = 0x01000000
+IN_DONT_FOLLOW = 0x02000000
+IN_ISDIR       = 0x40000000
+IN_CLOEXEC     = 0o2000000
+
+WATCH_MASK = (IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVED_FROM
+              | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_DELETE_SELF
+              | IN_MOVE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW)
+ADM_MASK = IN_CREATE | IN_ONLYDIR
+
+ADM_DIR = '.svn'
+JOURNAL_FILE = 'fsmonitor-journal'
+COOKIE_FILE = 'fsmonitor-cookie'
+
+EVENT_HEADER = struct.Struct('iIII')
+
+libc = ctypes.CDLL(None, use_errno=True)
+
+
+def check(result):
+  if result < 0:
+    err = ctypes.get_errno()
+    raise OSError(err, os.strerror(err))
+  return result
+
+
+class Monitor:
+  def __init__(self, wcroot, max_journal_size):
+    self.wcroot = os.path.abspath(wcroot)
+    self.max_journal_size = max_journal_size
+    adm_path = os.path.join(self.wcroot, ADM_DIR)
+    if not os.path.isfile(os.path.join(adm_path, 'wc.db')):
+      sys.exit("'%s' is not the root of a working copy" % wcroot)
+
+    # Hold the lock for as long as we live; Subversion checks it to tell
+    # whether the journal is being kept up to date.
+    self.journal = open(os.path.join(adm_path, JOURNAL_FILE), 'ab+')
+    try:
+      fcntl.lockf(self.journal, fcntl.LOCK_EX | fcntl.LOCK_NB)
+    except OSError:
+      sys.exit("'%s' is being watched already" % wcroot)
+
+    self.fd = check(libc.inotify_init1(IN_CLOEXEC))
+    self.paths = {}
+    self.adm_wd = self.add_watch(adm_path, ADM_MASK)
+    self.watch_tree('')
+
+    # Only now that we see every change, let Subversion use the journal.
+    self.rotate()
+
+  def add_watch(self, path, mask):
+    return check(libc.inotify_add_watch(self.fd, os.fsencode(path), mask))
+
+  def watch_tree(self, relpath):
+    """Watch RELPATH and all directories below it.  Return the relpaths of
+    all nodes below RELPATH."""
+    found = []
+    try:
+      wd = self.add_watch(os.path.join(self.wcroot, relpath), WATCH_MASK)
+    except OSError as e:
+      if e.errno in (errno.ENOENT, errno.ENOTDIR):
+        return found
+      raise
+    self.paths[wd] = relpath
+
+    try:
+      entries = list(os.scandir(os.path.join(self.wcroot, relpath)))
+    except OSError:
+      return found
+    for entry in entries:
+      if entry.name == ADM_DIR:
+        continue
+      child = relpath + '/' + entry.name if relpath else entry.name
+      found.append(child)
+      if entry.is_dir(follow_symlinks=False):
+        found.extend(self.watch_tree(child))
+    return found
+
+  def rotate(self):
+    """Start a new journal, invalidating all status baselines."""
+    token = '%x-%x' % (os.getpid(), int(time.time() * 1000000))
+    self.journal.seek(0)
+    self.journal.truncate(0)
+    self.journal.write(('svn-fsmonitor 1 %s\n' % token).encode())
+    self.journal.flush()
+
+  def journal_line(self, line):
+    self.journal.write(os.fsencode(line) + b'\n')
+
+  def handle(self, wd, mask, name):
+    if mask & IN_Q_OVERFLOW:
+      # We lost events, so nothing we've written can be trusted anymore.
+      self.rotate()
+      return
+
+    if wd == self.adm_wd:
+      if name.startswith(COOKIE_FILE):
+        self.journal_line('!cookie ' + name)
+      return
+
+    if mask & IN_IGNORED:
+      self.paths.pop(wd, None)
+      return
+
+    parent = self.paths.get(wd)
+    if parent is None or name == ADM_DIR:
+      return
+
+    if name:
+      relpath = parent + '/' + name if parent else name
+    else:
+      relpath = parent
+    self.journal_line(relpath)
+
+    if mask & IN_ISDIR and mask & (IN_CREATE | IN_MOVED_TO):
+      # Anything may have happened in there before we started watching.
+      for child in self.watch_tree(relpath):
+        self.journal_line(child)
+
+    if relpath == '' and mask & (IN_DELETE_SELF | IN_MOVE_SELF):
+      sys.exit("'%s' disappeared" % self.wcroot)
+
+  def run(self):
+    while True:
+      buf = os.read(self.fd, 65536)
+      offset = 0
+      while offset < len(buf):
+        wd, mask, cookie, length = EVENT_HEADER.unpack_from(buf, offset)
+        offset += EVENT_HEADER.size
+        name = os.fsdecode(buf[offset:offset + length].rstrip(b'\0'))
+        offset += length
+        self.handle(wd, mask, name)
+
+      # Make each batch of events visible before waiting for the next one,
+      # so that cookies never appear ahead of earlier changes.
+      self.journal.flush()
+      if self.journal.tell() > self.max_journal_size:
+        self.rotate()
+
+
+def main():
+  parser = argparse.ArgumentParser(
+             description='Keep a change journal for a Subversion working '
+                         'copy, allowing status walks to skip unchanged '
+                         'directories.')
+  parser.add_argument('--max-journal-size', type=int, default=16 << 20,
+                      metavar='BYTES',
+                      help='start over after the journal grew this large '
+                           '(default: %(default)s)')
+  parser.add_argument('wcroot', metavar='WCROOT',
+                      help='root of the working copy to watch')
+  args = parser.parse_args()
+
+  if not sys.platform.startswith('linux'):
+    sys.exit('This script requires Linux.')
+
+  try:
+    Monitor(args.wcroot, args.max_journal_size).run()
+  except KeyboardInterrupt:
+    pass
+
+
+if __name__ == '__main__':
+  main()